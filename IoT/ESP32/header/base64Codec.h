@@ -0,0 +1,196 @@
+/**
+ * @file base64Codec.h
+ * @brief Base64（RFC 4648 標準アルファベット、パディング付き）の共通符号化/復号定義。
+ * @details
+ * - [重要] MQTT（fileSync / securePing / payload暗号化）と保守AP（ペアリング / ファイル更新）が共通で使う。
+ *   `mbedtls_base64_*` の「長さ問合せ → 本処理」の2回呼出しを置き換え、出力長は算術で求めて1回で処理する。
+ * - [重要] 復号は 4 文字を表引き4回で 24bit にまとめる。空白（' ' '\t' '\r' '\n'）を含む入力は逐次処理へ切り替えて読み飛ばす
+ *   （mbedtls と同じ許容範囲）。
+ * - [厳守] パディングを省いた末尾（例: "QUI"）、途中の '='、'=' の後の有効文字は不正として false を返す。
+ *   mbedtls 2.x は揃わない末尾を黙って捨てて成功を返すが、欠けたデータを受理しないよう拒否する。
+ * - [推奨] 受信バッファを再利用できる場合は decodeInPlace を使い、復号用の別バッファを確保しない。
+ * - [推奨] 分割して届くデータは base64StreamDecoder / base64StreamEncoder で逐次処理する。
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief 分割入力を逐次復号する状態。
+ * @details
+ * - [重要] update の出力は「保留中の文字数 + 入力文字数」のうち 4 文字単位で揃った分だけ。最大は getMaxUpdateOutput で求める。
+ * - [厳守] 失敗後は reset するまで update / finish は false を返す。
+ */
+class base64StreamDecoder {
+ public:
+  base64StreamDecoder();
+
+  /**
+   * @brief 状態を初期化する。
+   */
+  void reset();
+
+  /**
+   * @brief 入力文字列の一部を復号する。
+   * @param text 入力文字列（null可、textLength=0 の場合）。
+   * @param textLength 入力文字数。
+   * @param bytesOut 出力先（textLength>0 の場合は null不可）。先頭から書き込む。
+   * @param bytesCapacity 出力先の容量(byte)。
+   * @param byteLengthOut 書き込んだ長さ(byte)の出力先（null不可）。
+   * @return 成功時true。不正文字・容量不足時false。
+   */
+  bool update(const char* text, size_t textLength, uint8_t* bytesOut, size_t bytesCapacity, size_t* byteLengthOut);
+
+  /**
+   * @brief 入力の終端を確認する。
+   * @return 4 文字単位で揃って終わっていればtrue。
+   */
+  bool finish();
+
+  /**
+   * @brief update 1回の最大出力長(byte)を返す。
+   * @param textLength 入力文字数。
+   */
+  static size_t getMaxUpdateOutput(size_t textLength) { return (textLength / 4U + 1U) * 3U; }
+
+ private:
+  /** @brief 組立て中の 24bit 値。@type uint32_t */
+  uint32_t groupBits_;
+  /** @brief 組立て中の文字数（'=' を含む、0〜3）。@type uint8_t */
+  uint8_t groupCharCount_;
+  /** @brief 組立て中の '=' の数。@type uint8_t */
+  uint8_t groupPaddingCount_;
+  /** @brief パディング付きの組を処理済みか（以後は空白のみ許容）。@type bool */
+  bool isPaddingSeen_;
+  /** @brief 失敗済みか。@type bool */
+  bool isFailed_;
+};
+
+/**
+ * @brief 分割入力を逐次符号化する状態。
+ * @details
+ * - [重要] 3 byte に満たない端数（最大 2 byte）を保持し、finish でパディング付きの最終組を出力する。
+ */
+class base64StreamEncoder {
+ public:
+  base64StreamEncoder();
+
+  /**
+   * @brief 状態を初期化する。
+   */
+  void reset();
+
+  /**
+   * @brief 入力バイト列の一部を符号化する。
+   * @param bytes 入力（null可、byteLength=0 の場合）。
+   * @param byteLength 入力長(byte)。
+   * @param textOut 出力先。NUL 終端はしない。
+   * @param textCapacity 出力先の容量（文字数）。
+   * @param textLengthOut 書き込んだ文字数の出力先（null不可）。
+   * @return 成功時true。容量不足時false（状態は変えない）。
+   */
+  bool update(const uint8_t* bytes, size_t byteLength, char* textOut, size_t textCapacity, size_t* textLengthOut);
+
+  /**
+   * @brief 端数を最終組として出力し、状態を初期化する。
+   * @param textOut 出力先（4 文字以上）。
+   * @param textCapacity 出力先の容量（文字数）。
+   * @param textLengthOut 書き込んだ文字数（0 または 4）の出力先（null不可）。
+   * @return 成功時true。
+   */
+  bool finish(char* textOut, size_t textCapacity, size_t* textLengthOut);
+
+  /**
+   * @brief update 1回の最大出力長（文字数）を返す。
+   * @param byteLength 入力長(byte)。
+   */
+  static size_t getMaxUpdateOutput(size_t byteLength) { return ((byteLength + 2U) / 3U) * 4U; }
+
+ private:
+  /** @brief 端数の保持領域。@type uint8_t[] */
+  uint8_t pendingBytes_[2];
+  /** @brief 端数の長さ(byte)。@type uint8_t */
+  uint8_t pendingCount_;
+};
+
+namespace base64Codec {
+
+/**
+ * @brief 符号化後の文字数を返す（NUL 終端を含まない）。
+ * @param byteLength 入力長(byte)。
+ */
+inline size_t getEncodedLength(size_t byteLength) { return ((byteLength + 2U) / 3U) * 4U; }
+
+/**
+ * @brief 復号後の長さ(byte)を入力文字数と末尾のパディングから算出する（(文字数 / 4) * 3 - '=' の数）。
+ * @param text 入力文字列（null可、textLength=0 の場合）。
+ * @param textLength 入力文字数。
+ * @return 空白を含まない入力では正確な長さ。空白を含む入力では上限（出力先の確保にはそのまま使える）。
+ */
+size_t getDecodedLength(const char* text, size_t textLength);
+
+/**
+ * @brief バイト列を符号化する。
+ * @param bytes 入力（null可、byteLength=0 の場合）。
+ * @param byteLength 入力長(byte)。
+ * @param textOut 出力先（null不可）。容量に余りがあれば NUL 終端する。
+ * @param textCapacity 出力先の容量（文字数）。getEncodedLength 以上であること。
+ * @param textLengthOut 書き込んだ文字数の出力先（null可）。
+ * @return 成功時true。
+ */
+bool encode(const uint8_t* bytes, size_t byteLength, char* textOut, size_t textCapacity, size_t* textLengthOut);
+
+/**
+ * @brief 文字列を復号する。
+ * @param text 入力文字列（null可、textLength=0 の場合）。
+ * @param textLength 入力文字数。
+ * @param bytesOut 出力先（textLength>0 の場合は null不可）。
+ * @param bytesCapacity 出力先の容量(byte)。getDecodedLength の値以上であること。
+ * @param byteLengthOut 書き込んだ長さ(byte)の出力先（null可）。
+ * @return 成功時true。
+ */
+bool decode(const char* text, size_t textLength, uint8_t* bytesOut, size_t bytesCapacity, size_t* byteLengthOut);
+
+/**
+ * @brief 入力文字列のバッファへ上書きで復号する。
+ * @param text 入力文字列（復号結果で先頭から上書きされる）。
+ * @param textLength 入力文字数。
+ * @param byteLengthOut 復号後の長さ(byte)の出力先（null不可）。
+ * @return 成功時true。失敗時のバッファ内容は不定。
+ * @details
+ * - [重要] 書込み位置は常に読取り位置より手前にあるため、追加の領域を使わない。
+ */
+bool decodeInPlace(char* text, size_t textLength, size_t* byteLengthOut);
+
+/**
+ * @brief 文字列をバイト列へ復号する（出力先は正確な長さで1回だけ確保する）。
+ * @param text 入力文字列。
+ * @param bytesOut 出力先（null不可）。失敗時は空にする。
+ * @return 成功時true。
+ */
+bool decodeToBytes(const String& text, std::vector<uint8_t>* bytesOut);
+
+/**
+ * @brief バイト列を文字列へ符号化する（出力先は正確な長さで予約する）。
+ * @param bytes 入力（null可、byteLength=0 の場合）。
+ * @param byteLength 入力長(byte)。
+ * @param textOut 出力先（null不可）。
+ * @return 成功時true。
+ */
+bool encodeToText(const uint8_t* bytes, size_t byteLength, String* textOut);
+
+/**
+ * @brief バイト列を文字列へ符号化する。
+ * @param bytes 入力バイト列。
+ * @param textOut 出力先（null不可）。
+ * @return 成功時true。
+ */
+inline bool encodeToText(const std::vector<uint8_t>& bytes, String* textOut) {
+  return encodeToText(bytes.data(), bytes.size(), textOut);
+}
+
+}  // namespace base64Codec
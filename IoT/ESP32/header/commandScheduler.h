@@ -0,0 +1,117 @@
+/**
+ * @file commandScheduler.h
+ * @brief UTC時刻指定（`args.at`）の出力コマンドを予約実行するスケジューラ定義。
+ * @details
+ * - [重要] 受信時に検証と前処理（gpioBatchPlan の作成）まで済ませ、発火時はレジスタ書込みだけを行う。
+ * - [重要] 予約はタイマーホイール（10ms × 128 スロット、周回数付き）で保持し、発火の少し前に
+ *   esp_timer の単発タイマーを残り時間で張り直して、目標時刻ちょうどに実行する。
+ * - [重要] 目標時刻は NTP 同期済みの UTC（gettimeofday）で解釈し、単発タイマーを張る直前に現在UTCから
+ *   残り時間を計算し直す。受信後に NTP 補正が入っても目標時刻はずれない。
+ * - [重要] ホイールのタイマーは予約がホイール上にある間だけ動く。予約が無い間は止まっている。
+ * - [厳守] 発火処理（esp_timer タスク）ではログを出さない。発火結果は appTaskId::kCommandScheduler から
+ *   kMqttPublishScheduledResultRequest で mqttTask へ送り、ログと応答は mqttTask で出す。
+ * - [制限] esp_timer のコールバックは esp_timer タスク（core0 / 高優先度）で動く。ISR 発火ではないため、
+ *   Wi-Fi ドライバ等の処理と重なった場合は数十us 程度遅れることがある。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "gpioBatch.h"
+
+/** @brief 同時に保持できる予約数。@type uint8_t */
+constexpr uint8_t kCommandSchedulerMaxEntries = 16;
+
+/**
+ * @brief 予約の受付結果。
+ */
+enum class commandScheduleError : uint8_t {
+  kNone = 0,
+  /** initialize 未実施。 */
+  kNotInitialized,
+  /** 時刻未同期（NTP 同期前）。 */
+  kClockNotSynchronized,
+  /** 目標時刻が過去。 */
+  kInPast,
+  /** 目標時刻が受付上限より先。 */
+  kTooFarAhead,
+  /** 予約表が満杯。 */
+  kFull,
+  /** esp_timer の操作に失敗。 */
+  kTimerFailed,
+};
+
+/**
+ * @brief 予約受付の詳細。
+ */
+struct commandScheduleReceipt {
+  /** @brief 受付結果。@type commandScheduleError */
+  commandScheduleError error;
+  /** @brief 受付時点から目標時刻までの時間(us)。@type int64_t */
+  int64_t delayUs;
+  /** @brief 受付後の予約数。@type uint8_t */
+  uint8_t pendingCount;
+};
+
+namespace commandScheduler {
+
+/**
+ * @brief タイマーを作成する。
+ * @return 成功時true。
+ * @details
+ * - [厳守] gpioBatch::initializeOutputs の後、mainTask の起動時に1回呼ぶ。
+ */
+bool initialize();
+
+/**
+ * @brief 検証済みの出力操作を UTC 時刻に予約する。
+ * @param targetUtcUs 目標時刻（UNIX エポックからの us）。
+ * @param plan 検証済み出力操作。
+ * @param subName 応答に使うサブコマンド。
+ * @param requestId 応答に引き継ぐ要求ID。
+ * @param destinationId 応答先ID。
+ * @param receiptOut 受付結果出力先（null不可）。
+ * @return 受け付けた場合true。
+ * @details
+ * - [重要] 発火後の結果は mqttTask へ kMqttPublishScheduledResultRequest で渡し、応答として publish する。
+ */
+bool scheduleOutputPlan(int64_t targetUtcUs,
+                        const gpioBatchPlan& plan,
+                        const char* subName,
+                        const char* requestId,
+                        const char* destinationId,
+                        commandScheduleReceipt* receiptOut);
+
+/**
+ * @brief `YYYY-MM-DDTHH:MM:SS[.fff[fff]]Z` 形式の UTC 時刻を解釈する。
+ * @param timestampText 時刻文字列。
+ * @param epochMicrosOut 出力先（UNIX エポックからの us）。
+ * @return 解釈できた場合true。
+ */
+bool parseUtcTimestamp(const char* timestampText, int64_t* epochMicrosOut);
+
+/**
+ * @brief 現在の UTC 時刻を us で返す。
+ * @param epochMicrosOut 出力先。
+ * @return 時刻同期済みならtrue。
+ */
+bool getUtcNowMicros(int64_t* epochMicrosOut);
+
+/**
+ * @brief 予約中（未発火）の件数を返す。
+ */
+uint8_t getPendingCount();
+
+/**
+ * @brief mqttTask へ送れなかった発火結果の件数を取り出して 0 に戻す（mqttTask のログ用）。
+ * @return 前回の取り出し以降に送れなかった件数。
+ */
+uint32_t takeDroppedResultCount();
+
+/**
+ * @brief 受付結果の文字列を返す（ログ/応答の detail 用）。
+ */
+const char* getErrorText(commandScheduleError error);
+
+}  // namespace commandScheduler
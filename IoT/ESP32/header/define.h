@@ -28,6 +28,8 @@ enum class appTaskId : uint8_t {
   kLed = 9,
   kInput = 10,
   kTimeServer = 11,
+  kNetworkSelfTest = 12,
+  kCommandScheduler = 13,
 };
 
 /**
@@ -46,10 +48,12 @@ enum class appMessageType : uint8_t {
   kMqttPublishOnlineRequest = 22,
   kMqttPublishOnlineDone = 23,
   kMqttPublishOtaProgressRequest = 24,
-  kMqttPublishOtaProgressDone = 25,
+  kMqttPublishScheduledResultRequest = 25,
+  kMqttPublishNetSelfTestResultRequest = 26,
   kTimeServerInitRequest = 30,
   kTimeServerInitDone = 31,
   kOtaStartRequest = 40,
+  kOtaPreEraseRequest = 41,
   kTaskError = 255,
 };
 
@@ -115,7 +119,7 @@ constexpr uint32_t kHttpPathMaxLength = 128;
  * @brief タスクIDの最大値。
  * @note [重要] 配列の静的確保サイズ計算に使用する。
  */
-constexpr uint8_t kTaskIdMaxValue = static_cast<uint8_t>(appTaskId::kTimeServer);
+constexpr uint8_t kTaskIdMaxValue = static_cast<uint8_t>(appTaskId::kCommandScheduler);
 
 /**
  * @brief タスク管理スロット数（0番を含む）。
@@ -0,0 +1,53 @@
+/**
+ * @file diagnosticStats.h
+ * @brief 診断系計測（flashBenchmark / networkSelfTest）で共有する集計関数の定義。
+ * @details
+ * - [重要] 所要時間の度数分布は log2 区間（bucket i = [2^i, 2^(i+1)) us、0us は bucket 0）で数える。
+ *   JSON へは末尾の 0 を省いて書き、配列長で最大区間を表す。
+ * - [重要] 時間は micros() の差分(us)を uint32_t で扱う。1回の計測が約71分を超えることはないため桁あふれは起きない。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct cJSON;
+
+namespace diagnosticStats {
+
+/**
+ * @brief 値を範囲内へ丸める。
+ * @param value 値。
+ * @param minimum 下限。
+ * @param maximum 上限。
+ * @return 丸めた値。
+ */
+uint32_t clampValue(uint32_t value, uint32_t minimum, uint32_t maximum);
+
+/**
+ * @brief 所要時間1回分を log2 度数分布へ加える。
+ * @param buckets 度数分布（null不可）。
+ * @param bucketCount 区間数（1以上）。最終区間はそれ以上の値をまとめて数える。
+ * @param elapsedUs 所要時間(us)。
+ */
+void recordLog2Bucket(uint16_t* buckets, uint8_t bucketCount, uint32_t elapsedUs);
+
+/**
+ * @brief 転送量と所要時間からスループット(KB/s)を求める。
+ * @param bytes 転送量(byte)。
+ * @param elapsedUs 所要時間(us)。
+ * @return KB/s（KB = 1024byte）。所要時間が 0 なら 0。
+ */
+uint32_t computeKiloBytesPerSecond(uint32_t bytes, uint32_t elapsedUs);
+
+/**
+ * @brief 度数分布を JSON 配列として書き込む（末尾の 0 は省く）。
+ * @param objectOut 書込み先オブジェクト（null不可）。
+ * @param name キー名。
+ * @param buckets 度数分布。
+ * @param bucketCount 区間数。
+ * @return 成功時true。
+ */
+bool appendBucketsToJson(cJSON* objectOut, const char* name, const uint16_t* buckets, uint8_t bucketCount);
+
+}  // namespace diagnosticStats
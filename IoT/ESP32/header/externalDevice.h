@@ -1,6 +1,15 @@
 /**
  * @file externalDevice.h
- * @brief 外部デバイス管理タスクのひな形。
+ * @brief 外部デバイス（I2Cセンサー等）のドライバ枠組みと、外部デバイス管理の受け口（kExternalDevice）。
+ * @details
+ * - [重要] 各デバイスは記述子（externalDeviceDescriptor）で「アドレス候補・チップID確認・初期化手順・
+ *   校正値の読取範囲・測定トリガ・変換待ち・読取範囲・周期・変換関数」を宣言する。処理の流れは枠組みが持つ。
+ * - [重要] バスへのアクセスは I2C 専用タスク（i2cService）だけが行う。本モジュールは externalDeviceBus 経由で
+ *   命令を出すだけで Wire に依存しない。
+ * - [重要] 周期の来たデバイス（少し先に来るものも含む）をまとめ、「全デバイスのトリガ書込み → 変換待ち1回 →
+ *   全デバイスの読取バーストを連続実行」で処理する。1デバイスずつキュー往復・変換待ちをしない。
+ * - [重要] 結果はデバイスごとのスナップショットへ seqlock で公開する。読む側はロックもキュー往復も不要。
+ * - [推奨] デバイス追加は externalDeviceId へ追記し、externalDevice.cpp の記述子表へ1行追加する。
  */
 
 #pragma once
@@ -9,14 +18,244 @@
 #include <freertos/task.h>
 #include <stdint.h>
 
-class externalDeviceTask {
+/**
+ * @brief 枠組みが管理する外部デバイス。
+ * @details
+ * - [厳守] 値は externalDevice.cpp の記述子表の並びと一致させる。追加時は kCount の直前へ追加する。
+ */
+enum class externalDeviceId : uint8_t {
+  /** 温湿度・気圧センサー BME280（0x76/0x77）。 */
+  kBme280 = 0,
+  kCount,
+};
+
+/** @brief 1デバイスが公開できる値の最大数。@type uint8_t */
+constexpr uint8_t kExternalDeviceMaxValues = 4;
+/** @brief 1回の測定で読むバイト数の上限（読取範囲の合計）。@type uint8_t */
+constexpr uint8_t kExternalDeviceMaxFrameBytes = 32;
+/** @brief 校正値として保持するバイト数の上限。@type uint8_t */
+constexpr uint8_t kExternalDeviceMaxCalibrationBytes = 48;
+/** @brief 1デバイスの読取範囲（および校正値範囲）の最大数。@type uint8_t */
+constexpr uint8_t kExternalDeviceMaxRanges = 4;
+
+/**
+ * @brief レジスタ書込み1手順。
+ */
+struct externalDeviceRegisterWrite {
+  /** @brief レジスタ番地。@type uint8_t */
+  uint8_t registerAddress;
+  /** @brief 書込み値。@type uint8_t */
+  uint8_t value;
+  /** @brief 書込み後の待機(ms)。0なら待たない。@type uint16_t */
+  uint16_t delayAfterMs;
+};
+
+/**
+ * @brief 連続レジスタ範囲（バースト読取の単位）。
+ */
+struct externalDeviceRegisterRange {
+  /** @brief 先頭レジスタ番地。@type uint8_t */
+  uint8_t startRegister;
+  /** @brief バイト数。@type uint8_t */
+  uint8_t length;
+};
+
+/**
+ * @brief デバイスのスナップショット（公開される測定結果）。
+ * @details
+ * - [厳守] `isValid=false` の場合は values を利用しない。
+ * - [重要] values の意味と単位はデバイスごとに記述子のコメントで定める（BME280: 温度degC / 湿度%RH / 気圧hPa）。
+ */
+struct externalDeviceReading {
+  /** @brief 測定成功フラグ。@type bool */
+  bool isValid;
+  /** @brief 応答したI2Cアドレス。未検出時は0。@type uint8_t */
+  uint8_t address;
+  /** @brief values の有効数。@type uint8_t */
+  uint8_t valueCount;
+  /** @brief 測定時刻(millis)。@type uint32_t */
+  uint32_t capturedAtMs;
+  /** @brief 起動後の測定成功回数。@type uint32_t */
+  uint32_t sampleCount;
+  /** @brief 測定値。@type float[] */
+  float values[kExternalDeviceMaxValues];
+};
+
+/**
+ * @brief 生バイト列を測定値へ変換する関数。
+ * @param calibration 校正値（calibrationRanges を並び順に連結したもの）。
+ * @param frame 測定値（readRanges を並び順に連結したもの）。
+ * @param readingOut 変換結果出力先（values / valueCount を設定する）。
+ * @return 変換成功時true、値が不正ならfalse。
+ */
+typedef bool (*externalDeviceDecodeFunction)(const uint8_t* calibration,
+                                             const uint8_t* frame,
+                                             externalDeviceReading* readingOut);
+
+/**
+ * @brief デバイス記述子（ドライバが宣言する内容のすべて）。
+ */
+struct externalDeviceDescriptor {
+  /** @brief 表示名。@type const char* */
+  const char* name;
+  /** @brief アドレス候補（先頭を優先）。@type const uint8_t* */
+  const uint8_t* candidateAddresses;
+  /** @brief アドレス候補数。@type uint8_t */
+  uint8_t candidateAddressCount;
+  /** @brief チップIDを確認する場合true。@type bool */
+  bool hasChipId;
+  /** @brief チップIDレジスタ番地。@type uint8_t */
+  uint8_t chipIdRegister;
+  /** @brief 期待するチップID。@type uint8_t */
+  uint8_t expectedChipId;
+  /** @brief 初期化手順（検出直後に1回）。@type const externalDeviceRegisterWrite* */
+  const externalDeviceRegisterWrite* initSequence;
+  /** @brief 初期化手順数。@type uint8_t */
+  uint8_t initSequenceLength;
+  /** @brief 校正値の読取範囲（初期化後に1回）。@type const externalDeviceRegisterRange* */
+  const externalDeviceRegisterRange* calibrationRanges;
+  /** @brief 校正値の読取範囲数。@type uint8_t */
+  uint8_t calibrationRangeCount;
+  /** @brief 測定トリガ（測定ごと。不要ならnull）。@type const externalDeviceRegisterWrite* */
+  const externalDeviceRegisterWrite* triggerSequence;
+  /** @brief 測定トリガ数。@type uint8_t */
+  uint8_t triggerSequenceLength;
+  /** @brief トリガ後、読取までの変換待ち(ms)。@type uint16_t */
+  uint16_t conversionDelayMs;
+  /** @brief 測定値の読取範囲（番地の昇順で宣言する）。@type const externalDeviceRegisterRange* */
+  const externalDeviceRegisterRange* readRanges;
+  /** @brief 測定値の読取範囲数。@type uint8_t */
+  uint8_t readRangeCount;
+  /** @brief 測定周期(ms)。@type uint32_t */
+  uint32_t periodMs;
+  /** @brief 変換関数。@type externalDeviceDecodeFunction */
+  externalDeviceDecodeFunction decode;
+};
+
+/**
+ * @brief 枠組みがバスへ出す命令（I2C専用タスクが Wire で実装する）。
+ * @details
+ * - [厳守] 実装は I2C 専用タスクの中でだけ呼ばれる前提とし、排他は持たない。
+ */
+class externalDeviceBus {
  public:
-  bool startTask();
+  virtual ~externalDeviceBus() = default;
 
- private:
-  static void taskEntry(void* taskParameter);
-  void runLoop();
+  /**
+   * @brief アドレスの応答有無を確認する。
+   * @param address I2Cアドレス。
+   * @return 応答ありでtrue。
+   */
+  virtual bool probe(uint8_t address) = 0;
+
+  /**
+   * @brief 1レジスタへ書き込む。
+   * @param address I2Cアドレス。
+   * @param registerAddress レジスタ番地。
+   * @param value 書込み値。
+   * @return 成功時true。
+   */
+  virtual bool writeRegister(uint8_t address, uint8_t registerAddress, uint8_t value) = 0;
+
+  /**
+   * @brief 連続レジスタを1トランザクション（番地書込み + リピーテッドスタート + 読取）で読む。
+   * @param address I2Cアドレス。
+   * @param startRegister 先頭レジスタ番地。
+   * @param bufferOut 読取結果出力先（length バイト以上）。
+   * @param length 読取バイト数。
+   * @return 全バイト読めた場合true。
+   */
+  virtual bool readRegisters(uint8_t address, uint8_t startRegister, uint8_t* bufferOut, uint8_t length) = 0;
+};
 
-  static constexpr uint32_t taskStackSize = 4096;
-  static constexpr UBaseType_t taskPriority = 1;
+namespace externalDeviceDriver {
+
+/**
+ * @brief 併合済みのバースト読取1回分。
+ */
+struct burstPlan {
+  /** @brief 先頭レジスタ番地。@type uint8_t */
+  uint8_t startRegister;
+  /** @brief バイト数。@type uint8_t */
+  uint8_t length;
+};
+
+/**
+ * @brief 読取範囲を併合してバースト計画を作る（純関数）。
+ * @details
+ * - [重要] 隙間が4byte以下で、併合後も32byte（Wire の受信バッファ長）以内なら1バーストへ併合する。
+ * - [推奨] 併合規則を変えたら tools/fleetSimulator/externalDeviceScenario で確認する。
+ * @param ranges 読取範囲（番地の昇順）。
+ * @param rangeCount 読取範囲数。
+ * @param burstsOut バースト計画出力先（kExternalDeviceMaxRanges 個）。
+ * @return バースト数。範囲が不正、またはバーストが kExternalDeviceMaxRanges を超える場合は0。
+ */
+uint8_t buildBurstPlans(const externalDeviceRegisterRange* ranges, uint8_t rangeCount, burstPlan* burstsOut);
+
+/**
+ * @brief BME280 の生値を補正して温度・湿度・気圧へ変換する（記述子表の変換関数。純関数）。
+ * @details
+ * - [重要] 補正式はデータシートの整数版（温度 int32 / 気圧 int64 / 湿度 int32）をそのまま使う。
+ * - [推奨] 補正式を変えたら tools/fleetSimulator/externalDeviceScenario でデータシートの計算例と突き合わせる。
+ * @param calibration 校正値（0x88..0xA1 の26byte + 0xE1..0xE7 の7byte）。
+ * @param frame 測定値（0xF7..0xFE の8byte）。
+ * @param readingOut values[0]=温度degC, values[1]=湿度%RH, values[2]=気圧hPa。
+ * @return 変換成功時true、未測定値（0x80000）や補正不能時false。
+ */
+bool decodeBme280(const uint8_t* calibration, const uint8_t* frame, externalDeviceReading* readingOut);
+
+/**
+ * @brief 周期の来たデバイスを検出/初期化し、まとめて測定してスナップショットを更新する。
+ * @details
+ * - [厳守] I2C 専用タスクからのみ呼ぶ。
+ * - [重要] 未検出デバイスの再探索もここで行う（一定間隔で再試行）。
+ * @param bus バス実装。
+ * @param nowMs 現在時刻(millis)。
+ * @return 次に呼ぶまでの推奨待機(ms)。1以上。
+ */
+uint32_t runDueDevices(externalDeviceBus& bus, uint32_t nowMs);
+
+/**
+ * @brief 次の runDueDevices で周期を待たずに測定させる（任意のタスクから呼べる）。
+ * @param deviceId 対象デバイス。
+ */
+void requestImmediateRead(externalDeviceId deviceId);
+
+/**
+ * @brief 最新スナップショットを読む（任意のタスクから呼べる。ロック不要）。
+ * @param deviceId 対象デバイス。
+ * @param readingOut 出力先（null不可）。
+ * @return 一貫したスナップショットを読めた場合true（未測定でも isValid=false で true を返す）。
+ */
+bool readSnapshot(externalDeviceId deviceId, externalDeviceReading* readingOut);
+
+/**
+ * @brief デバイスの表示名を返す。
+ * @param deviceId 対象デバイス。
+ * @return 表示名。範囲外は "unknown"。
+ */
+const char* getDeviceName(externalDeviceId deviceId);
+
+}  // namespace externalDeviceDriver
+
+namespace flowRuntime {
+class flowScheduler;
+}
+
+/**
+ * @brief 外部デバイス管理の受け口（kExternalDevice）。
+ * @details
+ * - [重要] センサーの測定は i2cService が externalDeviceDriver::runDueDevices で行い、結果は readSnapshot で読む。
+ *   本クラスは起動応答だけを持つため専用タスクを作らず、既存スケジューラへ相乗りする。
+ * - [推奨] 出力系（アクチュエータ等）を追加する場合は、本クラスのフローとして kExternalDevice 宛の要求を処理する。
+ */
+class externalDeviceTask {
+ public:
+  /**
+   * @brief 既存スケジューラ上の起動応答フローとして動作させる。
+   * @param schedulerOut 相乗り先スケジューラ（初期化済み、null不可）。
+   * @return 成功時true。
+   * @note [重要] 配置表（taskPlacement.cpp）の externalDeviceTask 行の分のスタックを確保しない。
+   */
+  bool attachToFlowScheduler(flowRuntime::flowScheduler* schedulerOut);
 };
@@ -0,0 +1,111 @@
+/**
+ * @file flashBenchmark.h
+ * @brief LittleFS 上のフラッシュ I/O 計測（ベンチマーク / 健全性確認）定義。
+ * @details
+ * - [重要] LittleFS の作業領域（`/bench`）へ試験ファイルを作り、順次/ランダムの読み書き、fsync、
+ *   open/rename/remove の所要時間を計測する。終了時に作業領域は削除する。
+ * - [重要] 所要時間は 2 の冪の区間（bucket i = [2^i, 2^(i+1)) us）の度数分布で返す。個体差（断片化・
+ *   摩耗）の比較と、バッファサイズ（例: `computeLittleFsFileSha256` の 512B）の調整に使う。
+ * - [厳守] 計測中はフラッシュへの書込みが集中する。OTA / fileSync 実行中は呼ばない。
+ * - [制限] 計測は呼出し元タスクで同期実行する（既定設定で数秒）。同時に1件のみ。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct cJSON;
+
+/** @brief 計測するブロックサイズの数。@type uint8_t */
+constexpr uint8_t kFlashBenchmarkBlockSizeCount = 4;
+/** @brief 度数分布の区間数（1us 〜 約0.5秒以上）。@type uint8_t */
+constexpr uint8_t kFlashBenchmarkBucketCount = 20;
+/** @brief 1ブロックサイズあたりのデータ計測項目数（seqWrite/seqRead/randRead/randWrite/fsync）。@type uint8_t */
+constexpr uint8_t kFlashBenchmarkDataMetricCount = 5;
+/** @brief メタデータ計測項目数（open/rename/remove）。@type uint8_t */
+constexpr uint8_t kFlashBenchmarkMetaMetricCount = 3;
+/** @brief 計測項目の総数。@type uint8_t */
+constexpr uint8_t kFlashBenchmarkMetricCount =
+    kFlashBenchmarkBlockSizeCount * kFlashBenchmarkDataMetricCount + kFlashBenchmarkMetaMetricCount;
+
+/**
+ * @brief 計測条件。
+ */
+struct flashBenchmarkOptions {
+  /** @brief ブロックサイズごとの試験ファイルサイズ(byte)。4096〜65536。@type uint32_t */
+  uint32_t fileBytes;
+  /** @brief ランダム読み/書きの回数。1〜128。@type uint16_t */
+  uint16_t randomOperationCount;
+  /** @brief open/rename/remove の回数。1〜64。@type uint16_t */
+  uint16_t metaOperationCount;
+};
+
+/**
+ * @brief 計測項目1件の結果。
+ */
+struct flashBenchmarkMetric {
+  /** @brief 項目名（seqWrite / seqRead / randRead / randWrite / fsync / open / rename / remove）。@type const char* */
+  const char* name;
+  /** @brief ブロックサイズ(byte)。メタデータ項目は 0。@type uint16_t */
+  uint16_t blockSize;
+  /** @brief 計測回数。@type uint16_t */
+  uint16_t count;
+  /** @brief 失敗回数。@type uint16_t */
+  uint16_t errorCount;
+  /** @brief 転送量(byte)。メタデータ項目は 0。@type uint32_t */
+  uint32_t bytes;
+  /** @brief 合計所要時間(us)。@type uint32_t */
+  uint32_t totalUs;
+  /** @brief 最小所要時間(us)。@type uint32_t */
+  uint32_t minUs;
+  /** @brief 最大所要時間(us)。@type uint32_t */
+  uint32_t maxUs;
+  /** @brief 度数分布。@type uint16_t[] */
+  uint16_t buckets[kFlashBenchmarkBucketCount];
+};
+
+/**
+ * @brief 計測結果。
+ */
+struct flashBenchmarkReport {
+  /** @brief LittleFS 容量(byte)。@type uint32_t */
+  uint32_t totalBytes;
+  /** @brief 計測前の使用量(byte)。@type uint32_t */
+  uint32_t usedBytes;
+  /** @brief 計測全体の所要時間(ms)。@type uint32_t */
+  uint32_t elapsedMs;
+  /** @brief 計測条件。@type flashBenchmarkOptions */
+  flashBenchmarkOptions options;
+  /** @brief 有効な項目数。@type uint8_t */
+  uint8_t metricCount;
+  /** @brief 項目別結果。@type flashBenchmarkMetric[] */
+  flashBenchmarkMetric metrics[kFlashBenchmarkMetricCount];
+};
+
+namespace flashBenchmark {
+
+/**
+ * @brief 既定の計測条件を返す（16KB / ランダム32回 / メタデータ16回）。
+ */
+flashBenchmarkOptions getDefaultOptions();
+
+/**
+ * @brief 計測を実行する。
+ * @param options 計測条件（範囲外は上下限へ丸める）。
+ * @param reportOut 結果出力先（null不可）。
+ * @param detailOut 失敗理由出力先（null可）。
+ * @return 計測を完了した場合true。個々の操作の失敗は errorCount に数え、計測は続ける。
+ * @details
+ * - [厳守] 空き容量が試験ファイル2本分に満たない場合は何も書かずに false を返す。
+ */
+bool run(const flashBenchmarkOptions& options, flashBenchmarkReport* reportOut, const char** detailOut);
+
+/**
+ * @brief 計測結果を JSON オブジェクトへ書き込む（`totalBytes` `usedBytes` `elapsedMs` `options` `metrics`）。
+ * @param report 計測結果。
+ * @param objectOut 書込み先（null不可）。
+ * @return 成功時true。
+ */
+bool appendReportToJson(const flashBenchmarkReport& report, cJSON* objectOut);
+
+}  // namespace flashBenchmark
@@ -0,0 +1,494 @@
+/**
+ * @file flowRuntime.h
+ * @brief 協調型フロー実行基盤。送信→応答待ちなどの多段処理を1タスク上で多重実行する。
+ * @details
+ * - [重要] 各フローは `flowBase::step()` を持つ再開可能な状態機械であり、待機条件（メッセージ受信、
+ *   タイムアウト、ソケット受信可、FreeRTOS Queue受信）を登録して制御を返す。待機中はスタックを消費しない。
+ * - [重要] `flowScheduler` は担当タスクIDのメールボックス（interTaskMessage の Queue）を所有し、
+ *   受信メッセージを待機中フローへ配送する。一致しないメッセージは破棄せず保留箱へ退避する。
+ * - [重要] C++20 コルーチン対応コンパイラでは `coroutineFlow` により同じ待機条件を `co_await` で記述できる。
+ * - [制限] Arduino-ESP32 2.0.17 の xtensa GCC 8.4 はコルーチン未対応のため、実機では状態機械フローのみ有効。
+ *   ホスト（GCC 10 以降）と将来のツールチェーン更新時に `FLOW_RUNTIME_HAS_COROUTINE` が 1 になる。
+ * - [厳守] 1スケジューラは1タスクからのみ駆動する。フロー/スケジューラは排他制御を持たない。
+ * - [推奨] ホストでビルドする場合は `tools/fleetSimulator/hostShim` を include パスへ加え、`flowPlatform` を明示する。
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "define.h"
+#include "interTaskMessage.h"
+#include "util.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define FLOW_RUNTIME_HAS_COROUTINE 1
+#endif
+#endif
+#ifndef FLOW_RUNTIME_HAS_COROUTINE
+#define FLOW_RUNTIME_HAS_COROUTINE 0
+#endif
+
+namespace flowRuntime {
+
+/** @brief 無期限待機を表すタイムアウト値。@type uint32_t */
+constexpr uint32_t kWaitForever = UINT32_MAX;
+
+/**
+ * @brief フローが登録する待機条件の種別。
+ */
+enum class flowWaitKind : uint8_t {
+  kNone = 0,
+  kYield,
+  kSleep,
+  kMessage,
+  kSocketReadable,
+  kQueueItem,
+  kFlowCompletion,
+};
+
+/**
+ * @brief 待機の解除理由。`flowBase::lastWaitResult()` で参照する。
+ */
+enum class flowWaitResult : uint8_t {
+  kNone = 0,
+  kReady,
+  kMessage,
+  kTimeout,
+  kTaskError,
+  kSocketReadable,
+  kSocketError,
+  kQueueItem,
+  kFlowCompleted,
+};
+
+/**
+ * @brief `flowBase::step()` の戻り値。
+ */
+enum class flowStepResult : uint8_t {
+  kWaiting = 0,
+  kCompleted,
+};
+
+/**
+ * @brief スケジューラが使うプラットフォーム依存処理。
+ * @details
+ * - [重要] 実機では `getDefaultFlowPlatform()` が FreeRTOS / interTaskMessage / lwIP select を使う実装を返す。
+ * - [重要] ホストでは呼び出し側が全関数ポインタを設定して `flowScheduler::initialize` へ渡す。
+ */
+struct flowPlatform {
+  /** @brief 単調増加のms時刻を返す。 */
+  uint32_t (*nowMs)();
+  /** @brief 指定タスクIDのメールボックスから最大waitMs待って1件受信する。 */
+  bool (*receiveMessage)(appTaskId taskId, appTaskMessage* messageOut, uint32_t waitMs);
+  /** @brief メッセージを送信する。 */
+  bool (*sendMessage)(const appTaskMessage& message, uint32_t timeoutMs);
+  /** @brief 受信待機するメールボックスが無い場合の待機。 */
+  void (*delayMs)(uint32_t delayMs);
+  /** @brief Queueから待機なしで1件受信する。queueHandleは実機では QueueHandle_t。 */
+  bool (*receiveQueueItem)(void* queueHandle, void* itemOut);
+  /** @brief ソケットが受信可能か待機なしで判定する。1=受信可、0=未、負値=エラー。 */
+  int32_t (*pollSocketReadable)(int32_t socketFd);
+};
+
+#if defined(ESP_PLATFORM)
+/**
+ * @brief 実機用の既定プラットフォーム実装を返す。
+ * @return FreeRTOS / interTaskMessage / lwIP を使う実装。
+ */
+const flowPlatform* getDefaultFlowPlatform();
+#endif
+
+class flowScheduler;
+
+/**
+ * @brief 協調型フローの基底クラス。
+ * @details
+ * - [重要] 派生クラスは `step()` 内で処理を進め、待機が必要になったら `waitXxx()` を1つ登録して
+ *   `flowStepResult::kWaiting` を返す。待機解除後に再度 `step()` が呼ばれる。
+ * - [厳守] 待機条件を登録せずに kWaiting を返した場合は、次周期で再度 `step()` される（yield扱い）。
+ * - [制限] 1フローが同時に持てる待機条件は1つ。
+ */
+class flowBase {
+ public:
+  virtual ~flowBase() = default;
+  flowBase(const flowBase&) = delete;
+  flowBase& operator=(const flowBase&) = delete;
+
+  /**
+   * @brief フローを1段進める。
+   * @return 完了時 kCompleted、待機中 kWaiting。
+   */
+  virtual flowStepResult step() = 0;
+
+  /** @brief ログ用フロー名を返す。 */
+  const char* flowName() const { return flowName_; }
+  /** @brief 完了済みか返す。 */
+  bool isCompleted() const { return isCompleted_; }
+  /** @brief スケジューラへ登録済みか返す。 */
+  bool isAttached() const { return scheduler_ != nullptr; }
+
+  /** @brief 直近の待機解除理由を返す。 */
+  flowWaitResult lastWaitResult() const { return lastWaitResult_; }
+  /** @brief 直近に受信したメッセージ（kMessage / kTaskError 時に有効）を返す。 */
+  const appTaskMessage& lastMessage() const { return lastMessage_; }
+
+  /**
+   * @brief メッセージ受信待機を登録する。
+   * @param expectedSourceTaskId 期待する送信元。kUnknownなら送信元を問わない。
+   * @param expectedMessageType 期待するメッセージ種別。
+   * @param waitDetail 追加一致条件（null可）。文字列はフロー完了まで有効であること。
+   * @param timeoutMs タイムアウト(ms)。kWaitForeverで無期限。
+   * @note [重要] 期待送信元から kTaskError が届いた場合は kTaskError で待機を解除する（appUtil::waitMessage と同じ判定）。
+   */
+  void waitMessage(appTaskId expectedSourceTaskId,
+                   appMessageType expectedMessageType,
+                   const appUtil::appTaskMessageDetail* waitDetail,
+                   uint32_t timeoutMs);
+  /**
+   * @brief 送信元・種別を問わずメッセージ受信を待機する。
+   * @param timeoutMs タイムアウト(ms)。
+   * @note [重要] メールボックスの全メッセージを自身で処理する常駐フロー用。保留箱へは退避されない。
+   */
+  void waitAnyMessage(uint32_t timeoutMs);
+  /** @brief 指定時間待機する。 */
+  void sleepFor(uint32_t durationMs);
+  /** @brief 次周期まで制御を返す。 */
+  void yieldNow();
+  /**
+   * @brief ソケット受信可を待機する。
+   * @param socketFd lwIP / POSIX ソケット記述子。
+   * @param timeoutMs タイムアウト(ms)。
+   */
+  void waitSocketReadable(int32_t socketFd, uint32_t timeoutMs);
+  /**
+   * @brief FreeRTOS Queue の受信を待機する（I2C応答Queueなど）。
+   * @param queueHandle 対象Queue（実機では QueueHandle_t）。
+   * @param itemOut 受信先。待機解除までフロー側で保持すること。
+   * @param timeoutMs タイムアウト(ms)。
+   */
+  void waitQueueItem(void* queueHandle, void* itemOut, uint32_t timeoutMs);
+  /**
+   * @brief 子フローを同じスケジューラへ登録し、その完了を待機する。
+   * @param childFlow 子フロー（未登録であること）。
+   * @param timeoutMs タイムアウト(ms)。タイムアウト時も子フローは継続する。
+   * @return 登録成功時true。
+   */
+  bool startChildFlow(flowBase* childFlow, uint32_t timeoutMs);
+  /**
+   * @brief 所属スケジューラ経由でメッセージを送信する。
+   * @param message 送信メッセージ。
+   * @param timeoutMs 送信待機(ms)。
+   * @return 成功時true。未登録ならfalse。
+   */
+  bool sendMessage(const appTaskMessage& message, uint32_t timeoutMs);
+
+ protected:
+  explicit flowBase(const char* flowName);
+
+ private:
+  friend class flowScheduler;
+
+  void setWait(flowWaitKind waitKind, uint32_t timeoutMs);
+
+  const char* flowName_;
+  flowScheduler* scheduler_ = nullptr;
+  uint8_t mailboxIndex_ = 0;
+  appTaskId mailboxTaskId_ = appTaskId::kUnknown;
+  bool isCompleted_ = false;
+  flowWaitKind waitKind_ = flowWaitKind::kNone;
+  bool hasDeadline_ = false;
+  uint32_t waitStartedAtMs_ = 0;
+  uint32_t waitTimeoutMs_ = 0;
+  appTaskId expectedSourceTaskId_ = appTaskId::kUnknown;
+  appMessageType expectedMessageType_ = appMessageType::kHeartbeat;
+  bool isAnyMessageWait_ = false;
+  const appUtil::appTaskMessageDetail* waitDetail_ = nullptr;
+  int32_t socketFd_ = -1;
+  void* queueHandle_ = nullptr;
+  void* queueItemOut_ = nullptr;
+  flowBase* childFlow_ = nullptr;
+  flowWaitResult lastWaitResult_ = flowWaitResult::kNone;
+  appTaskMessage lastMessage_{};
+};
+
+/**
+ * @brief フローを多重実行する単一タスク用スケジューラ。
+ * @details
+ * - [重要] 複数タスクIDのメールボックスを1スケジューラで受け持てる（ひな形タスクの統合用）。
+ * - [重要] メッセージ待機中のフローがいるメールボックスだけを吸い上げる。どの待機にも一致しなかった
+ *   メッセージは保留箱へ入り、`takeDeferredMessage()` で取り出す（保留箱が空ならOSのQueueから直接取り出す）。
+ * - [重要] 保留箱が満杯のときはメッセージを元のメールボックスの末尾へ戻し、その周期の吸い上げを止める（破棄しない）。
+ * - [制限] 登録フロー数・メールボックス数・保留件数は固定上限（ヒープ確保なし）。
+ */
+class flowScheduler {
+ public:
+  /** @brief 同時登録できる最大フロー数。@type size_t */
+  static constexpr size_t kMaxFlowCount = 8;
+  /** @brief 受け持てる最大メールボックス数。@type size_t */
+  static constexpr size_t kMaxMailboxCount = 4;
+  /**
+   * @brief 保留箱容量（全メールボックス共用）。@type size_t
+   * @note [重要] appTaskMessage は約260byteのため、メールボックス別に持たず共用にして内部RAMを抑える。
+   * @note [重要] 起動時は mainTask が9タスクへ startup 要求を送り、Wi-Fi 接続フローの待機中に9件の応答が届く。
+   *       その9件 + 余裕3件とする。溢れた分は破棄せずメールボックス（OSのQueue）の末尾へ戻す。
+   */
+  static constexpr size_t kDeferredMessageCapacity = 12;
+  /** @brief 複数メールボックス/ソケット/Queue待機時のポーリング刻み(ms)。@type uint32_t */
+  static constexpr uint32_t kPollSliceMs = 10;
+
+  /**
+   * @brief スケジューラを初期化する。
+   * @param schedulerName ログ用名称。
+   * @param platform プラットフォーム実装（実機ではnullで既定実装）。
+   * @return 初期化成功時true。
+   */
+  bool initialize(const char* schedulerName, const flowPlatform* platform);
+
+  /**
+   * @brief メールボックスを受け持つ。Queue自体は呼び出し側で registerTaskQueue 済みであること。
+   * @param taskId 受け持つタスクID。
+   * @return 成功時true。
+   */
+  bool registerMailbox(appTaskId taskId);
+
+  /**
+   * @brief フローを登録する。
+   * @param flow 登録するフロー（スケジューラより長く生存すること）。
+   * @param mailboxTaskId フローが受信に使うメールボックス。
+   * @return 成功時true。
+   */
+  bool addFlow(flowBase* flow, appTaskId mailboxTaskId);
+
+  /**
+   * @brief 1周期分処理する。実行可能フローが無ければ最大maxIdleMs待機する。
+   * @param maxIdleMs 最大待機時間(ms)。
+   * @return 今周期で step() したフロー数。
+   */
+  uint32_t runOnce(uint32_t maxIdleMs);
+
+  /**
+   * @brief 指定時間のあいだ runOnce を繰り返す。
+   * @param durationMs 実行時間(ms)。
+   */
+  void runFor(uint32_t durationMs);
+
+  /**
+   * @brief 指定フローの完了まで runOnce を繰り返す。
+   * @param flow 対象フロー（登録済み）。
+   * @return 完了時true。未登録ならfalse。
+   * @note [重要] 待機中も同じスケジューラ上の他フローは動作し続ける。
+   */
+  bool runUntilCompleted(flowBase* flow);
+
+  /**
+   * @brief 保留箱（空ならメールボックス）からメッセージを1件取り出す。待機はしない。
+   * @param taskId メールボックスのタスクID。
+   * @param messageOut 出力先（null不可）。
+   * @return 取り出せた場合true。
+   */
+  bool takeDeferredMessage(appTaskId taskId, appTaskMessage* messageOut);
+
+  /**
+   * @brief メッセージを送信する（フロー用）。
+   * @param message 送信メッセージ。
+   * @param timeoutMs 送信待機(ms)。
+   * @return 成功時true。
+   */
+  bool sendMessage(const appTaskMessage& message, uint32_t timeoutMs);
+
+  /** @brief 現在時刻(ms)。 */
+  uint32_t nowMs() const;
+  /** @brief 未完了の登録フロー数。 */
+  size_t activeFlowCount() const;
+
+ private:
+  int32_t findMailboxIndex(appTaskId taskId) const;
+  bool dispatchMessage(uint8_t mailboxIndex, const appTaskMessage& message);
+  bool pushDeferredMessage(const appTaskMessage& message);
+  void pollWaitConditions(uint32_t nowMs);
+  void wakeFlow(flowBase* flow, flowWaitResult waitResult);
+  uint32_t computeIdleWaitMs(uint32_t nowMs, uint32_t maxIdleMs) const;
+  void receiveFromMailboxes(uint32_t idleWaitMs);
+  bool hasMessageWaiter(uint8_t mailboxIndex) const;
+  void releaseCompletedFlows();
+
+  const char* schedulerName_ = "flowScheduler";
+  const flowPlatform* platform_ = nullptr;
+  flowBase* flows_[kMaxFlowCount] = {};
+  bool isReady_[kMaxFlowCount] = {};
+  appTaskId mailboxTaskIds_[kMaxMailboxCount] = {};
+  size_t mailboxCount_ = 0;
+  appTaskMessage deferredMessages_[kDeferredMessageCapacity] = {};
+  size_t deferredCount_ = 0;
+};
+
+/**
+ * @brief 「要求送信→応答待ち」を1フローにまとめた汎用フロー。
+ * @details
+ * - [重要] `appUtil::sendMessage` + `appUtil::waitMessage` の組を置き換える。応答待ち中に届いた無関係な
+ *   メッセージは破棄されず、スケジューラの保留箱へ残る。
+ * - [厳守] `configure` で要求内容をメッセージへ複写するため、呼び出し側文字列の寿命は configure 中だけでよい。
+ */
+class requestReplyFlow : public flowBase {
+ public:
+  explicit requestReplyFlow(const char* flowName);
+
+  /**
+   * @brief 要求と期待応答を設定する。未完了のまま再設定はできない。
+   * @param destinationTaskId 要求先タスク。
+   * @param sourceTaskId 自タスク（応答の宛先）。
+   * @param requestType 要求メッセージ種別。
+   * @param requestDetail 要求詳細（null可）。
+   * @param replyType 期待する応答種別。
+   * @param sendTimeoutMs 送信待機(ms)。
+   * @param replyTimeoutMs 応答待機(ms)。
+   * @return 設定成功時true。
+   */
+  bool configure(appTaskId destinationTaskId,
+                 appTaskId sourceTaskId,
+                 appMessageType requestType,
+                 const appUtil::appTaskMessageDetail* requestDetail,
+                 appMessageType replyType,
+                 uint32_t sendTimeoutMs,
+                 uint32_t replyTimeoutMs);
+
+  flowStepResult step() override;
+
+  /** @brief 応答を受信できた場合true。 */
+  bool succeeded() const { return isSucceeded_; }
+  /** @brief 送信に失敗した場合true（応答待ち前に終了）。 */
+  bool sendFailed() const { return isSendFailed_; }
+  /** @brief 受信した応答（succeeded時に有効）。 */
+  const appTaskMessage& replyMessage() const { return lastMessage(); }
+
+ private:
+  enum class stateType : uint8_t { kIdle, kSend, kWaitReply, kDone };
+
+  stateType state_ = stateType::kIdle;
+  appTaskMessage requestMessage_{};
+  appMessageType replyType_ = appMessageType::kHeartbeat;
+  uint32_t sendTimeoutMs_ = 0;
+  uint32_t replyTimeoutMs_ = 0;
+  bool isSucceeded_ = false;
+  bool isSendFailed_ = false;
+};
+
+/**
+ * @brief kStartupRequest に kStartupAck を返し続ける常駐フロー。
+ * @details
+ * - [重要] 実処理を持たないひな形タスクを独立タスクにせず、既存スケジューラへ相乗りさせるために使う。
+ * - [重要] kStartupRequest 以外のメッセージは otherMessageHandler へ渡す（null なら破棄）。
+ */
+class startupAckResponderFlow : public flowBase {
+ public:
+  /** @brief kStartupRequest 以外を受信したときの処理。 */
+  using otherMessageHandlerType = void (*)(const appTaskMessage& message);
+
+  /**
+   * @param selfTaskId 応答元タスクID。
+   * @param ackText kStartupAck の text へ入れる文字列。
+   * @param otherMessageHandler kStartupRequest 以外の受信処理（null可）。
+   */
+  startupAckResponderFlow(appTaskId selfTaskId, const char* ackText, otherMessageHandlerType otherMessageHandler);
+
+  flowStepResult step() override;
+
+ private:
+  appTaskId selfTaskId_;
+  const char* ackText_;
+  otherMessageHandlerType otherMessageHandler_;
+  bool isWaiting_ = false;
+};
+
+#if FLOW_RUNTIME_HAS_COROUTINE
+/**
+ * @brief C++20 コルーチンで記述するフロー。
+ * @details
+ * - [重要] コルーチン関数は `coroutineFlow` を返し、`co_await awaitMessage(...)` などで待機する。
+ * - [重要] 初回 `step()` まで本体は開始しない。コルーチンフレームは operator new で確保される。
+ * - [厳守] スケジューラ登録後は移動しない（待機登録先としてアドレスを保持するため）。
+ */
+class coroutineFlow : public flowBase {
+ public:
+  struct promise_type {
+    coroutineFlow* owner = nullptr;
+
+    coroutineFlow get_return_object() {
+      return coroutineFlow(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception();
+  };
+  using handleType = std::coroutine_handle<promise_type>;
+
+  explicit coroutineFlow(handleType handle);
+  coroutineFlow(coroutineFlow&& other) noexcept;
+  coroutineFlow& operator=(coroutineFlow&&) = delete;
+  ~coroutineFlow() override;
+
+  flowStepResult step() override;
+
+ private:
+  handleType handle_;
+};
+
+/**
+ * @brief コルーチン用待機オブジェクトの共通部。
+ * @details
+ * - [重要] `await_suspend` で所有フローへ待機条件を登録し、`await_resume` で解除理由を返す。
+ */
+template <typename registerFunctionType>
+struct flowAwaiter {
+  registerFunctionType registerWait;
+  coroutineFlow* owner = nullptr;
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(coroutineFlow::handleType handle) {
+    owner = handle.promise().owner;
+    registerWait(owner);
+  }
+  flowWaitResult await_resume() const noexcept { return owner->lastWaitResult(); }
+};
+
+/**
+ * @brief メッセージ受信を待つ。受信内容は await 後に `lastMessage()` で参照する。
+ */
+inline auto awaitMessage(appTaskId expectedSourceTaskId, appMessageType expectedMessageType, uint32_t timeoutMs) {
+  auto registerWait = [=](coroutineFlow* owner) {
+    owner->waitMessage(expectedSourceTaskId, expectedMessageType, nullptr, timeoutMs);
+  };
+  return flowAwaiter<decltype(registerWait)>{registerWait};
+}
+
+/** @brief 指定時間待機する。 */
+inline auto awaitSleep(uint32_t durationMs) {
+  auto registerWait = [=](coroutineFlow* owner) { owner->sleepFor(durationMs); };
+  return flowAwaiter<decltype(registerWait)>{registerWait};
+}
+
+/** @brief ソケット受信可を待つ。 */
+inline auto awaitSocketReadable(int32_t socketFd, uint32_t timeoutMs) {
+  auto registerWait = [=](coroutineFlow* owner) { owner->waitSocketReadable(socketFd, timeoutMs); };
+  return flowAwaiter<decltype(registerWait)>{registerWait};
+}
+
+/** @brief Queue受信（I2C応答など）を待つ。 */
+inline auto awaitQueueItem(void* queueHandle, void* itemOut, uint32_t timeoutMs) {
+  auto registerWait = [=](coroutineFlow* owner) { owner->waitQueueItem(queueHandle, itemOut, timeoutMs); };
+  return flowAwaiter<decltype(registerWait)>{registerWait};
+}
+
+/** @brief 子フローを開始して完了を待つ。 */
+inline auto awaitFlow(flowBase* childFlow, uint32_t timeoutMs) {
+  auto registerWait = [=](coroutineFlow* owner) { owner->startChildFlow(childFlow, timeoutMs); };
+  return flowAwaiter<decltype(registerWait)>{registerWait};
+}
+#endif
+
+}  // namespace flowRuntime
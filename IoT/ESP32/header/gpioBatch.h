@@ -0,0 +1,189 @@
+/**
+ * @file gpioBatch.h
+ * @brief 出力ポート（リレー/GPIO/LED）の一括制御定義。
+ * @details
+ * - [重要] 複数の出力操作を1回で検証し、GPIO の W1TS/W1TC レジスタへ直接書き込んで同時に切り替える。
+ *   1操作ずつ digitalWrite すると出力ごとに切替時刻がずれるため、シーン制御ではこちらを使う。
+ * - [厳守] 操作できるのは gpioBatch.cpp の許可表にある出力だけ。未許可の出力を含む要求は全体を拒否し、
+ *   1つも出力を変えない（部分適用しない）。
+ * - [重要] `led` は基板の状態LED（index 0=青 GPIO7 / 1=緑 GPIO6 / 2=赤 GPIO5、led.h）を指す。
+ *   ピン初期化は ledController が行い、本モジュールは出力レベルだけを書く。
+ * - [重要] `led` を書いた LED は ledController の手動制御になり、表示パターン（通信中の緑点滅など）で上書きされない。
+ *   再起動、またはメンテナンスモード表示への切替まで保持する。
+ * - [厳守] リレー/汎用出力は、拡張基板を配線した個体のビルドでだけ `APP_GPIO_BATCH_EXPANSION_OUTPUTS=1` を
+ *   指定して有効にする。既定（0）では `relay` / `gpio` は許可表に無く、起動時もそれらのピンへ触れない。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef APP_GPIO_BATCH_EXPANSION_OUTPUTS
+#define APP_GPIO_BATCH_EXPANSION_OUTPUTS 0
+#endif
+
+/**
+ * @brief 出力の種別（MQTT の `target` / サブコマンドに対応）。
+ */
+enum class gpioBatchTarget : uint8_t {
+  /** リレー（`set relay` の `channel`）。 */
+  kRelay = 0,
+  /** 汎用出力（`set gpio_H` / `set gpio_L` の `index`）。 */
+  kGpio,
+  /** 状態LED（`set led_ON` / `set led_OFF` の `index`）。 */
+  kLed,
+  kUnknown,
+};
+
+/** @brief 1回の一括操作で受け付ける最大操作数。@type uint8_t */
+constexpr uint8_t kGpioBatchMaxOperations = 16;
+
+/**
+ * @brief 出力操作1件。
+ */
+struct gpioBatchOperation {
+  /** @brief 出力種別。@type gpioBatchTarget */
+  gpioBatchTarget target;
+  /** @brief 出力番号（relay は channel、gpio/led は index）。@type uint8_t */
+  uint8_t index;
+  /** @brief true で ON/High（出力の論理レベル。負論理の配線は許可表で吸収する）。@type bool */
+  bool isActive;
+};
+
+/**
+ * @brief 一括操作の拒否理由。
+ */
+enum class gpioBatchError : uint8_t {
+  kNone = 0,
+  /** 操作が0件。 */
+  kEmpty,
+  /** 操作数が kGpioBatchMaxOperations を超える。 */
+  kTooMany,
+  /** 許可表に無い出力。 */
+  kUnknownOutput,
+  /** 同じ出力へ ON と OFF を同時に指定した。 */
+  kConflict,
+  /** 出力ポートが未初期化。 */
+  kNotInitialized,
+};
+
+/**
+ * @brief 一括操作の結果。
+ */
+struct gpioBatchResult {
+  /** @brief 出力へ反映した場合true。@type bool */
+  bool isApplied;
+  /** @brief 拒否理由。@type gpioBatchError */
+  gpioBatchError error;
+  /** @brief 拒否の原因となった操作の位置（0始まり）。拒否なしは 0xFF。@type uint8_t */
+  uint8_t failedOperationIndex;
+  /** @brief 反映した操作数。@type uint8_t */
+  uint8_t appliedCount;
+  /** @brief レジスタ書込みの回数（W1TS/W1TC のうち値が0でないもの）。@type uint8_t */
+  uint8_t registerWriteCount;
+};
+
+/** @brief GPIOバンク数（GPIO0-31 / GPIO32-48）。@type uint8_t */
+constexpr uint8_t kGpioBatchBankCount = 2;
+
+/**
+ * @brief 検証済みの一括操作（レジスタへ書くマスク）。
+ * @details
+ * - [重要] prepareOperations で作り、applyPlan で書き込む。予約実行では受信時に作っておき、発火時は書くだけにする。
+ */
+struct gpioBatchPlan {
+  /** @brief High にするピンのマスク（バンク別）。@type uint32_t[] */
+  uint32_t setMasks[kGpioBatchBankCount];
+  /** @brief Low にするピンのマスク（バンク別）。@type uint32_t[] */
+  uint32_t clearMasks[kGpioBatchBankCount];
+  /** @brief 手動制御へ切り替える状態LED（bit=LED番号）。@type uint8_t */
+  uint8_t ledOverrideMask;
+  /** @brief 手動制御へ切り替える状態LEDの点灯状態（bit=LED番号）。@type uint8_t */
+  uint8_t ledActiveMask;
+  /** @brief 含まれる操作数。@type uint8_t */
+  uint8_t operationCount;
+};
+
+namespace gpioBatch {
+
+/**
+ * @brief 許可表のリレー/汎用出力を OUTPUT にし、OFF（非アクティブ）へそろえる。
+ * @return 成功時true。
+ * @details
+ * - [厳守] mainTask の起動時に1回、ledController の初期化後に呼ぶ（リレーを不定状態のまま放置しない）。
+ * - [重要] 状態LEDのピンは ledController が初期化済みのため触れない。拡張出力が無効なら設定するピンは無い。
+ */
+bool initializeOutputs();
+
+/**
+ * @brief 出力操作をまとめて検証し、同時に反映する。
+ * @param operations 操作配列。
+ * @param operationCount 操作数。
+ * @param resultOut 結果出力先（null不可）。
+ * @return 反映した場合true。拒否時は false で、出力は変えない。
+ */
+bool applyOperations(const gpioBatchOperation* operations, uint8_t operationCount, gpioBatchResult* resultOut);
+
+/**
+ * @brief 出力操作を検証し、レジスタへ書くマスクを作る（出力は変えない）。
+ * @param operations 操作配列。
+ * @param operationCount 操作数。
+ * @param planOut 検証済み操作の出力先（null不可）。
+ * @param resultOut 結果出力先（null不可）。拒否理由を設定する。
+ * @return 検証成功時true。
+ */
+bool prepareOperations(const gpioBatchOperation* operations,
+                       uint8_t operationCount,
+                       gpioBatchPlan* planOut,
+                       gpioBatchResult* resultOut);
+
+/**
+ * @brief 検証済みの一括操作を書き込む。
+ * @param plan prepareOperations の結果。
+ * @param resultOut 結果出力先（null不可）。
+ * @return 反映した場合true。
+ * @details
+ * - [重要] 予約実行の発火（esp_timer タスク）からも呼ぶため、ログを含む待ちを一切含めない。結果のログは呼出し側で出す。
+ */
+bool applyPlan(const gpioBatchPlan& plan, gpioBatchResult* resultOut);
+
+/**
+ * @brief 出力の現在の論理状態を読む（出力レジスタから読むため、直前の一括操作の結果と一致する）。
+ * @param target 出力種別。
+ * @param index 出力番号。
+ * @param isActiveOut 出力先（null不可）。
+ * @return 許可表にある出力ならtrue。
+ */
+bool readOutputState(gpioBatchTarget target, uint8_t index, bool* isActiveOut);
+
+/**
+ * @brief 許可表にある出力番号を、表の順に列挙する。
+ * @param target 出力種別。
+ * @param indexesOut 出力番号の出力先。
+ * @param capacity indexesOut の要素数。
+ * @return 書き込んだ件数。
+ */
+uint8_t listOutputIndexes(gpioBatchTarget target, uint8_t* indexesOut, uint8_t capacity);
+
+/**
+ * @brief 種別名（"relay" / "gpio" / "led"）から種別を得る。
+ * @param targetName 種別名。
+ * @return 種別。不明は kUnknown。
+ */
+gpioBatchTarget parseTargetName(const char* targetName);
+
+/**
+ * @brief 種別名を返す。
+ * @param target 出力種別。
+ * @return 種別名。
+ */
+const char* getTargetName(gpioBatchTarget target);
+
+/**
+ * @brief 拒否理由の文字列を返す（ログ/応答の detail 用）。
+ * @param error 拒否理由。
+ * @return 文字列。
+ */
+const char* getErrorText(gpioBatchError error);
+
+}  // namespace gpioBatch
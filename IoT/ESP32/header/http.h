@@ -9,14 +9,24 @@
 #include <freertos/task.h>
 #include <stdint.h>
 
+namespace flowRuntime {
+class flowScheduler;
+}
+
 class httpTask {
  public:
   bool startTask();
 
+  /**
+   * @brief 専用タスクを作らず、既存スケジューラ上の起動応答フローとして動作させる。
+   * @param schedulerOut 相乗り先スケジューラ（初期化済み、null不可）。
+   * @return 成功時true。
+   * @note [重要] ひな形段階では起動応答しか持たないため、配置表（taskPlacement.cpp）の httpTask 行の分のスタックを確保しない。
+   *       実処理を実装する段階で startTask() へ戻す。
+   */
+  bool attachToFlowScheduler(flowRuntime::flowScheduler* schedulerOut);
+
  private:
   static void taskEntry(void* taskParameter);
   void runLoop();
-
-  static constexpr uint32_t taskStackSize = 4096;
-  static constexpr UBaseType_t taskPriority = 1;
 };
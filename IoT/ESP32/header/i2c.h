@@ -4,7 +4,7 @@
  * @details
  * - [重要] I2Cデバイスを複数接続する前提で、同時アクセス競合を防止する。
  * - [厳守] I2Cデバイス操作は本サービスのキュー経由で実行する。
- * - [将来対応] LCD以外のI2Cデバイス要求（センサー等）を同一キューへ統合する。
+ * - [重要] センサーは外部デバイス枠組み（externalDevice.h）が本サービスのタスク内で周期測定する。
  */
 
 #pragma once
@@ -74,7 +74,9 @@ class i2cService {
    * @param timeoutMs 応答待機時間ms。
    * @return 読み取り成功時true、失敗時false。
    * @details
-   * - [重要] I2Cアクセスは内部キュー経由でI2C専用タスクへ委譲する。
+   * - [重要] 周期測定のスナップショットが新しければ即時に返す。古い/未測定の場合のみ内部キュー経由で
+   *   I2C専用タスクへ即時測定を依頼する。
+   * - [重要] 即時測定が失敗した場合は、前回のスナップショットが残っていても false を返す（snapshotOut には前回値が入る）。
    * - [厳守] LCD表示と同時に呼ばれても、直接 `Wire` へアクセスしない。
    */
   bool requestEnvironmentSnapshot(i2cEnvironmentSnapshot* snapshotOut, uint32_t timeoutMs);
@@ -89,11 +91,6 @@ class i2cService {
    * @brief I2C専用ループ処理。
    */
   void runLoop();
-
-  /** @brief I2C専用タスクのスタックサイズ。@type uint32_t */
-  static constexpr uint32_t taskStackSize = 4096;
-  /** @brief I2C専用タスクの優先度。@type UBaseType_t */
-  static constexpr UBaseType_t taskPriority = 2;
 };
 
 /**
@@ -16,7 +16,11 @@ class inputTask {
  private:
   static void taskEntry(void* taskParameter);
   void runLoop();
-
-  static constexpr uint32_t taskStackSize = 4096;
-  static constexpr UBaseType_t taskPriority = 1;
 };
+
+/**
+ * @brief チャタリング除去後のボタン押下状態を返す。
+ * @param isPressedOut 出力先（null不可）。
+ * @return 入力タスクが監視を開始済みならtrue。
+ */
+bool readStableButtonState(bool* isPressedOut);
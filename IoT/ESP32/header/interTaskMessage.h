@@ -5,6 +5,8 @@
  * - [重要] 各タスクは専用Queueを持ち、宛先タスクIDで配送する。
  * - [推奨] まずは起動通知/ACKの制御に利用し、将来コマンド配送へ拡張する。
  * - [制限] 同一タスクの重複registerは許容しない（falseを返す）。
+ * - [重要] 要求の完了を待つ場合は完了通知トークン（appCompletionToken）を要求メッセージへ載せる。
+ *   処理側はトークンを完了させるだけで、待つ側は自分のQueueを読まずにタイムアウト付きで待てる。
  */
 
 #pragma once
@@ -14,6 +16,40 @@
 #include <stdint.h>
 #include "define.h"
 
+/**
+ * @brief 完了通知トークン。
+ * @details
+ * - [重要] 値型（4byte）なのでメッセージにそのまま載せられる。generation=0 は「完了通知不要」を表す。
+ * - [重要] 待つ側がタイムアウトして枠を返した後に届いた完了は、generation 不一致として捨てる（別の要求を誤って完了させない）。
+ */
+struct appCompletionToken {
+  /** @brief 完了通知枠の番号。@type uint16_t */
+  uint16_t slotIndex;
+  /** @brief 枠の払い出し世代（0は無効）。@type uint16_t */
+  uint16_t generation;
+};
+
+/**
+ * @brief 完了通知の待機結果。
+ */
+enum class appCompletionResult : uint8_t {
+  /** 処理側が成功で完了させた。 */
+  kSucceeded = 0,
+  /** 処理側が失敗で完了させた。 */
+  kFailed,
+  /** 待機時間内に完了しなかった。 */
+  kTimeout,
+  /** 無効なトークン（未発行/払い出し済み枠の再利用）。 */
+  kInvalidToken,
+};
+
+/**
+ * @brief トークンが完了通知を要求しているか判定する。
+ * @param token 判定するトークン。
+ * @return generation が 0 以外なら true。
+ */
+inline bool isCompletionRequested(const appCompletionToken& token) { return token.generation != 0; }
+
 /**
  * @brief タスク間で送受信するメッセージ構造体。
  */
@@ -38,6 +74,8 @@ struct appTaskMessage {
   char text3[64];
   /** @brief 汎用テキストパラメータ4。@type char[64] */
   char text4[64];
+  /** @brief 完了通知トークン（不要なら generation=0）。@type appCompletionToken */
+  appCompletionToken completionToken;
 };
 
 /**
@@ -67,6 +105,15 @@ class interTaskMessageService {
    */
   bool sendMessage(const appTaskMessage& message, TickType_t timeoutTicks);
 
+  /**
+   * @brief 宛先タスクのQueueへ待たずに送信する（失敗してもログを出さない）。
+   * @details
+   * - [重要] esp_timer コールバックなど、ログ出力で処理を遅らせたくない文脈向け。失敗の記録は呼出し側で行う。
+   * @param message 送信するメッセージ。
+   * @return 成功時true、未初期化/宛先不正/Queue満杯時false。
+   */
+  bool trySendMessage(const appTaskMessage& message);
+
   /**
    * @brief 指定タスクQueueからメッセージ受信する。
    * @param taskId 受信対象タスクID。
@@ -75,6 +122,39 @@ class interTaskMessageService {
    * @return 受信成功時true、失敗/タイムアウト時false。
    */
   bool receiveMessage(appTaskId taskId, appTaskMessage* messageOut, TickType_t timeoutTicks);
+
+  /**
+   * @brief 完了通知枠を1つ払い出す（待つ側が要求送信前に呼ぶ）。
+   * @details
+   * - [厳守] 払い出したトークンは awaitCompletion か cancelCompletion で必ず返却する。
+   * @param tokenOut 払い出したトークン出力先（null不可）。
+   * @return 成功時true、空き枠なし/未初期化時false。
+   */
+  bool acquireCompletion(appCompletionToken* tokenOut);
+
+  /**
+   * @brief 完了通知を送る（処理側が呼ぶ。待つ側のタスクを即座に起こす）。
+   * @param token 要求メッセージに載っていたトークン。
+   * @param succeeded 処理結果。
+   * @return 完了させた場合true。待つ側が既にタイムアウト/取消済み、または無効なトークンならfalse。
+   */
+  bool completeCompletion(const appCompletionToken& token, bool succeeded);
+
+  /**
+   * @brief 完了通知を待ち、枠を返却する（待つ側が呼ぶ）。
+   * @details
+   * - [重要] 自タスクのQueueは読まないため、待機中に届いた他のメッセージは失われない。
+   * @param token acquireCompletion で得たトークン。
+   * @param timeoutTicks 待機Tick。
+   * @return 待機結果。
+   */
+  appCompletionResult awaitCompletion(const appCompletionToken& token, TickType_t timeoutTicks);
+
+  /**
+   * @brief 完了を待たずに枠を返却する（要求の送信に失敗した場合など）。
+   * @param token acquireCompletion で得たトークン。
+   */
+  void cancelCompletion(const appCompletionToken& token);
 };
 
 /**
@@ -12,6 +12,19 @@
 #include <freertos/task.h>
 #include <stdint.h>
 
+/** @brief 青LEDのGPIO番号。@type uint8_t */
+constexpr uint8_t kBlueLedGpio = 7;
+/** @brief 緑LEDのGPIO番号。@type uint8_t */
+constexpr uint8_t kGreenLedGpio = 6;
+/** @brief 赤LEDのGPIO番号。@type uint8_t */
+constexpr uint8_t kRedLedGpio = 5;
+/** @brief 青LEDの番号（MQTT `led` の index、手動制御マスクのビット位置）。@type uint8_t */
+constexpr uint8_t kBlueLedIndex = 0;
+/** @brief 緑LEDの番号。@type uint8_t */
+constexpr uint8_t kGreenLedIndex = 1;
+/** @brief 赤LEDの番号。@type uint8_t */
+constexpr uint8_t kRedLedIndex = 2;
+
 /**
  * @brief GPIO直叩きでLED表示を制御するサービス。
  */
@@ -85,6 +98,18 @@ class ledController {
    * - 0.3s ON -> 0.3s OFF -> 0.3s ON -> 0.3s OFF -> 1.0s ON -> 0.3s OFF
    */
   static void indicateMaintenanceModeBluePatternCycle();
+
+  /**
+   * @brief 状態LEDを手動制御（gpioBatch の `led` 操作）へ切り替える。
+   * @param ledIndexMask 対象LEDのビット（bit0=青 / bit1=緑 / bit2=赤）。
+   * @param activeMask 対象LEDの手動レベル（ビットが1なら点灯）。
+   * @details
+   * - [重要] 手動制御中のLEDは表示パターン（通信中の緑点滅など）で書き換えない。
+   *   再起動、またはメンテナンスモード表示への切替まで保持する。
+   * - [厳守] ロック・ログ・待ちを含めない（予約実行の発火で esp_timer タスクから呼ばれるため）。
+   *   gpioBatch はレジスタへ書く前に呼ぶ。
+   */
+  static void setManualOverride(uint8_t ledIndexMask, uint8_t activeMask);
 };
 
 class ledTask {
@@ -98,9 +123,4 @@ class ledTask {
  private:
   static void taskEntry(void* taskParameter);
   void runLoop();
-
-  /** @brief LEDタスクスタックサイズ。@type uint32_t */
-  static constexpr uint32_t taskStackSize = 4096;
-  /** @brief LEDタスク優先度。@type UBaseType_t */
-  static constexpr UBaseType_t taskPriority = 1;
 };
@@ -0,0 +1,161 @@
+/**
+ * @file mirrorDownload.h
+ * @brief 複数ミラーからのイメージ取得（先頭プローブによる取得元選択、転送中のミラー切替、全体SHA-256検証）定義。
+ * @details
+ * - [重要] OTA（firmware.bin）と imagePackageApply（ZIP）が共通で使う。URL は優先順の配列で渡す
+ *   （例: LocalServer のキャッシュ → クラウドのオリジン）。
+ * - [重要] 取得の流れ:
+ *   1. 各 URL へ `Range: bytes=0-(probeBytes-1)` を順に送り、接続開始からプローブ完了までの平均速度を測る（本文は捨てる）。
+ *      全体サイズが優先順で最初に成功した URL と異なる URL は使わない。
+ *   2. 速度が最も速い URL から先頭を取得する（同速なら優先順）。
+ *   3. 区間（throughputWindowMs）ごとの速度がその接続の最高値の collapsePercent% を下回り、かつ他の URL の推定速度の方が速い場合、
+ *      接続を閉じて現在の位置から `Range: bytes=<offset>-` で他の URL へ切り替える。無通信・切断時も同様に再開する。
+ *   4. 受信順に SHA-256 を計算し、全量の受信後に期待値と照合する。
+ * - [厳守] 出力先（sink）へは先頭から順にしか渡さない。範囲要求に応じない URL（200 応答）は先頭からの取得にだけ使い、
+ *   途中からの再開には使わない。
+ * - [制限] HTTP/1.1 の `Content-Length` 付き応答のみ扱う（chunked 転送は失敗として扱う）。リダイレクトは 3 回まで追う。
+ * - [制限] 呼出し元タスクで同期実行する。プローブは URL ごとに最大 probeBytes を余分に取得する。
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief 扱う URL の最大数。超えた分は無視する。@type uint8_t */
+constexpr uint8_t kMirrorDownloadMaxSources = 4;
+
+/**
+ * @brief ホスト名を IPv4 へ解決する関数。
+ * @param host ホスト名（IPv4 文字列は呼ばれる前に解決済み）。
+ * @param ipOut 解決結果の出力先。
+ * @return 成功時true。
+ */
+typedef bool (*mirrorDownloadResolveHost)(const char* host, IPAddress* ipOut);
+
+/**
+ * @brief 受信データの出力先。
+ * @param sinkContext run へ渡した文脈。
+ * @param data 受信データ。
+ * @param length 長さ(byte)。
+ * @param offset data 先頭のイメージ内位置(byte)。前回の offset + length と常に一致する。
+ * @param totalBytes イメージ全体のサイズ(byte)。
+ * @return 継続する場合true。false なら取得を中止する。
+ */
+typedef bool (*mirrorDownloadSink)(void* sinkContext, const uint8_t* data, size_t length, uint32_t offset, uint32_t totalBytes);
+
+/**
+ * @brief 取得条件。
+ */
+struct mirrorDownloadOptions {
+  /** @brief プローブで取得する先頭サイズ(byte)。@type uint32_t */
+  uint32_t probeBytes;
+  /** @brief プローブ1件の上限時間(ms)。超えた時点までの受信量で速度を求める。@type uint32_t */
+  uint32_t probeTimeoutMs;
+  /** @brief 無通信のまま待つ上限(ms)。超えたら別の URL（または同じ URL の再接続）で再開する。@type uint32_t */
+  uint32_t idleTimeoutMs;
+  /** @brief 取得全体の上限時間(ms)。@type uint32_t */
+  uint32_t totalTimeoutMs;
+  /** @brief 速度を評価する区間(ms)。@type uint32_t */
+  uint32_t throughputWindowMs;
+  /** @brief 区間速度が接続内の最高値のこの割合(%)を下回ったら切替を検討する。@type uint8_t */
+  uint8_t collapsePercent;
+  /** @brief 取得開始後の接続し直し（切替・再開）の上限回数。@type uint8_t */
+  uint8_t maxSwitchCount;
+  /** @brief URL 1件あたりの失敗（接続失敗・無通信・切断）の上限回数。超えた URL は以後使わない。@type uint8_t */
+  uint8_t maxFailuresPerSource;
+  /** @brief 許容するイメージサイズの上限(byte)。0 で無制限。@type uint32_t */
+  uint32_t maxImageBytes;
+  /** @brief https 以外の URL（リダイレクト先を含む）を拒否するか。@type bool */
+  bool isHttpsRequired;
+  /** @brief TLS 検証に使うルートCA証明書PEM（https の URL がある場合は null/空不可、呼出し中は保持すること）。@type const char* */
+  const char* tlsCaCertificate;
+  /** @brief ホスト名の解決関数。null なら WiFi.hostByName を使う。@type mirrorDownloadResolveHost */
+  mirrorDownloadResolveHost resolveHost;
+  /** @brief 要求の User-Agent（null なら既定値）。@type const char* */
+  const char* userAgent;
+};
+
+/**
+ * @brief URL 1件分の結果。
+ */
+struct mirrorDownloadSourceStats {
+  /** @brief 実際に取得した URL（リダイレクト後）。@type String */
+  String url;
+  /** @brief プローブに成功し、取得候補になったか。@type bool */
+  bool isProbeOk;
+  /** @brief 範囲要求に 206 で応じたか（途中からの再開に使えるか）。@type bool */
+  bool isRangeSupported;
+  /** @brief プローブの最初の本文受信までの時間(ms)。@type uint32_t */
+  uint32_t probeFirstByteMs;
+  /** @brief プローブの平均速度(KB/s)。@type uint32_t */
+  uint32_t probeKbps;
+  /** @brief この URL から出力先へ渡した量(byte)。@type uint32_t */
+  uint32_t downloadedBytes;
+  /** @brief 失敗回数。@type uint8_t */
+  uint8_t failureCount;
+  /** @brief 直近の失敗理由（成功のみなら "ok"）。@type const char* */
+  const char* detail;
+};
+
+/**
+ * @brief 取得結果。
+ */
+struct mirrorDownloadResult {
+  /** @brief イメージ全体のサイズ(byte)。@type uint32_t */
+  uint32_t totalBytes;
+  /** @brief 出力先へ渡した量(byte)。@type uint32_t */
+  uint32_t downloadedBytes;
+  /** @brief 所要時間(ms)。プローブを含む。@type uint32_t */
+  uint32_t elapsedMs;
+  /** @brief 取得開始後に接続し直した回数。@type uint8_t */
+  uint8_t switchCount;
+  /** @brief 最後に取得した URL の位置（未取得なら -1）。@type int8_t */
+  int8_t finalSourceIndex;
+  /** @brief 出力先へデータを渡した URL の位置のビット集合。@type uint8_t */
+  uint8_t usedSourceMask;
+  /** @brief 受信データの SHA-256（小文字16進）。全量を受信できなかった場合は空。@type char[] */
+  char sha256Hex[65];
+  /** @brief 失敗理由（成功時 "ok"）。@type const char* */
+  const char* detail;
+  /** @brief 扱った URL 数。@type uint8_t */
+  uint8_t sourceCount;
+  /** @brief URL ごとの結果。@type mirrorDownloadSourceStats[] */
+  mirrorDownloadSourceStats sources[kMirrorDownloadMaxSources];
+};
+
+namespace mirrorDownload {
+
+/**
+ * @brief 既定の取得条件を返す。
+ * @details
+ * - [推奨] probeBytes=16384、probeTimeoutMs=5000、idleTimeoutMs=15000、totalTimeoutMs=300000、throughputWindowMs=3000、
+ *   collapsePercent=25、maxSwitchCount=6、maxFailuresPerSource=2。
+ */
+mirrorDownloadOptions getDefaultOptions();
+
+/**
+ * @brief 複数 URL からイメージを取得する。
+ * @param urls 優先順の URL 配列（null不可）。空文字は無視する。
+ * @param urlCount URL 数（kMirrorDownloadMaxSources を超えた分は無視）。
+ * @param options 取得条件。
+ * @param expectedSha256 期待する SHA-256（16進、大小文字不問、null/空なら照合しない）。
+ * @param sink 出力先（null不可）。
+ * @param sinkContext 出力先へ渡す文脈（null可）。
+ * @param resultOut 結果の出力先（null不可）。失敗時も途中までの統計を残す。
+ * @return 全量を受信し、SHA-256 が一致した場合true。
+ * @details
+ * - [重要] false かつ resultOut->sha256Hex が空でない場合は、全量を受信したが SHA-256 が一致しなかったことを表す。
+ *   出力先へデータを渡した URL は resultOut->usedSourceMask で分かる（次回の候補から外す判断に使う）。
+ */
+bool run(const String* urls,
+         size_t urlCount,
+         const mirrorDownloadOptions& options,
+         const char* expectedSha256,
+         mirrorDownloadSink sink,
+         void* sinkContext,
+         mirrorDownloadResult* resultOut);
+
+}  // namespace mirrorDownload
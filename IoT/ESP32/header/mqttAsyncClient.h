@@ -0,0 +1,447 @@
+/**
+ * @file mqttAsyncClient.h
+ * @brief 非同期 MQTT 3.1.1 クライアント中核（送信キュー、QoS1 送信窓、逐次パケット解析）の定義。
+ * @details
+ * - [重要] `publish()` / `subscribe()` はパケットを送信キューへ積むだけで、通信路への書込みは `poll()` が行う。
+ *   `poll()` 1回あたりの書込み量は `maxWriteBytesPerPoll` で制限し、大きな payload でも呼び出し元を長く止めない。
+ * - [重要] QoS1 publish は packet id を払い出して送信窓（最大 `kMaxInflightWindow`）へ保持し、PUBACK で解放する。
+ *   切断中も窓に空きがあれば受理し、再接続（CONNACK 受信）後に送信順で再送する。既送分に DUP=1 を付けるのは
+ *   CONNACK の sessionPresent=1（Clean Session=0 でブローカーがセッションを保持）の場合だけで、
+ *   新規セッション（Clean Session=1 など）では新規 PUBLISH として DUP=0 で送り直す。
+ * - [重要] 受信は `mqttPacketParser` が任意の分割（1byteずつを含む）で届くバイト列からパケットを組み立てる。
+ *   PubSubClient と異なり受信上限（`maxIncomingPacketBytes`）と送信サイズ（送信キュー容量）は独立している。
+ * - [重要] 通信路は `mqttTransport`（関数ポインタ）で抽象化する。実機は `makeArduinoClientTransport()`、
+ *   ホストは `tools/fleetSimulator/mqttWireBroker` などのブローカー代替へ直結する。
+ * - [制限] 送信 QoS2 は扱わない（QoS0/1 のみ）。受信 QoS2 は PUBREC/PUBCOMP で応答し、PUBLISH 受信時点で1回配送する。
+ *   端末発の通知は受信側が id で重複排除する前提で QoS1 の重複配送を許容でき、QoS2 の2往復追加と
+ *   メッセージ毎の状態保持（PUBREC/PUBREL 待ち）に見合う用途がないため。
+ * - [制限] 1クライアントは1タスクからのみ駆動する。排他制御は持たない。
+ * - [重要] `mqtt.cpp` は本クライアントを mqttTask から駆動する（PubSubClient は使わない）。
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+class Client;
+#endif
+
+namespace mqttAsync {
+
+/** @brief QoS1 送信窓の上限（同時に PUBACK 待ちにできる件数）。@type uint8_t */
+constexpr uint8_t kMaxInflightWindow = 32;
+/** @brief 送信キューのうち PUBACK / PINGREQ などの制御パケット用に確保しておく byte 数。@type size_t */
+constexpr size_t kControlReserveBytes = 64;
+
+/**
+ * @brief 送信/購読 QoS。
+ */
+enum class mqttQos : uint8_t {
+  kAtMostOnce = 0,
+  kAtLeastOnce = 1,
+};
+
+/**
+ * @brief クライアント状態。
+ */
+enum class mqttClientState : uint8_t {
+  /** 通信路なし。QoS1 publish は送信窓へ保留できる。 */
+  kDisconnected = 0,
+  /** CONNECT 送信済み、CONNACK 待ち。 */
+  kAwaitingConnack,
+  /** CONNACK(0) 受信済み。 */
+  kConnected,
+};
+
+/**
+ * @brief `publish()` / `subscribe()` の受付結果。
+ */
+enum class mqttEnqueueResult : uint8_t {
+  kQueued = 0,
+  /** QoS0 / SUBSCRIBE は接続中のみ受け付ける。 */
+  kNotConnected,
+  /** 送信キューに空きが無い。`poll()` 後に再試行する。 */
+  kQueueFull,
+  /** QoS1 送信窓が満杯。PUBACK 受信後に再試行する。 */
+  kWindowFull,
+  /** パケットが送信キュー容量を超える。 */
+  kTooLarge,
+  kInvalidArgument,
+};
+
+/**
+ * @brief MQTT 制御パケット種別（固定ヘッダー上位4bit）。
+ */
+enum class mqttPacketType : uint8_t {
+  kConnect = 1,
+  kConnack = 2,
+  kPublish = 3,
+  kPuback = 4,
+  kPubrec = 5,
+  kPubrel = 6,
+  kPubcomp = 7,
+  kSubscribe = 8,
+  kSuback = 9,
+  kUnsubscribe = 10,
+  kUnsuback = 11,
+  kPingreq = 12,
+  kPingresp = 13,
+  kDisconnect = 14,
+};
+
+/**
+ * @brief 通信路の抽象。
+ * @details
+ * - [厳守] `write` / `read` は待機しない。0 は「今は送れない/データなし」、負値は切断を表す。
+ */
+struct mqttTransport {
+  /** @brief 各関数へ渡す利用側コンテキスト。 */
+  void* context;
+  /** @brief 最大 length byte を送る。受理した byte 数（0..length）または負値を返す。 */
+  int32_t (*write)(void* context, const uint8_t* data, size_t length);
+  /** @brief 最大 capacity byte を受信する。受信 byte 数（0..capacity）または負値を返す。 */
+  int32_t (*read)(void* context, uint8_t* bufferOut, size_t capacity);
+};
+
+#if defined(ESP_PLATFORM)
+/**
+ * @brief Arduino `Client`（WiFiClient / WiFiClientSecure 派生）を使う通信路を返す。
+ * @param client 接続済みクライアント（null不可、通信路の利用中は破棄しないこと）。
+ * @return 通信路。
+ * @details
+ * - [制限] TLS の `write` は 1 レコード分の暗号化・送信まで戻らない。待機時間は `maxWriteBytesPerPoll` で抑える。
+ */
+mqttTransport makeArduinoClientTransport(Client* client);
+#endif
+
+/**
+ * @brief 組み立て済みの受信パケット。ポインタはコールバック内でのみ有効。
+ */
+struct mqttPacketView {
+  /** @brief 固定ヘッダー1byte目。@type uint8_t */
+  uint8_t headerByte;
+  /** @brief 可変ヘッダー + payload。@type const uint8_t* */
+  const uint8_t* body;
+  /** @brief body の長さ（Remaining Length）。@type size_t */
+  size_t bodyLength;
+
+  /** @brief パケット種別を返す。 */
+  mqttPacketType type() const { return static_cast<mqttPacketType>(headerByte >> 4); }
+  /** @brief 固定ヘッダーのフラグ（下位4bit）を返す。 */
+  uint8_t flags() const { return static_cast<uint8_t>(headerByte & 0x0F); }
+};
+
+/**
+ * @brief 逐次 MQTT パケット解析器。
+ * @details
+ * - [重要] `feed()` は任意長の断片を受け取り、完成したパケットごとに handler を呼ぶ。
+ *   固定ヘッダー・Remaining Length（可変長整数）・本体のいずれの途中で分割されてもよい。
+ * - [重要] 上限を超えるパケットは保持せず `hasError()` を立てる。以降の解析は `reset()` まで停止する。
+ */
+class mqttPacketParser {
+ public:
+  /** @brief パケット完成時のコールバック。 */
+  using packetHandler = void (*)(void* context, const mqttPacketView& packet);
+
+  mqttPacketParser() = default;
+  ~mqttPacketParser();
+  mqttPacketParser(const mqttPacketParser&) = delete;
+  mqttPacketParser& operator=(const mqttPacketParser&) = delete;
+
+  /**
+   * @brief 受信バッファを確保する。
+   * @param maxPacketBodyBytes 受理する Remaining Length の上限。
+   * @return 確保成功時true。
+   */
+  bool initialize(size_t maxPacketBodyBytes);
+
+  /**
+   * @brief 受信断片を解析する。
+   * @param data 受信データ。
+   * @param length 長さ。
+   * @param handler パケット完成時のコールバック。
+   * @param context コールバックへ渡すコンテキスト。
+   * @return 解析エラーが無ければtrue。
+   */
+  bool feed(const uint8_t* data, size_t length, packetHandler handler, void* context);
+
+  /** @brief 解析途中の状態を破棄する（再接続時）。 */
+  void reset();
+
+  /** @brief 解析エラー（上限超過、Remaining Length 不正）が発生したか返す。 */
+  bool hasError() const { return stage_ == parseStage::kError; }
+
+ private:
+  enum class parseStage : uint8_t {
+    kHeader = 0,
+    kRemainingLength,
+    kBody,
+    kError,
+  };
+
+  parseStage stage_ = parseStage::kHeader;
+  uint8_t headerByte_ = 0;
+  uint32_t remainingLength_ = 0;
+  uint32_t remainingLengthMultiplier_ = 1;
+  uint8_t remainingLengthBytes_ = 0;
+  size_t bodyReceived_ = 0;
+  uint8_t* bodyBuffer_ = nullptr;
+  size_t bodyCapacity_ = 0;
+};
+
+/**
+ * @brief クライアントの構成値。
+ */
+struct mqttAsyncClientConfig {
+  /** @brief 送信キュー容量(byte)。最大 publish サイズもこれで決まる。@type size_t */
+  size_t sendQueueBytes;
+  /** @brief 受信パケット（Remaining Length）の上限(byte)。@type size_t */
+  size_t maxIncomingPacketBytes;
+  /** @brief QoS1 送信窓（1..kMaxInflightWindow）。@type uint8_t */
+  uint8_t inflightWindow;
+  /** @brief Keep Alive(秒)。0 で PINGREQ を送らない。@type uint16_t */
+  uint16_t keepAliveSeconds;
+  /** @brief `poll()` 1回で通信路へ書き込む上限(byte)。@type size_t */
+  size_t maxWriteBytesPerPoll;
+  /** @brief CONNECT 送信から CONNACK 受信までの上限(ms)。@type uint32_t */
+  uint32_t connackTimeoutMs;
+};
+
+/**
+ * @brief 既定の構成値を返す（送信 8KB、受信 4KB、窓 8、Keep Alive 60秒、1回 1460byte）。
+ */
+mqttAsyncClientConfig getDefaultMqttAsyncClientConfig();
+
+/**
+ * @brief CONNECT の内容。
+ */
+struct mqttConnectOptions {
+  /** @brief クライアントID（null不可）。@type const char* */
+  const char* clientId;
+  /** @brief ユーザー名（不要なら nullptr）。@type const char* */
+  const char* userName;
+  /** @brief パスワード（不要なら nullptr）。@type const char* */
+  const char* password;
+  /** @brief Clean Session。@type bool */
+  bool cleanSession;
+  /** @brief Will トピック（不要なら nullptr）。@type const char* */
+  const char* willTopic;
+  /** @brief Will payload。@type const char* */
+  const char* willPayload;
+  /** @brief Will QoS。@type mqttQos */
+  mqttQos willQos;
+  /** @brief Will retain。@type bool */
+  bool willRetain;
+};
+
+/**
+ * @brief 受信した PUBLISH。ポインタはコールバック内でのみ有効。
+ */
+struct mqttIncomingMessage {
+  /** @brief トピック（終端なし）。@type const char* */
+  const char* topic;
+  /** @brief トピック長。@type size_t */
+  size_t topicLength;
+  /** @brief payload。@type const uint8_t* */
+  const uint8_t* payload;
+  /** @brief payload 長。@type size_t */
+  size_t payloadLength;
+  /** @brief 受信 QoS（0..2）。@type uint8_t */
+  uint8_t qos;
+  /** @brief retain フラグ。@type bool */
+  bool retained;
+  /** @brief DUP フラグ。@type bool */
+  bool duplicate;
+};
+
+/**
+ * @brief クライアントの累積統計。
+ */
+struct mqttAsyncClientStats {
+  /** @brief 送信キューへ積んだ PUBLISH 件数（再送を除く）。@type uint32_t */
+  uint32_t publishQueuedCount;
+  /** @brief PUBACK 受信件数。@type uint32_t */
+  uint32_t publishAckedCount;
+  /** @brief 再接続後に再送した PUBLISH 件数。@type uint32_t */
+  uint32_t retransmitCount;
+  /** @brief 受信 PUBLISH 件数。@type uint32_t */
+  uint32_t messageReceivedCount;
+  /** @brief 送信 byte 数。@type uint64_t */
+  uint64_t bytesSent;
+  /** @brief 受信 byte 数。@type uint64_t */
+  uint64_t bytesReceived;
+  /** @brief 送信キュー使用量の最大値。@type size_t */
+  size_t maxSendQueueUsedBytes;
+  /** @brief 送信窓使用数の最大値。@type uint8_t */
+  uint8_t maxInflightCount;
+  /** @brief 解析エラー・想定外パケットの件数。@type uint32_t */
+  uint32_t protocolErrorCount;
+  /** @brief 制御パケットを送信キューへ積めず破棄した件数。@type uint32_t */
+  uint32_t controlDropCount;
+};
+
+/**
+ * @brief 非同期 MQTT 3.1.1 クライアント。
+ */
+class mqttAsyncClient {
+ public:
+  /** @brief PUBLISH 受信コールバック。 */
+  using messageHandler = void (*)(void* context, const mqttIncomingMessage& message);
+  /** @brief PUBACK 受信コールバック。 */
+  using publishAckHandler = void (*)(void* context, uint16_t packetId);
+  /** @brief SUBACK 受信コールバック。returnCode は 0..2 が許可QoS、0x80 が失敗。 */
+  using subscribeAckHandler = void (*)(void* context, uint16_t packetId, uint8_t returnCode);
+
+  mqttAsyncClient() = default;
+  ~mqttAsyncClient();
+  mqttAsyncClient(const mqttAsyncClient&) = delete;
+  mqttAsyncClient& operator=(const mqttAsyncClient&) = delete;
+
+  /**
+   * @brief 送信キュー・受信バッファを確保する。
+   * @param config 構成値。
+   * @return 成功時true。
+   * @details
+   * - [厳守] 接続前に1回だけ呼ぶ。確保はここでのみ行う（QoS1 の再送用コピーを除く）。
+   */
+  bool initialize(const mqttAsyncClientConfig& config);
+
+  /** @brief PUBLISH 受信コールバックを設定する。 */
+  void setMessageHandler(messageHandler handler, void* context);
+  /** @brief PUBACK 受信コールバックを設定する。 */
+  void setPublishAckHandler(publishAckHandler handler, void* context);
+  /** @brief SUBACK 受信コールバックを設定する。 */
+  void setSubscribeAckHandler(subscribeAckHandler handler, void* context);
+
+  /**
+   * @brief 接続済みの通信路で MQTT セッションを開始する（CONNECT を積む）。
+   * @param transport 通信路（TCP/TLS 接続済み）。
+   * @param options CONNECT の内容。
+   * @param nowMs 現在時刻(ms)。
+   * @return CONNECT を積めた場合true。
+   */
+  bool beginSession(const mqttTransport& transport, const mqttConnectOptions& options, uint32_t nowMs);
+
+  /**
+   * @brief 通信路を切り離す（切断検知時、または明示切断）。
+   * @details
+   * - [重要] 送信キューと解析途中の受信は破棄する。QoS1 送信窓は保持し、次の `beginSession()` 後に再送する。
+   */
+  void endSession();
+
+  /**
+   * @brief DISCONNECT を積む。送信完了後に `poll()` が通信路を切り離す。
+   * @return 積めた場合true。
+   */
+  bool requestDisconnect();
+
+  /**
+   * @brief PUBLISH を送信キュー（QoS1 は送信窓）へ積む。
+   * @param topic トピック（null不可）。
+   * @param payload payload（length が 0 なら null可）。
+   * @param payloadLength payload 長。
+   * @param qos QoS。
+   * @param retained retain フラグ。
+   * @param packetIdOut QoS1 の packet id 出力先（不要なら nullptr、QoS0 は 0）。
+   * @return 受付結果。
+   */
+  mqttEnqueueResult publish(const char* topic,
+                            const uint8_t* payload,
+                            size_t payloadLength,
+                            mqttQos qos,
+                            bool retained,
+                            uint16_t* packetIdOut);
+
+  /**
+   * @brief SUBSCRIBE（1フィルタ）を送信キューへ積む。
+   * @param topicFilter トピックフィルタ（null不可）。
+   * @param qos 要求QoS。
+   * @param packetIdOut packet id 出力先（不要なら nullptr）。
+   * @return 受付結果。
+   */
+  mqttEnqueueResult subscribe(const char* topicFilter, mqttQos qos, uint16_t* packetIdOut);
+
+  /**
+   * @brief 送信・受信・Keep Alive を1回進める。待機しない。
+   * @param nowMs 現在時刻(ms)。
+   * @return セッション継続時true。切断・タイムアウト・プロトコルエラー時は `endSession()` 済みで false。
+   */
+  bool poll(uint32_t nowMs);
+
+  /** @brief 状態を返す。 */
+  mqttClientState state() const { return state_; }
+  /** @brief CONNACK(0) 受信済みか返す。 */
+  bool isConnected() const { return state_ == mqttClientState::kConnected; }
+  /** @brief 直近の CONNACK 戻りコードを返す（未受信は 0xFF）。 */
+  uint8_t lastConnackReturnCode() const { return lastConnackReturnCode_; }
+  /** @brief PUBACK 待ち（未送信・再送待ちを含む）の件数を返す。 */
+  uint8_t inflightCount() const { return inflightCount_; }
+  /** @brief 送信キューの使用量(byte)を返す。 */
+  size_t sendQueueUsedBytes() const { return sendQueueUsed_; }
+  /** @brief 累積統計を返す。 */
+  const mqttAsyncClientStats& stats() const { return stats_; }
+
+ private:
+  /** @brief 送信窓の1枠。packet は QoS1 PUBLISH の完成形（DUP=0）。DUP は送信キューへ積む時に付ける。 */
+  struct inflightEntry {
+    bool isUsed;
+    bool isQueued;
+    bool wasSent;
+    uint16_t packetId;
+    uint32_t sequence;
+    uint8_t* packet;
+    size_t packetLength;
+  };
+
+  static void onPacketParsed(void* context, const mqttPacketView& packet);
+  void handlePacket(const mqttPacketView& packet);
+  void handleIncomingPublish(const mqttPacketView& packet);
+  void handlePublishAck(uint16_t packetId);
+  bool enqueueControlPacket(mqttPacketType type, uint8_t flags, uint16_t packetId);
+  bool enqueueBytes(const uint8_t* data, size_t length, bool useControlReserve);
+  size_t sendQueueFreeBytes() const { return sendQueueCapacity_ - sendQueueUsed_; }
+  void queueInflightPackets();
+  bool flushSendQueue(uint32_t nowMs);
+  bool receiveFromTransport();
+  uint16_t allocatePacketId();
+  void markProtocolError(const char* reason);
+
+  mqttAsyncClientConfig config_ = {};
+  bool isInitialized_ = false;
+  mqttClientState state_ = mqttClientState::kDisconnected;
+  mqttTransport transport_ = {};
+  bool hasTransport_ = false;
+  bool disconnectRequested_ = false;
+  bool protocolErrorPending_ = false;
+  uint8_t lastConnackReturnCode_ = 0xFF;
+  bool isSessionPresent_ = false;
+
+  uint8_t* sendQueue_ = nullptr;
+  size_t sendQueueCapacity_ = 0;
+  size_t sendQueueHead_ = 0;
+  size_t sendQueueUsed_ = 0;
+
+  mqttPacketParser parser_;
+  inflightEntry inflight_[kMaxInflightWindow] = {};
+  uint8_t inflightCount_ = 0;
+  uint32_t nextSequence_ = 0;
+  uint16_t lastPacketId_ = 0;
+
+  uint32_t sessionStartedAtMs_ = 0;
+  uint32_t lastSentAtMs_ = 0;
+  uint32_t pingSentAtMs_ = 0;
+  bool isPingOutstanding_ = false;
+
+  messageHandler messageHandler_ = nullptr;
+  void* messageHandlerContext_ = nullptr;
+  publishAckHandler publishAckHandler_ = nullptr;
+  void* publishAckHandlerContext_ = nullptr;
+  subscribeAckHandler subscribeAckHandler_ = nullptr;
+  void* subscribeAckHandlerContext_ = nullptr;
+
+  mqttAsyncClientStats stats_ = {};
+};
+
+}  // namespace mqttAsync
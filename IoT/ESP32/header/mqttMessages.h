@@ -51,6 +51,66 @@ bool buildMqttStatusPayload(const char* subName,
                             uint32_t startupCpuMillis,
                             String* payloadTextOut);
 
+/**
+ * @brief trh通知に載せるBME280読取値。
+ */
+struct trhNoticeReading {
+  /** @brief センサーのI2Cアドレス。@type uint8_t */
+  uint8_t sensorAddress = 0;
+  /** @brief 温度[°C]。@type float */
+  float temperatureC = 0.0f;
+  /** @brief 相対湿度[%RH]。@type float */
+  float humidityRh = 0.0f;
+  /** @brief 気圧[hPa]。@type float */
+  float pressureHpa = 0.0f;
+};
+
+/**
+ * @brief trh通知payloadを生成する（mqtt_notice.cpp）。
+ * @param sourceId 送信元ノード名（null不可）。
+ * @param destinationId 宛先ID（null/空は"all"）。
+ * @param messageId メッセージID（null不可）。
+ * @param timestampText tsへ入れるUTC文字列（null可）。
+ * @param isSuccess 読取成功フラグ（falseのときargsに測定値を含めない）。
+ * @param detailText 補足メッセージ（null可）。
+ * @param reading 読取値。
+ * @param payloadTextOut 出力先（null不可）。
+ * @return 成功時true、失敗時false。
+ */
+bool buildTrhNoticePayload(const char* sourceId,
+                           const char* destinationId,
+                           const char* messageId,
+                           const char* timestampText,
+                           bool isSuccess,
+                           const char* detailText,
+                           const trhNoticeReading& reading,
+                           String* payloadTextOut);
+
+/**
+ * @brief fileSyncStatus通知payloadを生成する（mqtt_notice.cpp）。
+ * @param sourceId 送信元ノード名（null不可）。
+ * @param destinationId 宛先ID（null/空は"all"）。
+ * @param messageId メッセージID（null不可）。
+ * @param sessionId セッションID（null可）。
+ * @param targetArea 対象領域（null可）。
+ * @param phase フェーズ（null可）。
+ * @param result 結果（OK/NG、null可）。
+ * @param detail 詳細メッセージ（null可）。
+ * @param errorCode エラーコード（null可）。
+ * @param payloadTextOut 出力先（null不可）。
+ * @return 成功時true、失敗時false。
+ */
+bool buildFileSyncStatusPayload(const char* sourceId,
+                                const char* destinationId,
+                                const char* messageId,
+                                const char* sessionId,
+                                const char* targetArea,
+                                const char* phase,
+                                const char* result,
+                                const char* detail,
+                                const char* errorCode,
+                                String* payloadTextOut);
+
 /**
  * @brief statusメッセージを送信する。
  * @param mqttClientOut 送信先クライアント（null不可）。
@@ -0,0 +1,154 @@
+/**
+ * @file networkSelfTest.h
+ * @brief 通信経路の自己診断（TCP / TLS の往復時間・スループット計測）定義。
+ * @details
+ * - [重要] 指定した計測用エンドポイント（LocalServer、または `tools/fleetSimulator` の netSelfTestScenario `--serve`）へ
+ *   平文 TCP と TLS の順に接続し、同じ接続上で ping（往復時間）→ ダウンロード → アップロードを行う。
+ * - [重要] OTA / 画像パッケージの取得失敗が「電波品質」「TLS の CPU 負荷」「サーバー速度」のどれによるかを、
+ *   RSSI、TLS ハンドシェイク時間、平文と TLS のスループット差で切り分けるために使う。
+ * - [重要] 再送による停滞は端末側から直接は見えないため、受信（送信）間隔が閾値を超えた回数と合計時間で表す。
+ * - [制限] 計測は呼出し元タスクで同期実行する（既定設定で数秒、最大で数十秒）。同時に1件のみ。
+ *   mqtt.cpp は専用の netSelfTestTask から呼び、mqttTask の Keep Alive を止めない。
+ *
+ * 計測用エンドポイントの HTTP/1.1（keep-alive）仕様:
+ * - `GET /selftest/ping` → 200、本文なし。
+ * - `GET /selftest/download?bytes=N` → 200、`Content-Length: N` の本文。
+ * - `POST /selftest/upload`（`Content-Length: N`）→ 全量受信後に 200、本文 `received=N`。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct cJSON;
+
+/** @brief 往復時間の度数分布の区間数（1us 〜 約8秒以上）。@type uint8_t */
+constexpr uint8_t kNetworkSelfTestBucketCount = 24;
+/** @brief 計測モード数（tcp / tls）。@type uint8_t */
+constexpr uint8_t kNetworkSelfTestModeCount = 2;
+
+/**
+ * @brief 計測条件。
+ */
+struct networkSelfTestOptions {
+  /** @brief 計測用エンドポイントのホスト名または IPv4 文字列（null不可、呼出し中は保持すること）。@type const char* */
+  const char* host;
+  /** @brief 平文 TCP のポート。0 で平文計測を省略。@type uint16_t */
+  uint16_t tcpPort;
+  /** @brief TLS のポート。0 で TLS 計測を省略。@type uint16_t */
+  uint16_t tlsPort;
+  /** @brief ダウンロード / アップロードそれぞれの転送量(byte)。4096〜1048576。@type uint32_t */
+  uint32_t transferBytes;
+  /** @brief ping 回数。1〜64。@type uint16_t */
+  uint16_t pingCount;
+  /** @brief 停滞とみなす受信/送信間隔(ms)。50〜2000。@type uint16_t */
+  uint16_t stallThresholdMs;
+  /** @brief TLS 検証に使うルートCA証明書PEM（null/空なら TLS 計測は失敗として記録）。@type const char* */
+  const char* tlsCaCertificate;
+};
+
+/**
+ * @brief ダウンロード / アップロード1回分の結果。
+ */
+struct networkSelfTestTransfer {
+  /** @brief 実転送量(byte)。@type uint32_t */
+  uint32_t bytes;
+  /** @brief 所要時間(us)。要求送信から最終 byte の受信（応答受信）まで。@type uint32_t */
+  uint32_t elapsedUs;
+  /** @brief 停滞回数（間隔が閾値以上）。@type uint16_t */
+  uint16_t stallCount;
+  /** @brief 停滞の合計時間(us)。@type uint32_t */
+  uint32_t stallTotalUs;
+  /** @brief 最大の受信/送信間隔(us)。@type uint32_t */
+  uint32_t maxGapUs;
+  /** @brief 全量を転送できたか。@type bool */
+  bool isComplete;
+};
+
+/**
+ * @brief 計測モード1件（tcp / tls）の結果。
+ */
+struct networkSelfTestModeResult {
+  /** @brief モード名（tcp / tls）。@type const char* */
+  const char* name;
+  /** @brief 接続先ポート。@type uint16_t */
+  uint16_t port;
+  /** @brief 計測を行ったか（ポート 0 なら false）。@type bool */
+  bool isAttempted;
+  /** @brief 全段階を完了したか。@type bool */
+  bool isSuccess;
+  /** @brief 失敗した段階の説明（成功時 "ok"）。@type const char* */
+  const char* detail;
+  /** @brief 接続所要時間(us)。TLS はハンドシェイクを含む。@type uint32_t */
+  uint32_t connectUs;
+  /** @brief TLS ハンドシェイク時間(us)。同じポートへの TCP 接続時間を差し引いた値。@type uint32_t */
+  uint32_t tlsHandshakeUs;
+  /** @brief ping 成功回数。@type uint16_t */
+  uint16_t rttCount;
+  /** @brief ping 失敗回数。@type uint16_t */
+  uint16_t rttErrorCount;
+  /** @brief 往復時間の合計(us)。@type uint32_t */
+  uint32_t rttTotalUs;
+  /** @brief 往復時間の最小(us)。@type uint32_t */
+  uint32_t rttMinUs;
+  /** @brief 往復時間の最大(us)。@type uint32_t */
+  uint32_t rttMaxUs;
+  /** @brief 往復時間の度数分布（bucket i = [2^i, 2^(i+1)) us）。@type uint16_t[] */
+  uint16_t rttBuckets[kNetworkSelfTestBucketCount];
+  /** @brief ダウンロード結果。@type networkSelfTestTransfer */
+  networkSelfTestTransfer download;
+  /** @brief アップロード結果。@type networkSelfTestTransfer */
+  networkSelfTestTransfer upload;
+};
+
+/**
+ * @brief 計測結果。
+ */
+struct networkSelfTestReport {
+  /** @brief 計測条件（範囲へ丸めた後）。@type networkSelfTestOptions */
+  networkSelfTestOptions options;
+  /** @brief 接続先 IPv4 文字列。@type char[] */
+  char resolvedIp[16];
+  /** @brief 名前解決の所要時間(us)。@type uint32_t */
+  uint32_t dnsUs;
+  /** @brief 計測全体の所要時間(ms)。@type uint32_t */
+  uint32_t elapsedMs;
+  /** @brief RSSI の最小(dBm)。@type int8_t */
+  int8_t rssiMin;
+  /** @brief RSSI の最大(dBm)。@type int8_t */
+  int8_t rssiMax;
+  /** @brief RSSI の合計（平均算出用）。@type int32_t */
+  int32_t rssiSum;
+  /** @brief RSSI の採取回数。@type uint16_t */
+  uint16_t rssiSampleCount;
+  /** @brief モード別結果（[0]=tcp, [1]=tls）。@type networkSelfTestModeResult[] */
+  networkSelfTestModeResult modes[kNetworkSelfTestModeCount];
+};
+
+namespace networkSelfTest {
+
+/**
+ * @brief 既定の計測条件を返す（host 未設定 / TCP 8090 / TLS 8443 / 128KB / ping 16回 / 停滞 200ms）。
+ */
+networkSelfTestOptions getDefaultOptions();
+
+/**
+ * @brief 計測を実行する。
+ * @param options 計測条件（範囲外は上下限へ丸める）。
+ * @param reportOut 結果出力先（null不可）。
+ * @param detailOut 失敗理由出力先（null可）。
+ * @return 名前解決まで完了し、いずれかのモードを計測した場合true。モード単位の失敗は modes[].detail に記録する。
+ * @details
+ * - [厳守] Wi-Fi 未接続、host 未指定、名前解決失敗、実行中の重複呼出しは false を返す。
+ */
+bool run(const networkSelfTestOptions& options, networkSelfTestReport* reportOut, const char** detailOut);
+
+/**
+ * @brief 計測結果を JSON オブジェクトへ書き込む（`host` `ip` `dnsUs` `elapsedMs` `options` `rssi` `modes`）。
+ * @param report 計測結果。
+ * @param objectOut 書込み先（null不可）。
+ * @return 成功時true。
+ */
+bool appendReportToJson(const networkSelfTestReport& report, cJSON* objectOut);
+
+}  // namespace networkSelfTest
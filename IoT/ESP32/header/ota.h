@@ -10,17 +10,22 @@
 #include <Arduino.h>
 #include <stdint.h>
 
+#include <vector>
+
 /**
  * @brief OTA開始要求の保持モデル。
  * @details
  * - [重要] MQTT受信時にURLや版数を一時保持し、OTAタスクで安全に参照する。
  * - [厳守] 機密値は保持しない。ファームURLとSHA256のみ扱う。
+ * - [重要] mirrorUrls は優先順のミラー（例: LocalServer のキャッシュ → クラウド）。取得候補は mirrorUrls の後ろに
+ *   firmwareUrl（重複時は除く）を加えた列とし、先頭プローブで速い URL から取得する（mirrorDownload.h 参照）。
  */
 struct otaStartRequestContext {
   String transactionId;
   String firmwareVersion;
   String firmwareUrl;
   String firmwareSha256;
+  std::vector<String> mirrorUrls;
 };
 
 /**
@@ -30,6 +35,14 @@ struct otaStartRequestContext {
  */
 bool storePendingOtaStartRequest(const otaStartRequestContext& requestContext);
 
+/**
+ * @brief OTA 更新を実行中か（otaTask が要求を取り出してから、失敗で終わるまで）。
+ * @return 実行中ならtrue。
+ * @details
+ * - [重要] 他タスクから参照してよい。成功時はそのまま再起動するため false へは戻らない。
+ */
+bool isOtaInProgress();
+
 class otaTask {
  public:
   bool startTask();
@@ -37,7 +50,4 @@ class otaTask {
  private:
   static void taskEntry(void* taskParameter);
   void runLoop();
-
-  static constexpr uint32_t taskStackSize = 16384;
-  static constexpr UBaseType_t taskPriority = 1;
 };
@@ -0,0 +1,142 @@
+/**
+ * @file taskPlacement.h
+ * @brief タスク配置表（コア/優先度/スタック配置/スタックサイズ）とコア別負荷計測の定義。
+ * @details
+ * - [重要] 全タスクのコア割当・優先度・スタック配置・スタックサイズは taskPlacement.cpp の配置表へ集約する。
+ *   各 `startTask()` は `createPlacedStaticTask()` を呼び、個別に値を持たない。
+ * - [重要] 配置方針: 通信/TLS 系（Wi-Fi/MQTT/OTA/HTTP/TCPIP/NTP）は Wi-Fi ドライバ・lwIP と同じ core0、
+ *   フラッシュ書込み系（ファイルログ）と入出力系（I2C/LED/入力/mainTask）は core1 に置く。
+ * - [推奨] 配置を変えたら status の `cpuLoadCore0` / `cpuLoadCore1` とログ `taskPlacement: cpu load` で効果を確認する。
+ * - [制限] 本ヘッダーはホスト（fleetSimulator）からも参照されるため、FreeRTOS の型以外に依存しない。
+ */
+
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdint.h>
+
+namespace taskPlacement {
+
+/** @brief 通信/TLS 系タスクを置くコア（Wi-Fi ドライバ・lwIP と同じ PRO_CPU）。@type BaseType_t */
+constexpr BaseType_t kNetworkCoreId = 0;
+/** @brief アプリ処理・フラッシュ書込み系タスクを置くコア（Arduino loop と同じ APP_CPU）。@type BaseType_t */
+constexpr BaseType_t kApplicationCoreId = 1;
+/** @brief 計測対象の最大コア数（ESP32-S3 は 2）。@type uint8_t */
+constexpr uint8_t kMaxCoreCount = 2;
+
+/**
+ * @brief 配置表のタスク識別子。
+ * @details
+ * - [厳守] 値は配置表（taskPlacement.cpp）の並びと一致させる。追加時は kCount の直前へ追加する。
+ */
+enum class placedTaskId : uint8_t {
+  kMain = 0,
+  kWifi,
+  kMqtt,
+  kHttp,
+  kTcpip,
+  kOta,
+  kTimeServer,
+  kExternalDevice,
+  kDisplay,
+  kLed,
+  kInput,
+  kI2c,
+  kFileLogWriter,
+  kNetworkSelfTest,
+  kCount,
+};
+
+/**
+ * @brief タスクスタックの配置先。
+ */
+enum class taskStackLocation : uint8_t {
+  /** PSRAM を優先し、確保失敗時は内部RAMへフォールバックする（従来の各 startTask と同じ動作）。 */
+  kPsramPreferred = 0,
+  /** 内部RAMのみ。キャッシュ無効中（フラッシュ操作中）も動作が必要なタスク向け。 */
+  kInternalOnly,
+};
+
+/**
+ * @brief 配置表の1行。
+ */
+struct taskPlacementEntry {
+  /** @brief FreeRTOS タスク名。@type const char* */
+  const char* taskName;
+  /** @brief コア割当（kNetworkCoreId / kApplicationCoreId / tskNO_AFFINITY）。@type BaseType_t */
+  BaseType_t coreId;
+  /** @brief 優先度。@type UBaseType_t */
+  UBaseType_t priority;
+  /** @brief スタック配置先。@type taskStackLocation */
+  taskStackLocation stackLocation;
+  /** @brief スタックサイズ（byte）。@type uint32_t */
+  uint32_t stackSize;
+};
+
+/**
+ * @brief コア別負荷の計測結果。
+ */
+struct cpuLoadSnapshot {
+  /** @brief 1回以上計測窓が完了していれば true。@type bool */
+  bool isValid;
+  /** @brief 計測方式（"runTimeStats" / "idleTick"）。@type const char* */
+  const char* methodName;
+  /** @brief 計測したコア数。@type uint8_t */
+  uint8_t coreCount;
+  /** @brief コア別負荷(%)。0..100。@type uint8_t */
+  uint8_t loadPercent[kMaxCoreCount];
+  /** @brief 直近の計測窓の長さ(ms)。@type uint32_t */
+  uint32_t sampleWindowMs;
+};
+
+/**
+ * @brief 配置表の1行を返す。
+ * @param taskId 対象タスク。
+ * @return 配置表の行。範囲外の場合は kMain の行を返す。
+ */
+const taskPlacementEntry& getPlacement(placedTaskId taskId);
+
+/**
+ * @brief 配置表に従ってスタックを確保し、静的タスクを生成する。
+ * @param taskId 対象タスク。
+ * @param taskEntry タスクエントリ関数。
+ * @param taskParameter タスク引数。
+ * @param stackBufferInOut スタック領域ポインタの保持先。null 以外が入っていれば再利用する。
+ * @param controlBlockOut タスク制御ブロック。
+ * @param taskHandleOut 生成したタスクハンドルの出力先（不要なら nullptr）。
+ * @return 生成成功時true、失敗時false。
+ * @details
+ * - [重要] 生成時に「タスク名・コア・優先度・スタック配置・サイズ」を1行ログへ出す。配置の確認はこのログで行う。
+ */
+bool createPlacedStaticTask(placedTaskId taskId,
+                            TaskFunction_t taskEntry,
+                            void* taskParameter,
+                            StackType_t** stackBufferInOut,
+                            StaticTask_t* controlBlockOut,
+                            TaskHandle_t* taskHandleOut);
+
+/**
+ * @brief コア別負荷の計測を開始する（idle hook 登録）。
+ * @return 開始成功時true、失敗時false。
+ * @details
+ * - [推奨] mainTask の先頭で1回呼ぶ。2回目以降は何もしない。
+ */
+bool startCpuLoadSampling();
+
+/**
+ * @brief 計測窓が経過していればコア別負荷を更新する。
+ * @param nowMs 現在時刻(ms)。
+ * @details
+ * - [推奨] mainTask の周期処理から呼ぶ。窓は 10 秒。
+ */
+void updateCpuLoadSampling(uint32_t nowMs);
+
+/**
+ * @brief 直近のコア別負荷を取得する。
+ * @param snapshotOut 出力先。
+ * @return 計測済みの値を出力できた場合true、未計測または引数不正時false。
+ */
+bool getCpuLoadSnapshot(cpuLoadSnapshot* snapshotOut);
+
+}  // namespace taskPlacement
@@ -35,9 +35,4 @@ class timeServerTask {
    * @brief タスク常駐ループ。
    */
   void runLoop();
-
-  /** @brief タスクスタックサイズ。@type uint32_t */
-  static constexpr uint32_t taskStackSize = 4096;
-  /** @brief タスク優先度。@type UBaseType_t */
-  static constexpr UBaseType_t taskPriority = 0;
 };
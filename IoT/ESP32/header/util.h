@@ -66,6 +66,10 @@ struct appTaskMessageDetail {
   const char* text3;
   /** @brief text4一致/設定条件（nullなら無視）。@type const char* */
   const char* text4;
+  /** @brief completionTokenを使用する場合true（設定時のみ。待機条件には使わない）。@type bool */
+  bool hasCompletionToken;
+  /** @brief 完了通知トークン。@type appCompletionToken */
+  appCompletionToken completionToken;
 };
 
 /**
@@ -74,6 +78,27 @@ struct appTaskMessageDetail {
  */
 appTaskMessageDetail createEmptyMessageDetail();
 
+/**
+ * @brief 詳細構造体からタスク間メッセージを組み立てる（送信はしない）。
+ * @param destinationTaskId 送信先タスクID。
+ * @param sourceTaskId 送信元タスクID。
+ * @param requestType 要求内容（メッセージ種別）。
+ * @param requestDetail 要求詳細（null可）。設定済み項目のみ反映する。
+ * @return 組み立てたメッセージ。
+ */
+appTaskMessage buildTaskMessage(appTaskId destinationTaskId,
+                                appTaskId sourceTaskId,
+                                appMessageType requestType,
+                                const appTaskMessageDetail* requestDetail);
+
+/**
+ * @brief メッセージが詳細条件に一致するか判定する。
+ * @param message 判定対象。
+ * @param waitDetail 詳細条件（nullなら常に一致）。設定済み項目のみ比較する。
+ * @return 一致時true。
+ */
+bool messageDetailMatches(const appTaskMessage& message, const appTaskMessageDetail* waitDetail);
+
 /**
  * @brief タスク間メッセージを汎用送信する。
  * @param destinationTaskId 送信先タスクID。
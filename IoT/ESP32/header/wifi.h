@@ -23,13 +23,4 @@ class wifiTask {
  private:
   static void taskEntry(void* taskParameter);
   void runLoop();
-
-  /**
-   * @brief Wi-Fiタスクスタックサイズ。@type uint32_t
-   * @details
-   * - [変更][2026-04-04] Wi-Fi 系の追加ログと原因切り分け余裕を確保するため、最小限として 512 byte 増やす。
-   */
-  static constexpr uint32_t taskStackSize = 4608;
-  /** @brief Wi-Fiタスク優先度。@type UBaseType_t */
-  static constexpr UBaseType_t taskPriority = 1;
 };
@@ -6,6 +6,10 @@
  * - [厳守] MQTT接続前にブローカー到達確認（TCPプローブ）を実施する。
  * - [厳守] MQTT認証はユーザー名/パスワード必須とし、未設定時は接続しない。
  * - [重要] TLS有効時は `SENSITIVE_MQTT_TLS_CA_CERT` を設定し、証明書検証を有効化する。
+ * - [重要] MQTT は mqttAsyncClient で扱う。publish は送信キューへ積むだけで、書込みは mqttTask のループ
+ *   （pollMqttClient）が少しずつ行う。OTA進捗・fileSync/imagePackage 通知は QoS1 で送り、再接続後に再送する。
+ * - [重要] 受信 PUBLISH は poll 中に複製して受信待ち行列へ積み、poll を抜けてから onMqttMessageReceived へ渡す
+ *   （応答 publish から poll を呼んでも受信解析へ再入しない）。
  */
 
 #include "mqtt.h"
@@ -18,18 +22,22 @@
 #include <vector>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
-#include <HTTPClient.h>
-#include <PubSubClient.h>
 #include <LittleFS.h>
-#include <mbedtls/base64.h>
+#include <atomic>
 #include <mbedtls/gcm.h>
 #include <mbedtls/md.h>
 #include <mbedtls/sha256.h>
 #include <cJSON.h>
 
+#include "base64Codec.h"
 #include "common.h"
 #include "firmwareInfo.h"
+#include "flashBenchmark.h"
+#include "networkSelfTest.h"
+#include "commandScheduler.h"
+#include "gpioBatch.h"
 #include "i2c.h"
+#include "input.h"
 #include "interTaskMessage.h"
 #include "jsonService.h"
 #include "mqttPayloadSecurity.h"
@@ -37,28 +45,17 @@
 #include "led.h"
 #include "log.h"
 #include "maintenanceMode.h"
+#include "mirrorDownload.h"
+#include "mqttAsyncClient.h"
 #include "ota.h"
 #include "otaRollback.h"
 #include "sensitiveData.h"
 #include "sensitiveDataService.h"
+#include "taskPlacement.h"
 #include "util.h"
 #include "version.h"
 
 namespace {
-/**
- * @brief OTA進捗フェーズが終端（done/error）か判定する。
- * @param phaseText フェーズ文字列。
- * @return 終端フェーズならtrue。
- */
-bool isTerminalOtaPhase(const char* phaseText) {
-  if (phaseText == nullptr) {
-    return false;
-  }
-  String normalizedPhase = String(phaseText);
-  normalizedPhase.trim();
-  return normalizedPhase.equalsIgnoreCase("done") || normalizedPhase.equalsIgnoreCase("error");
-}
-
 /**
  * @brief MQTT向けTLSクライアント。
  * @details
@@ -81,7 +78,7 @@ class MqttTlsClient : public WiFiClientSecure {
   /**
    * @brief IPアドレス向けconnectを上書きする。
    * @details
-   * - [重要] PubSubClientはIP接続時にこの関数を呼ぶ。
+   * - [重要] openMqttSession はIP接続時にこの関数を呼ぶ。
    * - [重要] TLS検証文脈（host + CA）が有効なら、その文脈でconnectする。
    * @param ip 接続先IPアドレス。
    * @param port 接続先ポート番号。
@@ -167,8 +164,10 @@ StaticTask_t mqttTaskControlBlock;
 WiFiClient mqttNetworkClient;
 /** @brief MQTT(TLS)通信用の下位TCPクライアント。 */
 MqttTlsClient mqttTlsNetworkClient;
-/** @brief PubSubClient本体。mqttNetworkClientを介して通信する。 */
-PubSubClient mqttClient(mqttNetworkClient);
+/** @brief 非同期MQTTクライアント本体。mqttActiveNetworkClient を通信路にする。 */
+mqttAsync::mqttAsyncClient mqttClient;
+/** @brief 現在の通信路（mqttNetworkClient または mqttTlsNetworkClient）。 */
+Client* mqttActiveNetworkClient = &mqttNetworkClient;
 
 /** @brief MQTT接続先ホスト名/IP文字列バッファ。 */
 char mqttHost[64] = {0};
@@ -188,6 +187,37 @@ constexpr const char* statusValueOnline = "Online";
 constexpr int64_t minimumValidUtcEpochMillis = 1609459200000LL;
 /** @brief mainTaskEntry開始時CPU時刻(ms)。publish要求時にmainTaskから受け取る。 */
 uint32_t mainTaskStartupCpuMillis = 0;
+/** @brief status 返信要求を1回の publish へまとめる待ち時間(ms)。 */
+constexpr uint32_t statusReplyCoalesceWindowMs = 200;
+/** @brief 1回の status 返信で応答済みとして列挙する要求元の上限。 */
+constexpr uint8_t statusReplyMaxRequesters = 8;
+/** @brief status 返信の publish 失敗後、再送するまでの待ち時間(ms)。 */
+constexpr uint32_t statusReplyRetryIntervalMs = 1000;
+/** @brief status 返信の publish を試みる上限回数（超えたら破棄してログを残す）。 */
+constexpr uint8_t statusReplyMaxAttempts = 5;
+
+/**
+ * @brief 集約待ちの status 返信要求。
+ * @details
+ * - [重要] 受信コールバックと mqttTask のループは同じタスクで動くため排他は不要。
+ */
+struct statusReplyPendingState {
+  /** @brief 集約待ちの要求があれば true。@type bool */
+  bool isPending;
+  /** @brief 最初の要求を受けた時刻(ms)。再送待ちの間は直前に publish に失敗した時刻。@type uint32_t */
+  uint32_t firstRequestMs;
+  /** @brief publish に失敗した回数。@type uint8_t */
+  uint8_t failedAttemptCount;
+  /** @brief 集約した要求数（同一要求元の重複も数える）。@type uint32_t */
+  uint32_t requestCount;
+  /** @brief 列挙済みの要求元数。@type uint8_t */
+  uint8_t requesterCount;
+  /** @brief 要求元ID（重複なし、受信順）。@type char[][48] */
+  char requesterIds[statusReplyMaxRequesters][48];
+};
+/** @brief 集約待ちの status 返信。 */
+statusReplyPendingState pendingStatusReply{};
+
 /** @brief 送信者/受信者名として利用するデバイス識別子。 */
 String deviceNodeName = "";
 /** @brief pingBrokerHostで解決済みのMQTT接続先IP。 */
@@ -196,6 +226,40 @@ IPAddress mqttResolvedBrokerIpAddress;
 bool mqttResolvedBrokerIpValid = false;
 /** @brief MQTTパケットバッファサイズ（暗号化ペイロード肥大化対策）。 */
 constexpr uint16_t mqttPacketBufferSizeBytes = 4096;
+/** @brief 送信キュー容量。1件の publish 上限でもある（get multi / 診断応答の肥大化に備え受信上限の4倍）。 */
+constexpr size_t mqttSendQueueBytes = 16384;
+/** @brief QoS1 送信窓（OTA進捗は5%刻みのため、再接続をまたいでも足りる件数）。 */
+constexpr uint8_t mqttInflightWindow = 8;
+/** @brief Keep Alive(秒)。 */
+constexpr uint16_t mqttKeepAliveSeconds = 60;
+/** @brief 送信キュー/送信窓の空きを待つ上限(ms)。 */
+constexpr uint32_t mqttPublishQueueWaitMs = 3000;
+/** @brief 終端通知の PUBACK を待つ上限(ms)。OTA 側の待機（3500ms）より短くする。 */
+constexpr uint32_t mqttTerminalAckWaitMs = 3000;
+/** @brief 受信待ち行列の深さ。 */
+constexpr size_t mqttReceivedQueueDepth = 8;
+/** @brief 受信トピックの最大長。 */
+constexpr size_t mqttMaxTopicLength = 160;
+
+/**
+ * @brief poll 中に受信した PUBLISH の複製。
+ */
+struct mqttReceivedMessage {
+  /** @brief トピック。@type String */
+  String topic;
+  /** @brief payload。@type String */
+  String payload;
+};
+/** @brief 受信待ち行列（リング）。 */
+mqttReceivedMessage mqttReceivedQueue[mqttReceivedQueueDepth];
+/** @brief 受信待ち行列の先頭位置。 */
+size_t mqttReceivedQueueHead = 0;
+/** @brief 受信待ち行列の件数。 */
+size_t mqttReceivedQueueCount = 0;
+/** @brief onMqttMessageReceived を実行中なら true（入れ子の pollMqttClient では配送しない）。 */
+bool isMqttDispatching = false;
+/** @brief mqttClient.initialize 済みなら true。 */
+bool isMqttClientAllocated = false;
 /** @brief MQTT payload暗号化モード（0:平文,1:互換,2:暗号必須）。 */
 #ifndef MQTT_PAYLOAD_SECURITY_MODE
 // [厳守] 本番既定は strict(2)。明示的に上書きしない限り平文受理しない。
@@ -222,48 +286,8 @@ bool ensureMqttSensitiveDataReady() {
   return mqttSensitiveDataInitialized;
 }
 
-/**
- * @brief Base64文字列をバイト列へ復号する。
- * @param inputBase64 入力文字列。
- * @param outputBufferOut 出力先。
- * @return 成功時true。
- */
-bool decodeBase64Text(const String& inputBase64, std::vector<uint8_t>* outputBufferOut) {
-  if (outputBufferOut == nullptr) {
-    appLogError("decodeBase64Text failed. outputBufferOut is null.");
-    return false;
-  }
-  outputBufferOut->clear();
-  size_t outputLength = 0;
-  int32_t firstResult = mbedtls_base64_decode(nullptr,
-                                              0,
-                                              &outputLength,
-                                              reinterpret_cast<const unsigned char*>(inputBase64.c_str()),
-                                              inputBase64.length());
-  if (firstResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && firstResult != 0) {
-    appLogError("decodeBase64Text failed. probe decode result=%ld inputLength=%ld",
-                static_cast<long>(firstResult),
-                static_cast<long>(inputBase64.length()));
-    return false;
-  }
-  outputBufferOut->resize(outputLength);
-  if (outputLength == 0) {
-    return true;
-  }
-  int32_t decodeResult = mbedtls_base64_decode(outputBufferOut->data(),
-                                               outputBufferOut->size(),
-                                               &outputLength,
-                                               reinterpret_cast<const unsigned char*>(inputBase64.c_str()),
-                                               inputBase64.length());
-  if (decodeResult != 0) {
-    appLogError("decodeBase64Text failed. decode result=%ld inputLength=%ld", static_cast<long>(decodeResult), static_cast<long>(inputBase64.length()));
-    return false;
-  }
-  outputBufferOut->resize(outputLength);
-  return true;
-}
-
 bool loadKDeviceBytes(std::vector<uint8_t>* keyBytesOut);
+void onMqttMessageReceived(char* topicName, byte* payloadBuffer, unsigned int payloadLength);
 bool createCurrentUtcIso8601Text(String* utcIso8601Out);
 bool publishTrhNotice(const String& destinationId,
                       const String& requestId,
@@ -384,7 +408,7 @@ bool verifyFileSyncCommandSignature(const String& normalizedSubName, const Strin
   }
 
   std::vector<uint8_t> expectedMacBytes;
-  if (!decodeBase64Text(signatureBase64, &expectedMacBytes)) {
+  if (!base64Codec::decodeToBytes(signatureBase64, &expectedMacBytes)) {
     appLogError("verifyFileSyncCommandSignature failed. signature base64 decode error. sub=%s", normalizedSubName.c_str());
     return false;
   }
@@ -416,40 +440,6 @@ bool verifyFileSyncCommandSignature(const String& normalizedSubName, const Strin
   return true;
 }
 
-/**
- * @brief バイト列をBase64文字列へ変換する。
- * @param inputBuffer 入力バッファ。
- * @param outputBase64Out 出力先。
- * @return 成功時true。
- */
-bool encodeBase64Text(const std::vector<uint8_t>& inputBuffer, String* outputBase64Out) {
-  if (outputBase64Out == nullptr) {
-    appLogError("encodeBase64Text failed. outputBase64Out is null.");
-    return false;
-  }
-  size_t requiredLength = 0;
-  int32_t probeResult = mbedtls_base64_encode(nullptr, 0, &requiredLength, inputBuffer.data(), inputBuffer.size());
-  if (probeResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && probeResult != 0) {
-    appLogError("encodeBase64Text failed. probe result=%ld inputLength=%ld",
-                static_cast<long>(probeResult),
-                static_cast<long>(inputBuffer.size()));
-    return false;
-  }
-  std::vector<uint8_t> encodedBuffer(requiredLength + 1, 0);
-  size_t writtenLength = 0;
-  int32_t encodeResult = mbedtls_base64_encode(encodedBuffer.data(),
-                                               encodedBuffer.size(),
-                                               &writtenLength,
-                                               inputBuffer.data(),
-                                               inputBuffer.size());
-  if (encodeResult != 0) {
-    appLogError("encodeBase64Text failed. encode result=%ld inputLength=%ld", static_cast<long>(encodeResult), static_cast<long>(inputBuffer.size()));
-    return false;
-  }
-  *outputBase64Out = String(reinterpret_cast<const char*>(encodedBuffer.data()), writtenLength);
-  return true;
-}
-
 /**
  * @brief 保存済みk-deviceを読込み、暗号化鍵(32byte)へ変換する。
  * @param keyBytesOut 出力先。
@@ -468,7 +458,7 @@ bool loadKDeviceBytes(std::vector<uint8_t>* keyBytesOut) {
     appLogError("loadKDeviceBytes failed. loadKeyDevice returned false.");
     return false;
   }
-  if (!decodeBase64Text(keyDeviceBase64, keyBytesOut)) {
+  if (!base64Codec::decodeToBytes(keyDeviceBase64, keyBytesOut)) {
     appLogError("loadKDeviceBytes failed. invalid base64.");
     return false;
   }
@@ -850,15 +840,184 @@ bool configureMqttTransportClient(bool tlsEnabled) {
     }
     mqttTlsNetworkClient.setCACert(mqttTlsCaCertRuntime.c_str());
     mqttTlsNetworkClient.setTlsValidationContext(mqttHost, mqttTlsCaCertRuntime.c_str());
-    mqttClient.setClient(mqttTlsNetworkClient);
+    mqttActiveNetworkClient = &mqttTlsNetworkClient;
     appLogInfo("configureMqttTransportClient: TLS transport selected. tlsHost=%s", mqttHost);
     return true;
   }
-  mqttClient.setClient(mqttNetworkClient);
+  mqttActiveNetworkClient = &mqttNetworkClient;
   appLogInfo("configureMqttTransportClient: plain TCP transport selected.");
   return true;
 }
 
+/**
+ * @brief 受信 PUBLISH を受信待ち行列へ複製する（mqttClient.poll 内から呼ばれる）。
+ */
+void queueMqttReceivedMessage(void* context, const mqttAsync::mqttIncomingMessage& message) {
+  (void)context;
+  if (message.topicLength == 0 || message.topicLength >= mqttMaxTopicLength) {
+    appLogError("queueMqttReceivedMessage failed. invalid topic length=%u", static_cast<unsigned>(message.topicLength));
+    return;
+  }
+  if (mqttReceivedQueueCount >= mqttReceivedQueueDepth) {
+    appLogError("queueMqttReceivedMessage failed. queue full. drop. topicLength=%u payloadLength=%u",
+                static_cast<unsigned>(message.topicLength),
+                static_cast<unsigned>(message.payloadLength));
+    return;
+  }
+  mqttReceivedMessage& slot = mqttReceivedQueue[(mqttReceivedQueueHead + mqttReceivedQueueCount) % mqttReceivedQueueDepth];
+  slot.topic = "";
+  slot.topic.reserve(message.topicLength + 1);
+  for (size_t index = 0; index < message.topicLength; ++index) {
+    slot.topic += message.topic[index];
+  }
+  slot.payload = "";
+  slot.payload.reserve(message.payloadLength + 1);
+  for (size_t index = 0; index < message.payloadLength; ++index) {
+    slot.payload += static_cast<char>(message.payload[index]);
+  }
+  ++mqttReceivedQueueCount;
+}
+
+/**
+ * @brief mqttClient を1回進め、受信待ち行列を onMqttMessageReceived へ配送する。
+ * @return セッション継続時true。
+ * @details
+ * - [重要] 切断・タイムアウト時は下位クライアントも閉じる。QoS1 送信窓は次の openMqttSession 後に再送される。
+ * - [重要] onMqttMessageReceived 内の publish から呼ばれた場合は poll だけ行い、配送は外側へ任せる。
+ */
+bool pollMqttClient() {
+  if (mqttClient.state() == mqttAsync::mqttClientState::kDisconnected) {
+    return false;
+  }
+  const bool pollResult = mqttClient.poll(millis());
+  if (!pollResult) {
+    appLogWarn("pollMqttClient: session ended. inflight=%u", static_cast<unsigned>(mqttClient.inflightCount()));
+    mqttActiveNetworkClient->stop();
+  }
+  if (isMqttDispatching) {
+    return pollResult;
+  }
+  isMqttDispatching = true;
+  char topicBuffer[mqttMaxTopicLength];
+  while (mqttReceivedQueueCount > 0) {
+    mqttReceivedMessage& message = mqttReceivedQueue[mqttReceivedQueueHead];
+    strncpy(topicBuffer, message.topic.c_str(), sizeof(topicBuffer) - 1);
+    topicBuffer[sizeof(topicBuffer) - 1] = '\0';
+    const String payloadText = message.payload;
+    mqttReceivedQueueHead = (mqttReceivedQueueHead + 1) % mqttReceivedQueueDepth;
+    --mqttReceivedQueueCount;
+    onMqttMessageReceived(topicBuffer,
+                          reinterpret_cast<byte*>(const_cast<char*>(payloadText.c_str())),
+                          payloadText.length());
+  }
+  isMqttDispatching = false;
+  return mqttClient.isConnected();
+}
+
+/**
+ * @brief 文字列 payload を publish する（送信キューへ積む）。
+ * @param topicText トピック。
+ * @param payloadText payload。
+ * @param retained retain フラグ。
+ * @param qos QoS。
+ * @return 積めた場合true。
+ * @details
+ * - [重要] 送信キュー/送信窓が空くまで pollMqttClient で書き出しながら最大 mqttPublishQueueWaitMs 待つ。
+ */
+bool publishMqttText(const char* topicText, const String& payloadText, bool retained, mqttAsync::mqttQos qos) {
+  const uint32_t startedAtMs = millis();
+  for (;;) {
+    const mqttAsync::mqttEnqueueResult enqueueResult =
+        mqttClient.publish(topicText,
+                           reinterpret_cast<const uint8_t*>(payloadText.c_str()),
+                           payloadText.length(),
+                           qos,
+                           retained,
+                           nullptr);
+    if (enqueueResult == mqttAsync::mqttEnqueueResult::kQueued) {
+      return true;
+    }
+    const bool isRetryable = (enqueueResult == mqttAsync::mqttEnqueueResult::kQueueFull ||
+                              enqueueResult == mqttAsync::mqttEnqueueResult::kWindowFull);
+    if (!isRetryable || static_cast<uint32_t>(millis() - startedAtMs) >= mqttPublishQueueWaitMs || !pollMqttClient()) {
+      appLogError("publishMqttText failed. result=%u topic=%s bytes=%u queueUsed=%u inflight=%u",
+                  static_cast<unsigned>(enqueueResult),
+                  topicText,
+                  static_cast<unsigned>(payloadText.length()),
+                  static_cast<unsigned>(mqttClient.sendQueueUsedBytes()),
+                  static_cast<unsigned>(mqttClient.inflightCount()));
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+}
+
+/**
+ * @brief QoS1 送信窓が空く（全 PUBACK 受信）まで待つ。
+ * @param timeoutMs 上限(ms)。
+ * @return 空いた場合true。
+ */
+bool waitMqttInflightDrained(uint32_t timeoutMs) {
+  const uint32_t startedAtMs = millis();
+  while (mqttClient.inflightCount() > 0) {
+    if (static_cast<uint32_t>(millis() - startedAtMs) >= timeoutMs || !pollMqttClient()) {
+      appLogWarn("waitMqttInflightDrained timeout. inflight=%u waitedMs=%lu",
+                 static_cast<unsigned>(mqttClient.inflightCount()),
+                 static_cast<unsigned long>(millis() - startedAtMs));
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  return true;
+}
+
+/**
+ * @brief 下位クライアントで TCP/TLS 接続し、MQTT セッション（CONNECT→CONNACK）を開始する。
+ * @return CONNACK(0) を受けた場合true。
+ */
+bool openMqttSession(const char* clientId, const char* willTopic, const char* willPayload) {
+  mqttClient.endSession();
+  mqttActiveNetworkClient->stop();
+  const int connectResult = mqttResolvedBrokerIpValid
+                                ? mqttActiveNetworkClient->connect(mqttResolvedBrokerIpAddress, static_cast<uint16_t>(mqttPort))
+                                : mqttActiveNetworkClient->connect(mqttHost, static_cast<uint16_t>(mqttPort));
+  if (connectResult != 1) {
+    appLogWarn("openMqttSession failed. transport connect failed. host=%s port=%ld tls=%d",
+               mqttHost,
+               static_cast<long>(mqttPort),
+               static_cast<int>(mqttTls));
+    return false;
+  }
+  mqttAsync::mqttConnectOptions connectOptions = {};
+  connectOptions.clientId = clientId;
+  connectOptions.userName = mqttUser;
+  connectOptions.password = mqttPass;
+  // クリーンセッション: 送信窓に残った QoS1 publish は CONNACK 後に新規 PUBLISH（DUP=0）として送り直される。
+  connectOptions.cleanSession = true;
+  connectOptions.willTopic = willTopic;
+  connectOptions.willPayload = willPayload;
+  connectOptions.willQos = mqttAsync::mqttQos::kAtLeastOnce;
+  connectOptions.willRetain = true;
+  if (!mqttClient.beginSession(mqttAsync::makeArduinoClientTransport(mqttActiveNetworkClient), connectOptions, millis())) {
+    appLogWarn("openMqttSession failed. beginSession returned false.");
+    mqttActiveNetworkClient->stop();
+    return false;
+  }
+  while (mqttClient.state() == mqttAsync::mqttClientState::kAwaitingConnack) {
+    if (!mqttClient.poll(millis())) {
+      break;
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  if (!mqttClient.isConnected()) {
+    appLogWarn("openMqttSession failed. connack=%u", static_cast<unsigned>(mqttClient.lastConnackReturnCode()));
+    mqttClient.endSession();
+    mqttActiveNetworkClient->stop();
+    return false;
+  }
+  return true;
+}
+
 /**
  * @brief デバイス名（トピックの末尾識別子）を解決する。
  * @param deviceNameTextOut 出力先（null不可）。
@@ -956,6 +1115,8 @@ struct fileSyncSessionState {
 };
 
 fileSyncSessionState currentFileSyncSession;
+/** @brief currentFileSyncSession.active の写し（他タスクから isFileSyncSessionActive で参照）。@type std::atomic<bool> */
+std::atomic<bool> isFileSyncSessionActiveShared{false};
 
 struct imagePackageApplyRequest {
   String sessionId;
@@ -963,6 +1124,8 @@ struct imagePackageApplyRequest {
   String packageSha256;
   String destinationDir;
   bool overwrite = false;
+  /** @brief packageUrl より優先して試すミラー URL（優先順）。@type std::vector<String> */
+  std::vector<String> mirrorUrls;
 };
 
 struct imagePackageDownloadResult {
@@ -987,7 +1150,7 @@ bool publishFileSyncStatusNotice(const String& destinationId,
                                  const char* result,
                                  const char* detail,
                                  const char* errorCode) {
-  if (!mqttClient.connected()) {
+  if (!mqttClient.isConnected()) {
     appLogWarn("publishFileSyncStatusNotice skipped. mqtt is not connected.");
     return false;
   }
@@ -1002,23 +1165,17 @@ bool publishFileSyncStatusNotice(const String& destinationId,
   }
   const String messageId = String(deviceNodeName) + "-" + millis();
   String payloadText;
-  jsonService payloadJsonService;
-  jsonKeyValueItem itemList[] = {
-      {"v", jsonValueType::kString, iotCommon::kProtocolVersion, 0, 0, false},
-      {"DstID", jsonValueType::kString, destinationId.length() > 0 ? destinationId.c_str() : "all", 0, 0, false},
-      {"SrcID", jsonValueType::kString, deviceNodeName.c_str(), 0, 0, false},
-      {"Request", jsonValueType::kString, "Notice", 0, 0, false},
-      {"id", jsonValueType::kString, messageId.c_str(), 0, 0, false},
-      {"sub", jsonValueType::kString, "fileSyncStatus", 0, 0, false},
-      {"sessionId", jsonValueType::kString, sessionId.c_str(), 0, 0, false},
-      {"targetArea", jsonValueType::kString, targetArea.c_str(), 0, 0, false},
-      {"phase", jsonValueType::kString, phase == nullptr ? "" : phase, 0, 0, false},
-      {"result", jsonValueType::kString, result == nullptr ? "" : result, 0, 0, false},
-      {"detail", jsonValueType::kString, detail == nullptr ? "" : detail, 0, 0, false},
-      {"errorCode", jsonValueType::kString, errorCode == nullptr ? "" : errorCode, 0, 0, false},
-  };
-  if (!payloadJsonService.setValuesByPath(&payloadText, itemList, sizeof(itemList) / sizeof(itemList[0]))) {
-    appLogError("publishFileSyncStatusNotice failed. setValuesByPath returned false.");
+  if (!mqtt::buildFileSyncStatusPayload(deviceNodeName.c_str(),
+                                        destinationId.c_str(),
+                                        messageId.c_str(),
+                                        sessionId.c_str(),
+                                        targetArea.c_str(),
+                                        phase,
+                                        result,
+                                        detail,
+                                        errorCode,
+                                        &payloadText)) {
+    appLogError("publishFileSyncStatusNotice failed. buildFileSyncStatusPayload returned false.");
     return false;
   }
   String outgoingPayloadText;
@@ -1026,12 +1183,12 @@ bool publishFileSyncStatusNotice(const String& destinationId,
     appLogError("publishFileSyncStatusNotice failed. resolveOutgoingPayloadText returned false.");
     return false;
   }
-  const bool publishResult = mqttClient.publish(topicText.c_str(), outgoingPayloadText.c_str(), false);
+  const bool publishResult = publishMqttText(topicText.c_str(), outgoingPayloadText, false, mqttAsync::mqttQos::kAtLeastOnce);
   if (!publishResult) {
     appLogError("publishFileSyncStatusNotice failed. publish returned false. topic=%s", topicText.c_str());
     return false;
   }
-  mqttClient.loop();
+  pollMqttClient();
   return true;
 }
 
@@ -1053,7 +1210,7 @@ bool publishImagePackageStatusNotice(const String& destinationId,
                                      const char* result,
                                      const char* detail,
                                      const char* errorCode) {
-  if (!mqttClient.connected()) {
+  if (!mqttClient.isConnected()) {
     appLogWarn("publishImagePackageStatusNotice skipped. mqtt is not connected.");
     return false;
   }
@@ -1092,12 +1249,12 @@ bool publishImagePackageStatusNotice(const String& destinationId,
     appLogError("publishImagePackageStatusNotice failed. resolveOutgoingPayloadText returned false.");
     return false;
   }
-  const bool publishResult = mqttClient.publish(topicText.c_str(), outgoingPayloadText.c_str(), false);
+  const bool publishResult = publishMqttText(topicText.c_str(), outgoingPayloadText, false, mqttAsync::mqttQos::kAtLeastOnce);
   if (!publishResult) {
     appLogError("publishImagePackageStatusNotice failed. publish returned false. topic=%s", topicText.c_str());
     return false;
   }
-  mqttClient.loop();
+  pollMqttClient();
   return true;
 }
 
@@ -1333,6 +1490,16 @@ bool parseImagePackageApplyRequest(const String& payloadText, imagePackageApplyR
   request.packageSha256 = cJSON_IsString(packageSha256Item) ? String(packageSha256Item->valuestring) : String("");
   request.destinationDir = cJSON_IsString(destinationDirItem) ? String(destinationDirItem->valuestring) : String("");
   request.overwrite = cJSON_IsBool(overwriteItem) ? cJSON_IsTrue(overwriteItem) : false;
+  cJSON* mirrorUrlsItem = cJSON_GetObjectItemCaseSensitive(argsObject, "mirrorUrls");
+  const cJSON* mirrorUrlItem = nullptr;
+  cJSON_ArrayForEach(mirrorUrlItem, mirrorUrlsItem) {
+    if (request.mirrorUrls.size() + 1 >= kMirrorDownloadMaxSources) {
+      break;
+    }
+    if (cJSON_IsString(mirrorUrlItem) && strlen(mirrorUrlItem->valuestring) > 0) {
+      request.mirrorUrls.push_back(String(mirrorUrlItem->valuestring));
+    }
+  }
   cJSON_Delete(rootObject);
 
   if (request.sessionId.length() == 0 ||
@@ -1350,11 +1517,62 @@ bool parseImagePackageApplyRequest(const String& payloadText, imagePackageApplyR
   return true;
 }
 
+/**
+ * @brief imagePackageApply の取得で使うホスト名解決。
+ * @details
+ * - [重要] MQTT ブローカーと同じホストだけ、DNS 不達時に SENSITIVE_WIFI_DNS_PRIMARY の IP へ退避する（従来どおり）。
+ */
+bool resolveImagePackageHost(const char* host, IPAddress* ipOut) {
+  if (host == nullptr || ipOut == nullptr) {
+    appLogError("resolveImagePackageHost failed. host=%p ipOut=%p", host, ipOut);
+    return false;
+  }
+  if (WiFi.hostByName(host, *ipOut) == 1) {
+    return true;
+  }
+  const IPAddress dnsPrimaryFallbackIp(
+      SENSITIVE_WIFI_DNS_PRIMARY_OCTET1,
+      SENSITIVE_WIFI_DNS_PRIMARY_OCTET2,
+      SENSITIVE_WIFI_DNS_PRIMARY_OCTET3,
+      SENSITIVE_WIFI_DNS_PRIMARY_OCTET4);
+  if (mqttHost != nullptr && String(host).equalsIgnoreCase(String(mqttHost)) &&
+      dnsPrimaryFallbackIp != IPAddress(0, 0, 0, 0)) {
+    appLogWarn("resolveImagePackageHost: fallback to configured IP. host=%s fallbackIp=%s",
+               host,
+               dnsPrimaryFallbackIp.toString().c_str());
+    *ipOut = dnsPrimaryFallbackIp;
+    return true;
+  }
+  appLogError("resolveImagePackageHost failed. host=%s", host);
+  return false;
+}
+
+/**
+ * @brief imagePackageApply の受信データを一時 ZIP へ書き込む。
+ * @return 継続する場合true。
+ */
+bool writeImagePackageZipData(void* sinkContext, const uint8_t* data, size_t length, uint32_t offset, uint32_t totalBytes) {
+  File* zipFile = static_cast<File*>(sinkContext);
+  const size_t writtenSize = zipFile->write(data, length);
+  if (writtenSize != length) {
+    appLogError("writeImagePackageZipData failed. file write mismatch. offset=%lu expected=%lu actual=%lu total=%lu",
+                static_cast<unsigned long>(offset),
+                static_cast<unsigned long>(length),
+                static_cast<unsigned long>(writtenSize),
+                static_cast<unsigned long>(totalBytes));
+    return false;
+  }
+  return true;
+}
+
 /**
  * @brief HTTPSでZIPを取得しLittleFSへ保存しながらSHA-256を検証する。
  * @param request imagePackageApply要求。
  * @param tempZipPathOut 保存した一時ZIPパス出力先。
  * @return 成功時true。
+ * @details
+ * - [重要] mirrorUrls（優先順）→ packageUrl を候補とし、先頭プローブで最速の URL から取得する（mirrorDownload.h）。
+ * - [厳守] 候補はすべて https とする（リダイレクト先も含む）。
  */
 bool downloadImagePackageZip(const imagePackageApplyRequest& request,
                              String* tempZipPathOut,
@@ -1374,10 +1592,16 @@ bool downloadImagePackageZip(const imagePackageApplyRequest& request,
     setImagePackageDownloadFailure(downloadResultOut, "IPKG_FILESYSTEM_NOT_READY", "LittleFS is not ready");
     return false;
   }
-  if (!request.packageUrl.startsWith("https://")) {
-    appLogError("downloadImagePackageZip failed. HTTPS is required. packageUrl=%s", request.packageUrl.c_str());
-    setImagePackageDownloadFailure(downloadResultOut, "IPKG_HTTPS_REQUIRED", "packageUrl must start with https://");
-    return false;
+  std::vector<String> sourceUrls = request.mirrorUrls;
+  sourceUrls.push_back(request.packageUrl);
+  for (const String& sourceUrl : sourceUrls) {
+    if (!sourceUrl.startsWith("https://")) {
+      appLogError("downloadImagePackageZip failed. HTTPS is required. url=%s", sourceUrl.c_str());
+      setImagePackageDownloadFailure(downloadResultOut,
+                                     "IPKG_HTTPS_REQUIRED",
+                                     String("packageUrl and mirrorUrls must start with https://. url=") + sourceUrl);
+      return false;
+    }
   }
 
   if (!ensureMqttSensitiveDataReady()) {
@@ -1417,192 +1641,75 @@ bool downloadImagePackageZip(const imagePackageApplyRequest& request,
 
   String tempZipPath = String("/images/.tmp/imagePackage-") + request.sessionId + ".zip.tmp";
   LittleFS.remove(tempZipPath);
-
-  MqttTlsClient secureClient;
-  secureClient.setCACert(tlsCaCertificate.c_str());
-  {
-    String urlWithoutScheme = request.packageUrl.substring(strlen("https://"));
-    int32_t slashIndex = urlWithoutScheme.indexOf('/');
-    String authorityPart = slashIndex >= 0 ? urlWithoutScheme.substring(0, slashIndex) : urlWithoutScheme;
-    int32_t colonIndex = authorityPart.indexOf(':');
-    String requestHost = colonIndex >= 0 ? authorityPart.substring(0, colonIndex) : authorityPart;
-    requestHost.trim();
-    secureClient.setTlsValidationContext(requestHost.c_str(), tlsCaCertificate.c_str());
-    IPAddress dnsPrimaryFallbackIp(
-        SENSITIVE_WIFI_DNS_PRIMARY_OCTET1,
-        SENSITIVE_WIFI_DNS_PRIMARY_OCTET2,
-        SENSITIVE_WIFI_DNS_PRIMARY_OCTET3,
-        SENSITIVE_WIFI_DNS_PRIMARY_OCTET4);
-    if (mqttHost != nullptr &&
-        requestHost.equalsIgnoreCase(String(mqttHost)) &&
-        dnsPrimaryFallbackIp != IPAddress(0, 0, 0, 0)) {
-      secureClient.setFallbackEndpointIp(dnsPrimaryFallbackIp);
-      appLogInfo("downloadImagePackageZip: host fallback IP enabled. host=%s fallbackIp=%s",
-                 requestHost.c_str(),
-                 dnsPrimaryFallbackIp.toString().c_str());
-    }
-  }
-
-  HTTPClient httpClient;
-  if (!httpClient.begin(secureClient, request.packageUrl)) {
-    appLogError("downloadImagePackageZip failed. HTTPClient::begin returned false. url=%s", request.packageUrl.c_str());
-    setImagePackageDownloadFailure(downloadResultOut,
-                                   "IPKG_HTTP_BEGIN_FAILED",
-                                   String("HTTPClient::begin failed. url=") + request.packageUrl);
-    return false;
-  }
-  httpClient.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-  const int32_t statusCode = httpClient.GET();
-  if (statusCode != HTTP_CODE_OK) {
-    const String statusReason = HTTPClient::errorToString(statusCode);
-    appLogError("downloadImagePackageZip failed. HTTP status is not 200. status=%ld url=%s",
-                static_cast<long>(statusCode),
-                request.packageUrl.c_str());
-    if (statusCode < 0) {
-      setImagePackageDownloadFailure(downloadResultOut,
-                                     "IPKG_HTTP_CONNECT_FAILED",
-                                     String("HTTP GET failed. status=") + String(statusCode) +
-                                         " reason=" + statusReason +
-                                         " url=" + request.packageUrl);
-    } else {
-      setImagePackageDownloadFailure(downloadResultOut,
-                                     "IPKG_HTTP_STATUS_NOT_OK",
-                                     String("HTTP status is not 200. status=") + String(statusCode) +
-                                         " url=" + request.packageUrl);
-    }
-    httpClient.end();
-    return false;
-  }
-
   File zipFile = LittleFS.open(tempZipPath, "w");
   if (!zipFile) {
     appLogError("downloadImagePackageZip failed. open temp zip file failed. path=%s", tempZipPath.c_str());
     setImagePackageDownloadFailure(downloadResultOut,
                                    "IPKG_TEMP_FILE_OPEN_FAILED",
                                    String("open temp zip file failed. path=") + tempZipPath);
-    httpClient.end();
     return false;
   }
 
-  mbedtls_sha256_context shaContext;
-  mbedtls_sha256_init(&shaContext);
-  mbedtls_sha256_starts_ret(&shaContext, 0);
-
-  WiFiClient* stream = httpClient.getStreamPtr();
-  int32_t remainedLength = httpClient.getSize();
-  const uint32_t downloadStartMs = millis();
-  uint32_t lastDataReceivedMs = downloadStartMs;
-  constexpr uint32_t imagePackageDownloadIdleTimeoutMs = 15000;
-  constexpr uint32_t imagePackageDownloadTotalTimeoutMs = 120000;
-  size_t totalDownloadedSize = 0;
-  // [重要] スタック使用量を抑えるため、I/Oバッファは静的領域を使う。
-  static uint8_t downloadBuffer[512];
-  while (true) {
-    const uint32_t elapsedTotalMs = millis() - downloadStartMs;
-    if (elapsedTotalMs > imagePackageDownloadTotalTimeoutMs) {
-      appLogError("downloadImagePackageZip failed. total timeout exceeded. elapsedMs=%lu totalDownloaded=%lu remainedLength=%ld",
-                  static_cast<unsigned long>(elapsedTotalMs),
-                  static_cast<unsigned long>(totalDownloadedSize),
-                  static_cast<long>(remainedLength));
-      zipFile.close();
-      httpClient.end();
-      mbedtls_sha256_free(&shaContext);
-      LittleFS.remove(tempZipPath);
-      setImagePackageDownloadFailure(downloadResultOut,
-                                     "IPKG_DOWNLOAD_TOTAL_TIMEOUT",
-                                     String("total timeout exceeded. elapsedMs=") + String(elapsedTotalMs) +
-                                         " totalDownloaded=" + String(totalDownloadedSize));
-      return false;
-    }
-
-    size_t availableSize = stream->available();
-    if (availableSize == 0) {
-      const uint32_t idleMs = millis() - lastDataReceivedMs;
-      if (!httpClient.connected()) {
-        break;
-      }
-      if (remainedLength == 0) {
-        break;
-      }
-      if (idleMs > imagePackageDownloadIdleTimeoutMs) {
-        appLogError("downloadImagePackageZip failed. idle timeout exceeded. idleMs=%lu totalDownloaded=%lu remainedLength=%ld",
-                    static_cast<unsigned long>(idleMs),
-                    static_cast<unsigned long>(totalDownloadedSize),
-                    static_cast<long>(remainedLength));
-        zipFile.close();
-        httpClient.end();
-        mbedtls_sha256_free(&shaContext);
-        LittleFS.remove(tempZipPath);
-        setImagePackageDownloadFailure(downloadResultOut,
-                                       "IPKG_DOWNLOAD_IDLE_TIMEOUT",
-                                       String("idle timeout exceeded. idleMs=") + String(idleMs) +
-                                           " totalDownloaded=" + String(totalDownloadedSize));
-        return false;
-      }
-      delay(10);
-      continue;
-    }
-    if (availableSize > sizeof(downloadBuffer)) {
-      availableSize = sizeof(downloadBuffer);
-    }
-    int32_t readSize = stream->readBytes(downloadBuffer, availableSize);
-    if (readSize <= 0) {
-      break;
-    }
-    size_t writtenSize = zipFile.write(downloadBuffer, static_cast<size_t>(readSize));
-    if (writtenSize != static_cast<size_t>(readSize)) {
-      appLogError("downloadImagePackageZip failed. file write mismatch. path=%s expected=%ld actual=%ld",
-                  tempZipPath.c_str(),
-                  static_cast<long>(readSize),
-                  static_cast<long>(writtenSize));
-      zipFile.close();
-      httpClient.end();
-      mbedtls_sha256_free(&shaContext);
-      LittleFS.remove(tempZipPath);
-      setImagePackageDownloadFailure(downloadResultOut,
-                                     "IPKG_TEMP_FILE_WRITE_FAILED",
-                                     String("temp zip write mismatch. path=") + tempZipPath +
-                                         " expected=" + String(readSize) +
-                                         " actual=" + String(writtenSize));
-      return false;
+  mirrorDownloadOptions downloadOptions = mirrorDownload::getDefaultOptions();
+  downloadOptions.isHttpsRequired = true;
+  downloadOptions.tlsCaCertificate = tlsCaCertificate.c_str();
+  downloadOptions.resolveHost = resolveImagePackageHost;
+  downloadOptions.idleTimeoutMs = 15000;
+  downloadOptions.totalTimeoutMs = 120000;
+  downloadOptions.userAgent = "esp32lab-imagePackage/1.0";
+  mirrorDownloadResult downloadResult;
+  const String expectedSha256 = normalizeSha256Hex(request.packageSha256);
+  const bool downloadResultOk = mirrorDownload::run(sourceUrls.data(),
+                                                    sourceUrls.size(),
+                                                    downloadOptions,
+                                                    expectedSha256.c_str(),
+                                                    writeImagePackageZipData,
+                                                    &zipFile,
+                                                    &downloadResult);
+  zipFile.close();
+  if (!downloadResultOk) {
+    LittleFS.remove(tempZipPath);
+    const String resultDetail = String(downloadResult.detail) + " downloaded=" + String(downloadResult.downloadedBytes) +
+                                " total=" + String(downloadResult.totalBytes) +
+                                " switches=" + String(downloadResult.switchCount);
+    bool hasIdleTimeout = false;
+    bool hasHttpStatusError = false;
+    for (uint8_t sourceIndex = 0; sourceIndex < downloadResult.sourceCount; ++sourceIndex) {
+      hasIdleTimeout = hasIdleTimeout || strcmp(downloadResult.sources[sourceIndex].detail, "idle timeout") == 0;
+      hasHttpStatusError = hasHttpStatusError || strcmp(downloadResult.sources[sourceIndex].detail, "http status not ok") == 0;
     }
-    mbedtls_sha256_update_ret(&shaContext, downloadBuffer, static_cast<size_t>(readSize));
-    totalDownloadedSize += static_cast<size_t>(readSize);
-    lastDataReceivedMs = millis();
-    if (remainedLength > 0) {
-      remainedLength -= readSize;
-      if (remainedLength <= 0) {
-        break;
-      }
+    const char* errorCode = "IPKG_DOWNLOAD_OR_HASH_FAILED";
+    if (strlen(downloadResult.sha256Hex) > 0) {
+      errorCode = "IPKG_SHA256_MISMATCH";
+    } else if (strcmp(downloadResult.detail, "sink rejected data") == 0) {
+      errorCode = "IPKG_TEMP_FILE_WRITE_FAILED";
+    } else if (strcmp(downloadResult.detail, "total timeout") == 0) {
+      errorCode = "IPKG_DOWNLOAD_TOTAL_TIMEOUT";
+    } else if (hasIdleTimeout) {
+      errorCode = "IPKG_DOWNLOAD_IDLE_TIMEOUT";
+    } else if (downloadResult.downloadedBytes == 0) {
+      errorCode = hasHttpStatusError ? "IPKG_HTTP_STATUS_NOT_OK" : "IPKG_HTTP_CONNECT_FAILED";
     }
-  }
-
-  unsigned char hashBytes[32] = {0};
-  mbedtls_sha256_finish_ret(&shaContext, hashBytes);
-  mbedtls_sha256_free(&shaContext);
-  zipFile.close();
-  httpClient.end();
-
-  char hashText[65] = {0};
-  for (size_t index = 0; index < 32; ++index) {
-    snprintf(&hashText[index * 2], 3, "%02x", hashBytes[index]);
-  }
-  hashText[64] = '\0';
-  const String actualSha256 = normalizeSha256Hex(String(hashText));
-  const String expectedSha256 = normalizeSha256Hex(request.packageSha256);
-  if (!actualSha256.equals(expectedSha256)) {
-    appLogError("downloadImagePackageZip failed. sha256 mismatch. expected=%s actual=%s path=%s",
+    appLogError("downloadImagePackageZip failed. errorCode=%s detail=%s expected=%s actual=%s path=%s",
+                errorCode,
+                resultDetail.c_str(),
                 expectedSha256.c_str(),
-                actualSha256.c_str(),
+                downloadResult.sha256Hex,
                 tempZipPath.c_str());
-    LittleFS.remove(tempZipPath);
     setImagePackageDownloadFailure(downloadResultOut,
-                                   "IPKG_SHA256_MISMATCH",
-                                   String("sha256 mismatch. expected=") + expectedSha256 +
-                                       " actual=" + actualSha256);
+                                   errorCode,
+                                   strlen(downloadResult.sha256Hex) > 0
+                                       ? String("sha256 mismatch. expected=") + expectedSha256 + " actual=" + downloadResult.sha256Hex
+                                       : resultDetail);
     return false;
   }
 
+  appLogInfo("downloadImagePackageZip: downloaded. url=%s bytes=%lu sources=%u switches=%u elapsedMs=%lu",
+             downloadResult.sources[downloadResult.finalSourceIndex].url.c_str(),
+             static_cast<unsigned long>(downloadResult.totalBytes),
+             static_cast<unsigned>(downloadResult.sourceCount),
+             static_cast<unsigned>(downloadResult.switchCount),
+             static_cast<unsigned long>(downloadResult.elapsedMs));
   *tempZipPathOut = tempZipPath;
   if (downloadResultOut != nullptr) {
     downloadResultOut->success = true;
@@ -2213,6 +2320,7 @@ bool handleFileSyncPlanCommand(const String& payloadText, const String& destinat
   }
 
   currentFileSyncSession.active = true;
+  isFileSyncSessionActiveShared.store(true, std::memory_order_release);
   currentFileSyncSession.sessionId = sessionId;
   currentFileSyncSession.targetArea = targetArea;
   currentFileSyncSession.deleteMode = deleteMode;
@@ -2296,15 +2404,20 @@ bool handleFileSyncChunkCommand(const String& payloadText, const String& destina
     return true;
   }
 
-  String dataBase64 = cJSON_IsString(cJSON_GetObjectItemCaseSensitive(argsObject, "dataBase64"))
-                          ? String(cJSON_GetObjectItemCaseSensitive(argsObject, "dataBase64")->valuestring)
-                          : String("");
+  cJSON* dataBase64Item = cJSON_GetObjectItemCaseSensitive(argsObject, "dataBase64");
   int32_t chunkIndex = cJSON_IsNumber(cJSON_GetObjectItemCaseSensitive(argsObject, "chunkIndex"))
                            ? static_cast<int32_t>(cJSON_GetObjectItemCaseSensitive(argsObject, "chunkIndex")->valuedouble)
                            : 0;
-  std::vector<uint8_t> chunkBytes;
-  if (!decodeBase64Text(dataBase64, &chunkBytes)) {
-    appLogError("handleFileSyncChunkCommand failed. decodeBase64Text error. path=%s chunkIndex=%ld",
+  // [重要] チャンクは解析済みJSONの文字列領域へ上書きで復号し、String / vector への複製を作らない（rootObject 解放まで有効）。
+  const uint8_t* chunkBytes = nullptr;
+  size_t chunkSize = 0;
+  bool isChunkDecoded = true;
+  if (cJSON_IsString(dataBase64Item) && dataBase64Item->valuestring != nullptr) {
+    isChunkDecoded = base64Codec::decodeInPlace(dataBase64Item->valuestring, strlen(dataBase64Item->valuestring), &chunkSize);
+    chunkBytes = reinterpret_cast<const uint8_t*>(dataBase64Item->valuestring);
+  }
+  if (!isChunkDecoded) {
+    appLogError("handleFileSyncChunkCommand failed. base64Codec::decodeInPlace error. path=%s chunkIndex=%ld",
                 normalizedPath.c_str(),
                 static_cast<long>(chunkIndex));
     cJSON_Delete(rootObject);
@@ -2348,12 +2461,12 @@ bool handleFileSyncChunkCommand(const String& payloadText, const String& destina
                                 "FSYNC_IO_ERROR");
     return true;
   }
-  size_t writtenSize = tempFile.write(chunkBytes.data(), chunkBytes.size());
+  size_t writtenSize = (chunkSize > 0) ? tempFile.write(chunkBytes, chunkSize) : 0;
   tempFile.close();
-  if (writtenSize != chunkBytes.size()) {
+  if (writtenSize != chunkSize) {
     appLogError("handleFileSyncChunkCommand failed. write size mismatch. path=%s expected=%u actual=%u",
                 tempPath.c_str(),
-                static_cast<unsigned>(chunkBytes.size()),
+                static_cast<unsigned>(chunkSize),
                 static_cast<unsigned>(writtenSize));
     publishFileSyncStatusNotice(destinationId,
                                 currentFileSyncSession.sessionId,
@@ -2514,64 +2627,1009 @@ bool handleFileSyncCommitCommand(const String& payloadText, const String& destin
                               commitResult ? "commit completed" : "commit failed",
                               errorCodeText.c_str());
   currentFileSyncSession = fileSyncSessionState{};
+  isFileSyncSessionActiveShared.store(false, std::memory_order_release);
   cJSON_Delete(rootObject);
   return true;
 }
 
 /**
- * @brief set/get系の受信を暫定処理する。
- * @param commandName コマンド名（set/get）。
+ * @brief 出力ポート操作の set サブコマンドか判定する。
  * @param normalizedSubName 正規化済みサブコマンド。
- * @param parsedMessage 解析済みメッセージ。
- * @return 処理済みならtrue。
- * @details
- * - [重要] 現時点は受信口を固定し、詳細制御実装は後続タスクへ委譲する。
+ * @return relay / gpio_H / gpio_L / led_ON / led_OFF / batch ならtrue。
  */
-bool handleSetOrGetSubCommand(const char* commandName,
-                              const String& normalizedSubName,
-                              const mqtt::mqttIncomingMessage& parsedMessage) {
-  if (commandName == nullptr || strlen(commandName) == 0) {
+bool isOutputSetSubCommand(const String& normalizedSubName) {
+  return normalizedSubName == iotCommon::mqtt::subCommand::set::kRelay ||
+         normalizedSubName == iotCommon::mqtt::subCommand::set::kGpioHigh ||
+         normalizedSubName == iotCommon::mqtt::subCommand::set::kGpioLow ||
+         normalizedSubName == iotCommon::mqtt::subCommand::set::kLedOn ||
+         normalizedSubName == iotCommon::mqtt::subCommand::set::kLedOff ||
+         normalizedSubName == iotCommon::mqtt::subCommand::set::kBatch;
+}
+
+/**
+ * @brief 出力状態の JSON 値を論理状態へ変換する。
+ * @param stateItem `state` 値（bool / number / "on" "off" "high" "low"）。
+ * @param isActiveOut 出力先。
+ * @return 解釈できた場合true。
+ */
+bool parseOutputStateItem(const cJSON* stateItem, bool* isActiveOut) {
+  if (stateItem == nullptr || isActiveOut == nullptr) {
     return false;
   }
+  if (cJSON_IsBool(stateItem)) {
+    *isActiveOut = cJSON_IsTrue(stateItem);
+    return true;
+  }
+  if (cJSON_IsNumber(stateItem)) {
+    *isActiveOut = (stateItem->valuedouble != 0.0);
+    return true;
+  }
+  if (cJSON_IsString(stateItem) && stateItem->valuestring != nullptr) {
+    const char* stateText = stateItem->valuestring;
+    if (strcasecmp(stateText, "on") == 0 || strcasecmp(stateText, "high") == 0 || strcmp(stateText, "1") == 0) {
+      *isActiveOut = true;
+      return true;
+    }
+    if (strcasecmp(stateText, "off") == 0 || strcasecmp(stateText, "low") == 0 || strcmp(stateText, "0") == 0) {
+      *isActiveOut = false;
+      return true;
+    }
+  }
+  return false;
+}
 
-  if (normalizedSubName.length() == 0) {
+/**
+ * @brief 出力番号の JSON 値を読む。
+ * @return 0..255 の整数なら true。
+ */
+bool parseOutputIndexItem(const cJSON* indexItem, uint8_t* indexOut) {
+  if (indexItem == nullptr || indexOut == nullptr || !cJSON_IsNumber(indexItem)) {
+    return false;
+  }
+  if (indexItem->valuedouble < 0.0 || indexItem->valuedouble > 255.0 ||
+      indexItem->valuedouble != static_cast<double>(indexItem->valueint)) {
     return false;
   }
+  *indexOut = static_cast<uint8_t>(indexItem->valueint);
+  return true;
+}
 
-  if (strcmp(commandName, "set") == 0 && normalizedSubName.equalsIgnoreCase("keyDeviceSet")) {
-    jsonService payloadJsonService;
-    String keyDeviceBase64;
-    payloadJsonService.getValueByPath(parsedMessage.rawPayload, "args.keyDevice", &keyDeviceBase64);
-    if (keyDeviceBase64.length() == 0) {
-      appLogError("handleSetOrGetSubCommand failed. keyDeviceSet requires args.keyDevice.");
-      return true;
+/**
+ * @brief set 要求の args から出力操作列を組み立てる。
+ * @param normalizedSubName 正規化済みサブコマンド。
+ * @param argsObject `args` オブジェクト。
+ * @param operationsOut 出力先（kGpioBatchMaxOperations 件）。
+ * @param operationCountOut 操作数出力先。
+ * @param detailOut 失敗理由 / 成功時の要約。
+ * @return 組み立て成功時true。
+ * @details
+ * - [重要] `batch` は `args.ops` 配列（各要素 `target` `index` `state`）を受ける。単発サブコマンドは1件の操作になる。
+ */
+bool buildOutputOperations(const String& normalizedSubName,
+                           const cJSON* argsObject,
+                           gpioBatchOperation* operationsOut,
+                           uint8_t* operationCountOut,
+                           String* detailOut) {
+  *operationCountOut = 0;
+  if (argsObject == nullptr || !cJSON_IsObject(argsObject)) {
+    *detailOut = "args is required";
+    return false;
+  }
+
+  if (normalizedSubName == iotCommon::mqtt::subCommand::set::kBatch) {
+    const cJSON* operationArray = cJSON_GetObjectItemCaseSensitive(argsObject, "ops");
+    if (!cJSON_IsArray(operationArray)) {
+      *detailOut = "args.ops must be array";
+      return false;
     }
-    if (!ensureMqttSensitiveDataReady()) {
-      appLogError("handleSetOrGetSubCommand failed. sensitiveDataService is not ready.");
-      return true;
+    const int arraySize = cJSON_GetArraySize(operationArray);
+    if (arraySize <= 0 || arraySize > kGpioBatchMaxOperations) {
+      *detailOut = String("args.ops size must be 1..") + String(static_cast<unsigned>(kGpioBatchMaxOperations));
+      return false;
     }
-    if (!mqttSensitiveDataService.saveKeyDevice(keyDeviceBase64)) {
-      appLogError("handleSetOrGetSubCommand failed. saveKeyDevice returned false.");
-      return true;
+    int position = 0;
+    const cJSON* operationItem = nullptr;
+    cJSON_ArrayForEach(operationItem, operationArray) {
+      const cJSON* targetItem = cJSON_GetObjectItemCaseSensitive(operationItem, "target");
+      gpioBatchOperation& operation = operationsOut[position];
+      operation.target = gpioBatch::parseTargetName(cJSON_IsString(targetItem) ? targetItem->valuestring : nullptr);
+      if (operation.target == gpioBatchTarget::kUnknown ||
+          !parseOutputIndexItem(cJSON_GetObjectItemCaseSensitive(operationItem, "index"), &operation.index) ||
+          !parseOutputStateItem(cJSON_GetObjectItemCaseSensitive(operationItem, "state"), &operation.isActive)) {
+        *detailOut = String("invalid ops[") + String(position) + "] (target/index/state)";
+        return false;
+      }
+      ++position;
     }
-    appLogWarn("handleSetOrGetSubCommand: keyDeviceSet saved successfully. keyLength=%ld", static_cast<long>(keyDeviceBase64.length()));
+    *operationCountOut = static_cast<uint8_t>(position);
     return true;
   }
 
-  if (strcmp(commandName, "set") == 0 && normalizedSubName.equalsIgnoreCase("fileLogSet")) {
-    cJSON* rootObject = cJSON_Parse(parsedMessage.rawPayload.c_str());
-    if (rootObject == nullptr) {
-      appLogError("handleSetOrGetSubCommand failed. fileLogSet payload parse failed.");
-      return true;
+  gpioBatchOperation& operation = operationsOut[0];
+  if (normalizedSubName == iotCommon::mqtt::subCommand::set::kRelay) {
+    operation.target = gpioBatchTarget::kRelay;
+    if (!parseOutputIndexItem(cJSON_GetObjectItemCaseSensitive(argsObject, "channel"), &operation.index) ||
+        !parseOutputStateItem(cJSON_GetObjectItemCaseSensitive(argsObject, "state"), &operation.isActive)) {
+      *detailOut = "args.channel and args.state are required";
+      return false;
     }
-    cJSON* argsObject = cJSON_GetObjectItemCaseSensitive(rootObject, "args");
-    cJSON* enabledItem = (argsObject != nullptr) ? cJSON_GetObjectItemCaseSensitive(argsObject, "enabled") : nullptr;
-    bool enabledValue = false;
-    bool enabledParsed = false;
-    if (enabledItem != nullptr) {
-      if (cJSON_IsBool(enabledItem)) {
-        enabledValue = cJSON_IsTrue(enabledItem);
-        enabledParsed = true;
+    *detailOut = String("channel=") + String(operation.index) + " state=" + (operation.isActive ? "on" : "off");
+  } else {
+    const bool isGpio = (normalizedSubName == iotCommon::mqtt::subCommand::set::kGpioHigh ||
+                         normalizedSubName == iotCommon::mqtt::subCommand::set::kGpioLow);
+    operation.target = isGpio ? gpioBatchTarget::kGpio : gpioBatchTarget::kLed;
+    operation.isActive = (normalizedSubName == iotCommon::mqtt::subCommand::set::kGpioHigh ||
+                          normalizedSubName == iotCommon::mqtt::subCommand::set::kLedOn);
+    if (!parseOutputIndexItem(cJSON_GetObjectItemCaseSensitive(argsObject, "index"), &operation.index)) {
+      *detailOut = "args.index is required";
+      return false;
+    }
+    *detailOut = String("index=") + String(operation.index) + (isGpio ? " level=" : " state=") +
+                 (isGpio ? (operation.isActive ? "high" : "low") : (operation.isActive ? "on" : "off"));
+  }
+  *operationCountOut = 1;
+  return true;
+}
+
+/**
+ * @brief 応答エンベロープ（v/DstID/SrcID/Request/id/ts/op/sub/Res/detail/errorCode）を組み立て、notice/<sub> へ1件 publish する。
+ * @param opName 応答の op（要求のコマンド種別: set / get / call）。
+ * @param subName サブコマンド。
+ * @param requestIdText 要求ID（空なら採番する）。
+ * @param destinationId 返信先ID（空なら all）。
+ * @param isSuccess 成否（Res）。
+ * @param detailText 補足メッセージ（null は空文字）。
+ * @param errorCode エラーコード（null なら errorCode を含めない）。
+ * @param extraKey 追加ペイロードのキー（`results` / `args` など。extraItem が null なら未使用）。
+ * @param extraItem 追加ペイロード（所有権を引き取る。null可）。
+ * @param messageIdOut 応答の id（null可）。
+ * @param publishedBytesOut 送信した payload の byte 数（暗号化後。null可）。
+ * @return publish成功時true。
+ * @details
+ * - [重要] 応答の共通部分はここだけで組み立てる。用途ごとの差は op / errorCode の有無 / 追加ペイロードのみ。
+ */
+bool publishResponseEnvelope(const char* opName,
+                             const char* subName,
+                             const String& requestIdText,
+                             const String& destinationId,
+                             bool isSuccess,
+                             const char* detailText,
+                             const char* errorCode,
+                             const char* extraKey,
+                             cJSON* extraItem,
+                             String* messageIdOut,
+                             size_t* publishedBytesOut) {
+  if (!mqttClient.isConnected()) {
+    cJSON_Delete(extraItem);
+    appLogWarn("publishResponseEnvelope skipped. mqtt is not connected. sub=%s", subName);
+    return false;
+  }
+  if (deviceNodeName.length() <= 0 && !resolveDeviceNodeName(&deviceNodeName)) {
+    cJSON_Delete(extraItem);
+    appLogError("publishResponseEnvelope failed. resolveDeviceNodeName returned false.");
+    return false;
+  }
+  String topicText;
+  if (!createTopicText("notice", subName, deviceNodeName.c_str(), &topicText)) {
+    cJSON_Delete(extraItem);
+    appLogError("publishResponseEnvelope failed. createTopicText returned false. sub=%s", subName);
+    return false;
+  }
+  const String messageId = requestIdText.length() > 0 ? requestIdText : (String(deviceNodeName) + "-" + millis());
+  String timestampText;
+  if (!createCurrentUtcIso8601Text(&timestampText)) {
+    timestampText = "";
+  }
+  cJSON* rootObject = cJSON_CreateObject();
+  if (rootObject == nullptr) {
+    cJSON_Delete(extraItem);
+    appLogError("publishResponseEnvelope failed. cJSON_CreateObject returned null.");
+    return false;
+  }
+  cJSON_AddStringToObject(rootObject, "v", iotCommon::kProtocolVersion);
+  cJSON_AddStringToObject(rootObject, "DstID", destinationId.length() > 0 ? destinationId.c_str() : "all");
+  cJSON_AddStringToObject(rootObject, "SrcID", deviceNodeName.c_str());
+  cJSON_AddStringToObject(rootObject, "Request", "Response");
+  cJSON_AddStringToObject(rootObject, "id", messageId.c_str());
+  cJSON_AddStringToObject(rootObject, "ts", timestampText.c_str());
+  cJSON_AddStringToObject(rootObject, "op", opName);
+  cJSON_AddStringToObject(rootObject, "sub", subName);
+  cJSON_AddStringToObject(rootObject,
+                          "Res",
+                          isSuccess ? iotCommon::mqtt::responseResult::kOk : iotCommon::mqtt::responseResult::kNg);
+  cJSON_AddStringToObject(rootObject, "detail", detailText == nullptr ? "" : detailText);
+  if (errorCode != nullptr) {
+    cJSON_AddStringToObject(rootObject, "errorCode", errorCode);
+  }
+  if (extraItem != nullptr) {
+    cJSON_AddItemToObject(rootObject, extraKey, extraItem);
+  }
+  char* serializedPayload = cJSON_PrintUnformatted(rootObject);
+  cJSON_Delete(rootObject);
+  if (serializedPayload == nullptr) {
+    appLogError("publishResponseEnvelope failed. cJSON_PrintUnformatted returned null. sub=%s", subName);
+    return false;
+  }
+  const String plainPayloadText = String(serializedPayload);
+  cJSON_free(serializedPayload);
+
+  String outgoingPayloadText;
+  if (!resolveOutgoingPayloadText(topicText, plainPayloadText, &outgoingPayloadText)) {
+    appLogError("publishResponseEnvelope failed. resolveOutgoingPayloadText returned false. topic=%s", topicText.c_str());
+    return false;
+  }
+  if (!publishMqttText(topicText.c_str(), outgoingPayloadText, false, mqttAsync::mqttQos::kAtMostOnce)) {
+    appLogError("publishResponseEnvelope failed. publish returned false. topic=%s bytes=%u",
+                topicText.c_str(),
+                static_cast<unsigned>(outgoingPayloadText.length()));
+    return false;
+  }
+  pollMqttClient();
+  if (messageIdOut != nullptr) {
+    *messageIdOut = messageId;
+  }
+  if (publishedBytesOut != nullptr) {
+    *publishedBytesOut = outgoingPayloadText.length();
+  }
+  return true;
+}
+
+/**
+ * @brief コマンド結果応答（Res/detail/errorCode）を1件 publish する。
+ * @param opName 応答の op（要求のコマンド種別: set / get）。
+ * @param destinationId 返信先ID。
+ * @param requestId 要求ID（応答へ引き継ぐ）。
+ * @param subName サブコマンド。
+ * @param isSuccess 反映成功フラグ。
+ * @param detailText 補足メッセージ。
+ * @param errorCode 失敗時のエラーコード（成功時は空）。
+ * @return publish成功時true。
+ */
+bool publishCommandResultNotice(const char* opName,
+                                const String& destinationId,
+                                const String& requestId,
+                                const String& subName,
+                                bool isSuccess,
+                                const String& detailText,
+                                const char* errorCode) {
+  return publishResponseEnvelope(opName,
+                                 subName.c_str(),
+                                 requestId,
+                                 destinationId,
+                                 isSuccess,
+                                 detailText.c_str(),
+                                 errorCode == nullptr ? "" : errorCode,
+                                 nullptr,
+                                 nullptr,
+                                 nullptr,
+                                 nullptr);
+}
+
+/**
+ * @brief 出力ポート操作（set）の結果応答を1件 publish する。
+ * @details 引数は publishCommandResultNotice と同じ（op は set 固定）。
+ * @return publish成功時true。
+ */
+bool publishOutputSetResultNotice(const String& destinationId,
+                                  const String& requestId,
+                                  const String& subName,
+                                  bool isSuccess,
+                                  const String& detailText,
+                                  const char* errorCode) {
+  return publishCommandResultNotice(iotCommon::mqtt::jsonKey::set::kCommand,
+                                    destinationId,
+                                    requestId,
+                                    subName,
+                                    isSuccess,
+                                    detailText,
+                                    errorCode);
+}
+
+/**
+ * @brief `args.at` 付きの出力操作を検証して予約し、受付結果を応答する。
+ * @param normalizedSubName 正規化済みサブコマンド。
+ * @param sourceId 要求元ID（応答先）。
+ * @param requestIdText 要求ID。
+ * @param atText `args.at` の文字列（文字列でなければ空）。
+ * @param operations 組み立て済み操作列。
+ * @param operationCount 操作数。
+ * @return 常にtrue（処理済み）。
+ * @details
+ * - [重要] 受付時に検証とマスク作成まで済ませる。応答は受付時に1件、発火時に1件の計2件になる。
+ * - [厳守] 検証や予約に失敗した場合は出力を変えず、受付応答だけを NG で返す。
+ */
+bool handleScheduledOutputSetCommand(const String& normalizedSubName,
+                                     const String& sourceId,
+                                     const String& requestIdText,
+                                     const String& atText,
+                                     const gpioBatchOperation* operations,
+                                     uint8_t operationCount) {
+  int64_t targetUtcUs = 0;
+  if (atText.length() <= 0 || !commandScheduler::parseUtcTimestamp(atText.c_str(), &targetUtcUs)) {
+    publishOutputSetResultNotice(sourceId,
+                                 requestIdText,
+                                 normalizedSubName,
+                                 false,
+                                 "args.at must be UTC text (YYYY-MM-DDTHH:MM:SS[.fff]Z)",
+                                 "INVALID_ARGUMENT");
+    return true;
+  }
+  gpioBatchPlan outputPlan{};
+  gpioBatchResult prepareResult{};
+  if (!gpioBatch::prepareOperations(operations, operationCount, &outputPlan, &prepareResult)) {
+    String detailText = String(gpioBatch::getErrorText(prepareResult.error));
+    if (prepareResult.failedOperationIndex != 0xFF) {
+      detailText += String(" position=") + String(prepareResult.failedOperationIndex);
+    }
+    publishOutputSetResultNotice(sourceId, requestIdText, normalizedSubName, false, detailText, "INVALID_ARGUMENT");
+    return true;
+  }
+
+  commandScheduleReceipt scheduleReceipt{};
+  if (!commandScheduler::scheduleOutputPlan(targetUtcUs,
+                                            outputPlan,
+                                            normalizedSubName.c_str(),
+                                            requestIdText.c_str(),
+                                            sourceId.c_str(),
+                                            &scheduleReceipt)) {
+    const char* errorCode = "INVALID_ARGUMENT";
+    if (scheduleReceipt.error == commandScheduleError::kClockNotSynchronized) {
+      errorCode = "TIME_NOT_SYNCED";
+    } else if (scheduleReceipt.error == commandScheduleError::kInPast) {
+      errorCode = "EXPIRED_REQUEST";
+    } else if (scheduleReceipt.error == commandScheduleError::kFull ||
+               scheduleReceipt.error == commandScheduleError::kNotInitialized ||
+               scheduleReceipt.error == commandScheduleError::kTimerFailed) {
+      errorCode = "BUSY_RETRY_LATER";
+    }
+    publishOutputSetResultNotice(sourceId,
+                                 requestIdText,
+                                 normalizedSubName,
+                                 false,
+                                 String(commandScheduler::getErrorText(scheduleReceipt.error)) + " at=" + atText,
+                                 errorCode);
+    return true;
+  }
+  const String detailText = String("scheduled at=") + atText +
+                            " delayMs=" + String(static_cast<long>(scheduleReceipt.delayUs / 1000)) +
+                            " pending=" + String(scheduleReceipt.pendingCount);
+  publishOutputSetResultNotice(sourceId, requestIdText, normalizedSubName, true, detailText, "");
+  return true;
+}
+
+/**
+ * @brief 出力ポート操作の set 要求を処理する（単発も batch も同じ経路で一括反映する）。
+ * @param normalizedSubName 正規化済みサブコマンド。
+ * @param parsedMessage 解析済みメッセージ。
+ * @return 常にtrue（処理済み）。
+ * @details
+ * - [重要] batch の全操作は1回の検証・1回のレジスタ書込みで同時に反映し、応答も1件だけ返す。
+ * - [厳守] 1件でも不正なら INVALID_ARGUMENT で全体を拒否し、出力は変えない。
+ */
+bool handleOutputSetCommand(const String& normalizedSubName, const mqtt::mqttIncomingMessage& parsedMessage) {
+  cJSON* rootObject = cJSON_Parse(parsedMessage.rawPayload.c_str());
+  if (rootObject == nullptr) {
+    appLogError("handleOutputSetCommand failed. payload parse failed. sub=%s", normalizedSubName.c_str());
+    publishOutputSetResultNotice(parsedMessage.srcId, "", normalizedSubName, false, "payload parse failed", "INVALID_ARGUMENT");
+    return true;
+  }
+  const cJSON* requestIdItem = cJSON_GetObjectItemCaseSensitive(rootObject, "id");
+  const String requestIdText = (cJSON_IsString(requestIdItem) && requestIdItem->valuestring != nullptr)
+                                   ? String(requestIdItem->valuestring)
+                                   : String("");
+
+  gpioBatchOperation operations[kGpioBatchMaxOperations] = {};
+  uint8_t operationCount = 0;
+  String detailText;
+  const cJSON* argsObject = cJSON_GetObjectItemCaseSensitive(rootObject, "args");
+  const cJSON* atItem = cJSON_IsObject(argsObject) ? cJSON_GetObjectItemCaseSensitive(argsObject, "at") : nullptr;
+  const bool isScheduled = (atItem != nullptr);
+  const String atText = (cJSON_IsString(atItem) && atItem->valuestring != nullptr) ? String(atItem->valuestring) : String("");
+  const bool buildResult = buildOutputOperations(normalizedSubName, argsObject, operations, &operationCount, &detailText);
+  cJSON_Delete(rootObject);
+  if (!buildResult) {
+    appLogWarn("handleOutputSetCommand rejected. sub=%s reason=%s srcId=%s",
+               normalizedSubName.c_str(),
+               detailText.c_str(),
+               parsedMessage.srcId.c_str());
+    publishOutputSetResultNotice(parsedMessage.srcId, requestIdText, normalizedSubName, false, detailText, "INVALID_ARGUMENT");
+    return true;
+  }
+  if (isScheduled) {
+    return handleScheduledOutputSetCommand(normalizedSubName, parsedMessage.srcId, requestIdText, atText, operations, operationCount);
+  }
+
+  gpioBatchResult batchResult{};
+  if (!gpioBatch::applyOperations(operations, operationCount, &batchResult)) {
+    detailText = String(gpioBatch::getErrorText(batchResult.error));
+    if (batchResult.failedOperationIndex != 0xFF) {
+      detailText += String(" position=") + String(batchResult.failedOperationIndex);
+    }
+    publishOutputSetResultNotice(parsedMessage.srcId, requestIdText, normalizedSubName, false, detailText, "INVALID_ARGUMENT");
+    return true;
+  }
+  if (normalizedSubName == iotCommon::mqtt::subCommand::set::kBatch) {
+    detailText = String("applied=") + String(batchResult.appliedCount) + " registerWrites=" + String(batchResult.registerWriteCount);
+  }
+  appLogInfo("handleOutputSetCommand applied. sub=%s %s requestId=%s",
+             normalizedSubName.c_str(),
+             detailText.c_str(),
+             requestIdText.c_str());
+  publishOutputSetResultNotice(parsedMessage.srcId, requestIdText, normalizedSubName, true, detailText, "");
+  return true;
+}
+
+/** @brief `get multi` で1要求に含められる最大項目数。@type uint8_t */
+constexpr uint8_t kMultiGetMaxItems = 8;
+
+/**
+ * @brief 出力種別の状態を `states` 配列として結果へ加える。
+ * @return 1件以上読めた場合true。
+ */
+bool appendOutputStatesToResult(gpioBatchTarget target, cJSON* resultObject) {
+  uint8_t outputIndexes[kGpioBatchMaxOperations] = {};
+  const uint8_t outputCount = gpioBatch::listOutputIndexes(target, outputIndexes, kGpioBatchMaxOperations);
+  cJSON* statesArray = cJSON_AddArrayToObject(resultObject, "states");
+  if (statesArray == nullptr) {
+    return false;
+  }
+  uint8_t readCount = 0;
+  for (uint8_t position = 0; position < outputCount; ++position) {
+    bool isActive = false;
+    if (!gpioBatch::readOutputState(target, outputIndexes[position], &isActive)) {
+      continue;
+    }
+    cJSON* stateObject = cJSON_CreateObject();
+    if (stateObject == nullptr) {
+      return false;
+    }
+    cJSON_AddNumberToObject(stateObject, "index", outputIndexes[position]);
+    if (target == gpioBatchTarget::kGpio) {
+      cJSON_AddStringToObject(stateObject, "state", isActive ? "high" : "low");
+    } else {
+      cJSON_AddStringToObject(stateObject, "state", isActive ? "on" : "off");
+    }
+    cJSON_AddItemToArray(statesArray, stateObject);
+    ++readCount;
+  }
+  return readCount > 0;
+}
+
+/**
+ * @brief `get multi` の1項目を実行し、結果オブジェクトへ書き込む。
+ * @param itemSubName 正規化済みの項目サブコマンド。
+ * @param resultObject 結果オブジェクト（`sub` は設定済み）。
+ * @return 項目が成功した場合true。
+ * @details
+ * - [重要] 単発 get と同じ情報源（周期測定スナップショット / 出力レジスタ / 入力タスクの確定状態）を読む。
+ */
+bool executeMultiGetItem(const String& itemSubName, cJSON* resultObject) {
+  const char* errorCode = "";
+  String detailText;
+  bool isSuccess = false;
+  if (itemSubName == iotCommon::mqtt::subCommand::get::kTrh) {
+    i2cService* i2cServiceInstance = getI2cServiceInstance();
+    i2cEnvironmentSnapshot snapshot{};
+    if (i2cServiceInstance == nullptr) {
+      detailText = "I2C service is not started";
+      errorCode = "BUSY_RETRY_LATER";
+    } else if (!i2cServiceInstance->requestEnvironmentSnapshot(&snapshot, 2000)) {
+      detailText = "BME280 read failed";
+      errorCode = "BUSY_RETRY_LATER";
+    } else {
+      char sensorAddressText[8] = {};
+      snprintf(sensorAddressText, sizeof(sensorAddressText), "0x%02X", static_cast<unsigned>(snapshot.sensorAddress));
+      cJSON_AddStringToObject(resultObject, "sensorAddress", sensorAddressText);
+      cJSON_AddNumberToObject(resultObject, "temperatureC", static_cast<double>(snapshot.temperatureC));
+      cJSON_AddNumberToObject(resultObject, "humidityRh", static_cast<double>(snapshot.humidityRh));
+      cJSON_AddNumberToObject(resultObject, "pressureHpa", static_cast<double>(snapshot.pressureHpa));
+      detailText = "BME280 read success";
+      isSuccess = true;
+    }
+  } else if (itemSubName == iotCommon::mqtt::subCommand::get::kRelay ||
+             itemSubName == iotCommon::mqtt::subCommand::get::kLed ||
+             itemSubName == iotCommon::mqtt::subCommand::get::kGpio) {
+    const gpioBatchTarget outputTarget = gpioBatch::parseTargetName(itemSubName.c_str());
+    uint8_t outputIndexes[kGpioBatchMaxOperations] = {};
+    if (gpioBatch::listOutputIndexes(outputTarget, outputIndexes, kGpioBatchMaxOperations) == 0) {
+      // [重要] relay / gpio は拡張出力を有効にしたビルドでだけ許可表に載る。
+      detailText = "output is not available on this build";
+      errorCode = "UNSUPPORTED_SUB";
+    } else {
+      isSuccess = appendOutputStatesToResult(outputTarget, resultObject);
+      detailText = isSuccess ? "output state read" : "output is not initialized";
+      errorCode = isSuccess ? "" : "BUSY_RETRY_LATER";
+    }
+  } else if (itemSubName == iotCommon::mqtt::subCommand::get::kButton) {
+    bool isPressed = false;
+    isSuccess = readStableButtonState(&isPressed);
+    if (isSuccess) {
+      cJSON_AddBoolToObject(resultObject, "pressed", isPressed);
+    }
+    detailText = isSuccess ? "button state read" : "input task is not started";
+    errorCode = isSuccess ? "" : "BUSY_RETRY_LATER";
+  } else {
+    detailText = "sub is not supported in multi";
+    errorCode = "UNSUPPORTED_SUB";
+  }
+  cJSON_AddStringToObject(resultObject,
+                          "Res",
+                          isSuccess ? iotCommon::mqtt::responseResult::kOk : iotCommon::mqtt::responseResult::kNg);
+  cJSON_AddStringToObject(resultObject, "detail", detailText.c_str());
+  cJSON_AddStringToObject(resultObject, "errorCode", errorCode);
+  return isSuccess;
+}
+
+/**
+ * @brief `get multi` を処理し、全項目の結果を1件の応答で返す。
+ * @param parsedMessage 解析済みメッセージ。
+ * @return 常にtrue（処理済み）。
+ * @details
+ * - [重要] `args.items` の順に1回の受信処理の中で実行し、`results` に同じ順で項目ごとの結果を入れる。
+ * - [重要] 全項目成功なら `Res=OK`。1件でも失敗があれば `Res=NG` とし、成功した項目の値はそのまま返す。
+ * - [厳守] `items` 自体が不正（配列でない / 0件 / 上限超過）の場合は項目を実行せず `INVALID_ARGUMENT` で返す。
+ */
+bool handleMultiGetCommand(const mqtt::mqttIncomingMessage& parsedMessage) {
+  const char* subName = iotCommon::mqtt::subCommand::get::kMulti;
+  cJSON* requestObject = cJSON_Parse(parsedMessage.rawPayload.c_str());
+  const cJSON* requestIdItem =
+      (requestObject != nullptr) ? cJSON_GetObjectItemCaseSensitive(requestObject, "id") : nullptr;
+  const String requestIdText = (cJSON_IsString(requestIdItem) && requestIdItem->valuestring != nullptr)
+                                   ? String(requestIdItem->valuestring)
+                                   : String("");
+  const cJSON* argsObject =
+      (requestObject != nullptr) ? cJSON_GetObjectItemCaseSensitive(requestObject, "args") : nullptr;
+  const cJSON* itemArray = cJSON_IsObject(argsObject) ? cJSON_GetObjectItemCaseSensitive(argsObject, "items") : nullptr;
+  const int itemCount = cJSON_IsArray(itemArray) ? cJSON_GetArraySize(itemArray) : 0;
+  if (itemCount <= 0 || itemCount > kMultiGetMaxItems) {
+    cJSON_Delete(requestObject);
+    appLogWarn("handleMultiGetCommand rejected. items=%d srcId=%s", itemCount, parsedMessage.srcId.c_str());
+    publishCommandResultNotice(iotCommon::mqtt::jsonKey::get::kCommand,
+                               parsedMessage.srcId,
+                               requestIdText,
+                               subName,
+                               false,
+                               String("args.items must be array of 1..") + String(kMultiGetMaxItems),
+                               "INVALID_ARGUMENT");
+    return true;
+  }
+
+  if (!mqttClient.isConnected()) {
+    cJSON_Delete(requestObject);
+    appLogWarn("handleMultiGetCommand skipped. mqtt is not connected.");
+    return true;
+  }
+  cJSON* resultsArray = cJSON_CreateArray();
+  if (resultsArray == nullptr) {
+    cJSON_Delete(requestObject);
+    appLogError("handleMultiGetCommand failed. cJSON_CreateArray returned null.");
+    return true;
+  }
+  uint8_t successCount = 0;
+  const cJSON* itemEntry = nullptr;
+  cJSON_ArrayForEach(itemEntry, itemArray) {
+    // [重要] 項目は文字列（"trh"）か {"sub":"trh"} のどちらでも受ける。
+    const cJSON* subItem = cJSON_IsObject(itemEntry) ? cJSON_GetObjectItemCaseSensitive(itemEntry, "sub") : itemEntry;
+    const String itemSubName = (cJSON_IsString(subItem) && subItem->valuestring != nullptr)
+                                   ? normalizeSubCommand(String(subItem->valuestring))
+                                   : String("");
+    cJSON* resultObject = cJSON_CreateObject();
+    if (resultObject == nullptr) {
+      break;
+    }
+    cJSON_AddStringToObject(resultObject, "sub", itemSubName.c_str());
+    if (executeMultiGetItem(itemSubName, resultObject)) {
+      ++successCount;
+    }
+    cJSON_AddItemToArray(resultsArray, resultObject);
+  }
+  cJSON_Delete(requestObject);
+
+  const bool isAllSuccess = (successCount == itemCount);
+  const String detailText = String("items=") + String(itemCount) + " ok=" + String(successCount);
+  String messageId;
+  size_t publishedBytes = 0;
+  if (!publishResponseEnvelope(iotCommon::mqtt::jsonKey::get::kCommand,
+                               subName,
+                               requestIdText,
+                               parsedMessage.srcId,
+                               isAllSuccess,
+                               detailText.c_str(),
+                               nullptr,
+                               "results",
+                               resultsArray,
+                               &messageId,
+                               &publishedBytes)) {
+    appLogError("handleMultiGetCommand failed. publishResponseEnvelope returned false. requestId=%s",
+                requestIdText.c_str());
+    return true;
+  }
+  appLogInfo("handleMultiGetCommand success. requestId=%s %s bytes=%u",
+             messageId.c_str(),
+             detailText.c_str(),
+             static_cast<unsigned>(publishedBytes));
+  return true;
+}
+
+/**
+ * @brief 診断系 `call`（flashBench / netSelfTest）の応答を notice/<sub> へ1件 publish する。
+ * @param subName サブコマンド名。
+ * @param requestIdText 要求ID（空なら採番する）。
+ * @param destinationId 返信先ID。
+ * @param isSuccess 成否。
+ * @param detailText 詳細。
+ * @param errorCode エラーコード（成功時は空）。
+ * @param argsObject 応答の `args`（所有権を引き取る。null可）。
+ * @return publish できた場合true。
+ */
+bool publishDiagnosticCallResponse(const char* subName,
+                                   const String& requestIdText,
+                                   const String& destinationId,
+                                   bool isSuccess,
+                                   const char* detailText,
+                                   const char* errorCode,
+                                   cJSON* argsObject) {
+  String messageId;
+  size_t publishedBytes = 0;
+  if (!publishResponseEnvelope("call",
+                               subName,
+                               requestIdText,
+                               destinationId,
+                               isSuccess,
+                               detailText,
+                               errorCode == nullptr ? "" : errorCode,
+                               "args",
+                               argsObject,
+                               &messageId,
+                               &publishedBytes)) {
+    appLogWarn("publishDiagnosticCallResponse: result not published. sub=%s requestId=%s", subName, requestIdText.c_str());
+    return false;
+  }
+  appLogInfo("publishDiagnosticCallResponse success. sub=%s requestId=%s result=%s bytes=%u",
+             subName,
+             messageId.c_str(),
+             isSuccess ? "OK" : "NG",
+             static_cast<unsigned>(publishedBytes));
+  return true;
+}
+
+/**
+ * @brief `call flashBench` を処理し、LittleFS の I/O 計測結果を1件の応答で返す。
+ * @param payloadText 受信payload。
+ * @param destinationId 返信先ID。
+ * @return 常にtrue（処理済み）。
+ * @details
+ * - [重要] 計測は本タスクで同期実行する（既定設定で数秒）。その間は MQTT の受信処理が止まる。
+ * - [厳守] OTA 更新中・fileSync セッション中は計測しない（`BUSY_RETRY_LATER`）。
+ */
+bool handleFlashBenchmarkCommand(const String& payloadText, const String& destinationId) {
+  jsonService payloadJsonService;
+  String requestIdText;
+  payloadJsonService.getValueByPath(payloadText, "id", &requestIdText);
+  flashBenchmarkOptions options = flashBenchmark::getDefaultOptions();
+  long optionValue = 0;
+  if (payloadJsonService.getValueByPath(payloadText, "args.fileBytes", &optionValue) && optionValue > 0) {
+    options.fileBytes = static_cast<uint32_t>(optionValue);
+  }
+  if (payloadJsonService.getValueByPath(payloadText, "args.randomOps", &optionValue) && optionValue > 0) {
+    options.randomOperationCount = static_cast<uint16_t>(optionValue > 0xFFFF ? 0xFFFF : optionValue);
+  }
+  if (payloadJsonService.getValueByPath(payloadText, "args.metaOps", &optionValue) && optionValue > 0) {
+    options.metaOperationCount = static_cast<uint16_t>(optionValue > 0xFFFF ? 0xFFFF : optionValue);
+  }
+
+  // [重要] 計測結果は約2KB になるため、タスクスタックではなく静的領域に置く。
+  static flashBenchmarkReport benchmarkReport;
+  const char* detailText = isOtaInProgress() ? "ota is in progress" : "filesync session is active";
+  const char* errorCode = "BUSY_RETRY_LATER";
+  bool isSuccess = false;
+  if (!isOtaInProgress() && !currentFileSyncSession.active) {
+    isSuccess = flashBenchmark::run(options, &benchmarkReport, &detailText);
+    errorCode = isSuccess ? "" : "FS_IO_FAILED";
+  }
+
+  cJSON* argsObject = nullptr;
+  if (isSuccess) {
+    argsObject = cJSON_CreateObject();
+    if (argsObject == nullptr || !flashBenchmark::appendReportToJson(benchmarkReport, argsObject)) {
+      cJSON_Delete(argsObject);
+      appLogError("handleFlashBenchmarkCommand failed. appendReportToJson returned false.");
+      return true;
+    }
+  }
+  publishDiagnosticCallResponse(iotCommon::mqtt::subCommand::call::kFlashBench,
+                                requestIdText,
+                                destinationId,
+                                isSuccess,
+                                detailText,
+                                errorCode,
+                                argsObject);
+  return true;
+}
+
+/**
+ * @brief 通信自己診断の TLS 検証に使う CA 証明書を解決する。
+ * @param tlsCaCertificateOut 出力先（null不可）。
+ * @return 取得成功時true。
+ * @details
+ * - [重要] MQTT / 画像パッケージ取得と同じく `/certs` を主経路とし、未投入時のみヘッダー証明書へフォールバックする。
+ */
+bool resolveSelfTestTlsCaCertificate(String* tlsCaCertificateOut) {
+  if (tlsCaCertificateOut == nullptr || !ensureMqttSensitiveDataReady()) {
+    appLogError("resolveSelfTestTlsCaCertificate failed. output is null or sensitive data service is not ready.");
+    return false;
+  }
+  String certIssueNo;
+  String certSetAt;
+  if (mqttSensitiveDataService.loadMqttTlsCertificate(tlsCaCertificateOut, &certIssueNo, &certSetAt) &&
+      tlsCaCertificateOut->length() > 0) {
+    return true;
+  }
+#if defined(SENSITIVE_MQTT_TLS_CA_CERT)
+  if (strlen(SENSITIVE_MQTT_TLS_CA_CERT) > 0) {
+    *tlsCaCertificateOut = String(SENSITIVE_MQTT_TLS_CA_CERT);
+    appLogWarn("resolveSelfTestTlsCaCertificate: fallback to header MQTT TLS CA certificate.");
+    return true;
+  }
+#endif
+  appLogWarn("resolveSelfTestTlsCaCertificate: MQTT TLS CA certificate is unavailable.");
+  return false;
+}
+
+/**
+ * @brief `call netSelfTest` 1件分の計測要求と結果（計測タスクと mqttTask で共有）。
+ * @details
+ * - [重要] isRunning が true の間は計測タスクだけが書き込み、mqttTask は完了通知を受けてから読む。
+ */
+struct networkSelfTestJob {
+  /** @brief 計測中（結果の publish 完了まで）なら true。@type bool */
+  bool isRunning;
+  /** @brief 要求ID。@type String */
+  String requestId;
+  /** @brief 返信先ID。@type String */
+  String destinationId;
+  /** @brief 計測先ホスト（options.host が指す）。@type String */
+  String host;
+  /** @brief TLS 検証用CA（options.tlsCaCertificate が指す）。@type String */
+  String tlsCaCertificate;
+  /** @brief 計測条件。@type networkSelfTestOptions */
+  networkSelfTestOptions options;
+  /** @brief 計測結果（度数分布を含み約400B のため静的領域に置く）。@type networkSelfTestReport */
+  networkSelfTestReport report;
+  /** @brief 成否。@type bool */
+  bool isSuccess;
+  /** @brief 失敗理由。@type const char* */
+  const char* detail;
+};
+/** @brief 計測要求（同時に1件）。 */
+networkSelfTestJob selfTestJob;
+/** @brief selfTestJob.isRunning の排他。 */
+portMUX_TYPE selfTestJobLock = portMUX_INITIALIZER_UNLOCKED;
+/** @brief 計測タスクのハンドル（初回要求時に生成）。 */
+TaskHandle_t selfTestTaskHandle = nullptr;
+/** @brief 計測タスク用スタック領域。 */
+StackType_t* selfTestTaskStackBuffer = nullptr;
+/** @brief 計測タスク用制御ブロック。 */
+StaticTask_t selfTestTaskControlBlock;
+
+/**
+ * @brief 計測タスク本体。通知を受けるたびに selfTestJob を1件計測し、結果を mqttTask へ渡す。
+ * @details
+ * - [重要] 計測（最大で数十秒）を mqttTask から外し、計測中も Keep Alive と他コマンドの処理を続ける。
+ */
+void networkSelfTestTaskEntry(void* taskParameter) {
+  (void)taskParameter;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    selfTestJob.detail = "ok";
+    selfTestJob.isSuccess = networkSelfTest::run(selfTestJob.options, &selfTestJob.report, &selfTestJob.detail);
+    appUtil::appTaskMessageDetail resultDetail = appUtil::createEmptyMessageDetail();
+    resultDetail.hasBoolValue = true;
+    resultDetail.boolValue = selfTestJob.isSuccess;
+    if (!appUtil::sendMessage(appTaskId::kMqtt,
+                              appTaskId::kNetworkSelfTest,
+                              appMessageType::kMqttPublishNetSelfTestResultRequest,
+                              &resultDetail,
+                              1000)) {
+      appLogError("networkSelfTestTaskEntry failed. result is dropped. requestId=%s", selfTestJob.requestId.c_str());
+      portENTER_CRITICAL(&selfTestJobLock);
+      selfTestJob.isRunning = false;
+      portEXIT_CRITICAL(&selfTestJobLock);
+    }
+  }
+}
+
+/**
+ * @brief 計測要求を計測タスクへ渡す（初回は計測タスクを生成する）。
+ * @return 受け付けた場合true。計測中・タスク生成失敗は false（detailOut に理由）。
+ */
+bool startNetworkSelfTestJob(const String& requestIdText,
+                             const String& destinationId,
+                             const String& hostText,
+                             const networkSelfTestOptions& options,
+                             const char** detailOut) {
+  portENTER_CRITICAL(&selfTestJobLock);
+  const bool wasRunning = selfTestJob.isRunning;
+  selfTestJob.isRunning = true;
+  portEXIT_CRITICAL(&selfTestJobLock);
+  if (wasRunning) {
+    *detailOut = "self test is already running";
+    return false;
+  }
+  if (selfTestTaskHandle == nullptr &&
+      !taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kNetworkSelfTest,
+                                             networkSelfTestTaskEntry,
+                                             nullptr,
+                                             &selfTestTaskStackBuffer,
+                                             &selfTestTaskControlBlock,
+                                             &selfTestTaskHandle)) {
+    portENTER_CRITICAL(&selfTestJobLock);
+    selfTestJob.isRunning = false;
+    portEXIT_CRITICAL(&selfTestJobLock);
+    *detailOut = "self test task create failed";
+    return false;
+  }
+  selfTestJob.requestId = requestIdText;
+  selfTestJob.destinationId = destinationId;
+  selfTestJob.host = hostText;
+  selfTestJob.options = options;
+  selfTestJob.options.host = selfTestJob.host.c_str();
+  selfTestJob.options.tlsCaCertificate = nullptr;
+  if (options.tlsCaCertificate != nullptr) {
+    selfTestJob.tlsCaCertificate = options.tlsCaCertificate;
+    selfTestJob.options.tlsCaCertificate = selfTestJob.tlsCaCertificate.c_str();
+  }
+  xTaskNotifyGive(selfTestTaskHandle);
+  return true;
+}
+
+/**
+ * @brief 計測タスクの完了通知を受け、`call netSelfTest` の結果を応答する（mqttTask で呼ぶ）。
+ */
+void publishNetworkSelfTestJobResult() {
+  cJSON* argsObject = nullptr;
+  if (selfTestJob.isSuccess) {
+    argsObject = cJSON_CreateObject();
+    if (argsObject == nullptr || !networkSelfTest::appendReportToJson(selfTestJob.report, argsObject)) {
+      cJSON_Delete(argsObject);
+      argsObject = nullptr;
+      selfTestJob.isSuccess = false;
+      selfTestJob.detail = "result serialize failed";
+      appLogError("publishNetworkSelfTestJobResult failed. appendReportToJson returned false.");
+    }
+  }
+  publishDiagnosticCallResponse(iotCommon::mqtt::subCommand::call::kNetSelfTest,
+                                selfTestJob.requestId,
+                                selfTestJob.destinationId,
+                                selfTestJob.isSuccess,
+                                selfTestJob.detail,
+                                selfTestJob.isSuccess ? "" : "NETWORK_UNAVAILABLE",
+                                argsObject);
+  selfTestJob.tlsCaCertificate = "";
+  portENTER_CRITICAL(&selfTestJobLock);
+  selfTestJob.isRunning = false;
+  portEXIT_CRITICAL(&selfTestJobLock);
+}
+
+/**
+ * @brief `call netSelfTest` を受け付け、計測用エンドポイントへの TCP / TLS 計測を計測タスクで開始する。
+ * @param payloadText 受信payload。
+ * @param destinationId 返信先ID。
+ * @return 常にtrue（処理済み）。
+ * @details
+ * - [重要] `args.host` 省略時は MQTT ブローカーのホスト（LocalServer）を計測先とする。
+ * - [重要] 計測は netSelfTestTask で行い、完了後に mqttTask が結果を1件の応答で返す（publishNetworkSelfTestJobResult）。
+ *   受付時点では応答しない。拒否（引数不正・fileSync 中・計測中）はその場で応答する。
+ * - [厳守] fileSync セッション中は計測しない（`BUSY_RETRY_LATER`）。
+ */
+bool handleNetworkSelfTestCommand(const String& payloadText, const String& destinationId) {
+  jsonService payloadJsonService;
+  String requestIdText;
+  String hostText;
+  payloadJsonService.getValueByPath(payloadText, "id", &requestIdText);
+  payloadJsonService.getValueByPath(payloadText, "args.host", &hostText);
+  hostText.trim();
+  if (hostText.length() == 0) {
+    hostText = String(mqttHost);
+  }
+  networkSelfTestOptions options = networkSelfTest::getDefaultOptions();
+  options.host = hostText.c_str();
+  long optionValue = 0;
+  if (payloadJsonService.getValueByPath(payloadText, "args.tcpPort", &optionValue) && optionValue >= 0 && optionValue <= 65535) {
+    options.tcpPort = static_cast<uint16_t>(optionValue);
+  }
+  if (payloadJsonService.getValueByPath(payloadText, "args.tlsPort", &optionValue) && optionValue >= 0 && optionValue <= 65535) {
+    options.tlsPort = static_cast<uint16_t>(optionValue);
+  }
+  if (payloadJsonService.getValueByPath(payloadText, "args.bytes", &optionValue) && optionValue > 0) {
+    options.transferBytes = static_cast<uint32_t>(optionValue);
+  }
+  if (payloadJsonService.getValueByPath(payloadText, "args.pings", &optionValue) && optionValue > 0) {
+    options.pingCount = static_cast<uint16_t>(optionValue > 0xFFFF ? 0xFFFF : optionValue);
+  }
+  if (payloadJsonService.getValueByPath(payloadText, "args.stallMs", &optionValue) && optionValue > 0) {
+    options.stallThresholdMs = static_cast<uint16_t>(optionValue > 0xFFFF ? 0xFFFF : optionValue);
+  }
+  String tlsCaCertificate;
+  if (options.tlsPort != 0 && resolveSelfTestTlsCaCertificate(&tlsCaCertificate)) {
+    options.tlsCaCertificate = tlsCaCertificate.c_str();
+  }
+
+  const char* detailText = "filesync session is active";
+  const char* errorCode = "BUSY_RETRY_LATER";
+  if (hostText.length() == 0 || (options.tcpPort == 0 && options.tlsPort == 0)) {
+    detailText = "host is empty or both ports are 0";
+    errorCode = "INVALID_ARGUMENT";
+  } else if (!currentFileSyncSession.active) {
+    if (startNetworkSelfTestJob(requestIdText, destinationId, hostText, options, &detailText)) {
+      appLogInfo("handleNetworkSelfTestCommand accepted. requestId=%s host=%s", requestIdText.c_str(), hostText.c_str());
+      return true;
+    }
+  }
+  publishDiagnosticCallResponse(iotCommon::mqtt::subCommand::call::kNetSelfTest,
+                                requestIdText,
+                                destinationId,
+                                false,
+                                detailText,
+                                errorCode,
+                                nullptr);
+  return true;
+}
+
+/**
+ * @brief set/get系の受信を暫定処理する。
+ * @param commandName コマンド名（set/get）。
+ * @param normalizedSubName 正規化済みサブコマンド。
+ * @param parsedMessage 解析済みメッセージ。
+ * @return 処理済みならtrue。
+ * @details
+ * - [重要] 現時点は受信口を固定し、詳細制御実装は後続タスクへ委譲する。
+ */
+bool handleSetOrGetSubCommand(const char* commandName,
+                              const String& normalizedSubName,
+                              const mqtt::mqttIncomingMessage& parsedMessage) {
+  if (commandName == nullptr || strlen(commandName) == 0) {
+    return false;
+  }
+
+  if (normalizedSubName.length() == 0) {
+    return false;
+  }
+
+  if (strcmp(commandName, "set") == 0 && normalizedSubName.equalsIgnoreCase("keyDeviceSet")) {
+    jsonService payloadJsonService;
+    String keyDeviceBase64;
+    payloadJsonService.getValueByPath(parsedMessage.rawPayload, "args.keyDevice", &keyDeviceBase64);
+    if (keyDeviceBase64.length() == 0) {
+      appLogError("handleSetOrGetSubCommand failed. keyDeviceSet requires args.keyDevice.");
+      return true;
+    }
+    if (!ensureMqttSensitiveDataReady()) {
+      appLogError("handleSetOrGetSubCommand failed. sensitiveDataService is not ready.");
+      return true;
+    }
+    if (!mqttSensitiveDataService.saveKeyDevice(keyDeviceBase64)) {
+      appLogError("handleSetOrGetSubCommand failed. saveKeyDevice returned false.");
+      return true;
+    }
+    appLogWarn("handleSetOrGetSubCommand: keyDeviceSet saved successfully. keyLength=%ld", static_cast<long>(keyDeviceBase64.length()));
+    return true;
+  }
+
+  if (strcmp(commandName, "set") == 0 && normalizedSubName.equalsIgnoreCase("fileLogSet")) {
+    cJSON* rootObject = cJSON_Parse(parsedMessage.rawPayload.c_str());
+    if (rootObject == nullptr) {
+      appLogError("handleSetOrGetSubCommand failed. fileLogSet payload parse failed.");
+      return true;
+    }
+    cJSON* argsObject = cJSON_GetObjectItemCaseSensitive(rootObject, "args");
+    cJSON* enabledItem = (argsObject != nullptr) ? cJSON_GetObjectItemCaseSensitive(argsObject, "enabled") : nullptr;
+    bool enabledValue = false;
+    bool enabledParsed = false;
+    if (enabledItem != nullptr) {
+      if (cJSON_IsBool(enabledItem)) {
+        enabledValue = cJSON_IsTrue(enabledItem);
+        enabledParsed = true;
       } else if (cJSON_IsNumber(enabledItem)) {
         enabledValue = (enabledItem->valuedouble != 0.0);
         enabledParsed = true;
@@ -2651,6 +3709,14 @@ bool handleSetOrGetSubCommand(const char* commandName,
     return true;
   }
 
+  if (strcmp(commandName, "set") == 0 && isOutputSetSubCommand(normalizedSubName)) {
+    return handleOutputSetCommand(normalizedSubName, parsedMessage);
+  }
+
+  if (strcmp(commandName, "get") == 0 && normalizedSubName == iotCommon::mqtt::subCommand::get::kMulti) {
+    return handleMultiGetCommand(parsedMessage);
+  }
+
   appLogInfo("handleSetOrGetSubCommand accepted. command=%s sub=%s dstId=%s srcId=%s",
              commandName,
              normalizedSubName.c_str(),
@@ -2742,6 +3808,14 @@ bool handleCallSubCommand(const String& normalizedSubName,
     return handleImagePackageApplyCommand(payloadText, parsedMessage.srcId);
   }
 
+  if (normalizedSubName == iotCommon::mqtt::subCommand::call::kFlashBench) {
+    return handleFlashBenchmarkCommand(payloadText, parsedMessage.srcId);
+  }
+
+  if (normalizedSubName == iotCommon::mqtt::subCommand::call::kNetSelfTest) {
+    return handleNetworkSelfTestCommand(payloadText, parsedMessage.srcId);
+  }
+
   if (normalizedSubName.equalsIgnoreCase("securePing")) {
     jsonService payloadJsonService;
     String requestIdText;
@@ -2769,7 +3843,8 @@ bool handleCallSubCommand(const String& normalizedSubName,
     std::vector<uint8_t> ivBytes;
     std::vector<uint8_t> cipherBytes;
     std::vector<uint8_t> tagBytes;
-    if (!decodeBase64Text(ivBase64, &ivBytes) || !decodeBase64Text(cipherBase64, &cipherBytes) || !decodeBase64Text(tagBase64, &tagBytes)) {
+    if (!base64Codec::decodeToBytes(ivBase64, &ivBytes) || !base64Codec::decodeToBytes(cipherBase64, &cipherBytes) ||
+        !base64Codec::decodeToBytes(tagBase64, &tagBytes)) {
       appLogError("handleCallSubCommand securePing failed. base64 decode failed.");
       return true;
     }
@@ -2781,7 +3856,7 @@ bool handleCallSubCommand(const String& normalizedSubName,
 
     String responsePlainText;
     // [重要][再発防止] 応答平文に元payload全体を含めると暗号後サイズが大きくなり、
-    // PubSubClient の publish が失敗し secureEcho timeout につながるため、最小情報のみに制限する。
+    // MQTT パケット上限を超えて publish が失敗し secureEcho timeout につながるため、最小情報のみに制限する。
     // [厳守] decrypted は JSON文字列ではなく JSON値として返す（LocalServer側で JSON.parse するため）。
     responsePlainText = "{\"result\":\"OK\",\"requestId\":\"" + requestIdText + "\",\"decrypted\":" + plainText + "}";
     std::vector<uint8_t> responseIvBytes;
@@ -2794,9 +3869,9 @@ bool handleCallSubCommand(const String& normalizedSubName,
     String responseIvBase64;
     String responseCipherBase64;
     String responseTagBase64;
-    if (!encodeBase64Text(responseIvBytes, &responseIvBase64) ||
-        !encodeBase64Text(responseCipherBytes, &responseCipherBase64) ||
-        !encodeBase64Text(responseTagBytes, &responseTagBase64)) {
+    if (!base64Codec::encodeToText(responseIvBytes, &responseIvBase64) ||
+        !base64Codec::encodeToText(responseCipherBytes, &responseCipherBase64) ||
+        !base64Codec::encodeToText(responseTagBytes, &responseTagBase64)) {
       appLogError("handleCallSubCommand securePing failed. base64 encode failed.");
       return true;
     }
@@ -2832,7 +3907,7 @@ bool handleCallSubCommand(const String& normalizedSubName,
       appLogError("handleCallSubCommand securePing failed. resolveOutgoingPayloadText failed. topic=%s", topicText.c_str());
       return true;
     }
-    bool publishResult = mqttClient.publish(topicText.c_str(), outgoingPayloadText.c_str(), false);
+    bool publishResult = publishMqttText(topicText.c_str(), outgoingPayloadText, false, mqttAsync::mqttQos::kAtMostOnce);
     if (!publishResult) {
       appLogError("handleCallSubCommand securePing failed. publish failed. topic=%s", topicText.c_str());
       return true;
@@ -2844,6 +3919,37 @@ bool handleCallSubCommand(const String& normalizedSubName,
   return false;
 }
 
+/**
+ * @brief status 返信要求を集約待ちへ加える。
+ * @param requesterId 要求元ID。
+ * @return 集約待ちの最初の要求なら true。
+ * @details
+ * - [重要] 同じ要求元の重複は1件として列挙する。上限を超えた要求元は件数（requestCount）だけに数える。
+ */
+bool addPendingStatusReplyRequester(const String& requesterId) {
+  const bool isFirstRequest = !pendingStatusReply.isPending;
+  if (isFirstRequest) {
+    pendingStatusReply = statusReplyPendingState{};
+    pendingStatusReply.isPending = true;
+    pendingStatusReply.firstRequestMs = millis();
+  }
+  ++pendingStatusReply.requestCount;
+  if (requesterId.length() <= 0) {
+    return isFirstRequest;
+  }
+  for (uint8_t requesterIndex = 0; requesterIndex < pendingStatusReply.requesterCount; ++requesterIndex) {
+    if (requesterId == pendingStatusReply.requesterIds[requesterIndex]) {
+      return isFirstRequest;
+    }
+  }
+  if (pendingStatusReply.requesterCount < statusReplyMaxRequesters) {
+    char* requesterSlot = pendingStatusReply.requesterIds[pendingStatusReply.requesterCount];
+    snprintf(requesterSlot, sizeof(pendingStatusReply.requesterIds[0]), "%s", requesterId.c_str());
+    ++pendingStatusReply.requesterCount;
+  }
+  return isFirstRequest;
+}
+
 /**
  * @brief サーバーから受信したMQTTペイロードを解析してログ出力する。
  * @param topicName 受信トピック。
@@ -2888,28 +3994,14 @@ void onMqttMessageReceived(char* topicName, byte* payloadBuffer, unsigned int pa
   bool isStatusCallTopic = (topicName != nullptr && strstr(topicName, "esp32lab/call/status/") != nullptr);
   if (isStatusCallTopic &&
       normalizedSubName == iotCommon::mqtt::jsonKey::status::kCommand) {
-    appUtil::appTaskMessageDetail statusReplyDetail = appUtil::createEmptyMessageDetail();
-    statusReplyDetail.hasIntValue = true;
-    statusReplyDetail.intValue = static_cast<int32_t>(mainTaskStartupCpuMillis);
-    statusReplyDetail.text = "status reply requested by mqtt callback";
-    statusReplyDetail.text2 = iotCommon::mqtt::subCommand::status::kReply;
-    statusReplyDetail.text3 = statusValueOnline;
-    bool sendResult = appUtil::sendMessage(appTaskId::kMqtt,
-                                           appTaskId::kMqtt,
-                                           appMessageType::kMqttPublishOnlineRequest,
-                                           &statusReplyDetail,
-                                           100);
-    if (!sendResult) {
-      appLogError("onMqttMessageReceived failed. could not queue status reply. topic=%s srcId=%s dstId=%s",
-                  (topicName == nullptr ? "(null)" : topicName),
-                  parsedMessage.srcId.c_str(),
-                  parsedMessage.dstId.c_str());
-    } else {
-      appLogInfo("onMqttMessageReceived: status reply queued. topic=%s srcId=%s dstId=%s",
-                 (topicName == nullptr ? "(null)" : topicName),
-                 parsedMessage.srcId.c_str(),
-                 parsedMessage.dstId.c_str());
-    }
+    // [重要] 返信は mqttTask のループで集約して1回だけ publish する（要求ごとに status を組み立てない）。
+    const bool isFirstRequest = addPendingStatusReplyRequester(parsedMessage.srcId);
+    appLogInfo("onMqttMessageReceived: status reply %s. topic=%s srcId=%s dstId=%s pending=%lu",
+               isFirstRequest ? "pending" : "coalesced",
+               (topicName == nullptr ? "(null)" : topicName),
+               parsedMessage.srcId.c_str(),
+               parsedMessage.dstId.c_str(),
+               static_cast<unsigned long>(pendingStatusReply.requestCount));
   }
 
   bool isOtaStartCallTopic = (topicName != nullptr && strstr(topicName, "esp32lab/call/otaStart/") != nullptr);
@@ -2924,6 +4016,18 @@ void onMqttMessageReceived(char* topicName, byte* payloadBuffer, unsigned int pa
     if (otaRequestContext.firmwareSha256.length() == 0) {
       payloadJsonService.getValueByPath(parsedMessage.rawPayload, "args.firmwareSha256", &otaRequestContext.firmwareSha256);
     }
+    cJSON* otaPayloadObject = cJSON_Parse(parsedMessage.rawPayload.c_str());
+    cJSON* otaArgsObject = cJSON_GetObjectItemCaseSensitive(otaPayloadObject, "args");
+    const cJSON* mirrorUrlItem = nullptr;
+    cJSON_ArrayForEach(mirrorUrlItem, cJSON_GetObjectItemCaseSensitive(otaArgsObject, "mirrorUrls")) {
+      if (otaRequestContext.mirrorUrls.size() + 1 >= kMirrorDownloadMaxSources) {
+        break;
+      }
+      if (cJSON_IsString(mirrorUrlItem) && strlen(mirrorUrlItem->valuestring) > 0) {
+        otaRequestContext.mirrorUrls.push_back(String(mirrorUrlItem->valuestring));
+      }
+    }
+    cJSON_Delete(otaPayloadObject);
 
     if (otaRequestContext.firmwareUrl.length() == 0) {
       appLogError("onMqttMessageReceived failed. otaStart firmwareUrl is empty. topic=%s payload=%s",
@@ -2944,10 +4048,11 @@ void onMqttMessageReceived(char* topicName, byte* payloadBuffer, unsigned int pa
                   otaRequestContext.firmwareVersion.c_str(),
                   otaRequestContext.firmwareUrl.c_str());
     } else {
-      appLogInfo("onMqttMessageReceived: ota start queued. topic=%s version=%s url=%s",
+      appLogInfo("onMqttMessageReceived: ota start queued. topic=%s version=%s url=%s mirrors=%u",
                  (topicName == nullptr ? "(null)" : topicName),
                  otaRequestContext.firmwareVersion.c_str(),
-                 otaRequestContext.firmwareUrl.c_str());
+                 otaRequestContext.firmwareUrl.c_str(),
+                 static_cast<unsigned>(otaRequestContext.mirrorUrls.size()));
     }
   }
 
@@ -3114,40 +4219,46 @@ bool connectToMqttBroker() {
   }
 
   if (mqttResolvedBrokerIpValid) {
-    mqttClient.setServer(mqttResolvedBrokerIpAddress, static_cast<uint16_t>(mqttPort));
-    appLogWarn("connectToMqttBroker: mqttClient.setServer uses resolved IP. host=%s ip=%s port=%ld",
+    appLogWarn("connectToMqttBroker: session uses resolved IP. host=%s ip=%s port=%ld",
                mqttHost,
                mqttResolvedBrokerIpAddress.toString().c_str(),
                static_cast<long>(mqttPort));
   } else {
-    mqttClient.setServer(mqttHost, static_cast<uint16_t>(mqttPort));
-    appLogInfo("connectToMqttBroker: mqttClient.setServer uses host. host=%s port=%ld",
+    appLogInfo("connectToMqttBroker: session uses host. host=%s port=%ld",
                mqttHost,
                static_cast<long>(mqttPort));
   }
-  mqttClient.setCallback(onMqttMessageReceived);
-  // [重要] 4096byteバッファは暗号化payloadの肥大化対策として優先的にPSRAM利用を狙う。
-  // [厳守] 実割当先はライブラリ内部malloc依存のため、ヒープ差分をログで常時監視する。
-  const size_t spiramFreeBefore = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-  const size_t internalFreeBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
-  bool bufferSizeResult = mqttClient.setBufferSize(mqttPacketBufferSizeBytes);
-  const size_t spiramFreeAfter = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-  const size_t internalFreeAfter = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
-  if (!bufferSizeResult) {
-    appLogError("connectToMqttBroker failed. mqttClient.setBufferSize(%u) failed.",
-                static_cast<unsigned>(mqttPacketBufferSizeBytes));
-    return false;
-  }
-  const long spiramDelta = static_cast<long>(spiramFreeBefore) - static_cast<long>(spiramFreeAfter);
-  const long internalDelta = static_cast<long>(internalFreeBefore) - static_cast<long>(internalFreeAfter);
-  appLogInfo("connectToMqttBroker: mqtt buffer allocated. size=%u spiramDelta=%ld internalDelta=%ld",
-             static_cast<unsigned>(mqttPacketBufferSizeBytes),
-             spiramDelta,
-             internalDelta);
-  if (spiramDelta <= 0) {
-    appLogWarn("connectToMqttBroker: mqtt buffer may not be on PSRAM. size=%u internalDelta=%ld",
+  if (!isMqttClientAllocated) {
+    // [重要] 送信キュー/受信バッファは initialize で1回だけ確保する（再接続で再確保しない）。
+    // [厳守] 実割当先は heap_caps_malloc の既定方針依存のため、ヒープ差分をログで常時監視する。
+    mqttAsync::mqttAsyncClientConfig clientConfig = mqttAsync::getDefaultMqttAsyncClientConfig();
+    clientConfig.sendQueueBytes = mqttSendQueueBytes;
+    clientConfig.maxIncomingPacketBytes = mqttPacketBufferSizeBytes;
+    clientConfig.inflightWindow = mqttInflightWindow;
+    clientConfig.keepAliveSeconds = mqttKeepAliveSeconds;
+    const size_t spiramFreeBefore = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    const size_t internalFreeBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    bool initializeResult = mqttClient.initialize(clientConfig);
+    const size_t spiramFreeAfter = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    const size_t internalFreeAfter = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (!initializeResult) {
+      appLogError("connectToMqttBroker failed. mqttClient.initialize failed. sendQueue=%u incoming=%u",
+                  static_cast<unsigned>(mqttSendQueueBytes),
+                  static_cast<unsigned>(mqttPacketBufferSizeBytes));
+      return false;
+    }
+    mqttClient.setMessageHandler(queueMqttReceivedMessage, nullptr);
+    isMqttClientAllocated = true;
+    const long spiramDelta = static_cast<long>(spiramFreeBefore) - static_cast<long>(spiramFreeAfter);
+    const long internalDelta = static_cast<long>(internalFreeBefore) - static_cast<long>(internalFreeAfter);
+    appLogInfo("connectToMqttBroker: mqtt buffer allocated. sendQueue=%u incoming=%u spiramDelta=%ld internalDelta=%ld",
+               static_cast<unsigned>(mqttSendQueueBytes),
                static_cast<unsigned>(mqttPacketBufferSizeBytes),
+               spiramDelta,
                internalDelta);
+    if (spiramDelta <= 0) {
+      appLogWarn("connectToMqttBroker: mqtt buffer may not be on PSRAM. internalDelta=%ld", internalDelta);
+    }
   }
   String clientId = "esp32lab-" + String(static_cast<uint32_t>(ESP.getEfuseMac()), HEX);
   if (deviceNodeName.length() <= 0) {
@@ -3234,13 +4345,7 @@ bool connectToMqttBroker() {
   for (int32_t retryIndex = 0; retryIndex < maxRetryCount; ++retryIndex) {
     ledController::indicateMqttConnecting();
     ledController::indicateCommunicationActivity();
-    bool connectResult = mqttClient.connect(clientId.c_str(),
-                                            mqttUser,
-                                            mqttPass,
-                                            willTopicText.c_str(),
-                                            1,
-                                            true,
-                                            willOutgoingPayloadText.c_str());
+    bool connectResult = openMqttSession(clientId.c_str(), willTopicText.c_str(), willOutgoingPayloadText.c_str());
 
     if (connectResult) {
       String subscribeTopicSet = String("esp32lab/set/+/") + deviceNodeName;
@@ -3252,37 +4357,46 @@ bool connectToMqttBroker() {
       String subscribeTopicCallAll = "esp32lab/call/+/all";
       String subscribeTopicNetworkAll = "esp32lab/network/+/all";
       bool subscribeResult =
-          mqttClient.subscribe(subscribeTopicSet.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicGet.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicCall.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicNetwork.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicSetAll.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicGetAll.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicCallAll.c_str(), 1) &&
-          mqttClient.subscribe(subscribeTopicNetworkAll.c_str(), 1);
+          mqttClient.subscribe(subscribeTopicSet.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicGet.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicCall.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicNetwork.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicSetAll.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicGetAll.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicCallAll.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued &&
+          mqttClient.subscribe(subscribeTopicNetworkAll.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) == mqttAsync::mqttEnqueueResult::kQueued;
       if (!subscribeResult) {
         appLogWarn("connectToMqttBroker: subscribe failed. receiver=%s", deviceNodeName.c_str());
       }
+      pollMqttClient();
       ledController::indicateMqttConnected();
-      appLogInfo("connectToMqttBroker success. state=%d", mqttClient.state());
+      appLogInfo("connectToMqttBroker success. inflight=%u", static_cast<unsigned>(mqttClient.inflightCount()));
       return true;
     }
 
-    appLogWarn("connectToMqttBroker retry. retry=%ld state=%d", static_cast<long>(retryIndex + 1), mqttClient.state());
+    appLogWarn("connectToMqttBroker retry. retry=%ld connack=%u",
+               static_cast<long>(retryIndex + 1),
+               static_cast<unsigned>(mqttClient.lastConnackReturnCode()));
     vTaskDelay(pdMS_TO_TICKS(retryDelayMs));
   }
 
-  appLogError("connectToMqttBroker failed. state=%d", mqttClient.state());
+  appLogError("connectToMqttBroker failed. connack=%u", static_cast<unsigned>(mqttClient.lastConnackReturnCode()));
   ledController::indicateErrorPattern();
   return false;
 }
 
 /**
  * @brief MQTTへonlineステータスを初回publishする。
+ * @param requesterIdsText 応答済みの要求元（カンマ区切り）。reply 以外は null。
+ * @param requestCount 集約した要求数。0 なら requesterIds / requestCount を載せない。
  * @return publish成功時true、失敗時false。
  */
-bool publishStatusNotice(const char* subName, const char* onlineStateText, uint32_t startupCpuMillis) {
-  if (!mqttClient.connected()) {
+bool publishStatusNotice(const char* subName,
+                         const char* onlineStateText,
+                         uint32_t startupCpuMillis,
+                         const char* requesterIdsText,
+                         uint32_t requestCount) {
+  if (!mqttClient.isConnected()) {
     appLogError("publishStatusNotice failed. mqtt is not connected.");
     return false;
   }
@@ -3312,12 +4426,22 @@ bool publishStatusNotice(const char* subName, const char* onlineStateText, uint3
     appLogError("publishStatusNotice failed. buildMqttStatusPayload failed. topic=%s", topicText.c_str());
     return false;
   }
+  if (requestCount > 0) {
+    jsonService payloadJsonService;
+    jsonKeyValueItem requesterItemList[] = {
+        {iotCommon::mqtt::jsonKey::status::kRequesterIds, jsonValueType::kString, requesterIdsText == nullptr ? "" : requesterIdsText, 0, 0, false},
+        {iotCommon::mqtt::jsonKey::status::kRequestCount, jsonValueType::kLong, nullptr, 0, static_cast<long>(requestCount), false},
+    };
+    if (!payloadJsonService.setValuesByPath(&plainPayloadText, requesterItemList, sizeof(requesterItemList) / sizeof(requesterItemList[0]))) {
+      appLogWarn("publishStatusNotice: requester items were not added. setValuesByPath failed.");
+    }
+  }
   String outgoingPayloadText;
   if (!resolveOutgoingPayloadText(topicText, plainPayloadText, &outgoingPayloadText)) {
     appLogError("publishStatusNotice failed. resolveOutgoingPayloadText failed. topic=%s", topicText.c_str());
     return false;
   }
-  bool publishResult = mqttClient.publish(topicText.c_str(), outgoingPayloadText.c_str(), true);
+  bool publishResult = publishMqttText(topicText.c_str(), outgoingPayloadText, true, mqttAsync::mqttQos::kAtMostOnce);
   ledController::indicateCommunicationActivity();
   if (!publishResult) {
     appLogError("publishStatusNotice failed. topic=%s sub=%s onlineState=%s",
@@ -3327,7 +4451,7 @@ bool publishStatusNotice(const char* subName, const char* onlineStateText, uint3
     return false;
   }
 
-  mqttClient.loop();
+  pollMqttClient();
   appLogInfo("publishStatusNotice success. topic=%s sub=%s onlineState=%s",
              topicText.c_str(),
              safeSubName,
@@ -3335,6 +4459,94 @@ bool publishStatusNotice(const char* subName, const char* onlineStateText, uint3
   return true;
 }
 
+/**
+ * @brief publish に失敗した status 返信を集約待ちへ戻す。
+ * @param failedReply publish に失敗した集約内容。
+ * @details
+ * - [重要] publish 中に届いた要求（pendingStatusReply）は失敗分へ合流させ、次の再送1回で一緒に応答する。
+ */
+void requeueFailedStatusReply(const statusReplyPendingState& failedReply) {
+  statusReplyPendingState mergedReply = failedReply;
+  if (pendingStatusReply.isPending) {
+    mergedReply.requestCount += pendingStatusReply.requestCount;
+    for (uint8_t arrivedIndex = 0; arrivedIndex < pendingStatusReply.requesterCount; ++arrivedIndex) {
+      const char* arrivedId = pendingStatusReply.requesterIds[arrivedIndex];
+      bool isKnownRequester = false;
+      for (uint8_t requesterIndex = 0; requesterIndex < mergedReply.requesterCount; ++requesterIndex) {
+        if (strcmp(arrivedId, mergedReply.requesterIds[requesterIndex]) == 0) {
+          isKnownRequester = true;
+          break;
+        }
+      }
+      if (!isKnownRequester && mergedReply.requesterCount < statusReplyMaxRequesters) {
+        snprintf(mergedReply.requesterIds[mergedReply.requesterCount],
+                 sizeof(mergedReply.requesterIds[0]),
+                 "%s",
+                 arrivedId);
+        ++mergedReply.requesterCount;
+      }
+    }
+  }
+  mergedReply.isPending = true;
+  mergedReply.firstRequestMs = millis();
+  ++mergedReply.failedAttemptCount;
+  pendingStatusReply = mergedReply;
+}
+
+/**
+ * @brief 集約待ちの status 返信を、待ち時間を過ぎていれば1回だけ publish する。
+ * @return publish した場合true。
+ * @details
+ * - [重要] publish 中は集約状態を空にしておき、pollMqttClient() で届いた要求は次の集約へ入れる。
+ * - [重要] publish に失敗した場合は集約内容を戻し、statusReplyRetryIntervalMs ごとに再送する。
+ *   statusReplyMaxAttempts 回失敗したら破棄してログを残す。
+ * - [重要] 応答済みの要求元は `requesterIds`（カンマ区切り）と `requestCount` で status に載せる。
+ */
+bool flushPendingStatusReply() {
+  const uint32_t waitMs =
+      (pendingStatusReply.failedAttemptCount == 0) ? statusReplyCoalesceWindowMs : statusReplyRetryIntervalMs;
+  if (!pendingStatusReply.isPending || static_cast<uint32_t>(millis() - pendingStatusReply.firstRequestMs) < waitMs) {
+    return false;
+  }
+  const statusReplyPendingState flushingReply = pendingStatusReply;
+  pendingStatusReply = statusReplyPendingState{};
+
+  String requesterIdsText;
+  for (uint8_t requesterIndex = 0; requesterIndex < flushingReply.requesterCount; ++requesterIndex) {
+    if (requesterIndex > 0) {
+      requesterIdsText += ",";
+    }
+    requesterIdsText += flushingReply.requesterIds[requesterIndex];
+  }
+  const bool publishResult = isMqttInitialized && publishStatusNotice(iotCommon::mqtt::subCommand::status::kReply,
+                                                                      statusValueOnline,
+                                                                      mainTaskStartupCpuMillis,
+                                                                      requesterIdsText.c_str(),
+                                                                      flushingReply.requestCount);
+  if (!publishResult && !mqttClient.isConnected()) {
+    isMqttInitialized = false;
+  }
+  if (!publishResult) {
+    if (flushingReply.failedAttemptCount + 1 < statusReplyMaxAttempts) {
+      requeueFailedStatusReply(flushingReply);
+      appLogWarn("flushPendingStatusReply failed. retry later. attempt=%u requests=%lu requesters=%s",
+                 static_cast<unsigned>(flushingReply.failedAttemptCount + 1),
+                 static_cast<unsigned long>(flushingReply.requestCount),
+                 requesterIdsText.c_str());
+      return false;
+    }
+    appLogError("flushPendingStatusReply failed. dropped after %u attempts. requests=%lu requesters=%s",
+                static_cast<unsigned>(statusReplyMaxAttempts),
+                static_cast<unsigned long>(flushingReply.requestCount),
+                requesterIdsText.c_str());
+    return false;
+  }
+  appLogInfo("flushPendingStatusReply success. requests=%lu requesters=%s",
+             static_cast<unsigned long>(flushingReply.requestCount),
+             requesterIdsText.c_str());
+  return true;
+}
+
 /**
  * @brief 現在UTCをISO8601文字列へ変換する。
  * @param utcIso8601Out 出力先。
@@ -3393,7 +4605,7 @@ bool publishTrhNotice(const String& destinationId,
                       const i2cEnvironmentSnapshot& snapshot,
                       bool isSuccess,
                       const char* detailText) {
-  if (!mqttClient.connected()) {
+  if (!mqttClient.isConnected()) {
     appLogError("publishTrhNotice failed. mqtt is not connected.");
     return false;
   }
@@ -3418,48 +4630,23 @@ bool publishTrhNotice(const String& destinationId,
     timestampText = "";
   }
 
-  cJSON* rootObject = cJSON_CreateObject();
-  if (rootObject == nullptr) {
-    appLogError("publishTrhNotice failed. cJSON_CreateObject returned null.");
-    return false;
-  }
-
-  cJSON_AddStringToObject(rootObject, "v", "1");
-  cJSON_AddStringToObject(rootObject, "DstID", destinationId.length() > 0 ? destinationId.c_str() : "all");
-  cJSON_AddStringToObject(rootObject, "SrcID", deviceNodeName.c_str());
-  cJSON_AddStringToObject(rootObject, "Request", "Notice");
-  cJSON_AddStringToObject(rootObject, "id", messageId.c_str());
-  cJSON_AddStringToObject(rootObject, "ts", timestampText.c_str());
-  cJSON_AddStringToObject(rootObject, "op", "notice");
-  cJSON_AddStringToObject(rootObject, "sub", iotCommon::mqtt::subCommand::notice::kTrh);
-  cJSON_AddStringToObject(rootObject, "Res", isSuccess ? iotCommon::mqtt::responseResult::kOk
-                                                       : iotCommon::mqtt::responseResult::kNg);
-  cJSON_AddStringToObject(rootObject, "detail", detailText == nullptr ? "" : detailText);
-
-  cJSON* argsObject = cJSON_AddObjectToObject(rootObject, "args");
-  if (argsObject == nullptr) {
-    cJSON_Delete(rootObject);
-    appLogError("publishTrhNotice failed. cJSON_AddObjectToObject(args) returned null.");
-    return false;
-  }
-  cJSON_AddStringToObject(argsObject, "sensorId", "bme280-1");
-  char sensorAddressText[8] = {};
-  snprintf(sensorAddressText, sizeof(sensorAddressText), "0x%02X", static_cast<unsigned>(snapshot.sensorAddress));
-  cJSON_AddStringToObject(argsObject, "sensorAddress", sensorAddressText);
-  if (isSuccess) {
-    cJSON_AddNumberToObject(argsObject, "temperatureC", static_cast<double>(snapshot.temperatureC));
-    cJSON_AddNumberToObject(argsObject, "humidityRh", static_cast<double>(snapshot.humidityRh));
-    cJSON_AddNumberToObject(argsObject, "pressureHpa", static_cast<double>(snapshot.pressureHpa));
-  }
-
-  char* serializedPayload = cJSON_PrintUnformatted(rootObject);
-  cJSON_Delete(rootObject);
-  if (serializedPayload == nullptr) {
-    appLogError("publishTrhNotice failed. cJSON_PrintUnformatted returned null.");
+  mqtt::trhNoticeReading reading;
+  reading.sensorAddress = snapshot.sensorAddress;
+  reading.temperatureC = snapshot.temperatureC;
+  reading.humidityRh = snapshot.humidityRh;
+  reading.pressureHpa = snapshot.pressureHpa;
+  String plainPayloadText;
+  if (!mqtt::buildTrhNoticePayload(deviceNodeName.c_str(),
+                                   destinationId.c_str(),
+                                   messageId.c_str(),
+                                   timestampText.c_str(),
+                                   isSuccess,
+                                   detailText,
+                                   reading,
+                                   &plainPayloadText)) {
+    appLogError("publishTrhNotice failed. buildTrhNoticePayload returned false.");
     return false;
   }
-  const String plainPayloadText = String(serializedPayload);
-  cJSON_free(serializedPayload);
 
   String outgoingPayloadText;
   if (!resolveOutgoingPayloadText(topicText, plainPayloadText, &outgoingPayloadText)) {
@@ -3467,7 +4654,7 @@ bool publishTrhNotice(const String& destinationId,
     return false;
   }
 
-  const bool publishResult = mqttClient.publish(topicText.c_str(), outgoingPayloadText.c_str(), false);
+  const bool publishResult = publishMqttText(topicText.c_str(), outgoingPayloadText, false, mqttAsync::mqttQos::kAtMostOnce);
   if (!publishResult) {
     appLogError("publishTrhNotice failed. topic=%s requestId=%s",
                 topicText.c_str(),
@@ -3475,7 +4662,7 @@ bool publishTrhNotice(const String& destinationId,
     return false;
   }
 
-  mqttClient.loop();
+  pollMqttClient();
   appLogInfo("publishTrhNotice success. topic=%s requestId=%s result=%s temperature=%.2f humidity=%.2f pressure=%.2f",
              topicText.c_str(),
              messageId.c_str(),
@@ -3498,7 +4685,7 @@ bool publishOtaProgressNotice(int32_t progressPercent,
                               const char* phase,
                               const char* detail,
                               const char* firmwareVersion) {
-  if (!mqttClient.connected()) {
+  if (!mqttClient.isConnected()) {
     appLogError("publishOtaProgressNotice failed. mqtt is not connected.");
     return false;
   }
@@ -3546,14 +4733,14 @@ bool publishOtaProgressNotice(int32_t progressPercent,
     appLogError("publishOtaProgressNotice failed. resolveOutgoingPayloadText failed. topic=%s", topicText.c_str());
     return false;
   }
-  const bool publishResult = mqttClient.publish(topicText.c_str(), outgoingPayloadText.c_str(), false);
+  const bool publishResult = publishMqttText(topicText.c_str(), outgoingPayloadText, false, mqttAsync::mqttQos::kAtLeastOnce);
   if (!publishResult) {
     appLogError("publishOtaProgressNotice failed. topic=%s payloadLength=%ld",
                 topicText.c_str(),
                 static_cast<long>(payloadText.length()));
     return false;
   }
-  mqttClient.loop();
+  pollMqttClient();
   appLogInfo("publishOtaProgressNotice success. topic=%s phase=%s progress=%ld",
              topicText.c_str(),
              phase == nullptr ? "" : phase,
@@ -3562,6 +4749,10 @@ bool publishOtaProgressNotice(int32_t progressPercent,
 }
 }
 
+bool isFileSyncSessionActive() {
+  return isFileSyncSessionActiveShared.load(std::memory_order_acquire);
+}
+
 /**
  * @brief MQTTタスクを生成し、受信用キューを登録する。
  * @return 生成成功時true、失敗時false。
@@ -3570,34 +4761,14 @@ bool mqttTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kMqtt, 8);
 
-  if (mqttTaskStackBuffer == nullptr) {
-    mqttTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (mqttTaskStackBuffer == nullptr) {
-    appLogWarn("mqttTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    mqttTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (mqttTaskStackBuffer == nullptr) {
-    appLogError("mqttTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
-    return false;
-  }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "mqttTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      mqttTaskStackBuffer,
-      &mqttTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("mqttTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kMqtt,
+                                             taskEntry,
+                                             this,
+                                             &mqttTaskStackBuffer,
+                                             &mqttTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("mqttTask created. stackBytes=%u", static_cast<unsigned>(taskStackSize));
   return true;
 }
 
@@ -3621,8 +4792,8 @@ void mqttTask::runLoop() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   appLogInfo("mqttTask loop started. (skeleton)");
   for (;;) {
-    if (isMqttInitialized && mqttClient.connected()) {
-      mqttClient.loop();
+    if (isMqttInitialized && mqttClient.isConnected()) {
+      pollMqttClient();
     }
 
     appTaskMessage receivedMessage{};
@@ -3679,8 +4850,10 @@ void mqttTask::runLoop() {
                                            : statusValueOnline;
       bool publishResult = isMqttInitialized && publishStatusNotice(requestSubName,
                                                                     requestOnlineState,
-                                                                    mainTaskStartupCpuMillis);
-      if (!publishResult && !mqttClient.connected()) {
+                                                                    mainTaskStartupCpuMillis,
+                                                                    nullptr,
+                                                                    0);
+      if (!publishResult && !mqttClient.isConnected()) {
         // [重要] 送信失敗かつ切断状態なら初期化完了フラグを落として再接続シーケンスへ委譲する。
         isMqttInitialized = false;
       }
@@ -3706,7 +4879,7 @@ void mqttTask::runLoop() {
                                                     receivedMessage.text,
                                                     receivedMessage.text2,
                                                     receivedMessage.text3);
-      if (!publishResult && !mqttClient.connected()) {
+      if (!publishResult && !mqttClient.isConnected()) {
         isMqttInitialized = false;
       }
       if (!publishResult) {
@@ -3722,35 +4895,57 @@ void mqttTask::runLoop() {
                    static_cast<long>(receivedMessage.intValue),
                    receivedMessage.text3);
       }
-      if (isTerminalOtaPhase(receivedMessage.text)) {
-        appTaskMessage doneMessage{};
-        doneMessage.sourceTaskId = appTaskId::kMqtt;
-        doneMessage.destinationTaskId = receivedMessage.sourceTaskId;
-        doneMessage.messageType = appMessageType::kMqttPublishOtaProgressDone;
-        doneMessage.intValue = publishResult ? 1 : 0;
-        doneMessage.intValue2 = receivedMessage.intValue;
-        strncpy(doneMessage.text, receivedMessage.text, sizeof(doneMessage.text) - 1);
-        doneMessage.text[sizeof(doneMessage.text) - 1] = '\0';
-        strncpy(doneMessage.text2,
-                publishResult ? "mqtt ota terminal publish done" : "mqtt ota terminal publish failed",
-                sizeof(doneMessage.text2) - 1);
-        doneMessage.text2[sizeof(doneMessage.text2) - 1] = '\0';
-        bool sendResult = messageService.sendMessage(doneMessage, pdMS_TO_TICKS(300));
-        if (!sendResult) {
-          appLogError("mqttTask: failed to send ota terminal publish ack. phase=%s progress=%ld targetTask=%d",
-                      receivedMessage.text,
-                      static_cast<long>(receivedMessage.intValue),
-                      static_cast<int>(receivedMessage.sourceTaskId));
-        } else {
-          appLogInfo("mqttTask: ota terminal publish ack sent. phase=%s progress=%ld result=%d targetTask=%d",
-                     receivedMessage.text,
-                     static_cast<long>(receivedMessage.intValue),
-                     publishResult ? 1 : 0,
-                     static_cast<int>(receivedMessage.sourceTaskId));
+      if (isCompletionRequested(receivedMessage.completionToken)) {
+        // [重要] 終端通知(done/error)は要求元が完了通知トークンで待っている。Queue経由のACKは送らない。
+        // [重要] 直後に再起動し得るため、PUBACK（QoS1 送信窓が空く）まで待ってから完了させる。
+        if (publishResult) {
+          publishResult = waitMqttInflightDrained(mqttTerminalAckWaitMs);
         }
+        const bool completeResult = messageService.completeCompletion(receivedMessage.completionToken, publishResult);
+        appLogInfo("mqttTask: ota progress completion %s. phase=%s progress=%ld result=%d",
+                   completeResult ? "signaled" : "dropped",
+                   receivedMessage.text,
+                   static_cast<long>(receivedMessage.intValue),
+                   publishResult ? 1 : 0);
       }
     }
 
+    if (receiveResult && receivedMessage.messageType == appMessageType::kMqttPublishScheduledResultRequest) {
+      // [重要] 時刻指定 set の発火結果。受付応答と同じ id で2件目の応答を返す。
+      // [重要] 発火側（esp_timer タスク）はログを出さないため、発火の記録はここで出す。
+      const bool isApplied = receivedMessage.boolValue;
+      const String detailText = String("fired lateUs=") + String(static_cast<long>(receivedMessage.intValue)) +
+                                " applied=" + String(static_cast<long>(receivedMessage.intValue2));
+      appLogInfo("commandScheduler fired. sub=%s id=%s applied=%d %s",
+                 receivedMessage.text,
+                 receivedMessage.text2,
+                 isApplied ? 1 : 0,
+                 detailText.c_str());
+      const uint32_t droppedResultCount = commandScheduler::takeDroppedResultCount();
+      if (droppedResultCount > 0) {
+        appLogWarn("commandScheduler fired results were dropped. queue full. count=%lu",
+                   static_cast<unsigned long>(droppedResultCount));
+      }
+      bool publishResult = isMqttInitialized && publishOutputSetResultNotice(String(receivedMessage.text3),
+                                                                             String(receivedMessage.text2),
+                                                                             String(receivedMessage.text),
+                                                                             isApplied,
+                                                                             detailText,
+                                                                             isApplied ? "" : "INVALID_ARGUMENT");
+      if (!publishResult) {
+        appLogError("mqttTask: scheduled result publish failed. sub=%s id=%s %s",
+                    receivedMessage.text,
+                    receivedMessage.text2,
+                    detailText.c_str());
+      }
+    }
+
+    if (receiveResult && receivedMessage.messageType == appMessageType::kMqttPublishNetSelfTestResultRequest) {
+      publishNetworkSelfTestJobResult();
+    }
+
+    flushPendingStatusReply();
+
     // TODO: MQTT初期化、接続、subscribe/publish処理を実装する。
     // [重要] OTA終端通知(done/error)の遅延を抑えるため、ループ間隔を短縮する。
     vTaskDelay(pdMS_TO_TICKS(50));
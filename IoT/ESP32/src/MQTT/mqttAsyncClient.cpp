@@ -0,0 +1,921 @@
+/**
+ * @file mqttAsyncClient.cpp
+ * @brief 非同期 MQTT 3.1.1 クライアント中核の実装。
+ * @details
+ * - [重要] 送信キューはバイト単位のリングバッファで、通信路が一部しか受理しなくても続きから書き込む。
+ *   パケット境界は持たないため、切断時は送信キューごと破棄し、QoS1 は送信窓のコピーから積み直す。
+ * - [重要] 受信は `mqttPacketParser` で組み立てる。本体が1断片に収まる場合はコピーせずに渡す。
+ * - [厳守] 本ファイルは Arduino / FreeRTOS に依存しない（`makeArduinoClientTransport` を除く）。
+ *   ホストでは `tools/fleetSimulator/hostShim` を include パスへ加えてビルドする。
+ */
+
+#include "mqttAsyncClient.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+#if defined(ESP_PLATFORM)
+#include <Client.h>
+#endif
+
+namespace {
+
+/** @brief Remaining Length の最大値（4byte 可変長整数）。 */
+constexpr uint32_t kMaxRemainingLength = 268435455UL;
+/** @brief `poll()` 1回あたりの最大 read 回数。受信が続いても送信とタイムアウト判定へ戻る。 */
+constexpr uint8_t kMaxReadsPerPoll = 8;
+/** @brief 1回の read で使う一時バッファ長。 */
+constexpr size_t kReadChunkBytes = 256;
+/** @brief PUBLISH 固定ヘッダーの DUP フラグ。 */
+constexpr uint8_t kPublishDupFlag = 0x08;
+/** @brief PUBLISH 固定ヘッダーの retain フラグ。 */
+constexpr uint8_t kPublishRetainFlag = 0x01;
+
+/**
+ * @brief Remaining Length を可変長整数へ符号化する。
+ * @param remainingLength 値。
+ * @param encodedOut 出力先（4byte以上）。
+ * @return 出力 byte 数（1..4）。
+ */
+size_t encodeRemainingLength(uint32_t remainingLength, uint8_t* encodedOut) {
+  size_t encodedLength = 0;
+  do {
+    uint8_t encodedByte = static_cast<uint8_t>(remainingLength % 128);
+    remainingLength /= 128;
+    if (remainingLength > 0) {
+      encodedByte |= 0x80;
+    }
+    encodedOut[encodedLength++] = encodedByte;
+  } while (remainingLength > 0 && encodedLength < 4);
+  return encodedLength;
+}
+
+/** @brief Remaining Length の符号化長を返す。 */
+size_t remainingLengthSize(uint32_t remainingLength) {
+  if (remainingLength < 128UL) {
+    return 1;
+  }
+  if (remainingLength < 16384UL) {
+    return 2;
+  }
+  if (remainingLength < 2097152UL) {
+    return 3;
+  }
+  return 4;
+}
+
+/** @brief 16bit 値をビッグエンディアンで書き込み、次の位置を返す。 */
+uint8_t* writeUint16(uint8_t* cursor, uint16_t value) {
+  cursor[0] = static_cast<uint8_t>(value >> 8);
+  cursor[1] = static_cast<uint8_t>(value & 0xFF);
+  return cursor + 2;
+}
+
+/** @brief 16bit 値をビッグエンディアンで読む。 */
+uint16_t readUint16(const uint8_t* cursor) {
+  return static_cast<uint16_t>((static_cast<uint16_t>(cursor[0]) << 8) | cursor[1]);
+}
+
+/** @brief 長さ付き文字列（2byte長 + 本体）のサイズを返す。null は 0 とみなす。 */
+size_t lengthPrefixedSize(const char* text) {
+  return 2 + (text == nullptr ? 0 : strlen(text));
+}
+
+#if defined(ESP_PLATFORM)
+int32_t arduinoClientWrite(void* context, const uint8_t* data, size_t length) {
+  Client* client = static_cast<Client*>(context);
+  if (!client->connected()) {
+    return -1;
+  }
+  const size_t writtenLength = client->write(data, length);
+  if (writtenLength == 0 && !client->connected()) {
+    return -1;
+  }
+  return static_cast<int32_t>(writtenLength);
+}
+
+int32_t arduinoClientRead(void* context, uint8_t* bufferOut, size_t capacity) {
+  Client* client = static_cast<Client*>(context);
+  const int availableLength = client->available();
+  if (availableLength <= 0) {
+    return client->connected() ? 0 : -1;
+  }
+  const size_t readLength = static_cast<size_t>(availableLength) < capacity ? static_cast<size_t>(availableLength)
+                                                                            : capacity;
+  const int readResult = client->read(bufferOut, readLength);
+  if (readResult < 0) {
+    return client->connected() ? 0 : -1;
+  }
+  return static_cast<int32_t>(readResult);
+}
+#endif
+
+}  // namespace
+
+namespace mqttAsync {
+
+#if defined(ESP_PLATFORM)
+mqttTransport makeArduinoClientTransport(Client* client) {
+  mqttTransport transport = {};
+  transport.context = client;
+  transport.write = arduinoClientWrite;
+  transport.read = arduinoClientRead;
+  return transport;
+}
+#endif
+
+mqttAsyncClientConfig getDefaultMqttAsyncClientConfig() {
+  mqttAsyncClientConfig config = {};
+  config.sendQueueBytes = 8192;
+  config.maxIncomingPacketBytes = 4096;
+  config.inflightWindow = 8;
+  config.keepAliveSeconds = 60;
+  // TCP 1セグメント相当。TLS でも1レコードの暗号化・送信で戻る。
+  config.maxWriteBytesPerPoll = 1460;
+  config.connackTimeoutMs = 10000;
+  return config;
+}
+
+// ---------------------------------------------------------------------------
+// mqttPacketParser
+// ---------------------------------------------------------------------------
+
+mqttPacketParser::~mqttPacketParser() {
+  free(bodyBuffer_);
+}
+
+bool mqttPacketParser::initialize(size_t maxPacketBodyBytes) {
+  if (bodyBuffer_ != nullptr) {
+    appLogError("mqttPacketParser::initialize failed. already initialized.");
+    return false;
+  }
+  if (maxPacketBodyBytes == 0 || maxPacketBodyBytes > kMaxRemainingLength) {
+    appLogError("mqttPacketParser::initialize failed. invalid maxPacketBodyBytes=%lu",
+                static_cast<unsigned long>(maxPacketBodyBytes));
+    return false;
+  }
+  bodyBuffer_ = static_cast<uint8_t*>(malloc(maxPacketBodyBytes));
+  if (bodyBuffer_ == nullptr) {
+    appLogError("mqttPacketParser::initialize failed. malloc(%lu) returned null.",
+                static_cast<unsigned long>(maxPacketBodyBytes));
+    return false;
+  }
+  bodyCapacity_ = maxPacketBodyBytes;
+  reset();
+  return true;
+}
+
+void mqttPacketParser::reset() {
+  stage_ = parseStage::kHeader;
+  headerByte_ = 0;
+  remainingLength_ = 0;
+  remainingLengthMultiplier_ = 1;
+  remainingLengthBytes_ = 0;
+  bodyReceived_ = 0;
+}
+
+bool mqttPacketParser::feed(const uint8_t* data, size_t length, packetHandler handler, void* context) {
+  if (stage_ == parseStage::kError) {
+    return false;
+  }
+  if ((data == nullptr && length > 0) || handler == nullptr || bodyBuffer_ == nullptr) {
+    appLogError("mqttPacketParser::feed failed. invalid argument or not initialized.");
+    stage_ = parseStage::kError;
+    return false;
+  }
+
+  size_t offset = 0;
+  while (offset < length) {
+    switch (stage_) {
+      case parseStage::kHeader:
+        headerByte_ = data[offset++];
+        remainingLength_ = 0;
+        remainingLengthMultiplier_ = 1;
+        remainingLengthBytes_ = 0;
+        stage_ = parseStage::kRemainingLength;
+        break;
+
+      case parseStage::kRemainingLength: {
+        const uint8_t encodedByte = data[offset++];
+        remainingLength_ += static_cast<uint32_t>(encodedByte & 0x7F) * remainingLengthMultiplier_;
+        remainingLengthMultiplier_ *= 128;
+        ++remainingLengthBytes_;
+        if ((encodedByte & 0x80) != 0) {
+          if (remainingLengthBytes_ >= 4) {
+            appLogError("mqttPacketParser::feed failed. remaining length exceeds 4 bytes.");
+            stage_ = parseStage::kError;
+            return false;
+          }
+          break;
+        }
+        if (remainingLength_ > bodyCapacity_) {
+          appLogError("mqttPacketParser::feed failed. packet too large. type=%u remainingLength=%lu limit=%lu",
+                      static_cast<unsigned>(headerByte_ >> 4), static_cast<unsigned long>(remainingLength_),
+                      static_cast<unsigned long>(bodyCapacity_));
+          stage_ = parseStage::kError;
+          return false;
+        }
+        if (remainingLength_ == 0) {
+          const mqttPacketView packet = {headerByte_, bodyBuffer_, 0};
+          stage_ = parseStage::kHeader;
+          handler(context, packet);
+          break;
+        }
+        bodyReceived_ = 0;
+        stage_ = parseStage::kBody;
+        break;
+      }
+
+      case parseStage::kBody: {
+        const size_t availableLength = length - offset;
+        const size_t neededLength = remainingLength_ - bodyReceived_;
+        // 本体全体が断片内にある場合は受信バッファへ移さずに渡す。
+        if (bodyReceived_ == 0 && availableLength >= neededLength) {
+          const mqttPacketView packet = {headerByte_, data + offset, neededLength};
+          offset += neededLength;
+          stage_ = parseStage::kHeader;
+          handler(context, packet);
+          break;
+        }
+        const size_t copyLength = availableLength < neededLength ? availableLength : neededLength;
+        memcpy(bodyBuffer_ + bodyReceived_, data + offset, copyLength);
+        bodyReceived_ += copyLength;
+        offset += copyLength;
+        if (bodyReceived_ == remainingLength_) {
+          const mqttPacketView packet = {headerByte_, bodyBuffer_, remainingLength_};
+          stage_ = parseStage::kHeader;
+          handler(context, packet);
+        }
+        break;
+      }
+
+      case parseStage::kError:
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// mqttAsyncClient
+// ---------------------------------------------------------------------------
+
+mqttAsyncClient::~mqttAsyncClient() {
+  for (uint8_t index = 0; index < kMaxInflightWindow; ++index) {
+    free(inflight_[index].packet);
+  }
+  free(sendQueue_);
+}
+
+bool mqttAsyncClient::initialize(const mqttAsyncClientConfig& config) {
+  if (isInitialized_) {
+    appLogError("mqttAsyncClient::initialize failed. already initialized.");
+    return false;
+  }
+  if (config.sendQueueBytes <= kControlReserveBytes || config.inflightWindow == 0 ||
+      config.inflightWindow > kMaxInflightWindow || config.maxWriteBytesPerPoll == 0) {
+    appLogError("mqttAsyncClient::initialize failed. invalid config. sendQueueBytes=%lu inflightWindow=%u "
+                "maxWriteBytesPerPoll=%lu",
+                static_cast<unsigned long>(config.sendQueueBytes), static_cast<unsigned>(config.inflightWindow),
+                static_cast<unsigned long>(config.maxWriteBytesPerPoll));
+    return false;
+  }
+  if (!parser_.initialize(config.maxIncomingPacketBytes)) {
+    appLogError("mqttAsyncClient::initialize failed. parser initialize returned false.");
+    return false;
+  }
+  sendQueue_ = static_cast<uint8_t*>(malloc(config.sendQueueBytes));
+  if (sendQueue_ == nullptr) {
+    appLogError("mqttAsyncClient::initialize failed. malloc(%lu) returned null.",
+                static_cast<unsigned long>(config.sendQueueBytes));
+    return false;
+  }
+  config_ = config;
+  sendQueueCapacity_ = config.sendQueueBytes;
+  sendQueueHead_ = 0;
+  sendQueueUsed_ = 0;
+  isInitialized_ = true;
+  return true;
+}
+
+void mqttAsyncClient::setMessageHandler(messageHandler handler, void* context) {
+  messageHandler_ = handler;
+  messageHandlerContext_ = context;
+}
+
+void mqttAsyncClient::setPublishAckHandler(publishAckHandler handler, void* context) {
+  publishAckHandler_ = handler;
+  publishAckHandlerContext_ = context;
+}
+
+void mqttAsyncClient::setSubscribeAckHandler(subscribeAckHandler handler, void* context) {
+  subscribeAckHandler_ = handler;
+  subscribeAckHandlerContext_ = context;
+}
+
+bool mqttAsyncClient::beginSession(const mqttTransport& transport, const mqttConnectOptions& options, uint32_t nowMs) {
+  if (!isInitialized_) {
+    appLogError("mqttAsyncClient::beginSession failed. not initialized.");
+    return false;
+  }
+  if (transport.write == nullptr || transport.read == nullptr || options.clientId == nullptr) {
+    appLogError("mqttAsyncClient::beginSession failed. invalid argument.");
+    return false;
+  }
+  const bool hasWill = options.willTopic != nullptr;
+  const bool hasUserName = options.userName != nullptr && options.userName[0] != '\0';
+  const bool hasPassword = options.password != nullptr && options.password[0] != '\0';
+  const size_t stringLengths[] = {
+      strlen(options.clientId),
+      hasWill ? strlen(options.willTopic) : 0,
+      (hasWill && options.willPayload != nullptr) ? strlen(options.willPayload) : 0,
+      hasUserName ? strlen(options.userName) : 0,
+      hasPassword ? strlen(options.password) : 0,
+  };
+  for (size_t index = 0; index < sizeof(stringLengths) / sizeof(stringLengths[0]); ++index) {
+    if (stringLengths[index] > 0xFFFF) {
+      appLogError("mqttAsyncClient::beginSession failed. connect field too long. index=%lu",
+                  static_cast<unsigned long>(index));
+      return false;
+    }
+  }
+
+  if (hasTransport_) {
+    endSession();
+  }
+
+  // 可変ヘッダー: Protocol Name(6) + Level(1) + Flags(1) + Keep Alive(2)
+  size_t remainingLength = 10 + lengthPrefixedSize(options.clientId);
+  uint8_t connectFlags = 0;
+  if (options.cleanSession) {
+    connectFlags |= 0x02;
+  }
+  if (hasWill) {
+    connectFlags |= 0x04;
+    connectFlags |= static_cast<uint8_t>(static_cast<uint8_t>(options.willQos) << 3);
+    if (options.willRetain) {
+      connectFlags |= 0x20;
+    }
+    remainingLength += lengthPrefixedSize(options.willTopic) + lengthPrefixedSize(options.willPayload);
+  }
+  if (hasUserName) {
+    connectFlags |= 0x80;
+    remainingLength += lengthPrefixedSize(options.userName);
+  }
+  if (hasPassword) {
+    connectFlags |= 0x40;
+    remainingLength += lengthPrefixedSize(options.password);
+  }
+  const size_t packetLength = 1 + remainingLengthSize(static_cast<uint32_t>(remainingLength)) + remainingLength;
+  if (packetLength > sendQueueCapacity_) {
+    appLogError("mqttAsyncClient::beginSession failed. connect packet too large. length=%lu",
+                static_cast<unsigned long>(packetLength));
+    return false;
+  }
+
+  transport_ = transport;
+  hasTransport_ = true;
+  state_ = mqttClientState::kAwaitingConnack;
+  isSessionPresent_ = false;
+  lastConnackReturnCode_ = 0xFF;
+  sessionStartedAtMs_ = nowMs;
+  lastSentAtMs_ = nowMs;
+
+  uint8_t fixedHeader[5] = {static_cast<uint8_t>(static_cast<uint8_t>(mqttPacketType::kConnect) << 4)};
+  const size_t fixedHeaderLength = 1 + encodeRemainingLength(static_cast<uint32_t>(remainingLength), fixedHeader + 1);
+  uint8_t variableHeader[10] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, connectFlags, 0, 0};
+  writeUint16(variableHeader + 8, config_.keepAliveSeconds);
+  enqueueBytes(fixedHeader, fixedHeaderLength, true);
+  enqueueBytes(variableHeader, sizeof(variableHeader), true);
+
+  const char* payloadFields[] = {
+      options.clientId,
+      hasWill ? options.willTopic : nullptr,
+      hasWill ? (options.willPayload != nullptr ? options.willPayload : "") : nullptr,
+      hasUserName ? options.userName : nullptr,
+      hasPassword ? options.password : nullptr,
+  };
+  for (size_t index = 0; index < sizeof(payloadFields) / sizeof(payloadFields[0]); ++index) {
+    if (payloadFields[index] == nullptr) {
+      continue;
+    }
+    const size_t fieldLength = strlen(payloadFields[index]);
+    uint8_t lengthBytes[2];
+    writeUint16(lengthBytes, static_cast<uint16_t>(fieldLength));
+    enqueueBytes(lengthBytes, sizeof(lengthBytes), true);
+    enqueueBytes(reinterpret_cast<const uint8_t*>(payloadFields[index]), fieldLength, true);
+  }
+  appLogInfo("mqttAsyncClient::beginSession. clientId=%s cleanSession=%d keepAlive=%u inflight=%u",
+             options.clientId, options.cleanSession ? 1 : 0, static_cast<unsigned>(config_.keepAliveSeconds),
+             static_cast<unsigned>(inflightCount_));
+  return true;
+}
+
+void mqttAsyncClient::endSession() {
+  hasTransport_ = false;
+  transport_ = {};
+  state_ = mqttClientState::kDisconnected;
+  sendQueueHead_ = 0;
+  sendQueueUsed_ = 0;
+  parser_.reset();
+  isPingOutstanding_ = false;
+  disconnectRequested_ = false;
+  protocolErrorPending_ = false;
+  for (uint8_t index = 0; index < kMaxInflightWindow; ++index) {
+    inflight_[index].isQueued = false;
+  }
+}
+
+bool mqttAsyncClient::requestDisconnect() {
+  if (!hasTransport_) {
+    return false;
+  }
+  if (!enqueueControlPacket(mqttPacketType::kDisconnect, 0, 0)) {
+    appLogWarn("mqttAsyncClient::requestDisconnect failed. send queue full.");
+    return false;
+  }
+  disconnectRequested_ = true;
+  return true;
+}
+
+mqttEnqueueResult mqttAsyncClient::publish(const char* topic,
+                                           const uint8_t* payload,
+                                           size_t payloadLength,
+                                           mqttQos qos,
+                                           bool retained,
+                                           uint16_t* packetIdOut) {
+  if (packetIdOut != nullptr) {
+    *packetIdOut = 0;
+  }
+  if (!isInitialized_ || topic == nullptr || (payload == nullptr && payloadLength > 0)) {
+    appLogError("mqttAsyncClient::publish failed. invalid argument or not initialized.");
+    return mqttEnqueueResult::kInvalidArgument;
+  }
+  const size_t topicLength = strlen(topic);
+  if (topicLength == 0 || topicLength > 0xFFFF || strpbrk(topic, "+#") != nullptr) {
+    appLogError("mqttAsyncClient::publish failed. invalid topic=%s", topic);
+    return mqttEnqueueResult::kInvalidArgument;
+  }
+  const size_t remainingLength = 2 + topicLength + (qos == mqttQos::kAtLeastOnce ? 2 : 0) + payloadLength;
+  const size_t packetLength = remainingLength > kMaxRemainingLength
+                                  ? SIZE_MAX
+                                  : 1 + remainingLengthSize(static_cast<uint32_t>(remainingLength)) + remainingLength;
+  if (packetLength > sendQueueCapacity_ - kControlReserveBytes) {
+    appLogError("mqttAsyncClient::publish failed. packet too large. topic=%s length=%lu limit=%lu", topic,
+                static_cast<unsigned long>(packetLength),
+                static_cast<unsigned long>(sendQueueCapacity_ - kControlReserveBytes));
+    return mqttEnqueueResult::kTooLarge;
+  }
+
+  uint8_t fixedHeader[5] = {static_cast<uint8_t>((static_cast<uint8_t>(mqttPacketType::kPublish) << 4) |
+                                                 (static_cast<uint8_t>(qos) << 1) |
+                                                 (retained ? kPublishRetainFlag : 0))};
+  const size_t fixedHeaderLength = 1 + encodeRemainingLength(static_cast<uint32_t>(remainingLength), fixedHeader + 1);
+  uint8_t topicLengthBytes[2];
+  writeUint16(topicLengthBytes, static_cast<uint16_t>(topicLength));
+
+  if (qos == mqttQos::kAtMostOnce) {
+    if (state_ != mqttClientState::kConnected) {
+      return mqttEnqueueResult::kNotConnected;
+    }
+    if (sendQueueFreeBytes() < packetLength + kControlReserveBytes) {
+      return mqttEnqueueResult::kQueueFull;
+    }
+    enqueueBytes(fixedHeader, fixedHeaderLength, false);
+    enqueueBytes(topicLengthBytes, sizeof(topicLengthBytes), false);
+    enqueueBytes(reinterpret_cast<const uint8_t*>(topic), topicLength, false);
+    if (payloadLength > 0) {
+      enqueueBytes(payload, payloadLength, false);
+    }
+    ++stats_.publishQueuedCount;
+    return mqttEnqueueResult::kQueued;
+  }
+
+  if (inflightCount_ >= config_.inflightWindow) {
+    return mqttEnqueueResult::kWindowFull;
+  }
+  inflightEntry* freeEntry = nullptr;
+  for (uint8_t index = 0; index < kMaxInflightWindow; ++index) {
+    if (!inflight_[index].isUsed) {
+      freeEntry = &inflight_[index];
+      break;
+    }
+  }
+  if (freeEntry == nullptr) {
+    return mqttEnqueueResult::kWindowFull;
+  }
+  uint8_t* packet = static_cast<uint8_t*>(malloc(packetLength));
+  if (packet == nullptr) {
+    appLogError("mqttAsyncClient::publish failed. malloc(%lu) returned null.", static_cast<unsigned long>(packetLength));
+    return mqttEnqueueResult::kQueueFull;
+  }
+  const uint16_t packetId = allocatePacketId();
+  uint8_t* cursor = packet;
+  memcpy(cursor, fixedHeader, fixedHeaderLength);
+  cursor += fixedHeaderLength;
+  cursor = writeUint16(cursor, static_cast<uint16_t>(topicLength));
+  memcpy(cursor, topic, topicLength);
+  cursor += topicLength;
+  cursor = writeUint16(cursor, packetId);
+  if (payloadLength > 0) {
+    memcpy(cursor, payload, payloadLength);
+  }
+
+  freeEntry->isUsed = true;
+  freeEntry->isQueued = false;
+  freeEntry->wasSent = false;
+  freeEntry->packetId = packetId;
+  freeEntry->sequence = nextSequence_++;
+  freeEntry->packet = packet;
+  freeEntry->packetLength = packetLength;
+  ++inflightCount_;
+  ++stats_.publishQueuedCount;
+  if (inflightCount_ > stats_.maxInflightCount) {
+    stats_.maxInflightCount = inflightCount_;
+  }
+  if (packetIdOut != nullptr) {
+    *packetIdOut = packetId;
+  }
+  if (state_ == mqttClientState::kConnected) {
+    queueInflightPackets();
+  }
+  return mqttEnqueueResult::kQueued;
+}
+
+mqttEnqueueResult mqttAsyncClient::subscribe(const char* topicFilter, mqttQos qos, uint16_t* packetIdOut) {
+  if (packetIdOut != nullptr) {
+    *packetIdOut = 0;
+  }
+  if (!isInitialized_ || topicFilter == nullptr) {
+    appLogError("mqttAsyncClient::subscribe failed. invalid argument or not initialized.");
+    return mqttEnqueueResult::kInvalidArgument;
+  }
+  const size_t filterLength = strlen(topicFilter);
+  if (filterLength == 0 || filterLength > 0xFFFF) {
+    appLogError("mqttAsyncClient::subscribe failed. invalid topicFilter length=%lu",
+                static_cast<unsigned long>(filterLength));
+    return mqttEnqueueResult::kInvalidArgument;
+  }
+  if (state_ != mqttClientState::kConnected) {
+    return mqttEnqueueResult::kNotConnected;
+  }
+  const size_t remainingLength = 2 + 2 + filterLength + 1;
+  const size_t packetLength = 1 + remainingLengthSize(static_cast<uint32_t>(remainingLength)) + remainingLength;
+  if (packetLength > sendQueueCapacity_ - kControlReserveBytes) {
+    return mqttEnqueueResult::kTooLarge;
+  }
+  if (sendQueueFreeBytes() < packetLength + kControlReserveBytes) {
+    return mqttEnqueueResult::kQueueFull;
+  }
+  const uint16_t packetId = allocatePacketId();
+  // SUBSCRIBE の固定ヘッダーフラグは 0b0010 固定（MQTT 3.1.1 3.8.1）。
+  uint8_t header[5 + 2 + 2] = {static_cast<uint8_t>((static_cast<uint8_t>(mqttPacketType::kSubscribe) << 4) | 0x02)};
+  size_t headerLength = 1 + encodeRemainingLength(static_cast<uint32_t>(remainingLength), header + 1);
+  writeUint16(header + headerLength, packetId);
+  headerLength += 2;
+  writeUint16(header + headerLength, static_cast<uint16_t>(filterLength));
+  headerLength += 2;
+  const uint8_t requestedQos = static_cast<uint8_t>(qos);
+  enqueueBytes(header, headerLength, false);
+  enqueueBytes(reinterpret_cast<const uint8_t*>(topicFilter), filterLength, false);
+  enqueueBytes(&requestedQos, 1, false);
+  if (packetIdOut != nullptr) {
+    *packetIdOut = packetId;
+  }
+  return mqttEnqueueResult::kQueued;
+}
+
+bool mqttAsyncClient::poll(uint32_t nowMs) {
+  if (!hasTransport_) {
+    return false;
+  }
+  if (!receiveFromTransport()) {
+    appLogWarn("mqttAsyncClient::poll. transport read failed. state=%u", static_cast<unsigned>(state_));
+    endSession();
+    return false;
+  }
+  if (protocolErrorPending_) {
+    endSession();
+    return false;
+  }
+
+  if (state_ == mqttClientState::kAwaitingConnack) {
+    if (nowMs - sessionStartedAtMs_ >= config_.connackTimeoutMs) {
+      appLogWarn("mqttAsyncClient::poll. connack timeout. timeoutMs=%lu",
+                 static_cast<unsigned long>(config_.connackTimeoutMs));
+      endSession();
+      return false;
+    }
+  } else if (state_ == mqttClientState::kConnected && config_.keepAliveSeconds > 0) {
+    const uint32_t keepAliveMs = static_cast<uint32_t>(config_.keepAliveSeconds) * 1000UL;
+    if (isPingOutstanding_) {
+      if (nowMs - pingSentAtMs_ >= keepAliveMs) {
+        appLogWarn("mqttAsyncClient::poll. pingresp timeout. keepAliveSeconds=%u",
+                   static_cast<unsigned>(config_.keepAliveSeconds));
+        endSession();
+        return false;
+      }
+    } else if (nowMs - lastSentAtMs_ >= keepAliveMs) {
+      if (enqueueControlPacket(mqttPacketType::kPingreq, 0, 0)) {
+        isPingOutstanding_ = true;
+        pingSentAtMs_ = nowMs;
+      }
+    }
+  }
+
+  if (state_ == mqttClientState::kConnected) {
+    queueInflightPackets();
+  }
+  if (!flushSendQueue(nowMs)) {
+    appLogWarn("mqttAsyncClient::poll. transport write failed. pending=%lu",
+               static_cast<unsigned long>(sendQueueUsed_));
+    endSession();
+    return false;
+  }
+  if (disconnectRequested_ && sendQueueUsed_ == 0) {
+    appLogInfo("mqttAsyncClient::poll. disconnect sent.");
+    endSession();
+    return false;
+  }
+  return true;
+}
+
+void mqttAsyncClient::onPacketParsed(void* context, const mqttPacketView& packet) {
+  static_cast<mqttAsyncClient*>(context)->handlePacket(packet);
+}
+
+void mqttAsyncClient::handlePacket(const mqttPacketView& packet) {
+  if (protocolErrorPending_) {
+    return;
+  }
+  if (state_ == mqttClientState::kAwaitingConnack && packet.type() != mqttPacketType::kConnack) {
+    markProtocolError("packet before connack");
+    return;
+  }
+  switch (packet.type()) {
+    case mqttPacketType::kConnack:
+      if (state_ != mqttClientState::kAwaitingConnack || packet.bodyLength != 2) {
+        markProtocolError("unexpected connack");
+        return;
+      }
+      lastConnackReturnCode_ = packet.body[1];
+      if (lastConnackReturnCode_ != 0) {
+        appLogError("mqttAsyncClient connack refused. returnCode=%u", static_cast<unsigned>(lastConnackReturnCode_));
+        protocolErrorPending_ = true;
+        return;
+      }
+      state_ = mqttClientState::kConnected;
+      isSessionPresent_ = (packet.body[0] & 0x01) != 0;
+      appLogInfo("mqttAsyncClient connected. sessionPresent=%u resend=%u", isSessionPresent_ ? 1U : 0U,
+                 static_cast<unsigned>(inflightCount_));
+      queueInflightPackets();
+      return;
+
+    case mqttPacketType::kPublish:
+      handleIncomingPublish(packet);
+      return;
+
+    case mqttPacketType::kPuback:
+      if (packet.bodyLength != 2) {
+        markProtocolError("invalid puback");
+        return;
+      }
+      handlePublishAck(readUint16(packet.body));
+      return;
+
+    case mqttPacketType::kPubrel:
+      // 受信 QoS2 の第2段。PUBLISH 受信時に配送済みのため PUBCOMP を返すだけでよい。
+      if (packet.bodyLength != 2) {
+        markProtocolError("invalid pubrel");
+        return;
+      }
+      if (!enqueueControlPacket(mqttPacketType::kPubcomp, 0, readUint16(packet.body))) {
+        ++stats_.controlDropCount;
+      }
+      return;
+
+    case mqttPacketType::kSuback:
+      if (packet.bodyLength < 3) {
+        markProtocolError("invalid suback");
+        return;
+      }
+      if (packet.body[2] == 0x80) {
+        appLogWarn("mqttAsyncClient suback failure. packetId=%u", static_cast<unsigned>(readUint16(packet.body)));
+      }
+      if (subscribeAckHandler_ != nullptr) {
+        subscribeAckHandler_(subscribeAckHandlerContext_, readUint16(packet.body), packet.body[2]);
+      }
+      return;
+
+    case mqttPacketType::kUnsuback:
+      return;
+
+    case mqttPacketType::kPingresp:
+      isPingOutstanding_ = false;
+      return;
+
+    default:
+      markProtocolError("unexpected packet type");
+      return;
+  }
+}
+
+void mqttAsyncClient::handleIncomingPublish(const mqttPacketView& packet) {
+  const uint8_t qos = static_cast<uint8_t>((packet.flags() >> 1) & 0x03);
+  if (qos > 2 || packet.bodyLength < 2) {
+    markProtocolError("invalid publish header");
+    return;
+  }
+  const size_t topicLength = readUint16(packet.body);
+  const size_t packetIdLength = qos > 0 ? 2 : 0;
+  if (packet.bodyLength < 2 + topicLength + packetIdLength) {
+    markProtocolError("invalid publish length");
+    return;
+  }
+  const uint8_t* cursor = packet.body + 2 + topicLength;
+  const uint16_t packetId = qos > 0 ? readUint16(cursor) : 0;
+  cursor += packetIdLength;
+
+  mqttIncomingMessage message = {};
+  message.topic = reinterpret_cast<const char*>(packet.body + 2);
+  message.topicLength = topicLength;
+  message.payload = cursor;
+  message.payloadLength = packet.bodyLength - (2 + topicLength + packetIdLength);
+  message.qos = qos;
+  message.retained = (packet.flags() & kPublishRetainFlag) != 0;
+  message.duplicate = (packet.flags() & kPublishDupFlag) != 0;
+  ++stats_.messageReceivedCount;
+  if (messageHandler_ != nullptr) {
+    messageHandler_(messageHandlerContext_, message);
+  }
+
+  if (qos == 1) {
+    if (!enqueueControlPacket(mqttPacketType::kPuback, 0, packetId)) {
+      ++stats_.controlDropCount;
+    }
+  } else if (qos == 2) {
+    if (!enqueueControlPacket(mqttPacketType::kPubrec, 0, packetId)) {
+      ++stats_.controlDropCount;
+    }
+  }
+}
+
+void mqttAsyncClient::handlePublishAck(uint16_t packetId) {
+  for (uint8_t index = 0; index < kMaxInflightWindow; ++index) {
+    inflightEntry& entry = inflight_[index];
+    if (!entry.isUsed || entry.packetId != packetId) {
+      continue;
+    }
+    free(entry.packet);
+    entry = {};
+    --inflightCount_;
+    ++stats_.publishAckedCount;
+    if (publishAckHandler_ != nullptr) {
+      publishAckHandler_(publishAckHandlerContext_, packetId);
+    }
+    return;
+  }
+  // 再送と元送信の両方に PUBACK が来た場合などは該当なしになる。エラーにはしない。
+  appLogDebug("mqttAsyncClient puback for unknown packetId=%u", static_cast<unsigned>(packetId));
+}
+
+bool mqttAsyncClient::enqueueControlPacket(mqttPacketType type, uint8_t flags, uint16_t packetId) {
+  uint8_t packet[4] = {static_cast<uint8_t>((static_cast<uint8_t>(type) << 4) | flags), 0, 0, 0};
+  size_t packetLength = 2;
+  if (type != mqttPacketType::kPingreq && type != mqttPacketType::kDisconnect) {
+    packet[1] = 2;
+    writeUint16(packet + 2, packetId);
+    packetLength = 4;
+  }
+  return enqueueBytes(packet, packetLength, true);
+}
+
+bool mqttAsyncClient::enqueueBytes(const uint8_t* data, size_t length, bool useControlReserve) {
+  const size_t limit = useControlReserve ? sendQueueCapacity_ : sendQueueCapacity_ - kControlReserveBytes;
+  if (sendQueueUsed_ + length > limit) {
+    return false;
+  }
+  size_t tail = (sendQueueHead_ + sendQueueUsed_) % sendQueueCapacity_;
+  const size_t firstLength = (sendQueueCapacity_ - tail) < length ? (sendQueueCapacity_ - tail) : length;
+  memcpy(sendQueue_ + tail, data, firstLength);
+  if (firstLength < length) {
+    memcpy(sendQueue_, data + firstLength, length - firstLength);
+  }
+  sendQueueUsed_ += length;
+  if (sendQueueUsed_ > stats_.maxSendQueueUsedBytes) {
+    stats_.maxSendQueueUsedBytes = sendQueueUsed_;
+  }
+  return true;
+}
+
+void mqttAsyncClient::queueInflightPackets() {
+  // 送信順（sequence 昇順）に積む。先頭が入らなければ後続も積まず、順序を保つ。
+  while (true) {
+    inflightEntry* nextEntry = nullptr;
+    for (uint8_t index = 0; index < kMaxInflightWindow; ++index) {
+      inflightEntry& entry = inflight_[index];
+      if (entry.isUsed && !entry.isQueued &&
+          (nextEntry == nullptr || static_cast<int32_t>(entry.sequence - nextEntry->sequence) < 0)) {
+        nextEntry = &entry;
+      }
+    }
+    if (nextEntry == nullptr) {
+      return;
+    }
+    if (sendQueueFreeBytes() < nextEntry->packetLength + kControlReserveBytes) {
+      return;
+    }
+    // DUP=1 はブローカーが前回のセッション（packet id と受信済み状態）を保持している場合だけ付ける。
+    // 新規セッション（sessionPresent=0）では既送分も新規 PUBLISH として DUP=0 で送り直す。
+    const bool isDuplicate = nextEntry->wasSent && isSessionPresent_;
+    const uint8_t headerByte = static_cast<uint8_t>(nextEntry->packet[0] | (isDuplicate ? kPublishDupFlag : 0));
+    enqueueBytes(&headerByte, 1, false);
+    enqueueBytes(nextEntry->packet + 1, nextEntry->packetLength - 1, false);
+    if (nextEntry->wasSent) {
+      ++stats_.retransmitCount;
+    }
+    nextEntry->isQueued = true;
+    nextEntry->wasSent = true;
+  }
+}
+
+bool mqttAsyncClient::flushSendQueue(uint32_t nowMs) {
+  size_t writeBudget = config_.maxWriteBytesPerPoll;
+  while (sendQueueUsed_ > 0 && writeBudget > 0) {
+    size_t chunkLength = sendQueueCapacity_ - sendQueueHead_;
+    if (chunkLength > sendQueueUsed_) {
+      chunkLength = sendQueueUsed_;
+    }
+    if (chunkLength > writeBudget) {
+      chunkLength = writeBudget;
+    }
+    const int32_t writtenLength = transport_.write(transport_.context, sendQueue_ + sendQueueHead_, chunkLength);
+    if (writtenLength < 0) {
+      return false;
+    }
+    if (writtenLength == 0) {
+      break;
+    }
+    sendQueueHead_ = (sendQueueHead_ + static_cast<size_t>(writtenLength)) % sendQueueCapacity_;
+    sendQueueUsed_ -= static_cast<size_t>(writtenLength);
+    writeBudget -= static_cast<size_t>(writtenLength);
+    stats_.bytesSent += static_cast<uint64_t>(writtenLength);
+    lastSentAtMs_ = nowMs;
+  }
+  if (sendQueueUsed_ == 0) {
+    sendQueueHead_ = 0;
+  }
+  return true;
+}
+
+bool mqttAsyncClient::receiveFromTransport() {
+  uint8_t readBuffer[kReadChunkBytes];
+  for (uint8_t readIndex = 0; readIndex < kMaxReadsPerPoll; ++readIndex) {
+    const int32_t readLength = transport_.read(transport_.context, readBuffer, sizeof(readBuffer));
+    if (readLength < 0) {
+      return false;
+    }
+    if (readLength == 0) {
+      return true;
+    }
+    stats_.bytesReceived += static_cast<uint64_t>(readLength);
+    if (!parser_.feed(readBuffer, static_cast<size_t>(readLength), onPacketParsed, this)) {
+      markProtocolError("parser error");
+      return true;
+    }
+    if (protocolErrorPending_ || !hasTransport_) {
+      return true;
+    }
+  }
+  return true;
+}
+
+uint16_t mqttAsyncClient::allocatePacketId() {
+  while (true) {
+    ++lastPacketId_;
+    if (lastPacketId_ == 0) {
+      lastPacketId_ = 1;
+    }
+    bool isInUse = false;
+    for (uint8_t index = 0; index < kMaxInflightWindow; ++index) {
+      if (inflight_[index].isUsed && inflight_[index].packetId == lastPacketId_) {
+        isInUse = true;
+        break;
+      }
+    }
+    if (!isInUse) {
+      return lastPacketId_;
+    }
+  }
+}
+
+void mqttAsyncClient::markProtocolError(const char* reason) {
+  appLogError("mqttAsyncClient protocol error. reason=%s state=%u", reason, static_cast<unsigned>(state_));
+  ++stats_.protocolErrorCount;
+  protocolErrorPending_ = true;
+}
+
+}  // namespace mqttAsync
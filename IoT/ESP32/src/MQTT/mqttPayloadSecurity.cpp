@@ -9,86 +9,15 @@
 
 #include "mqttPayloadSecurity.h"
 
-#include <mbedtls/base64.h>
 #include <mbedtls/gcm.h>
 
+#include "base64Codec.h"
 #include "common.h"
 #include "jsonService.h"
 #include "log.h"
 
 namespace {
 
-bool decodeBase64Text(const String& inputBase64, std::vector<uint8_t>* outputBufferOut) {
-  if (outputBufferOut == nullptr) {
-    appLogError("mqttPayloadSecurity::decodeBase64Text failed. outputBufferOut is null.");
-    return false;
-  }
-  outputBufferOut->clear();
-  size_t outputLength = 0;
-  int32_t firstResult = mbedtls_base64_decode(nullptr,
-                                              0,
-                                              &outputLength,
-                                              reinterpret_cast<const unsigned char*>(inputBase64.c_str()),
-                                              inputBase64.length());
-  if (firstResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && firstResult != 0) {
-    appLogError("mqttPayloadSecurity::decodeBase64Text failed. probe decode result=%ld inputLength=%ld",
-                static_cast<long>(firstResult),
-                static_cast<long>(inputBase64.length()));
-    return false;
-  }
-  outputBufferOut->resize(outputLength);
-  if (outputLength == 0) {
-    return true;
-  }
-  int32_t secondResult = mbedtls_base64_decode(outputBufferOut->data(),
-                                               outputBufferOut->size(),
-                                               &outputLength,
-                                               reinterpret_cast<const unsigned char*>(inputBase64.c_str()),
-                                               inputBase64.length());
-  if (secondResult != 0) {
-    appLogError("mqttPayloadSecurity::decodeBase64Text failed. decode result=%ld inputLength=%ld",
-                static_cast<long>(secondResult),
-                static_cast<long>(inputBase64.length()));
-    outputBufferOut->clear();
-    return false;
-  }
-  outputBufferOut->resize(outputLength);
-  return true;
-}
-
-bool encodeBase64Text(const std::vector<uint8_t>& inputBuffer, String* outputBase64Out) {
-  if (outputBase64Out == nullptr) {
-    appLogError("mqttPayloadSecurity::encodeBase64Text failed. outputBase64Out is null.");
-    return false;
-  }
-  size_t encodedLength = 0;
-  int32_t probeResult = mbedtls_base64_encode(nullptr, 0, &encodedLength, inputBuffer.data(), inputBuffer.size());
-  if (probeResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && probeResult != 0) {
-    appLogError("mqttPayloadSecurity::encodeBase64Text failed. probe result=%ld inputSize=%ld",
-                static_cast<long>(probeResult),
-                static_cast<long>(inputBuffer.size()));
-    return false;
-  }
-  std::vector<uint8_t> outputBytes(encodedLength + 1, 0);
-  int32_t encodeResult = mbedtls_base64_encode(outputBytes.data(),
-                                               outputBytes.size(),
-                                               &encodedLength,
-                                               inputBuffer.data(),
-                                               inputBuffer.size());
-  if (encodeResult != 0) {
-    appLogError("mqttPayloadSecurity::encodeBase64Text failed. encode result=%ld inputSize=%ld",
-                static_cast<long>(encodeResult),
-                static_cast<long>(inputBuffer.size()));
-    return false;
-  }
-  outputBase64Out->reserve(encodedLength);
-  outputBase64Out->remove(0);
-  for (size_t index = 0; index < encodedLength; ++index) {
-    *outputBase64Out += static_cast<char>(outputBytes[index]);
-  }
-  return true;
-}
-
 bool decryptAesGcm(const std::vector<uint8_t>& keyBytes,
                    const std::vector<uint8_t>& ivBytes,
                    const std::vector<uint8_t>& cipherBytes,
@@ -203,9 +132,9 @@ bool encodeEncryptedEnvelope(const std::vector<uint8_t>& keyBytes,
   String ivBase64;
   String cipherBase64;
   String tagBase64;
-  if (!encodeBase64Text(ivBytes, &ivBase64) ||
-      !encodeBase64Text(cipherBytes, &cipherBase64) ||
-      !encodeBase64Text(tagBytes, &tagBase64)) {
+  if (!base64Codec::encodeToText(ivBytes, &ivBase64) ||
+      !base64Codec::encodeToText(cipherBytes, &cipherBase64) ||
+      !base64Codec::encodeToText(tagBytes, &tagBase64)) {
     return false;
   }
   String payloadOut = "{}";
@@ -261,7 +190,8 @@ bool decodeEncryptedEnvelopeIfPresent(const std::vector<uint8_t>& keyBytes,
   std::vector<uint8_t> ivBytes;
   std::vector<uint8_t> cipherBytes;
   std::vector<uint8_t> tagBytes;
-  if (!decodeBase64Text(ivBase64, &ivBytes) || !decodeBase64Text(cipherBase64, &cipherBytes) || !decodeBase64Text(tagBase64, &tagBytes)) {
+  if (!base64Codec::decodeToBytes(ivBase64, &ivBytes) || !base64Codec::decodeToBytes(cipherBase64, &cipherBytes) ||
+      !base64Codec::decodeToBytes(tagBase64, &tagBytes)) {
     return false;
   }
   if (!decryptAesGcm(keyBytes, ivBytes, cipherBytes, tagBytes, plainPayloadOut)) {
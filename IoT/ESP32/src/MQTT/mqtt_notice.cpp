@@ -0,0 +1,123 @@
+/**
+ * @file mqtt_notice.cpp
+ * @brief MQTT notice（trh / fileSyncStatus）のpayload生成処理。
+ * @details
+ * - [重要] 接続状態・ノード名解決・暗号化・送信は呼び出し側（mqtt.cpp）が担当し、ここではpayload文字列だけを組み立てる。
+ * - [重要] ホストの fleetSimulator も同じ関数をリンクして使うため、FreeRTOS/WiFi/時刻取得には依存しない。
+ * - [推奨] キー構成を変更した場合は LocalServer 側の受信処理と合わせて更新する。
+ */
+
+#include "mqttMessages.h"
+
+#include <cJSON.h>
+
+#include "common.h"
+#include "jsonService.h"
+#include "log.h"
+
+namespace mqtt {
+
+bool buildTrhNoticePayload(const char* sourceId,
+                           const char* destinationId,
+                           const char* messageId,
+                           const char* timestampText,
+                           bool isSuccess,
+                           const char* detailText,
+                           const trhNoticeReading& reading,
+                           String* payloadTextOut) {
+  if (payloadTextOut == nullptr) {
+    appLogError("mqtt::buildTrhNoticePayload failed. payloadTextOut is null.");
+    return false;
+  }
+  if (sourceId == nullptr || messageId == nullptr) {
+    appLogError("mqtt::buildTrhNoticePayload failed. sourceId or messageId is null.");
+    return false;
+  }
+
+  cJSON* rootObject = cJSON_CreateObject();
+  if (rootObject == nullptr) {
+    appLogError("mqtt::buildTrhNoticePayload failed. cJSON_CreateObject returned null.");
+    return false;
+  }
+
+  cJSON_AddStringToObject(rootObject, "v", "1");
+  cJSON_AddStringToObject(rootObject, "DstID", (destinationId != nullptr && destinationId[0] != '\0') ? destinationId : "all");
+  cJSON_AddStringToObject(rootObject, "SrcID", sourceId);
+  cJSON_AddStringToObject(rootObject, "Request", "Notice");
+  cJSON_AddStringToObject(rootObject, "id", messageId);
+  cJSON_AddStringToObject(rootObject, "ts", timestampText == nullptr ? "" : timestampText);
+  cJSON_AddStringToObject(rootObject, "op", "notice");
+  cJSON_AddStringToObject(rootObject, "sub", iotCommon::mqtt::subCommand::notice::kTrh);
+  cJSON_AddStringToObject(rootObject, "Res", isSuccess ? iotCommon::mqtt::responseResult::kOk
+                                                       : iotCommon::mqtt::responseResult::kNg);
+  cJSON_AddStringToObject(rootObject, "detail", detailText == nullptr ? "" : detailText);
+
+  cJSON* argsObject = cJSON_AddObjectToObject(rootObject, "args");
+  if (argsObject == nullptr) {
+    cJSON_Delete(rootObject);
+    appLogError("mqtt::buildTrhNoticePayload failed. cJSON_AddObjectToObject(args) returned null.");
+    return false;
+  }
+  cJSON_AddStringToObject(argsObject, "sensorId", "bme280-1");
+  char sensorAddressText[8] = {};
+  snprintf(sensorAddressText, sizeof(sensorAddressText), "0x%02X", static_cast<unsigned>(reading.sensorAddress));
+  cJSON_AddStringToObject(argsObject, "sensorAddress", sensorAddressText);
+  if (isSuccess) {
+    cJSON_AddNumberToObject(argsObject, "temperatureC", static_cast<double>(reading.temperatureC));
+    cJSON_AddNumberToObject(argsObject, "humidityRh", static_cast<double>(reading.humidityRh));
+    cJSON_AddNumberToObject(argsObject, "pressureHpa", static_cast<double>(reading.pressureHpa));
+  }
+
+  char* serializedPayload = cJSON_PrintUnformatted(rootObject);
+  cJSON_Delete(rootObject);
+  if (serializedPayload == nullptr) {
+    appLogError("mqtt::buildTrhNoticePayload failed. cJSON_PrintUnformatted returned null.");
+    return false;
+  }
+  *payloadTextOut = String(serializedPayload);
+  cJSON_free(serializedPayload);
+  return true;
+}
+
+bool buildFileSyncStatusPayload(const char* sourceId,
+                                const char* destinationId,
+                                const char* messageId,
+                                const char* sessionId,
+                                const char* targetArea,
+                                const char* phase,
+                                const char* result,
+                                const char* detail,
+                                const char* errorCode,
+                                String* payloadTextOut) {
+  if (payloadTextOut == nullptr) {
+    appLogError("mqtt::buildFileSyncStatusPayload failed. payloadTextOut is null.");
+    return false;
+  }
+  if (sourceId == nullptr || messageId == nullptr) {
+    appLogError("mqtt::buildFileSyncStatusPayload failed. sourceId or messageId is null.");
+    return false;
+  }
+
+  jsonService payloadJsonService;
+  jsonKeyValueItem itemList[] = {
+      {"v", jsonValueType::kString, iotCommon::kProtocolVersion, 0, 0, false},
+      {"DstID", jsonValueType::kString, (destinationId != nullptr && destinationId[0] != '\0') ? destinationId : "all", 0, 0, false},
+      {"SrcID", jsonValueType::kString, sourceId, 0, 0, false},
+      {"Request", jsonValueType::kString, "Notice", 0, 0, false},
+      {"id", jsonValueType::kString, messageId, 0, 0, false},
+      {"sub", jsonValueType::kString, iotCommon::mqtt::subCommand::notice::kFileSyncStatus, 0, 0, false},
+      {"sessionId", jsonValueType::kString, sessionId == nullptr ? "" : sessionId, 0, 0, false},
+      {"targetArea", jsonValueType::kString, targetArea == nullptr ? "" : targetArea, 0, 0, false},
+      {"phase", jsonValueType::kString, phase == nullptr ? "" : phase, 0, 0, false},
+      {"result", jsonValueType::kString, result == nullptr ? "" : result, 0, 0, false},
+      {"detail", jsonValueType::kString, detail == nullptr ? "" : detail, 0, 0, false},
+      {"errorCode", jsonValueType::kString, errorCode == nullptr ? "" : errorCode, 0, 0, false},
+  };
+  if (!payloadJsonService.setValuesByPath(payloadTextOut, itemList, sizeof(itemList) / sizeof(itemList[0]))) {
+    appLogError("mqtt::buildFileSyncStatusPayload failed. setValuesByPath failed.");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace mqtt
@@ -17,6 +17,7 @@
 #include "firmwareInfo.h"
 #include "jsonService.h"
 #include "log.h"
+#include "taskPlacement.h"
 #include "version.h"
 
 namespace {
@@ -490,6 +491,16 @@ bool buildMqttStatusPayload(const char* subName,
     appLogError("mqtt::buildMqttStatusPayload failed. setValuesByPath failed.");
     return false;
   }
+  taskPlacement::cpuLoadSnapshot cpuLoad{};
+  if (taskPlacement::getCpuLoadSnapshot(&cpuLoad)) {
+    jsonKeyValueItem cpuLoadItemList[] = {
+        {iotCommon::mqtt::jsonKey::status::kCpuLoadCore0, jsonValueType::kLong, nullptr, 0, static_cast<long>(cpuLoad.loadPercent[0]), false},
+        {iotCommon::mqtt::jsonKey::status::kCpuLoadCore1, jsonValueType::kLong, nullptr, 0, static_cast<long>(cpuLoad.loadPercent[1]), false},
+    };
+    if (!payloadJsonService.setValuesByPath(&payloadText, cpuLoadItemList, sizeof(cpuLoadItemList) / sizeof(cpuLoadItemList[0]))) {
+      appLogWarn("mqtt::buildMqttStatusPayload: cpu load items were not added. setValuesByPath failed.");
+    }
+  }
 
   *payloadTextOut = payloadText;
   return true;
@@ -0,0 +1,416 @@
+/**
+ * @file base64Codec.cpp
+ * @brief Base64 の共通符号化/復号の実装。
+ * @details
+ * - [重要] 復号表は 4 文字の位置ごとに桁をずらした値（1KB × 4）を持ち、4 回の表引きと OR で 24bit を得る。
+ *   不正文字・'='・空白の表値は bit24 を立てておき、OR 結果の bit24 だけで逐次処理への切替えを判定する。
+ * - [重要] 表は constexpr で生成し、RAM ではなくフラッシュ（rodata）へ置く。
+ */
+
+#include "base64Codec.h"
+
+#include "log.h"
+
+namespace {
+
+/** @brief 符号化アルファベット。@type const char[] */
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+/** @brief 文字種: 不正文字。@type uint8_t */
+constexpr uint8_t kSymbolInvalid = 0xFF;
+/** @brief 文字種: パディング '='。@type uint8_t */
+constexpr uint8_t kSymbolPadding = 0xFE;
+/** @brief 文字種: 読み飛ばす空白。@type uint8_t */
+constexpr uint8_t kSymbolSpace = 0xFD;
+/** @brief 復号表で「高速処理できない文字」を表す bit。@type uint32_t */
+constexpr uint32_t kGroupNotFastBit = 0x01000000UL;
+/** @brief encodeToText が1回に積む文字数（4 の倍数）。@type size_t */
+constexpr size_t kEncodeChunkChars = 256;
+
+/**
+ * @brief 1 文字の文字種（0〜63 の値、または kSymbol*）を返す。
+ */
+constexpr uint8_t toSymbol(uint8_t character) {
+  if (character >= 'A' && character <= 'Z') {
+    return static_cast<uint8_t>(character - 'A');
+  }
+  if (character >= 'a' && character <= 'z') {
+    return static_cast<uint8_t>(character - 'a' + 26);
+  }
+  if (character >= '0' && character <= '9') {
+    return static_cast<uint8_t>(character - '0' + 52);
+  }
+  if (character == '+') {
+    return 62;
+  }
+  if (character == '/') {
+    return 63;
+  }
+  if (character == '=') {
+    return kSymbolPadding;
+  }
+  if (character == ' ' || character == '\t' || character == '\r' || character == '\n') {
+    return kSymbolSpace;
+  }
+  return kSymbolInvalid;
+}
+
+/**
+ * @brief 復号表一式。
+ */
+struct decodeTables {
+  /** @brief 文字種表。@type uint8_t[] */
+  uint8_t symbol[256];
+  /** @brief 組の1文字目（<<18）。@type uint32_t[] */
+  uint32_t shift18[256];
+  /** @brief 組の2文字目（<<12）。@type uint32_t[] */
+  uint32_t shift12[256];
+  /** @brief 組の3文字目（<<6）。@type uint32_t[] */
+  uint32_t shift6[256];
+  /** @brief 組の4文字目。@type uint32_t[] */
+  uint32_t shift0[256];
+};
+
+constexpr decodeTables buildDecodeTables() {
+  decodeTables tables = {};
+  for (uint32_t character = 0; character < 256; ++character) {
+    const uint8_t symbol = toSymbol(static_cast<uint8_t>(character));
+    tables.symbol[character] = symbol;
+    const bool isValue = symbol < 64;
+    tables.shift18[character] = isValue ? (static_cast<uint32_t>(symbol) << 18) : kGroupNotFastBit;
+    tables.shift12[character] = isValue ? (static_cast<uint32_t>(symbol) << 12) : kGroupNotFastBit;
+    tables.shift6[character] = isValue ? (static_cast<uint32_t>(symbol) << 6) : kGroupNotFastBit;
+    tables.shift0[character] = isValue ? static_cast<uint32_t>(symbol) : kGroupNotFastBit;
+  }
+  return tables;
+}
+
+/** @brief 復号表。@type decodeTables */
+constexpr decodeTables kDecodeTables = buildDecodeTables();
+
+/**
+ * @brief 空白・パディングを含まない 4 文字の組を、続く限りまとめて復号する。
+ * @return 消費した文字数（4 の倍数）。出力長は消費文字数の 3/4。
+ * @details
+ * - [重要] 組ごとに 4 文字を読んでから 3 byte を書くため、bytesOut が text と同じ位置から始まっても安全。
+ */
+size_t decodeFastGroups(const uint8_t* text, size_t textLength, uint8_t* bytesOut, size_t bytesCapacity) {
+  size_t groupCount = textLength / 4U;
+  const size_t capacityGroupCount = bytesCapacity / 3U;
+  groupCount = (groupCount < capacityGroupCount) ? groupCount : capacityGroupCount;
+  size_t groupIndex = 0;
+  for (; groupIndex < groupCount; ++groupIndex) {
+    const uint8_t* groupText = text + groupIndex * 4U;
+    const uint32_t groupBits = kDecodeTables.shift18[groupText[0]] | kDecodeTables.shift12[groupText[1]] |
+                               kDecodeTables.shift6[groupText[2]] | kDecodeTables.shift0[groupText[3]];
+    if ((groupBits & kGroupNotFastBit) != 0) {
+      break;
+    }
+    uint8_t* groupBytes = bytesOut + groupIndex * 3U;
+    groupBytes[0] = static_cast<uint8_t>(groupBits >> 16);
+    groupBytes[1] = static_cast<uint8_t>(groupBits >> 8);
+    groupBytes[2] = static_cast<uint8_t>(groupBits);
+  }
+  return groupIndex * 4U;
+}
+
+/**
+ * @brief 3 byte 単位の組をまとめて符号化する。
+ */
+void encodeFullGroups(const uint8_t* bytes, size_t groupCount, char* textOut) {
+  for (size_t groupIndex = 0; groupIndex < groupCount; ++groupIndex) {
+    const uint8_t* groupBytes = bytes + groupIndex * 3U;
+    const uint32_t groupBits = (static_cast<uint32_t>(groupBytes[0]) << 16) |
+                               (static_cast<uint32_t>(groupBytes[1]) << 8) | static_cast<uint32_t>(groupBytes[2]);
+    char* groupText = textOut + groupIndex * 4U;
+    groupText[0] = kAlphabet[(groupBits >> 18) & 0x3F];
+    groupText[1] = kAlphabet[(groupBits >> 12) & 0x3F];
+    groupText[2] = kAlphabet[(groupBits >> 6) & 0x3F];
+    groupText[3] = kAlphabet[groupBits & 0x3F];
+  }
+}
+
+/**
+ * @brief 1〜2 byte の端数をパディング付きの 4 文字へ符号化する。
+ */
+void encodeTailGroup(const uint8_t* bytes, size_t byteLength, char* textOut) {
+  const uint32_t groupBits = (static_cast<uint32_t>(bytes[0]) << 16) |
+                             ((byteLength > 1) ? (static_cast<uint32_t>(bytes[1]) << 8) : 0U);
+  textOut[0] = kAlphabet[(groupBits >> 18) & 0x3F];
+  textOut[1] = kAlphabet[(groupBits >> 12) & 0x3F];
+  textOut[2] = (byteLength > 1) ? kAlphabet[(groupBits >> 6) & 0x3F] : '=';
+  textOut[3] = '=';
+}
+
+}  // namespace
+
+base64StreamDecoder::base64StreamDecoder() {
+  reset();
+}
+
+void base64StreamDecoder::reset() {
+  groupBits_ = 0;
+  groupCharCount_ = 0;
+  groupPaddingCount_ = 0;
+  isPaddingSeen_ = false;
+  isFailed_ = false;
+}
+
+bool base64StreamDecoder::update(const char* text,
+                                 size_t textLength,
+                                 uint8_t* bytesOut,
+                                 size_t bytesCapacity,
+                                 size_t* byteLengthOut) {
+  if (byteLengthOut == nullptr) {
+    return false;
+  }
+  *byteLengthOut = 0;
+  if (isFailed_) {
+    return false;
+  }
+  if (textLength == 0) {
+    return true;
+  }
+  if (text == nullptr || bytesOut == nullptr) {
+    isFailed_ = true;
+    return false;
+  }
+  const uint8_t* inputText = reinterpret_cast<const uint8_t*>(text);
+  size_t textIndex = 0;
+  size_t writtenLength = 0;
+  while (textIndex < textLength) {
+    // 組の境目では表引きでまとめて進め、止まった位置から1文字ずつ処理する
+    if (groupCharCount_ == 0 && !isPaddingSeen_) {
+      const size_t consumedLength = decodeFastGroups(inputText + textIndex,
+                                                     textLength - textIndex,
+                                                     bytesOut + writtenLength,
+                                                     bytesCapacity - writtenLength);
+      textIndex += consumedLength;
+      writtenLength += (consumedLength / 4U) * 3U;
+      if (textIndex >= textLength) {
+        break;
+      }
+    }
+    const uint8_t symbol = kDecodeTables.symbol[inputText[textIndex]];
+    ++textIndex;
+    if (symbol == kSymbolSpace) {
+      continue;
+    }
+    if (symbol == kSymbolInvalid || isPaddingSeen_) {
+      isFailed_ = true;
+      return false;
+    }
+    if (symbol == kSymbolPadding) {
+      if (groupCharCount_ < 2) {
+        isFailed_ = true;
+        return false;
+      }
+      ++groupPaddingCount_;
+      groupBits_ <<= 6;
+    } else {
+      if (groupPaddingCount_ > 0) {
+        isFailed_ = true;
+        return false;
+      }
+      groupBits_ = (groupBits_ << 6) | symbol;
+    }
+    ++groupCharCount_;
+    if (groupCharCount_ < 4) {
+      continue;
+    }
+    const size_t groupByteLength = 3U - groupPaddingCount_;
+    if (bytesCapacity - writtenLength < groupByteLength) {
+      isFailed_ = true;
+      return false;
+    }
+    bytesOut[writtenLength++] = static_cast<uint8_t>(groupBits_ >> 16);
+    if (groupByteLength > 1) {
+      bytesOut[writtenLength++] = static_cast<uint8_t>(groupBits_ >> 8);
+    }
+    if (groupByteLength > 2) {
+      bytesOut[writtenLength++] = static_cast<uint8_t>(groupBits_);
+    }
+    isPaddingSeen_ = groupPaddingCount_ > 0;
+    groupBits_ = 0;
+    groupCharCount_ = 0;
+    groupPaddingCount_ = 0;
+  }
+  *byteLengthOut = writtenLength;
+  return true;
+}
+
+bool base64StreamDecoder::finish() {
+  return !isFailed_ && groupCharCount_ == 0;
+}
+
+base64StreamEncoder::base64StreamEncoder() {
+  reset();
+}
+
+void base64StreamEncoder::reset() {
+  pendingBytes_[0] = 0;
+  pendingBytes_[1] = 0;
+  pendingCount_ = 0;
+}
+
+bool base64StreamEncoder::update(const uint8_t* bytes,
+                                 size_t byteLength,
+                                 char* textOut,
+                                 size_t textCapacity,
+                                 size_t* textLengthOut) {
+  if (textLengthOut == nullptr) {
+    return false;
+  }
+  *textLengthOut = 0;
+  if (byteLength == 0) {
+    return true;
+  }
+  const size_t requiredLength = ((pendingCount_ + byteLength) / 3U) * 4U;
+  if (bytes == nullptr || (requiredLength > 0 && textOut == nullptr) || textCapacity < requiredLength) {
+    return false;
+  }
+  size_t byteIndex = 0;
+  size_t writtenLength = 0;
+  if (pendingCount_ > 0) {
+    uint8_t groupBytes[3] = {pendingBytes_[0], pendingBytes_[1], 0};
+    while (pendingCount_ < 3 && byteIndex < byteLength) {
+      groupBytes[pendingCount_++] = bytes[byteIndex++];
+    }
+    if (pendingCount_ < 3) {
+      pendingBytes_[0] = groupBytes[0];
+      pendingBytes_[1] = groupBytes[1];
+      return true;
+    }
+    encodeFullGroups(groupBytes, 1, textOut);
+    writtenLength = 4;
+    pendingCount_ = 0;
+  }
+  const size_t groupCount = (byteLength - byteIndex) / 3U;
+  encodeFullGroups(bytes + byteIndex, groupCount, textOut + writtenLength);
+  byteIndex += groupCount * 3U;
+  writtenLength += groupCount * 4U;
+  while (byteIndex < byteLength) {
+    pendingBytes_[pendingCount_++] = bytes[byteIndex++];
+  }
+  *textLengthOut = writtenLength;
+  return true;
+}
+
+bool base64StreamEncoder::finish(char* textOut, size_t textCapacity, size_t* textLengthOut) {
+  if (textLengthOut == nullptr) {
+    return false;
+  }
+  *textLengthOut = 0;
+  if (pendingCount_ == 0) {
+    return true;
+  }
+  if (textOut == nullptr || textCapacity < 4) {
+    return false;
+  }
+  encodeTailGroup(pendingBytes_, pendingCount_, textOut);
+  *textLengthOut = 4;
+  reset();
+  return true;
+}
+
+namespace base64Codec {
+
+size_t getDecodedLength(const char* text, size_t textLength) {
+  size_t byteLength = (textLength / 4U) * 3U;
+  if (text == nullptr || textLength < 4) {
+    return byteLength;
+  }
+  // 空白を含む入力は 4 の倍数にならないことがあるが、その場合も末尾の '=' を引いた値は上限のまま
+  if (text[textLength - 1] == '=') {
+    --byteLength;
+    if (text[textLength - 2] == '=') {
+      --byteLength;
+    }
+  }
+  return byteLength;
+}
+
+bool encode(const uint8_t* bytes, size_t byteLength, char* textOut, size_t textCapacity, size_t* textLengthOut) {
+  const size_t encodedLength = getEncodedLength(byteLength);
+  if (textOut == nullptr || textCapacity < encodedLength || (byteLength > 0 && bytes == nullptr)) {
+    return false;
+  }
+  const size_t groupCount = byteLength / 3U;
+  encodeFullGroups(bytes, groupCount, textOut);
+  const size_t tailLength = byteLength - groupCount * 3U;
+  if (tailLength > 0) {
+    encodeTailGroup(bytes + groupCount * 3U, tailLength, textOut + groupCount * 4U);
+  }
+  if (textCapacity > encodedLength) {
+    textOut[encodedLength] = '\0';
+  }
+  if (textLengthOut != nullptr) {
+    *textLengthOut = encodedLength;
+  }
+  return true;
+}
+
+bool decode(const char* text, size_t textLength, uint8_t* bytesOut, size_t bytesCapacity, size_t* byteLengthOut) {
+  base64StreamDecoder decoder;
+  size_t writtenLength = 0;
+  if (!decoder.update(text, textLength, bytesOut, bytesCapacity, &writtenLength) || !decoder.finish()) {
+    return false;
+  }
+  if (byteLengthOut != nullptr) {
+    *byteLengthOut = writtenLength;
+  }
+  return true;
+}
+
+bool decodeInPlace(char* text, size_t textLength, size_t* byteLengthOut) {
+  if (byteLengthOut == nullptr) {
+    return false;
+  }
+  return decode(text, textLength, reinterpret_cast<uint8_t*>(text), textLength, byteLengthOut);
+}
+
+bool decodeToBytes(const String& text, std::vector<uint8_t>* bytesOut) {
+  if (bytesOut == nullptr) {
+    appLogError("base64Codec::decodeToBytes failed. bytesOut is null.");
+    return false;
+  }
+  const size_t textLength = text.length();
+  bytesOut->resize(getDecodedLength(text.c_str(), textLength));
+  size_t byteLength = 0;
+  if (!decode(text.c_str(), textLength, bytesOut->data(), bytesOut->size(), &byteLength)) {
+    appLogError("base64Codec::decodeToBytes failed. invalid base64. inputLength=%ld", static_cast<long>(textLength));
+    bytesOut->clear();
+    return false;
+  }
+  bytesOut->resize(byteLength);
+  return true;
+}
+
+bool encodeToText(const uint8_t* bytes, size_t byteLength, String* textOut) {
+  if (textOut == nullptr || (byteLength > 0 && bytes == nullptr)) {
+    appLogError("base64Codec::encodeToText failed. textOut or bytes is null.");
+    return false;
+  }
+  textOut->remove(0);
+  if (byteLength == 0) {
+    return true;
+  }
+  if (!textOut->reserve(static_cast<unsigned int>(getEncodedLength(byteLength)))) {
+    appLogError("base64Codec::encodeToText failed. reserve failed. inputSize=%ld", static_cast<long>(byteLength));
+    return false;
+  }
+  // [重要] String へ1文字ずつ足すと長さ確認が毎回走るため、スタック上の NUL 終端済みの塊で積む
+  char chunkText[kEncodeChunkChars + 1];
+  constexpr size_t kChunkBytes = (kEncodeChunkChars / 4U) * 3U;
+  size_t byteIndex = 0;
+  while (byteIndex < byteLength) {
+    const size_t remainingLength = byteLength - byteIndex;
+    const size_t chunkLength = (remainingLength < kChunkBytes) ? remainingLength : kChunkBytes;
+    size_t chunkTextLength = 0;
+    encode(bytes + byteIndex, chunkLength, chunkText, sizeof(chunkText), &chunkTextLength);
+    textOut->concat(chunkText);
+    byteIndex += chunkLength;
+  }
+  return true;
+}
+
+}  // namespace base64Codec
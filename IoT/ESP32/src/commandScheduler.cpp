@@ -0,0 +1,617 @@
+/**
+ * @file commandScheduler.cpp
+ * @brief UTC時刻指定の出力コマンド予約実行の実装。
+ * @details
+ * - [重要] 予約は固定長の予約表に置き、タイマーホイールのスロットへ添字の連結リストでつなぐ（動的確保なし）。
+ * - [重要] ホイールは 10ms ごとの esp_timer で1スロットずつ進める。目標時刻の kArmLeadUs 手前に来た予約は
+ *   ホイールから外し、予約ごとの単発 esp_timer を「目標時刻 - 現在UTC」で張って目標時刻に発火させる。
+ * - [重要] ホイールのタイマーは最初の予約をホイールへ入れた時に張り、待機中の予約が無くなったら張り直さずに止める。
+ *   周期タイマーではなく単発を毎スロット張り直し、期限は開始時刻からの通算で求めて遅れを持ち越さない。
+ * - [厳守] タイマーのコールバック（esp_timer タスク）ではログを出さない。発火結果は mqttTask へ送り、
+ *   ログと応答はそちらで出す。送れなかった件数だけ数えておき、次の発火結果と一緒にログへ出す。
+ * - [重要] ホイール上の位置は受付時点の見積もりにすぎない。スロットから取り出すたびに現在UTCで残り時間を
+ *   計算し直し、まだ先なら入れ直す。NTP 補正で時計が跳んでも発火時刻は UTC 基準のまま保たれる。
+ */
+
+#include "commandScheduler.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "define.h"
+#include "interTaskMessage.h"
+#include "log.h"
+#include "util.h"
+
+namespace {
+
+/** @brief ホイール1スロットの時間(us)。@type int64_t */
+constexpr int64_t kWheelTickUs = 10000;
+/** @brief ホイールのスロット数（1周 = 1.28秒）。@type uint32_t */
+constexpr uint32_t kWheelSlotCount = 128;
+/** @brief 単発タイマーへ切り替える残り時間(us)。ホイール1スロット分より長く取る。@type int64_t */
+constexpr int64_t kArmLeadUs = 30000;
+/** @brief 受け付ける最長の予約先(us)。@type int64_t */
+constexpr int64_t kMaxScheduleAheadUs = 24LL * 60 * 60 * 1000000;
+/** @brief 時刻同期済みとみなす最小UNIX秒（2021-01-01T00:00:00Z）。@type time_t */
+constexpr time_t kMinimumValidEpochSeconds = 1609459200;
+/** @brief 連結リストの終端。@type uint8_t */
+constexpr uint8_t kNoEntry = 0xFF;
+
+/**
+ * @brief 予約1件の状態。
+ */
+enum class scheduleEntryState : uint8_t {
+  /** 未使用。 */
+  kFree = 0,
+  /** ホイール上で待機中。 */
+  kWaiting,
+  /** 単発タイマー設定済み。 */
+  kArmed,
+};
+
+/**
+ * @brief 予約1件。
+ */
+struct scheduleEntry {
+  /** @brief 状態。@type scheduleEntryState */
+  scheduleEntryState state;
+  /** @brief 同じスロットの次の予約。無しは kNoEntry。@type uint8_t */
+  uint8_t nextInSlot;
+  /** @brief 取り出しまでに残る周回数。@type uint32_t */
+  uint32_t remainingRounds;
+  /** @brief 目標時刻（UNIX エポックからの us）。@type int64_t */
+  int64_t targetUtcUs;
+  /** @brief 検証済み出力操作。@type gpioBatchPlan */
+  gpioBatchPlan plan;
+  /** @brief 応答用サブコマンド。@type char[24] */
+  char subName[24];
+  /** @brief 応答用要求ID。@type char[48] */
+  char requestId[48];
+  /** @brief 応答先ID。@type char[48] */
+  char destinationId[48];
+};
+
+/** @brief 予約表。@type scheduleEntry[] */
+scheduleEntry scheduleEntries[kCommandSchedulerMaxEntries] = {};
+/** @brief 予約ごとの単発タイマー。@type esp_timer_handle_t[] */
+esp_timer_handle_t preciseTimers[kCommandSchedulerMaxEntries] = {};
+/** @brief ホイールの各スロット先頭。@type uint8_t[] */
+uint8_t wheelSlotHeads[kWheelSlotCount] = {};
+/** @brief ホイールの現在スロット（通算）。@type uint32_t */
+uint32_t currentWheelTick = 0;
+/** @brief ホイールを進める単発タイマー（スロットごとに張り直す）。@type esp_timer_handle_t */
+esp_timer_handle_t wheelTimer = nullptr;
+/** @brief ホイールのタイマーを張っている間true（schedulerLock で保護）。@type bool */
+bool isWheelRunning = false;
+/** @brief 次のスロットを進める時刻（esp_timer_get_time 基準の us）。@type int64_t */
+int64_t nextWheelTickDueUs = 0;
+/** @brief mqttTask へ送れなかった発火結果の件数（schedulerLock で保護）。@type uint32_t */
+uint32_t droppedResultCount = 0;
+/** @brief 予約表とホイールの排他。 */
+portMUX_TYPE schedulerLock = portMUX_INITIALIZER_UNLOCKED;
+/** @brief 初期化済みフラグ。 */
+bool isSchedulerInitialized = false;
+
+/**
+ * @brief 文字列を終端付きで複写する（null は空文字）。
+ */
+void copyText(char* destination, size_t destinationSize, const char* source) {
+  snprintf(destination, destinationSize, "%s", source == nullptr ? "" : source);
+}
+
+/**
+ * @brief 残り時間からホイールへ入れる。
+ * @details
+ * - [厳守] schedulerLock 取得中に呼ぶ。
+ */
+void insertIntoWheelLocked(uint8_t entryIndex, int64_t remainingUs) {
+  int64_t ticksAhead = (remainingUs - kArmLeadUs) / kWheelTickUs;
+  if (ticksAhead < 1) {
+    ticksAhead = 1;
+  }
+  const uint32_t slotIndex = static_cast<uint32_t>((currentWheelTick + ticksAhead) % kWheelSlotCount);
+  scheduleEntry& entry = scheduleEntries[entryIndex];
+  entry.state = scheduleEntryState::kWaiting;
+  entry.remainingRounds = static_cast<uint32_t>((ticksAhead - 1) / kWheelSlotCount);
+  entry.nextInSlot = wheelSlotHeads[slotIndex];
+  wheelSlotHeads[slotIndex] = entryIndex;
+}
+
+/**
+ * @brief ホイールから予約を外す。
+ * @details
+ * - [厳守] schedulerLock 取得中に呼ぶ。
+ */
+void removeFromWheelLocked(uint8_t entryIndex) {
+  for (uint32_t slotIndex = 0; slotIndex < kWheelSlotCount; ++slotIndex) {
+    uint8_t previousIndex = kNoEntry;
+    for (uint8_t candidateIndex = wheelSlotHeads[slotIndex]; candidateIndex != kNoEntry;
+         candidateIndex = scheduleEntries[candidateIndex].nextInSlot) {
+      if (candidateIndex != entryIndex) {
+        previousIndex = candidateIndex;
+        continue;
+      }
+      if (previousIndex == kNoEntry) {
+        wheelSlotHeads[slotIndex] = scheduleEntries[entryIndex].nextInSlot;
+      } else {
+        scheduleEntries[previousIndex].nextInSlot = scheduleEntries[entryIndex].nextInSlot;
+      }
+      scheduleEntries[entryIndex].nextInSlot = kNoEntry;
+      return;
+    }
+  }
+}
+
+/**
+ * @brief ホイールに待機中の予約があるか。
+ * @details
+ * - [厳守] schedulerLock 取得中に呼ぶ。
+ */
+bool hasWaitingEntryLocked() {
+  for (uint8_t entryIndex = 0; entryIndex < kCommandSchedulerMaxEntries; ++entryIndex) {
+    if (scheduleEntries[entryIndex].state == scheduleEntryState::kWaiting) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief ホイールの次のスロットまでの単発タイマーを張る。
+ * @return esp_timer_start_once の結果。
+ */
+esp_err_t armWheelTimer() {
+  const int64_t timeoutUs = nextWheelTickDueUs - esp_timer_get_time();
+  return esp_timer_start_once(wheelTimer, static_cast<uint64_t>(timeoutUs > 0 ? timeoutUs : 1));
+}
+
+/**
+ * @brief 予約を単発タイマーへ切り替える。
+ * @details
+ * - [重要] esp_timer タスクからも呼ぶためログは出さない。失敗時のログは呼出し側で出す。
+ * @return esp_timer_start_once の結果。
+ */
+esp_err_t armPreciseTimer(uint8_t entryIndex, int64_t remainingUs) {
+  portENTER_CRITICAL(&schedulerLock);
+  scheduleEntries[entryIndex].state = scheduleEntryState::kArmed;
+  portEXIT_CRITICAL(&schedulerLock);
+  // [重要] 0 を渡すと esp_timer が拒否するため、期限切れは 1us で即時発火させる。
+  const uint64_t timeoutUs = static_cast<uint64_t>(remainingUs > 0 ? remainingUs : 1);
+  return esp_timer_start_once(preciseTimers[entryIndex], timeoutUs);
+}
+
+/**
+ * @brief 予約を解放する。
+ */
+void releaseEntry(uint8_t entryIndex) {
+  portENTER_CRITICAL(&schedulerLock);
+  scheduleEntries[entryIndex].state = scheduleEntryState::kFree;
+  scheduleEntries[entryIndex].nextInSlot = kNoEntry;
+  portEXIT_CRITICAL(&schedulerLock);
+}
+
+/**
+ * @brief 発火結果を mqttTask へ渡す。
+ * @details
+ * - [重要] esp_timer タスクを止めないよう待たずに送り、ログも出さない。送れなかった件数だけ数える。
+ */
+void notifyFiredResult(const scheduleEntry& entry, bool isApplied, uint8_t appliedCount, int64_t latenessUs) {
+  appUtil::appTaskMessageDetail resultDetail = appUtil::createEmptyMessageDetail();
+  resultDetail.text = entry.subName;
+  resultDetail.text2 = entry.requestId;
+  resultDetail.text3 = entry.destinationId;
+  resultDetail.hasIntValue = true;
+  resultDetail.intValue = static_cast<int32_t>(latenessUs);
+  resultDetail.hasIntValue2 = true;
+  resultDetail.intValue2 = appliedCount;
+  resultDetail.hasBoolValue = true;
+  resultDetail.boolValue = isApplied;
+  const appTaskMessage resultMessage = appUtil::buildTaskMessage(appTaskId::kMqtt,
+                                                                 appTaskId::kCommandScheduler,
+                                                                 appMessageType::kMqttPublishScheduledResultRequest,
+                                                                 &resultDetail);
+  if (!getInterTaskMessageService().trySendMessage(resultMessage)) {
+    portENTER_CRITICAL(&schedulerLock);
+    ++droppedResultCount;
+    portEXIT_CRITICAL(&schedulerLock);
+  }
+}
+
+/**
+ * @brief 単発タイマーの発火処理（目標時刻）。
+ */
+void onPreciseTimer(void* timerArgument) {
+  const uint8_t entryIndex = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(timerArgument));
+  int64_t firedUtcUs = 0;
+  commandScheduler::getUtcNowMicros(&firedUtcUs);
+  gpioBatchResult applyResult{};
+  // [重要] 出力を先に書き、時刻計測や通知はその後に行う（発火の揺らぎを増やさない）。
+  const bool isApplied = gpioBatch::applyPlan(scheduleEntries[entryIndex].plan, &applyResult);
+  const int64_t latenessUs = firedUtcUs - scheduleEntries[entryIndex].targetUtcUs;
+  notifyFiredResult(scheduleEntries[entryIndex], isApplied, applyResult.appliedCount, latenessUs);
+  releaseEntry(entryIndex);
+}
+
+/**
+ * @brief ホイールを1スロット進め、期限の近い予約を単発タイマーへ移す。
+ * @details
+ * - [重要] 処理後も待機中の予約が残っていれば次のスロットを張り直し、無ければ止める。
+ */
+void onWheelTick(void* timerArgument) {
+  (void)timerArgument;
+  uint8_t dueEntries[kCommandSchedulerMaxEntries];
+  uint8_t dueCount = 0;
+  portENTER_CRITICAL(&schedulerLock);
+  ++currentWheelTick;
+  nextWheelTickDueUs += kWheelTickUs;
+  const uint32_t slotIndex = currentWheelTick % kWheelSlotCount;
+  uint8_t previousIndex = kNoEntry;
+  uint8_t entryIndex = wheelSlotHeads[slotIndex];
+  while (entryIndex != kNoEntry) {
+    scheduleEntry& entry = scheduleEntries[entryIndex];
+    const uint8_t nextIndex = entry.nextInSlot;
+    if (entry.remainingRounds > 0) {
+      --entry.remainingRounds;
+      previousIndex = entryIndex;
+    } else {
+      if (previousIndex == kNoEntry) {
+        wheelSlotHeads[slotIndex] = nextIndex;
+      } else {
+        scheduleEntries[previousIndex].nextInSlot = nextIndex;
+      }
+      entry.nextInSlot = kNoEntry;
+      dueEntries[dueCount++] = entryIndex;
+    }
+    entryIndex = nextIndex;
+  }
+  portEXIT_CRITICAL(&schedulerLock);
+
+  int64_t utcNowUs = 0;
+  const bool isClockValid = (dueCount == 0) || commandScheduler::getUtcNowMicros(&utcNowUs);
+  for (uint8_t dueIndex = 0; dueIndex < dueCount; ++dueIndex) {
+    const uint8_t dueEntry = dueEntries[dueIndex];
+    // [注意] 時計が未同期へ戻った（通常起きない）場合は残り時間を測れないため、そのまま即時発火させる。
+    const int64_t remainingUs = isClockValid ? (scheduleEntries[dueEntry].targetUtcUs - utcNowUs) : 0;
+    if (remainingUs > kArmLeadUs + kWheelTickUs) {
+      portENTER_CRITICAL(&schedulerLock);
+      insertIntoWheelLocked(dueEntry, remainingUs);
+      portEXIT_CRITICAL(&schedulerLock);
+      continue;
+    }
+    if (armPreciseTimer(dueEntry, remainingUs) != ESP_OK) {
+      // [重要] タイマーを張れなければその場で実行する（予約を黙って捨てない）。遅れは応答の lateUs に残る。
+      onPreciseTimer(reinterpret_cast<void*>(static_cast<uintptr_t>(dueEntry)));
+    }
+  }
+
+  // [重要] 判定と isWheelRunning の更新を同じロック内で行い、受付側の再開と食い違わないようにする。
+  portENTER_CRITICAL(&schedulerLock);
+  isWheelRunning = hasWaitingEntryLocked();
+  const bool shouldContinue = isWheelRunning;
+  portEXIT_CRITICAL(&schedulerLock);
+  if (shouldContinue && armWheelTimer() != ESP_OK) {
+    // [注意] 張り直せなかった場合は停止扱いにし、次の受付で張り直させる。
+    portENTER_CRITICAL(&schedulerLock);
+    isWheelRunning = false;
+    portEXIT_CRITICAL(&schedulerLock);
+  }
+}
+
+/**
+ * @brief 指定年月の日数を返す。
+ */
+int32_t getDaysInMonth(int32_t year, int32_t month) {
+  static const int32_t kDaysInMonth[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool isLeapYear = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+  return (month == 2 && isLeapYear) ? 29 : kDaysInMonth[month - 1];
+}
+
+/**
+ * @brief 1970-01-01 からの日数を返す（グレゴリオ暦）。
+ * @details
+ * - [重要] timegm は newlib の環境で TZ に依存するため使わず、暦計算で求める。
+ */
+int64_t getDaysFromCivil(int32_t year, int32_t month, int32_t day) {
+  year -= (month <= 2) ? 1 : 0;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const int64_t yearOfEra = year - era * 400;
+  const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * @brief 固定桁の10進数を読む。
+ * @return 読めた場合true。
+ */
+bool parseFixedDigits(const char* text, uint8_t digitCount, int32_t* valueOut) {
+  int32_t value = 0;
+  for (uint8_t digitIndex = 0; digitIndex < digitCount; ++digitIndex) {
+    const char digit = text[digitIndex];
+    if (digit < '0' || digit > '9') {
+      return false;
+    }
+    value = value * 10 + (digit - '0');
+  }
+  *valueOut = value;
+  return true;
+}
+}  // namespace
+
+namespace commandScheduler {
+
+bool initialize() {
+  if (isSchedulerInitialized) {
+    return true;
+  }
+  for (uint8_t entryIndex = 0; entryIndex < kCommandSchedulerMaxEntries; ++entryIndex) {
+    scheduleEntries[entryIndex].state = scheduleEntryState::kFree;
+    scheduleEntries[entryIndex].nextInSlot = kNoEntry;
+    esp_timer_create_args_t preciseTimerArgs = {};
+    preciseTimerArgs.callback = onPreciseTimer;
+    preciseTimerArgs.arg = reinterpret_cast<void*>(static_cast<uintptr_t>(entryIndex));
+    preciseTimerArgs.dispatch_method = ESP_TIMER_TASK;
+    preciseTimerArgs.name = "cmdSchedFire";
+    const esp_err_t createResult = esp_timer_create(&preciseTimerArgs, &preciseTimers[entryIndex]);
+    if (createResult != ESP_OK) {
+      appLogError("commandScheduler::initialize failed. esp_timer_create(fire) err=%d entry=%u",
+                  static_cast<int>(createResult),
+                  static_cast<unsigned>(entryIndex));
+      return false;
+    }
+  }
+  memset(wheelSlotHeads, kNoEntry, sizeof(wheelSlotHeads));
+
+  esp_timer_create_args_t wheelTimerArgs = {};
+  wheelTimerArgs.callback = onWheelTick;
+  wheelTimerArgs.arg = nullptr;
+  wheelTimerArgs.dispatch_method = ESP_TIMER_TASK;
+  wheelTimerArgs.name = "cmdSchedWheel";
+  // [重要] ここでは作るだけで張らない。最初の予約をホイールへ入れた時に張る。
+  const esp_err_t wheelResult = esp_timer_create(&wheelTimerArgs, &wheelTimer);
+  if (wheelResult != ESP_OK) {
+    appLogError("commandScheduler::initialize failed. wheel timer err=%d", static_cast<int>(wheelResult));
+    return false;
+  }
+  isSchedulerInitialized = true;
+  appLogInfo("commandScheduler::initialize success. entries=%u tickUs=%lld slots=%lu",
+             static_cast<unsigned>(kCommandSchedulerMaxEntries),
+             static_cast<long long>(kWheelTickUs),
+             static_cast<unsigned long>(kWheelSlotCount));
+  return true;
+}
+
+bool scheduleOutputPlan(int64_t targetUtcUs,
+                        const gpioBatchPlan& plan,
+                        const char* subName,
+                        const char* requestId,
+                        const char* destinationId,
+                        commandScheduleReceipt* receiptOut) {
+  if (receiptOut == nullptr) {
+    appLogError("commandScheduler::scheduleOutputPlan failed. receiptOut is null.");
+    return false;
+  }
+  *receiptOut = commandScheduleReceipt{};
+  if (!isSchedulerInitialized) {
+    receiptOut->error = commandScheduleError::kNotInitialized;
+    appLogError("commandScheduler::scheduleOutputPlan failed. scheduler is not initialized.");
+    return false;
+  }
+  int64_t utcNowUs = 0;
+  if (!getUtcNowMicros(&utcNowUs)) {
+    receiptOut->error = commandScheduleError::kClockNotSynchronized;
+    appLogWarn("commandScheduler::scheduleOutputPlan rejected. clock is not synchronized.");
+    return false;
+  }
+  const int64_t delayUs = targetUtcUs - utcNowUs;
+  receiptOut->delayUs = delayUs;
+  if (delayUs <= 0) {
+    receiptOut->error = commandScheduleError::kInPast;
+    appLogWarn("commandScheduler::scheduleOutputPlan rejected. target is in the past. delayUs=%lld",
+               static_cast<long long>(delayUs));
+    return false;
+  }
+  if (delayUs > kMaxScheduleAheadUs) {
+    receiptOut->error = commandScheduleError::kTooFarAhead;
+    appLogWarn("commandScheduler::scheduleOutputPlan rejected. target is too far. delayUs=%lld",
+               static_cast<long long>(delayUs));
+    return false;
+  }
+
+  uint8_t entryIndex = kNoEntry;
+  uint8_t pendingCount = 0;
+  portENTER_CRITICAL(&schedulerLock);
+  for (uint8_t candidateIndex = 0; candidateIndex < kCommandSchedulerMaxEntries; ++candidateIndex) {
+    if (scheduleEntries[candidateIndex].state != scheduleEntryState::kFree) {
+      ++pendingCount;
+    } else if (entryIndex == kNoEntry) {
+      entryIndex = candidateIndex;
+    }
+  }
+  if (entryIndex != kNoEntry) {
+    // [重要] 空きを確保した時点で kWaiting にし、解放前に他の受付に取られないようにする。
+    scheduleEntries[entryIndex].state = scheduleEntryState::kWaiting;
+    ++pendingCount;
+  }
+  portEXIT_CRITICAL(&schedulerLock);
+  receiptOut->pendingCount = pendingCount;
+  if (entryIndex == kNoEntry) {
+    receiptOut->error = commandScheduleError::kFull;
+    appLogWarn("commandScheduler::scheduleOutputPlan rejected. table is full. pending=%u",
+               static_cast<unsigned>(pendingCount));
+    return false;
+  }
+
+  scheduleEntry& entry = scheduleEntries[entryIndex];
+  entry.targetUtcUs = targetUtcUs;
+  entry.plan = plan;
+  entry.nextInSlot = kNoEntry;
+  copyText(entry.subName, sizeof(entry.subName), subName);
+  copyText(entry.requestId, sizeof(entry.requestId), requestId);
+  copyText(entry.destinationId, sizeof(entry.destinationId), destinationId);
+
+  if (delayUs <= kArmLeadUs + kWheelTickUs) {
+    const esp_err_t armResult = armPreciseTimer(entryIndex, delayUs);
+    if (armResult != ESP_OK) {
+      releaseEntry(entryIndex);
+      receiptOut->error = commandScheduleError::kTimerFailed;
+      receiptOut->pendingCount = static_cast<uint8_t>(pendingCount - 1);
+      appLogError("commandScheduler::scheduleOutputPlan failed. precise timer err=%d sub=%s id=%s",
+                  static_cast<int>(armResult),
+                  entry.subName,
+                  entry.requestId);
+      return false;
+    }
+  } else {
+    portENTER_CRITICAL(&schedulerLock);
+    insertIntoWheelLocked(entryIndex, delayUs);
+    const bool shouldStartWheel = !isWheelRunning;
+    if (shouldStartWheel) {
+      isWheelRunning = true;
+      nextWheelTickDueUs = esp_timer_get_time() + kWheelTickUs;
+    }
+    portEXIT_CRITICAL(&schedulerLock);
+    const esp_err_t wheelResult = shouldStartWheel ? armWheelTimer() : ESP_OK;
+    if (wheelResult != ESP_OK) {
+      portENTER_CRITICAL(&schedulerLock);
+      removeFromWheelLocked(entryIndex);
+      isWheelRunning = false;
+      portEXIT_CRITICAL(&schedulerLock);
+      releaseEntry(entryIndex);
+      receiptOut->error = commandScheduleError::kTimerFailed;
+      receiptOut->pendingCount = static_cast<uint8_t>(pendingCount - 1);
+      appLogError("commandScheduler::scheduleOutputPlan failed. wheel timer err=%d sub=%s id=%s",
+                  static_cast<int>(wheelResult),
+                  entry.subName,
+                  entry.requestId);
+      return false;
+    }
+  }
+  appLogInfo("commandScheduler::scheduleOutputPlan accepted. sub=%s id=%s delayUs=%lld pending=%u",
+             entry.subName,
+             entry.requestId,
+             static_cast<long long>(delayUs),
+             static_cast<unsigned>(pendingCount));
+  return true;
+}
+
+bool parseUtcTimestamp(const char* timestampText, int64_t* epochMicrosOut) {
+  if (timestampText == nullptr || epochMicrosOut == nullptr) {
+    appLogError("commandScheduler::parseUtcTimestamp failed. timestampText=%p epochMicrosOut=%p",
+                timestampText,
+                epochMicrosOut);
+    return false;
+  }
+  // [制限] 受け付けるのは `YYYY-MM-DDTHH:MM:SS[.f..]Z`（UTC 固定）のみ。時差付き表記は受け付けない。
+  if (strlen(timestampText) < 20 || timestampText[4] != '-' || timestampText[7] != '-' || timestampText[10] != 'T' ||
+      timestampText[13] != ':' || timestampText[16] != ':') {
+    appLogWarn("commandScheduler::parseUtcTimestamp rejected. format. text=%s", timestampText);
+    return false;
+  }
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t day = 0;
+  int32_t hour = 0;
+  int32_t minute = 0;
+  int32_t second = 0;
+  if (!parseFixedDigits(timestampText, 4, &year) || !parseFixedDigits(timestampText + 5, 2, &month) ||
+      !parseFixedDigits(timestampText + 8, 2, &day) || !parseFixedDigits(timestampText + 11, 2, &hour) ||
+      !parseFixedDigits(timestampText + 14, 2, &minute) || !parseFixedDigits(timestampText + 17, 2, &second)) {
+    appLogWarn("commandScheduler::parseUtcTimestamp rejected. digits. text=%s", timestampText);
+    return false;
+  }
+  if (year < 1970 || month < 1 || month > 12 || day < 1 || day > getDaysInMonth(year, month) || hour > 23 ||
+      minute > 59 || second > 59) {
+    appLogWarn("commandScheduler::parseUtcTimestamp rejected. range. text=%s", timestampText);
+    return false;
+  }
+
+  const char* cursor = timestampText + 19;
+  int64_t fractionUs = 0;
+  if (*cursor == '.') {
+    ++cursor;
+    int64_t scale = 100000;
+    uint8_t digitCount = 0;
+    while (*cursor >= '0' && *cursor <= '9') {
+      // [注意] us より細かい桁は切り捨てる。
+      if (scale > 0) {
+        fractionUs += (*cursor - '0') * scale;
+        scale /= 10;
+      }
+      ++cursor;
+      ++digitCount;
+    }
+    if (digitCount == 0 || digitCount > 9) {
+      appLogWarn("commandScheduler::parseUtcTimestamp rejected. fraction. text=%s", timestampText);
+      return false;
+    }
+  }
+  if (cursor[0] != 'Z' || cursor[1] != '\0') {
+    appLogWarn("commandScheduler::parseUtcTimestamp rejected. only UTC(Z) is accepted. text=%s", timestampText);
+    return false;
+  }
+
+  const int64_t epochSeconds =
+      getDaysFromCivil(year, month, day) * 86400LL + hour * 3600LL + minute * 60LL + static_cast<int64_t>(second);
+  *epochMicrosOut = epochSeconds * 1000000LL + fractionUs;
+  return true;
+}
+
+bool getUtcNowMicros(int64_t* epochMicrosOut) {
+  if (epochMicrosOut == nullptr) {
+    return false;
+  }
+  struct timeval currentTime = {};
+  gettimeofday(&currentTime, nullptr);
+  if (currentTime.tv_sec < kMinimumValidEpochSeconds) {
+    return false;
+  }
+  *epochMicrosOut = static_cast<int64_t>(currentTime.tv_sec) * 1000000LL + static_cast<int64_t>(currentTime.tv_usec);
+  return true;
+}
+
+uint8_t getPendingCount() {
+  uint8_t pendingCount = 0;
+  portENTER_CRITICAL(&schedulerLock);
+  for (uint8_t entryIndex = 0; entryIndex < kCommandSchedulerMaxEntries; ++entryIndex) {
+    if (scheduleEntries[entryIndex].state != scheduleEntryState::kFree) {
+      ++pendingCount;
+    }
+  }
+  portEXIT_CRITICAL(&schedulerLock);
+  return pendingCount;
+}
+
+uint32_t takeDroppedResultCount() {
+  portENTER_CRITICAL(&schedulerLock);
+  const uint32_t droppedCount = droppedResultCount;
+  droppedResultCount = 0;
+  portEXIT_CRITICAL(&schedulerLock);
+  return droppedCount;
+}
+
+const char* getErrorText(commandScheduleError error) {
+  switch (error) {
+    case commandScheduleError::kNone:
+      return "none";
+    case commandScheduleError::kNotInitialized:
+      return "scheduler not initialized";
+    case commandScheduleError::kClockNotSynchronized:
+      return "clock not synchronized";
+    case commandScheduleError::kInPast:
+      return "target time is in the past";
+    case commandScheduleError::kTooFarAhead:
+      return "target time is too far ahead";
+    case commandScheduleError::kFull:
+      return "schedule table is full";
+    case commandScheduleError::kTimerFailed:
+      return "timer start failed";
+  }
+  return "unknown";
+}
+
+}  // namespace commandScheduler
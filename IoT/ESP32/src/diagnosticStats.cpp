@@ -0,0 +1,56 @@
+/**
+ * @file diagnosticStats.cpp
+ * @brief 診断系計測で共有する集計関数の実装。
+ */
+
+#include "diagnosticStats.h"
+
+#include <cJSON.h>
+
+namespace diagnosticStats {
+
+uint32_t clampValue(uint32_t value, uint32_t minimum, uint32_t maximum) {
+  if (value < minimum) {
+    return minimum;
+  }
+  return (value > maximum) ? maximum : value;
+}
+
+void recordLog2Bucket(uint16_t* buckets, uint8_t bucketCount, uint32_t elapsedUs) {
+  if (buckets == nullptr || bucketCount == 0) {
+    return;
+  }
+  uint8_t bucketIndex = 0;
+  for (uint32_t remainingUs = elapsedUs; remainingUs > 1 && bucketIndex < bucketCount - 1; remainingUs >>= 1) {
+    ++bucketIndex;
+  }
+  ++buckets[bucketIndex];
+}
+
+uint32_t computeKiloBytesPerSecond(uint32_t bytes, uint32_t elapsedUs) {
+  if (elapsedUs == 0) {
+    return 0;
+  }
+  // [重要] KB/s = byte / us * 1e6 / 1024。
+  return static_cast<uint32_t>((static_cast<uint64_t>(bytes) * 1000000ULL / elapsedUs) / 1024ULL);
+}
+
+bool appendBucketsToJson(cJSON* objectOut, const char* name, const uint16_t* buckets, uint8_t bucketCount) {
+  if (objectOut == nullptr || name == nullptr || buckets == nullptr) {
+    return false;
+  }
+  uint8_t usedBucketCount = bucketCount;
+  while (usedBucketCount > 0 && buckets[usedBucketCount - 1] == 0) {
+    --usedBucketCount;
+  }
+  cJSON* bucketsArray = cJSON_AddArrayToObject(objectOut, name);
+  if (bucketsArray == nullptr) {
+    return false;
+  }
+  for (uint8_t bucketIndex = 0; bucketIndex < usedBucketCount; ++bucketIndex) {
+    cJSON_AddItemToArray(bucketsArray, cJSON_CreateNumber(buckets[bucketIndex]));
+  }
+  return true;
+}
+
+}  // namespace diagnosticStats
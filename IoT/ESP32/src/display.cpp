@@ -5,49 +5,48 @@
 
 #include "display.h"
 
-#include <esp_heap_caps.h>
 #include <string.h>
 
+#include "flowRuntime.h"
 #include "interTaskMessage.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
 StackType_t* displayTaskStackBuffer = nullptr;
 StaticTask_t displayTaskControlBlock;
+/** @brief スケジューラ相乗り時の起動応答フロー。 */
+flowRuntime::startupAckResponderFlow displayStartupAckFlow(appTaskId::kDisplay, "displayTask startup ack", nullptr);
 }
 
-bool displayTask::startTask() {
+bool displayTask::attachToFlowScheduler(flowRuntime::flowScheduler* schedulerOut) {
+  if (schedulerOut == nullptr) {
+    appLogError("displayTask::attachToFlowScheduler failed. schedulerOut is null.");
+    return false;
+  }
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kDisplay, 8);
-
-  if (displayTaskStackBuffer == nullptr) {
-    displayTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (displayTaskStackBuffer == nullptr) {
-    appLogWarn("displayTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    displayTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (displayTaskStackBuffer == nullptr) {
-    appLogError("displayTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
+  if (!schedulerOut->registerMailbox(appTaskId::kDisplay) ||
+      !schedulerOut->addFlow(&displayStartupAckFlow, appTaskId::kDisplay)) {
+    appLogError("displayTask::attachToFlowScheduler failed. scheduler registration failed.");
     return false;
   }
+  appLogInfo("displayTask attached to flow scheduler. (skeleton, no dedicated stack)");
+  return true;
+}
+
+bool displayTask::startTask() {
+  interTaskMessageService& messageService = getInterTaskMessageService();
+  messageService.registerTaskQueue(appTaskId::kDisplay, 8);
 
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "displayTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      displayTaskStackBuffer,
-      &displayTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("displayTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kDisplay,
+                                             taskEntry,
+                                             this,
+                                             &displayTaskStackBuffer,
+                                             &displayTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("displayTask created.");
   return true;
 }
 
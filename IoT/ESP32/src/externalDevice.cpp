@@ -1,79 +1,680 @@
 /**
  * @file externalDevice.cpp
- * @brief 外部デバイス管理タスクのひな形実装。
+ * @brief 外部デバイスのドライバ枠組み（記述子表・測定スケジューラ・スナップショット）と、起動応答の受け口（mainFlowScheduler 相乗り）の実装。
+ * @details
+ * - [重要] 測定は「周期の来たデバイスをまとめて1バッチ」で行う。
+ *   (1) 全デバイスのトリガを連続書込み → (2) 最長の変換待ちを1回だけ待つ → (3) 全デバイスの読取バーストを連続実行。
+ * - [重要] 1デバイス内の読取範囲は、隙間が kMergeGapBytes 以下なら1バーストへ併合する
+ *   （隙間の余分な読取より、番地指定 + リピーテッドスタートのやり直しの方が高くつくため）。
+ * - [重要] スナップショットは seqlock（書き手は I2C 専用タスクのみ）。読む側は書込み中を検出したら読み直す。
+ * - [制限] バースト1回の長さは kMaxBurstBytes まで（Wire の受信バッファ長に合わせる）。
  */
 
 #include "externalDevice.h"
 
-#include <esp_heap_caps.h>
+#include <Arduino.h>
+#include <atomic>
 #include <string.h>
 
+#include "flowRuntime.h"
 #include "interTaskMessage.h"
 #include "log.h"
 
 namespace {
-StackType_t* externalDeviceTaskStackBuffer = nullptr;
-StaticTask_t externalDeviceTaskControlBlock;
+/** @brief スケジューラ相乗り時の起動応答フロー。 */
+flowRuntime::startupAckResponderFlow externalDeviceStartupAckFlow(appTaskId::kExternalDevice,
+                                                                  "externalDeviceTask startup ack",
+                                                                  nullptr);
+
+/** @brief 管理デバイス数。@type uint8_t */
+constexpr uint8_t kDeviceCount = static_cast<uint8_t>(externalDeviceId::kCount);
+/** @brief 周期がこの時間内に来るデバイスは、今回のバッチへ前倒しで含める(ms)。@type uint32_t */
+constexpr uint32_t kBatchWindowMs = 50;
+/** @brief 測定予定が無いときの最大待機(ms)。I2C 要求キューの応答性もこの値で決まる。@type uint32_t */
+constexpr uint32_t kMaxIdleWaitMs = 100;
+/** @brief 未検出/故障デバイスの再探索間隔(ms)。@type uint32_t */
+constexpr uint32_t kReprobeIntervalMs = 30000;
+/** @brief 連続失敗でデバイスを未検出扱いへ戻す回数。@type uint8_t */
+constexpr uint8_t kMaxConsecutiveFailures = 3;
+/** @brief 読取範囲を併合する隙間の上限(byte)。@type uint8_t */
+constexpr uint8_t kMergeGapBytes = 4;
+/** @brief バースト1回の最大長(byte)。@type uint8_t */
+constexpr uint8_t kMaxBurstBytes = 32;
+/** @brief スナップショット読取の再試行上限。@type uint8_t */
+constexpr uint8_t kSnapshotReadRetryCount = 8;
+/** @brief バス統計をログへ出すバッチ間隔。@type uint32_t */
+constexpr uint32_t kStatisticsLogBatchInterval = 120;
+
+// ---------------------------------------------------------------------------
+// BME280（温度degC / 湿度%RH / 気圧hPa）
+// ---------------------------------------------------------------------------
+
+/** @brief BME280 アドレス候補（SDO=GND で 0x76）。 */
+constexpr uint8_t kBme280Addresses[] = {0x76, 0x77};
+/** @brief BME280 初期化手順。 */
+constexpr externalDeviceRegisterWrite kBme280InitSequence[] = {
+    {0xE0, 0xB6, 5},  // reset: 校正値の NVM コピー完了（仕様 2ms）まで待つ
+    {0xF2, 0x01, 0},  // ctrl_hum: 湿度 x1（ctrl_meas 書込みで有効になる）
+    {0xF5, 0x00, 0},  // config: IIR フィルタなし
+    {0xF4, 0x24, 0},  // ctrl_meas: 温度 x1 / 気圧 x1 / sleep
+};
+/** @brief BME280 校正値範囲（dig_T1..dig_H1 / dig_H2..dig_H6）。 */
+constexpr externalDeviceRegisterRange kBme280CalibrationRanges[] = {{0x88, 26}, {0xE1, 7}};
+/** @brief BME280 測定トリガ（forced mode: 1回測って sleep へ戻る）。 */
+constexpr externalDeviceRegisterWrite kBme280TriggerSequence[] = {{0xF4, 0x25, 0}};
+/** @brief BME280 測定値範囲（press[3] / temp[3] / hum[2]）。 */
+constexpr externalDeviceRegisterRange kBme280ReadRanges[] = {{0xF7, 8}};
+
+/**
+ * @brief リトルエンディアン16bitを読む。
+ */
+uint16_t readUint16Le(const uint8_t* bytes) {
+  return static_cast<uint16_t>(bytes[0] | (static_cast<uint16_t>(bytes[1]) << 8));
 }
 
-bool externalDeviceTask::startTask() {
-  interTaskMessageService& messageService = getInterTaskMessageService();
-  messageService.registerTaskQueue(appTaskId::kExternalDevice, 8);
+}  // namespace
+
+namespace externalDeviceDriver {
+
+bool decodeBme280(const uint8_t* calibration, const uint8_t* frame, externalDeviceReading* readingOut) {
+  const uint16_t digT1 = readUint16Le(&calibration[0]);
+  const int16_t digT2 = static_cast<int16_t>(readUint16Le(&calibration[2]));
+  const int16_t digT3 = static_cast<int16_t>(readUint16Le(&calibration[4]));
+  const uint16_t digP1 = readUint16Le(&calibration[6]);
+  int16_t digP[10] = {};
+  for (uint8_t index = 2; index <= 9; ++index) {
+    digP[index] = static_cast<int16_t>(readUint16Le(&calibration[8 + (index - 2) * 2]));
+  }
+  const uint8_t digH1 = calibration[25];
+  const int16_t digH2 = static_cast<int16_t>(readUint16Le(&calibration[26]));
+  const uint8_t digH3 = calibration[28];
+  const int16_t digH4 = static_cast<int16_t>((static_cast<int8_t>(calibration[29]) * 16) | (calibration[30] & 0x0F));
+  const int16_t digH5 = static_cast<int16_t>((static_cast<int8_t>(calibration[31]) * 16) | (calibration[30] >> 4));
+  const int8_t digH6 = static_cast<int8_t>(calibration[32]);
+
+  const int32_t adcP = (static_cast<int32_t>(frame[0]) << 12) | (static_cast<int32_t>(frame[1]) << 4) | (frame[2] >> 4);
+  const int32_t adcT = (static_cast<int32_t>(frame[3]) << 12) | (static_cast<int32_t>(frame[4]) << 4) | (frame[5] >> 4);
+  const int32_t adcH = (static_cast<int32_t>(frame[6]) << 8) | frame[7];
+  if (adcT == 0x80000 || adcP == 0x80000) {
+    return false;  // 測定がスキップされた（リセット直後の値）
+  }
+
+  int32_t var1 = (((adcT >> 3) - (static_cast<int32_t>(digT1) << 1)) * static_cast<int32_t>(digT2)) >> 11;
+  int32_t var2 = (((((adcT >> 4) - static_cast<int32_t>(digT1)) * ((adcT >> 4) - static_cast<int32_t>(digT1))) >> 12) *
+                  static_cast<int32_t>(digT3)) >>
+                 14;
+  const int32_t tFine = var1 + var2;
+  const int32_t temperatureCentiC = (tFine * 5 + 128) >> 8;
+
+  int64_t pressureVar1 = static_cast<int64_t>(tFine) - 128000;
+  int64_t pressureVar2 = pressureVar1 * pressureVar1 * static_cast<int64_t>(digP[6]);
+  pressureVar2 = pressureVar2 + ((pressureVar1 * static_cast<int64_t>(digP[5])) << 17);
+  pressureVar2 = pressureVar2 + (static_cast<int64_t>(digP[4]) << 35);
+  pressureVar1 = ((pressureVar1 * pressureVar1 * static_cast<int64_t>(digP[3])) >> 8) +
+                 ((pressureVar1 * static_cast<int64_t>(digP[2])) << 12);
+  pressureVar1 = (((static_cast<int64_t>(1) << 47) + pressureVar1) * static_cast<int64_t>(digP1)) >> 33;
+  if (pressureVar1 == 0) {
+    return false;  // 0除算回避（校正値不正）
+  }
+  int64_t pressureQ24 = 1048576 - adcP;
+  pressureQ24 = (((pressureQ24 << 31) - pressureVar2) * 3125) / pressureVar1;
+  pressureVar1 = (static_cast<int64_t>(digP[9]) * (pressureQ24 >> 13) * (pressureQ24 >> 13)) >> 25;
+  pressureVar2 = (static_cast<int64_t>(digP[8]) * pressureQ24) >> 19;
+  pressureQ24 = ((pressureQ24 + pressureVar1 + pressureVar2) >> 8) + (static_cast<int64_t>(digP[7]) << 4);
+
+  int32_t humidity = tFine - 76800;
+  humidity = (((((adcH << 14) - (static_cast<int32_t>(digH4) << 20) - (static_cast<int32_t>(digH5) * humidity)) + 16384) >> 15) *
+              (((((((humidity * static_cast<int32_t>(digH6)) >> 10) *
+                   (((humidity * static_cast<int32_t>(digH3)) >> 11) + 32768)) >>
+                  10) +
+                 2097152) *
+                    static_cast<int32_t>(digH2) +
+                8192) >>
+               14));
+  humidity = humidity - (((((humidity >> 15) * (humidity >> 15)) >> 7) * static_cast<int32_t>(digH1)) >> 4);
+  humidity = (humidity < 0) ? 0 : humidity;
+  humidity = (humidity > 419430400) ? 419430400 : humidity;
+
+  readingOut->valueCount = 3;
+  readingOut->values[0] = static_cast<float>(temperatureCentiC) / 100.0F;
+  readingOut->values[1] = static_cast<float>(humidity >> 12) / 1024.0F;
+  readingOut->values[2] = static_cast<float>(pressureQ24) / 256.0F / 100.0F;
+  return true;
+}
+
+}  // namespace externalDeviceDriver
+
+namespace {
+
+/**
+ * @brief デバイス記述子表（externalDeviceId の並びと一致させる）。
+ */
+const externalDeviceDescriptor kDeviceDescriptors[] = {
+    {"BME280",
+     kBme280Addresses,
+     sizeof(kBme280Addresses),
+     true,
+     0xD0,
+     0x60,
+     kBme280InitSequence,
+     sizeof(kBme280InitSequence) / sizeof(kBme280InitSequence[0]),
+     kBme280CalibrationRanges,
+     sizeof(kBme280CalibrationRanges) / sizeof(kBme280CalibrationRanges[0]),
+     kBme280TriggerSequence,
+     sizeof(kBme280TriggerSequence) / sizeof(kBme280TriggerSequence[0]),
+     10,  // 温度/気圧/湿度 x1 の最大測定時間 9.3ms
+     kBme280ReadRanges,
+     sizeof(kBme280ReadRanges) / sizeof(kBme280ReadRanges[0]),
+     5000,
+     externalDeviceDriver::decodeBme280},
+};
+static_assert(sizeof(kDeviceDescriptors) / sizeof(kDeviceDescriptors[0]) == kDeviceCount,
+              "kDeviceDescriptors must match externalDeviceId");
+
+// ---------------------------------------------------------------------------
+// スケジューラ
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief デバイスの状態。
+ */
+enum class deviceState : uint8_t {
+  /** 未探索（起動直後）。 */
+  kUnprobed = 0,
+  /** 初期化済み、周期測定中。 */
+  kReady,
+  /** 未検出または連続失敗。retryAtMs に再探索する。 */
+  kAbsent,
+};
+
+using externalDeviceDriver::burstPlan;
+
+/**
+ * @brief デバイスごとの実行時状態（I2C 専用タスクだけが触る）。
+ */
+struct deviceRuntime {
+  /** @brief 状態。@type deviceState */
+  deviceState state;
+  /** @brief 検出アドレス。@type uint8_t */
+  uint8_t address;
+  /** @brief 連続失敗回数。@type uint8_t */
+  uint8_t consecutiveFailures;
+  /** @brief 読取バースト数。@type uint8_t */
+  uint8_t readBurstCount;
+  /** @brief 読取バースト（読取範囲を併合したもの）。@type burstPlan[] */
+  burstPlan readBursts[kExternalDeviceMaxRanges];
+  /** @brief 次の測定予定時刻(millis)。@type uint32_t */
+  uint32_t nextDueMs;
+  /** @brief 再探索時刻(millis)。@type uint32_t */
+  uint32_t retryAtMs;
+  /** @brief 測定成功回数。@type uint32_t */
+  uint32_t sampleCount;
+  /** @brief 校正値。@type uint8_t[] */
+  uint8_t calibration[kExternalDeviceMaxCalibrationBytes];
+};
+
+/**
+ * @brief バス利用統計（I2C 専用タスクだけが触る）。
+ */
+struct busStatistics {
+  /** @brief バッチ数。@type uint32_t */
+  uint32_t batchCount;
+  /** @brief トランザクション数（書込み + バースト読取）。@type uint32_t */
+  uint32_t transactionCount;
+  /** @brief 失敗したトランザクション数。@type uint32_t */
+  uint32_t failedTransactionCount;
+  /** @brief バスを使っていた時間の合計(us)。変換待ちは含まない。@type uint64_t */
+  uint64_t busBusyUs;
+  /** @brief 最初のバッチ時刻(millis)。@type uint32_t */
+  uint32_t firstBatchAtMs;
+};
+
+/**
+ * @brief seqlock で公開するスナップショット。
+ */
+struct snapshotSlot {
+  /** @brief 奇数なら書込み中。@type std::atomic<uint32_t> */
+  std::atomic<uint32_t> sequence;
+  /** @brief 公開中の測定結果。@type externalDeviceReading */
+  externalDeviceReading reading;
+};
+
+deviceRuntime deviceRuntimeTable[kDeviceCount] = {};
+snapshotSlot snapshotTable[kDeviceCount] = {};
+std::atomic<bool> immediateReadRequested[kDeviceCount] = {};
+busStatistics busStats = {};
+
+/**
+ * @brief 時刻 a が b 以降か（millis の折り返しを考慮）。
+ */
+bool isTimeReached(uint32_t nowMs, uint32_t targetMs) {
+  return static_cast<int32_t>(nowMs - targetMs) >= 0;
+}
+
+/**
+ * @brief スナップショットを公開する（書き手は I2C 専用タスクのみ）。
+ * @param deviceIndex デバイス番号。
+ * @param reading 公開する測定結果。
+ */
+void publishSnapshot(uint8_t deviceIndex, const externalDeviceReading& reading) {
+  snapshotSlot& slot = snapshotTable[deviceIndex];
+  const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&slot.reading, &reading, sizeof(reading));
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}  // namespace
+
+namespace externalDeviceDriver {
+
+uint8_t buildBurstPlans(const externalDeviceRegisterRange* ranges, uint8_t rangeCount, burstPlan* burstsOut) {
+  uint8_t burstCount = 0;
+  for (uint8_t index = 0; index < rangeCount; ++index) {
+    const externalDeviceRegisterRange& range = ranges[index];
+    if (range.length == 0 || range.length > kMaxBurstBytes) {
+      return 0;
+    }
+    if (burstCount > 0) {
+      burstPlan& last = burstsOut[burstCount - 1];
+      const uint16_t lastEnd = static_cast<uint16_t>(last.startRegister + last.length);
+      const uint16_t mergedEnd = static_cast<uint16_t>(range.startRegister + range.length);
+      if (range.startRegister >= last.startRegister && range.startRegister <= lastEnd + kMergeGapBytes &&
+          mergedEnd - last.startRegister <= kMaxBurstBytes) {
+        if (mergedEnd > lastEnd) {
+          last.length = static_cast<uint8_t>(mergedEnd - last.startRegister);
+        }
+        continue;
+      }
+    }
+    if (burstCount >= kExternalDeviceMaxRanges) {
+      return 0;
+    }
+    burstsOut[burstCount].startRegister = range.startRegister;
+    burstsOut[burstCount].length = range.length;
+    ++burstCount;
+  }
+  return burstCount;
+}
 
-  if (externalDeviceTaskStackBuffer == nullptr) {
-    externalDeviceTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+}  // namespace externalDeviceDriver
+
+namespace {
+
+using externalDeviceDriver::buildBurstPlans;
+
+/**
+ * @brief バースト計画どおりに読み、各読取範囲を並び順に連結してバッファへ置く。
+ * @return 全バースト成功時true。
+ */
+bool readRangesIntoBuffer(externalDeviceBus& bus,
+                          uint8_t address,
+                          const externalDeviceRegisterRange* ranges,
+                          uint8_t rangeCount,
+                          const burstPlan* bursts,
+                          uint8_t burstCount,
+                          uint8_t* bufferOut) {
+  uint8_t burstBuffer[kMaxBurstBytes];
+  for (uint8_t burstIndex = 0; burstIndex < burstCount; ++burstIndex) {
+    const burstPlan& burst = bursts[burstIndex];
+    ++busStats.transactionCount;
+    if (!bus.readRegisters(address, burst.startRegister, burstBuffer, burst.length)) {
+      ++busStats.failedTransactionCount;
+      return false;
+    }
+    uint16_t frameOffset = 0;
+    for (uint8_t rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex) {
+      const externalDeviceRegisterRange& range = ranges[rangeIndex];
+      if (range.startRegister >= burst.startRegister &&
+          range.startRegister + range.length <= burst.startRegister + burst.length) {
+        memcpy(&bufferOut[frameOffset], &burstBuffer[range.startRegister - burst.startRegister], range.length);
+      }
+      frameOffset = static_cast<uint16_t>(frameOffset + range.length);
+    }
   }
-  if (externalDeviceTaskStackBuffer == nullptr) {
-    appLogWarn("externalDeviceTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    externalDeviceTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+  return true;
+}
+
+/**
+ * @brief 書込み手順を実行する。
+ * @return 全手順成功時true。
+ */
+bool runWriteSequence(externalDeviceBus& bus,
+                      uint8_t address,
+                      const externalDeviceRegisterWrite* sequence,
+                      uint8_t sequenceLength) {
+  for (uint8_t index = 0; index < sequenceLength; ++index) {
+    ++busStats.transactionCount;
+    if (!bus.writeRegister(address, sequence[index].registerAddress, sequence[index].value)) {
+      ++busStats.failedTransactionCount;
+      return false;
+    }
+    if (sequence[index].delayAfterMs > 0) {
+      vTaskDelay(pdMS_TO_TICKS(sequence[index].delayAfterMs));
+    }
   }
-  if (externalDeviceTaskStackBuffer == nullptr) {
-    appLogError("externalDeviceTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
+  return true;
+}
+
+/**
+ * @brief 範囲の合計バイト数。
+ */
+uint16_t sumRangeBytes(const externalDeviceRegisterRange* ranges, uint8_t rangeCount) {
+  uint16_t totalBytes = 0;
+  for (uint8_t index = 0; index < rangeCount; ++index) {
+    totalBytes = static_cast<uint16_t>(totalBytes + ranges[index].length);
+  }
+  return totalBytes;
+}
+
+/**
+ * @brief デバイスを未検出扱いへ戻し、無効なスナップショットを公開する。
+ */
+void markDeviceAbsent(uint8_t deviceIndex, uint32_t nowMs) {
+  deviceRuntime& runtime = deviceRuntimeTable[deviceIndex];
+  runtime.state = deviceState::kAbsent;
+  runtime.retryAtMs = nowMs + kReprobeIntervalMs;
+  externalDeviceReading reading{};
+  reading.isValid = false;
+  reading.address = runtime.address;
+  reading.capturedAtMs = nowMs;
+  reading.sampleCount = runtime.sampleCount;
+  publishSnapshot(deviceIndex, reading);
+}
+
+/**
+ * @brief デバイスを探索し、初期化手順と校正値読取を行う。
+ * @param bus バス実装。
+ * @param deviceIndex デバイス番号。
+ * @param nowMs 現在時刻(millis)。
+ * @return 初期化成功時true。
+ */
+bool probeAndInitializeDevice(externalDeviceBus& bus, uint8_t deviceIndex, uint32_t nowMs) {
+  const externalDeviceDescriptor& descriptor = kDeviceDescriptors[deviceIndex];
+  deviceRuntime& runtime = deviceRuntimeTable[deviceIndex];
+  const bool wasUnprobed = (runtime.state == deviceState::kUnprobed);
+
+  uint8_t foundAddress = 0;
+  for (uint8_t index = 0; index < descriptor.candidateAddressCount && foundAddress == 0; ++index) {
+    const uint8_t candidate = descriptor.candidateAddresses[index];
+    if (!bus.probe(candidate)) {
+      continue;
+    }
+    if (descriptor.hasChipId) {
+      uint8_t chipId = 0;
+      if (!bus.readRegisters(candidate, descriptor.chipIdRegister, &chipId, 1) || chipId != descriptor.expectedChipId) {
+        appLogWarn("externalDeviceDriver probe skipped. chip id mismatch. device=%s address=0x%02X chipId=0x%02X expected=0x%02X",
+                   descriptor.name,
+                   static_cast<unsigned>(candidate),
+                   static_cast<unsigned>(chipId),
+                   static_cast<unsigned>(descriptor.expectedChipId));
+        continue;
+      }
+    }
+    foundAddress = candidate;
+  }
+  if (foundAddress == 0) {
+    // [推奨] 未接続のまま運用する構成もあるため、警告は初回だけ出す。
+    if (wasUnprobed) {
+      appLogWarn("externalDeviceDriver probe failed. device=%s retryMs=%lu",
+                 descriptor.name,
+                 static_cast<unsigned long>(kReprobeIntervalMs));
+    }
+    markDeviceAbsent(deviceIndex, nowMs);
     return false;
   }
+  runtime.address = foundAddress;
 
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "externalDeviceTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      externalDeviceTaskStackBuffer,
-      &externalDeviceTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("externalDeviceTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  const uint16_t frameBytes = sumRangeBytes(descriptor.readRanges, descriptor.readRangeCount);
+  const uint16_t calibrationBytes = sumRangeBytes(descriptor.calibrationRanges, descriptor.calibrationRangeCount);
+  burstPlan calibrationBursts[kExternalDeviceMaxRanges] = {};
+  const uint8_t calibrationBurstCount =
+      buildBurstPlans(descriptor.calibrationRanges, descriptor.calibrationRangeCount, calibrationBursts);
+  runtime.readBurstCount = buildBurstPlans(descriptor.readRanges, descriptor.readRangeCount, runtime.readBursts);
+  if (frameBytes > kExternalDeviceMaxFrameBytes || calibrationBytes > kExternalDeviceMaxCalibrationBytes ||
+      runtime.readBurstCount == 0 || (descriptor.calibrationRangeCount > 0 && calibrationBurstCount == 0)) {
+    appLogError("externalDeviceDriver initialize failed. invalid descriptor ranges. device=%s frameBytes=%u calibrationBytes=%u",
+                descriptor.name,
+                static_cast<unsigned>(frameBytes),
+                static_cast<unsigned>(calibrationBytes));
+    markDeviceAbsent(deviceIndex, nowMs);
     return false;
   }
-  appLogInfo("externalDeviceTask created.");
+
+  if (!runWriteSequence(bus, foundAddress, descriptor.initSequence, descriptor.initSequenceLength) ||
+      !readRangesIntoBuffer(bus,
+                            foundAddress,
+                            descriptor.calibrationRanges,
+                            descriptor.calibrationRangeCount,
+                            calibrationBursts,
+                            calibrationBurstCount,
+                            runtime.calibration)) {
+    appLogError("externalDeviceDriver initialize failed. device=%s address=0x%02X",
+                descriptor.name,
+                static_cast<unsigned>(foundAddress));
+    markDeviceAbsent(deviceIndex, nowMs);
+    return false;
+  }
+
+  runtime.state = deviceState::kReady;
+  runtime.consecutiveFailures = 0;
+  runtime.nextDueMs = nowMs;
+  appLogInfo("externalDeviceDriver initialize success. device=%s address=0x%02X periodMs=%lu readBursts=%u frameBytes=%u",
+             descriptor.name,
+             static_cast<unsigned>(foundAddress),
+             static_cast<unsigned long>(descriptor.periodMs),
+             static_cast<unsigned>(runtime.readBurstCount),
+             static_cast<unsigned>(frameBytes));
   return true;
 }
 
-void externalDeviceTask::taskEntry(void* taskParameter) {
-  externalDeviceTask* self = static_cast<externalDeviceTask*>(taskParameter);
-  self->runLoop();
+/**
+ * @brief 測定失敗を記録し、連続失敗なら未検出扱いへ戻す。
+ */
+void recordMeasurementFailure(uint8_t deviceIndex, uint32_t nowMs, const char* stage) {
+  deviceRuntime& runtime = deviceRuntimeTable[deviceIndex];
+  ++runtime.consecutiveFailures;
+  appLogWarn("externalDeviceDriver measurement failed. device=%s stage=%s consecutiveFailures=%u",
+             kDeviceDescriptors[deviceIndex].name,
+             stage,
+             static_cast<unsigned>(runtime.consecutiveFailures));
+  if (runtime.consecutiveFailures >= kMaxConsecutiveFailures) {
+    appLogError("externalDeviceDriver device lost. device=%s address=0x%02X retryMs=%lu",
+                kDeviceDescriptors[deviceIndex].name,
+                static_cast<unsigned>(runtime.address),
+                static_cast<unsigned long>(kReprobeIntervalMs));
+    markDeviceAbsent(deviceIndex, nowMs);
+  }
+}
+
+/**
+ * @brief バス利用統計を一定バッチごとにログへ出す。
+ */
+void logBusStatisticsIfDue(uint32_t nowMs) {
+  if (busStats.batchCount == 0 || (busStats.batchCount % kStatisticsLogBatchInterval) != 0) {
+    return;
+  }
+  const uint32_t elapsedMs = nowMs - busStats.firstBatchAtMs;
+  const uint32_t utilizationPermille =
+      (elapsedMs == 0) ? 0 : static_cast<uint32_t>(busStats.busBusyUs / static_cast<uint64_t>(elapsedMs));
+  appLogInfo("externalDeviceDriver bus stats. batches=%lu transactions=%lu failed=%lu busyMs=%lu utilization=%lu.%lu%%",
+             static_cast<unsigned long>(busStats.batchCount),
+             static_cast<unsigned long>(busStats.transactionCount),
+             static_cast<unsigned long>(busStats.failedTransactionCount),
+             static_cast<unsigned long>(busStats.busBusyUs / 1000),
+             static_cast<unsigned long>(utilizationPermille / 10),
+             static_cast<unsigned long>(utilizationPermille % 10));
 }
+}  // namespace
+
+namespace externalDeviceDriver {
 
-void externalDeviceTask::runLoop() {
+uint32_t runDueDevices(externalDeviceBus& bus, uint32_t nowMs) {
+  // (0) 未探索・再探索時刻を過ぎた（または即時測定を要求された）デバイスを初期化する
+  for (uint8_t index = 0; index < kDeviceCount; ++index) {
+    deviceRuntime& runtime = deviceRuntimeTable[index];
+    const bool immediate = immediateReadRequested[index].load(std::memory_order_acquire);
+    if (runtime.state == deviceState::kUnprobed ||
+        (runtime.state == deviceState::kAbsent && (immediate || isTimeReached(nowMs, runtime.retryAtMs)))) {
+      probeAndInitializeDevice(bus, index, nowMs);
+    }
+  }
+
+  // (1) 今回のバッチに入れるデバイスを決める（窓内に来るものは前倒し）
+  bool isDue[kDeviceCount] = {};
+  uint8_t dueCount = 0;
+  for (uint8_t index = 0; index < kDeviceCount; ++index) {
+    const deviceRuntime& runtime = deviceRuntimeTable[index];
+    const bool immediate = immediateReadRequested[index].exchange(false, std::memory_order_acq_rel);
+    if (runtime.state != deviceState::kReady) {
+      continue;
+    }
+    if (immediate || isTimeReached(nowMs + kBatchWindowMs, runtime.nextDueMs)) {
+      isDue[index] = true;
+      ++dueCount;
+    }
+  }
+
+  if (dueCount > 0) {
+    if (busStats.batchCount == 0) {
+      busStats.firstBatchAtMs = nowMs;
+    }
+    ++busStats.batchCount;
+
+    // (2) 全デバイスのトリガを連続で書き、変換待ちは最長の1回だけにする
+    uint32_t busyStartUs = micros();
+    uint16_t conversionDelayMs = 0;
+    for (uint8_t index = 0; index < kDeviceCount; ++index) {
+      if (!isDue[index]) {
+        continue;
+      }
+      const externalDeviceDescriptor& descriptor = kDeviceDescriptors[index];
+      if (!runWriteSequence(bus, deviceRuntimeTable[index].address, descriptor.triggerSequence, descriptor.triggerSequenceLength)) {
+        isDue[index] = false;
+        recordMeasurementFailure(index, nowMs, "trigger");
+        continue;
+      }
+      if (descriptor.conversionDelayMs > conversionDelayMs) {
+        conversionDelayMs = descriptor.conversionDelayMs;
+      }
+    }
+    busStats.busBusyUs += static_cast<uint32_t>(micros() - busyStartUs);
+    if (conversionDelayMs > 0) {
+      vTaskDelay(pdMS_TO_TICKS(conversionDelayMs));
+    }
+
+    // (3) 全デバイスの読取バーストを連続実行し、変換してスナップショットへ公開する
+    busyStartUs = micros();
+    const uint32_t capturedAtMs = millis();
+    for (uint8_t index = 0; index < kDeviceCount; ++index) {
+      if (!isDue[index]) {
+        continue;
+      }
+      const externalDeviceDescriptor& descriptor = kDeviceDescriptors[index];
+      deviceRuntime& runtime = deviceRuntimeTable[index];
+      uint8_t frame[kExternalDeviceMaxFrameBytes] = {};
+      if (!readRangesIntoBuffer(bus,
+                                runtime.address,
+                                descriptor.readRanges,
+                                descriptor.readRangeCount,
+                                runtime.readBursts,
+                                runtime.readBurstCount,
+                                frame)) {
+        recordMeasurementFailure(index, nowMs, "read");
+        continue;
+      }
+      externalDeviceReading reading{};
+      reading.address = runtime.address;
+      reading.capturedAtMs = capturedAtMs;
+      if (!descriptor.decode(runtime.calibration, frame, &reading)) {
+        recordMeasurementFailure(index, nowMs, "decode");
+        continue;
+      }
+      runtime.consecutiveFailures = 0;
+      ++runtime.sampleCount;
+      reading.isValid = true;
+      reading.sampleCount = runtime.sampleCount;
+      publishSnapshot(index, reading);
+
+      // 時間軸を保って次の予定を決める（大きく遅れた場合は今から1周期後へ寄せ直す）
+      runtime.nextDueMs += descriptor.periodMs;
+      if (isTimeReached(nowMs, runtime.nextDueMs)) {
+        runtime.nextDueMs = nowMs + descriptor.periodMs;
+      }
+    }
+    busStats.busBusyUs += static_cast<uint32_t>(micros() - busyStartUs);
+    logBusStatisticsIfDue(millis());
+  }
+
+  // (4) 次の予定までの待機時間
+  uint32_t waitMs = kMaxIdleWaitMs;
+  for (uint8_t index = 0; index < kDeviceCount; ++index) {
+    const deviceRuntime& runtime = deviceRuntimeTable[index];
+    const uint32_t targetMs = (runtime.state == deviceState::kReady) ? runtime.nextDueMs : runtime.retryAtMs;
+    if (runtime.state == deviceState::kUnprobed) {
+      continue;
+    }
+    const uint32_t untilMs = isTimeReached(nowMs, targetMs) ? 0 : (targetMs - nowMs);
+    if (untilMs < waitMs) {
+      waitMs = untilMs;
+    }
+  }
+  return (waitMs == 0) ? 1 : waitMs;
+}
+
+void requestImmediateRead(externalDeviceId deviceId) {
+  const uint8_t deviceIndex = static_cast<uint8_t>(deviceId);
+  if (deviceIndex >= kDeviceCount) {
+    appLogError("externalDeviceDriver::requestImmediateRead failed. invalid deviceId=%u", static_cast<unsigned>(deviceIndex));
+    return;
+  }
+  immediateReadRequested[deviceIndex].store(true, std::memory_order_release);
+}
+
+bool readSnapshot(externalDeviceId deviceId, externalDeviceReading* readingOut) {
+  const uint8_t deviceIndex = static_cast<uint8_t>(deviceId);
+  if (readingOut == nullptr || deviceIndex >= kDeviceCount) {
+    appLogError("externalDeviceDriver::readSnapshot failed. invalid argument. deviceId=%u", static_cast<unsigned>(deviceIndex));
+    return false;
+  }
+  const snapshotSlot& slot = snapshotTable[deviceIndex];
+  for (uint8_t attempt = 0; attempt < kSnapshotReadRetryCount; ++attempt) {
+    const uint32_t sequenceBefore = slot.sequence.load(std::memory_order_acquire);
+    if ((sequenceBefore & 1U) != 0) {
+      taskYIELD();  // 書込み中（I2C 専用タスクが memcpy 中）
+      continue;
+    }
+    memcpy(readingOut, &slot.reading, sizeof(*readingOut));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequenceBefore) {
+      return true;
+    }
+  }
+  appLogWarn("externalDeviceDriver::readSnapshot failed. writer busy. device=%s", getDeviceName(deviceId));
+  return false;
+}
+
+const char* getDeviceName(externalDeviceId deviceId) {
+  const uint8_t deviceIndex = static_cast<uint8_t>(deviceId);
+  return (deviceIndex < kDeviceCount) ? kDeviceDescriptors[deviceIndex].name : "unknown";
+}
+
+}  // namespace externalDeviceDriver
+
+bool externalDeviceTask::attachToFlowScheduler(flowRuntime::flowScheduler* schedulerOut) {
+  if (schedulerOut == nullptr) {
+    appLogError("externalDeviceTask::attachToFlowScheduler failed. schedulerOut is null.");
+    return false;
+  }
   interTaskMessageService& messageService = getInterTaskMessageService();
-  appLogInfo("externalDeviceTask loop started. (skeleton)");
-  for (;;) {
-    appTaskMessage receivedMessage{};
-    bool receiveResult = messageService.receiveMessage(appTaskId::kExternalDevice, &receivedMessage, pdMS_TO_TICKS(50));
-    if (receiveResult && receivedMessage.messageType == appMessageType::kStartupRequest) {
-      appTaskMessage responseMessage{};
-      responseMessage.sourceTaskId = appTaskId::kExternalDevice;
-      responseMessage.destinationTaskId = appTaskId::kMain;
-      responseMessage.messageType = appMessageType::kStartupAck;
-      responseMessage.intValue = 1;
-      strncpy(responseMessage.text, "externalDeviceTask startup ack", sizeof(responseMessage.text) - 1);
-      responseMessage.text[sizeof(responseMessage.text) - 1] = '\0';
-      messageService.sendMessage(responseMessage, pdMS_TO_TICKS(100));
-    }
-
-    // TODO: センサー/アクチュエータ等の外部デバイス管理を実装する。
-    vTaskDelay(pdMS_TO_TICKS(1000));
+  messageService.registerTaskQueue(appTaskId::kExternalDevice, 8);
+  if (!schedulerOut->registerMailbox(appTaskId::kExternalDevice) ||
+      !schedulerOut->addFlow(&externalDeviceStartupAckFlow, appTaskId::kExternalDevice)) {
+    appLogError("externalDeviceTask::attachToFlowScheduler failed. scheduler registration failed.");
+    return false;
   }
+  appLogInfo("externalDeviceTask attached to flow scheduler. (no dedicated stack)");
+  return true;
 }
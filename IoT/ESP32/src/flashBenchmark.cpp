@@ -0,0 +1,318 @@
+/**
+ * @file flashBenchmark.cpp
+ * @brief LittleFS 上のフラッシュ I/O 計測の実装。
+ * @details
+ * - [重要] 1ブロックサイズにつき、順次書込み → 順次読出し → ランダム読出し → ランダム書込み → fsync の順に
+ *   同じ試験ファイルを使って計測する。ランダム系は順次書込み済みのファイル内をブロック単位で選ぶ。
+ * - [重要] fsync は「1ブロック追記 + flush」を1回として計測する（ログ追記と同じ書き方）。
+ * - [重要] 時間計測は micros() の差分で行う。集計（度数分布・KB/s）は diagnosticStats を使う。
+ */
+
+#include "flashBenchmark.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <cJSON.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+
+#include "diagnosticStats.h"
+#include "log.h"
+
+namespace {
+
+/** @brief 計測するブロックサイズ(byte)。@type uint16_t[] */
+constexpr uint16_t kBlockSizes[kFlashBenchmarkBlockSizeCount] = {256, 512, 1024, 4096};
+/** @brief 作業領域。@type const char* */
+constexpr const char* kScratchDirectory = "/bench";
+/** @brief 試験ファイル。@type const char* */
+constexpr const char* kDataFilePath = "/bench/data.bin";
+/** @brief fsync 計測用ファイル。@type const char* */
+constexpr const char* kSyncFilePath = "/bench/sync.bin";
+/** @brief メタデータ計測用ファイル（rename 前）。@type const char* */
+constexpr const char* kMetaFilePath = "/bench/meta.bin";
+/** @brief メタデータ計測用ファイル（rename 後）。@type const char* */
+constexpr const char* kMetaRenamedFilePath = "/bench/meta2.bin";
+/** @brief 空き容量の余裕(byte)。LittleFS のメタデータ分。@type uint32_t */
+constexpr uint32_t kFreeSpaceMarginBytes = 16384;
+
+/** @brief 読み書き用バッファ（最大ブロックサイズ分）。 */
+uint8_t benchmarkBuffer[4096];
+/** @brief 実行中フラグの排他。 */
+portMUX_TYPE benchmarkLock = portMUX_INITIALIZER_UNLOCKED;
+/** @brief 実行中フラグ。 */
+bool isBenchmarkRunning = false;
+
+/**
+ * @brief 計測項目を初期化する。
+ */
+flashBenchmarkMetric* beginMetric(flashBenchmarkReport* report, const char* name, uint16_t blockSize) {
+  flashBenchmarkMetric& metric = report->metrics[report->metricCount++];
+  metric = flashBenchmarkMetric{};
+  metric.name = name;
+  metric.blockSize = blockSize;
+  metric.minUs = UINT32_MAX;
+  return &metric;
+}
+
+/**
+ * @brief 1回分の所要時間を計測項目へ加える。
+ */
+void recordSample(flashBenchmarkMetric* metric, uint32_t elapsedUs, uint32_t transferredBytes, bool isSuccess) {
+  ++metric->count;
+  if (!isSuccess) {
+    ++metric->errorCount;
+  }
+  metric->bytes += transferredBytes;
+  metric->totalUs += elapsedUs;
+  metric->minUs = (elapsedUs < metric->minUs) ? elapsedUs : metric->minUs;
+  metric->maxUs = (elapsedUs > metric->maxUs) ? elapsedUs : metric->maxUs;
+  diagnosticStats::recordLog2Bucket(metric->buckets, kFlashBenchmarkBucketCount, elapsedUs);
+}
+
+/**
+ * @brief 作業領域の試験ファイルを消す。
+ */
+void removeScratchFiles() {
+  const char* const scratchFiles[] = {kDataFilePath, kSyncFilePath, kMetaFilePath, kMetaRenamedFilePath};
+  for (const char* scratchFile : scratchFiles) {
+    if (LittleFS.exists(scratchFile)) {
+      LittleFS.remove(scratchFile);
+    }
+  }
+}
+
+/**
+ * @brief 1ブロックサイズ分のデータ計測を行う。
+ */
+void measureDataMetrics(uint16_t blockSize, const flashBenchmarkOptions& options, flashBenchmarkReport* report) {
+  const uint32_t blockCount = options.fileBytes / blockSize;
+
+  flashBenchmarkMetric* seqWrite = beginMetric(report, "seqWrite", blockSize);
+  File dataFile = LittleFS.open(kDataFilePath, "w");
+  for (uint32_t blockIndex = 0; blockIndex < blockCount && dataFile; ++blockIndex) {
+    benchmarkBuffer[0] = static_cast<uint8_t>(blockIndex);
+    const uint32_t startUs = micros();
+    const size_t writtenSize = dataFile.write(benchmarkBuffer, blockSize);
+    recordSample(seqWrite, micros() - startUs, writtenSize, writtenSize == blockSize);
+  }
+  if (dataFile) {
+    // [重要] close 時の書き戻しも順次書込みの所要時間に含める。
+    const uint32_t startUs = micros();
+    dataFile.close();
+    seqWrite->totalUs += micros() - startUs;
+  } else {
+    ++seqWrite->errorCount;
+  }
+
+  flashBenchmarkMetric* seqRead = beginMetric(report, "seqRead", blockSize);
+  dataFile = LittleFS.open(kDataFilePath, "r");
+  for (uint32_t blockIndex = 0; blockIndex < blockCount && dataFile; ++blockIndex) {
+    const uint32_t startUs = micros();
+    const size_t readSize = dataFile.read(benchmarkBuffer, blockSize);
+    recordSample(seqRead, micros() - startUs, readSize, readSize == blockSize);
+  }
+
+  flashBenchmarkMetric* randRead = beginMetric(report, "randRead", blockSize);
+  for (uint16_t operationIndex = 0; operationIndex < options.randomOperationCount && dataFile; ++operationIndex) {
+    const uint32_t offset = (esp_random() % blockCount) * blockSize;
+    const uint32_t startUs = micros();
+    const bool seekResult = dataFile.seek(offset);
+    const size_t readSize = seekResult ? dataFile.read(benchmarkBuffer, blockSize) : 0;
+    recordSample(randRead, micros() - startUs, readSize, readSize == blockSize);
+  }
+  if (dataFile) {
+    dataFile.close();
+  } else {
+    ++seqRead->errorCount;
+  }
+
+  flashBenchmarkMetric* randWrite = beginMetric(report, "randWrite", blockSize);
+  dataFile = LittleFS.open(kDataFilePath, "r+");
+  for (uint16_t operationIndex = 0; operationIndex < options.randomOperationCount && dataFile; ++operationIndex) {
+    const uint32_t offset = (esp_random() % blockCount) * blockSize;
+    const uint32_t startUs = micros();
+    const bool seekResult = dataFile.seek(offset);
+    const size_t writtenSize = seekResult ? dataFile.write(benchmarkBuffer, blockSize) : 0;
+    recordSample(randWrite, micros() - startUs, writtenSize, writtenSize == blockSize);
+  }
+  if (dataFile) {
+    const uint32_t startUs = micros();
+    dataFile.close();
+    randWrite->totalUs += micros() - startUs;
+  } else {
+    ++randWrite->errorCount;
+  }
+
+  flashBenchmarkMetric* fsyncMetric = beginMetric(report, "fsync", blockSize);
+  File syncFile = LittleFS.open(kSyncFilePath, "w");
+  for (uint16_t operationIndex = 0; operationIndex < options.metaOperationCount && syncFile; ++operationIndex) {
+    const uint32_t startUs = micros();
+    const size_t writtenSize = syncFile.write(benchmarkBuffer, blockSize);
+    syncFile.flush();
+    recordSample(fsyncMetric, micros() - startUs, writtenSize, writtenSize == blockSize);
+  }
+  if (syncFile) {
+    syncFile.close();
+  } else {
+    ++fsyncMetric->errorCount;
+  }
+  removeScratchFiles();
+}
+
+/**
+ * @brief open / rename / remove の計測を行う。
+ */
+void measureMetaMetrics(const flashBenchmarkOptions& options, flashBenchmarkReport* report) {
+  flashBenchmarkMetric* openMetric = beginMetric(report, "open", 0);
+  flashBenchmarkMetric* renameMetric = beginMetric(report, "rename", 0);
+  flashBenchmarkMetric* removeMetric = beginMetric(report, "remove", 0);
+  for (uint16_t operationIndex = 0; operationIndex < options.metaOperationCount; ++operationIndex) {
+    uint32_t startUs = micros();
+    File metaFile = LittleFS.open(kMetaFilePath, "w");
+    const bool openResult = static_cast<bool>(metaFile);
+    recordSample(openMetric, micros() - startUs, 0, openResult);
+    if (!openResult) {
+      continue;
+    }
+    metaFile.write(benchmarkBuffer, 64);
+    metaFile.close();
+
+    startUs = micros();
+    const bool renameResult = LittleFS.rename(kMetaFilePath, kMetaRenamedFilePath);
+    recordSample(renameMetric, micros() - startUs, 0, renameResult);
+
+    startUs = micros();
+    const bool removeResult = LittleFS.remove(renameResult ? kMetaRenamedFilePath : kMetaFilePath);
+    recordSample(removeMetric, micros() - startUs, 0, removeResult);
+  }
+  removeScratchFiles();
+}
+}  // namespace
+
+namespace flashBenchmark {
+
+flashBenchmarkOptions getDefaultOptions() {
+  flashBenchmarkOptions options{};
+  options.fileBytes = 16384;
+  options.randomOperationCount = 32;
+  options.metaOperationCount = 16;
+  return options;
+}
+
+bool run(const flashBenchmarkOptions& options, flashBenchmarkReport* reportOut, const char** detailOut) {
+  const char* detailText = "ok";
+  if (reportOut == nullptr) {
+    appLogError("flashBenchmark::run failed. reportOut is null.");
+    return false;
+  }
+  *reportOut = flashBenchmarkReport{};
+  portENTER_CRITICAL(&benchmarkLock);
+  const bool wasRunning = isBenchmarkRunning;
+  isBenchmarkRunning = true;
+  portEXIT_CRITICAL(&benchmarkLock);
+  if (wasRunning) {
+    if (detailOut != nullptr) {
+      *detailOut = "benchmark is already running";
+    }
+    appLogWarn("flashBenchmark::run rejected. already running.");
+    return false;
+  }
+
+  bool runResult = false;
+  do {
+    reportOut->options.fileBytes = diagnosticStats::clampValue(options.fileBytes, 4096, 65536);
+    reportOut->options.randomOperationCount = static_cast<uint16_t>(diagnosticStats::clampValue(options.randomOperationCount, 1, 128));
+    reportOut->options.metaOperationCount = static_cast<uint16_t>(diagnosticStats::clampValue(options.metaOperationCount, 1, 64));
+    if (!LittleFS.begin(false)) {
+      detailText = "filesystem is unavailable";
+      break;
+    }
+    reportOut->totalBytes = static_cast<uint32_t>(LittleFS.totalBytes());
+    reportOut->usedBytes = static_cast<uint32_t>(LittleFS.usedBytes());
+    const uint32_t freeBytes = reportOut->totalBytes - reportOut->usedBytes;
+    if (freeBytes < reportOut->options.fileBytes * 2 + kFreeSpaceMarginBytes) {
+      detailText = "not enough free space";
+      break;
+    }
+    if (!LittleFS.exists(kScratchDirectory) && !LittleFS.mkdir(kScratchDirectory)) {
+      detailText = "scratch directory create failed";
+      break;
+    }
+    for (size_t byteIndex = 0; byteIndex < sizeof(benchmarkBuffer); ++byteIndex) {
+      benchmarkBuffer[byteIndex] = static_cast<uint8_t>(byteIndex * 31U + 7U);
+    }
+
+    const uint32_t startMs = millis();
+    for (uint8_t sizeIndex = 0; sizeIndex < kFlashBenchmarkBlockSizeCount; ++sizeIndex) {
+      measureDataMetrics(kBlockSizes[sizeIndex], reportOut->options, reportOut);
+    }
+    measureMetaMetrics(reportOut->options, reportOut);
+    reportOut->elapsedMs = millis() - startMs;
+    LittleFS.rmdir(kScratchDirectory);
+    runResult = true;
+  } while (false);
+
+  portENTER_CRITICAL(&benchmarkLock);
+  isBenchmarkRunning = false;
+  portEXIT_CRITICAL(&benchmarkLock);
+  if (detailOut != nullptr) {
+    *detailOut = detailText;
+  }
+  if (!runResult) {
+    appLogError("flashBenchmark::run failed. %s total=%lu used=%lu",
+                detailText,
+                static_cast<unsigned long>(reportOut->totalBytes),
+                static_cast<unsigned long>(reportOut->usedBytes));
+    return false;
+  }
+  appLogInfo("flashBenchmark::run success. elapsedMs=%lu fileBytes=%lu metrics=%u",
+             static_cast<unsigned long>(reportOut->elapsedMs),
+             static_cast<unsigned long>(reportOut->options.fileBytes),
+             static_cast<unsigned>(reportOut->metricCount));
+  return true;
+}
+
+bool appendReportToJson(const flashBenchmarkReport& report, cJSON* objectOut) {
+  if (objectOut == nullptr) {
+    appLogError("flashBenchmark::appendReportToJson failed. objectOut is null.");
+    return false;
+  }
+  cJSON_AddNumberToObject(objectOut, "totalBytes", report.totalBytes);
+  cJSON_AddNumberToObject(objectOut, "usedBytes", report.usedBytes);
+  cJSON_AddNumberToObject(objectOut, "elapsedMs", report.elapsedMs);
+  cJSON* optionsObject = cJSON_AddObjectToObject(objectOut, "options");
+  cJSON* metricsArray = cJSON_AddArrayToObject(objectOut, "metrics");
+  if (optionsObject == nullptr || metricsArray == nullptr) {
+    appLogError("flashBenchmark::appendReportToJson failed. cJSON allocation failed.");
+    return false;
+  }
+  cJSON_AddNumberToObject(optionsObject, "fileBytes", report.options.fileBytes);
+  cJSON_AddNumberToObject(optionsObject, "randomOps", report.options.randomOperationCount);
+  cJSON_AddNumberToObject(optionsObject, "metaOps", report.options.metaOperationCount);
+
+  for (uint8_t metricIndex = 0; metricIndex < report.metricCount; ++metricIndex) {
+    const flashBenchmarkMetric& metric = report.metrics[metricIndex];
+    cJSON* metricObject = cJSON_CreateObject();
+    if (metricObject == nullptr) {
+      appLogError("flashBenchmark::appendReportToJson failed. cJSON_CreateObject returned null.");
+      return false;
+    }
+    cJSON_AddStringToObject(metricObject, "name", metric.name);
+    cJSON_AddNumberToObject(metricObject, "blockSize", metric.blockSize);
+    cJSON_AddNumberToObject(metricObject, "count", metric.count);
+    cJSON_AddNumberToObject(metricObject, "errors", metric.errorCount);
+    cJSON_AddNumberToObject(metricObject, "minUs", metric.count > 0 ? metric.minUs : 0);
+    cJSON_AddNumberToObject(metricObject, "maxUs", metric.maxUs);
+    cJSON_AddNumberToObject(metricObject, "avgUs", metric.count > 0 ? metric.totalUs / metric.count : 0);
+    if (metric.bytes > 0 && metric.totalUs > 0) {
+      cJSON_AddNumberToObject(metricObject, "kbps", diagnosticStats::computeKiloBytesPerSecond(metric.bytes, metric.totalUs));
+    }
+    diagnosticStats::appendBucketsToJson(metricObject, "buckets", metric.buckets, kFlashBenchmarkBucketCount);
+    cJSON_AddItemToArray(metricsArray, metricObject);
+  }
+  return true;
+}
+
+}  // namespace flashBenchmark
@@ -0,0 +1,704 @@
+/**
+ * @file flowRuntime.cpp
+ * @brief 協調型フロー実行基盤の実装。
+ * @details
+ * - [重要] 待機の唯一のブロック点は `receiveFromMailboxes()` であり、メッセージ待機中はその到着で即時に起床する。
+ * - [重要] タイムアウト判定は `nowMs - waitStartedAtMs >= timeoutMs` の差分比較で行い、millis() の桁あふれに耐える。
+ * - [厳守] ヒープ確保はしない（コルーチンフレームを除く）。
+ */
+
+#include "flowRuntime.h"
+
+#include <string.h>
+
+#include "log.h"
+
+#if defined(ESP_PLATFORM)
+#include <Arduino.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#endif
+
+namespace {
+
+#if defined(ESP_PLATFORM)
+uint32_t freeRtosNowMs() {
+  return millis();
+}
+
+bool freeRtosReceiveMessage(appTaskId taskId, appTaskMessage* messageOut, uint32_t waitMs) {
+  return getInterTaskMessageService().receiveMessage(taskId, messageOut, pdMS_TO_TICKS(waitMs));
+}
+
+bool freeRtosSendMessage(const appTaskMessage& message, uint32_t timeoutMs) {
+  return getInterTaskMessageService().sendMessage(message, pdMS_TO_TICKS(timeoutMs));
+}
+
+void freeRtosDelayMs(uint32_t delayMs) {
+  vTaskDelay(pdMS_TO_TICKS(delayMs));
+}
+
+bool freeRtosReceiveQueueItem(void* queueHandle, void* itemOut) {
+  return xQueueReceive(static_cast<QueueHandle_t>(queueHandle), itemOut, 0) == pdTRUE;
+}
+
+int32_t lwipPollSocketReadable(int32_t socketFd) {
+  fd_set readSet;
+  FD_ZERO(&readSet);
+  FD_SET(socketFd, &readSet);
+  struct timeval zeroTimeout {};
+  const int selectResult = select(socketFd + 1, &readSet, nullptr, nullptr, &zeroTimeout);
+  if (selectResult < 0) {
+    return -1;
+  }
+  return (selectResult > 0 && FD_ISSET(socketFd, &readSet)) ? 1 : 0;
+}
+
+const flowRuntime::flowPlatform freeRtosFlowPlatform = {
+    freeRtosNowMs,
+    freeRtosReceiveMessage,
+    freeRtosSendMessage,
+    freeRtosDelayMs,
+    freeRtosReceiveQueueItem,
+    lwipPollSocketReadable,
+};
+#endif
+
+/**
+ * @brief 待機の残り時間を返す。
+ * @param startedAtMs 待機開始時刻。
+ * @param timeoutMs タイムアウト。
+ * @param nowMs 現在時刻。
+ * @return 残りms。経過済みなら0。
+ */
+uint32_t remainingWaitMs(uint32_t startedAtMs, uint32_t timeoutMs, uint32_t nowMs) {
+  const uint32_t elapsedMs = nowMs - startedAtMs;
+  return (elapsedMs >= timeoutMs) ? 0 : (timeoutMs - elapsedMs);
+}
+
+}  // namespace
+
+namespace flowRuntime {
+
+#if defined(ESP_PLATFORM)
+const flowPlatform* getDefaultFlowPlatform() {
+  return &freeRtosFlowPlatform;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// flowBase
+// ---------------------------------------------------------------------------
+
+flowBase::flowBase(const char* flowName) : flowName_(flowName == nullptr ? "(unnamed)" : flowName) {}
+
+void flowBase::setWait(flowWaitKind waitKind, uint32_t timeoutMs) {
+  waitKind_ = waitKind;
+  hasDeadline_ = (timeoutMs != kWaitForever);
+  waitTimeoutMs_ = timeoutMs;
+  waitStartedAtMs_ = (scheduler_ != nullptr) ? scheduler_->nowMs() : 0;
+  lastWaitResult_ = flowWaitResult::kNone;
+}
+
+void flowBase::waitMessage(appTaskId expectedSourceTaskId,
+                           appMessageType expectedMessageType,
+                           const appUtil::appTaskMessageDetail* waitDetail,
+                           uint32_t timeoutMs) {
+  expectedSourceTaskId_ = expectedSourceTaskId;
+  expectedMessageType_ = expectedMessageType;
+  isAnyMessageWait_ = false;
+  waitDetail_ = waitDetail;
+  setWait(flowWaitKind::kMessage, timeoutMs);
+}
+
+void flowBase::waitAnyMessage(uint32_t timeoutMs) {
+  expectedSourceTaskId_ = appTaskId::kUnknown;
+  isAnyMessageWait_ = true;
+  waitDetail_ = nullptr;
+  setWait(flowWaitKind::kMessage, timeoutMs);
+}
+
+void flowBase::sleepFor(uint32_t durationMs) {
+  setWait(flowWaitKind::kSleep, durationMs);
+}
+
+void flowBase::yieldNow() {
+  setWait(flowWaitKind::kYield, kWaitForever);
+}
+
+void flowBase::waitSocketReadable(int32_t socketFd, uint32_t timeoutMs) {
+  socketFd_ = socketFd;
+  setWait(flowWaitKind::kSocketReadable, timeoutMs);
+}
+
+void flowBase::waitQueueItem(void* queueHandle, void* itemOut, uint32_t timeoutMs) {
+  queueHandle_ = queueHandle;
+  queueItemOut_ = itemOut;
+  setWait(flowWaitKind::kQueueItem, timeoutMs);
+}
+
+bool flowBase::sendMessage(const appTaskMessage& message, uint32_t timeoutMs) {
+  if (scheduler_ == nullptr) {
+    appLogError("flowBase::sendMessage failed. flow is not attached. flow=%s", flowName_);
+    return false;
+  }
+  return scheduler_->sendMessage(message, timeoutMs);
+}
+
+bool flowBase::startChildFlow(flowBase* childFlow, uint32_t timeoutMs) {
+  if (scheduler_ == nullptr || childFlow == nullptr) {
+    appLogError("flowBase::startChildFlow failed. flow=%s scheduler=%d childFlow=%d",
+                flowName_,
+                scheduler_ != nullptr ? 1 : 0,
+                childFlow != nullptr ? 1 : 0);
+    yieldNow();
+    return false;
+  }
+  const bool addResult = scheduler_->addFlow(childFlow, mailboxTaskId_);
+  if (!addResult) {
+    appLogError("flowBase::startChildFlow failed. flowScheduler::addFlow returned false. flow=%s child=%s",
+                flowName_,
+                childFlow->flowName());
+    yieldNow();
+    return false;
+  }
+  childFlow_ = childFlow;
+  setWait(flowWaitKind::kFlowCompletion, timeoutMs);
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// flowScheduler
+// ---------------------------------------------------------------------------
+
+bool flowScheduler::initialize(const char* schedulerName, const flowPlatform* platform) {
+#if defined(ESP_PLATFORM)
+  if (platform == nullptr) {
+    platform = getDefaultFlowPlatform();
+  }
+#endif
+  if (platform == nullptr || platform->nowMs == nullptr || platform->receiveMessage == nullptr ||
+      platform->sendMessage == nullptr || platform->delayMs == nullptr) {
+    appLogError("flowScheduler::initialize failed. platform is incomplete. name=%s",
+                schedulerName == nullptr ? "(null)" : schedulerName);
+    return false;
+  }
+  schedulerName_ = (schedulerName == nullptr) ? "flowScheduler" : schedulerName;
+  platform_ = platform;
+  mailboxCount_ = 0;
+  deferredCount_ = 0;
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    flows_[flowIndex] = nullptr;
+    isReady_[flowIndex] = false;
+  }
+  return true;
+}
+
+bool flowScheduler::registerMailbox(appTaskId taskId) {
+  if (platform_ == nullptr) {
+    appLogError("flowScheduler::registerMailbox failed. not initialized. taskId=%d", static_cast<int>(taskId));
+    return false;
+  }
+  if (findMailboxIndex(taskId) >= 0) {
+    return true;
+  }
+  if (mailboxCount_ >= kMaxMailboxCount) {
+    appLogError("flowScheduler::registerMailbox failed. mailbox table full. name=%s taskId=%d",
+                schedulerName_,
+                static_cast<int>(taskId));
+    return false;
+  }
+  mailboxTaskIds_[mailboxCount_] = taskId;
+  ++mailboxCount_;
+  return true;
+}
+
+bool flowScheduler::addFlow(flowBase* flow, appTaskId mailboxTaskId) {
+  if (flow == nullptr) {
+    appLogError("flowScheduler::addFlow failed. flow is null. name=%s", schedulerName_);
+    return false;
+  }
+  if (flow->scheduler_ != nullptr) {
+    appLogError("flowScheduler::addFlow failed. flow already attached. name=%s flow=%s",
+                schedulerName_,
+                flow->flowName());
+    return false;
+  }
+  const int32_t mailboxIndex = findMailboxIndex(mailboxTaskId);
+  if (mailboxIndex < 0) {
+    appLogError("flowScheduler::addFlow failed. mailbox is not registered. name=%s flow=%s taskId=%d",
+                schedulerName_,
+                flow->flowName(),
+                static_cast<int>(mailboxTaskId));
+    return false;
+  }
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    if (flows_[flowIndex] != nullptr) {
+      continue;
+    }
+    flow->scheduler_ = this;
+    flow->mailboxIndex_ = static_cast<uint8_t>(mailboxIndex);
+    flow->mailboxTaskId_ = mailboxTaskId;
+    flow->isCompleted_ = false;
+    flow->waitKind_ = flowWaitKind::kNone;
+    flow->lastWaitResult_ = flowWaitResult::kReady;
+    flows_[flowIndex] = flow;
+    isReady_[flowIndex] = true;
+    return true;
+  }
+  appLogError("flowScheduler::addFlow failed. flow table full. name=%s flow=%s", schedulerName_, flow->flowName());
+  return false;
+}
+
+uint32_t flowScheduler::runOnce(uint32_t maxIdleMs) {
+  if (platform_ == nullptr) {
+    appLogError("flowScheduler::runOnce failed. not initialized.");
+    return 0;
+  }
+
+  uint32_t currentMs = platform_->nowMs();
+  pollWaitConditions(currentMs);
+
+  uint32_t steppedFlowCount = 0;
+  bool hasCompletedFlow = false;
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    flowBase* flow = flows_[flowIndex];
+    if (flow == nullptr || !isReady_[flowIndex]) {
+      continue;
+    }
+    isReady_[flowIndex] = false;
+    flow->waitKind_ = flowWaitKind::kNone;
+    const flowStepResult stepResult = flow->step();
+    ++steppedFlowCount;
+    if (stepResult == flowStepResult::kCompleted) {
+      flow->isCompleted_ = true;
+      flow->waitKind_ = flowWaitKind::kNone;
+      hasCompletedFlow = true;
+      continue;
+    }
+    if (flow->waitKind_ == flowWaitKind::kNone) {
+      // [重要] 待機条件なしの kWaiting は yield とみなし、次周期で再実行する。
+      flow->yieldNow();
+    }
+  }
+  releaseCompletedFlows();
+
+  currentMs = platform_->nowMs();
+  pollWaitConditions(currentMs);
+  // [重要] 完了したフローがある周期は待機しない。runUntilCompleted の呼び出し元へ即時に制御を返すため。
+  receiveFromMailboxes(hasCompletedFlow ? 0 : computeIdleWaitMs(currentMs, maxIdleMs));
+  return steppedFlowCount;
+}
+
+void flowScheduler::runFor(uint32_t durationMs) {
+  if (platform_ == nullptr) {
+    appLogError("flowScheduler::runFor failed. not initialized.");
+    return;
+  }
+  const uint32_t startedAtMs = platform_->nowMs();
+  for (;;) {
+    const uint32_t remainingMs = remainingWaitMs(startedAtMs, durationMs, platform_->nowMs());
+    if (remainingMs == 0) {
+      return;
+    }
+    runOnce(remainingMs);
+  }
+}
+
+bool flowScheduler::runUntilCompleted(flowBase* flow) {
+  if (flow == nullptr || flow->scheduler_ != this) {
+    appLogError("flowScheduler::runUntilCompleted failed. flow is not attached. name=%s", schedulerName_);
+    return false;
+  }
+  while (!flow->isCompleted()) {
+    runOnce(kWaitForever);
+  }
+  return true;
+}
+
+bool flowScheduler::takeDeferredMessage(appTaskId taskId, appTaskMessage* messageOut) {
+  if (messageOut == nullptr) {
+    appLogError("flowScheduler::takeDeferredMessage failed. messageOut is null. taskId=%d", static_cast<int>(taskId));
+    return false;
+  }
+  // [重要] 保留箱は全メールボックス共用のため、宛先タスクIDで絞り込み、到着順を保ったまま取り出す。
+  for (size_t deferredIndex = 0; deferredIndex < deferredCount_; ++deferredIndex) {
+    if (deferredMessages_[deferredIndex].destinationTaskId != taskId) {
+      continue;
+    }
+    *messageOut = deferredMessages_[deferredIndex];
+    for (size_t moveIndex = deferredIndex + 1; moveIndex < deferredCount_; ++moveIndex) {
+      deferredMessages_[moveIndex - 1] = deferredMessages_[moveIndex];
+    }
+    --deferredCount_;
+    return true;
+  }
+  if (findMailboxIndex(taskId) < 0) {
+    return false;
+  }
+  return platform_->receiveMessage(taskId, messageOut, 0);
+}
+
+bool flowScheduler::sendMessage(const appTaskMessage& message, uint32_t timeoutMs) {
+  if (platform_ == nullptr) {
+    appLogError("flowScheduler::sendMessage failed. not initialized.");
+    return false;
+  }
+  return platform_->sendMessage(message, timeoutMs);
+}
+
+uint32_t flowScheduler::nowMs() const {
+  return platform_ == nullptr ? 0 : platform_->nowMs();
+}
+
+size_t flowScheduler::activeFlowCount() const {
+  size_t activeCount = 0;
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    if (flows_[flowIndex] != nullptr) {
+      ++activeCount;
+    }
+  }
+  return activeCount;
+}
+
+int32_t flowScheduler::findMailboxIndex(appTaskId taskId) const {
+  for (size_t mailboxIndex = 0; mailboxIndex < mailboxCount_; ++mailboxIndex) {
+    if (mailboxTaskIds_[mailboxIndex] == taskId) {
+      return static_cast<int32_t>(mailboxIndex);
+    }
+  }
+  return -1;
+}
+
+bool flowScheduler::dispatchMessage(uint8_t mailboxIndex, const appTaskMessage& message) {
+  // [重要] 完全一致の待機を優先し、次に送信元一致の kTaskError を配送する。
+  flowBase* taskErrorTarget = nullptr;
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    flowBase* flow = flows_[flowIndex];
+    if (flow == nullptr || isReady_[flowIndex] || flow->waitKind_ != flowWaitKind::kMessage ||
+        flow->mailboxIndex_ != mailboxIndex) {
+      continue;
+    }
+    const bool isSourceMatched = (flow->expectedSourceTaskId_ == appTaskId::kUnknown ||
+                                  flow->expectedSourceTaskId_ == message.sourceTaskId);
+    if (!isSourceMatched) {
+      continue;
+    }
+    if (flow->isAnyMessageWait_ ||
+        (message.messageType == flow->expectedMessageType_ &&
+         appUtil::messageDetailMatches(message, flow->waitDetail_))) {
+      flow->lastMessage_ = message;
+      wakeFlow(flow, flowWaitResult::kMessage);
+      return true;
+    }
+    if (message.messageType == appMessageType::kTaskError &&
+        flow->expectedSourceTaskId_ != appTaskId::kUnknown &&
+        taskErrorTarget == nullptr) {
+      taskErrorTarget = flow;
+    }
+  }
+  if (taskErrorTarget != nullptr) {
+    appLogError("flowScheduler: task error delivered to waiting flow. name=%s flow=%s src=%d detail=%s",
+                schedulerName_,
+                taskErrorTarget->flowName(),
+                static_cast<int>(message.sourceTaskId),
+                message.text);
+    taskErrorTarget->lastMessage_ = message;
+    wakeFlow(taskErrorTarget, flowWaitResult::kTaskError);
+    // [重要] 監視側（保留箱の利用者）もエラーを把握できるよう、kTaskError は保留箱にも残す。
+  }
+  return pushDeferredMessage(message);
+}
+
+bool flowScheduler::pushDeferredMessage(const appTaskMessage& message) {
+  if (deferredCount_ < kDeferredMessageCapacity) {
+    deferredMessages_[deferredCount_] = message;
+    ++deferredCount_;
+    return true;
+  }
+  // [重要] 満杯時は破棄せずメールボックスの末尾へ戻す。後ろに並ぶ待機中の応答は次周期以降に1件ずつ吸い上げる。
+  if (platform_->sendMessage(message, 0)) {
+    return false;
+  }
+  appLogWarn("flowScheduler: deferred box and mailbox full. drop message. name=%s dst=%d type=%d src=%d",
+             schedulerName_,
+             static_cast<int>(message.destinationTaskId),
+             static_cast<int>(message.messageType),
+             static_cast<int>(message.sourceTaskId));
+  return true;
+}
+
+void flowScheduler::pollWaitConditions(uint32_t nowMs) {
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    flowBase* flow = flows_[flowIndex];
+    if (flow == nullptr || isReady_[flowIndex]) {
+      continue;
+    }
+    switch (flow->waitKind_) {
+      case flowWaitKind::kYield:
+        wakeFlow(flow, flowWaitResult::kReady);
+        continue;
+      case flowWaitKind::kSocketReadable: {
+        if (platform_->pollSocketReadable == nullptr) {
+          wakeFlow(flow, flowWaitResult::kSocketError);
+          continue;
+        }
+        const int32_t pollResult = platform_->pollSocketReadable(flow->socketFd_);
+        if (pollResult != 0) {
+          wakeFlow(flow, pollResult > 0 ? flowWaitResult::kSocketReadable : flowWaitResult::kSocketError);
+          continue;
+        }
+        break;
+      }
+      case flowWaitKind::kQueueItem:
+        if (platform_->receiveQueueItem != nullptr &&
+            platform_->receiveQueueItem(flow->queueHandle_, flow->queueItemOut_)) {
+          wakeFlow(flow, flowWaitResult::kQueueItem);
+          continue;
+        }
+        break;
+      case flowWaitKind::kFlowCompletion:
+        if (flow->childFlow_ != nullptr && flow->childFlow_->isCompleted()) {
+          flow->childFlow_ = nullptr;
+          wakeFlow(flow, flowWaitResult::kFlowCompleted);
+          continue;
+        }
+        break;
+      default:
+        break;
+    }
+    if (flow->hasDeadline_ && remainingWaitMs(flow->waitStartedAtMs_, flow->waitTimeoutMs_, nowMs) == 0) {
+      wakeFlow(flow, flow->waitKind_ == flowWaitKind::kSleep ? flowWaitResult::kReady : flowWaitResult::kTimeout);
+    }
+  }
+}
+
+void flowScheduler::wakeFlow(flowBase* flow, flowWaitResult waitResult) {
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    if (flows_[flowIndex] == flow) {
+      flow->lastWaitResult_ = waitResult;
+      flow->waitKind_ = flowWaitKind::kNone;
+      isReady_[flowIndex] = true;
+      return;
+    }
+  }
+}
+
+uint32_t flowScheduler::computeIdleWaitMs(uint32_t nowMs, uint32_t maxIdleMs) const {
+  uint32_t idleWaitMs = maxIdleMs;
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    const flowBase* flow = flows_[flowIndex];
+    if (flow == nullptr) {
+      continue;
+    }
+    if (isReady_[flowIndex] || flow->waitKind_ == flowWaitKind::kYield) {
+      return 0;
+    }
+    if (flow->waitKind_ == flowWaitKind::kSocketReadable || flow->waitKind_ == flowWaitKind::kQueueItem ||
+        flow->waitKind_ == flowWaitKind::kFlowCompletion) {
+      idleWaitMs = (idleWaitMs < kPollSliceMs) ? idleWaitMs : kPollSliceMs;
+    }
+    if (flow->hasDeadline_) {
+      const uint32_t remainingMs = remainingWaitMs(flow->waitStartedAtMs_, flow->waitTimeoutMs_, nowMs);
+      idleWaitMs = (idleWaitMs < remainingMs) ? idleWaitMs : remainingMs;
+    }
+  }
+  size_t waitedMailboxCount = 0;
+  for (size_t mailboxIndex = 0; mailboxIndex < mailboxCount_; ++mailboxIndex) {
+    if (hasMessageWaiter(static_cast<uint8_t>(mailboxIndex))) {
+      ++waitedMailboxCount;
+    }
+  }
+  if (waitedMailboxCount > 1) {
+    idleWaitMs = (idleWaitMs < kPollSliceMs) ? idleWaitMs : kPollSliceMs;
+  }
+  return idleWaitMs;
+}
+
+void flowScheduler::receiveFromMailboxes(uint32_t idleWaitMs) {
+  // [重要] 受信待機中のフローがいるメールボックスだけを吸い上げる。待機者のいないメールボックスの
+  //        メッセージはOSのQueueに残し、`takeDeferredMessage()` で所有者が取り出す（保留箱の溢れ防止）。
+  appTaskMessage receivedMessage{};
+  bool hasBlocked = false;
+  for (size_t mailboxIndex = 0; mailboxIndex < mailboxCount_; ++mailboxIndex) {
+    if (!hasMessageWaiter(static_cast<uint8_t>(mailboxIndex))) {
+      continue;
+    }
+    uint32_t waitMs = hasBlocked ? 0 : idleWaitMs;
+    hasBlocked = true;
+    while (platform_->receiveMessage(mailboxTaskIds_[mailboxIndex], &receivedMessage, waitMs)) {
+      waitMs = 0;
+      if (!dispatchMessage(static_cast<uint8_t>(mailboxIndex), receivedMessage)) {
+        // 保留箱が満杯でメールボックスへ戻した。同じメッセージを取り直し続けないよう、この周期は止める。
+        break;
+      }
+    }
+  }
+  if (!hasBlocked && idleWaitMs > 0) {
+    platform_->delayMs(idleWaitMs);
+  }
+}
+
+bool flowScheduler::hasMessageWaiter(uint8_t mailboxIndex) const {
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    const flowBase* flow = flows_[flowIndex];
+    if (flow != nullptr && !isReady_[flowIndex] && flow->waitKind_ == flowWaitKind::kMessage &&
+        flow->mailboxIndex_ == mailboxIndex) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void flowScheduler::releaseCompletedFlows() {
+  for (size_t flowIndex = 0; flowIndex < kMaxFlowCount; ++flowIndex) {
+    flowBase* flow = flows_[flowIndex];
+    if (flow == nullptr || !flow->isCompleted()) {
+      continue;
+    }
+    // [重要] 親フローの kFlowCompletion 判定は isCompleted() を参照するため、解放前に起床させる。
+    for (size_t parentIndex = 0; parentIndex < kMaxFlowCount; ++parentIndex) {
+      flowBase* parentFlow = flows_[parentIndex];
+      if (parentFlow != nullptr && parentFlow->waitKind_ == flowWaitKind::kFlowCompletion &&
+          parentFlow->childFlow_ == flow) {
+        parentFlow->childFlow_ = nullptr;
+        wakeFlow(parentFlow, flowWaitResult::kFlowCompleted);
+      }
+    }
+    flow->scheduler_ = nullptr;
+    flows_[flowIndex] = nullptr;
+    isReady_[flowIndex] = false;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// requestReplyFlow
+// ---------------------------------------------------------------------------
+
+requestReplyFlow::requestReplyFlow(const char* flowName) : flowBase(flowName) {}
+
+bool requestReplyFlow::configure(appTaskId destinationTaskId,
+                                 appTaskId sourceTaskId,
+                                 appMessageType requestType,
+                                 const appUtil::appTaskMessageDetail* requestDetail,
+                                 appMessageType replyType,
+                                 uint32_t sendTimeoutMs,
+                                 uint32_t replyTimeoutMs) {
+  if (isAttached()) {
+    appLogError("requestReplyFlow::configure failed. flow is running. flow=%s", flowName());
+    return false;
+  }
+  requestMessage_ = appUtil::buildTaskMessage(destinationTaskId, sourceTaskId, requestType, requestDetail);
+  replyType_ = replyType;
+  sendTimeoutMs_ = sendTimeoutMs;
+  replyTimeoutMs_ = replyTimeoutMs;
+  isSucceeded_ = false;
+  isSendFailed_ = false;
+  state_ = stateType::kSend;
+  return true;
+}
+
+flowStepResult requestReplyFlow::step() {
+  switch (state_) {
+    case stateType::kSend: {
+      if (!sendMessage(requestMessage_, sendTimeoutMs_)) {
+        appLogWarn("requestReplyFlow: send failed. flow=%s dst=%d type=%d",
+                   flowName(),
+                   static_cast<int>(requestMessage_.destinationTaskId),
+                   static_cast<int>(requestMessage_.messageType));
+        isSendFailed_ = true;
+        state_ = stateType::kDone;
+        return flowStepResult::kCompleted;
+      }
+      waitMessage(requestMessage_.destinationTaskId, replyType_, nullptr, replyTimeoutMs_);
+      state_ = stateType::kWaitReply;
+      return flowStepResult::kWaiting;
+    }
+    case stateType::kWaitReply:
+      isSucceeded_ = (lastWaitResult() == flowWaitResult::kMessage);
+      state_ = stateType::kDone;
+      return flowStepResult::kCompleted;
+    case stateType::kIdle:
+    case stateType::kDone:
+    default:
+      appLogError("requestReplyFlow::step failed. flow is not configured. flow=%s", flowName());
+      return flowStepResult::kCompleted;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// startupAckResponderFlow
+// ---------------------------------------------------------------------------
+
+startupAckResponderFlow::startupAckResponderFlow(appTaskId selfTaskId,
+                                                 const char* ackText,
+                                                 otherMessageHandlerType otherMessageHandler)
+    : flowBase("startupAckResponder"),
+      selfTaskId_(selfTaskId),
+      ackText_(ackText == nullptr ? "" : ackText),
+      otherMessageHandler_(otherMessageHandler) {}
+
+flowStepResult startupAckResponderFlow::step() {
+  if (isWaiting_ && lastWaitResult() == flowWaitResult::kMessage) {
+    const appTaskMessage& receivedMessage = lastMessage();
+    if (receivedMessage.messageType == appMessageType::kStartupRequest) {
+      appUtil::appTaskMessageDetail ackDetail = appUtil::createEmptyMessageDetail();
+      ackDetail.hasIntValue = true;
+      ackDetail.intValue = 1;
+      ackDetail.text = ackText_;
+      const appTaskMessage ackMessage = appUtil::buildTaskMessage(
+          receivedMessage.sourceTaskId, selfTaskId_, appMessageType::kStartupAck, &ackDetail);
+      if (!sendMessage(ackMessage, 100)) {
+        appLogWarn("startupAckResponderFlow: ack send failed. selfTaskId=%d", static_cast<int>(selfTaskId_));
+      }
+    } else if (otherMessageHandler_ != nullptr) {
+      otherMessageHandler_(receivedMessage);
+    }
+  }
+  // [重要] メールボックスの全メッセージをこのフローで受ける。保留箱へ溜めないため。
+  waitAnyMessage(kWaitForever);
+  isWaiting_ = true;
+  return flowStepResult::kWaiting;
+}
+
+#if FLOW_RUNTIME_HAS_COROUTINE
+// ---------------------------------------------------------------------------
+// coroutineFlow
+// ---------------------------------------------------------------------------
+
+void coroutineFlow::promise_type::unhandled_exception() {
+  appLogFatal("coroutineFlow: unhandled exception in coroutine body. flow=%s",
+              owner == nullptr ? "(null)" : owner->flowName());
+  abort();
+}
+
+coroutineFlow::coroutineFlow(handleType handle) : flowBase("coroutineFlow"), handle_(handle) {
+  if (handle_) {
+    handle_.promise().owner = this;
+  }
+}
+
+coroutineFlow::coroutineFlow(coroutineFlow&& other) noexcept : flowBase("coroutineFlow"), handle_(other.handle_) {
+  other.handle_ = nullptr;
+  if (handle_) {
+    handle_.promise().owner = this;
+  }
+}
+
+coroutineFlow::~coroutineFlow() {
+  if (handle_) {
+    handle_.destroy();
+  }
+}
+
+flowStepResult coroutineFlow::step() {
+  if (!handle_ || handle_.done()) {
+    return flowStepResult::kCompleted;
+  }
+  handle_.resume();
+  return handle_.done() ? flowStepResult::kCompleted : flowStepResult::kWaiting;
+}
+#endif
+
+}  // namespace flowRuntime
@@ -0,0 +1,340 @@
+/**
+ * @file gpioBatch.cpp
+ * @brief 出力ポート（リレー/GPIO/LED）の一括制御実装。
+ * @details
+ * - [重要] 反映は「ON にするピンの W1TS 書込み」と「OFF にするピンの W1TC 書込み」を、GPIO0-31 / GPIO32-48 の
+ *   バンクごとに連続して行う。同じバンク・同じ向きの出力は1回の書込みで同時に変わる。
+ * - [重要] 書込みは portMUX の臨界区間で行い、割込みやもう一方のコアに割り込まれて切替がばらけないようにする。
+ * - [厳守] 拡張出力のピンは I2C(8/9)・ボタン(4)・状態LED(5/6/7)・ストラップピン・USB・オクタルPSRAM と重ねない。
+ */
+
+#include "gpioBatch.h"
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+#include <string.h>
+
+#include "led.h"
+#include "log.h"
+
+namespace {
+
+/**
+ * @brief 許可表の1行（論理出力と物理ピンの対応）。
+ */
+struct gpioBatchOutputEntry {
+  /** @brief 出力種別。@type gpioBatchTarget */
+  gpioBatchTarget target;
+  /** @brief 出力番号。@type uint8_t */
+  uint8_t index;
+  /** @brief GPIO番号。@type uint8_t */
+  uint8_t gpioNumber;
+  /** @brief true なら High で ON（正論理）。@type bool */
+  bool isActiveHigh;
+};
+
+/**
+ * @brief 操作を許可する出力の表。
+ * @details
+ * - [重要] `led` は状態LED（正論理）。ピンの初期化は ledController が持ち、index は led.h の k*LedIndex と一致させる。
+ * - [重要] 拡張出力（リレー: GPIO10-13 負論理 / 汎用: GPIO14-17）は APP_GPIO_BATCH_EXPANSION_OUTPUTS=1 のビルドだけに載せる。
+ *   リレーモジュールは入力 Low で励磁する負論理品を前提とする。
+ */
+constexpr gpioBatchOutputEntry kOutputTable[] = {
+    {gpioBatchTarget::kLed, kBlueLedIndex, kBlueLedGpio, true},
+    {gpioBatchTarget::kLed, kGreenLedIndex, kGreenLedGpio, true},
+    {gpioBatchTarget::kLed, kRedLedIndex, kRedLedGpio, true},
+#if APP_GPIO_BATCH_EXPANSION_OUTPUTS
+    {gpioBatchTarget::kRelay, 1, 10, false},
+    {gpioBatchTarget::kRelay, 2, 11, false},
+    {gpioBatchTarget::kRelay, 3, 12, false},
+    {gpioBatchTarget::kRelay, 4, 13, false},
+    {gpioBatchTarget::kGpio, 0, 14, true},
+    {gpioBatchTarget::kGpio, 1, 15, true},
+    {gpioBatchTarget::kGpio, 2, 16, true},
+    {gpioBatchTarget::kGpio, 3, 17, true},
+#endif
+};
+/** @brief 許可表の行数。@type uint8_t */
+constexpr uint8_t kOutputCount = sizeof(kOutputTable) / sizeof(kOutputTable[0]);
+
+/** @brief レジスタ書込みの臨界区間。 */
+portMUX_TYPE gpioBatchLock = portMUX_INITIALIZER_UNLOCKED;
+/** @brief 初期化済みフラグ。 */
+bool isOutputInitialized = false;
+
+/**
+ * @brief 許可表から出力を探す。
+ * @return 見つかった行番号。無ければ kOutputCount。
+ */
+uint8_t findOutputEntry(gpioBatchTarget target, uint8_t index) {
+  for (uint8_t entryIndex = 0; entryIndex < kOutputCount; ++entryIndex) {
+    if (kOutputTable[entryIndex].target == target && kOutputTable[entryIndex].index == index) {
+      return entryIndex;
+    }
+  }
+  return kOutputCount;
+}
+
+/**
+ * @brief W1TS/W1TC マスクをバンクごとに書き込む。
+ * @param setMasks High にするピンのマスク（バンク別）。
+ * @param clearMasks Low にするピンのマスク（バンク別）。
+ * @return 実際に書き込んだレジスタ数。
+ */
+uint8_t writeOutputMasks(const uint32_t* setMasks, const uint32_t* clearMasks) {
+  uint8_t writeCount = 0;
+  portENTER_CRITICAL(&gpioBatchLock);
+  if (setMasks[0] != 0) {
+    REG_WRITE(GPIO_OUT_W1TS_REG, setMasks[0]);
+    ++writeCount;
+  }
+  if (clearMasks[0] != 0) {
+    REG_WRITE(GPIO_OUT_W1TC_REG, clearMasks[0]);
+    ++writeCount;
+  }
+  if (setMasks[1] != 0) {
+    REG_WRITE(GPIO_OUT1_W1TS_REG, setMasks[1]);
+    ++writeCount;
+  }
+  if (clearMasks[1] != 0) {
+    REG_WRITE(GPIO_OUT1_W1TC_REG, clearMasks[1]);
+    ++writeCount;
+  }
+  portEXIT_CRITICAL(&gpioBatchLock);
+  return writeCount;
+}
+
+/**
+ * @brief 出力1件分のビットをマスクへ加える。
+ */
+void addOutputToMasks(const gpioBatchOutputEntry& entry, bool isActive, uint32_t* setMasks, uint32_t* clearMasks) {
+  const bool levelHigh = (isActive == entry.isActiveHigh);
+  const uint8_t bank = entry.gpioNumber / 32;
+  const uint32_t bit = 1UL << (entry.gpioNumber % 32);
+  if (levelHigh) {
+    setMasks[bank] |= bit;
+  } else {
+    clearMasks[bank] |= bit;
+  }
+}
+}  // namespace
+
+namespace gpioBatch {
+
+bool initializeOutputs() {
+  if (isOutputInitialized) {
+    return true;
+  }
+  uint32_t setMasks[kGpioBatchBankCount] = {};
+  uint32_t clearMasks[kGpioBatchBankCount] = {};
+  uint8_t configuredCount = 0;
+  for (uint8_t entryIndex = 0; entryIndex < kOutputCount; ++entryIndex) {
+    if (kOutputTable[entryIndex].target == gpioBatchTarget::kLed) {
+      continue;
+    }
+    addOutputToMasks(kOutputTable[entryIndex], false, setMasks, clearMasks);
+  }
+  // [重要] 先に出力ラッチを OFF レベルへそろえてから OUTPUT にし、負論理リレーの一瞬の励磁を避ける。
+  writeOutputMasks(setMasks, clearMasks);
+  for (uint8_t entryIndex = 0; entryIndex < kOutputCount; ++entryIndex) {
+    if (kOutputTable[entryIndex].target == gpioBatchTarget::kLed) {
+      continue;
+    }
+    pinMode(kOutputTable[entryIndex].gpioNumber, OUTPUT);
+    ++configuredCount;
+  }
+  writeOutputMasks(setMasks, clearMasks);
+  isOutputInitialized = true;
+  appLogInfo("gpioBatch::initializeOutputs success. outputs=%u configuredPins=%u expansion=%d",
+             static_cast<unsigned>(kOutputCount),
+             static_cast<unsigned>(configuredCount),
+             APP_GPIO_BATCH_EXPANSION_OUTPUTS);
+  return true;
+}
+
+bool prepareOperations(const gpioBatchOperation* operations,
+                       uint8_t operationCount,
+                       gpioBatchPlan* planOut,
+                       gpioBatchResult* resultOut) {
+  if (planOut == nullptr || resultOut == nullptr) {
+    appLogError("gpioBatch::prepareOperations failed. planOut=%p resultOut=%p", planOut, resultOut);
+    return false;
+  }
+  *planOut = gpioBatchPlan{};
+  *resultOut = gpioBatchResult{};
+  resultOut->failedOperationIndex = 0xFF;
+  if (!isOutputInitialized) {
+    resultOut->error = gpioBatchError::kNotInitialized;
+    appLogError("gpioBatch::prepareOperations failed. outputs are not initialized.");
+    return false;
+  }
+  if (operations == nullptr || operationCount == 0) {
+    resultOut->error = gpioBatchError::kEmpty;
+    appLogWarn("gpioBatch::prepareOperations rejected. no operations.");
+    return false;
+  }
+  if (operationCount > kGpioBatchMaxOperations) {
+    resultOut->error = gpioBatchError::kTooMany;
+    appLogWarn("gpioBatch::prepareOperations rejected. operationCount=%u max=%u",
+               static_cast<unsigned>(operationCount),
+               static_cast<unsigned>(kGpioBatchMaxOperations));
+    return false;
+  }
+
+  // [厳守] 全操作を検証してからまとめて書く。途中で1件でも不正なら何も変えない。
+  for (uint8_t operationIndex = 0; operationIndex < operationCount; ++operationIndex) {
+    const gpioBatchOperation& operation = operations[operationIndex];
+    const uint8_t entryIndex = findOutputEntry(operation.target, operation.index);
+    if (entryIndex >= kOutputCount) {
+      resultOut->error = gpioBatchError::kUnknownOutput;
+      resultOut->failedOperationIndex = operationIndex;
+      appLogWarn("gpioBatch::prepareOperations rejected. unknown output. position=%u target=%s index=%u",
+                 static_cast<unsigned>(operationIndex),
+                 getTargetName(operation.target),
+                 static_cast<unsigned>(operation.index));
+      return false;
+    }
+    addOutputToMasks(kOutputTable[entryIndex], operation.isActive, planOut->setMasks, planOut->clearMasks);
+    if (operation.target == gpioBatchTarget::kLed) {
+      const uint8_t ledBit = static_cast<uint8_t>(1U << operation.index);
+      planOut->ledOverrideMask |= ledBit;
+      if (operation.isActive) {
+        planOut->ledActiveMask |= ledBit;
+      }
+    }
+  }
+  for (uint8_t bank = 0; bank < kGpioBatchBankCount; ++bank) {
+    if ((planOut->setMasks[bank] & planOut->clearMasks[bank]) != 0) {
+      resultOut->error = gpioBatchError::kConflict;
+      appLogWarn("gpioBatch::prepareOperations rejected. conflicting levels. bank=%u mask=0x%08lX",
+                 static_cast<unsigned>(bank),
+                 static_cast<unsigned long>(planOut->setMasks[bank] & planOut->clearMasks[bank]));
+      return false;
+    }
+  }
+  planOut->operationCount = operationCount;
+  return true;
+}
+
+bool applyPlan(const gpioBatchPlan& plan, gpioBatchResult* resultOut) {
+  // [重要] esp_timer タスクから呼ばれるためログは出さない。結果の記録は呼出し側で行う。
+  if (resultOut == nullptr) {
+    return false;
+  }
+  *resultOut = gpioBatchResult{};
+  resultOut->failedOperationIndex = 0xFF;
+  if (!isOutputInitialized || plan.operationCount == 0) {
+    resultOut->error = isOutputInitialized ? gpioBatchError::kEmpty : gpioBatchError::kNotInitialized;
+    return false;
+  }
+  // [重要] 書く前に手動制御へ切り替え、直後の表示パターン更新で状態LEDが戻されないようにする。
+  if (plan.ledOverrideMask != 0) {
+    ledController::setManualOverride(plan.ledOverrideMask, plan.ledActiveMask);
+  }
+  resultOut->registerWriteCount = writeOutputMasks(plan.setMasks, plan.clearMasks);
+  resultOut->isApplied = true;
+  resultOut->appliedCount = plan.operationCount;
+  return true;
+}
+
+bool applyOperations(const gpioBatchOperation* operations, uint8_t operationCount, gpioBatchResult* resultOut) {
+  gpioBatchPlan plan{};
+  if (!prepareOperations(operations, operationCount, &plan, resultOut)) {
+    return false;
+  }
+  if (!applyPlan(plan, resultOut)) {
+    appLogError("gpioBatch::applyOperations failed. error=%u", static_cast<unsigned>(resultOut->error));
+    return false;
+  }
+  appLogInfo("gpioBatch::applyOperations applied. operations=%u registerWrites=%u set=0x%08lX/0x%08lX clear=0x%08lX/0x%08lX",
+             static_cast<unsigned>(plan.operationCount),
+             static_cast<unsigned>(resultOut->registerWriteCount),
+             static_cast<unsigned long>(plan.setMasks[0]),
+             static_cast<unsigned long>(plan.setMasks[1]),
+             static_cast<unsigned long>(plan.clearMasks[0]),
+             static_cast<unsigned long>(plan.clearMasks[1]));
+  return true;
+}
+
+bool readOutputState(gpioBatchTarget target, uint8_t index, bool* isActiveOut) {
+  if (isActiveOut == nullptr) {
+    appLogError("gpioBatch::readOutputState failed. isActiveOut is null.");
+    return false;
+  }
+  const uint8_t entryIndex = findOutputEntry(target, index);
+  if (entryIndex >= kOutputCount) {
+    return false;
+  }
+  const gpioBatchOutputEntry& entry = kOutputTable[entryIndex];
+  const uint32_t outputRegister = (entry.gpioNumber < 32) ? REG_READ(GPIO_OUT_REG) : REG_READ(GPIO_OUT1_REG);
+  const bool levelHigh = ((outputRegister >> (entry.gpioNumber % 32)) & 1U) != 0;
+  *isActiveOut = (levelHigh == entry.isActiveHigh);
+  return true;
+}
+
+uint8_t listOutputIndexes(gpioBatchTarget target, uint8_t* indexesOut, uint8_t capacity) {
+  if (indexesOut == nullptr) {
+    appLogError("gpioBatch::listOutputIndexes failed. indexesOut is null.");
+    return 0;
+  }
+  uint8_t listedCount = 0;
+  for (uint8_t entryIndex = 0; entryIndex < kOutputCount && listedCount < capacity; ++entryIndex) {
+    if (kOutputTable[entryIndex].target == target) {
+      indexesOut[listedCount++] = kOutputTable[entryIndex].index;
+    }
+  }
+  return listedCount;
+}
+
+gpioBatchTarget parseTargetName(const char* targetName) {
+  if (targetName == nullptr) {
+    return gpioBatchTarget::kUnknown;
+  }
+  if (strcmp(targetName, "relay") == 0) {
+    return gpioBatchTarget::kRelay;
+  }
+  if (strcmp(targetName, "gpio") == 0) {
+    return gpioBatchTarget::kGpio;
+  }
+  if (strcmp(targetName, "led") == 0) {
+    return gpioBatchTarget::kLed;
+  }
+  return gpioBatchTarget::kUnknown;
+}
+
+const char* getTargetName(gpioBatchTarget target) {
+  switch (target) {
+    case gpioBatchTarget::kRelay:
+      return "relay";
+    case gpioBatchTarget::kGpio:
+      return "gpio";
+    case gpioBatchTarget::kLed:
+      return "led";
+    default:
+      return "unknown";
+  }
+}
+
+const char* getErrorText(gpioBatchError error) {
+  switch (error) {
+    case gpioBatchError::kNone:
+      return "none";
+    case gpioBatchError::kEmpty:
+      return "no operations";
+    case gpioBatchError::kTooMany:
+      return "too many operations";
+    case gpioBatchError::kUnknownOutput:
+      return "output not allowed";
+    case gpioBatchError::kConflict:
+      return "conflicting levels for same output";
+    case gpioBatchError::kNotInitialized:
+      return "outputs not initialized";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace gpioBatch
@@ -5,50 +5,60 @@
 
 #include "http.h"
 
-#include <esp_heap_caps.h>
 #include <string.h>
 
+#include "flowRuntime.h"
 #include "interTaskMessage.h"
 #include "led.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
 StackType_t* httpTaskStackBuffer = nullptr;
 StaticTask_t httpTaskControlBlock;
+
+/**
+ * @brief 起動要求以外の受信時処理（runLoop と同じ通信アクティビティ表示）。
+ * @param message 受信メッセージ。
+ */
+void handleHttpOtherMessage(const appTaskMessage& message) {
+  (void)message;
+  // [将来対応] HTTP通信の実処理に入るタイミングで通信アクティビティ表示を行う。
+  ledController::indicateCommunicationActivity();
 }
 
-bool httpTask::startTask() {
-  interTaskMessageService& messageService = getInterTaskMessageService();
-  messageService.registerTaskQueue(appTaskId::kHttp, 8);
+/** @brief スケジューラ相乗り時の起動応答フロー。 */
+flowRuntime::startupAckResponderFlow httpStartupAckFlow(appTaskId::kHttp, "httpTask startup ack", handleHttpOtherMessage);
+}
 
-  if (httpTaskStackBuffer == nullptr) {
-    httpTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (httpTaskStackBuffer == nullptr) {
-    appLogWarn("httpTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    httpTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+bool httpTask::attachToFlowScheduler(flowRuntime::flowScheduler* schedulerOut) {
+  if (schedulerOut == nullptr) {
+    appLogError("httpTask::attachToFlowScheduler failed. schedulerOut is null.");
+    return false;
   }
-  if (httpTaskStackBuffer == nullptr) {
-    appLogError("httpTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
+  interTaskMessageService& messageService = getInterTaskMessageService();
+  messageService.registerTaskQueue(appTaskId::kHttp, 8);
+  if (!schedulerOut->registerMailbox(appTaskId::kHttp) ||
+      !schedulerOut->addFlow(&httpStartupAckFlow, appTaskId::kHttp)) {
+    appLogError("httpTask::attachToFlowScheduler failed. scheduler registration failed.");
     return false;
   }
+  appLogInfo("httpTask attached to flow scheduler. (skeleton, no dedicated stack)");
+  return true;
+}
+
+bool httpTask::startTask() {
+  interTaskMessageService& messageService = getInterTaskMessageService();
+  messageService.registerTaskQueue(appTaskId::kHttp, 8);
 
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "httpTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      httpTaskStackBuffer,
-      &httpTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("httpTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kHttp,
+                                             taskEntry,
+                                             this,
+                                             &httpTaskStackBuffer,
+                                             &httpTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("httpTask created.");
   return true;
 }
 
@@ -4,21 +4,22 @@
  * @details
  * - [重要] I2Cアクセスは専用タスクでのみ実行し、同時送信を禁止する。
  * - [推奨] LCDアドレスや初期化条件は本ファイル先頭定数で管理する。
+ * - [重要] センサー（BME280等）は外部デバイス枠組み（externalDevice.h）の記述子で扱い、本ファイルは Wire 実装の
+ *   バス（wireExternalDeviceBus）を渡すだけにする。
  */
 
 #include "i2c.h"
 
-#include <Adafruit_BME280.h>
 #include <Arduino.h>
 #include <Wire.h>
-#include <math.h>
 #include <hd44780.h>
 #include <hd44780ioClass/hd44780_I2Cexp.h>
-#include <esp_heap_caps.h>
 #include <freertos/queue.h>
 #include <string.h>
 
+#include "externalDevice.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
 /** @brief LCDで優先的に試験するI2Cアドレス。@type uint8_t */
@@ -29,10 +30,6 @@ constexpr uint8_t lcdAddressCandidate2 = 0x3F;
 constexpr uint8_t lcdColumnCount = 16;
 /** @brief LCD行数。@type uint8_t */
 constexpr uint8_t lcdRowCount = 2;
-/** @brief BME280の第1候補I2Cアドレス。@type uint8_t */
-constexpr uint8_t bme280AddressCandidate1 = 0x76;
-/** @brief BME280の第2候補I2Cアドレス。@type uint8_t */
-constexpr uint8_t bme280AddressCandidate2 = 0x77;
 /** @brief 表示要求キュー長。@type uint32_t */
 constexpr uint32_t requestQueueLength = 8;
 /** @brief ESP32側SDAピン番号。@type uint8_t */
@@ -41,6 +38,8 @@ constexpr uint8_t i2cSdaPin = 8;
 constexpr uint8_t i2cSclPin = 9;
 /** @brief BME280読み取り応答待機既定時間(ms)。@type uint32_t */
 constexpr uint32_t defaultEnvironmentResponseTimeoutMs = 1500;
+/** @brief 周期測定のスナップショットをそのまま返してよい経過時間(ms)。BME280 周期(5000ms)の2倍。@type uint32_t */
+constexpr uint32_t environmentSnapshotFreshMs = 10000;
 
 /**
  * @brief I2Cキュー要求種別。
@@ -83,18 +82,12 @@ StaticTask_t i2cTaskControlBlock;
 QueueHandle_t i2cRequestQueue = nullptr;
 /** @brief hd44780 I2C LCDドライバインスタンス。 */
 hd44780_I2Cexp i2cLcd;
-/** @brief BME280ドライバインスタンス。 */
-Adafruit_BME280 bme280Device;
 /** @brief I2Cバス初期化済みフラグ。 */
 bool isI2cInitialized = false;
 /** @brief LCD初期化済みフラグ。 */
 bool isLcdInitialized = false;
 /** @brief 検出済みLCDアドレス。 */
 uint8_t detectedLcdAddress = 0;
-/** @brief BME280初期化済みフラグ。 */
-bool isBme280Initialized = false;
-/** @brief 検出済みBME280アドレス。 */
-uint8_t detectedBme280Address = 0;
 /** @brief 起動済みI2Cサービス実体。 */
 i2cService* activeI2cServiceInstance = nullptr;
 
@@ -189,43 +182,6 @@ bool detectLcdAddress(uint8_t* detectedAddressOut) {
   return false;
 }
 
-/**
- * @brief BME280のI2Cアドレスを検出する。
- * @param detectedAddressOut 検出アドレス出力先。
- * @return 検出成功時true、失敗時false。
- */
-bool detectBme280Address(uint8_t* detectedAddressOut) {
-  if (detectedAddressOut == nullptr) {
-    appLogError("detectBme280Address failed. detectedAddressOut is null.");
-    return false;
-  }
-
-  uint8_t testResult76 = getI2cAddressTestResult(bme280AddressCandidate1);
-  appLogInfo("detectBme280Address test. address=0x%02X result=%u",
-             static_cast<unsigned>(bme280AddressCandidate1),
-             static_cast<unsigned>(testResult76));
-  if (testResult76 == 0) {
-    *detectedAddressOut = bme280AddressCandidate1;
-    appLogInfo("detectBme280Address success. address=0x%02X", static_cast<unsigned>(*detectedAddressOut));
-    return true;
-  }
-
-  uint8_t testResult77 = getI2cAddressTestResult(bme280AddressCandidate2);
-  appLogInfo("detectBme280Address test. address=0x%02X result=%u",
-             static_cast<unsigned>(bme280AddressCandidate2),
-             static_cast<unsigned>(testResult77));
-  if (testResult77 == 0) {
-    *detectedAddressOut = bme280AddressCandidate2;
-    appLogInfo("detectBme280Address success. address=0x%02X", static_cast<unsigned>(*detectedAddressOut));
-    return true;
-  }
-
-  appLogWarn("detectBme280Address failed. tried=0x%02X,0x%02X",
-             static_cast<unsigned>(bme280AddressCandidate1),
-             static_cast<unsigned>(bme280AddressCandidate2));
-  return false;
-}
-
 /**
  * @brief LCDを初期化する。
  * @return 初期化成功時true、失敗時false。
@@ -269,48 +225,6 @@ bool initializeLcdDevice() {
   return true;
 }
 
-/**
- * @brief BME280を初期化する。
- * @return 初期化成功時true、失敗時false。
- * @details
- * - [重要] BME280未接続時はfalseを返し、呼び出し元でMQTT/シリアルへ異常を通知する。
- * - [重要] I2Cモード前提のため、基板の `CSB` は 3.3V 固定を想定する。
- */
-bool initializeBme280Device() {
-  if (isBme280Initialized) {
-    return true;
-  }
-  if (!initializeI2cBus()) {
-    appLogError("initializeBme280Device failed. initializeI2cBus returned false.");
-    return false;
-  }
-
-  uint8_t bme280Address = 0;
-  if (!detectBme280Address(&bme280Address)) {
-    appLogWarn("initializeBme280Device skipped. BME280 address not detected.");
-    return false;
-  }
-
-  detectedBme280Address = bme280Address;
-  const bool beginResult = bme280Device.begin(static_cast<uint8_t>(detectedBme280Address), &Wire);
-  if (!beginResult) {
-    appLogError("initializeBme280Device failed. bme280Device.begin returned false. address=0x%02X",
-                static_cast<unsigned>(detectedBme280Address));
-    return false;
-  }
-
-  // [重要] 5分ごとのオンデマンド取得が主用途のため、forced modeで必要時のみ測定する。
-  bme280Device.setSampling(Adafruit_BME280::MODE_FORCED,
-                           Adafruit_BME280::SAMPLING_X1,
-                           Adafruit_BME280::SAMPLING_X1,
-                           Adafruit_BME280::SAMPLING_X1,
-                           Adafruit_BME280::FILTER_OFF);
-  isBme280Initialized = true;
-  appLogInfo("initializeBme280Device success. address=0x%02X",
-             static_cast<unsigned>(detectedBme280Address));
-  return true;
-}
-
 /**
  * @brief LCDへ2行文字列を出力する。
  * @param request 表示要求データ。
@@ -341,55 +255,64 @@ bool renderLcdText(const i2cDisplayRequest& request) {
 }
 
 /**
- * @brief BME280から環境値を読み取る。
- * @param snapshotOut 読み取り結果出力先。
- * @return 成功時true、失敗時false。
+ * @brief 外部デバイス枠組みへ渡す Wire 実装のバス。
+ * @details
+ * - [厳守] I2C専用タスク内（runLoop から呼ぶ runDueDevices）でのみ使う。
  */
-bool readEnvironmentSnapshot(i2cEnvironmentSnapshot* snapshotOut) {
-  if (snapshotOut == nullptr) {
-    appLogError("readEnvironmentSnapshot failed. snapshotOut is null.");
-    return false;
+class wireExternalDeviceBus : public externalDeviceBus {
+ public:
+  bool probe(uint8_t address) override {
+    return isI2cAddressResponding(address);
   }
 
-  *snapshotOut = i2cEnvironmentSnapshot{};
-  if (!initializeBme280Device()) {
-    snapshotOut->isValid = false;
-    snapshotOut->isSensorDetected = false;
-    snapshotOut->sensorAddress = 0;
-    appLogWarn("readEnvironmentSnapshot failed. initializeBme280Device returned false.");
-    return false;
+  bool writeRegister(uint8_t address, uint8_t registerAddress, uint8_t value) override {
+    Wire.beginTransmission(address);
+    Wire.write(registerAddress);
+    Wire.write(value);
+    return (Wire.endTransmission() == 0);
   }
 
-  if (!bme280Device.takeForcedMeasurement()) {
-    appLogWarn("readEnvironmentSnapshot: takeForcedMeasurement returned false. continue with current sampled values.");
+  bool readRegisters(uint8_t address, uint8_t startRegister, uint8_t* bufferOut, uint8_t length) override {
+    if (bufferOut == nullptr || length == 0) {
+      appLogError("wireExternalDeviceBus::readRegisters failed. invalid argument. address=0x%02X",
+                  static_cast<unsigned>(address));
+      return false;
+    }
+    // [重要] 番地書込みは STOP を出さず（リピーテッドスタート）、そのまま読取へ続ける。
+    Wire.beginTransmission(address);
+    Wire.write(startRegister);
+    if (Wire.endTransmission(false) != 0) {
+      return false;
+    }
+    const uint8_t receivedLength = static_cast<uint8_t>(Wire.requestFrom(address, length));
+    if (receivedLength != length) {
+      return false;
+    }
+    for (uint8_t index = 0; index < length; ++index) {
+      bufferOut[index] = static_cast<uint8_t>(Wire.read());
+    }
+    return true;
   }
+};
 
-  const float temperatureC = bme280Device.readTemperature();
-  const float humidityRh = bme280Device.readHumidity();
-  const float pressureHpa = bme280Device.readPressure() / 100.0F;
-  if (isnan(temperatureC) || isnan(humidityRh) || isnan(pressureHpa)) {
-    appLogError("readEnvironmentSnapshot failed. invalid measurement. temperature=%f humidity=%f pressure=%f",
-                static_cast<double>(temperatureC),
-                static_cast<double>(humidityRh),
-                static_cast<double>(pressureHpa));
-    snapshotOut->isValid = false;
-    snapshotOut->isSensorDetected = true;
-    snapshotOut->sensorAddress = detectedBme280Address;
-    return false;
-  }
+/** @brief 外部デバイス枠組みへ渡すバス実体。 */
+wireExternalDeviceBus externalBus;
 
-  snapshotOut->isValid = true;
-  snapshotOut->isSensorDetected = true;
-  snapshotOut->sensorAddress = detectedBme280Address;
-  snapshotOut->temperatureC = temperatureC;
-  snapshotOut->humidityRh = humidityRh;
-  snapshotOut->pressureHpa = pressureHpa;
-  appLogInfo("readEnvironmentSnapshot success. address=0x%02X temperature=%.2f humidity=%.2f pressure=%.2f",
-             static_cast<unsigned>(snapshotOut->sensorAddress),
-             static_cast<double>(snapshotOut->temperatureC),
-             static_cast<double>(snapshotOut->humidityRh),
-             static_cast<double>(snapshotOut->pressureHpa));
-  return true;
+/**
+ * @brief BME280 のスナップショットを環境センサースナップショットへ詰め替える。
+ * @param reading 外部デバイス枠組みのスナップショット。
+ * @param snapshotOut 出力先。
+ */
+void convertReadingToEnvironmentSnapshot(const externalDeviceReading& reading, i2cEnvironmentSnapshot* snapshotOut) {
+  *snapshotOut = i2cEnvironmentSnapshot{};
+  snapshotOut->isSensorDetected = (reading.address != 0);
+  snapshotOut->sensorAddress = reading.address;
+  snapshotOut->isValid = reading.isValid && reading.valueCount >= 3;
+  if (snapshotOut->isValid) {
+    snapshotOut->temperatureC = reading.values[0];
+    snapshotOut->humidityRh = reading.values[1];
+    snapshotOut->pressureHpa = reading.values[2];
+  }
 }
 
 /**
@@ -436,34 +359,14 @@ bool i2cService::startTask() {
   }
   activeI2cServiceInstance = this;
 
-  if (i2cTaskStackBuffer == nullptr) {
-    i2cTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (i2cTaskStackBuffer == nullptr) {
-    appLogWarn("i2cService: PSRAM stack allocation failed. fallback to internal RAM.");
-    i2cTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (i2cTaskStackBuffer == nullptr) {
-    appLogError("i2cService::startTask failed. heap_caps_malloc stack failed.");
-    return false;
-  }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "i2cTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      i2cTaskStackBuffer,
-      &i2cTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("i2cService::startTask failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kI2c,
+                                             taskEntry,
+                                             this,
+                                             &i2cTaskStackBuffer,
+                                             &i2cTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("i2cService task created.");
   return true;
 }
 
@@ -522,6 +425,14 @@ bool i2cService::requestEnvironmentSnapshot(i2cEnvironmentSnapshot* snapshotOut,
     return false;
   }
 
+  // [重要] 周期測定の結果が新しければ、I2C専用タスクを待たずにスナップショットを返す。
+  externalDeviceReading reading{};
+  if (externalDeviceDriver::readSnapshot(externalDeviceId::kBme280, &reading) && reading.isValid &&
+      static_cast<uint32_t>(millis() - reading.capturedAtMs) <= environmentSnapshotFreshMs) {
+    convertReadingToEnvironmentSnapshot(reading, snapshotOut);
+    return true;
+  }
+
   QueueHandle_t responseQueue = xQueueCreate(1, sizeof(i2cEnvironmentResponse));
   if (responseQueue == nullptr) {
     appLogError("requestEnvironmentSnapshot failed. xQueueCreate responseQueue returned null.");
@@ -572,13 +483,17 @@ void i2cService::taskEntry(void* taskParameter) {
  * @brief I2C表示要求を処理する常駐ループ。
  * @details
  * - [重要] I2Cアクセスは必ず本ループ内で実行する。
- * - [推奨] 将来のI2Cデバイス追加時も同じ直列化方針を維持する。
+ * - [重要] センサーの周期測定は externalDeviceDriver::runDueDevices に任せ、戻り値の待機時間だけ要求を待つ。
+ * - [推奨] センサー追加は externalDevice.cpp の記述子表で行い、本ループは変更しない。
  */
 void i2cService::runLoop() {
   appLogInfo("i2cService loop started.");
+  initializeI2cBus();
   for (;;) {
+    // [重要] 周期測定を先に済ませ、次の測定予定までを要求待ちに充てる。
+    const uint32_t waitMs = externalDeviceDriver::runDueDevices(externalBus, millis());
     i2cTaskRequest request{};
-    BaseType_t receiveResult = xQueueReceive(i2cRequestQueue, &request, pdMS_TO_TICKS(100));
+    BaseType_t receiveResult = xQueueReceive(i2cRequestQueue, &request, pdMS_TO_TICKS(waitMs));
     if (receiveResult == pdTRUE) {
       if (request.requestType == i2cRequestType::kDisplayText) {
         appLogInfo("i2cService dequeued LCD request. line1=%s line2=%s holdMs=%lu",
@@ -596,7 +511,21 @@ void i2cService::runLoop() {
         }
       } else if (request.requestType == i2cRequestType::kReadEnvironment) {
         i2cEnvironmentResponse response{};
-        response.success = readEnvironmentSnapshot(&response.snapshot);
+        externalDeviceReading previousReading{};
+        externalDeviceReading reading{};
+        // [重要] 強制測定の前後で測定成功回数を比べ、今回の測定が失敗して前回の値が残っているだけの場合は失敗として返す。
+        const bool hasPreviousReading = externalDeviceDriver::readSnapshot(externalDeviceId::kBme280, &previousReading);
+        externalDeviceDriver::requestImmediateRead(externalDeviceId::kBme280);
+        externalDeviceDriver::runDueDevices(externalBus, millis());
+        const bool hasReading = externalDeviceDriver::readSnapshot(externalDeviceId::kBme280, &reading);
+        const bool isFreshReading =
+            hasReading && reading.isValid && (!hasPreviousReading || reading.sampleCount != previousReading.sampleCount);
+        response.success = isFreshReading;
+        if (hasReading && reading.isValid && !isFreshReading) {
+          appLogWarn("i2cService forced environment read did not complete. returning stale snapshot as failure. capturedAtMs=%lu",
+                     static_cast<unsigned long>(reading.capturedAtMs));
+        }
+        convertReadingToEnvironmentSnapshot(reading, &response.snapshot);
         if (request.responseQueue != nullptr) {
           BaseType_t replyResult = xQueueSend(request.responseQueue, &response, pdMS_TO_TICKS(100));
           if (replyResult != pdTRUE) {
@@ -610,7 +539,6 @@ void i2cService::runLoop() {
                    static_cast<unsigned>(request.requestType));
       }
     }
-    vTaskDelay(pdMS_TO_TICKS(20));
   }
 }
 
@@ -11,7 +11,6 @@
 #include "input.h"
 
 #include <Arduino.h>
-#include <esp_heap_caps.h>
 #include <esp_system.h>
 #include <string.h>
 
@@ -19,6 +18,7 @@
 #include "interTaskMessage.h"
 #include "led.h"
 #include "log.h"
+#include "taskPlacement.h"
 #include "util.h"
 
 namespace {
@@ -37,6 +37,11 @@ constexpr uint32_t longPressMinDurationMs = 1000;
 /** @brief 起動中長押し判定期間(ms)。@type uint32_t */
 constexpr uint32_t startupMaintenanceWindowMs = 30000;
 
+/** @brief 他タスクへ公開するチャタリング除去後の押下状態。@type bool */
+volatile bool isStableButtonPressed = false;
+/** @brief 入力監視を開始済みなら true。@type bool */
+volatile bool isButtonMonitoringStarted = false;
+
 StackType_t* inputTaskStackBuffer = nullptr;
 StaticTask_t inputTaskControlBlock;
 
@@ -159,34 +164,14 @@ bool inputTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kInput, 8);
 
-  if (inputTaskStackBuffer == nullptr) {
-    inputTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (inputTaskStackBuffer == nullptr) {
-    appLogWarn("inputTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    inputTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (inputTaskStackBuffer == nullptr) {
-    appLogError("inputTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kInput,
+                                             taskEntry,
+                                             this,
+                                             &inputTaskStackBuffer,
+                                             &inputTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "inputTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      inputTaskStackBuffer,
-      &inputTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("inputTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
-    return false;
-  }
-  appLogInfo("inputTask created.");
   return true;
 }
 
@@ -203,6 +188,7 @@ void inputTask::runLoop() {
              static_cast<unsigned>(buttonInputGpio),
              static_cast<unsigned long>(inputScanIntervalMs),
              static_cast<unsigned>(debounceConfirmCount));
+  isButtonMonitoringStarted = true;
   for (;;) {
     appTaskMessage receivedMessage{};
     bool receiveResult = messageService.receiveMessage(appTaskId::kInput, &receivedMessage, 0);
@@ -230,6 +216,7 @@ void inputTask::runLoop() {
     if (buttonContext.consecutiveCount >= debounceConfirmCount &&
         buttonContext.stablePressed != buttonContext.rawPressed) {
       buttonContext.stablePressed = buttonContext.rawPressed;
+      isStableButtonPressed = buttonContext.stablePressed;
       if (buttonContext.stablePressed) {
         buttonContext.isPressTimingActive = true;
         buttonContext.longPressHandledDuringCurrentPress = false;
@@ -261,3 +248,15 @@ void inputTask::runLoop() {
     vTaskDelay(pdMS_TO_TICKS(inputScanIntervalMs));
   }
 }
+
+bool readStableButtonState(bool* isPressedOut) {
+  if (isPressedOut == nullptr) {
+    appLogError("readStableButtonState failed. isPressedOut is null.");
+    return false;
+  }
+  if (!isButtonMonitoringStarted) {
+    return false;
+  }
+  *isPressedOut = isStableButtonPressed;
+  return true;
+}
@@ -4,10 +4,13 @@
  * @details
  * - [重要] 宛先タスク専用Queueに対して送信することで、一般的で分かりやすい配送を行う。
  * - [厳守] Queue未登録のタスクへは送信しない。
+ * - [重要] 完了通知は固定数の枠（静的確保のバイナリセマフォ + 世代番号）で実装し、ヒープを使わない。
  */
 
 #include "interTaskMessage.h"
 
+#include <freertos/semphr.h>
+
 #include "log.h"
 
 namespace {
@@ -19,6 +22,75 @@ QueueHandle_t taskQueueTable[taskSlotCount] = {nullptr};
 /** @brief サービス初期化済みフラグ。 */
 bool isInitialized = false;
 
+/** @brief 同時に待機できる完了通知の数。@type uint16_t */
+constexpr uint16_t kCompletionSlotCount = 4;
+
+/**
+ * @brief 完了通知枠の状態。
+ */
+enum class completionSlotState : uint8_t {
+  /** 未使用。 */
+  kFree = 0,
+  /** 払い出し済み、完了待ち。 */
+  kPending,
+  /** 完了済み（待つ側が結果を受け取るまで保持）。 */
+  kCompleted,
+};
+
+/**
+ * @brief 完了通知枠。
+ */
+struct completionSlot {
+  /** @brief 状態。@type completionSlotState */
+  completionSlotState state;
+  /** @brief 現在の払い出し世代（1以上）。@type uint16_t */
+  uint16_t generation;
+  /** @brief 処理結果。@type bool */
+  bool succeeded;
+  /** @brief 待つ側を起こすセマフォ。@type SemaphoreHandle_t */
+  SemaphoreHandle_t signal;
+  /** @brief セマフォの静的領域。@type StaticSemaphore_t */
+  StaticSemaphore_t signalBuffer;
+};
+
+/** @brief 完了通知枠テーブル。 */
+completionSlot completionSlotTable[kCompletionSlotCount] = {};
+/** @brief 完了通知枠の排他。 */
+portMUX_TYPE completionSlotLock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief トークンが指す枠を返す（世代は呼び出し側で照合する）。
+ * @param token トークン。
+ * @return 枠。範囲外/未初期化ならnull。
+ */
+completionSlot* findCompletionSlot(const appCompletionToken& token) {
+  if (!isInitialized || !isCompletionRequested(token) || token.slotIndex >= kCompletionSlotCount) {
+    return nullptr;
+  }
+  return &completionSlotTable[token.slotIndex];
+}
+
+/**
+ * @brief 枠を未使用へ戻す（世代一致時のみ）。
+ * @param slot 対象枠。
+ * @param generation 払い出し世代。
+ * @param succeededOut 戻す直前の処理結果の出力先（null可）。
+ * @return 戻す直前の状態。世代不一致時は kFree。
+ */
+completionSlotState releaseCompletionSlot(completionSlot* slot, uint16_t generation, bool* succeededOut) {
+  completionSlotState previousState = completionSlotState::kFree;
+  portENTER_CRITICAL(&completionSlotLock);
+  if (slot->generation == generation && slot->state != completionSlotState::kFree) {
+    previousState = slot->state;
+    if (succeededOut != nullptr) {
+      *succeededOut = slot->succeeded;
+    }
+    slot->state = completionSlotState::kFree;
+  }
+  portEXIT_CRITICAL(&completionSlotLock);
+  return previousState;
+}
+
 /**
  * @brief タスクIDをQueueテーブルの添字へ変換する。
  * @param taskId タスクID。
@@ -42,6 +114,18 @@ bool interTaskMessageService::initialize() {
   for (uint8_t index = 0; index < taskSlotCount; ++index) {
     taskQueueTable[index] = nullptr;
   }
+  for (uint16_t index = 0; index < kCompletionSlotCount; ++index) {
+    completionSlot& slot = completionSlotTable[index];
+    slot.state = completionSlotState::kFree;
+    slot.generation = 0;
+    slot.succeeded = false;
+    slot.signal = xSemaphoreCreateBinaryStatic(&slot.signalBuffer);
+    if (slot.signal == nullptr) {
+      appLogError("interTaskMessageService::initialize failed. xSemaphoreCreateBinaryStatic returned null. slotIndex=%u",
+                  static_cast<unsigned>(index));
+      return false;
+    }
+  }
 
   isInitialized = true;
   appLogInfo("interTaskMessageService initialized.");
@@ -122,6 +206,22 @@ bool interTaskMessageService::sendMessage(const appTaskMessage& message, TickTyp
   return true;
 }
 
+/**
+ * @brief 宛先タスクQueueへ待たずに送信する（ログなし）。
+ * @param message 送信メッセージ。
+ * @return 成功時true、失敗時false。
+ */
+bool interTaskMessageService::trySendMessage(const appTaskMessage& message) {
+  if (!isInitialized) {
+    return false;
+  }
+  int32_t destinationIndex = taskIdToIndex(message.destinationTaskId);
+  if (destinationIndex < 0 || taskQueueTable[destinationIndex] == nullptr) {
+    return false;
+  }
+  return xQueueSend(taskQueueTable[destinationIndex], &message, 0) == pdPASS;
+}
+
 /**
  * @brief 指定タスクQueueからメッセージを受信する。
  * @param taskId 受信対象タスクID。
@@ -161,3 +261,122 @@ interTaskMessageService& getInterTaskMessageService() {
   static interTaskMessageService messageService;
   return messageService;
 }
+
+bool interTaskMessageService::acquireCompletion(appCompletionToken* tokenOut) {
+  if (tokenOut == nullptr) {
+    appLogError("interTaskMessageService::acquireCompletion failed. tokenOut is null.");
+    return false;
+  }
+  tokenOut->slotIndex = 0;
+  tokenOut->generation = 0;
+  if (!isInitialized) {
+    appLogError("interTaskMessageService::acquireCompletion failed. service not initialized.");
+    return false;
+  }
+
+  completionSlot* acquiredSlot = nullptr;
+  portENTER_CRITICAL(&completionSlotLock);
+  for (uint16_t index = 0; index < kCompletionSlotCount; ++index) {
+    completionSlot& slot = completionSlotTable[index];
+    if (slot.state != completionSlotState::kFree) {
+      continue;
+    }
+    // 世代は 1..65535 を巡回する（0 は「完了通知不要」のため使わない）
+    slot.generation = static_cast<uint16_t>(slot.generation + 1);
+    if (slot.generation == 0) {
+      slot.generation = 1;
+    }
+    slot.state = completionSlotState::kPending;
+    slot.succeeded = false;
+    tokenOut->slotIndex = index;
+    tokenOut->generation = slot.generation;
+    acquiredSlot = &slot;
+    break;
+  }
+  portEXIT_CRITICAL(&completionSlotLock);
+
+  if (acquiredSlot == nullptr) {
+    appLogError("interTaskMessageService::acquireCompletion failed. no free slot. slotCount=%u",
+                static_cast<unsigned>(kCompletionSlotCount));
+    return false;
+  }
+  // 前の世代へ遅れて届いた通知が残っていれば捨てる
+  xSemaphoreTake(acquiredSlot->signal, 0);
+  return true;
+}
+
+bool interTaskMessageService::completeCompletion(const appCompletionToken& token, bool succeeded) {
+  completionSlot* slot = findCompletionSlot(token);
+  if (slot == nullptr) {
+    appLogError("interTaskMessageService::completeCompletion failed. invalid token. slotIndex=%u generation=%u",
+                static_cast<unsigned>(token.slotIndex),
+                static_cast<unsigned>(token.generation));
+    return false;
+  }
+
+  bool completed = false;
+  portENTER_CRITICAL(&completionSlotLock);
+  if (slot->generation == token.generation && slot->state == completionSlotState::kPending) {
+    slot->succeeded = succeeded;
+    slot->state = completionSlotState::kCompleted;
+    completed = true;
+  }
+  portEXIT_CRITICAL(&completionSlotLock);
+
+  if (!completed) {
+    appLogWarn("interTaskMessageService::completeCompletion skipped. waiter already gone. slotIndex=%u generation=%u",
+               static_cast<unsigned>(token.slotIndex),
+               static_cast<unsigned>(token.generation));
+    return false;
+  }
+  xSemaphoreGive(slot->signal);
+  return true;
+}
+
+appCompletionResult interTaskMessageService::awaitCompletion(const appCompletionToken& token, TickType_t timeoutTicks) {
+  completionSlot* slot = findCompletionSlot(token);
+  if (slot == nullptr) {
+    appLogError("interTaskMessageService::awaitCompletion failed. invalid token. slotIndex=%u generation=%u",
+                static_cast<unsigned>(token.slotIndex),
+                static_cast<unsigned>(token.generation));
+    return appCompletionResult::kInvalidToken;
+  }
+
+  const TickType_t waitStartTick = xTaskGetTickCount();
+  while (true) {
+    const TickType_t elapsedTicks = xTaskGetTickCount() - waitStartTick;
+    const TickType_t remainingTicks = (elapsedTicks >= timeoutTicks) ? 0 : (timeoutTicks - elapsedTicks);
+    if (xSemaphoreTake(slot->signal, remainingTicks) != pdTRUE) {
+      break;
+    }
+    portENTER_CRITICAL(&completionSlotLock);
+    const bool completed = (slot->generation == token.generation && slot->state == completionSlotState::kCompleted);
+    portEXIT_CRITICAL(&completionSlotLock);
+    if (completed) {
+      break;
+    }
+    // 前の世代へ遅れて届いた通知で起きた場合は、残り時間だけ待ち直す
+  }
+
+  // タイムアウトと完了が競合した場合も、枠の状態を見て完了を優先する
+  bool succeeded = false;
+  const completionSlotState previousState = releaseCompletionSlot(slot, token.generation, &succeeded);
+  if (previousState == completionSlotState::kCompleted) {
+    return succeeded ? appCompletionResult::kSucceeded : appCompletionResult::kFailed;
+  }
+  if (previousState == completionSlotState::kFree) {
+    appLogError("interTaskMessageService::awaitCompletion failed. token already released. slotIndex=%u generation=%u",
+                static_cast<unsigned>(token.slotIndex),
+                static_cast<unsigned>(token.generation));
+    return appCompletionResult::kInvalidToken;
+  }
+  return appCompletionResult::kTimeout;
+}
+
+void interTaskMessageService::cancelCompletion(const appCompletionToken& token) {
+  completionSlot* slot = findCompletionSlot(token);
+  if (slot == nullptr) {
+    return;
+  }
+  releaseCompletionSlot(slot, token.generation, nullptr);
+}
@@ -10,20 +10,22 @@
 #include "led.h"
 
 #include <Arduino.h>
-#include <esp_heap_caps.h>
 #include <freertos/semphr.h>
 #include <string.h>
 
+#include <atomic>
+
 #include "interTaskMessage.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
-/** @brief 青LEDのGPIO番号。@type uint8_t */
-constexpr uint8_t blueLedGpio = 7;
-/** @brief 緑LEDのGPIO番号。@type uint8_t */
-constexpr uint8_t greenLedGpio = 6;
-/** @brief 赤LEDのGPIO番号。@type uint8_t */
-constexpr uint8_t redLedGpio = 5;
+/** @brief 青LEDのGPIO番号（led.h の kBlueLedGpio）。@type uint8_t */
+constexpr uint8_t blueLedGpio = kBlueLedGpio;
+/** @brief 緑LEDのGPIO番号（led.h の kGreenLedGpio）。@type uint8_t */
+constexpr uint8_t greenLedGpio = kGreenLedGpio;
+/** @brief 赤LEDのGPIO番号（led.h の kRedLedGpio）。@type uint8_t */
+constexpr uint8_t redLedGpio = kRedLedGpio;
 
 /** @brief ledTask用スタック領域。 */
 StackType_t* ledTaskStackBuffer = nullptr;
@@ -40,6 +42,10 @@ bool greenBlinkState = false;
 uint32_t lastGreenToggleMs = 0;
 /** @brief 緑LEDが定常点灯状態かどうか。 */
 bool isGreenSteadyOn = false;
+/** @brief 手動制御中のLED（bit=LED番号）。表示パターンはこのLEDへ書かない。 */
+std::atomic<uint8_t> manualOverrideMask{0};
+/** @brief 手動制御中のLEDの点灯状態（bit=LED番号）。 */
+std::atomic<uint8_t> manualActiveMask{0};
 
 /**
  * @brief LED制御用ミューテックスを初期化する。
@@ -95,13 +101,39 @@ void unlockLedControl() {
   }
 }
 
+/**
+ * @brief 表示パターンから単色LEDを書く。手動制御中のLEDには書かない。
+ * @param ledIndex LED番号（手動制御マスクのビット位置）。
+ * @param gpioNumber GPIO番号。
+ * @param isOn trueで点灯、falseで消灯。
+ */
+void writePatternLed(uint8_t ledIndex, uint8_t gpioNumber, bool isOn) {
+  ensureLedHardwareInitialized();
+  const uint8_t ledBit = static_cast<uint8_t>(1U << ledIndex);
+  if ((manualOverrideMask.load() & ledBit) != 0) {
+    return;
+  }
+  digitalWrite(gpioNumber, isOn ? HIGH : LOW);
+  // [重要] 判定と書込みの間に gpioBatch が手動値を書いた場合は、上書きした分を手動値へ戻す。
+  if ((manualOverrideMask.load() & ledBit) != 0) {
+    digitalWrite(gpioNumber, (manualActiveMask.load() & ledBit) != 0 ? HIGH : LOW);
+  }
+}
+
+/**
+ * @brief 手動制御を解除し、以降の表示パターンで全LEDを書けるようにする。
+ */
+void releaseManualOverride() {
+  manualOverrideMask.store(0);
+  manualActiveMask.store(0);
+}
+
 /**
  * @brief 単色LEDを設定する。
  * @param isOn trueで点灯、falseで消灯。
  */
 void setBlueLed(bool isOn) {
-  ensureLedHardwareInitialized();
-  digitalWrite(blueLedGpio, isOn ? HIGH : LOW);
+  writePatternLed(kBlueLedIndex, blueLedGpio, isOn);
 }
 
 /**
@@ -109,8 +141,7 @@ void setBlueLed(bool isOn) {
  * @param isOn trueで点灯、falseで消灯。
  */
 void setGreenLed(bool isOn) {
-  ensureLedHardwareInitialized();
-  digitalWrite(greenLedGpio, isOn ? HIGH : LOW);
+  writePatternLed(kGreenLedIndex, greenLedGpio, isOn);
 }
 
 /**
@@ -118,8 +149,7 @@ void setGreenLed(bool isOn) {
  * @param isOn trueで点灯、falseで消灯。
  */
 void setRedLed(bool isOn) {
-  ensureLedHardwareInitialized();
-  digitalWrite(redLedGpio, isOn ? HIGH : LOW);
+  writePatternLed(kRedLedIndex, redLedGpio, isOn);
 }
 
 /**
@@ -279,7 +309,8 @@ void ledController::indicateMaintenanceModeRedOn() {
   if (!lockLedControl(portMAX_DELAY)) {
     return;
   }
-  // [重要] メンテナンスモードは赤LED点灯を継続状態として示す。
+  // [重要] メンテナンスモードは赤LED点灯を継続状態として示す。MQTT からの手動制御はここで解除する。
+  releaseManualOverride();
   setBlueLed(false);
   setGreenLed(false);
   setRedLed(true);
@@ -290,7 +321,8 @@ void ledController::indicateMaintenanceModeBluePatternCycle() {
   if (!lockLedControl(portMAX_DELAY)) {
     return;
   }
-  // [重要] APモード中は要件どおり青LEDの専用点滅を繰り返して状態を示す。
+  // [重要] APモード中は要件どおり青LEDの専用点滅を繰り返して状態を示す。MQTT からの手動制御はここで解除する。
+  releaseManualOverride();
   setRedLed(false);
   setGreenLed(false);
 
@@ -310,6 +342,16 @@ void ledController::indicateMaintenanceModeBluePatternCycle() {
   unlockLedControl();
 }
 
+void ledController::setManualOverride(uint8_t ledIndexMask, uint8_t activeMask) {
+  // [重要] 点灯状態を先に更新し、writePatternLed が手動値へ戻すときに古い値を書かないようにする。
+  uint8_t currentActiveMask = manualActiveMask.load();
+  uint8_t nextActiveMask = 0;
+  do {
+    nextActiveMask = static_cast<uint8_t>((currentActiveMask & ~ledIndexMask) | (activeMask & ledIndexMask));
+  } while (!manualActiveMask.compare_exchange_weak(currentActiveMask, nextActiveMask));
+  manualOverrideMask.fetch_or(ledIndexMask);
+}
+
 /**
  * @brief LEDタスクを生成し、受信用キューを登録する。
  * @return 生成成功時true、失敗時false。
@@ -318,34 +360,14 @@ bool ledTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kLed, 8);
 
-  if (ledTaskStackBuffer == nullptr) {
-    ledTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (ledTaskStackBuffer == nullptr) {
-    appLogWarn("ledTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    ledTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (ledTaskStackBuffer == nullptr) {
-    appLogError("ledTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
-    return false;
-  }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "ledTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      ledTaskStackBuffer,
-      &ledTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("ledTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kLed,
+                                             taskEntry,
+                                             this,
+                                             &ledTaskStackBuffer,
+                                             &ledTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("ledTask created.");
   return true;
 }
 
@@ -11,7 +11,6 @@
 #include <Arduino.h>
 #include <LittleFS.h>
 #include <Preferences.h>
-#include <esp_heap_caps.h>
 #include <freertos/queue.h>
 #include <algorithm>
 #include <stdarg.h>
@@ -22,6 +21,7 @@
 #include <vector>
 
 #include "../header/firmwareMode.h"
+#include "../header/taskPlacement.h"
 
 #ifndef IOT_ENABLE_FILE_LOG
 #define IOT_ENABLE_FILE_LOG 1
@@ -84,14 +84,6 @@ constexpr uint32_t fileLogFailureAutoDisableThreshold = 3;
 uint32_t fileLogConsecutiveFailureCount = 0;
 /** @brief ファイルログ書込みキュー長。 */
 constexpr uint32_t fileLogQueueLength = 64;
-/**
- * @brief ファイルログ書込みタスクのスタックサイズ。
- * @details
- * - [変更][2026-04-04] セキュア化最終版の診断ログ増加を見込みつつ、過剰確保を避けるため 512 byte のみ加算する。
- */
-constexpr uint32_t fileLogWriterTaskStackSize = 6656;
-/** @brief ファイルログ書込みタスク優先度。 */
-constexpr UBaseType_t fileLogWriterTaskPriority = 0;
 /** @brief ファイルログ1行の最大文字数（終端含む）。 */
 constexpr size_t fileLogQueueLineMaxChars = 192;
 /** @brief バッチ書込みの最大件数。 */
@@ -108,6 +100,12 @@ TaskHandle_t fileLogWriterTaskHandle = nullptr;
 StackType_t* fileLogWriterTaskStackBuffer = nullptr;
 /** @brief ファイルログ書込みタスク制御ブロック。 */
 StaticTask_t fileLogWriterTaskControlBlock;
+/**
+ * @brief ファイルログ書込みタスク生成中フラグ。
+ * @details
+ * - [重要] 生成処理内の WARN/ERROR ログが enqueueFileLogLine() から再度生成へ入る再帰を防ぐ。
+ */
+bool fileLogWriterTaskCreating = false;
 
 /**
  * @brief ファイルログ書込みキュー要素。
@@ -245,32 +243,19 @@ bool ensureFileLogWriterReady() {
     return true;
   }
 
-  if (fileLogWriterTaskStackBuffer == nullptr) {
-    fileLogWriterTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(fileLogWriterTaskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (fileLogWriterTaskStackBuffer == nullptr) {
-    fileLogWriterTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(fileLogWriterTaskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (fileLogWriterTaskStackBuffer == nullptr) {
+  if (fileLogWriterTaskCreating) {
     return false;
   }
 
-  fileLogWriterTaskHandle = xTaskCreateStaticPinnedToCore(
-      fileLogWriterTaskEntry,
-      "fileLogWriterTask",
-      fileLogWriterTaskStackSize,
-      nullptr,
-      fileLogWriterTaskPriority,
-      fileLogWriterTaskStackBuffer,
-      &fileLogWriterTaskControlBlock,
-      tskNO_AFFINITY);
-  if (fileLogWriterTaskHandle != nullptr) {
-    appLogInfo("ensureFileLogWriterReady: fileLogWriterTask created. stackBytes=%u",
-               static_cast<unsigned>(fileLogWriterTaskStackSize));
-  }
-  return (fileLogWriterTaskHandle != nullptr);
+  fileLogWriterTaskCreating = true;
+  const bool createResult = taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kFileLogWriter,
+                                                                  fileLogWriterTaskEntry,
+                                                                  nullptr,
+                                                                  &fileLogWriterTaskStackBuffer,
+                                                                  &fileLogWriterTaskControlBlock,
+                                                                  &fileLogWriterTaskHandle);
+  fileLogWriterTaskCreating = false;
+  return createResult;
 }
 
 /**
@@ -4,6 +4,7 @@
  * @details
  * - [重要] Wi-Fi/MQTT/時刻同期の初期化シーケンスをmainTaskで制御する。
  * - [厳守] 時刻同期はtimeServerTaskへ委譲し、24時間周期の再同期をタスク側で継続する。
+ * - [重要] 要求→応答待ちは mainTask の flowScheduler 上のフローで行い、待機中も相乗りフロー（display/http）を動かす。
  */
 
 #include <Arduino.h>
@@ -16,11 +17,14 @@
 #include <WiFi.h>
 
 #include "certification.h"
+#include "commandScheduler.h"
 #include "common.h"
 #include "display.h"
 #include "error.h"
 #include "externalDevice.h"
 #include "filesystem.h"
+#include "flowRuntime.h"
+#include "gpioBatch.h"
 #include "http.h"
 #include "i2c.h"
 #include "input.h"
@@ -35,6 +39,7 @@
 #include "sensitiveData.h"
 #include "sensitiveDataService.h"
 #include "secureNvsInit.h"
+#include "taskPlacement.h"
 #include "tcpip.h"
 #include "timeServer.h"
 #include "util.h"
@@ -48,17 +53,6 @@ namespace {
  * @note [重要] モニタ側の設定と一致しないとログ解読が困難になる。
  */
 constexpr uint32_t serialBaudRate = 115200;
-/**
- * @brief mainTaskに割り当てるスタックサイズ。
- * @type uint32_t
- * @note [重要] 初期化シーケンスとAPメンテナンスAPI処理が同一タスクで重なるため、15KBへ拡張して運用する。
- * @note [変更][2026-03-24] 7041 dry-run precheck で measuredMinStackMarginBytes=3232 (閾値4096未満) が継続したため、
- *       PC-007.stackMarginOk を満たすために mainTask の最小余裕を増やす。
- * @note [変更][2026-04-04] secure NVS 初期化ログ強化と最終セキュア化前の診断余裕確保のため、さらに 512 byte 増やす。
- * @note [変更][2026-04-04b] AP/STA/OTA 事前動作確認と文鎮化時診断用途で、さらに 1024 byte 追加し、きりのよい 15KB に合わせる。
- * @note [推奨] 15KB は 15360 byte であり、12288 byte 運用から 3072 byte の余裕を追加した構成とする。
- */
-constexpr uint32_t mainTaskStackSize = 15360;
 
 #ifndef APP_SECURE_RESCUE_MODE
 #define APP_SECURE_RESCUE_MODE 0
@@ -73,11 +67,6 @@ constexpr uint32_t mainTaskStackSize = 15360;
  *       loop() には到達しないため、このフラグは保険として機能する。
  */
 volatile bool setupAbortedByNvsFailure = false;
-/**
- * @brief mainTaskの優先度。
- * @type UBaseType_t
- */
-constexpr UBaseType_t mainTaskPriority = 1;
 /**
  * @brief mainTask心拍ログの送信間隔(ms)。
  * @type uint32_t
@@ -147,12 +136,19 @@ filesystemService filesystemModule;
 sensitiveDataService sensitiveDataModule;
 /** @brief タスク間メッセージサービス参照。 */
 interTaskMessageService& messageService = getInterTaskMessageService();
+/**
+ * @brief mainTaskで駆動するフロースケジューラ。
+ * @note [重要] kMain のメールボックスを所有し、ひな形タスク（display/http）の起動応答フローも相乗りさせる。
+ * @note [重要] 応答待ち中に届いた kTaskError 等は破棄されず保留箱へ残り、メインループで処理する。
+ */
+flowRuntime::flowScheduler mainFlowScheduler;
 
 String maskSecretForLog(const String& rawValue);
 String getCurrentTimeString();
 iotError::errorCodeType mapTaskErrorCode(appTaskId sourceTaskId);
 bool isUtcTimeSynchronized();
 void writeErrText(iotError::errorCodeType errorCode, char* errTextOut, size_t errTextOutSize);
+bool runRequestReplyFlow(flowRuntime::requestReplyFlow* requestFlow);
 bool executeWifiConnectAndConfirm(const String& wifiSsid, const String& wifiPass);
 bool executeMqttConnectAndConfirm(const String& mqttUrl,
                                   const String& mqttUser,
@@ -248,6 +244,25 @@ void writeErrText(iotError::errorCodeType errorCode, char* errTextOut, size_t er
   }
 }
 
+/**
+ * @brief 要求→応答フローを mainFlowScheduler で完了まで実行する。
+ * @param requestFlow configure 済みのフロー（null不可）。
+ * @return フローを実行できた場合true。応答の成否は requestFlow->succeeded() で判定する。
+ * @note [重要] 待機中も同じスケジューラ上の相乗りフローは動作し続ける。
+ */
+bool runRequestReplyFlow(flowRuntime::requestReplyFlow* requestFlow) {
+  if (requestFlow == nullptr) {
+    appLogError("runRequestReplyFlow failed. requestFlow is null.");
+    return false;
+  }
+  if (!mainFlowScheduler.addFlow(requestFlow, appTaskId::kMain)) {
+    appLogError("runRequestReplyFlow failed. mainFlowScheduler.addFlow returned false. flow=%s",
+                requestFlow->flowName());
+    return false;
+  }
+  return mainFlowScheduler.runUntilCompleted(requestFlow);
+}
+
 /**
  * @brief Wi-Fi接続要求を送信し、接続完了応答まで待機する。
  * @param wifiSsid SSID。
@@ -261,34 +276,30 @@ bool executeWifiConnectAndConfirm(const String& wifiSsid, const String& wifiPass
   appLogInfo("mainTaskEntry: wifi init request send. ssid=%s pass=%s",
              wifiSsid.c_str(),
              maskSecretForLog(wifiPass).c_str());
-  bool wifiInitSendResult = appUtil::sendMessage(
-      appTaskId::kWifi,
-      appTaskId::kMain,
-      appMessageType::kWifiInitRequest,
-      &wifiInitDetail,
-      300);
-  if (!wifiInitSendResult) {
+  flowRuntime::requestReplyFlow wifiInitFlow("wifiInit");
+  wifiInitFlow.configure(appTaskId::kWifi,
+                         appTaskId::kMain,
+                         appMessageType::kWifiInitRequest,
+                         &wifiInitDetail,
+                         appMessageType::kWifiInitDone,
+                         300,
+                         35000);
+  const bool wifiInitRunResult = runRequestReplyFlow(&wifiInitFlow);
+  if (!wifiInitRunResult || wifiInitFlow.sendFailed()) {
     char errText[8] = {};
     writeErrText(static_cast<iotError::errorCodeType>(iotError::errorCodeEnum::kEspStartupWifiInitRequestFailed), errText, sizeof(errText));
-    appLogWarn("%s mainTaskEntry: appUtil::sendMessage(kWifiInitRequest) returned false.", errText);
+    appLogWarn("%s mainTaskEntry: send(kWifiInitRequest) failed.", errText);
     return false;
   }
-
-  appTaskMessage wifiInitResponseMessage{};
-  bool wifiInitWaitResult = appUtil::waitMessage(
-      appTaskId::kWifi,
-      appTaskId::kMain,
-      appMessageType::kWifiInitDone,
-      nullptr,
-      35000,
-      &wifiInitResponseMessage);
-  if (!wifiInitWaitResult) {
+  if (!wifiInitFlow.succeeded()) {
     char errText[8] = {};
     writeErrText(static_cast<iotError::errorCodeType>(iotError::errorCodeEnum::kEspStartupWifiInitTimeout), errText, sizeof(errText));
-    appLogWarn("%s mainTaskEntry: appUtil::waitMessage(kWifiInitDone) timeout.", errText);
+    appLogWarn("%s mainTaskEntry: wait(kWifiInitDone) failed. waitResult=%d",
+               errText,
+               static_cast<int>(wifiInitFlow.lastWaitResult()));
     return false;
   }
-  appLogInfo("mainTaskEntry: wifi initialization completed. detail=%s", wifiInitResponseMessage.text);
+  appLogInfo("mainTaskEntry: wifi initialization completed. detail=%s", wifiInitFlow.replyMessage().text);
   return true;
 }
 
@@ -320,34 +331,30 @@ bool executeMqttConnectAndConfirm(const String& mqttUrl,
              maskSecretForLog(mqttPass).c_str(),
              static_cast<long>(mqttPort),
              static_cast<int>(mqttTls));
-  bool mqttInitSendResult = appUtil::sendMessage(
-      appTaskId::kMqtt,
-      appTaskId::kMain,
-      appMessageType::kMqttInitRequest,
-      &mqttInitDetail,
-      300);
-  if (!mqttInitSendResult) {
+  flowRuntime::requestReplyFlow mqttInitFlow("mqttInit");
+  mqttInitFlow.configure(appTaskId::kMqtt,
+                         appTaskId::kMain,
+                         appMessageType::kMqttInitRequest,
+                         &mqttInitDetail,
+                         appMessageType::kMqttInitDone,
+                         300,
+                         20000);
+  const bool mqttInitRunResult = runRequestReplyFlow(&mqttInitFlow);
+  if (!mqttInitRunResult || mqttInitFlow.sendFailed()) {
     char errText[8] = {};
     writeErrText(static_cast<iotError::errorCodeType>(iotError::errorCodeEnum::kEspStartupMqttInitRequestFailed), errText, sizeof(errText));
-    appLogWarn("%s mainTaskEntry: appUtil::sendMessage(kMqttInitRequest) returned false.", errText);
+    appLogWarn("%s mainTaskEntry: send(kMqttInitRequest) failed.", errText);
     return false;
   }
-
-  appTaskMessage mqttInitResponseMessage{};
-  bool mqttInitWaitResult = appUtil::waitMessage(
-      appTaskId::kMqtt,
-      appTaskId::kMain,
-      appMessageType::kMqttInitDone,
-      nullptr,
-      20000,
-      &mqttInitResponseMessage);
-  if (!mqttInitWaitResult) {
+  if (!mqttInitFlow.succeeded()) {
     char errText[8] = {};
     writeErrText(static_cast<iotError::errorCodeType>(iotError::errorCodeEnum::kEspStartupMqttInitTimeout), errText, sizeof(errText));
-    appLogWarn("%s mainTaskEntry: appUtil::waitMessage(kMqttInitDone) timeout.", errText);
+    appLogWarn("%s mainTaskEntry: wait(kMqttInitDone) failed. waitResult=%d",
+               errText,
+               static_cast<int>(mqttInitFlow.lastWaitResult()));
     return false;
   }
-  appLogInfo("mainTaskEntry: mqtt initialization completed. detail=%s", mqttInitResponseMessage.text);
+  appLogInfo("mainTaskEntry: mqtt initialization completed. detail=%s", mqttInitFlow.replyMessage().text);
   return true;
 }
 
@@ -367,34 +374,29 @@ bool executeMqttStatusPublishAndConfirm(uint32_t startupCpuMillis, const char* p
   mqttPublishDetail.text = "status online publish request";
   mqttPublishDetail.text2 = publishSubName;
   mqttPublishDetail.text3 = "Online";
-  bool mqttPublishRequestResult = appUtil::sendMessage(
-      appTaskId::kMqtt,
-      appTaskId::kMain,
-      appMessageType::kMqttPublishOnlineRequest,
-      &mqttPublishDetail,
-      300);
-  if (!mqttPublishRequestResult) {
-    appLogWarn("mainTaskEntry: appUtil::sendMessage(kMqttPublishOnlineRequest) failed. reason=%s",
+  flowRuntime::requestReplyFlow mqttPublishFlow("mqttStatusPublish");
+  mqttPublishFlow.configure(appTaskId::kMqtt,
+                            appTaskId::kMain,
+                            appMessageType::kMqttPublishOnlineRequest,
+                            &mqttPublishDetail,
+                            appMessageType::kMqttPublishOnlineDone,
+                            300,
+                            20000);
+  const bool mqttPublishRunResult = runRequestReplyFlow(&mqttPublishFlow);
+  if (!mqttPublishRunResult || mqttPublishFlow.sendFailed()) {
+    appLogWarn("mainTaskEntry: send(kMqttPublishOnlineRequest) failed. reason=%s",
                (publishReasonText == nullptr ? "(null)" : publishReasonText));
     return false;
   }
-
-  appTaskMessage mqttPublishResponseMessage{};
-  bool mqttPublishWaitResult = appUtil::waitMessage(
-      appTaskId::kMqtt,
-      appTaskId::kMain,
-      appMessageType::kMqttPublishOnlineDone,
-      nullptr,
-      20000,
-      &mqttPublishResponseMessage);
-  if (!mqttPublishWaitResult) {
-    appLogWarn("mainTaskEntry: appUtil::waitMessage(kMqttPublishOnlineDone) timeout. reason=%s",
-               (publishReasonText == nullptr ? "(null)" : publishReasonText));
+  if (!mqttPublishFlow.succeeded()) {
+    appLogWarn("mainTaskEntry: wait(kMqttPublishOnlineDone) failed. reason=%s waitResult=%d",
+               (publishReasonText == nullptr ? "(null)" : publishReasonText),
+               static_cast<int>(mqttPublishFlow.lastWaitResult()));
     return false;
   }
   appLogInfo("mainTaskEntry: mqtt status publish completed. reason=%s detail=%s",
              (publishReasonText == nullptr ? "(null)" : publishReasonText),
-             mqttPublishResponseMessage.text);
+             mqttPublishFlow.replyMessage().text);
   return true;
 }
 
@@ -418,33 +420,30 @@ bool executeNtpSyncAndConfirm(const String& timeServerUrl, int32_t timeServerPor
              timeServerUrl.c_str(),
              static_cast<long>(timeServerPort),
              static_cast<int>(timeServerTls));
-  bool timeServerInitSendResult = appUtil::sendMessage(
-      appTaskId::kTimeServer,
-      appTaskId::kMain,
-      appMessageType::kTimeServerInitRequest,
-      &timeServerInitDetail,
-      300);
-  if (!timeServerInitSendResult) {
+  flowRuntime::requestReplyFlow timeServerInitFlow("timeServerInit");
+  timeServerInitFlow.configure(appTaskId::kTimeServer,
+                               appTaskId::kMain,
+                               appMessageType::kTimeServerInitRequest,
+                               &timeServerInitDetail,
+                               appMessageType::kTimeServerInitDone,
+                               300,
+                               20000);
+  const bool timeServerInitRunResult = runRequestReplyFlow(&timeServerInitFlow);
+  if (!timeServerInitRunResult || timeServerInitFlow.sendFailed()) {
     char errText[8] = {};
     writeErrText(static_cast<iotError::errorCodeType>(iotError::errorCodeEnum::kEspStartupTimeInitRequestFailed), errText, sizeof(errText));
-    appLogWarn("%s mainTaskEntry: appUtil::sendMessage(kTimeServerInitRequest) returned false.", errText);
+    appLogWarn("%s mainTaskEntry: send(kTimeServerInitRequest) failed.", errText);
     return false;
   }
-
-  appTaskMessage timeServerInitResponseMessage{};
-  bool timeServerInitWaitResult = appUtil::waitMessage(
-      appTaskId::kTimeServer,
-      appTaskId::kMain,
-      appMessageType::kTimeServerInitDone,
-      nullptr,
-      20000,
-      &timeServerInitResponseMessage);
-  if (!timeServerInitWaitResult) {
+  if (!timeServerInitFlow.succeeded()) {
     char errText[8] = {};
     writeErrText(static_cast<iotError::errorCodeType>(iotError::errorCodeEnum::kEspStartupTimeInitTimeout), errText, sizeof(errText));
-    appLogWarn("%s mainTaskEntry: appUtil::waitMessage(kTimeServerInitDone) timeout.", errText);
+    appLogWarn("%s mainTaskEntry: wait(kTimeServerInitDone) failed. waitResult=%d",
+               errText,
+               static_cast<int>(timeServerInitFlow.lastWaitResult()));
     return false;
   }
+  const appTaskMessage& timeServerInitResponseMessage = timeServerInitFlow.replyMessage();
   if (timeServerInitResponseMessage.intValue != 1) {
     appLogWarn("mainTaskEntry: time server initialization failed. detail=%s utcNow=%s",
                timeServerInitResponseMessage.text,
@@ -655,7 +654,15 @@ void mainTaskEntry(void* taskParameter) {
 
   // [重要] 起動時は青LEDを一旦消灯後0.5秒待機してから点灯する。
   ledController::initializeByMainOnBoot();
+  // [重要] 拡張出力（リレー等、有効なビルドのみ）を不定状態のまま放置しないよう、起動直後に OFF へそろえる。
+  gpioBatch::initializeOutputs();
+  if (!commandScheduler::initialize()) {
+    appLogWarn("mainTaskEntry: command scheduler is unavailable. set with args.at is rejected.");
+  }
   appLogInfo("mainTask started.");
+  if (!taskPlacement::startCpuLoadSampling()) {
+    appLogWarn("mainTaskEntry: cpu load sampling is unavailable. status omits cpuLoadCore0/1.");
+  }
 
   bool i2cStartResult = i2cModule.startTask();
   if (!i2cStartResult) {
@@ -798,13 +805,22 @@ void mainTaskEntry(void* taskParameter) {
 
   // [重要] FreeRTOS Queueによる一般的なメッセージ連携を開始する。
   // [補足] mainTaskは指令側として各機能タスクを起動し、応答のみを待機する。
+  const bool flowSchedulerInitializeResult = mainFlowScheduler.initialize("mainFlowScheduler", nullptr) &&
+                                             mainFlowScheduler.registerMailbox(appTaskId::kMain);
+  if (!flowSchedulerInitializeResult) {
+    ledController::indicateAbortPattern();
+    appLogFatal("mainTaskEntry failed. mainFlowScheduler initialization failed.");
+    vTaskDelete(nullptr);
+  }
   wifiService.startTask();
   mqttService.startTask();
-  httpService.startTask();
+  // [重要] ひな形段階の http/display と、起動応答だけを持つ externalDevice は専用タスクを作らず
+  //        mainFlowScheduler へ相乗りさせる（スタック各4KB削減）。
+  httpService.attachToFlowScheduler(&mainFlowScheduler);
   //tcpipService.startTask();  // 必要時のみ有効化
   otaService.startTask();
-  externalDeviceService.startTask();
-  displayService.startTask();
+  externalDeviceService.attachToFlowScheduler(&mainFlowScheduler);
+  displayService.attachToFlowScheduler(&mainFlowScheduler);
   ledService.startTask();
   inputService.startTask();
   timeServerService.startTask();
@@ -844,9 +860,10 @@ void mainTaskEntry(void* taskParameter) {
   for (;;) {
     static uint32_t heartbeatCount = 0;
     static iotError::errorCodeType currentErrorCode = iotError::kNoError;
+    // [重要] 相乗りフローを進めたうえで、kMain 宛ての未処理メッセージ（保留箱→Queue）をすべて処理する。
+    mainFlowScheduler.runOnce(100);
     appTaskMessage receivedMessage{};
-    bool receiveResult = messageService.receiveMessage(appTaskId::kMain, &receivedMessage, pdMS_TO_TICKS(100));
-    if (receiveResult) {
+    while (mainFlowScheduler.takeDeferredMessage(appTaskId::kMain, &receivedMessage)) {
       appLogInfo("mainTaskEntry: message received. src=%d dst=%d type=%d text=%s",
                  static_cast<int>(receivedMessage.sourceTaskId),
                  static_cast<int>(receivedMessage.destinationTaskId),
@@ -886,6 +903,7 @@ void mainTaskEntry(void* taskParameter) {
     }
 
     uint32_t nowMs = millis();
+    taskPlacement::updateCpuLoadSampling(nowMs);
     bool isWifiCurrentlyConnected = (WiFi.status() == WL_CONNECTED);
     if (!isWifiCurrentlyConnected) {
       if (isWifiReady || isMqttReady) {
@@ -957,6 +975,12 @@ void mainTaskEntry(void* taskParameter) {
               appLogError("mainTaskEntry: otaRollback::confirmCurrentAppIfNeeded failed.");
             } else {
               isCurrentAppConfirmed = true;
+              // [重要] 確定後は rollback 先が不要になるため、非アクティブ面の事前消去を otaTask へ依頼する。
+              const bool preEraseRequestResult = appUtil::sendMessage(
+                  appTaskId::kOta, appTaskId::kMain, appMessageType::kOtaPreEraseRequest, nullptr, 100);
+              if (!preEraseRequestResult) {
+                appLogWarn("mainTaskEntry: send(kOtaPreEraseRequest) failed. OTA will erase during download.");
+              }
             }
           }
         } else {
@@ -1015,7 +1039,7 @@ void mainTaskEntry(void* taskParameter) {
     String secondLine = String(secondLineBuffer);
     startDisplayResult = i2cModule.requestLcdText(timeString.c_str(), secondLine.c_str(), 0);
     ++heartbeatCount;
-    vTaskDelay(pdMS_TO_TICKS(mainTaskIntervalMs));
+    mainFlowScheduler.runFor(mainTaskIntervalMs);
   }
 }
 
@@ -1044,8 +1068,10 @@ void setup() {
              static_cast<unsigned>(ESP.getPsramSize()),
              static_cast<unsigned>(ESP.getFreePsram()),
              static_cast<unsigned>(ESP.getFreeHeap()));
+  const taskPlacement::taskPlacementEntry& mainTaskPlacement =
+      taskPlacement::getPlacement(taskPlacement::placedTaskId::kMain);
   appLogInfo("setup: configured mainTaskStackSize=%u bytes before secure NVS initialization.",
-             static_cast<unsigned>(mainTaskStackSize));
+             static_cast<unsigned>(mainTaskPlacement.stackSize));
 
   certificationModule.initialize();
   filesystemModule.initialize();
@@ -1087,14 +1113,15 @@ void setup() {
     appLogError("setup: otaRollback::initializeOnBoot failed.");
   }
 
+  // [重要] mainTask のスタックは動的確保（内部RAM）のため、配置表のコア/優先度/サイズのみ使う。
   BaseType_t createTaskResult = xTaskCreatePinnedToCore(
       mainTaskEntry,
-      "mainTask",
-      mainTaskStackSize,
+      mainTaskPlacement.taskName,
+      mainTaskPlacement.stackSize,
       nullptr,
-      mainTaskPriority,
+      mainTaskPlacement.priority,
       nullptr,
-      ARDUINO_RUNNING_CORE);
+      mainTaskPlacement.coreId);
 
   if (createTaskResult != pdPASS) {
     char errText[8] = {};
@@ -19,15 +19,19 @@
 #include <esp_ota_ops.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <mbedtls/base64.h>
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/ecdh.h>
 #include <mbedtls/ecp.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/gcm.h>
 #include <mbedtls/sha256.h>
+#include <cJSON.h>
+#include "base64Codec.h"
+#include "flashBenchmark.h"
 #include "jsonService.h"
 #include "log.h"
+#include "mqtt.h"
+#include "ota.h"
 #include "sensitiveData.h"
 #include "sensitiveDataService.h"
 #include "version.h"
@@ -484,82 +488,6 @@ bool ensureDirectoryPathExistsForAp(const String& directoryPath) {
   return true;
 }
 
-/**
- * @brief Base64文字列をバイト列へ復号する。
- * @param inputBase64 入力Base64文字列。
- * @param outputBytesOut 出力先。
- * @return 復号成功時true。
- */
-bool decodeBase64TextForAp(const String& inputBase64, std::vector<uint8_t>* outputBytesOut) {
-  if (outputBytesOut == nullptr) {
-    return false;
-  }
-  outputBytesOut->clear();
-  size_t outputLength = 0;
-  int probeResult = mbedtls_base64_decode(nullptr,
-                                          0,
-                                          &outputLength,
-                                          reinterpret_cast<const unsigned char*>(inputBase64.c_str()),
-                                          inputBase64.length());
-  if (probeResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && probeResult != 0) {
-    appLogError("decodeBase64TextForAp failed. probeResult=%d inputLength=%ld",
-                probeResult,
-                static_cast<long>(inputBase64.length()));
-    return false;
-  }
-  outputBytesOut->resize(outputLength);
-  if (outputLength == 0) {
-    return true;
-  }
-  int decodeResult = mbedtls_base64_decode(outputBytesOut->data(),
-                                           outputBytesOut->size(),
-                                           &outputLength,
-                                           reinterpret_cast<const unsigned char*>(inputBase64.c_str()),
-                                           inputBase64.length());
-  if (decodeResult != 0) {
-    appLogError("decodeBase64TextForAp failed. decodeResult=%d inputLength=%ld",
-                decodeResult,
-                static_cast<long>(inputBase64.length()));
-    return false;
-  }
-  outputBytesOut->resize(outputLength);
-  return true;
-}
-
-/**
- * @brief バイト列をBase64文字列へ変換する。
- * @param inputBytes 入力バイト列。
- * @param outputBase64Out 出力先。
- * @return 変換成功時true。
- */
-bool encodeBase64TextForAp(const std::vector<uint8_t>& inputBytes, String* outputBase64Out) {
-  if (outputBase64Out == nullptr) {
-    return false;
-  }
-  size_t outputLength = 0;
-  int probeResult = mbedtls_base64_encode(nullptr, 0, &outputLength, inputBytes.data(), inputBytes.size());
-  if (probeResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && probeResult != 0) {
-    appLogError("encodeBase64TextForAp failed. probeResult=%d inputSize=%ld", probeResult, static_cast<long>(inputBytes.size()));
-    return false;
-  }
-  std::vector<uint8_t> outputBytes(outputLength + 1, 0);
-  int encodeResult = mbedtls_base64_encode(outputBytes.data(),
-                                           outputBytes.size(),
-                                           &outputLength,
-                                           inputBytes.data(),
-                                           inputBytes.size());
-  if (encodeResult != 0) {
-    appLogError("encodeBase64TextForAp failed. encodeResult=%d inputSize=%ld", encodeResult, static_cast<long>(inputBytes.size()));
-    return false;
-  }
-  outputBase64Out->remove(0);
-  outputBase64Out->reserve(outputLength);
-  for (size_t index = 0; index < outputLength; ++index) {
-    *outputBase64Out += static_cast<char>(outputBytes[index]);
-  }
-  return true;
-}
-
 /**
  * @brief APモード局所更新API向けに LittleFS 初期化状態を保証する。
  * @return 初期化済みならtrue。
@@ -771,7 +699,7 @@ bool performPairingTransportHandshakeForAp(const String& clientPublicKeyBase64,
     return false;
   }
   std::vector<uint8_t> clientPublicKeyBytes;
-  if (!decodeBase64TextForAp(clientPublicKeyBase64, &clientPublicKeyBytes)) {
+  if (!base64Codec::decodeToBytes(clientPublicKeyBase64, &clientPublicKeyBytes)) {
     appLogError("performPairingTransportHandshakeForAp failed. client public key decode failed.");
     return false;
   }
@@ -886,7 +814,7 @@ bool performPairingTransportHandshakeForAp(const String& clientPublicKeyBase64,
     return false;
   }
   String serverPublicKeyBase64;
-  if (!encodeBase64TextForAp(serverPublicKeyBytes, &serverPublicKeyBase64)) {
+  if (!base64Codec::encodeToText(serverPublicKeyBytes, &serverPublicKeyBase64)) {
     appLogError("performPairingTransportHandshakeForAp failed. public key base64 encode failed.");
     mbedtls_ctr_drbg_free(&ctrDrbgContext);
     mbedtls_entropy_free(&entropyContext);
@@ -1037,7 +965,7 @@ void handleManagedFileUpsertApi() {
     return;
   }
   std::vector<uint8_t> fileBytes;
-  if (!decodeBase64TextForAp(dataBase64, &fileBytes)) {
+  if (!base64Codec::decodeToBytes(dataBase64, &fileBytes)) {
     maintenanceWebServer.send(400, "application/json", "{\"result\":\"NG\",\"detail\":\"base64 decode failed\"}");
     return;
   }
@@ -1105,6 +1033,67 @@ void handleManagedFileDeleteApi() {
   maintenanceWebServer.send(200, "application/json", responseText);
 }
 
+/**
+ * @brief LittleFS の I/O 計測を実行し、結果（度数分布）を返すAPI。
+ * @details
+ * - [重要] 受信形式は JSON（`fileBytes` / `randomOps` / `metaOps`、いずれも任意）。MQTT `call flashBench` と同じ結果形式。
+ * - [重要] 計測は要求処理内で同期実行する（既定設定で数秒）。
+ */
+void handleFlashBenchmarkApi() {
+  if (!isAuthorized(maintenanceRole::kMaintenance)) {
+    maintenanceWebServer.send(401, "application/json", "{\"result\":\"NG\",\"detail\":\"unauthorized\"}");
+    return;
+  }
+  const String requestBody = maintenanceWebServer.arg("plain");
+  flashBenchmarkOptions options = flashBenchmark::getDefaultOptions();
+  long optionValue = 0;
+  if (requestBody.length() > 0 && parseBodyLongValue(requestBody, "fileBytes", &optionValue) && optionValue > 0) {
+    options.fileBytes = static_cast<uint32_t>(optionValue);
+  }
+  if (requestBody.length() > 0 && parseBodyLongValue(requestBody, "randomOps", &optionValue) && optionValue > 0) {
+    options.randomOperationCount = static_cast<uint16_t>(optionValue > 0xFFFF ? 0xFFFF : optionValue);
+  }
+  if (requestBody.length() > 0 && parseBodyLongValue(requestBody, "metaOps", &optionValue) && optionValue > 0) {
+    options.metaOperationCount = static_cast<uint16_t>(optionValue > 0xFFFF ? 0xFFFF : optionValue);
+  }
+  // [厳守] OTA 更新中・fileSync セッション中は計測しない（flashBenchmark.h の呼出し条件）。
+  if (isOtaInProgress()) {
+    maintenanceWebServer.send(409, "application/json", "{\"result\":\"NG\",\"detail\":\"ota is in progress\"}");
+    return;
+  }
+  if (isFileSyncSessionActive()) {
+    maintenanceWebServer.send(409, "application/json", "{\"result\":\"NG\",\"detail\":\"filesync session is active\"}");
+    return;
+  }
+  if (!ensureLittleFsReadyForAp()) {
+    maintenanceWebServer.send(500, "application/json", "{\"result\":\"NG\",\"detail\":\"filesystem is unavailable\"}");
+    return;
+  }
+  static flashBenchmarkReport benchmarkReport;
+  const char* detailText = nullptr;
+  if (!flashBenchmark::run(options, &benchmarkReport, &detailText)) {
+    maintenanceWebServer.send(500,
+                              "application/json",
+                              String("{\"result\":\"NG\",\"detail\":\"") + toJsonSafeText(String(detailText)) + "\"}");
+    return;
+  }
+  cJSON* responseObject = cJSON_CreateObject();
+  char* serializedText = nullptr;
+  if (responseObject != nullptr) {
+    cJSON_AddStringToObject(responseObject, "result", "OK");
+    if (flashBenchmark::appendReportToJson(benchmarkReport, responseObject)) {
+      serializedText = cJSON_PrintUnformatted(responseObject);
+    }
+    cJSON_Delete(responseObject);
+  }
+  if (serializedText == nullptr) {
+    maintenanceWebServer.send(500, "application/json", "{\"result\":\"NG\",\"detail\":\"result serialization failed\"}");
+    return;
+  }
+  maintenanceWebServer.send(200, "application/json", serializedText);
+  cJSON_free(serializedText);
+}
+
 void handleHealthApi() {
   const String remoteIpText = maintenanceWebServer.client().remoteIP().toString();
   logMaintenanceApRuntimeSnapshot("handleHealthApi", remoteIpText.c_str());
@@ -1571,15 +1560,15 @@ void handlePairingSecureBundleApplyApi() {
   std::vector<uint8_t> ivBytes;
   std::vector<uint8_t> cipherBytes;
   std::vector<uint8_t> tagBytes;
-  if (!decodeBase64TextForAp(ivBase64, &ivBytes) || ivBytes.size() != 12) {
+  if (!base64Codec::decodeToBytes(ivBase64, &ivBytes) || ivBytes.size() != 12) {
     maintenanceWebServer.send(400, "application/json", "{\"result\":\"NG\",\"detail\":\"invalid ivBase64\"}");
     return;
   }
-  if (!decodeBase64TextForAp(cipherBase64, &cipherBytes) || cipherBytes.empty()) {
+  if (!base64Codec::decodeToBytes(cipherBase64, &cipherBytes) || cipherBytes.empty()) {
     maintenanceWebServer.send(400, "application/json", "{\"result\":\"NG\",\"detail\":\"invalid cipherBase64\"}");
     return;
   }
-  if (!decodeBase64TextForAp(tagBase64, &tagBytes) || tagBytes.size() != 16) {
+  if (!base64Codec::decodeToBytes(tagBase64, &tagBytes) || tagBytes.size() != 16) {
     maintenanceWebServer.send(400, "application/json", "{\"result\":\"NG\",\"detail\":\"invalid tagBase64\"}");
     return;
   }
@@ -2305,6 +2294,7 @@ bool start(const String& apSsid, sensitiveDataService* sensitiveDataServiceOut)
   maintenanceWebServer.on("/api/pairing/state", HTTP_GET, handlePairingStateApi);
   maintenanceWebServer.on("/api/files/upsert", HTTP_POST, handleManagedFileUpsertApi);
   maintenanceWebServer.on("/api/files/delete", HTTP_POST, handleManagedFileDeleteApi);
+  maintenanceWebServer.on("/api/diagnostics/flash-bench", HTTP_POST, handleFlashBenchmarkApi);
   maintenanceWebServer.on("/api/system/reboot", HTTP_POST, handleRebootApi);
   maintenanceWebServer.begin();
   isServerStarted = true;
@@ -0,0 +1,850 @@
+/**
+ * @file mirrorDownload.cpp
+ * @brief 複数ミラーからのイメージ取得の実装。
+ * @details
+ * - [重要] 要求は常に `Range: bytes=<offset>-` 付き、`Connection: close` で送る。206 応答なら途中からの再開に使える URL、
+ *   200 応答なら範囲要求に応じない URL として記録する。
+ * - [重要] URL が1件だけの場合はプローブを省き、本取得の応答でサイズと範囲要求対応を判定する（従来の単一 URL と同じ要求数）。
+ * - [重要] TLS は接続先 IP へ直接つなぎ、証明書検証は URL のホスト名で行う（6引数 connect）。
+ * - [禁止] 取得速度のために `setInsecure()` で検証を省かない。
+ * - [重要] 時間計測は micros() の差分で行う。totalTimeoutMs は 1 時間で丸めるため桁あふれは起きない。
+ */
+
+#include "mirrorDownload.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#include <mbedtls/sha256.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <vector>
+
+#include "log.h"
+
+namespace {
+
+/** @brief リダイレクトを追う最大回数。@type uint8_t */
+constexpr uint8_t kMirrorRedirectMaxCount = 3;
+/** @brief 応答ヘッダー1行の最大長（Location に署名付き URL が入る分を見込む）。@type size_t */
+constexpr size_t kHeaderLineMaxLength = 512;
+/** @brief 受信バッファ長(byte)。@type size_t */
+constexpr size_t kIoBufferSize = 2048;
+/** @brief 範囲の終端を指定しない場合の値。@type uint32_t */
+constexpr uint32_t kOpenEndedRange = UINT32_MAX;
+/** @brief 既定の User-Agent。@type const char* */
+constexpr const char* kDefaultUserAgent = "esp32lab-mirror/1.0";
+
+/**
+ * @brief URL の分解結果。
+ */
+struct mirrorUrlParts {
+  /** @brief https か。@type bool */
+  bool isTls;
+  /** @brief ホスト名。@type String */
+  String host;
+  /** @brief ポート。@type uint16_t */
+  uint16_t port;
+  /** @brief パス（クエリを含む）。@type String */
+  String path;
+};
+
+/**
+ * @brief 応答ヘッダーの解釈結果。
+ */
+struct mirrorResponseHeader {
+  /** @brief ステータスコード。@type int */
+  int statusCode;
+  /** @brief Content-Length があったか。@type bool */
+  bool hasContentLength;
+  /** @brief Content-Length。@type uint32_t */
+  uint32_t contentLength;
+  /** @brief Content-Range（bytes a-b/total）を解釈できたか。@type bool */
+  bool hasContentRange;
+  /** @brief Content-Range の先頭位置。@type uint32_t */
+  uint32_t rangeStart;
+  /** @brief Content-Range の全体サイズ。@type uint32_t */
+  uint32_t rangeTotal;
+  /** @brief chunked 転送か。@type bool */
+  bool isChunked;
+  /** @brief Location（無い、または長すぎる場合は空）。@type String */
+  String location;
+};
+
+/**
+ * @brief 接続1本分の状態。
+ */
+struct mirrorConnection {
+  /** @brief 平文用クライアント。@type WiFiClient */
+  WiFiClient plainClient;
+  /** @brief TLS 用クライアント。@type WiFiClientSecure */
+  WiFiClientSecure secureClient;
+  /** @brief 使用中のクライアント（未接続なら null）。@type WiFiClient* */
+  WiFiClient* activeClient = nullptr;
+  /** @brief 残りの本文(byte)。@type uint32_t */
+  uint32_t remainingBytes = 0;
+  /** @brief イメージ全体のサイズ(byte)。@type uint32_t */
+  uint32_t totalBytes = 0;
+  /** @brief 206 応答だったか。@type bool */
+  bool isRangeResponse = false;
+  /** @brief 途中からの要求に 200 で応じられたか（範囲要求に非対応）。@type bool */
+  bool isRangeRejected = false;
+};
+
+/**
+ * @brief 値を範囲内へ丸める。
+ */
+uint32_t clampValue(uint32_t value, uint32_t minimum, uint32_t maximum) {
+  if (value < minimum) {
+    return minimum;
+  }
+  return (value > maximum) ? maximum : value;
+}
+
+/**
+ * @brief 転送量と所要時間から KB/s を求める（0 にはしない）。
+ */
+uint32_t calculateKbps(uint32_t bytes, uint32_t elapsedUs) {
+  if (elapsedUs == 0) {
+    elapsedUs = 1;
+  }
+  const uint64_t kbps = (static_cast<uint64_t>(bytes) * 1000000ULL / elapsedUs) / 1024ULL;
+  return (kbps == 0) ? 1U : static_cast<uint32_t>(kbps > UINT32_MAX ? UINT32_MAX : kbps);
+}
+
+/**
+ * @brief URL を分解する（http / https のみ）。
+ */
+bool parseMirrorUrl(const String& urlText, mirrorUrlParts* partsOut) {
+  const int schemeSeparatorIndex = urlText.indexOf("://");
+  if (schemeSeparatorIndex <= 0) {
+    return false;
+  }
+  const String schemeText = urlText.substring(0, schemeSeparatorIndex);
+  if (schemeText.equalsIgnoreCase("https")) {
+    partsOut->isTls = true;
+  } else if (schemeText.equalsIgnoreCase("http")) {
+    partsOut->isTls = false;
+  } else {
+    return false;
+  }
+  const String remainText = urlText.substring(schemeSeparatorIndex + 3);
+  const int pathStartIndex = remainText.indexOf('/');
+  const String authorityText = pathStartIndex >= 0 ? remainText.substring(0, pathStartIndex) : remainText;
+  partsOut->path = pathStartIndex >= 0 ? remainText.substring(pathStartIndex) : String("/");
+  const int portSeparatorIndex = authorityText.indexOf(':');
+  if (portSeparatorIndex >= 0) {
+    partsOut->host = authorityText.substring(0, portSeparatorIndex);
+    const long portValue = authorityText.substring(portSeparatorIndex + 1).toInt();
+    partsOut->port = (portValue > 0 && portValue <= 65535) ? static_cast<uint16_t>(portValue) : 0;
+  } else {
+    partsOut->host = authorityText;
+    partsOut->port = partsOut->isTls ? 443 : 80;
+  }
+  return partsOut->host.length() > 0 && partsOut->port != 0;
+}
+
+/**
+ * @brief リダイレクト先を絶対 URL にする。
+ * @return 解釈できない場合は空文字。
+ */
+String buildRedirectUrl(const mirrorUrlParts& baseParts, const String& location) {
+  if (location.startsWith("http://") || location.startsWith("https://")) {
+    return location;
+  }
+  if (!location.startsWith("/")) {
+    return String("");
+  }
+  return String(baseParts.isTls ? "https://" : "http://") + baseParts.host + ":" + static_cast<unsigned>(baseParts.port) + location;
+}
+
+/**
+ * @brief ホスト名を解決する。
+ */
+bool resolveMirrorHost(const mirrorDownloadOptions& options, const String& host, IPAddress* ipOut) {
+  if (ipOut->fromString(host.c_str())) {
+    return true;
+  }
+  if (options.resolveHost != nullptr) {
+    return options.resolveHost(host.c_str(), ipOut);
+  }
+  return WiFi.hostByName(host.c_str(), *ipOut) == 1;
+}
+
+/**
+ * @brief 接続を閉じる。
+ */
+void closeMirrorConnection(mirrorConnection* connection) {
+  if (connection->activeClient != nullptr) {
+    connection->activeClient->stop();
+    connection->activeClient = nullptr;
+  }
+  connection->remainingBytes = 0;
+}
+
+/**
+ * @brief 受信データが届くまで待つ。
+ * @return 読める byte 数。切断または無通信タイムアウト時は 0。
+ */
+int waitForReadable(WiFiClient* client, uint32_t idleTimeoutUs) {
+  const uint32_t waitStartUs = micros();
+  for (;;) {
+    const int availableSize = client->available();
+    if (availableSize > 0) {
+      return availableSize;
+    }
+    if (!client->connected() || (micros() - waitStartUs) >= idleTimeoutUs) {
+      return 0;
+    }
+    delay(1);
+  }
+}
+
+/**
+ * @brief 数値ヘッダーの値を読む（先頭の空白は読み飛ばす）。
+ */
+bool parseHeaderNumber(const char* text, uint32_t* valueOut, const char** endOut) {
+  while (*text == ' ' || *text == '\t') {
+    ++text;
+  }
+  if (*text < '0' || *text > '9') {
+    return false;
+  }
+  char* endText = nullptr;
+  const unsigned long value = strtoul(text, &endText, 10);
+  *valueOut = static_cast<uint32_t>(value);
+  if (endOut != nullptr) {
+    *endOut = endText;
+  }
+  return true;
+}
+
+/**
+ * @brief 応答ヘッダーを空行まで読む。
+ * @return 空行まで読め、ステータス行を解釈できた場合true。
+ */
+bool readMirrorResponseHeader(WiFiClient* client, uint32_t idleTimeoutUs, mirrorResponseHeader* headerOut) {
+  *headerOut = mirrorResponseHeader{};
+  headerOut->statusCode = -1;
+  char lineBuffer[kHeaderLineMaxLength + 1];
+  size_t lineLength = 0;
+  bool isLineTruncated = false;
+  bool isStatusLine = true;
+  for (;;) {
+    if (waitForReadable(client, idleTimeoutUs) <= 0) {
+      return false;
+    }
+    const int readValue = client->read();
+    if (readValue < 0 || readValue == '\r') {
+      continue;
+    }
+    if (readValue != '\n') {
+      if (lineLength < kHeaderLineMaxLength) {
+        lineBuffer[lineLength++] = static_cast<char>(readValue);
+      } else {
+        isLineTruncated = true;
+      }
+      continue;
+    }
+    lineBuffer[lineLength] = '\0';
+    if (lineLength == 0) {
+      return headerOut->statusCode > 0;
+    }
+    if (isStatusLine) {
+      isStatusLine = false;
+      const char* statusText = strchr(lineBuffer, ' ');
+      if (strncmp(lineBuffer, "HTTP/1.", 7) != 0 || statusText == nullptr) {
+        return false;
+      }
+      headerOut->statusCode = atoi(statusText + 1);
+    } else if (strncasecmp(lineBuffer, "Content-Length:", 15) == 0) {
+      headerOut->hasContentLength = parseHeaderNumber(lineBuffer + 15, &headerOut->contentLength, nullptr);
+    } else if (strncasecmp(lineBuffer, "Content-Range:", 14) == 0) {
+      // [重要] `bytes <start>-<end>/<total>` のみ扱う。total が `*` の応答は再開位置を確かめられないため使わない。
+      const char* rangeText = lineBuffer + 14;
+      while (*rangeText == ' ') {
+        ++rangeText;
+      }
+      uint32_t rangeEnd = 0;
+      const char* cursor = nullptr;
+      headerOut->hasContentRange = strncasecmp(rangeText, "bytes ", 6) == 0 &&
+                                   parseHeaderNumber(rangeText + 6, &headerOut->rangeStart, &cursor) && *cursor == '-' &&
+                                   parseHeaderNumber(cursor + 1, &rangeEnd, &cursor) && *cursor == '/' &&
+                                   parseHeaderNumber(cursor + 1, &headerOut->rangeTotal, nullptr) && rangeEnd >= headerOut->rangeStart &&
+                                   rangeEnd < headerOut->rangeTotal;
+    } else if (strncasecmp(lineBuffer, "Transfer-Encoding:", 18) == 0) {
+      headerOut->isChunked = strstr(lineBuffer + 18, "chunked") != nullptr;
+    } else if (strncasecmp(lineBuffer, "Location:", 9) == 0 && !isLineTruncated) {
+      headerOut->location = String(lineBuffer + 9);
+      headerOut->location.trim();
+    }
+    lineLength = 0;
+    isLineTruncated = false;
+  }
+}
+
+/**
+ * @brief URL へ範囲要求を送り、本文の直前まで読む。
+ * @param urlInOut 要求先 URL。リダイレクトを追った場合は最終 URL へ書き換える。
+ * @param offset 要求する先頭位置(byte)。
+ * @param lastOffset 要求する末尾位置(byte、含む)。kOpenEndedRange なら末尾まで。
+ * @param detailOut 失敗理由の出力先。
+ * @return 本文を読める状態になった場合true。
+ */
+bool openMirrorRange(const mirrorDownloadOptions& options,
+                     String* urlInOut,
+                     uint32_t offset,
+                     uint32_t lastOffset,
+                     uint32_t idleTimeoutUs,
+                     mirrorConnection* connection,
+                     const char** detailOut) {
+  connection->isRangeRejected = false;
+  for (uint8_t redirectCount = 0; redirectCount <= kMirrorRedirectMaxCount; ++redirectCount) {
+    closeMirrorConnection(connection);
+    mirrorUrlParts urlParts;
+    if (!parseMirrorUrl(*urlInOut, &urlParts)) {
+      *detailOut = "invalid url";
+      return false;
+    }
+    if (options.isHttpsRequired && !urlParts.isTls) {
+      *detailOut = "https required";
+      return false;
+    }
+    IPAddress targetIp;
+    if (!resolveMirrorHost(options, urlParts.host, &targetIp)) {
+      *detailOut = "host resolve failed";
+      return false;
+    }
+    if (urlParts.isTls) {
+      if (options.tlsCaCertificate == nullptr || strlen(options.tlsCaCertificate) == 0) {
+        *detailOut = "tls ca certificate unavailable";
+        return false;
+      }
+      if (connection->secureClient.connect(targetIp, urlParts.port, urlParts.host.c_str(), options.tlsCaCertificate, nullptr, nullptr) ==
+          0) {
+        *detailOut = "tls connect failed";
+        return false;
+      }
+      connection->activeClient = &connection->secureClient;
+    } else {
+      if (connection->plainClient.connect(targetIp, urlParts.port) == 0) {
+        *detailOut = "tcp connect failed";
+        return false;
+      }
+      connection->activeClient = &connection->plainClient;
+    }
+
+    const bool isDefaultPort = urlParts.port == (urlParts.isTls ? 443 : 80);
+    String requestText = String("GET ") + urlParts.path + " HTTP/1.1\r\nHost: " + urlParts.host;
+    if (!isDefaultPort) {
+      requestText += ":";
+      requestText += static_cast<unsigned>(urlParts.port);
+    }
+    requestText += "\r\nUser-Agent: ";
+    requestText += (options.userAgent == nullptr) ? kDefaultUserAgent : options.userAgent;
+    requestText += "\r\nAccept-Encoding: identity\r\nRange: bytes=";
+    requestText += static_cast<unsigned long>(offset);
+    requestText += "-";
+    if (lastOffset != kOpenEndedRange) {
+      requestText += static_cast<unsigned long>(lastOffset);
+    }
+    requestText += "\r\nConnection: close\r\n\r\n";
+    if (connection->activeClient->write(reinterpret_cast<const uint8_t*>(requestText.c_str()), requestText.length()) !=
+        requestText.length()) {
+      *detailOut = "http request failed";
+      closeMirrorConnection(connection);
+      return false;
+    }
+
+    mirrorResponseHeader responseHeader;
+    if (!readMirrorResponseHeader(connection->activeClient, idleTimeoutUs, &responseHeader)) {
+      *detailOut = "header read failed";
+      closeMirrorConnection(connection);
+      return false;
+    }
+    const int statusCode = responseHeader.statusCode;
+    if (statusCode == 301 || statusCode == 302 || statusCode == 303 || statusCode == 307 || statusCode == 308) {
+      const String redirectUrl = buildRedirectUrl(urlParts, responseHeader.location);
+      if (redirectUrl.length() == 0) {
+        *detailOut = "invalid redirect";
+        closeMirrorConnection(connection);
+        return false;
+      }
+      *urlInOut = redirectUrl;
+      continue;
+    }
+    if (responseHeader.isChunked || !responseHeader.hasContentLength) {
+      *detailOut = "content length unknown";
+      closeMirrorConnection(connection);
+      return false;
+    }
+    if (statusCode == 206) {
+      if (!responseHeader.hasContentRange || responseHeader.rangeStart != offset ||
+          static_cast<uint64_t>(offset) + responseHeader.contentLength > responseHeader.rangeTotal) {
+        *detailOut = "invalid content range";
+        closeMirrorConnection(connection);
+        return false;
+      }
+      connection->isRangeResponse = true;
+      connection->totalBytes = responseHeader.rangeTotal;
+    } else if (statusCode == 200) {
+      if (offset > 0) {
+        // [厳守] 先頭から返された本文は再開位置と合わないため読まない。
+        connection->isRangeRejected = true;
+        *detailOut = "range not supported";
+        closeMirrorConnection(connection);
+        return false;
+      }
+      connection->isRangeResponse = false;
+      connection->totalBytes = responseHeader.contentLength;
+    } else {
+      appLogWarn("mirrorDownload: unexpected status. status=%d url=%s", statusCode, urlInOut->c_str());
+      *detailOut = "http status not ok";
+      closeMirrorConnection(connection);
+      return false;
+    }
+    if (connection->totalBytes == 0) {
+      *detailOut = "empty image";
+      closeMirrorConnection(connection);
+      return false;
+    }
+    connection->remainingBytes = responseHeader.contentLength;
+    return true;
+  }
+  *detailOut = "too many redirects";
+  closeMirrorConnection(connection);
+  return false;
+}
+
+/**
+ * @brief URL 1件の先頭を取得して速度を測る（本文は捨てる）。
+ * @param totalBytesOut イメージ全体のサイズの出力先。
+ */
+void probeMirrorSource(const mirrorDownloadOptions& options,
+                       mirrorDownloadSourceStats* source,
+                       mirrorConnection* connection,
+                       uint8_t* ioBuffer,
+                       uint32_t* totalBytesOut) {
+  const uint32_t probeTimeoutUs = options.probeTimeoutMs * 1000U;
+  const uint32_t startUs = micros();
+  const char* openDetail = "ok";
+  if (!openMirrorRange(options, &source->url, 0, options.probeBytes - 1, probeTimeoutUs, connection, &openDetail)) {
+    source->detail = openDetail;
+    return;
+  }
+  source->isRangeSupported = connection->isRangeResponse;
+  *totalBytesOut = connection->totalBytes;
+  const uint32_t wantedBytes = (connection->remainingBytes < options.probeBytes) ? connection->remainingBytes : options.probeBytes;
+  uint32_t receivedBytes = 0;
+  while (receivedBytes < wantedBytes && (micros() - startUs) < probeTimeoutUs) {
+    const int availableSize = connection->activeClient->available();
+    if (availableSize <= 0) {
+      if (!connection->activeClient->connected()) {
+        break;
+      }
+      delay(1);
+      continue;
+    }
+    size_t readRequestSize = static_cast<size_t>(availableSize);
+    readRequestSize = (readRequestSize > kIoBufferSize) ? kIoBufferSize : readRequestSize;
+    readRequestSize = (readRequestSize > wantedBytes - receivedBytes) ? wantedBytes - receivedBytes : readRequestSize;
+    const int readSize = connection->activeClient->read(ioBuffer, readRequestSize);
+    if (readSize <= 0) {
+      continue;
+    }
+    if (receivedBytes == 0) {
+      source->probeFirstByteMs = (micros() - startUs) / 1000U;
+    }
+    receivedBytes += static_cast<uint32_t>(readSize);
+  }
+  closeMirrorConnection(connection);
+  if (receivedBytes == 0) {
+    source->detail = "probe received no data";
+    return;
+  }
+  // [重要] 接続開始からの平均とする。小さいイメージでは往復遅延と TLS 接続時間の差が速度差より効くため。
+  source->probeKbps = calculateKbps(receivedBytes, micros() - startUs);
+  source->isProbeOk = true;
+  source->detail = "ok";
+}
+
+/**
+ * @brief 次に使う URL を選ぶ（推定速度が最も速いもの、同速なら優先順）。
+ * @param offset 再開位置。0 より大きい場合は範囲要求に応じる URL に限る。
+ * @param excludedIndex 候補から外す位置（-1 で外さない）。
+ * @return URL の位置。候補が無ければ -1。
+ */
+int8_t selectMirrorSource(const mirrorDownloadResult& result,
+                          const mirrorDownloadOptions& options,
+                          const uint32_t* estimatedKbps,
+                          uint32_t offset,
+                          int8_t excludedIndex) {
+  int8_t bestIndex = -1;
+  for (uint8_t sourceIndex = 0; sourceIndex < result.sourceCount; ++sourceIndex) {
+    const mirrorDownloadSourceStats& source = result.sources[sourceIndex];
+    if (!source.isProbeOk || source.failureCount >= options.maxFailuresPerSource || static_cast<int8_t>(sourceIndex) == excludedIndex) {
+      continue;
+    }
+    if (offset > 0 && !source.isRangeSupported) {
+      continue;
+    }
+    if (bestIndex < 0 || estimatedKbps[sourceIndex] > estimatedKbps[bestIndex]) {
+      bestIndex = static_cast<int8_t>(sourceIndex);
+    }
+  }
+  return bestIndex;
+}
+
+/**
+ * @brief SHA-256 を小文字16進へ変換する。
+ */
+void convertSha256ToHex(const unsigned char hashBytes[32], char hexOut[65]) {
+  static constexpr char hexChars[] = "0123456789abcdef";
+  for (size_t index = 0; index < 32; ++index) {
+    hexOut[index * 2] = hexChars[(hashBytes[index] >> 4) & 0x0F];
+    hexOut[index * 2 + 1] = hexChars[hashBytes[index] & 0x0F];
+  }
+  hexOut[64] = '\0';
+}
+
+/**
+ * @brief 期待値と SHA-256 を比べる（前後の空白と大小文字は無視）。
+ */
+bool isSha256Matched(const char* expectedSha256, const char* actualHex) {
+  while (*expectedSha256 == ' ' || *expectedSha256 == '\t') {
+    ++expectedSha256;
+  }
+  size_t expectedLength = strlen(expectedSha256);
+  while (expectedLength > 0 && (expectedSha256[expectedLength - 1] == ' ' || expectedSha256[expectedLength - 1] == '\t' ||
+                                expectedSha256[expectedLength - 1] == '\r' || expectedSha256[expectedLength - 1] == '\n')) {
+    --expectedLength;
+  }
+  return expectedLength == 64 && strncasecmp(expectedSha256, actualHex, 64) == 0;
+}
+}  // namespace
+
+namespace mirrorDownload {
+
+mirrorDownloadOptions getDefaultOptions() {
+  mirrorDownloadOptions options{};
+  options.probeBytes = 16384;
+  options.probeTimeoutMs = 5000;
+  options.idleTimeoutMs = 15000;
+  options.totalTimeoutMs = 300000;
+  options.throughputWindowMs = 3000;
+  options.collapsePercent = 25;
+  options.maxSwitchCount = 6;
+  options.maxFailuresPerSource = 2;
+  options.maxImageBytes = 0;
+  options.isHttpsRequired = false;
+  options.tlsCaCertificate = nullptr;
+  options.resolveHost = nullptr;
+  options.userAgent = nullptr;
+  return options;
+}
+
+bool run(const String* urls,
+         size_t urlCount,
+         const mirrorDownloadOptions& options,
+         const char* expectedSha256,
+         mirrorDownloadSink sink,
+         void* sinkContext,
+         mirrorDownloadResult* resultOut) {
+  if (resultOut == nullptr) {
+    appLogError("mirrorDownload::run failed. resultOut is null.");
+    return false;
+  }
+  *resultOut = mirrorDownloadResult{};
+  resultOut->finalSourceIndex = -1;
+  resultOut->detail = "ok";
+  if (urls == nullptr || sink == nullptr) {
+    resultOut->detail = "invalid argument";
+    appLogError("mirrorDownload::run failed. urls=%p sink=%p", urls, sink);
+    return false;
+  }
+
+  mirrorDownloadOptions effectiveOptions = options;
+  effectiveOptions.probeBytes = clampValue(options.probeBytes, 1024, 262144);
+  effectiveOptions.probeTimeoutMs = clampValue(options.probeTimeoutMs, 500, 60000);
+  effectiveOptions.idleTimeoutMs = clampValue(options.idleTimeoutMs, 1000, 120000);
+  effectiveOptions.totalTimeoutMs = clampValue(options.totalTimeoutMs, 5000, 3600000);
+  effectiveOptions.throughputWindowMs = clampValue(options.throughputWindowMs, 500, 60000);
+  effectiveOptions.collapsePercent = static_cast<uint8_t>(clampValue(options.collapsePercent, 1, 99));
+  effectiveOptions.maxFailuresPerSource = static_cast<uint8_t>(clampValue(options.maxFailuresPerSource, 1, 16));
+  const uint32_t idleTimeoutUs = effectiveOptions.idleTimeoutMs * 1000U;
+  const uint32_t totalTimeoutUs = effectiveOptions.totalTimeoutMs * 1000U;
+  const uint32_t windowUs = effectiveOptions.throughputWindowMs * 1000U;
+
+  // URL ごとの結果は urls と同じ位置に置く（空文字・重複は候補にしない）。
+  bool isCandidate[kMirrorDownloadMaxSources] = {};
+  uint8_t candidateCount = 0;
+  resultOut->sourceCount = static_cast<uint8_t>((urlCount > kMirrorDownloadMaxSources) ? kMirrorDownloadMaxSources : urlCount);
+  for (uint8_t sourceIndex = 0; sourceIndex < resultOut->sourceCount; ++sourceIndex) {
+    mirrorDownloadSourceStats& source = resultOut->sources[sourceIndex];
+    source.url = urls[sourceIndex];
+    source.url.trim();
+    source.detail = "skipped";
+    isCandidate[sourceIndex] = source.url.length() > 0;
+    for (uint8_t previousIndex = 0; previousIndex < sourceIndex; ++previousIndex) {
+      isCandidate[sourceIndex] = isCandidate[sourceIndex] && !resultOut->sources[previousIndex].url.equals(source.url);
+    }
+    candidateCount = static_cast<uint8_t>(candidateCount + (isCandidate[sourceIndex] ? 1 : 0));
+  }
+  if (candidateCount == 0) {
+    resultOut->detail = "no url";
+    appLogError("mirrorDownload::run failed. no url. urlCount=%lu", static_cast<unsigned long>(urlCount));
+    return false;
+  }
+
+  std::vector<uint8_t> ioBuffer(kIoBufferSize);
+  mirrorConnection connection;
+  uint32_t estimatedKbps[kMirrorDownloadMaxSources] = {};
+  uint32_t totalBytes = 0;
+  const uint32_t startUs = micros();
+
+  // 1. 候補が複数ならプローブして全体サイズと速度を揃える
+  for (uint8_t sourceIndex = 0; sourceIndex < resultOut->sourceCount; ++sourceIndex) {
+    mirrorDownloadSourceStats& source = resultOut->sources[sourceIndex];
+    if (!isCandidate[sourceIndex]) {
+      continue;
+    }
+    if (candidateCount == 1) {
+      // [重要] 比べる相手がいないため、本取得の応答でサイズと範囲要求対応を判定する。
+      source.isProbeOk = true;
+      source.isRangeSupported = false;
+      source.detail = "ok";
+      estimatedKbps[sourceIndex] = 1;
+      break;
+    }
+    uint32_t sourceTotalBytes = 0;
+    probeMirrorSource(effectiveOptions, &source, &connection, ioBuffer.data(), &sourceTotalBytes);
+    if (source.isProbeOk) {
+      if (totalBytes == 0) {
+        totalBytes = sourceTotalBytes;
+      } else if (sourceTotalBytes != totalBytes) {
+        // [厳守] 内容の異なるミラーを混ぜないよう、優先順で最初のサイズと異なる URL は使わない。
+        source.isProbeOk = false;
+        source.detail = "size mismatch";
+      }
+    }
+    estimatedKbps[sourceIndex] = source.probeKbps;
+    appLogInfo("mirrorDownload: probe. index=%u ok=%d range=%d firstByteMs=%lu kbps=%lu total=%lu detail=%s url=%s",
+               static_cast<unsigned>(sourceIndex),
+               source.isProbeOk ? 1 : 0,
+               source.isRangeSupported ? 1 : 0,
+               static_cast<unsigned long>(source.probeFirstByteMs),
+               static_cast<unsigned long>(source.probeKbps),
+               static_cast<unsigned long>(sourceTotalBytes),
+               source.detail,
+               source.url.c_str());
+  }
+
+  // 2. 速い順に取得し、速度低下・無通信・切断で切り替える
+  mbedtls_sha256_context sha256Context;
+  mbedtls_sha256_init(&sha256Context);
+  mbedtls_sha256_starts_ret(&sha256Context, 0);
+  uint32_t offset = 0;
+  bool isAborted = false;
+  bool isFirstConnection = true;
+  int8_t currentIndex = selectMirrorSource(*resultOut, effectiveOptions, estimatedKbps, 0, -1);
+  if (currentIndex < 0) {
+    resultOut->detail = "all probes failed";
+    isAborted = true;
+  }
+  if (!isAborted && effectiveOptions.maxImageBytes > 0 && totalBytes > effectiveOptions.maxImageBytes) {
+    resultOut->detail = "image too large";
+    isAborted = true;
+  }
+  while (!isAborted && (totalBytes == 0 || offset < totalBytes)) {
+    if ((micros() - startUs) >= totalTimeoutUs) {
+      resultOut->detail = "total timeout";
+      break;
+    }
+    if (currentIndex < 0) {
+      resultOut->detail = "no usable source";
+      break;
+    }
+    if (!isFirstConnection) {
+      if (resultOut->switchCount >= effectiveOptions.maxSwitchCount) {
+        resultOut->detail = "switch limit reached";
+        break;
+      }
+      ++resultOut->switchCount;
+    }
+    isFirstConnection = false;
+
+    mirrorDownloadSourceStats& source = resultOut->sources[currentIndex];
+    const char* openDetail = "ok";
+    if (!openMirrorRange(effectiveOptions, &source.url, offset, kOpenEndedRange, idleTimeoutUs, &connection, &openDetail)) {
+      source.isRangeSupported = source.isRangeSupported && !connection.isRangeRejected;
+      ++source.failureCount;
+      source.detail = openDetail;
+      appLogWarn("mirrorDownload: open failed. index=%d offset=%lu detail=%s url=%s",
+                 static_cast<int>(currentIndex),
+                 static_cast<unsigned long>(offset),
+                 openDetail,
+                 source.url.c_str());
+      currentIndex = selectMirrorSource(*resultOut, effectiveOptions, estimatedKbps, offset, -1);
+      continue;
+    }
+    if (totalBytes == 0) {
+      totalBytes = connection.totalBytes;
+      if (effectiveOptions.maxImageBytes > 0 && totalBytes > effectiveOptions.maxImageBytes) {
+        resultOut->detail = "image too large";
+        break;
+      }
+    }
+    source.isRangeSupported = connection.isRangeResponse;
+    if (connection.totalBytes != totalBytes) {
+      source.isProbeOk = false;
+      source.detail = "size mismatch";
+      closeMirrorConnection(&connection);
+      currentIndex = selectMirrorSource(*resultOut, effectiveOptions, estimatedKbps, offset, -1);
+      continue;
+    }
+
+    const uint32_t connectionStartUs = micros();
+    uint32_t connectionBytes = 0;
+    uint32_t windowStartUs = connectionStartUs;
+    uint32_t windowBytes = 0;
+    uint32_t peakKbps = 0;
+    uint32_t lastDataUs = connectionStartUs;
+    int8_t nextIndex = -1;
+    const char* failureDetail = nullptr;
+    while (connection.remainingBytes > 0) {
+      const uint32_t nowUs = micros();
+      if ((nowUs - startUs) >= totalTimeoutUs) {
+        resultOut->detail = "total timeout";
+        isAborted = true;
+        break;
+      }
+      // [重要] 区間の速度が接続内の最高値から崩れ、推定速度で上回る URL がある場合だけ切り替える。
+      const uint32_t windowElapsedUs = nowUs - windowStartUs;
+      if (windowElapsedUs >= windowUs) {
+        const uint32_t windowKbps = (windowBytes == 0) ? 0 : calculateKbps(windowBytes, windowElapsedUs);
+        if (windowKbps > peakKbps) {
+          peakKbps = windowKbps;
+        } else if (static_cast<uint64_t>(windowKbps) * 100U < static_cast<uint64_t>(peakKbps) * effectiveOptions.collapsePercent) {
+          const int8_t alternativeIndex = selectMirrorSource(*resultOut, effectiveOptions, estimatedKbps, offset, currentIndex);
+          if (alternativeIndex >= 0 && estimatedKbps[alternativeIndex] > windowKbps) {
+            appLogWarn("mirrorDownload: throughput collapsed. index=%d windowKbps=%lu peakKbps=%lu offset=%lu next=%d",
+                       static_cast<int>(currentIndex),
+                       static_cast<unsigned long>(windowKbps),
+                       static_cast<unsigned long>(peakKbps),
+                       static_cast<unsigned long>(offset),
+                       static_cast<int>(alternativeIndex));
+            estimatedKbps[currentIndex] = windowKbps;
+            nextIndex = alternativeIndex;
+            break;
+          }
+        }
+        windowStartUs = nowUs;
+        windowBytes = 0;
+      }
+
+      const int availableSize = connection.activeClient->available();
+      if (availableSize <= 0) {
+        if (!connection.activeClient->connected()) {
+          failureDetail = "disconnected";
+          break;
+        }
+        if ((nowUs - lastDataUs) >= idleTimeoutUs) {
+          failureDetail = "idle timeout";
+          break;
+        }
+        delay(1);
+        continue;
+      }
+      size_t readRequestSize = static_cast<size_t>(availableSize);
+      readRequestSize = (readRequestSize > ioBuffer.size()) ? ioBuffer.size() : readRequestSize;
+      readRequestSize = (readRequestSize > connection.remainingBytes) ? connection.remainingBytes : readRequestSize;
+      const int readSize = connection.activeClient->read(ioBuffer.data(), readRequestSize);
+      if (readSize <= 0) {
+        continue;
+      }
+      mbedtls_sha256_update_ret(&sha256Context, ioBuffer.data(), static_cast<size_t>(readSize));
+      if (!sink(sinkContext, ioBuffer.data(), static_cast<size_t>(readSize), offset, totalBytes)) {
+        resultOut->detail = "sink rejected data";
+        isAborted = true;
+        break;
+      }
+      offset += static_cast<uint32_t>(readSize);
+      connection.remainingBytes -= static_cast<uint32_t>(readSize);
+      connectionBytes += static_cast<uint32_t>(readSize);
+      windowBytes += static_cast<uint32_t>(readSize);
+      source.downloadedBytes += static_cast<uint32_t>(readSize);
+      resultOut->usedSourceMask = static_cast<uint8_t>(resultOut->usedSourceMask | (1U << currentIndex));
+      resultOut->finalSourceIndex = currentIndex;
+      lastDataUs = micros();
+    }
+    const uint32_t connectionElapsedUs = micros() - connectionStartUs;
+    closeMirrorConnection(&connection);
+    if (isAborted || offset >= totalBytes) {
+      break;
+    }
+    if (nextIndex >= 0) {
+      currentIndex = nextIndex;
+      continue;
+    }
+    if (failureDetail == nullptr) {
+      // 本文が Content-Length より先に尽きた（通常は起きない）
+      failureDetail = "body ended early";
+    }
+    ++source.failureCount;
+    source.detail = failureDetail;
+    if (connectionElapsedUs >= windowUs) {
+      estimatedKbps[currentIndex] = calculateKbps(connectionBytes, connectionElapsedUs);
+    }
+    appLogWarn("mirrorDownload: transfer interrupted. index=%d offset=%lu detail=%s failures=%u",
+               static_cast<int>(currentIndex),
+               static_cast<unsigned long>(offset),
+               failureDetail,
+               static_cast<unsigned>(source.failureCount));
+    currentIndex = selectMirrorSource(*resultOut, effectiveOptions, estimatedKbps, offset, -1);
+  }
+
+  unsigned char hashBytes[32];
+  mbedtls_sha256_finish_ret(&sha256Context, hashBytes);
+  mbedtls_sha256_free(&sha256Context);
+  resultOut->totalBytes = totalBytes;
+  resultOut->downloadedBytes = offset;
+  resultOut->elapsedMs = (micros() - startUs) / 1000U;
+
+  bool runResult = false;
+  if (totalBytes > 0 && offset == totalBytes) {
+    convertSha256ToHex(hashBytes, resultOut->sha256Hex);
+    if (expectedSha256 != nullptr && strlen(expectedSha256) > 0 && !isSha256Matched(expectedSha256, resultOut->sha256Hex)) {
+      resultOut->detail = "sha256 mismatch";
+    } else {
+      resultOut->detail = "ok";
+      runResult = true;
+    }
+  } else if (strcmp(resultOut->detail, "ok") == 0) {
+    resultOut->detail = "incomplete";
+  }
+
+  if (!runResult) {
+    appLogError("mirrorDownload::run failed. %s downloaded=%lu total=%lu switches=%u usedMask=0x%02X sha256=%s",
+                resultOut->detail,
+                static_cast<unsigned long>(offset),
+                static_cast<unsigned long>(totalBytes),
+                static_cast<unsigned>(resultOut->switchCount),
+                static_cast<unsigned>(resultOut->usedSourceMask),
+                resultOut->sha256Hex);
+    return false;
+  }
+  appLogInfo("mirrorDownload::run success. total=%lu elapsedMs=%lu switches=%u usedMask=0x%02X final=%d sha256=%s",
+             static_cast<unsigned long>(totalBytes),
+             static_cast<unsigned long>(resultOut->elapsedMs),
+             static_cast<unsigned>(resultOut->switchCount),
+             static_cast<unsigned>(resultOut->usedSourceMask),
+             static_cast<int>(resultOut->finalSourceIndex),
+             resultOut->sha256Hex);
+  return true;
+}
+
+}  // namespace mirrorDownload
@@ -0,0 +1,561 @@
+/**
+ * @file networkSelfTest.cpp
+ * @brief 通信経路の自己診断（TCP / TLS）の実装。
+ * @details
+ * - [重要] 1モードにつき接続を1本だけ張り、keep-alive で ping → ダウンロード → アップロードを順に流す。
+ *   接続を張り直さないため、TLS のハンドシェイク費用は connectUs / tlsHandshakeUs にだけ現れる。
+ * - [重要] 受信は available() を 1ms 間隔で確認して読む。読めた時刻の間隔を記録し、閾値以上を停滞として数える。
+ *   送信は write() 1回の所要時間（送信バッファが空くまでの待ち）を間隔として扱う。
+ * - [重要] 時間計測は micros() の差分で行う。集計（度数分布・KB/s）は diagnosticStats を使う。
+ */
+
+#include "networkSelfTest.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#include <cJSON.h>
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "diagnosticStats.h"
+#include "log.h"
+
+namespace {
+
+/** @brief 無通信のまま待つ上限(us)。@type uint32_t */
+constexpr uint32_t kIoTimeoutUs = 10000000;
+/** @brief 転送中に RSSI を採取する間隔(us)。@type uint32_t */
+constexpr uint32_t kRssiSampleIntervalUs = 250000;
+/** @brief 応答ヘッダー1行の最大長。@type size_t */
+constexpr size_t kHeaderLineMaxLength = 128;
+
+/** @brief 送受信バッファ。 */
+uint8_t selfTestBuffer[2048];
+/** @brief 実行中フラグの排他。 */
+portMUX_TYPE selfTestLock = portMUX_INITIALIZER_UNLOCKED;
+/** @brief 実行中フラグ。 */
+bool isSelfTestRunning = false;
+/** @brief 直近に RSSI を採取した時刻(us)。 */
+uint32_t lastRssiSampleUs = 0;
+
+/**
+ * @brief RSSI を採取する。
+ * @param report 記録先。
+ * @param isForced true なら採取間隔に関係なく採取する。
+ */
+void sampleRssi(networkSelfTestReport* report, bool isForced) {
+  const uint32_t nowUs = micros();
+  if (!isForced && (nowUs - lastRssiSampleUs) < kRssiSampleIntervalUs) {
+    return;
+  }
+  lastRssiSampleUs = nowUs;
+  const int8_t rssi = WiFi.RSSI();
+  if (report->rssiSampleCount == 0 || rssi < report->rssiMin) {
+    report->rssiMin = rssi;
+  }
+  if (report->rssiSampleCount == 0 || rssi > report->rssiMax) {
+    report->rssiMax = rssi;
+  }
+  report->rssiSum += rssi;
+  ++report->rssiSampleCount;
+}
+
+/**
+ * @brief 往復時間1回分を記録する。
+ */
+void recordRtt(networkSelfTestModeResult* mode, uint32_t elapsedUs) {
+  ++mode->rttCount;
+  mode->rttTotalUs += elapsedUs;
+  mode->rttMinUs = (elapsedUs < mode->rttMinUs) ? elapsedUs : mode->rttMinUs;
+  mode->rttMaxUs = (elapsedUs > mode->rttMaxUs) ? elapsedUs : mode->rttMaxUs;
+  diagnosticStats::recordLog2Bucket(mode->rttBuckets, kNetworkSelfTestBucketCount, elapsedUs);
+}
+
+/**
+ * @brief 受信/送信間隔1回分を記録する。
+ */
+void recordGap(networkSelfTestTransfer* transfer, uint32_t gapUs, uint32_t stallThresholdUs) {
+  transfer->maxGapUs = (gapUs > transfer->maxGapUs) ? gapUs : transfer->maxGapUs;
+  if (gapUs >= stallThresholdUs) {
+    ++transfer->stallCount;
+    transfer->stallTotalUs += gapUs;
+  }
+}
+
+/**
+ * @brief 受信データが届くまで待つ。
+ * @return 読める byte 数。切断または無通信タイムアウト時は 0。
+ */
+int waitForReadable(WiFiClient* client, networkSelfTestReport* report) {
+  const uint32_t waitStartUs = micros();
+  for (;;) {
+    const int availableSize = client->available();
+    if (availableSize > 0) {
+      return availableSize;
+    }
+    if (!client->connected() || (micros() - waitStartUs) >= kIoTimeoutUs) {
+      return 0;
+    }
+    sampleRssi(report, false);
+    delay(1);
+  }
+}
+
+/**
+ * @brief 文字列を全量送信する。
+ */
+bool writeText(WiFiClient* client, const char* text) {
+  const size_t textLength = strlen(text);
+  return client->write(reinterpret_cast<const uint8_t*>(text), textLength) == textLength;
+}
+
+/**
+ * @brief 応答ヘッダーを読み、ステータスと Content-Length を返す。
+ * @param contentLengthOut Content-Length（無ければ 0）。
+ * @return 空行まで読めた場合true。
+ */
+bool readResponseHeader(WiFiClient* client, networkSelfTestReport* report, int* statusCodeOut, uint32_t* contentLengthOut) {
+  *statusCodeOut = -1;
+  *contentLengthOut = 0;
+  char lineBuffer[kHeaderLineMaxLength + 1];
+  size_t lineLength = 0;
+  bool isStatusLine = true;
+  for (;;) {
+    if (waitForReadable(client, report) <= 0) {
+      return false;
+    }
+    const int readValue = client->read();
+    if (readValue < 0) {
+      continue;
+    }
+    if (readValue == '\r') {
+      continue;
+    }
+    if (readValue != '\n') {
+      if (lineLength < kHeaderLineMaxLength) {
+        lineBuffer[lineLength++] = static_cast<char>(readValue);
+      }
+      continue;
+    }
+    lineBuffer[lineLength] = '\0';
+    if (lineLength == 0) {
+      return *statusCodeOut > 0;
+    }
+    if (isStatusLine) {
+      isStatusLine = false;
+      const char* statusText = strchr(lineBuffer, ' ');
+      if (strncmp(lineBuffer, "HTTP/1.", 7) != 0 || statusText == nullptr) {
+        return false;
+      }
+      *statusCodeOut = atoi(statusText + 1);
+    } else if (strncasecmp(lineBuffer, "Content-Length:", 15) == 0) {
+      *contentLengthOut = static_cast<uint32_t>(strtoul(lineBuffer + 15, nullptr, 10));
+    }
+    lineLength = 0;
+  }
+}
+
+/**
+ * @brief 応答本文を読む。
+ * @param transfer 間隔の記録先（null なら読み捨てのみ）。
+ * @param textOut 先頭を文字列として残す先（null可）。
+ * @return 全量読めた場合true。
+ */
+bool readResponseBody(WiFiClient* client,
+                      networkSelfTestReport* report,
+                      uint32_t bodyLength,
+                      networkSelfTestTransfer* transfer,
+                      char* textOut,
+                      size_t textCapacity) {
+  const uint32_t stallThresholdUs = static_cast<uint32_t>(report->options.stallThresholdMs) * 1000U;
+  uint32_t remainingBytes = bodyLength;
+  uint32_t lastArrivalUs = micros();
+  size_t textLength = 0;
+  while (remainingBytes > 0) {
+    const int availableSize = waitForReadable(client, report);
+    if (availableSize <= 0) {
+      return false;
+    }
+    size_t readRequestSize = static_cast<size_t>(availableSize);
+    readRequestSize = (readRequestSize > sizeof(selfTestBuffer)) ? sizeof(selfTestBuffer) : readRequestSize;
+    readRequestSize = (readRequestSize > remainingBytes) ? remainingBytes : readRequestSize;
+    const int readSize = client->read(selfTestBuffer, readRequestSize);
+    if (readSize <= 0) {
+      continue;
+    }
+    const uint32_t nowUs = micros();
+    if (transfer != nullptr) {
+      recordGap(transfer, nowUs - lastArrivalUs, stallThresholdUs);
+      transfer->bytes += static_cast<uint32_t>(readSize);
+    }
+    lastArrivalUs = nowUs;
+    if (textOut != nullptr && textLength + 1 < textCapacity) {
+      const size_t copySize = (static_cast<size_t>(readSize) < textCapacity - 1 - textLength) ? static_cast<size_t>(readSize)
+                                                                                                : textCapacity - 1 - textLength;
+      memcpy(textOut + textLength, selfTestBuffer, copySize);
+      textLength += copySize;
+    }
+    remainingBytes -= static_cast<uint32_t>(readSize);
+    sampleRssi(report, false);
+  }
+  if (textOut != nullptr && textCapacity > 0) {
+    textOut[textLength] = '\0';
+  }
+  return true;
+}
+
+/**
+ * @brief ping を指定回数行う。
+ * @return 接続を保てた場合true（個々の非200応答は rttErrorCount に数える）。
+ */
+bool measurePing(WiFiClient* client, networkSelfTestReport* report, networkSelfTestModeResult* mode) {
+  char requestText[160];
+  snprintf(requestText,
+           sizeof(requestText),
+           "GET /selftest/ping HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+           report->options.host);
+  for (uint16_t pingIndex = 0; pingIndex < report->options.pingCount; ++pingIndex) {
+    const uint32_t startUs = micros();
+    int statusCode = -1;
+    uint32_t contentLength = 0;
+    if (!writeText(client, requestText) || !readResponseHeader(client, report, &statusCode, &contentLength) ||
+        !readResponseBody(client, report, contentLength, nullptr, nullptr, 0)) {
+      ++mode->rttErrorCount;
+      return false;
+    }
+    if (statusCode != 200) {
+      ++mode->rttErrorCount;
+      continue;
+    }
+    recordRtt(mode, micros() - startUs);
+  }
+  return true;
+}
+
+/**
+ * @brief ダウンロードを計測する。
+ */
+bool measureDownload(WiFiClient* client, networkSelfTestReport* report, networkSelfTestModeResult* mode) {
+  char requestText[192];
+  snprintf(requestText,
+           sizeof(requestText),
+           "GET /selftest/download?bytes=%lu HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+           static_cast<unsigned long>(report->options.transferBytes),
+           report->options.host);
+  const uint32_t startUs = micros();
+  int statusCode = -1;
+  uint32_t contentLength = 0;
+  if (!writeText(client, requestText) || !readResponseHeader(client, report, &statusCode, &contentLength)) {
+    return false;
+  }
+  if (statusCode != 200 || contentLength != report->options.transferBytes) {
+    appLogWarn("networkSelfTest: unexpected download response. mode=%s status=%d contentLength=%lu",
+               mode->name,
+               statusCode,
+               static_cast<unsigned long>(contentLength));
+    return false;
+  }
+  const bool bodyResult = readResponseBody(client, report, contentLength, &mode->download, nullptr, 0);
+  mode->download.elapsedUs = micros() - startUs;
+  mode->download.isComplete = bodyResult && mode->download.bytes == report->options.transferBytes;
+  return mode->download.isComplete;
+}
+
+/**
+ * @brief アップロードを計測する。
+ */
+bool measureUpload(WiFiClient* client, networkSelfTestReport* report, networkSelfTestModeResult* mode) {
+  char requestText[224];
+  snprintf(requestText,
+           sizeof(requestText),
+           "POST /selftest/upload HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n"
+           "Content-Type: application/octet-stream\r\nContent-Length: %lu\r\n\r\n",
+           report->options.host,
+           static_cast<unsigned long>(report->options.transferBytes));
+  for (size_t byteIndex = 0; byteIndex < sizeof(selfTestBuffer); ++byteIndex) {
+    selfTestBuffer[byteIndex] = static_cast<uint8_t>(byteIndex * 31U + 7U);
+  }
+  const uint32_t stallThresholdUs = static_cast<uint32_t>(report->options.stallThresholdMs) * 1000U;
+  const uint32_t startUs = micros();
+  if (!writeText(client, requestText)) {
+    return false;
+  }
+  while (mode->upload.bytes < report->options.transferBytes) {
+    const uint32_t remainingBytes = report->options.transferBytes - mode->upload.bytes;
+    const size_t chunkSize = (remainingBytes < sizeof(selfTestBuffer)) ? remainingBytes : sizeof(selfTestBuffer);
+    const uint32_t writeStartUs = micros();
+    const size_t writtenSize = client->write(selfTestBuffer, chunkSize);
+    recordGap(&mode->upload, micros() - writeStartUs, stallThresholdUs);
+    mode->upload.bytes += static_cast<uint32_t>(writtenSize);
+    if (writtenSize != chunkSize) {
+      mode->upload.elapsedUs = micros() - startUs;
+      return false;
+    }
+    sampleRssi(report, false);
+  }
+
+  int statusCode = -1;
+  uint32_t contentLength = 0;
+  char responseText[32];
+  if (!readResponseHeader(client, report, &statusCode, &contentLength) ||
+      !readResponseBody(client, report, contentLength, nullptr, responseText, sizeof(responseText))) {
+    mode->upload.elapsedUs = micros() - startUs;
+    return false;
+  }
+  mode->upload.elapsedUs = micros() - startUs;
+  // [重要] サーバーが受け取った量で完了を判定する（送信バッファへ積んだだけの量では判定しない）。
+  const uint32_t receivedBytes = (strncmp(responseText, "received=", 9) == 0)
+                                     ? static_cast<uint32_t>(strtoul(responseText + 9, nullptr, 10))
+                                     : 0;
+  mode->upload.isComplete = statusCode == 200 && receivedBytes == report->options.transferBytes;
+  return mode->upload.isComplete;
+}
+
+/**
+ * @brief 1モード分（接続 → ping → ダウンロード → アップロード）を計測する。
+ */
+void measureMode(const IPAddress& targetIp, bool useTls, networkSelfTestReport* report, networkSelfTestModeResult* mode) {
+  mode->isAttempted = true;
+  mode->rttMinUs = UINT32_MAX;
+  WiFiClient plainClient;
+  WiFiClientSecure secureClient;
+  WiFiClient* activeClient = useTls ? static_cast<WiFiClient*>(&secureClient) : &plainClient;
+  sampleRssi(report, true);
+
+  if (useTls) {
+    if (report->options.tlsCaCertificate == nullptr || strlen(report->options.tlsCaCertificate) == 0) {
+      mode->detail = "tls ca certificate unavailable";
+      return;
+    }
+    // [重要] 同じポートへの TCP 接続時間を先に測り、TLS 接続時間から差し引いてハンドシェイク時間とする。
+    WiFiClient probeClient;
+    const uint32_t probeStartUs = micros();
+    const bool probeResult = probeClient.connect(targetIp, mode->port) != 0;
+    const uint32_t probeUs = micros() - probeStartUs;
+    probeClient.stop();
+    if (!probeResult) {
+      mode->detail = "tcp connect failed";
+      return;
+    }
+    const uint32_t connectStartUs = micros();
+    const bool connectResult =
+        secureClient.connect(targetIp, mode->port, report->options.host, report->options.tlsCaCertificate, nullptr, nullptr) != 0;
+    mode->connectUs = micros() - connectStartUs;
+    if (!connectResult) {
+      mode->detail = "tls connect failed";
+      return;
+    }
+    mode->tlsHandshakeUs = (mode->connectUs > probeUs) ? (mode->connectUs - probeUs) : 0;
+  } else {
+    const uint32_t connectStartUs = micros();
+    const bool connectResult = plainClient.connect(targetIp, mode->port) != 0;
+    mode->connectUs = micros() - connectStartUs;
+    if (!connectResult) {
+      mode->detail = "tcp connect failed";
+      return;
+    }
+  }
+
+  if (!measurePing(activeClient, report, mode)) {
+    mode->detail = "ping failed";
+  } else if (!measureDownload(activeClient, report, mode)) {
+    mode->detail = "download failed";
+  } else if (!measureUpload(activeClient, report, mode)) {
+    mode->detail = "upload failed";
+  } else {
+    mode->detail = "ok";
+    mode->isSuccess = true;
+  }
+  activeClient->stop();
+  sampleRssi(report, true);
+}
+
+/**
+ * @brief 転送結果を JSON へ書き込む。
+ */
+void appendTransferToJson(const networkSelfTestTransfer& transfer, cJSON* objectOut) {
+  cJSON_AddNumberToObject(objectOut, "bytes", transfer.bytes);
+  cJSON_AddNumberToObject(objectOut, "elapsedUs", transfer.elapsedUs);
+  if (transfer.bytes > 0 && transfer.elapsedUs > 0) {
+    cJSON_AddNumberToObject(objectOut, "kbps", diagnosticStats::computeKiloBytesPerSecond(transfer.bytes, transfer.elapsedUs));
+  }
+  cJSON_AddNumberToObject(objectOut, "stalls", transfer.stallCount);
+  cJSON_AddNumberToObject(objectOut, "stallMs", transfer.stallTotalUs / 1000U);
+  cJSON_AddNumberToObject(objectOut, "maxGapUs", transfer.maxGapUs);
+  cJSON_AddBoolToObject(objectOut, "complete", transfer.isComplete);
+}
+}  // namespace
+
+namespace networkSelfTest {
+
+networkSelfTestOptions getDefaultOptions() {
+  networkSelfTestOptions options{};
+  options.host = nullptr;
+  options.tcpPort = 8090;
+  options.tlsPort = 8443;
+  options.transferBytes = 131072;
+  options.pingCount = 16;
+  options.stallThresholdMs = 200;
+  options.tlsCaCertificate = nullptr;
+  return options;
+}
+
+bool run(const networkSelfTestOptions& options, networkSelfTestReport* reportOut, const char** detailOut) {
+  const char* detailText = "ok";
+  if (reportOut == nullptr) {
+    appLogError("networkSelfTest::run failed. reportOut is null.");
+    return false;
+  }
+  *reportOut = networkSelfTestReport{};
+  portENTER_CRITICAL(&selfTestLock);
+  const bool wasRunning = isSelfTestRunning;
+  isSelfTestRunning = true;
+  portEXIT_CRITICAL(&selfTestLock);
+  if (wasRunning) {
+    if (detailOut != nullptr) {
+      *detailOut = "self test is already running";
+    }
+    appLogWarn("networkSelfTest::run rejected. already running.");
+    return false;
+  }
+
+  bool runResult = false;
+  do {
+    reportOut->options = options;
+    reportOut->options.transferBytes = diagnosticStats::clampValue(options.transferBytes, 4096, 1048576);
+    reportOut->options.pingCount = static_cast<uint16_t>(diagnosticStats::clampValue(options.pingCount, 1, 64));
+    reportOut->options.stallThresholdMs = static_cast<uint16_t>(diagnosticStats::clampValue(options.stallThresholdMs, 50, 2000));
+    reportOut->modes[0].name = "tcp";
+    reportOut->modes[0].port = options.tcpPort;
+    reportOut->modes[0].detail = "skipped";
+    reportOut->modes[1].name = "tls";
+    reportOut->modes[1].port = options.tlsPort;
+    reportOut->modes[1].detail = "skipped";
+    if (options.host == nullptr || strlen(options.host) == 0) {
+      detailText = "host is empty";
+      break;
+    }
+    if (options.tcpPort == 0 && options.tlsPort == 0) {
+      detailText = "both ports are 0";
+      break;
+    }
+    if (WiFi.status() != WL_CONNECTED) {
+      detailText = "wifi is not connected";
+      break;
+    }
+
+    const uint32_t startUs = micros();
+    IPAddress targetIp;
+    if (!targetIp.fromString(options.host)) {
+      const uint32_t dnsStartUs = micros();
+      const bool resolveResult = WiFi.hostByName(options.host, targetIp) == 1;
+      reportOut->dnsUs = micros() - dnsStartUs;
+      if (!resolveResult) {
+        detailText = "host resolve failed";
+        break;
+      }
+    }
+    snprintf(reportOut->resolvedIp, sizeof(reportOut->resolvedIp), "%s", targetIp.toString().c_str());
+
+    for (uint8_t modeIndex = 0; modeIndex < kNetworkSelfTestModeCount; ++modeIndex) {
+      if (reportOut->modes[modeIndex].port != 0) {
+        measureMode(targetIp, modeIndex == 1, reportOut, &reportOut->modes[modeIndex]);
+      }
+    }
+    reportOut->elapsedMs = (micros() - startUs) / 1000U;
+    runResult = true;
+  } while (false);
+
+  portENTER_CRITICAL(&selfTestLock);
+  isSelfTestRunning = false;
+  portEXIT_CRITICAL(&selfTestLock);
+  if (detailOut != nullptr) {
+    *detailOut = detailText;
+  }
+  if (!runResult) {
+    appLogError("networkSelfTest::run failed. %s host=%s",
+                detailText,
+                options.host == nullptr ? "(null)" : options.host);
+    return false;
+  }
+  appLogInfo("networkSelfTest::run success. host=%s ip=%s elapsedMs=%lu tcp=%s tls=%s",
+             reportOut->options.host,
+             reportOut->resolvedIp,
+             static_cast<unsigned long>(reportOut->elapsedMs),
+             reportOut->modes[0].detail,
+             reportOut->modes[1].detail);
+  return true;
+}
+
+bool appendReportToJson(const networkSelfTestReport& report, cJSON* objectOut) {
+  if (objectOut == nullptr) {
+    appLogError("networkSelfTest::appendReportToJson failed. objectOut is null.");
+    return false;
+  }
+  cJSON_AddStringToObject(objectOut, "host", report.options.host == nullptr ? "" : report.options.host);
+  cJSON_AddStringToObject(objectOut, "ip", report.resolvedIp);
+  cJSON_AddNumberToObject(objectOut, "dnsUs", report.dnsUs);
+  cJSON_AddNumberToObject(objectOut, "elapsedMs", report.elapsedMs);
+  cJSON* optionsObject = cJSON_AddObjectToObject(objectOut, "options");
+  cJSON* rssiObject = cJSON_AddObjectToObject(objectOut, "rssi");
+  cJSON* modesArray = cJSON_AddArrayToObject(objectOut, "modes");
+  if (optionsObject == nullptr || rssiObject == nullptr || modesArray == nullptr) {
+    appLogError("networkSelfTest::appendReportToJson failed. cJSON allocation returned null.");
+    return false;
+  }
+  cJSON_AddNumberToObject(optionsObject, "tcpPort", report.options.tcpPort);
+  cJSON_AddNumberToObject(optionsObject, "tlsPort", report.options.tlsPort);
+  cJSON_AddNumberToObject(optionsObject, "bytes", report.options.transferBytes);
+  cJSON_AddNumberToObject(optionsObject, "pings", report.options.pingCount);
+  cJSON_AddNumberToObject(optionsObject, "stallMs", report.options.stallThresholdMs);
+  cJSON_AddNumberToObject(rssiObject, "min", report.rssiMin);
+  cJSON_AddNumberToObject(rssiObject, "max", report.rssiMax);
+  cJSON_AddNumberToObject(rssiObject, "avg", report.rssiSampleCount > 0 ? report.rssiSum / report.rssiSampleCount : 0);
+  cJSON_AddNumberToObject(rssiObject, "samples", report.rssiSampleCount);
+
+  for (uint8_t modeIndex = 0; modeIndex < kNetworkSelfTestModeCount; ++modeIndex) {
+    const networkSelfTestModeResult& mode = report.modes[modeIndex];
+    if (!mode.isAttempted) {
+      continue;
+    }
+    cJSON* modeObject = cJSON_CreateObject();
+    if (modeObject == nullptr) {
+      appLogError("networkSelfTest::appendReportToJson failed. cJSON_CreateObject returned null.");
+      return false;
+    }
+    cJSON_AddStringToObject(modeObject, "mode", mode.name);
+    cJSON_AddNumberToObject(modeObject, "port", mode.port);
+    cJSON_AddBoolToObject(modeObject, "ok", mode.isSuccess);
+    cJSON_AddStringToObject(modeObject, "detail", mode.detail == nullptr ? "" : mode.detail);
+    cJSON_AddNumberToObject(modeObject, "connectUs", mode.connectUs);
+    if (modeIndex == 1) {
+      cJSON_AddNumberToObject(modeObject, "tlsHandshakeUs", mode.tlsHandshakeUs);
+    }
+    cJSON* rttObject = cJSON_AddObjectToObject(modeObject, "rtt");
+    if (rttObject != nullptr) {
+      cJSON_AddNumberToObject(rttObject, "count", mode.rttCount);
+      cJSON_AddNumberToObject(rttObject, "errors", mode.rttErrorCount);
+      cJSON_AddNumberToObject(rttObject, "minUs", mode.rttCount > 0 ? mode.rttMinUs : 0);
+      cJSON_AddNumberToObject(rttObject, "maxUs", mode.rttMaxUs);
+      cJSON_AddNumberToObject(rttObject, "avgUs", mode.rttCount > 0 ? mode.rttTotalUs / mode.rttCount : 0);
+      diagnosticStats::appendBucketsToJson(rttObject, "buckets", mode.rttBuckets, kNetworkSelfTestBucketCount);
+    }
+    cJSON* downloadObject = cJSON_AddObjectToObject(modeObject, "download");
+    if (downloadObject != nullptr) {
+      appendTransferToJson(mode.download, downloadObject);
+    }
+    cJSON* uploadObject = cJSON_AddObjectToObject(modeObject, "upload");
+    if (uploadObject != nullptr) {
+      appendTransferToJson(mode.upload, uploadObject);
+    }
+    cJSON_AddItemToArray(modesArray, modeObject);
+  }
+  return true;
+}
+
+}  // namespace networkSelfTest
@@ -3,47 +3,125 @@
  * @brief OTA更新機能のタスク実装。
  * @details
  * - [重要] MQTTで受信したOTA開始要求を受け、HTTPS/HTTPからfirmware.binを取得して更新する。
+ * - [重要] 取得は mirrorDownload へ任せる。ミラー（mirrorUrls）と firmwareUrl から速い URL を選び、速度低下・切断時は
+ *   範囲要求で他の URL へ切り替えて続きを書き込む。SHA256 不一致の試行で使った URL は次の試行の候補から外す。
  * - [厳守] SHA256一致を確認できた場合のみOTAを確定する。
- * - [禁止] 検証失敗時にUpdate.end(true)で不完全イメージを確定しない。
+ * - [禁止] 検証失敗時に esp_ota_set_boot_partition() で不完全イメージを起動面へ設定しない。
+ * - [重要] 現行アプリ確定後、非アクティブ面を otaTask の空き時間に低優先度で事前消去する。
+ *   OTA 書込みは消去済み範囲の消去を省略し、ダウンロード時間を通信速度だけで決まるようにする。
  * - [将来対応] 同一進捗率ごとの細粒度リトライ制御は別途拡張する。
  */
 
 #include "ota.h"
 
-#include <Update.h>
 #include <WiFi.h>
 #include <WiFiClient.h>
-#include <WiFiClientSecure.h>
 #include <time.h>
-#include <esp_heap_caps.h>
-#include <mbedtls/sha256.h>
+#include <esp_image_format.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 #include "firmwareInfo.h"
 #include "interTaskMessage.h"
 #include "log.h"
+#include "mirrorDownload.h"
 #include "sensitiveData.h"
 #include "sensitiveDataService.h"
+#include "taskPlacement.h"
 #include "util.h"
 
+#ifndef OTA_PRE_ERASE_ENABLE
+#define OTA_PRE_ERASE_ENABLE 1
+#endif
+
 namespace {
 StackType_t* otaTaskStackBuffer = nullptr;
 StaticTask_t otaTaskControlBlock;
 otaStartRequestContext pendingOtaStartRequest{};
 bool hasPendingOtaStartRequest = false;
+/** @brief OTA 更新の実行中フラグ（他タスクから isOtaInProgress で参照）。@type std::atomic<bool> */
+std::atomic<bool> isOtaRunning{false};
 sensitiveDataService otaSensitiveDataService;
 bool otaSensitiveDataInitialized = false;
 String otaTlsCaCertRuntime;
+/** @brief SENSITIVE_OTA_FALLBACK_IP を適用するホスト名（firmwareUrl のホスト。ミラーのホストには適用しない）。 */
+String otaFallbackResolveHost;
 
 constexpr uint32_t kOtaProgressHoldMs = 0;
 constexpr uint32_t kOtaAttemptMaxCount = 3;
 constexpr uint32_t kOtaRetryDelayMs = 5000;
 constexpr uint32_t kOtaDonePublishWaitMs = 2000;
 constexpr uint32_t kOtaTerminalPublishAckTimeoutMs = 3500;
-constexpr size_t kDownloadBufferSize = 4096;
 constexpr uint16_t kDefaultHttpPort = 80;
 constexpr uint16_t kDefaultHttpsPort = 443;
 constexpr int32_t kOtaProgressPublishStepPercent = 5;
+/** @brief フラッシュ消去単位（セクタ）。@type size_t */
+constexpr size_t kOtaFlashSectorSize = 4096;
+/** @brief 事前消去1ステップで消去するセクタ数。@type uint32_t */
+constexpr uint32_t kOtaPreEraseSectorsPerStep = 1;
+/**
+ * @brief 事前消去ステップ間の待機(ms)。
+ * @details
+ * - [重要] セクタ消去中は両コアのキャッシュが止まるため、1 セクタごとに必ず待機して他タスクへ CPU を返す。
+ */
+constexpr uint32_t kOtaPreEraseYieldMs = 20;
+/** @brief フラッシュ暗号化時の書込み単位。@type size_t */
+constexpr size_t kOtaWriteAlignment = 16;
+
+/**
+ * @brief 非アクティブ面の事前消去状態。
+ */
+enum class otaPreEraseState : uint8_t {
+  /** 未要求、または OTA が消去済み範囲を引き取った後。 */
+  kIdle = 0,
+  /** 要求済み。otaTask の空き時間に 1 セクタずつ消去を進める。 */
+  kErasing,
+  /** 面全体が消去済み。OTA は消去を省略できる。 */
+  kReady,
+};
+
+/**
+ * @brief 事前消去の進捗。
+ */
+struct otaPreEraseContext {
+  /** @brief 状態。@type otaPreEraseState */
+  otaPreEraseState state;
+  /** @brief 消去対象（次回 OTA 書込み先）。@type const esp_partition_t* */
+  const esp_partition_t* partition;
+  /** @brief 先頭から消去済みのバイト数（セクタ境界）。@type size_t */
+  size_t erasedBytes;
+  /** @brief 消去開始時刻(ms)。@type uint32_t */
+  uint32_t startedAtMs;
+};
+
+/**
+ * @brief OTA イメージ書込み状態。
+ * @details
+ * - [重要] erasedBytes より先へ書く直前にだけセクタ消去する。事前消去済みなら消去は発生しない。
+ * - [厳守] フラッシュ暗号化有効時は 16 byte 境界でしか書けないため、端数は pendingBytes に保持する。
+ */
+struct otaImageWriter {
+  /** @brief 書込み先。@type const esp_partition_t* */
+  const esp_partition_t* partition;
+  /** @brief フラッシュへ書込み済みのバイト数。@type size_t */
+  size_t writtenBytes;
+  /** @brief 先頭から消去済みのバイト数。@type size_t */
+  size_t erasedBytes;
+  /** @brief 事前消去から引き継いだバイト数（ログ用）。@type size_t */
+  size_t preErasedBytes;
+  /** @brief 16 byte 未満の端数。@type uint8_t[] */
+  uint8_t pendingBytes[kOtaWriteAlignment];
+  /** @brief 端数の長さ。@type size_t */
+  size_t pendingLength;
+};
+
+/** @brief 非アクティブ面の事前消去状態。 */
+otaPreEraseContext otaPreErase{otaPreEraseState::kIdle, nullptr, 0, 0};
 
 struct otaUrlInfo {
   String scheme;
@@ -125,49 +203,6 @@ bool resolveOtaTlsCaCertificate(String* tlsCaCertOut) {
 #endif
 }
 
-/**
- * @brief OTA向けTLSクライアント。
- * @details
- * - [重要] IP直指定で接続する場合でも、証明書検証は本来のホスト名で実施する。
- * - [禁止] OTAだけ `setInsecure()` で暫定運用しない。
- */
-class OtaTlsClient : public WiFiClientSecure {
- public:
-  /**
-   * @brief IP接続時に使うTLS検証コンテキストを設定する。
-   * @param tlsHostName 証明書検証に使うホスト名。
-   * @param tlsCaCertificate ルートCA証明書PEM。
-   */
-  void setTlsValidationContext(const char* tlsHostName, const char* tlsCaCertificate) {
-    tlsHostName_ = tlsHostName;
-    tlsCaCertificate_ = tlsCaCertificate;
-  }
-
-  /**
-   * @brief IPアドレス指定でTLS接続する。
-   * @param ip 接続先IPアドレス。
-   * @param port 接続先ポート。
-   * @return 接続成功時1、失敗時0。
-   */
-  int connect(IPAddress ip, uint16_t port) override {
-    bool hostAvailable = (tlsHostName_ != nullptr && strlen(tlsHostName_) > 0);
-    bool caAvailable = (tlsCaCertificate_ != nullptr && strlen(tlsCaCertificate_) > 0);
-    if (!hostAvailable || !caAvailable) {
-      appLogWarn("OtaTlsClient::connect used default verification path. ip=%s port=%u hostAvailable=%d caAvailable=%d",
-                 ip.toString().c_str(),
-                 static_cast<unsigned>(port),
-                 hostAvailable ? 1 : 0,
-                 caAvailable ? 1 : 0);
-      return WiFiClientSecure::connect(ip, port);
-    }
-    return WiFiClientSecure::connect(ip, port, tlsHostName_, tlsCaCertificate_, nullptr, nullptr);
-  }
-
- private:
-  const char* tlsHostName_ = nullptr;
-  const char* tlsCaCertificate_ = nullptr;
-};
-
 String buildOtaDetailText(const char* detailPrefix, int32_t attemptNumber) {
   String detailText = detailPrefix == nullptr ? "" : String(detailPrefix);
   if (attemptNumber > 0) {
@@ -232,59 +267,49 @@ bool shouldPublishWriteProgress(int32_t progressPercent, int32_t lastPublishedPr
 }
 
 /**
- * @brief MQTTタスクからOTA終端通知のpublish完了ACKを待機する。
+ * @brief OTA終端通知のpublish完了を待機する。
  * @details
  * - [重要] `done/error` は「キュー投入成功」ではなく「MQTT publish実行結果」を確認する。
- * - [制限] ACK待機中に他メッセージを受信した場合はログを残して無視する。
- * @param expectedProgressPercent 期待する進捗率。
- * @param expectedPhase 期待するフェーズ。
- * @return ACK成功時true、失敗/タイムアウト時false。
+ * - [重要] 完了通知トークンで待つため、otaTask のQueueは読まない（待機中の他メッセージを捨てない）。
+ *   mqttTask が publish を終えた時点で即座に起床する。
+ * @param completionToken 要求メッセージに載せたトークン（本関数で返却される）。
+ * @param progressPercent 進捗率（ログ用）。
+ * @param phase フェーズ（ログ用）。
+ * @return publish成功時true、失敗/タイムアウト時false。
  */
-bool waitForTerminalPublishAck(int32_t expectedProgressPercent, const String& expectedPhase) {
-  interTaskMessageService& messageService = getInterTaskMessageService();
+bool awaitTerminalPublishCompletion(const appCompletionToken& completionToken,
+                                    int32_t progressPercent,
+                                    const String& phase) {
   const uint32_t waitStartMs = millis();
-  while ((millis() - waitStartMs) < kOtaTerminalPublishAckTimeoutMs) {
-    appTaskMessage receivedMessage{};
-    bool receiveResult = messageService.receiveMessage(appTaskId::kOta, &receivedMessage, pdMS_TO_TICKS(100));
-    if (!receiveResult) {
-      continue;
-    }
-    if (receivedMessage.messageType != appMessageType::kMqttPublishOtaProgressDone) {
-      appLogWarn("waitForTerminalPublishAck skipped unexpected message. messageType=%d sourceTask=%d",
-                 static_cast<int>(receivedMessage.messageType),
-                 static_cast<int>(receivedMessage.sourceTaskId));
-      continue;
-    }
-    String ackPhase = String(receivedMessage.text);
-    ackPhase.trim();
-    if (!ackPhase.equalsIgnoreCase(expectedPhase) || receivedMessage.intValue2 != expectedProgressPercent) {
-      appLogWarn("waitForTerminalPublishAck got mismatched ack. expectedPhase=%s expectedProgress=%ld ackPhase=%s ackProgress=%ld",
-                 expectedPhase.c_str(),
-                 static_cast<long>(expectedProgressPercent),
-                 ackPhase.c_str(),
-                 static_cast<long>(receivedMessage.intValue2));
-      continue;
-    }
-
-    const bool publishResult = (receivedMessage.intValue == 1);
-    if (!publishResult) {
-      appLogError("waitForTerminalPublishAck failed. phase=%s progress=%ld detail=%s",
-                  ackPhase.c_str(),
-                  static_cast<long>(receivedMessage.intValue2),
-                  receivedMessage.text2);
+  const appCompletionResult completionResult =
+      getInterTaskMessageService().awaitCompletion(completionToken, pdMS_TO_TICKS(kOtaTerminalPublishAckTimeoutMs));
+  const unsigned long waitedMs = static_cast<unsigned long>(millis() - waitStartMs);
+  switch (completionResult) {
+    case appCompletionResult::kSucceeded:
+      appLogInfo("awaitTerminalPublishCompletion success. phase=%s progress=%ld waitedMs=%lu",
+                 phase.c_str(),
+                 static_cast<long>(progressPercent),
+                 waitedMs);
+      return true;
+    case appCompletionResult::kFailed:
+      appLogError("awaitTerminalPublishCompletion failed. mqtt publish failed. phase=%s progress=%ld waitedMs=%lu",
+                  phase.c_str(),
+                  static_cast<long>(progressPercent),
+                  waitedMs);
+      return false;
+    case appCompletionResult::kTimeout:
+      appLogError("awaitTerminalPublishCompletion timeout. phase=%s progress=%ld timeoutMs=%lu",
+                  phase.c_str(),
+                  static_cast<long>(progressPercent),
+                  static_cast<unsigned long>(kOtaTerminalPublishAckTimeoutMs));
+      return false;
+    case appCompletionResult::kInvalidToken:
+    default:
+      appLogError("awaitTerminalPublishCompletion failed. invalid token. phase=%s progress=%ld",
+                  phase.c_str(),
+                  static_cast<long>(progressPercent));
       return false;
-    }
-    appLogInfo("waitForTerminalPublishAck success. phase=%s progress=%ld",
-               ackPhase.c_str(),
-               static_cast<long>(receivedMessage.intValue2));
-    return true;
   }
-
-  appLogError("waitForTerminalPublishAck timeout. expectedPhase=%s expectedProgress=%ld timeoutMs=%lu",
-              expectedPhase.c_str(),
-              static_cast<long>(expectedProgressPercent),
-              static_cast<unsigned long>(kOtaTerminalPublishAckTimeoutMs));
-  return false;
 }
 
 bool publishOtaProgress(int32_t progressPercent,
@@ -294,6 +319,7 @@ bool publishOtaProgress(int32_t progressPercent,
   const bool isTerminalPhase = phase.equalsIgnoreCase("done") || phase.equalsIgnoreCase("error");
   const uint32_t sendTimeoutMs = isTerminalPhase ? 1500 : 500;
   const int32_t sendRetryCount = isTerminalPhase ? 5 : 3;
+  interTaskMessageService& messageService = getInterTaskMessageService();
   for (int32_t retryIndex = 0; retryIndex < sendRetryCount; ++retryIndex) {
     appUtil::appTaskMessageDetail progressDetail = appUtil::createEmptyMessageDetail();
     progressDetail.hasIntValue = true;
@@ -301,13 +327,25 @@ bool publishOtaProgress(int32_t progressPercent,
     progressDetail.text = phase.c_str();
     progressDetail.text2 = detail.c_str();
     progressDetail.text3 = firmwareVersion.c_str();
+    // [重要] 途中経過は送りっぱなし、終端(done/error)だけ完了通知トークンを付けて publish 結果を待つ。
+    appCompletionToken completionToken{0, 0};
+    if (isTerminalPhase) {
+      if (!messageService.acquireCompletion(&completionToken)) {
+        appLogError("publishOtaProgress failed. acquireCompletion failed. phase=%s progress=%ld",
+                    phase.c_str(),
+                    static_cast<long>(progressPercent));
+        return false;
+      }
+      progressDetail.hasCompletionToken = true;
+      progressDetail.completionToken = completionToken;
+    }
     if (appUtil::sendMessage(appTaskId::kMqtt,
                              appTaskId::kOta,
                              appMessageType::kMqttPublishOtaProgressRequest,
                              &progressDetail,
                              sendTimeoutMs)) {
       if (isTerminalPhase) {
-        const bool ackResult = waitForTerminalPublishAck(progressPercent, phase);
+        const bool ackResult = awaitTerminalPublishCompletion(completionToken, progressPercent, phase);
         if (!ackResult) {
           appLogWarn("publishOtaProgress terminal ack wait failed. phase=%s progress=%ld retry=%ld/%ld",
                      phase.c_str(),
@@ -319,6 +357,9 @@ bool publishOtaProgress(int32_t progressPercent,
       }
       return true;
     }
+    if (isTerminalPhase) {
+      messageService.cancelCompletion(completionToken);
+    }
     if (retryIndex + 1 < sendRetryCount) {
       appLogWarn("publishOtaProgress retry. phase=%s progress=%ld retry=%ld/%ld",
                  phase.c_str(),
@@ -343,17 +384,6 @@ void updateOtaDisplay(const String& line1, const String& line2) {
              static_cast<unsigned long>(kOtaProgressHoldMs));
 }
 
-String convertSha256ToHex(const unsigned char hashBytes[32]) {
-  static constexpr char hexChars[] = "0123456789abcdef";
-  char hashText[65];
-  for (size_t index = 0; index < 32; ++index) {
-    hashText[index * 2] = hexChars[(hashBytes[index] >> 4) & 0x0F];
-    hashText[index * 2 + 1] = hexChars[hashBytes[index] & 0x0F];
-  }
-  hashText[64] = '\0';
-  return String(hashText);
-}
-
 bool parseOtaUrl(const String& urlText, otaUrlInfo* urlInfoOut) {
   if (urlInfoOut == nullptr) {
     appLogError("parseOtaUrl failed. urlInfoOut is null.");
@@ -478,68 +508,289 @@ bool logOtaConnectionDiagnostics(const String& firmwareUrl, otaUrlInfo* urlInfoO
   return true;
 }
 
-bool writeHttpGetRequest(WiFiClient* client, const otaUrlInfo& urlInfo) {
-  if (client == nullptr) {
-    appLogError("writeHttpGetRequest failed. client is null.");
+/**
+ * @brief ミラー取得で使うホスト名解決。
+ * @details
+ * - [重要] SENSITIVE_OTA_FALLBACK_IP は firmwareUrl のホストにだけ適用する。ミラー（LocalServer / クラウド）の
+ *   ホストまで同じ IP へ向けると、候補を並べた意味がなくなるため。
+ */
+bool resolveOtaMirrorHost(const char* host, IPAddress* ipOut) {
+  if (host == nullptr || ipOut == nullptr) {
+    appLogError("resolveOtaMirrorHost failed. host=%p ipOut=%p", host, ipOut);
     return false;
   }
-  const String requestText =
-      String("GET ") + urlInfo.path + " HTTP/1.1\r\n" +
-      "Host: " + urlInfo.host + "\r\n" +
-      "User-Agent: esp32lab-ota/1.0\r\n" +
-      "Connection: close\r\n\r\n";
-  const size_t writtenSize = client->print(requestText);
-  if (writtenSize != requestText.length()) {
-    appLogError("writeHttpGetRequest failed. writtenSize=%u expected=%u host=%s path=%s",
-                static_cast<unsigned>(writtenSize),
-                static_cast<unsigned>(requestText.length()),
-                urlInfo.host.c_str(),
-                urlInfo.path.c_str());
+  if (otaFallbackResolveHost.length() > 0 && otaFallbackResolveHost.equalsIgnoreCase(host)) {
+    otaUrlInfo urlInfo;
+    urlInfo.host = host;
+    urlInfo.port = kDefaultHttpsPort;
+    bool dnsResolved = false;
+    bool fallbackUsed = false;
+    return resolveOtaTargetIp(urlInfo, ipOut, &dnsResolved, &fallbackUsed);
+  }
+  if (WiFi.hostByName(host, *ipOut) != 1) {
+    appLogError("resolveOtaMirrorHost failed. host=%s", host);
     return false;
   }
   return true;
 }
 
-bool readHttpResponseHeader(WiFiClient* client, int* statusCodeOut, int32_t* contentLengthOut, String* errorDetailOut) {
-  if (client == nullptr || statusCodeOut == nullptr || contentLengthOut == nullptr || errorDetailOut == nullptr) {
-    appLogError("readHttpResponseHeader failed. invalid parameter.");
+/**
+ * @brief otaTask の優先度を切り替える。
+ * @param isLowPriority true で事前消去用の最低優先度、false で配置表の優先度へ戻す。
+ */
+void setOtaTaskLowPriority(bool isLowPriority) {
+  const UBaseType_t placedPriority = taskPlacement::getPlacement(taskPlacement::placedTaskId::kOta).priority;
+  vTaskPrioritySet(nullptr, isLowPriority ? tskIDLE_PRIORITY : placedPriority);
+}
+
+/**
+ * @brief 非アクティブ面の事前消去を開始する。
+ * @return 開始した、または既に消去中/消去済みの場合true。
+ * @details
+ * - [重要] 現行アプリ確定（otaRollback::confirmCurrentAppIfNeeded）後にだけ要求される。
+ *   確定前に消すと、新アプリ異常時の rollback 先を失うため。
+ */
+bool startOtaPreErase() {
+#if OTA_PRE_ERASE_ENABLE
+  const esp_partition_t* nextPartition = esp_ota_get_next_update_partition(nullptr);
+  if (nextPartition == nullptr) {
+    appLogError("startOtaPreErase failed. esp_ota_get_next_update_partition returned null.");
     return false;
   }
+  if (otaPreErase.state != otaPreEraseState::kIdle && otaPreErase.partition == nextPartition) {
+    return true;
+  }
+  otaPreErase.state = otaPreEraseState::kErasing;
+  otaPreErase.partition = nextPartition;
+  otaPreErase.erasedBytes = 0;
+  otaPreErase.startedAtMs = millis();
+  setOtaTaskLowPriority(true);
+  appLogInfo("startOtaPreErase: started. label=%s sizeBytes=%lu",
+             nextPartition->label,
+             static_cast<unsigned long>(nextPartition->size));
+  return true;
+#else
+  appLogInfo("startOtaPreErase skipped. OTA_PRE_ERASE_ENABLE=0");
+  return false;
+#endif
+}
 
-  *statusCodeOut = -1;
-  *contentLengthOut = -1;
-  *errorDetailOut = "";
+/**
+ * @brief 事前消去を1ステップ（kOtaPreEraseSectorsPerStep セクタ）進める。
+ */
+void stepOtaPreErase() {
+  if (otaPreErase.state != otaPreEraseState::kErasing || otaPreErase.partition == nullptr) {
+    return;
+  }
+  const size_t partitionSize = otaPreErase.partition->size;
+  for (uint32_t sectorIndex = 0; sectorIndex < kOtaPreEraseSectorsPerStep; ++sectorIndex) {
+    if (otaPreErase.erasedBytes >= partitionSize) {
+      break;
+    }
+    const esp_err_t eraseResult =
+        esp_partition_erase_range(otaPreErase.partition, otaPreErase.erasedBytes, kOtaFlashSectorSize);
+    if (eraseResult != ESP_OK) {
+      appLogError("stepOtaPreErase failed. offset=%lu err=%s",
+                  static_cast<unsigned long>(otaPreErase.erasedBytes),
+                  esp_err_to_name(eraseResult));
+      otaPreErase.state = otaPreEraseState::kIdle;
+      setOtaTaskLowPriority(false);
+      return;
+    }
+    otaPreErase.erasedBytes += kOtaFlashSectorSize;
+  }
+  if (otaPreErase.erasedBytes >= partitionSize) {
+    otaPreErase.state = otaPreEraseState::kReady;
+    setOtaTaskLowPriority(false);
+    appLogInfo("stepOtaPreErase: partition erased and ready. label=%s elapsedMs=%lu",
+               otaPreErase.partition->label,
+               static_cast<unsigned long>(millis() - otaPreErase.startedAtMs));
+  }
+}
 
-  String statusLine = client->readStringUntil('\n');
-  statusLine.trim();
-  if (!statusLine.startsWith("HTTP/1.")) {
-    *errorDetailOut = "invalid status line";
-    appLogError("readHttpResponseHeader failed. invalid status line. statusLine=%s", statusLine.c_str());
+/**
+ * @brief 事前消去済み範囲を OTA 書込みへ引き渡す。
+ * @param partition 書込み先。
+ * @return 先頭から消去済みのバイト数。対象外なら0。
+ * @details
+ * - [重要] 引き渡し後は書込みで内容が変わるため、事前消去状態は kIdle に戻す。消去途中でも途中までを引き継ぐ。
+ */
+size_t takeOtaPreErasedBytes(const esp_partition_t* partition) {
+  if (otaPreErase.state == otaPreEraseState::kIdle) {
+    return 0;
+  }
+  const bool isSamePartition = (otaPreErase.partition == partition);
+  const size_t preErasedBytes = isSamePartition ? otaPreErase.erasedBytes : 0;
+  if (otaPreErase.state == otaPreEraseState::kErasing) {
+    setOtaTaskLowPriority(false);
+  }
+  otaPreErase.state = otaPreEraseState::kIdle;
+  otaPreErase.erasedBytes = 0;
+  return preErasedBytes;
+}
+
+/**
+ * @brief 消去済み範囲を endOffset まで広げる。
+ * @param writer 書込み状態。
+ * @param endOffset 書込み終端オフセット。
+ * @return 成功時true。
+ */
+bool ensureOtaImageErased(otaImageWriter* writer, size_t endOffset) {
+  while (writer->erasedBytes < endOffset) {
+    const esp_err_t eraseResult =
+        esp_partition_erase_range(writer->partition, writer->erasedBytes, kOtaFlashSectorSize);
+    if (eraseResult != ESP_OK) {
+      appLogError("ensureOtaImageErased failed. offset=%lu err=%s",
+                  static_cast<unsigned long>(writer->erasedBytes),
+                  esp_err_to_name(eraseResult));
+      return false;
+    }
+    writer->erasedBytes += kOtaFlashSectorSize;
+  }
+  return true;
+}
+
+/**
+ * @brief 16 byte 境界のデータをフラッシュへ書き込む。
+ * @param writer 書込み状態。
+ * @param data 書込みデータ。
+ * @param length 長さ（kOtaWriteAlignment の倍数）。
+ * @return 成功時true。
+ */
+bool writeAlignedOtaImage(otaImageWriter* writer, const uint8_t* data, size_t length) {
+  if (length == 0) {
+    return true;
+  }
+  if (writer->writtenBytes + length > writer->partition->size) {
+    appLogError("writeAlignedOtaImage failed. image exceeds partition. offset=%lu length=%lu partitionSize=%lu",
+                static_cast<unsigned long>(writer->writtenBytes),
+                static_cast<unsigned long>(length),
+                static_cast<unsigned long>(writer->partition->size));
+    return false;
+  }
+  if (!ensureOtaImageErased(writer, writer->writtenBytes + length)) {
     return false;
   }
+  const esp_err_t writeResult = esp_partition_write(writer->partition, writer->writtenBytes, data, length);
+  if (writeResult != ESP_OK) {
+    appLogError("writeAlignedOtaImage failed. offset=%lu length=%lu err=%s",
+                static_cast<unsigned long>(writer->writtenBytes),
+                static_cast<unsigned long>(length),
+                esp_err_to_name(writeResult));
+    return false;
+  }
+  writer->writtenBytes += length;
+  return true;
+}
 
-  const int firstSpaceIndex = statusLine.indexOf(' ');
-  const int secondSpaceIndex = statusLine.indexOf(' ', firstSpaceIndex + 1);
-  if (firstSpaceIndex < 0 || secondSpaceIndex < 0) {
-    *errorDetailOut = "status parse failed";
-    appLogError("readHttpResponseHeader failed. could not parse status line. statusLine=%s", statusLine.c_str());
+/**
+ * @brief OTA イメージ書込みを開始する。
+ * @param contentLength 受信予定サイズ（不明時は負値）。
+ * @param writerOut 書込み状態の出力先。
+ * @return 成功時true。
+ */
+bool beginOtaImageWrite(int32_t contentLength, otaImageWriter* writerOut) {
+  if (writerOut == nullptr) {
+    appLogError("beginOtaImageWrite failed. writerOut is null.");
     return false;
   }
-  *statusCodeOut = statusLine.substring(firstSpaceIndex + 1, secondSpaceIndex).toInt();
+  const esp_partition_t* nextPartition = esp_ota_get_next_update_partition(nullptr);
+  if (nextPartition == nullptr) {
+    appLogError("beginOtaImageWrite failed. esp_ota_get_next_update_partition returned null.");
+    return false;
+  }
+  if (contentLength > 0 && static_cast<size_t>(contentLength) > nextPartition->size) {
+    appLogError("beginOtaImageWrite failed. contentLength=%ld exceeds partitionSize=%lu",
+                static_cast<long>(contentLength),
+                static_cast<unsigned long>(nextPartition->size));
+    return false;
+  }
+  *writerOut = otaImageWriter{};
+  writerOut->partition = nextPartition;
+  writerOut->preErasedBytes = takeOtaPreErasedBytes(nextPartition);
+  writerOut->erasedBytes = writerOut->preErasedBytes;
+  appLogInfo("beginOtaImageWrite: label=%s contentLength=%ld preErasedBytes=%lu",
+             nextPartition->label,
+             static_cast<long>(contentLength),
+             static_cast<unsigned long>(writerOut->preErasedBytes));
+  return true;
+}
 
-  for (;;) {
-    String headerLine = client->readStringUntil('\n');
-    if (headerLine.length() == 0) {
-      continue;
+/**
+ * @brief OTA イメージの受信データを書き込む。
+ * @param writer 書込み状態。
+ * @param data 受信データ。
+ * @param length 長さ。
+ * @return 成功時true。
+ */
+bool writeOtaImage(otaImageWriter* writer, const uint8_t* data, size_t length) {
+  if (writer == nullptr || writer->partition == nullptr || data == nullptr) {
+    appLogError("writeOtaImage failed. writer=%p data=%p", writer, data);
+    return false;
+  }
+  if (writer->writtenBytes == 0 && writer->pendingLength == 0 && length > 0 && data[0] != ESP_IMAGE_HEADER_MAGIC) {
+    appLogError("writeOtaImage failed. invalid image magic=0x%02X", static_cast<unsigned>(data[0]));
+    return false;
+  }
+  size_t consumedLength = 0;
+  if (writer->pendingLength > 0) {
+    const size_t fillLength = min(kOtaWriteAlignment - writer->pendingLength, length);
+    memcpy(writer->pendingBytes + writer->pendingLength, data, fillLength);
+    writer->pendingLength += fillLength;
+    consumedLength += fillLength;
+    if (writer->pendingLength < kOtaWriteAlignment) {
+      return true;
     }
-    headerLine.trim();
-    if (headerLine.length() == 0) {
-      break;
+    if (!writeAlignedOtaImage(writer, writer->pendingBytes, kOtaWriteAlignment)) {
+      return false;
     }
-    if (headerLine.startsWith("Content-Length:")) {
-      *contentLengthOut = headerLine.substring(strlen("Content-Length:")).toInt();
+    writer->pendingLength = 0;
+  }
+  const size_t remainingLength = length - consumedLength;
+  const size_t alignedLength = remainingLength - (remainingLength % kOtaWriteAlignment);
+  if (!writeAlignedOtaImage(writer, data + consumedLength, alignedLength)) {
+    return false;
+  }
+  consumedLength += alignedLength;
+  writer->pendingLength = length - consumedLength;
+  memcpy(writer->pendingBytes, data + consumedLength, writer->pendingLength);
+  return true;
+}
+
+/**
+ * @brief OTA イメージ書込みを完了し、検証後に次回起動面へ設定する。
+ * @param writer 書込み状態。
+ * @param errorDetailOut 失敗理由の出力先。
+ * @return 成功時true。
+ * @details
+ * - [重要] esp_ota_set_boot_partition() がイメージ検証（ヘッダー/ハッシュ、Secure Boot 有効時は署名）を行う。
+ */
+bool finishOtaImageWrite(otaImageWriter* writer, String* errorDetailOut) {
+  if (writer == nullptr || writer->partition == nullptr || errorDetailOut == nullptr) {
+    appLogError("finishOtaImageWrite failed. writer=%p errorDetailOut=%p", writer, errorDetailOut);
+    return false;
+  }
+  if (writer->pendingLength > 0) {
+    memset(writer->pendingBytes + writer->pendingLength, 0xFF, kOtaWriteAlignment - writer->pendingLength);
+    if (!writeAlignedOtaImage(writer, writer->pendingBytes, kOtaWriteAlignment)) {
+      *errorDetailOut = "ota write failed";
+      return false;
     }
+    writer->pendingLength = 0;
   }
+  const esp_err_t setBootResult = esp_ota_set_boot_partition(writer->partition);
+  if (setBootResult != ESP_OK) {
+    *errorDetailOut = String("ota set boot failed: ") + esp_err_to_name(setBootResult);
+    appLogError("finishOtaImageWrite failed. esp_ota_set_boot_partition err=%s label=%s writtenBytes=%lu",
+                esp_err_to_name(setBootResult),
+                writer->partition->label,
+                static_cast<unsigned long>(writer->writtenBytes));
+    return false;
+  }
+  appLogInfo("finishOtaImageWrite: boot partition set. label=%s writtenBytes=%lu eraseSkippedBytes=%lu",
+             writer->partition->label,
+             static_cast<unsigned long>(writer->writtenBytes),
+             static_cast<unsigned long>(min(writer->preErasedBytes, writer->writtenBytes)));
   return true;
 }
 
@@ -553,11 +804,99 @@ bool takePendingOtaStartRequest(otaStartRequestContext* requestContextOut) {
   return true;
 }
 
+/**
+ * @brief ミラー取得の出力先（OTA 面への書込み）の状態。
+ */
+struct otaMirrorSinkContext {
+  /** @brief 書込み状態。@type otaImageWriter */
+  otaImageWriter writer;
+  /** @brief 書込みを開始したか（最初のデータで全体サイズが分かった時点で開始する）。@type bool */
+  bool isWriterStarted;
+  /** @brief 前回publishした進捗率。@type int32_t */
+  int32_t lastPublishedPercent;
+  /** @brief 試行番号。@type int32_t */
+  int32_t attemptNumber;
+  /** @brief 更新先の版数。@type const String* */
+  const String* firmwareVersion;
+  /** @brief 書込み失敗時の理由（成功中は null）。@type const char* */
+  const char* failureDetail;
+};
+
+/**
+ * @brief ミラー取得の受信データを OTA 面へ書き込み、進捗を通知する。
+ * @return 継続する場合true。
+ */
+bool writeOtaMirrorData(void* sinkContext, const uint8_t* data, size_t length, uint32_t offset, uint32_t totalBytes) {
+  otaMirrorSinkContext* context = static_cast<otaMirrorSinkContext*>(sinkContext);
+  if (!context->isWriterStarted) {
+    if (!beginOtaImageWrite(static_cast<int32_t>(totalBytes), &context->writer)) {
+      context->failureDetail = "ota begin failed";
+      return false;
+    }
+    context->isWriterStarted = true;
+  }
+  if (!writeOtaImage(&context->writer, data, length)) {
+    context->failureDetail = "ota write failed";
+    appLogError("writeOtaMirrorData failed. writeOtaImage failed. length=%u offset=%lu",
+                static_cast<unsigned>(length),
+                static_cast<unsigned long>(offset));
+    return false;
+  }
+  const int32_t progressPercent =
+      static_cast<int32_t>((static_cast<int64_t>(offset) + static_cast<int64_t>(length)) * 100 / totalBytes);
+  if (shouldPublishWriteProgress(progressPercent, context->lastPublishedPercent)) {
+    context->lastPublishedPercent = progressPercent;
+    publishOtaProgress(progressPercent,
+                       "write",
+                       buildOtaDetailText("downloading", context->attemptNumber),
+                       *context->firmwareVersion);
+    updateOtaDisplay(String("OTA ") + progressPercent + "%", *context->firmwareVersion);
+  }
+  return true;
+}
+
+/**
+ * @brief 取得候補の URL 列を作る。
+ * @param suspectUrls SHA256 不一致の試行で使った URL（候補から外す）。
+ * @param urlsOut 優先順の URL 列の出力先。
+ * @details
+ * - [重要] mirrorUrls（優先順）→ firmwareUrl の順に並べ、空文字と重複を除く。
+ * - [重要] 外すと候補が無くなる場合は外さない（配信元の一時的な不整合でも再試行の余地を残す）。
+ */
+void buildOtaSourceUrls(const otaStartRequestContext& requestContext,
+                        const std::vector<String>& suspectUrls,
+                        std::vector<String>* urlsOut) {
+  std::vector<String> allUrls;
+  for (const String& mirrorUrl : requestContext.mirrorUrls) {
+    if (allUrls.size() + 1 >= kMirrorDownloadMaxSources) {
+      break;
+    }
+    if (mirrorUrl.length() > 0 && std::find(allUrls.begin(), allUrls.end(), mirrorUrl) == allUrls.end()) {
+      allUrls.push_back(mirrorUrl);
+    }
+  }
+  if (std::find(allUrls.begin(), allUrls.end(), requestContext.firmwareUrl) == allUrls.end()) {
+    allUrls.push_back(requestContext.firmwareUrl);
+  }
+  urlsOut->clear();
+  for (const String& url : allUrls) {
+    if (std::find(suspectUrls.begin(), suspectUrls.end(), url) == suspectUrls.end()) {
+      urlsOut->push_back(url);
+    }
+  }
+  if (urlsOut->empty()) {
+    appLogWarn("buildOtaSourceUrls: every source is suspected. retry all. sourceCount=%u",
+               static_cast<unsigned>(allUrls.size()));
+    *urlsOut = allUrls;
+  }
+}
+
 bool executeSingleOtaAttempt(const otaStartRequestContext& requestContext,
                              int32_t attemptNumber,
+                             std::vector<String>* suspectUrlsInOut,
                              String* errorDetailOut) {
-  if (errorDetailOut == nullptr) {
-    appLogError("executeSingleOtaAttempt failed. errorDetailOut is null.");
+  if (errorDetailOut == nullptr || suspectUrlsInOut == nullptr) {
+    appLogError("executeSingleOtaAttempt failed. errorDetailOut=%p suspectUrlsInOut=%p", errorDetailOut, suspectUrlsInOut);
     return false;
   }
   if (requestContext.firmwareUrl.length() == 0) {
@@ -565,177 +904,89 @@ bool executeSingleOtaAttempt(const otaStartRequestContext& requestContext,
     return false;
   }
 
+  std::vector<String> sourceUrls;
+  buildOtaSourceUrls(requestContext, *suspectUrlsInOut, &sourceUrls);
+
   otaUrlInfo urlInfo;
   IPAddress resolvedIpAddress;
   if (!logOtaConnectionDiagnostics(requestContext.firmwareUrl, &urlInfo, &resolvedIpAddress)) {
-    *errorDetailOut = "ota resolve failed";
-    return false;
-  }
-
-  WiFiClient plainClient;
-  OtaTlsClient secureClient;
-  const bool useTls = requestContext.firmwareUrl.startsWith("https://");
-  WiFiClient* activeClient = nullptr;
-  bool connectResult = false;
-
-  if (useTls) {
-    secureClient.setTimeout(15000);
-    if (!resolveOtaTlsCaCertificate(&otaTlsCaCertRuntime) || otaTlsCaCertRuntime.length() == 0) {
-      *errorDetailOut = "ota tls cert unavailable";
-      appLogError("executeSingleOtaAttempt failed. OTA TLS cert is unavailable. url=%s",
-                  requestContext.firmwareUrl.c_str());
+    if (sourceUrls.size() <= 1) {
+      *errorDetailOut = "ota resolve failed";
       return false;
     }
-    secureClient.setCACert(otaTlsCaCertRuntime.c_str());
-    secureClient.setTlsValidationContext(urlInfo.host.c_str(), otaTlsCaCertRuntime.c_str());
-    connectResult = secureClient.connect(resolvedIpAddress, urlInfo.port);
-    activeClient = &secureClient;
-  } else {
-    plainClient.setTimeout(15000);
-    connectResult = plainClient.connect(resolvedIpAddress, urlInfo.port);
-    activeClient = &plainClient;
+    appLogWarn("executeSingleOtaAttempt: firmwareUrl diagnostics failed. continue with mirrors. sourceCount=%u",
+               static_cast<unsigned>(sourceUrls.size()));
   }
+  otaUrlInfo firmwareUrlInfo;
+  otaFallbackResolveHost = parseOtaUrl(requestContext.firmwareUrl, &firmwareUrlInfo) ? firmwareUrlInfo.host : String("");
 
-  if (!connectResult || activeClient == nullptr) {
-    *errorDetailOut = "http connect failed";
-    appLogError("executeSingleOtaAttempt failed. connect failed. host=%s ip=%s port=%u useTls=%d",
-                urlInfo.host.c_str(),
-                resolvedIpAddress.toString().c_str(),
-                static_cast<unsigned>(urlInfo.port),
-                useTls ? 1 : 0);
-    return false;
+  bool hasTlsUrl = false;
+  for (const String& sourceUrl : sourceUrls) {
+    hasTlsUrl = hasTlsUrl || sourceUrl.startsWith("https://");
   }
-
-  if (!writeHttpGetRequest(activeClient, urlInfo)) {
-    *errorDetailOut = "http request failed";
-    activeClient->stop();
-    return false;
-  }
-
-  int httpStatusCode = -1;
-  int32_t contentLength = -1;
-  String headerErrorDetail;
-  if (!readHttpResponseHeader(activeClient, &httpStatusCode, &contentLength, &headerErrorDetail)) {
-    *errorDetailOut = headerErrorDetail.length() > 0 ? headerErrorDetail : "header read failed";
-    activeClient->stop();
-    return false;
-  }
-
-  if (httpStatusCode != 200) {
-    *errorDetailOut = "http status " + String(httpStatusCode);
-    appLogError("executeSingleOtaAttempt failed. GET status=%d url=%s",
-                httpStatusCode,
+  if (hasTlsUrl && (!resolveOtaTlsCaCertificate(&otaTlsCaCertRuntime) || otaTlsCaCertRuntime.length() == 0)) {
+    *errorDetailOut = "ota tls cert unavailable";
+    appLogError("executeSingleOtaAttempt failed. OTA TLS cert is unavailable. url=%s",
                 requestContext.firmwareUrl.c_str());
-    activeClient->stop();
     return false;
   }
 
-  if (!Update.begin(contentLength > 0 ? static_cast<size_t>(contentLength) : UPDATE_SIZE_UNKNOWN)) {
-    *errorDetailOut = "Update.begin failed";
-    appLogError("executeSingleOtaAttempt failed. Update.begin failed. contentLength=%d error=%s",
-                contentLength,
-                Update.errorString());
-    activeClient->stop();
-    return false;
-  }
+  mirrorDownloadOptions downloadOptions = mirrorDownload::getDefaultOptions();
+  downloadOptions.tlsCaCertificate = hasTlsUrl ? otaTlsCaCertRuntime.c_str() : nullptr;
+  downloadOptions.resolveHost = resolveOtaMirrorHost;
+  downloadOptions.userAgent = "esp32lab-ota/1.0";
 
-  uint8_t downloadBuffer[kDownloadBufferSize];
-  int32_t totalWrittenBytes = 0;
-  int32_t lastPublishedPercent = -1;
-  mbedtls_sha256_context sha256Context;
-  mbedtls_sha256_init(&sha256Context);
-  mbedtls_sha256_starts_ret(&sha256Context, 0);
+  otaMirrorSinkContext sinkContext{};
+  sinkContext.lastPublishedPercent = -1;
+  sinkContext.attemptNumber = attemptNumber;
+  sinkContext.firmwareVersion = &requestContext.firmwareVersion;
+  sinkContext.failureDetail = nullptr;
 
   publishOtaProgress(0, "prepare", buildOtaDetailText("download start", attemptNumber), requestContext.firmwareVersion);
   updateOtaDisplay("OTA START", String("TRY ") + attemptNumber);
 
-  while (activeClient->connected() || activeClient->available() > 0) {
-    const size_t availableBytes = activeClient->available();
-    if (availableBytes == 0) {
-      delay(20);
-      continue;
-    }
-
-    const size_t readSize = activeClient->readBytes(downloadBuffer, min(availableBytes, sizeof(downloadBuffer)));
-    if (readSize == 0) {
-      delay(20);
-      continue;
-    }
-
-    mbedtls_sha256_update_ret(&sha256Context, downloadBuffer, readSize);
-    const size_t writtenSize = Update.write(downloadBuffer, readSize);
-    if (writtenSize != readSize) {
-      *errorDetailOut = "Update.write failed";
-      appLogError("executeSingleOtaAttempt failed. Update.write mismatch. readSize=%u writtenSize=%u error=%s",
-                  static_cast<unsigned>(readSize),
-                  static_cast<unsigned>(writtenSize),
-                  Update.errorString());
-      mbedtls_sha256_free(&sha256Context);
-      Update.abort();
-      activeClient->stop();
-      return false;
-    }
-
-    totalWrittenBytes += static_cast<int32_t>(writtenSize);
-    if (contentLength > 0) {
-      const int32_t progressPercent =
-          static_cast<int32_t>((static_cast<int64_t>(totalWrittenBytes) * 100) / contentLength);
-      if (shouldPublishWriteProgress(progressPercent, lastPublishedPercent)) {
-        lastPublishedPercent = progressPercent;
-        publishOtaProgress(progressPercent,
-                           "write",
-                           buildOtaDetailText("downloading", attemptNumber),
-                           requestContext.firmwareVersion);
-        updateOtaDisplay(String("OTA ") + progressPercent + "%", requestContext.firmwareVersion);
+  mirrorDownloadResult downloadResult;
+  const bool downloadResultOk = mirrorDownload::run(sourceUrls.data(),
+                                                    sourceUrls.size(),
+                                                    downloadOptions,
+                                                    requestContext.firmwareSha256.c_str(),
+                                                    writeOtaMirrorData,
+                                                    &sinkContext,
+                                                    &downloadResult);
+  if (!downloadResultOk) {
+    *errorDetailOut = (sinkContext.failureDetail != nullptr) ? sinkContext.failureDetail : downloadResult.detail;
+    if (strlen(downloadResult.sha256Hex) > 0) {
+      // [重要] 全量を受け取ったうえでの不一致は配信元の内容不整合とみなし、使った URL を次の試行の候補から外す。
+      for (uint8_t sourceIndex = 0; sourceIndex < downloadResult.sourceCount; ++sourceIndex) {
+        if ((downloadResult.usedSourceMask & (1U << sourceIndex)) != 0) {
+          suspectUrlsInOut->push_back(sourceUrls[sourceIndex]);
+        }
       }
+      appLogError("executeSingleOtaAttempt failed. sha256 mismatch. expected=%s actual=%s usedMask=0x%02X",
+                  requestContext.firmwareSha256.c_str(),
+                  downloadResult.sha256Hex,
+                  static_cast<unsigned>(downloadResult.usedSourceMask));
+    } else {
+      appLogError("executeSingleOtaAttempt failed. download failed. detail=%s downloaded=%lu total=%lu switches=%u",
+                  errorDetailOut->c_str(),
+                  static_cast<unsigned long>(downloadResult.downloadedBytes),
+                  static_cast<unsigned long>(downloadResult.totalBytes),
+                  static_cast<unsigned>(downloadResult.switchCount));
     }
-  }
-
-  unsigned char hashBytes[32];
-  mbedtls_sha256_finish_ret(&sha256Context, hashBytes);
-  mbedtls_sha256_free(&sha256Context);
-
-  if (contentLength > 0 && totalWrittenBytes != contentLength) {
-    *errorDetailOut = "content length mismatch";
-    appLogError("executeSingleOtaAttempt failed. content length mismatch. expected=%ld actual=%ld url=%s",
-                static_cast<long>(contentLength),
-                static_cast<long>(totalWrittenBytes),
-                requestContext.firmwareUrl.c_str());
-    Update.abort();
-    activeClient->stop();
     return false;
   }
-
-  const String calculatedSha256 = convertSha256ToHex(hashBytes);
-  if (requestContext.firmwareSha256.length() > 0 &&
-      !calculatedSha256.equalsIgnoreCase(requestContext.firmwareSha256)) {
-    *errorDetailOut = "sha256 mismatch";
-    appLogError("executeSingleOtaAttempt failed. sha256 mismatch. expected=%s actual=%s url=%s",
-                requestContext.firmwareSha256.c_str(),
-                calculatedSha256.c_str(),
-                requestContext.firmwareUrl.c_str());
-    Update.abort();
-    activeClient->stop();
+  if (!sinkContext.isWriterStarted) {
+    *errorDetailOut = "ota begin failed";
     return false;
   }
 
   publishOtaProgress(95, "verify", "sha256 ok", requestContext.firmwareVersion);
   updateOtaDisplay("OTA VERIFY", "SHA256 OK");
 
-  if (!Update.end()) {
-    *errorDetailOut = String("Update.end failed: ") + Update.errorString();
-    appLogError("executeSingleOtaAttempt failed. Update.end failed. error=%s", Update.errorString());
-    activeClient->stop();
-    return false;
-  }
-  if (!Update.isFinished()) {
-    *errorDetailOut = "Update not finished";
-    appLogError("executeSingleOtaAttempt failed. Update is not finished.");
-    activeClient->stop();
+  if (!finishOtaImageWrite(&sinkContext.writer, errorDetailOut)) {
     return false;
   }
 
-  activeClient->stop();
   const String otaAppliedAt = getCurrentUtcIso8601Text();
   if (otaAppliedAt.length() > 0) {
     const bool saveResult = firmwareInfo::saveOtaAppliedAt(requestContext.firmwareVersion, otaAppliedAt);
@@ -759,10 +1010,13 @@ bool executeSingleOtaAttempt(const otaStartRequestContext& requestContext,
                static_cast<unsigned long>(kOtaDonePublishWaitMs));
   }
   vTaskDelay(pdMS_TO_TICKS(kOtaDonePublishWaitMs));
-  appLogInfo("executeSingleOtaAttempt success. version=%s url=%s sha256=%s",
+  appLogInfo("executeSingleOtaAttempt success. version=%s url=%s sha256=%s sources=%u switches=%u elapsedMs=%lu",
              requestContext.firmwareVersion.c_str(),
-             requestContext.firmwareUrl.c_str(),
-             calculatedSha256.c_str());
+             downloadResult.sources[downloadResult.finalSourceIndex].url.c_str(),
+             downloadResult.sha256Hex,
+             static_cast<unsigned>(downloadResult.sourceCount),
+             static_cast<unsigned>(downloadResult.switchCount),
+             static_cast<unsigned long>(downloadResult.elapsedMs));
   return true;
 }
 }
@@ -773,38 +1027,22 @@ bool storePendingOtaStartRequest(const otaStartRequestContext& requestContext) {
   return true;
 }
 
+bool isOtaInProgress() {
+  return isOtaRunning.load(std::memory_order_acquire);
+}
+
 bool otaTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kOta, 8);
 
-  if (otaTaskStackBuffer == nullptr) {
-    otaTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (otaTaskStackBuffer == nullptr) {
-    appLogWarn("otaTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    otaTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (otaTaskStackBuffer == nullptr) {
-    appLogError("otaTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kOta,
+                                             taskEntry,
+                                             this,
+                                             &otaTaskStackBuffer,
+                                             &otaTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "otaTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      otaTaskStackBuffer,
-      &otaTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("otaTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
-    return false;
-  }
-  appLogInfo("otaTask created.");
   return true;
 }
 
@@ -818,7 +1056,12 @@ void otaTask::runLoop() {
   appLogInfo("otaTask loop started.");
   for (;;) {
     appTaskMessage receivedMessage{};
-    bool receiveResult = messageService.receiveMessage(appTaskId::kOta, &receivedMessage, pdMS_TO_TICKS(50));
+    const bool isPreErasing = (otaPreErase.state == otaPreEraseState::kErasing);
+    bool receiveResult =
+        messageService.receiveMessage(appTaskId::kOta, &receivedMessage, pdMS_TO_TICKS(isPreErasing ? 0 : 50));
+    if (receiveResult && receivedMessage.messageType == appMessageType::kOtaPreEraseRequest) {
+      startOtaPreErase();
+    }
     if (receiveResult && receivedMessage.messageType == appMessageType::kStartupRequest) {
       appTaskMessage responseMessage{};
       responseMessage.sourceTaskId = appTaskId::kOta;
@@ -836,19 +1079,23 @@ void otaTask::runLoop() {
         vTaskDelay(pdMS_TO_TICKS(100));
         continue;
       }
+      isOtaRunning.store(true, std::memory_order_release);
 
       String lastErrorDetail;
       bool otaSuccess = false;
+      std::vector<String> suspectUrls;
       for (int32_t attemptNumber = 1; attemptNumber <= static_cast<int32_t>(kOtaAttemptMaxCount); ++attemptNumber) {
         publishOtaProgress(0,
                            "prepare",
                            buildOtaDetailText("accepted", attemptNumber),
                            requestContext.firmwareVersion);
-        appLogInfo("otaTask: start OTA attempt. attempt=%ld version=%s url=%s",
+        appLogInfo("otaTask: start OTA attempt. attempt=%ld version=%s url=%s mirrors=%u suspects=%u",
                    static_cast<long>(attemptNumber),
                    requestContext.firmwareVersion.c_str(),
-                   requestContext.firmwareUrl.c_str());
-        if (executeSingleOtaAttempt(requestContext, attemptNumber, &lastErrorDetail)) {
+                   requestContext.firmwareUrl.c_str(),
+                   static_cast<unsigned>(requestContext.mirrorUrls.size()),
+                   static_cast<unsigned>(suspectUrls.size()));
+        if (executeSingleOtaAttempt(requestContext, attemptNumber, &suspectUrls, &lastErrorDetail)) {
           otaSuccess = true;
           break;
         }
@@ -867,11 +1114,19 @@ void otaTask::runLoop() {
                     requestContext.firmwareVersion.c_str(),
                     requestContext.firmwareUrl.c_str(),
                     lastErrorDetail.c_str());
+        isOtaRunning.store(false, std::memory_order_release);
+        // [推奨] 途中まで書いた面を空き時間に消し直し、次回 OTA も消去待ちなしで始められるようにする。
+        startOtaPreErase();
       } else {
         vTaskDelay(pdMS_TO_TICKS(1500));
         ESP.restart();
       }
     }
+    if (otaPreErase.state == otaPreEraseState::kErasing) {
+      stepOtaPreErase();
+      vTaskDelay(pdMS_TO_TICKS(kOtaPreEraseYieldMs));
+      continue;
+    }
     vTaskDelay(pdMS_TO_TICKS(100));
   }
 }
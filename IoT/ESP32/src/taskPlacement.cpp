@@ -0,0 +1,357 @@
+/**
+ * @file taskPlacement.cpp
+ * @brief タスク配置表と、配置表に従う静的タスク生成・コア別負荷計測の実装。
+ * @details
+ * - [重要] 配置表 placementTable が全タスクの唯一の設定元である。各タスクのヘッダーへ値を戻さない。
+ * - [重要] コア別負荷は CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 有効時は IDLE タスクの実行時間から、
+ *   無効時（Arduino-ESP32 既定）は idle hook が動いた tick 数から算出する。
+ * - [制限] idle hook 方式は「1 tick 内で一度でも idle に入ったら idle tick」と数えるため、負荷を低めに見積もる。
+ *   配置変更前後の比較には使えるが、絶対値は参考値として扱う。
+ */
+
+#include "taskPlacement.h"
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include <esp_freertos_hooks.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#include "log.h"
+
+#if defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS) && defined(CONFIG_FREERTOS_USE_TRACE_FACILITY)
+#define TASK_PLACEMENT_USE_RUN_TIME_STATS 1
+#else
+#define TASK_PLACEMENT_USE_RUN_TIME_STATS 0
+#endif
+
+namespace taskPlacement {
+
+namespace {
+
+/**
+ * @brief タスク配置表。
+ * @details
+ * - [厳守] 並びは placedTaskId と一致させる。
+ * - [重要] 優先度は従来値を維持する（I2C=2、timeServer/fileLogWriter=0、他=1）。変更時は負荷計測で確認する。
+ * - mainTask:
+ *   - [重要] 初期化シーケンスとAPメンテナンスAPI処理が同一タスクで重なるため、15KBへ拡張して運用する。
+ *   - [変更][2026-03-24] 7041 dry-run precheck で measuredMinStackMarginBytes=3232 (閾値4096未満) が継続したため、
+ *     PC-007.stackMarginOk を満たすために mainTask の最小余裕を増やす。
+ *   - [変更][2026-04-04] secure NVS 初期化ログ強化と最終セキュア化前の診断余裕確保のため、さらに 512 byte 増やす。
+ *   - [変更][2026-04-04b] AP/STA/OTA 事前動作確認と文鎮化時診断用途で、さらに 1024 byte 追加し、きりのよい 15KB に合わせる。
+ *   - [重要] setup() から xTaskCreatePinnedToCore で生成するため、スタックは内部RAMになる（kInternalOnly）。
+ * - wifiTask / tcpipTask:
+ *   - [変更][2026-04-04] 追加ログと原因切り分け余裕を確保するため、最小限として 512 byte 増やす。
+ * - mqttTask:
+ *   - [重要] 画像更新は分割I/O（小チャンク）で処理し、スタック肥大化を抑制する。
+ *   - [厳守] OTA系と同様の保守性を維持するため、スタックは 8192 + 4096 相当（12288）へ留める。
+ *   - [変更][2026-04-04] MQTT 上層のログ強化とセキュア化前診断余裕のため、最小限として 512 byte だけ追加する。
+ * - otaTask:
+ *   - [重要] TLS 受信が主体のため core0 に置く。フラッシュ書込みはキャッシュ停止で両コアに影響するが、
+ *     CPU 時間は TLS 復号が支配的である。
+ * - fileLogWriterTask:
+ *   - [変更][2026-04-04] セキュア化最終版の診断ログ増加を見込みつつ、過剰確保を避けるため 512 byte のみ加算する。
+ *   - [重要] LittleFS 書込み（CRC/メタデータ更新）を通信系と分けるため core1 に置く。
+ * - netSelfTestTask:
+ *   - [重要] `call netSelfTest` の計測専用。mqttTask から起こされ、TLS ハンドシェイクを含むため core0 に置く。
+ *   - [重要] mbedtls のハンドシェイク分を見込み 10KB とする（otaTask と異なりフラッシュ書込みは無い）。
+ * - [変更][2026-10-18] 全タスク tskNO_AFFINITY から、通信系 core0 / アプリ・フラッシュ系 core1 の明示配置へ変更。
+ */
+constexpr taskPlacementEntry placementTable[] = {
+    {"mainTask", kApplicationCoreId, 1, taskStackLocation::kInternalOnly, 15360},
+    {"wifiTask", kNetworkCoreId, 1, taskStackLocation::kPsramPreferred, 4608},
+    {"mqttTask", kNetworkCoreId, 1, taskStackLocation::kPsramPreferred, 12800},
+    {"httpTask", kNetworkCoreId, 1, taskStackLocation::kPsramPreferred, 4096},
+    {"tcpipTask", kNetworkCoreId, 1, taskStackLocation::kPsramPreferred, 3584},
+    {"otaTask", kNetworkCoreId, 1, taskStackLocation::kPsramPreferred, 16384},
+    {"timeServerTask", kNetworkCoreId, 0, taskStackLocation::kPsramPreferred, 4096},
+    {"externalDeviceTask", kApplicationCoreId, 1, taskStackLocation::kPsramPreferred, 4096},
+    {"displayTask", kApplicationCoreId, 1, taskStackLocation::kPsramPreferred, 4096},
+    {"ledTask", kApplicationCoreId, 1, taskStackLocation::kPsramPreferred, 4096},
+    {"inputTask", kApplicationCoreId, 1, taskStackLocation::kPsramPreferred, 4096},
+    {"i2cTask", kApplicationCoreId, 2, taskStackLocation::kPsramPreferred, 4096},
+    {"fileLogWriterTask", kApplicationCoreId, 0, taskStackLocation::kPsramPreferred, 6656},
+    {"netSelfTestTask", kNetworkCoreId, 1, taskStackLocation::kPsramPreferred, 10240},
+};
+static_assert(sizeof(placementTable) / sizeof(placementTable[0]) == static_cast<size_t>(placedTaskId::kCount),
+              "placementTable must have one row per placedTaskId.");
+
+/** @brief コア別負荷の計測窓(ms)。@type uint32_t */
+constexpr uint32_t cpuLoadSampleWindowMs = 10000;
+
+/** @brief 計測開始済みフラグ。@type bool */
+bool isCpuLoadSamplingStarted = false;
+/** @brief 直近の計測窓の開始時刻(ms)。@type uint32_t */
+uint32_t sampleWindowStartMs = 0;
+/** @brief 直近の計測結果。@type cpuLoadSnapshot */
+cpuLoadSnapshot latestSnapshot{false, "", 0, {0, 0}, 0};
+/** @brief latestSnapshot の排他（mainTask が更新し、mqttTask が参照する）。 */
+portMUX_TYPE snapshotLock = portMUX_INITIALIZER_UNLOCKED;
+
+#if TASK_PLACEMENT_USE_RUN_TIME_STATS
+/** @brief uxTaskGetSystemState で受け取る最大タスク数。@type UBaseType_t */
+constexpr UBaseType_t maxSampledTaskCount = 32;
+/** @brief uxTaskGetSystemState の受け取り領域（スタック節約のため静的確保）。 */
+TaskStatus_t sampledTaskStatusList[maxSampledTaskCount];
+/** @brief 前回計測時の IDLE タスク実行時間。 */
+uint32_t previousIdleRunTime[kMaxCoreCount] = {};
+/** @brief 前回計測時の総実行時間。 */
+uint32_t previousTotalRunTime = 0;
+
+/**
+ * @brief IDLE タスクの実行時間と総実行時間を取得する。
+ * @param idleRunTimeOut コア別 IDLE 実行時間の出力先。
+ * @param totalRunTimeOut 総実行時間の出力先。
+ * @return 取得成功時true。
+ */
+bool readIdleRunTime(uint32_t* idleRunTimeOut, uint32_t* totalRunTimeOut) {
+  uint32_t totalRunTime = 0;
+  const UBaseType_t taskCount = uxTaskGetSystemState(sampledTaskStatusList, maxSampledTaskCount, &totalRunTime);
+  if (taskCount == 0) {
+    return false;
+  }
+  for (uint8_t coreIndex = 0; coreIndex < portNUM_PROCESSORS && coreIndex < kMaxCoreCount; ++coreIndex) {
+    const TaskHandle_t idleTaskHandle = xTaskGetIdleTaskHandleForCPU(coreIndex);
+    idleRunTimeOut[coreIndex] = 0;
+    for (UBaseType_t taskIndex = 0; taskIndex < taskCount; ++taskIndex) {
+      if (sampledTaskStatusList[taskIndex].xHandle == idleTaskHandle) {
+        idleRunTimeOut[coreIndex] = sampledTaskStatusList[taskIndex].ulRunTimeCounter;
+        break;
+      }
+    }
+  }
+  *totalRunTimeOut = totalRunTime;
+  return true;
+}
+#else
+/** @brief コア別の idle tick 数（idle hook が加算する）。 */
+volatile uint32_t idleTickCount[kMaxCoreCount] = {};
+/** @brief コア別の直近 idle tick（同一 tick 内の重複加算防止）。 */
+volatile TickType_t lastIdleTick[kMaxCoreCount] = {};
+/** @brief 前回計測時の idle tick 数。 */
+uint32_t previousIdleTickCount[kMaxCoreCount] = {};
+/** @brief 前回計測時の tick。 */
+TickType_t previousSampleTick = 0;
+
+/**
+ * @brief idle hook 共通処理。1 tick につき1回だけ idle tick を数える。
+ * @param coreIndex 対象コア。
+ * @return 常に true（割り込みまで CPU を待機させる）。
+ */
+bool recordIdleTick(uint8_t coreIndex) {
+  const TickType_t currentTick = xTaskGetTickCount();
+  if (lastIdleTick[coreIndex] != currentTick) {
+    lastIdleTick[coreIndex] = currentTick;
+    idleTickCount[coreIndex] = idleTickCount[coreIndex] + 1;
+  }
+  return true;
+}
+
+bool idleHookCore0() {
+  return recordIdleTick(0);
+}
+
+#if portNUM_PROCESSORS > 1
+bool idleHookCore1() {
+  return recordIdleTick(1);
+}
+#endif
+#endif
+
+/**
+ * @brief idle 比率から負荷(%)を算出する。
+ * @param idleAmount 計測窓内の idle 量。
+ * @param totalAmount 計測窓の総量。
+ * @return 負荷(%)。0..100。
+ */
+uint8_t toLoadPercent(uint32_t idleAmount, uint32_t totalAmount) {
+  if (totalAmount == 0) {
+    return 0;
+  }
+  if (idleAmount > totalAmount) {
+    idleAmount = totalAmount;
+  }
+  return static_cast<uint8_t>(100U - static_cast<uint32_t>((static_cast<uint64_t>(idleAmount) * 100U) / totalAmount));
+}
+
+/**
+ * @brief コア番号の表示名を返す。
+ * @param coreId コア番号または tskNO_AFFINITY。
+ * @return 表示名。
+ */
+const char* toCoreText(BaseType_t coreId) {
+  if (coreId == kNetworkCoreId) {
+    return "0";
+  }
+  if (coreId == kApplicationCoreId) {
+    return "1";
+  }
+  return "any";
+}
+
+}  // namespace
+
+const taskPlacementEntry& getPlacement(placedTaskId taskId) {
+  const size_t tableIndex = static_cast<size_t>(taskId);
+  if (tableIndex >= static_cast<size_t>(placedTaskId::kCount)) {
+    appLogError("taskPlacement::getPlacement failed. taskId=%u is out of range.", static_cast<unsigned>(tableIndex));
+    return placementTable[0];
+  }
+  return placementTable[tableIndex];
+}
+
+bool createPlacedStaticTask(placedTaskId taskId,
+                            TaskFunction_t taskEntry,
+                            void* taskParameter,
+                            StackType_t** stackBufferInOut,
+                            StaticTask_t* controlBlockOut,
+                            TaskHandle_t* taskHandleOut) {
+  if (taskEntry == nullptr || stackBufferInOut == nullptr || controlBlockOut == nullptr) {
+    appLogError("taskPlacement::createPlacedStaticTask failed. taskEntry=%p stackBufferInOut=%p controlBlockOut=%p",
+                reinterpret_cast<void*>(taskEntry),
+                stackBufferInOut,
+                controlBlockOut);
+    return false;
+  }
+  const taskPlacementEntry& placement = getPlacement(taskId);
+  const size_t stackBytes = placement.stackSize * sizeof(StackType_t);
+
+  const char* stackLocationText = "internal";
+  if (*stackBufferInOut == nullptr && placement.stackLocation == taskStackLocation::kPsramPreferred) {
+    *stackBufferInOut = static_cast<StackType_t*>(heap_caps_malloc(stackBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (*stackBufferInOut == nullptr) {
+      appLogWarn("%s: PSRAM stack allocation failed. fallback to internal RAM.", placement.taskName);
+    } else {
+      stackLocationText = "psram";
+    }
+  }
+  if (*stackBufferInOut == nullptr) {
+    *stackBufferInOut = static_cast<StackType_t*>(heap_caps_malloc(stackBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+  }
+  if (*stackBufferInOut == nullptr) {
+    appLogError("%s creation failed. heap_caps_malloc stack failed. stackBytes=%u",
+                placement.taskName,
+                static_cast<unsigned>(stackBytes));
+    return false;
+  }
+
+  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(taskEntry,
+                                                                 placement.taskName,
+                                                                 placement.stackSize,
+                                                                 taskParameter,
+                                                                 placement.priority,
+                                                                 *stackBufferInOut,
+                                                                 controlBlockOut,
+                                                                 placement.coreId);
+  if (taskHandleOut != nullptr) {
+    *taskHandleOut = createdTaskHandle;
+  }
+  if (createdTaskHandle == nullptr) {
+    appLogError("%s creation failed. xTaskCreateStaticPinnedToCore returned null.", placement.taskName);
+    return false;
+  }
+  appLogInfo("%s created. core=%s priority=%u stack=%s stackBytes=%u",
+             placement.taskName,
+             toCoreText(placement.coreId),
+             static_cast<unsigned>(placement.priority),
+             stackLocationText,
+             static_cast<unsigned>(stackBytes));
+  return true;
+}
+
+bool startCpuLoadSampling() {
+  if (isCpuLoadSamplingStarted) {
+    return true;
+  }
+#if TASK_PLACEMENT_USE_RUN_TIME_STATS
+  if (!readIdleRunTime(previousIdleRunTime, &previousTotalRunTime)) {
+    appLogError("taskPlacement::startCpuLoadSampling failed. uxTaskGetSystemState returned 0.");
+    return false;
+  }
+#else
+  esp_err_t registerResult = esp_register_freertos_idle_hook_for_cpu(idleHookCore0, 0);
+#if portNUM_PROCESSORS > 1
+  if (registerResult == ESP_OK) {
+    registerResult = esp_register_freertos_idle_hook_for_cpu(idleHookCore1, 1);
+  }
+#endif
+  if (registerResult != ESP_OK) {
+    appLogError("taskPlacement::startCpuLoadSampling failed. esp_register_freertos_idle_hook_for_cpu err=%s",
+                esp_err_to_name(registerResult));
+    return false;
+  }
+  previousSampleTick = xTaskGetTickCount();
+#endif
+  sampleWindowStartMs = millis();
+  isCpuLoadSamplingStarted = true;
+  appLogInfo("taskPlacement: cpu load sampling started. method=%s windowMs=%lu",
+             TASK_PLACEMENT_USE_RUN_TIME_STATS ? "runTimeStats" : "idleTick",
+             static_cast<unsigned long>(cpuLoadSampleWindowMs));
+  return true;
+}
+
+void updateCpuLoadSampling(uint32_t nowMs) {
+  if (!isCpuLoadSamplingStarted) {
+    return;
+  }
+  const uint32_t elapsedMs = nowMs - sampleWindowStartMs;
+  if (elapsedMs < cpuLoadSampleWindowMs) {
+    return;
+  }
+
+  cpuLoadSnapshot nextSnapshot{};
+  nextSnapshot.isValid = true;
+  nextSnapshot.coreCount = (portNUM_PROCESSORS < kMaxCoreCount) ? portNUM_PROCESSORS : kMaxCoreCount;
+  nextSnapshot.sampleWindowMs = elapsedMs;
+#if TASK_PLACEMENT_USE_RUN_TIME_STATS
+  nextSnapshot.methodName = "runTimeStats";
+  uint32_t currentIdleRunTime[kMaxCoreCount] = {};
+  uint32_t currentTotalRunTime = 0;
+  if (!readIdleRunTime(currentIdleRunTime, &currentTotalRunTime)) {
+    appLogWarn("taskPlacement::updateCpuLoadSampling skipped. uxTaskGetSystemState returned 0.");
+    return;
+  }
+  const uint32_t totalDelta = currentTotalRunTime - previousTotalRunTime;
+  for (uint8_t coreIndex = 0; coreIndex < nextSnapshot.coreCount; ++coreIndex) {
+    nextSnapshot.loadPercent[coreIndex] =
+        toLoadPercent(currentIdleRunTime[coreIndex] - previousIdleRunTime[coreIndex], totalDelta);
+    previousIdleRunTime[coreIndex] = currentIdleRunTime[coreIndex];
+  }
+  previousTotalRunTime = currentTotalRunTime;
+#else
+  nextSnapshot.methodName = "idleTick";
+  const TickType_t currentTick = xTaskGetTickCount();
+  const uint32_t tickDelta = static_cast<uint32_t>(currentTick - previousSampleTick);
+  for (uint8_t coreIndex = 0; coreIndex < nextSnapshot.coreCount; ++coreIndex) {
+    const uint32_t currentIdleTickCount = idleTickCount[coreIndex];
+    nextSnapshot.loadPercent[coreIndex] =
+        toLoadPercent(currentIdleTickCount - previousIdleTickCount[coreIndex], tickDelta);
+    previousIdleTickCount[coreIndex] = currentIdleTickCount;
+  }
+  previousSampleTick = currentTick;
+#endif
+  sampleWindowStartMs = nowMs;
+
+  taskENTER_CRITICAL(&snapshotLock);
+  latestSnapshot = nextSnapshot;
+  taskEXIT_CRITICAL(&snapshotLock);
+  appLogDebug("taskPlacement: cpu load core0=%u%% core1=%u%% windowMs=%lu method=%s",
+              static_cast<unsigned>(nextSnapshot.loadPercent[0]),
+              static_cast<unsigned>(nextSnapshot.loadPercent[1]),
+              static_cast<unsigned long>(nextSnapshot.sampleWindowMs),
+              nextSnapshot.methodName);
+}
+
+bool getCpuLoadSnapshot(cpuLoadSnapshot* snapshotOut) {
+  if (snapshotOut == nullptr) {
+    appLogError("taskPlacement::getCpuLoadSnapshot failed. snapshotOut is null.");
+    return false;
+  }
+  taskENTER_CRITICAL(&snapshotLock);
+  *snapshotOut = latestSnapshot;
+  taskEXIT_CRITICAL(&snapshotLock);
+  return snapshotOut->isValid;
+}
+
+}  // namespace taskPlacement
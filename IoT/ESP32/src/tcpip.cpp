@@ -5,11 +5,11 @@
 
 #include "tcpip.h"
 
-#include <esp_heap_caps.h>
 #include <string.h>
 
 #include "interTaskMessage.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
 StackType_t* tcpipTaskStackBuffer = nullptr;
@@ -20,34 +20,14 @@ bool tcpipTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kTcpip, 8);
 
-  if (tcpipTaskStackBuffer == nullptr) {
-    tcpipTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (tcpipTaskStackBuffer == nullptr) {
-    appLogWarn("tcpipTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    tcpipTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (tcpipTaskStackBuffer == nullptr) {
-    appLogError("tcpipTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
-    return false;
-  }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "tcpipTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      tcpipTaskStackBuffer,
-      &tcpipTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("tcpipTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kTcpip,
+                                             taskEntry,
+                                             this,
+                                             &tcpipTaskStackBuffer,
+                                             &tcpipTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("tcpipTask created. stackBytes=%u", static_cast<unsigned>(taskStackSize));
   return true;
 }
 
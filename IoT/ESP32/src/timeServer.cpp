@@ -9,13 +9,13 @@
 
 #include "timeServer.h"
 
-#include <esp_heap_caps.h>
 #include <string.h>
 #include <WiFi.h>
 
 #include "timeService.h"
 #include "interTaskMessage.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
 /** @brief timeServerTask用スタック領域。PSRAM優先で確保し、失敗時は内部RAMへフォールバックする。 */
@@ -55,35 +55,14 @@ bool timeServerTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kTimeServer, 8);
 
-  if (timeServerTaskStackBuffer == nullptr) {
-    timeServerTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (timeServerTaskStackBuffer == nullptr) {
-    appLogWarn("timeServerTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    timeServerTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (timeServerTaskStackBuffer == nullptr) {
-    appLogError("timeServerTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
-    return false;
-  }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "timeServerTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      timeServerTaskStackBuffer,
-      &timeServerTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("timeServerTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kTimeServer,
+                                             taskEntry,
+                                             this,
+                                             &timeServerTaskStackBuffer,
+                                             &timeServerTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-
-  appLogInfo("timeServerTask created.");
   return true;
 }
 
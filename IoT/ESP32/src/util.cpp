@@ -67,34 +67,6 @@ bool textFieldEquals(const char* expected, const char* actual) {
   return (strcmp(expected, actual) == 0);
 }
 
-bool messageDetailMatches(const appTaskMessage& message, const appUtil::appTaskMessageDetail* waitDetail) {
-  if (waitDetail == nullptr) {
-    return true;
-  }
-  if (waitDetail->hasIntValue && message.intValue != waitDetail->intValue) {
-    return false;
-  }
-  if (waitDetail->hasIntValue2 && message.intValue2 != waitDetail->intValue2) {
-    return false;
-  }
-  if (waitDetail->hasBoolValue && message.boolValue != waitDetail->boolValue) {
-    return false;
-  }
-  if (!textFieldEquals(waitDetail->text, message.text)) {
-    return false;
-  }
-  if (!textFieldEquals(waitDetail->text2, message.text2)) {
-    return false;
-  }
-  if (!textFieldEquals(waitDetail->text3, message.text3)) {
-    return false;
-  }
-  if (!textFieldEquals(waitDetail->text4, message.text4)) {
-    return false;
-  }
-  return true;
-}
-
 /** @brief タスク別フラグ管理テーブル。 */
 bool taskFlagTable[appDefine::kTaskSlotCount][appDefine::kTaskFlagSlotCount] = {};
 /** @brief フラグテーブル排他制御用スピンロック。 */
@@ -158,14 +130,15 @@ appTaskMessageDetail createEmptyMessageDetail() {
   detail.text2 = nullptr;
   detail.text3 = nullptr;
   detail.text4 = nullptr;
+  detail.hasCompletionToken = false;
+  detail.completionToken = appCompletionToken{0, 0};
   return detail;
 }
 
-bool sendMessage(appTaskId destinationTaskId,
-                 appTaskId sourceTaskId,
-                 appMessageType requestType,
-                 const appTaskMessageDetail* requestDetail,
-                 int32_t timeoutMs) {
+appTaskMessage buildTaskMessage(appTaskId destinationTaskId,
+                                appTaskId sourceTaskId,
+                                appMessageType requestType,
+                                const appTaskMessageDetail* requestDetail) {
   appTaskMessage requestMessage{};
   requestMessage.sourceTaskId = sourceTaskId;
   requestMessage.destinationTaskId = destinationTaskId;
@@ -185,7 +158,47 @@ bool sendMessage(appTaskId destinationTaskId,
     copyTextField(requestMessage.text2, sizeof(requestMessage.text2), requestDetail->text2);
     copyTextField(requestMessage.text3, sizeof(requestMessage.text3), requestDetail->text3);
     copyTextField(requestMessage.text4, sizeof(requestMessage.text4), requestDetail->text4);
+    if (requestDetail->hasCompletionToken) {
+      requestMessage.completionToken = requestDetail->completionToken;
+    }
   }
+  return requestMessage;
+}
+
+bool messageDetailMatches(const appTaskMessage& message, const appTaskMessageDetail* waitDetail) {
+  if (waitDetail == nullptr) {
+    return true;
+  }
+  if (waitDetail->hasIntValue && message.intValue != waitDetail->intValue) {
+    return false;
+  }
+  if (waitDetail->hasIntValue2 && message.intValue2 != waitDetail->intValue2) {
+    return false;
+  }
+  if (waitDetail->hasBoolValue && message.boolValue != waitDetail->boolValue) {
+    return false;
+  }
+  if (!textFieldEquals(waitDetail->text, message.text)) {
+    return false;
+  }
+  if (!textFieldEquals(waitDetail->text2, message.text2)) {
+    return false;
+  }
+  if (!textFieldEquals(waitDetail->text3, message.text3)) {
+    return false;
+  }
+  if (!textFieldEquals(waitDetail->text4, message.text4)) {
+    return false;
+  }
+  return true;
+}
+
+bool sendMessage(appTaskId destinationTaskId,
+                 appTaskId sourceTaskId,
+                 appMessageType requestType,
+                 const appTaskMessageDetail* requestDetail,
+                 int32_t timeoutMs) {
+  appTaskMessage requestMessage = buildTaskMessage(destinationTaskId, sourceTaskId, requestType, requestDetail);
 
   TickType_t timeoutTicks = pdMS_TO_TICKS((timeoutMs <= 0) ? 0 : timeoutMs);
   bool sendResult = getInterTaskMessageService().sendMessage(requestMessage, timeoutTicks);
@@ -9,7 +9,6 @@
 
 #include "../header/wifi.h"
 
-#include <esp_heap_caps.h>
 #include <string.h>
 #include <WiFi.h>
 
@@ -17,6 +16,7 @@
 #include "interTaskMessage.h"
 #include "led.h"
 #include "log.h"
+#include "taskPlacement.h"
 
 namespace {
 /** @brief wifiTask用スタック領域。PSRAM優先で確保し、失敗時は内部RAMへフォールバックする。 */
@@ -243,34 +243,14 @@ bool wifiTask::startTask() {
   interTaskMessageService& messageService = getInterTaskMessageService();
   messageService.registerTaskQueue(appTaskId::kWifi, 8);
 
-  if (wifiTaskStackBuffer == nullptr) {
-    wifiTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-  }
-  if (wifiTaskStackBuffer == nullptr) {
-    appLogWarn("wifiTask: PSRAM stack allocation failed. fallback to internal RAM.");
-    wifiTaskStackBuffer = static_cast<StackType_t*>(
-        heap_caps_malloc(taskStackSize * sizeof(StackType_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-  }
-  if (wifiTaskStackBuffer == nullptr) {
-    appLogError("wifiTask creation failed. heap_caps_malloc stack failed. caps=SPIRAM|INTERNAL");
-    return false;
-  }
-
-  TaskHandle_t createdTaskHandle = xTaskCreateStaticPinnedToCore(
-      taskEntry,
-      "wifiTask",
-      taskStackSize,
-      this,
-      taskPriority,
-      wifiTaskStackBuffer,
-      &wifiTaskControlBlock,
-      tskNO_AFFINITY);
-  if (createdTaskHandle == nullptr) {
-    appLogError("wifiTask creation failed. xTaskCreateStaticPinnedToCore returned null.");
+  if (!taskPlacement::createPlacedStaticTask(taskPlacement::placedTaskId::kWifi,
+                                             taskEntry,
+                                             this,
+                                             &wifiTaskStackBuffer,
+                                             &wifiTaskControlBlock,
+                                             nullptr)) {
     return false;
   }
-  appLogInfo("wifiTask created. stackBytes=%u", static_cast<unsigned>(taskStackSize));
   return true;
 }
 
@@ -0,0 +1,337 @@
+/**
+ * @file base64Benchmark.cpp
+ * @brief 共通Base64（src/base64Codec.cpp）の一致確認と、mbedtls_base64_* との速度比較。
+ * @details
+ * - [重要] ファームウェアの base64Codec を無改変でリンクし、ホストの mbedTLS と次を突き合わせる。
+ *   - 0〜1024 byte と大きな入力の符号化結果が mbedtls と一致し、復号（通常 / 上書き / 逐次）で元に戻ること
+ *   - getDecodedLength が空白なしの入力で正確な長さを返すこと
+ *   - 改行入りの入力を mbedtls と同じく受理し、不正な入力（パディング省略を含む）を拒否すること
+ * - [重要] 速度は「置換前の実装（長さ問合せ + 本処理の2回呼出し、String へ1文字ずつ追加）」と
+ *   「base64Codec」を同じ入力で比べ、MB/s（入力側 byte 数基準）を表示する。
+ * - [注意] ホストの数値は相対比較用。実機（Xtensa、フラッシュ上の表）での絶対値とは異なる。
+ * - 判定に失敗した場合は終了コード 1 を返す。
+ */
+
+#include <mbedtls/base64.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base64Codec.h"
+
+namespace {
+
+/**
+ * @brief ベンチマーク設定。
+ */
+struct benchmarkOptions {
+  uint32_t seed = 1;
+  uint32_t minMs = 200;
+  bool isQuick = false;
+};
+
+/** @brief 判定失敗の件数。@type uint32_t */
+uint32_t failureCount = 0;
+
+void printUsage(const char* programName) {
+  printf("usage: %s [options]\n"
+         "  --seed N     乱数シード (default 1)\n"
+         "  --min-ms N   1計測あたりの最短時間 ms (default 200)\n"
+         "  --quick      一致確認のみ行い、速度計測を省略する\n",
+         programName);
+}
+
+bool parseOptions(int argc, char** argv, benchmarkOptions* optionsOut) {
+  for (int argIndex = 1; argIndex < argc; ++argIndex) {
+    const std::string arg = argv[argIndex];
+    const bool hasValue = (argIndex + 1) < argc;
+    if (arg == "--seed" && hasValue) {
+      optionsOut->seed = static_cast<uint32_t>(strtoul(argv[++argIndex], nullptr, 10));
+    } else if (arg == "--min-ms" && hasValue) {
+      optionsOut->minMs = static_cast<uint32_t>(strtoul(argv[++argIndex], nullptr, 10));
+    } else if (arg == "--quick") {
+      optionsOut->isQuick = true;
+    } else {
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+void expect(bool condition, const char* caseName, size_t size) {
+  if (!condition) {
+    ++failureCount;
+    printf("FAIL %s size=%zu\n", caseName, size);
+  }
+}
+
+/**
+ * @brief 置換前の mqtt.cpp / maintenanceApServer.cpp と同じ手順の復号（比較基準）。
+ */
+bool legacyDecode(const String& inputBase64, std::vector<uint8_t>* outputBufferOut) {
+  outputBufferOut->clear();
+  size_t outputLength = 0;
+  const int probeResult = mbedtls_base64_decode(nullptr, 0, &outputLength,
+                                                reinterpret_cast<const unsigned char*>(inputBase64.c_str()), inputBase64.length());
+  if (probeResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && probeResult != 0) {
+    return false;
+  }
+  outputBufferOut->resize(outputLength);
+  if (outputLength == 0) {
+    return true;
+  }
+  if (mbedtls_base64_decode(outputBufferOut->data(), outputBufferOut->size(), &outputLength,
+                            reinterpret_cast<const unsigned char*>(inputBase64.c_str()), inputBase64.length()) != 0) {
+    return false;
+  }
+  outputBufferOut->resize(outputLength);
+  return true;
+}
+
+/**
+ * @brief 置換前の mqttPayloadSecurity.cpp / maintenanceApServer.cpp と同じ手順の符号化（比較基準）。
+ */
+bool legacyEncode(const std::vector<uint8_t>& inputBuffer, String* outputBase64Out) {
+  size_t encodedLength = 0;
+  const int probeResult = mbedtls_base64_encode(nullptr, 0, &encodedLength, inputBuffer.data(), inputBuffer.size());
+  if (probeResult != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && probeResult != 0) {
+    return false;
+  }
+  std::vector<uint8_t> outputBytes(encodedLength + 1, 0);
+  if (mbedtls_base64_encode(outputBytes.data(), outputBytes.size(), &encodedLength, inputBuffer.data(), inputBuffer.size()) != 0) {
+    return false;
+  }
+  outputBase64Out->remove(0);
+  outputBase64Out->reserve(encodedLength);
+  for (size_t index = 0; index < encodedLength; ++index) {
+    *outputBase64Out += static_cast<char>(outputBytes[index]);
+  }
+  return true;
+}
+
+std::string encodeWithMbedtls(const std::vector<uint8_t>& bytes) {
+  size_t encodedLength = 0;
+  mbedtls_base64_encode(nullptr, 0, &encodedLength, bytes.data(), bytes.size());
+  std::vector<unsigned char> encodedBuffer(encodedLength + 1, 0);
+  mbedtls_base64_encode(encodedBuffer.data(), encodedBuffer.size(), &encodedLength, bytes.data(), bytes.size());
+  return std::string(reinterpret_cast<const char*>(encodedBuffer.data()), encodedLength);
+}
+
+bool decodeWithMbedtls(const std::string& text, std::vector<uint8_t>* bytesOut) {
+  bytesOut->assign(text.size() + 3, 0);
+  size_t outputLength = 0;
+  const int decodeResult = mbedtls_base64_decode(bytesOut->data(), bytesOut->size(), &outputLength,
+                                                 reinterpret_cast<const unsigned char*>(text.data()), text.size());
+  bytesOut->resize(outputLength);
+  return decodeResult == 0;
+}
+
+/**
+ * @brief 1 サイズ分の一致確認（符号化・復号・上書き復号・逐次処理）。
+ */
+void checkRoundTrip(const std::vector<uint8_t>& bytes, std::mt19937* random) {
+  const size_t size = bytes.size();
+  const std::string expectedText = encodeWithMbedtls(bytes);
+
+  std::vector<char> encodedText(base64Codec::getEncodedLength(size) + 1, 'x');
+  size_t encodedLength = 0;
+  expect(base64Codec::encode(bytes.data(), size, encodedText.data(), encodedText.size(), &encodedLength), "encode", size);
+  expect(encodedLength == expectedText.size() && memcmp(encodedText.data(), expectedText.data(), encodedLength) == 0 &&
+             encodedText[encodedLength] == '\0',
+         "encode matches mbedtls", size);
+
+  String encodedString;
+  expect(base64Codec::encodeToText(bytes, &encodedString) && expectedText == encodedString.c_str(), "encodeToText", size);
+
+  expect(base64Codec::getDecodedLength(expectedText.data(), expectedText.size()) == size, "getDecodedLength exact", size);
+
+  std::vector<uint8_t> decodedBytes;
+  expect(base64Codec::decodeToBytes(String(expectedText.c_str()), &decodedBytes) && decodedBytes == bytes, "decodeToBytes", size);
+
+  std::string inPlaceText = expectedText;
+  size_t inPlaceLength = 0;
+  expect(base64Codec::decodeInPlace(&inPlaceText[0], inPlaceText.size(), &inPlaceLength) && inPlaceLength == size &&
+             memcmp(inPlaceText.data(), bytes.data(), size) == 0,
+         "decodeInPlace", size);
+
+  // 逐次処理: 1〜17 の不揃いな区切りで流し込み、一括処理と同じ結果になること
+  std::uniform_int_distribution<size_t> chunkDistribution(1, 17);
+  base64StreamEncoder streamEncoder;
+  std::string streamText;
+  size_t byteIndex = 0;
+  bool isStreamOk = true;
+  while (byteIndex < size) {
+    const size_t chunkSize = std::min(chunkDistribution(*random), size - byteIndex);
+    char chunkText[32];
+    size_t chunkTextLength = 0;
+    isStreamOk = isStreamOk && streamEncoder.update(bytes.data() + byteIndex, chunkSize, chunkText, sizeof(chunkText), &chunkTextLength);
+    streamText.append(chunkText, chunkTextLength);
+    byteIndex += chunkSize;
+  }
+  char tailText[4];
+  size_t tailTextLength = 0;
+  isStreamOk = isStreamOk && streamEncoder.finish(tailText, sizeof(tailText), &tailTextLength);
+  streamText.append(tailText, tailTextLength);
+  expect(isStreamOk && streamText == expectedText, "base64StreamEncoder", size);
+
+  base64StreamDecoder streamDecoder;
+  std::vector<uint8_t> streamBytes;
+  size_t textIndex = 0;
+  isStreamOk = true;
+  while (textIndex < expectedText.size()) {
+    const size_t chunkLength = std::min(chunkDistribution(*random), expectedText.size() - textIndex);
+    uint8_t chunkBytes[32];
+    size_t chunkByteLength = 0;
+    isStreamOk = isStreamOk && streamDecoder.update(expectedText.data() + textIndex, chunkLength, chunkBytes,
+                                                    sizeof(chunkBytes), &chunkByteLength);
+    streamBytes.insert(streamBytes.end(), chunkBytes, chunkBytes + chunkByteLength);
+    textIndex += chunkLength;
+  }
+  expect(isStreamOk && streamDecoder.finish() && streamBytes == bytes, "base64StreamDecoder", size);
+
+  // 76 文字ごとの改行（PEM / MIME 形式）は mbedtls と同じく受理する
+  std::string wrappedText;
+  for (size_t lineStart = 0; lineStart < expectedText.size(); lineStart += 76) {
+    wrappedText.append(expectedText, lineStart, 76);
+    wrappedText.append("\r\n");
+  }
+  std::vector<uint8_t> wrappedBytes(base64Codec::getDecodedLength(wrappedText.data(), wrappedText.size()));
+  size_t wrappedLength = 0;
+  expect(wrappedBytes.size() >= size &&
+             base64Codec::decode(wrappedText.data(), wrappedText.size(), wrappedBytes.data(), wrappedBytes.size(), &wrappedLength) &&
+             wrappedLength == size && memcmp(wrappedBytes.data(), bytes.data(), size) == 0,
+         "decode with line breaks", size);
+}
+
+/**
+ * @brief 不正な入力の拒否を確認する。
+ * @details
+ * - [重要] パディングを省いた末尾（"QQ" 等）は mbedtls 2.x では成功扱いのまま末尾が捨てられる（出力長で分かる）。
+ *   base64Codec は欠けたデータを受理しないよう失敗にする。
+ */
+void checkInvalidInputs() {
+  const char* const invalidTexts[] = {"Q", "QQ", "QUI", "QQ=", "QUJDRA", "Q===", "QQ=A", "QQ==QUJD", "QQ===", "QUJ*", "QUJD\x80RA==", "=QQQ"};
+  for (const char* text : invalidTexts) {
+    uint8_t bytes[16];
+    size_t byteLength = 0;
+    std::vector<uint8_t> mbedtlsBytes;
+    const bool isAccepted = base64Codec::decode(text, strlen(text), bytes, sizeof(bytes), &byteLength);
+    const bool isMbedtlsAccepted = decodeWithMbedtls(text, &mbedtlsBytes);
+    printf("invalid \"%s\": base64Codec=%s mbedtls=%s", text, isAccepted ? "accepted" : "rejected",
+           isMbedtlsAccepted ? "accepted" : "rejected");
+    if (isMbedtlsAccepted) {
+      printf(" (mbedtls output %zu bytes)", mbedtlsBytes.size());
+    }
+    printf("\n");
+    expect(!isAccepted, "reject invalid input", strlen(text));
+  }
+  uint8_t smallBuffer[2];
+  size_t byteLength = 0;
+  expect(!base64Codec::decode("QUJD", 4, smallBuffer, sizeof(smallBuffer), &byteLength), "reject small buffer", 4);
+  char smallText[3];
+  expect(!base64Codec::encode(reinterpret_cast<const uint8_t*>("AB"), 2, smallText, sizeof(smallText), nullptr), "reject small text", 2);
+}
+
+/**
+ * @brief 処理を minMs 以上繰り返し、入力 byte 数基準の MB/s を返す。
+ */
+template <typename Operation>
+double measureMegabytesPerSecond(size_t bytesPerCall, uint32_t minMs, Operation operation) {
+  using clock = std::chrono::steady_clock;
+  uint64_t callCount = 0;
+  const auto startTime = clock::now();
+  auto elapsed = clock::duration::zero();
+  do {
+    for (uint32_t batchIndex = 0; batchIndex < 64; ++batchIndex) {
+      operation();
+    }
+    callCount += 64;
+    elapsed = clock::now() - startTime;
+  } while (elapsed < std::chrono::milliseconds(minMs));
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  return (static_cast<double>(bytesPerCall) * static_cast<double>(callCount)) / seconds / 1e6;
+}
+
+void runBenchmarks(const benchmarkOptions& options, std::mt19937* random) {
+  // 12: GCM IV、16: タグ、32: k-device、1024 / 4096: fileSync チャンク、49152: 大きな payload
+  const size_t sizes[] = {12, 16, 32, 1024, 4096, 49152};
+  printf("%8s %14s %14s %14s %14s %14s %14s\n", "bytes", "enc legacy", "enc codec", "dec mbedtls", "dec codec", "dec legacy",
+         "dec toBytes");
+  for (const size_t size : sizes) {
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& value : bytes) {
+      value = static_cast<uint8_t>((*random)());
+    }
+    const std::string text = encodeWithMbedtls(bytes);
+    const String textString(text.c_str());
+    String encodedString;
+    std::vector<uint8_t> decodedBytes;
+
+    const double legacyEncodeMbps = measureMegabytesPerSecond(size, options.minMs, [&]() { legacyEncode(bytes, &encodedString); });
+    const double codecEncodeMbps =
+        measureMegabytesPerSecond(size, options.minMs, [&]() { base64Codec::encodeToText(bytes, &encodedString); });
+    // 生の復号: mbedtls の2回呼出しと base64Codec::decode（確保済みバッファへ）
+    std::vector<uint8_t> rawBuffer(size + 3);
+    const double rawMbedtlsDecodeMbps = measureMegabytesPerSecond(text.size(), options.minMs, [&]() {
+      size_t outputLength = 0;
+      mbedtls_base64_decode(nullptr, 0, &outputLength, reinterpret_cast<const unsigned char*>(text.data()), text.size());
+      mbedtls_base64_decode(rawBuffer.data(), rawBuffer.size(), &outputLength, reinterpret_cast<const unsigned char*>(text.data()),
+                            text.size());
+    });
+    const double rawCodecDecodeMbps = measureMegabytesPerSecond(text.size(), options.minMs, [&]() {
+      size_t outputLength = 0;
+      base64Codec::decode(text.data(), text.size(), rawBuffer.data(), rawBuffer.size(), &outputLength);
+    });
+    // String → vector の置換前後（呼出し元から見た処理）
+    const double legacyDecodeMbps = measureMegabytesPerSecond(text.size(), options.minMs, [&]() { legacyDecode(textString, &decodedBytes); });
+    const double codecDecodeMbps =
+        measureMegabytesPerSecond(text.size(), options.minMs, [&]() { base64Codec::decodeToBytes(textString, &decodedBytes); });
+    printf("%8zu %9.1f MB/s %9.1f MB/s %9.1f MB/s %9.1f MB/s %9.1f MB/s %9.1f MB/s\n", size, legacyEncodeMbps, codecEncodeMbps,
+           rawMbedtlsDecodeMbps, rawCodecDecodeMbps, legacyDecodeMbps, codecDecodeMbps);
+  }
+  printf("(enc legacy / dec legacy = 置換前の呼出し手順、enc codec / dec toBytes = base64Codec の String / vector 版、\n"
+         " dec mbedtls / dec codec = 確保済みバッファへの復号のみ)\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmarkOptions options;
+  if (!parseOptions(argc, argv, &options)) {
+    return 2;
+  }
+  std::mt19937 random(options.seed);
+
+  printf("=== base64Benchmark report ===\n");
+  for (size_t size = 0; size <= 1024; ++size) {
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& value : bytes) {
+      value = static_cast<uint8_t>(random());
+    }
+    checkRoundTrip(bytes, &random);
+  }
+  const size_t largeSizes[] = {4095, 4096, 65537};
+  for (const size_t size : largeSizes) {
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& value : bytes) {
+      value = static_cast<uint8_t>(random());
+    }
+    checkRoundTrip(bytes, &random);
+  }
+  checkInvalidInputs();
+  printf("round trip checks failures=%u\n", static_cast<unsigned>(failureCount));
+
+  if (!options.isQuick) {
+    runBenchmarks(options, &random);
+  }
+  const bool isPassed = failureCount == 0;
+  printf("result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file brokerStandIn.cpp
+ * @brief フリートシミュレータ用のMQTTブローカー代替実装。
+ * @details
+ * - [重要] 処理は単一サーバFIFOとしてモデル化する（到着=publish+片道遅延、処理=1/maxMessagesPerSecond）。
+ * - [重要] 片道遅延とサービス時間が一定のため配送予定時刻は単調増加し、deque 末尾追加で順序を保てる。
+ */
+
+#include "brokerStandIn.h"
+
+#include <algorithm>
+
+#include "log.h"
+
+brokerStandIn::brokerStandIn(const brokerStandInConfig& config)
+    : config_(config), lastServiceEndUs_(0), stats_{} {}
+
+bool brokerStandIn::subscribe(const std::string& topicFilter, deliveryHandler handler) {
+  if (topicFilter.empty() || !handler) {
+    appLogError("brokerStandIn::subscribe failed. topicFilter=%s handler=%d",
+                topicFilter.c_str(),
+                handler ? 1 : 0);
+    return false;
+  }
+  const size_t hashPosition = topicFilter.find('#');
+  if (hashPosition != std::string::npos && hashPosition != topicFilter.size() - 1) {
+    appLogError("brokerStandIn::subscribe failed. '#' must be the last level. topicFilter=%s", topicFilter.c_str());
+    return false;
+  }
+  subscriptions_.push_back(subscription{topicFilter, handler});
+  return true;
+}
+
+bool brokerStandIn::publish(brokerMessage message) {
+  if (message.topic.empty() ||
+      message.topic.find('+') != std::string::npos ||
+      message.topic.find('#') != std::string::npos) {
+    appLogError("brokerStandIn::publish failed. invalid topic=%s", message.topic.c_str());
+    return false;
+  }
+
+  const uint64_t arrivalAtUs = message.publishedAtUs + config_.oneWayLatencyUs;
+  const uint64_t serviceTimeUs =
+      (config_.maxMessagesPerSecond > 0.0) ? static_cast<uint64_t>(1000000.0 / config_.maxMessagesPerSecond) : 0;
+  const uint64_t serviceStartUs = std::max(arrivalAtUs, lastServiceEndUs_);
+  lastServiceEndUs_ = serviceStartUs + serviceTimeUs;
+
+  stats_.acceptedCount += 1;
+  stats_.acceptedPayloadBytes += message.payload.size();
+  stats_.maxQueueWaitUs = std::max(stats_.maxQueueWaitUs, serviceStartUs - arrivalAtUs);
+
+  pendingDeliveries_.push_back(pendingDelivery{std::move(message), lastServiceEndUs_ + config_.oneWayLatencyUs});
+  stats_.maxQueueDepth = std::max(stats_.maxQueueDepth, pendingDeliveries_.size());
+  return true;
+}
+
+bool brokerStandIn::peekNextDeliveryTime(uint64_t* nextDeliveryAtUsOut) const {
+  if (nextDeliveryAtUsOut == nullptr) {
+    appLogError("brokerStandIn::peekNextDeliveryTime failed. nextDeliveryAtUsOut is null.");
+    return false;
+  }
+  if (pendingDeliveries_.empty()) {
+    return false;
+  }
+  *nextDeliveryAtUsOut = pendingDeliveries_.front().deliverAtUs;
+  return true;
+}
+
+size_t brokerStandIn::deliverDue(uint64_t nowUs) {
+  size_t deliveredMessageCount = 0;
+  while (!pendingDeliveries_.empty() && pendingDeliveries_.front().deliverAtUs <= nowUs) {
+    // [重要] 配送コールバック内で publish（コマンド応答等）されても壊れないよう、先に取り出す。
+    pendingDelivery delivery = std::move(pendingDeliveries_.front());
+    pendingDeliveries_.pop_front();
+
+    bool hasSubscriber = false;
+    for (const subscription& currentSubscription : subscriptions_) {
+      if (!matchTopicFilter(currentSubscription.topicFilter, delivery.message.topic)) {
+        continue;
+      }
+      hasSubscriber = true;
+      stats_.deliveredCount += 1;
+      currentSubscription.handler(delivery.message, delivery.deliverAtUs);
+    }
+    if (!hasSubscriber) {
+      stats_.droppedNoSubscriberCount += 1;
+    }
+    ++deliveredMessageCount;
+  }
+  return deliveredMessageCount;
+}
+
+bool brokerStandIn::matchTopicFilter(const std::string& topicFilter, const std::string& topicName) {
+  size_t filterIndex = 0;
+  size_t topicIndex = 0;
+  while (filterIndex < topicFilter.size()) {
+    const size_t filterLevelEnd = std::min(topicFilter.find('/', filterIndex), topicFilter.size());
+    const std::string filterLevel = topicFilter.substr(filterIndex, filterLevelEnd - filterIndex);
+    if (filterLevel == "#") {
+      return true;
+    }
+    if (topicIndex > topicName.size()) {
+      return false;
+    }
+    const size_t topicLevelEnd = std::min(topicName.find('/', topicIndex), topicName.size());
+    if (filterLevel != "+" &&
+        topicName.compare(topicIndex, topicLevelEnd - topicIndex, filterLevel) != 0) {
+      return false;
+    }
+    filterIndex = filterLevelEnd + 1;
+    topicIndex = topicLevelEnd + 1;
+  }
+  return topicIndex > topicName.size();
+}
@@ -0,0 +1,128 @@
+/**
+ * @file brokerStandIn.h
+ * @brief フリートシミュレータ用のMQTTブローカー代替（プロセス内トピックルータ）定義。
+ * @details
+ * - [重要] Mosquitto の代わりに、publish を仮想時刻付きFIFOへ積み、処理能力と片道遅延をモデル化して配送する。
+ * - [重要] トピックフィルタは MQTT 3.1.1 と同じく `+`（1階層）/ `#`（以下全階層）を解釈する。
+ * - [制限] QoS/retain/セッションは扱わない。QoSは全て at-most-once 相当とする。
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief ブローカー代替の性能モデル設定。
+ */
+struct brokerStandInConfig {
+  /** @brief ブローカーの最大処理件数/秒。0以下なら無制限。@type double */
+  double maxMessagesPerSecond;
+  /** @brief クライアント→ブローカー、ブローカー→クライアントそれぞれの片道遅延(us)。@type uint64_t */
+  uint64_t oneWayLatencyUs;
+};
+
+/**
+ * @brief ブローカー内を流れる1メッセージ。
+ */
+struct brokerMessage {
+  /** @brief トピック。@type std::string */
+  std::string topic;
+  /** @brief payload本文。@type std::string */
+  std::string payload;
+  /** @brief retainフラグ（統計用のみ）。@type bool */
+  bool retained;
+  /** @brief publish時刻（仮想時刻us）。@type uint64_t */
+  uint64_t publishedAtUs;
+};
+
+/**
+ * @brief ブローカー代替の累積統計。
+ */
+struct brokerStandInStats {
+  /** @brief 受理したpublish件数。@type uint64_t */
+  uint64_t acceptedCount;
+  /** @brief 購読者へ配送した件数（購読者数分カウント）。@type uint64_t */
+  uint64_t deliveredCount;
+  /** @brief 購読者不在で破棄した件数。@type uint64_t */
+  uint64_t droppedNoSubscriberCount;
+  /** @brief 受理したpayload総バイト数。@type uint64_t */
+  uint64_t acceptedPayloadBytes;
+  /** @brief キュー滞留件数の最大値。@type size_t */
+  size_t maxQueueDepth;
+  /** @brief ブローカー内待ち時間(us)の最大値。@type uint64_t */
+  uint64_t maxQueueWaitUs;
+};
+
+/**
+ * @brief MQTTブローカー代替。
+ */
+class brokerStandIn {
+ public:
+  /** @brief 配送コールバック。引数は配送メッセージと配送時刻(仮想us)。 */
+  using deliveryHandler = std::function<void(const brokerMessage&, uint64_t)>;
+
+  explicit brokerStandIn(const brokerStandInConfig& config);
+
+  /**
+   * @brief トピックフィルタを購読する。
+   * @param topicFilter 購読フィルタ（`+` / `#` 可）。
+   * @param handler 配送コールバック。
+   * @return 購読成功時true、フィルタ不正時false。
+   */
+  bool subscribe(const std::string& topicFilter, deliveryHandler handler);
+
+  /**
+   * @brief publishを受理し、配送予定時刻を計算してキューへ積む。
+   * @param message 送信メッセージ（publishedAtUs 設定済みであること）。
+   * @return 受理時true、トピック不正時false。
+   */
+  bool publish(brokerMessage message);
+
+  /**
+   * @brief 次の配送予定時刻を返す。
+   * @param nextDeliveryAtUsOut 出力先（null不可）。
+   * @return 配送待ちがある場合true。
+   */
+  bool peekNextDeliveryTime(uint64_t* nextDeliveryAtUsOut) const;
+
+  /**
+   * @brief 指定時刻までに配送予定のメッセージを購読者へ配送する。
+   * @param nowUs 現在の仮想時刻(us)。
+   * @return 配送したメッセージ件数（購読者数分ではなくメッセージ単位）。
+   */
+  size_t deliverDue(uint64_t nowUs);
+
+  /** @brief 累積統計を返す。 */
+  const brokerStandInStats& stats() const { return stats_; }
+
+  /**
+   * @brief MQTT 3.1.1 のトピックフィルタ一致判定。
+   * @param topicFilter 購読フィルタ。
+   * @param topicName 実トピック。
+   * @return 一致時true。
+   */
+  static bool matchTopicFilter(const std::string& topicFilter, const std::string& topicName);
+
+ private:
+  struct pendingDelivery {
+    brokerMessage message;
+    uint64_t deliverAtUs;
+  };
+  struct subscription {
+    std::string topicFilter;
+    deliveryHandler handler;
+  };
+
+  brokerStandInConfig config_;
+  std::deque<pendingDelivery> pendingDeliveries_;
+  std::vector<subscription> subscriptions_;
+  /** @brief 直前メッセージのブローカー処理完了時刻(us)。 */
+  uint64_t lastServiceEndUs_;
+  brokerStandInStats stats_;
+};
@@ -0,0 +1,298 @@
+/**
+ * @file externalDeviceScenario.cpp
+ * @brief 外部デバイスのドライバ枠組み（src/externalDevice.cpp）をホストで動かす検証シナリオ。
+ * @details
+ * - [重要] ファームウェアの externalDevice を無改変でリンクし、次を確認する。
+ *   - decodeBme280 がデータシートの計算例（校正値 + adc_T=519888 / adc_P=415148）で 25.08 degC / 100653 Pa を返すこと
+ *   - 未測定値（0x80000）を変換失敗として返すこと
+ *   - buildBurstPlans が隙間4byte以下の範囲を併合し、32byte超・範囲数超過・不正長を正しく扱うこと
+ *   - runDueDevices がレジスタを模した BME280 から探索・校正値読取・測定を行い、スナップショットへ公開すること
+ * - [重要] バスは `externalDeviceBus` を実装した模擬デバイスで、発行したトランザクションを記録して照合する。
+ * - 判定に失敗した場合は終了コード 1 を返す。
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "externalDevice.h"
+
+void setHostLogVerbose(bool verbose);
+
+namespace {
+
+/** @brief データシートの計算例の校正値（dig_T1..T3 / dig_P1..P9）。 */
+constexpr uint16_t kDatasheetDigT1 = 27504;
+constexpr int16_t kDatasheetDigT2 = 26435;
+constexpr int16_t kDatasheetDigT3 = -1000;
+constexpr uint16_t kDatasheetDigP1 = 36477;
+constexpr int16_t kDatasheetDigP2to9[] = {-10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+/** @brief データシートの計算例の生値。 */
+constexpr int32_t kDatasheetAdcT = 519888;
+constexpr int32_t kDatasheetAdcP = 415148;
+/** @brief 湿度の生値（校正値は実機で読んだ値の一例）。 */
+constexpr int32_t kSampleAdcH = 27000;
+/** @brief 期待値（データシート: 25.08 degC / 100653.27 Pa）。 */
+constexpr double kExpectedTemperatureC = 25.08;
+constexpr double kExpectedPressurePa = 100653.27;
+/** @brief 模擬 BME280 のアドレス（SDO=GND）。 */
+constexpr uint8_t kBme280Address = 0x76;
+/** @brief ドライバのバースト1回の最大長(byte)。externalDevice.cpp の kMaxBurstBytes と同じ。 */
+constexpr uint8_t kMaxBurstBytes = 32;
+
+/** @brief 判定失敗の件数。@type uint32_t */
+uint32_t failureCount = 0;
+
+void expect(bool condition, const char* caseName, const char* checkName) {
+  if (!condition) {
+    ++failureCount;
+    printf("FAIL %s %s\n", caseName, checkName);
+  }
+}
+
+void writeUint16Le(uint8_t* bytes, uint16_t value) {
+  bytes[0] = static_cast<uint8_t>(value & 0xFF);
+  bytes[1] = static_cast<uint8_t>(value >> 8);
+}
+
+/**
+ * @brief BME280 のレジスタ空間（0x00..0xFF）を模したバイト列を作る。
+ * @param adcT 温度の生値（20bit）。
+ * @param adcP 気圧の生値（20bit）。
+ * @param adcH 湿度の生値（16bit）。
+ */
+std::vector<uint8_t> buildBme280Registers(int32_t adcT, int32_t adcP, int32_t adcH) {
+  std::vector<uint8_t> registers(256, 0);
+  registers[0xD0] = 0x60;  // chip id
+  writeUint16Le(&registers[0x88], kDatasheetDigT1);
+  writeUint16Le(&registers[0x8A], static_cast<uint16_t>(kDatasheetDigT2));
+  writeUint16Le(&registers[0x8C], static_cast<uint16_t>(kDatasheetDigT3));
+  writeUint16Le(&registers[0x8E], kDatasheetDigP1);
+  for (size_t index = 0; index < sizeof(kDatasheetDigP2to9) / sizeof(kDatasheetDigP2to9[0]); ++index) {
+    writeUint16Le(&registers[0x90 + index * 2], static_cast<uint16_t>(kDatasheetDigP2to9[index]));
+  }
+  // 湿度の校正値: dig_H1=75, dig_H2=362, dig_H3=0, dig_H4=313, dig_H5=50, dig_H6=30
+  registers[0xA1] = 75;
+  writeUint16Le(&registers[0xE1], 362);
+  registers[0xE3] = 0;
+  registers[0xE4] = static_cast<uint8_t>(313 >> 4);
+  registers[0xE5] = static_cast<uint8_t>((313 & 0x0F) | ((50 & 0x0F) << 4));
+  registers[0xE6] = static_cast<uint8_t>(50 >> 4);
+  registers[0xE7] = 30;
+  // 測定値: press[3] / temp[3] / hum[2]（20bit 値は下位4bitを xlsb の上位へ置く）
+  registers[0xF7] = static_cast<uint8_t>(adcP >> 12);
+  registers[0xF8] = static_cast<uint8_t>(adcP >> 4);
+  registers[0xF9] = static_cast<uint8_t>((adcP & 0x0F) << 4);
+  registers[0xFA] = static_cast<uint8_t>(adcT >> 12);
+  registers[0xFB] = static_cast<uint8_t>(adcT >> 4);
+  registers[0xFC] = static_cast<uint8_t>((adcT & 0x0F) << 4);
+  registers[0xFD] = static_cast<uint8_t>(adcH >> 8);
+  registers[0xFE] = static_cast<uint8_t>(adcH & 0xFF);
+  return registers;
+}
+
+/**
+ * @brief レジスタ空間から decodeBme280 へ渡す校正値（0x88..0xA1 + 0xE1..0xE7）と測定値（0xF7..0xFE）を切り出す。
+ */
+void sliceBme280Buffers(const std::vector<uint8_t>& registers, uint8_t calibrationOut[33], uint8_t frameOut[8]) {
+  memcpy(&calibrationOut[0], &registers[0x88], 26);
+  memcpy(&calibrationOut[26], &registers[0xE1], 7);
+  memcpy(frameOut, &registers[0xF7], 8);
+}
+
+/**
+ * @brief BME280 1台を模したバス。発行した読取・書込みを記録する。
+ */
+class fakeBme280Bus : public externalDeviceBus {
+ public:
+  explicit fakeBme280Bus(std::vector<uint8_t> registers) : registers_(std::move(registers)) {}
+
+  bool probe(uint8_t address) override { return address == kBme280Address; }
+
+  bool writeRegister(uint8_t address, uint8_t registerAddress, uint8_t value) override {
+    if (address != kBme280Address) {
+      return false;
+    }
+    writes.push_back({registerAddress, value});
+    return true;
+  }
+
+  bool readRegisters(uint8_t address, uint8_t startRegister, uint8_t* bufferOut, uint8_t length) override {
+    if (address != kBme280Address || static_cast<uint16_t>(startRegister) + length > registers_.size()) {
+      return false;
+    }
+    memcpy(bufferOut, &registers_[startRegister], length);
+    reads.push_back({startRegister, length});
+    return true;
+  }
+
+  /** @brief 発行した読取（先頭番地と長さ）。@type std::vector<externalDeviceRegisterRange> */
+  std::vector<externalDeviceRegisterRange> reads;
+  /** @brief 発行した書込み（番地と値）。@type std::vector<std::pair<uint8_t, uint8_t>> */
+  std::vector<std::pair<uint8_t, uint8_t>> writes;
+
+ private:
+  std::vector<uint8_t> registers_;
+};
+
+/**
+ * @brief データシートの計算例で decodeBme280 が 25.08 degC / 100653 Pa を返すこと。
+ */
+void runDatasheetDecodeCase() {
+  const char* caseName = "bme280.datasheet";
+  uint8_t calibration[33] = {};
+  uint8_t frame[8] = {};
+  sliceBme280Buffers(buildBme280Registers(kDatasheetAdcT, kDatasheetAdcP, kSampleAdcH), calibration, frame);
+
+  externalDeviceReading reading{};
+  const bool isDecoded = externalDeviceDriver::decodeBme280(calibration, frame, &reading);
+  const double pressurePa = static_cast<double>(reading.values[2]) * 100.0;
+  expect(isDecoded, caseName, "decoded");
+  expect(reading.valueCount == 3, caseName, "valueCount");
+  expect(fabs(reading.values[0] - kExpectedTemperatureC) < 0.005, caseName, "temperature");
+  expect(fabs(pressurePa - kExpectedPressurePa) < 1.0, caseName, "pressure");
+  expect(reading.values[1] >= 0.0F && reading.values[1] <= 100.0F, caseName, "humidity range");
+  printf("%s decoded=%d temperatureC=%.2f pressurePa=%.2f humidityRh=%.2f\n",
+         caseName,
+         isDecoded ? 1 : 0,
+         static_cast<double>(reading.values[0]),
+         pressurePa,
+         static_cast<double>(reading.values[1]));
+}
+
+/**
+ * @brief 未測定値（リセット直後の 0x80000）を変換失敗として返すこと。
+ */
+void runSkippedMeasurementCase() {
+  const char* caseName = "bme280.skipped";
+  uint8_t calibration[33] = {};
+  uint8_t frame[8] = {};
+  sliceBme280Buffers(buildBme280Registers(0x80000, kDatasheetAdcP, kSampleAdcH), calibration, frame);
+  externalDeviceReading reading{};
+  const bool isTemperatureSkippedDecoded = externalDeviceDriver::decodeBme280(calibration, frame, &reading);
+  sliceBme280Buffers(buildBme280Registers(kDatasheetAdcT, 0x80000, kSampleAdcH), calibration, frame);
+  const bool isPressureSkippedDecoded = externalDeviceDriver::decodeBme280(calibration, frame, &reading);
+  expect(!isTemperatureSkippedDecoded, caseName, "temperature skipped");
+  expect(!isPressureSkippedDecoded, caseName, "pressure skipped");
+  printf("%s rejected=%d\n", caseName, (!isTemperatureSkippedDecoded && !isPressureSkippedDecoded) ? 1 : 0);
+}
+
+/**
+ * @brief buildBurstPlans の1ケース。
+ */
+struct burstPlanCase {
+  /** @brief ケース名。@type const char* */
+  const char* name;
+  /** @brief 読取範囲。@type std::vector<externalDeviceRegisterRange> */
+  std::vector<externalDeviceRegisterRange> ranges;
+  /** @brief 期待するバースト（空なら戻り値0を期待）。@type std::vector<externalDeviceDriver::burstPlan> */
+  std::vector<externalDeviceDriver::burstPlan> expectedBursts;
+};
+
+/**
+ * @brief buildBurstPlans の併合・分割・拒否。
+ */
+void runBurstPlanCases() {
+  const std::vector<burstPlanCase> cases = {
+      // 隙間2byte（<=4）は1バーストへ併合する
+      {"burstPlans.mergeGap", {{0x10, 4}, {0x16, 2}}, {{0x10, 8}}},
+      // 隙間ちょうど4byteも併合する
+      {"burstPlans.mergeGapLimit", {{0x10, 4}, {0x18, 2}}, {{0x10, 10}}},
+      // 隙間5byteは分ける
+      {"burstPlans.splitGap", {{0x10, 4}, {0x19, 2}}, {{0x10, 4}, {0x19, 2}}},
+      // 隣接・包含は1バーストのまま長さを延ばさない
+      {"burstPlans.contained", {{0x10, 8}, {0x12, 2}}, {{0x10, 8}}},
+      // 併合すると32byteを超える場合は分ける
+      {"burstPlans.splitOverMax", {{0x00, 30}, {0x1F, 4}}, {{0x00, 30}, {0x1F, 4}}},
+      // BME280 の校正値範囲（0x88/26 と 0xE1/7）は離れているため2バースト
+      {"burstPlans.bme280Calibration", {{0x88, 26}, {0xE1, 7}}, {{0x88, 26}, {0xE1, 7}}},
+      // 併合後も kExternalDeviceMaxRanges を超えるなら0
+      {"burstPlans.tooManyBursts", {{0x00, 1}, {0x10, 1}, {0x20, 1}, {0x30, 1}, {0x40, 1}}, {}},
+      // 長さ0・32byte超は0
+      {"burstPlans.zeroLength", {{0x10, 0}}, {}},
+      {"burstPlans.overMaxLength", {{0x10, static_cast<uint8_t>(kMaxBurstBytes + 1)}}, {}},
+  };
+  for (const burstPlanCase& planCase : cases) {
+    externalDeviceDriver::burstPlan bursts[kExternalDeviceMaxRanges] = {};
+    const uint8_t burstCount =
+        externalDeviceDriver::buildBurstPlans(planCase.ranges.data(), static_cast<uint8_t>(planCase.ranges.size()), bursts);
+    bool isMatched = (burstCount == planCase.expectedBursts.size());
+    for (size_t index = 0; isMatched && index < planCase.expectedBursts.size(); ++index) {
+      isMatched = bursts[index].startRegister == planCase.expectedBursts[index].startRegister &&
+                  bursts[index].length == planCase.expectedBursts[index].length;
+    }
+    expect(isMatched, planCase.name, "bursts");
+    printf("%s bursts=%u", planCase.name, static_cast<unsigned>(burstCount));
+    for (uint8_t index = 0; index < burstCount; ++index) {
+      printf(" 0x%02X/%u", static_cast<unsigned>(bursts[index].startRegister), static_cast<unsigned>(bursts[index].length));
+    }
+    printf("\n");
+  }
+}
+
+/**
+ * @brief runDueDevices が模擬 BME280 を探索・初期化・測定し、スナップショットへ公開すること。
+ */
+void runDriverCase() {
+  const char* caseName = "driver.bme280";
+  fakeBme280Bus bus(buildBme280Registers(kDatasheetAdcT, kDatasheetAdcP, kSampleAdcH));
+
+  const uint32_t waitMs = externalDeviceDriver::runDueDevices(bus, millis());
+  externalDeviceReading reading{};
+  const bool hasSnapshot = externalDeviceDriver::readSnapshot(externalDeviceId::kBme280, &reading);
+  const double pressurePa = static_cast<double>(reading.values[2]) * 100.0;
+
+  expect(hasSnapshot && reading.isValid, caseName, "snapshot valid");
+  expect(reading.address == kBme280Address, caseName, "address");
+  expect(reading.sampleCount == 1, caseName, "sampleCount");
+  expect(fabs(reading.values[0] - kExpectedTemperatureC) < 0.005, caseName, "temperature");
+  expect(fabs(pressurePa - kExpectedPressurePa) < 1.0, caseName, "pressure");
+  expect(waitMs > 0, caseName, "waitMs");
+
+  // 探索（chip id）→ 校正値2バースト → 測定値1バースト
+  const std::vector<std::pair<uint8_t, uint8_t>> expectedReads = {{0xD0, 1}, {0x88, 26}, {0xE1, 7}, {0xF7, 8}};
+  bool isReadSequenceMatched = bus.reads.size() == expectedReads.size();
+  for (size_t index = 0; isReadSequenceMatched && index < expectedReads.size(); ++index) {
+    isReadSequenceMatched = bus.reads[index].startRegister == expectedReads[index].first &&
+                            bus.reads[index].length == expectedReads[index].second;
+  }
+  expect(isReadSequenceMatched, caseName, "read sequence");
+  // 初期化手順の後に forced mode のトリガ（0xF4=0x25）を1回書く
+  expect(!bus.writes.empty() && bus.writes.back().first == 0xF4 && bus.writes.back().second == 0x25, caseName, "trigger");
+
+  printf("%s valid=%d address=0x%02X temperatureC=%.2f pressurePa=%.2f reads=%zu writes=%zu nextWaitMs=%u\n",
+         caseName,
+         reading.isValid ? 1 : 0,
+         static_cast<unsigned>(reading.address),
+         static_cast<double>(reading.values[0]),
+         pressurePa,
+         bus.reads.size(),
+         bus.writes.size(),
+         static_cast<unsigned>(waitMs));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--verbose") == 0) {
+    setHostLogVerbose(true);
+  } else if (argc > 1) {
+    printf("usage: %s [--verbose]\n", argv[0]);
+    return 2;
+  }
+
+  printf("=== externalDeviceScenario report ===\n");
+  runDatasheetDecodeCase();
+  runSkippedMeasurementCase();
+  runBurstPlanCases();
+  runDriverCase();
+
+  const bool isPassed = failureCount == 0;
+  printf("failures=%u\n", static_cast<unsigned>(failureCount));
+  printf("result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed ? 0 : 1;
+}
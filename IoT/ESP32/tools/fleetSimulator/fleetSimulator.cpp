@@ -0,0 +1,1394 @@
+/**
+ * @file fleetSimulator.cpp
+ * @brief ファームウェアのプロトコルモジュールをホストでビルドした仮想デバイス群（フリート）シミュレータ。
+ * @details
+ * - [重要] status payload は `mqtt::buildMqttStatusPayload`（src/MQTT/mqtt_status.cpp）、
+ *   暗号化エンベロープは `mqttPayloadSecurity`（src/MQTT/mqttPayloadSecurity.cpp）をそのまま使う。
+ * - [重要] trh / fileSyncStatus payload も `mqtt::buildTrhNoticePayload` / `mqtt::buildFileSyncStatusPayload`
+ *   （src/MQTT/mqtt_notice.cpp）で生成し、キー構成を本ファイルで再現しない。
+ * - [重要] 既定（オフライン）は仮想時刻の離散イベントループで動作し、実時間待機しない。数千台×数十分を数秒〜数十秒で処理する。
+ *   ブローカーは brokerStandIn（プロセス内トピックルータ）で処理能力と遅延をモデル化する。
+ * - [重要] `--broker host:port` 指定時（実ブローカーモード）は、端末ごとに実ソケット（hostShim の WiFiClient）と
+ *   ファームウェアと同じ `mqttAsyncClient` で MQTT 3.1.1 接続し、実時間で動作する。コマンドは実バックエンドから受ける。
+ * - [重要] 端末ごとに k-device 鍵・Base MAC・起動時刻（ブートストーム）・テレメトリ周期位相を持つ。
+ * - [制限] 実ブローカーモードは平文 TCP のみ（hostShim の WiFiClientSecure は常に接続失敗するため TLS 不可）。
+ * - [制限] fileSync の HMAC 署名検証と LittleFS 書き込みはモデル化しない（復号・JSON解釈・応答のみ）。
+ */
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "brokerStandIn.h"
+#include "common.h"
+#include "hostDeviceContext.h"
+#include "jsonService.h"
+#include "log.h"
+#include "mqttAsyncClient.h"
+#include "mqttMessages.h"
+#include "mqttPayloadSecurity.h"
+
+namespace {
+
+/**
+ * @brief コマンドライン設定。
+ */
+struct fleetSimulatorOptions {
+  /** @brief 仮想デバイス数。 */
+  uint32_t deviceCount = 1000;
+  /** @brief 仮想時間での実行秒数。 */
+  uint32_t durationSeconds = 600;
+  /** @brief ブートストームの幅（全台がこの秒数内に起動する）。 */
+  uint32_t bootWindowSeconds = 30;
+  /** @brief 定期status通知周期（main.cppの周期通知と同じ30秒が既定）。 */
+  uint32_t statusIntervalSeconds = 30;
+  /** @brief trh通知周期。 */
+  uint32_t trhIntervalSeconds = 300;
+  /** @brief バックエンドからのstatus要求間隔ms（フリート全体で1件ずつ、0で無効）。 */
+  uint32_t commandIntervalMs = 1000;
+  /** @brief バックエンドからのfileSyncChunk送信間隔ms（0で無効）。 */
+  uint32_t fileSyncIntervalMs = 0;
+  /** @brief fileSyncChunk の生データサイズ（base64化前）。 */
+  uint32_t fileSyncChunkBytes = 1024;
+  /** @brief ブローカー処理能力（件/秒）。 */
+  double brokerMessagesPerSecond = 5000.0;
+  /** @brief 片道ネットワーク遅延ms。 */
+  double oneWayLatencyMs = 2.0;
+  /** @brief 暗号化エンベロープを使うか（MQTT_PAYLOAD_SECURITY_MODE=strict 相当）。 */
+  bool isSecure = true;
+  /** @brief 乱数シード（鍵・MAC・起動時刻の再現用）。 */
+  uint32_t seed = 1;
+  /** @brief INFOログも出力するか。 */
+  bool isVerbose = false;
+  /** @brief 実ブローカーのホスト（空なら brokerStandIn を使うオフライン動作）。 */
+  std::string brokerHost;
+  /** @brief 実ブローカーのポート。 */
+  uint16_t brokerPort = 1883;
+  /** @brief 実ブローカーのユーザー名（空なら送らない）。 */
+  std::string mqttUserName;
+  /** @brief 実ブローカーのパスワード（空なら送らない）。 */
+  std::string mqttPassword;
+  /** @brief 端末名と k-device 鍵の出力先（実バックエンドへの登録用、空なら出力しない）。 */
+  std::string keysOutPath;
+};
+
+/**
+ * @brief 仮想時刻イベント種別。
+ */
+enum class fleetEventType : uint8_t {
+  kBoot = 1,
+  kStatusTick = 2,
+  kTrhTick = 3,
+  kBackendStatusRequest = 4,
+  kBackendFileSyncChunk = 5,
+  kLiveReconnect = 6,
+};
+
+/**
+ * @brief イベントキュー要素。
+ */
+struct fleetEvent {
+  uint64_t atUs;
+  uint64_t sequence;
+  fleetEventType eventType;
+  uint32_t deviceIndex;
+};
+
+/**
+ * @brief 時刻→投入順で取り出すための比較関数（priority_queueは最大ヒープのため逆順）。
+ */
+struct fleetEventLater {
+  bool operator()(const fleetEvent& left, const fleetEvent& right) const {
+    if (left.atUs != right.atUs) {
+      return left.atUs > right.atUs;
+    }
+    return left.sequence > right.sequence;
+  }
+};
+
+class fleetSimulator;
+
+/**
+ * @brief 実ブローカーモードでの端末1台分の MQTT セッション。
+ */
+struct liveMqttSession {
+  /** @brief 所有シミュレータ（受信コールバックの戻り先）。 */
+  fleetSimulator* owner = nullptr;
+  /** @brief 端末番号。 */
+  uint32_t deviceIndex = 0;
+  /** @brief TCP 接続（hostShim の POSIX ソケット実装）。 */
+  WiFiClient socket;
+  /** @brief ファームウェアと同じ非同期 MQTT クライアント。 */
+  mqttAsync::mqttAsyncClient client;
+  /** @brief CONNECT 送信時刻（0=セッションなし）。 */
+  uint64_t connectStartedAtUs = 0;
+  /** @brief CONNACK(0) 受信済みか。 */
+  bool isSessionUp = false;
+  /** @brief 一度でも接続できたか（周期通知の開始判定）。 */
+  bool hasEverConnected = false;
+  /** @brief QoS1 publish の packet id ごとの publish 時刻。 */
+  std::map<uint16_t, uint64_t> publishedAtUsByPacketId;
+};
+
+/**
+ * @brief 仮想デバイス1台分の状態。
+ */
+struct virtualDevice {
+  hostDeviceContext context;
+  std::vector<uint8_t> keyBytes;
+  std::string nodeName;
+  uint64_t bootAtUs;
+  PubSubClient client;
+  bool isBooted;
+  /** @brief バックエンドが送った未応答status要求の送信時刻（0=なし）。 */
+  uint64_t pendingStatusRequestAtUs;
+  /** @brief バックエンドが送った未応答fileSyncChunkの送信時刻（0=なし）。 */
+  uint64_t pendingFileSyncAtUs;
+  /** @brief 実ブローカーモードのセッション（オフライン時は null）。 */
+  std::unique_ptr<liveMqttSession> live;
+};
+
+/**
+ * @brief 遅延サンプル集計。
+ */
+class latencyRecorder {
+ public:
+  void add(uint64_t valueUs) { samplesUs_.push_back(valueUs); }
+  size_t count() const { return samplesUs_.size(); }
+
+  /**
+   * @brief パーセンタイル値をmsで返す。
+   * @param percentile 0-100。
+   * @return サンプルなしの場合0。
+   */
+  double percentileMs(double percentile) {
+    if (samplesUs_.empty()) {
+      return 0.0;
+    }
+    if (!isSorted_) {
+      std::sort(samplesUs_.begin(), samplesUs_.end());
+      isSorted_ = true;
+    }
+    const size_t index = std::min(samplesUs_.size() - 1,
+                                  static_cast<size_t>(percentile / 100.0 * static_cast<double>(samplesUs_.size())));
+    return static_cast<double>(samplesUs_[index]) / 1000.0;
+  }
+
+ private:
+  std::vector<uint64_t> samplesUs_;
+  bool isSorted_ = false;
+};
+
+/**
+ * @brief シミュレーション全体の集計値。
+ */
+struct fleetReport {
+  uint64_t publishedCount = 0;
+  uint64_t publishedBytes = 0;
+  uint64_t buildFailureCount = 0;
+  uint64_t decodeFailureCount = 0;
+  uint64_t commandSentCount = 0;
+  uint64_t commandSkippedBusyCount = 0;
+  std::map<std::string, uint64_t> publishedCountByKind;
+  std::map<std::string, latencyRecorder> deliveryLatencyByKind;
+  latencyRecorder statusRoundTrip;
+  latencyRecorder fileSyncRoundTrip;
+  latencyRecorder deviceBuildWallUs;
+  latencyRecorder backendDecodeWallUs;
+  uint64_t liveConnectedCount = 0;
+  uint64_t liveConnectFailureCount = 0;
+  uint64_t liveDisconnectCount = 0;
+  uint64_t livePublishRejectedCount = 0;
+  std::map<std::string, uint64_t> liveCommandCountBySub;
+  latencyRecorder liveConnackLatency;
+  latencyRecorder livePubackLatency;
+};
+
+constexpr uint64_t kMicrosPerSecond = 1000000ULL;
+constexpr const char* kBackendName = "LocalServer";
+/** @brief 実ブローカーモードの再接続間隔。 */
+constexpr uint64_t kLiveReconnectDelayUs = 5ULL * kMicrosPerSecond;
+/** @brief 実ブローカーモード終了時に DISCONNECT を送り切るまでの上限。 */
+constexpr uint64_t kLiveShutdownTimeoutUs = 2ULL * kMicrosPerSecond;
+
+/**
+ * @brief WiFiClient を mqttAsyncClient の通信路として書き込む（実機の arduinoClientWrite と同じ判定）。
+ */
+int32_t hostClientWrite(void* context, const uint8_t* data, size_t length) {
+  WiFiClient* client = static_cast<WiFiClient*>(context);
+  if (!client->connected()) {
+    return -1;
+  }
+  const size_t writtenLength = client->write(data, length);
+  if (writtenLength == 0 && !client->connected()) {
+    return -1;
+  }
+  return static_cast<int32_t>(writtenLength);
+}
+
+/**
+ * @brief WiFiClient から読める分だけ読む（実機の arduinoClientRead と同じ判定）。
+ */
+int32_t hostClientRead(void* context, uint8_t* bufferOut, size_t capacity) {
+  WiFiClient* client = static_cast<WiFiClient*>(context);
+  const int availableLength = client->available();
+  if (availableLength <= 0) {
+    return client->connected() ? 0 : -1;
+  }
+  const size_t readLength = static_cast<size_t>(availableLength) < capacity ? static_cast<size_t>(availableLength)
+                                                                            : capacity;
+  const int readResult = client->read(bufferOut, readLength);
+  if (readResult < 0) {
+    return client->connected() ? 0 : -1;
+  }
+  return static_cast<int32_t>(readResult);
+}
+
+/**
+ * @brief 引数文字列を数値へ変換する。
+ * @return 変換成功時true。
+ */
+bool parseUnsignedOption(const char* text, uint32_t* valueOut) {
+  if (text == nullptr || valueOut == nullptr) {
+    appLogError("parseUnsignedOption failed. text=%p valueOut=%p", text, valueOut);
+    return false;
+  }
+  char* endPointer = nullptr;
+  const unsigned long parsedValue = strtoul(text, &endPointer, 10);
+  if (endPointer == text || *endPointer != '\0') {
+    appLogError("parseUnsignedOption failed. not a number. text=%s", text);
+    return false;
+  }
+  *valueOut = static_cast<uint32_t>(parsedValue);
+  return true;
+}
+
+bool parseDoubleOption(const char* text, double* valueOut) {
+  if (text == nullptr || valueOut == nullptr) {
+    appLogError("parseDoubleOption failed. text=%p valueOut=%p", text, valueOut);
+    return false;
+  }
+  char* endPointer = nullptr;
+  const double parsedValue = strtod(text, &endPointer);
+  if (endPointer == text || *endPointer != '\0') {
+    appLogError("parseDoubleOption failed. not a number. text=%s", text);
+    return false;
+  }
+  *valueOut = parsedValue;
+  return true;
+}
+
+/**
+ * @brief `host[:port]` を分解する（ポート省略時は 1883）。
+ * @return 分解成功時true。
+ */
+bool parseBrokerAddressOption(const char* text, std::string* hostOut, uint16_t* portOut) {
+  if (text == nullptr || hostOut == nullptr || portOut == nullptr) {
+    appLogError("parseBrokerAddressOption failed. text=%p hostOut=%p portOut=%p", text, hostOut, portOut);
+    return false;
+  }
+  const std::string addressText = text;
+  const size_t colonIndex = addressText.rfind(':');
+  uint32_t portValue = 1883;
+  if (colonIndex != std::string::npos &&
+      (!parseUnsignedOption(addressText.substr(colonIndex + 1).c_str(), &portValue) || portValue == 0 || portValue > 65535)) {
+    appLogError("parseBrokerAddressOption failed. invalid port. text=%s", text);
+    return false;
+  }
+  *hostOut = addressText.substr(0, colonIndex);
+  if (hostOut->empty()) {
+    appLogError("parseBrokerAddressOption failed. host is empty. text=%s", text);
+    return false;
+  }
+  *portOut = static_cast<uint16_t>(portValue);
+  return true;
+}
+
+void printUsage(const char* programName) {
+  printf("usage: %s [options]\n"
+         "  --devices N              virtual device count (default 1000)\n"
+         "  --duration-s N           simulated seconds (default 600)\n"
+         "  --boot-window-s N        boot storm window seconds (default 30)\n"
+         "  --status-interval-s N    periodic status notice interval (default 30)\n"
+         "  --trh-interval-s N       trh notice interval (default 300)\n"
+         "  --command-interval-ms N  backend call/status request interval, 0=off (default 1000)\n"
+         "  --filesync-interval-ms N backend call/fileSyncChunk interval, 0=off (default 0)\n"
+         "  --filesync-chunk-bytes N fileSyncChunk raw bytes before base64 (default 1024)\n"
+         "  --broker-rate N          broker messages per second, 0=unlimited (default 5000)\n"
+         "  --latency-ms X           one-way network latency ms (default 2)\n"
+         "  --plain                  disable AES-256-GCM payload envelope\n"
+         "  --seed N                 random seed (default 1)\n"
+         "  --verbose                print firmware INFO logs\n"
+         "  --broker HOST[:PORT]     connect every device to a real MQTT 3.1.1 broker in real time (plain TCP)\n"
+         "  --mqtt-user NAME         broker user name (live mode)\n"
+         "  --mqtt-pass TEXT         broker password (live mode)\n"
+         "  --keys-out FILE          write nodeName,k-device hex per device for backend provisioning\n",
+         programName);
+}
+
+/**
+ * @brief コマンドライン引数を解析する。
+ * @return 解析成功時true。--help 時や不正引数時false。
+ */
+bool parseOptions(int argc, char** argv, fleetSimulatorOptions* optionsOut) {
+  if (optionsOut == nullptr) {
+    appLogError("parseOptions failed. optionsOut is null.");
+    return false;
+  }
+  for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex) {
+    const std::string argument = argv[argumentIndex];
+    const char* nextValue = (argumentIndex + 1 < argc) ? argv[argumentIndex + 1] : nullptr;
+    bool parseResult = true;
+    if (argument == "--devices") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->deviceCount);
+      ++argumentIndex;
+    } else if (argument == "--duration-s") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->durationSeconds);
+      ++argumentIndex;
+    } else if (argument == "--boot-window-s") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->bootWindowSeconds);
+      ++argumentIndex;
+    } else if (argument == "--status-interval-s") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->statusIntervalSeconds);
+      ++argumentIndex;
+    } else if (argument == "--trh-interval-s") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->trhIntervalSeconds);
+      ++argumentIndex;
+    } else if (argument == "--command-interval-ms") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->commandIntervalMs);
+      ++argumentIndex;
+    } else if (argument == "--filesync-interval-ms") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->fileSyncIntervalMs);
+      ++argumentIndex;
+    } else if (argument == "--filesync-chunk-bytes") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->fileSyncChunkBytes);
+      ++argumentIndex;
+    } else if (argument == "--broker-rate") {
+      parseResult = parseDoubleOption(nextValue, &optionsOut->brokerMessagesPerSecond);
+      ++argumentIndex;
+    } else if (argument == "--latency-ms") {
+      parseResult = parseDoubleOption(nextValue, &optionsOut->oneWayLatencyMs);
+      ++argumentIndex;
+    } else if (argument == "--seed") {
+      parseResult = parseUnsignedOption(nextValue, &optionsOut->seed);
+      ++argumentIndex;
+    } else if (argument == "--broker") {
+      parseResult = parseBrokerAddressOption(nextValue, &optionsOut->brokerHost, &optionsOut->brokerPort);
+      ++argumentIndex;
+    } else if (argument == "--mqtt-user") {
+      parseResult = (nextValue != nullptr);
+      optionsOut->mqttUserName = parseResult ? nextValue : "";
+      ++argumentIndex;
+    } else if (argument == "--mqtt-pass") {
+      parseResult = (nextValue != nullptr);
+      optionsOut->mqttPassword = parseResult ? nextValue : "";
+      ++argumentIndex;
+    } else if (argument == "--keys-out") {
+      parseResult = (nextValue != nullptr);
+      optionsOut->keysOutPath = parseResult ? nextValue : "";
+      ++argumentIndex;
+    } else if (argument == "--plain") {
+      optionsOut->isSecure = false;
+    } else if (argument == "--verbose") {
+      optionsOut->isVerbose = true;
+    } else {
+      if (argument != "--help" && argument != "-h") {
+        appLogError("parseOptions failed. unknown argument=%s", argument.c_str());
+      }
+      printUsage(argv[0]);
+      return false;
+    }
+    if (!parseResult) {
+      appLogError("parseOptions failed. invalid value. argument=%s", argument.c_str());
+      return false;
+    }
+  }
+  if (optionsOut->deviceCount == 0 || optionsOut->statusIntervalSeconds == 0 || optionsOut->trhIntervalSeconds == 0) {
+    appLogError("parseOptions failed. devices/status-interval/trh-interval must be > 0.");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 経過実時間(us)を返す計測補助。
+ */
+uint64_t measureWallUs(const std::chrono::steady_clock::time_point& startedAt) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startedAt).count());
+}
+
+/**
+ * @brief トピック `esp32lab/<kind>/<sub>/<name>` を分解する。
+ * @return 4階層で分解できた場合true。
+ */
+bool splitTopic(const std::string& topic, std::string* kindOut, std::string* subOut, std::string* nameOut) {
+  if (kindOut == nullptr || subOut == nullptr || nameOut == nullptr) {
+    appLogError("splitTopic failed. output is null. topic=%s", topic.c_str());
+    return false;
+  }
+  std::vector<std::string> levels;
+  size_t beginIndex = 0;
+  while (beginIndex <= topic.size()) {
+    const size_t endIndex = std::min(topic.find('/', beginIndex), topic.size());
+    levels.push_back(topic.substr(beginIndex, endIndex - beginIndex));
+    beginIndex = endIndex + 1;
+  }
+  if (levels.size() != 4 || levels[0] != "esp32lab") {
+    return false;
+  }
+  *kindOut = levels[1];
+  *subOut = levels[2];
+  *nameOut = levels[3];
+  return true;
+}
+
+/**
+ * @brief 仮想デバイス群・バックエンド・ブローカー代替をまとめたシミュレータ。
+ */
+class fleetSimulator {
+ public:
+  explicit fleetSimulator(const fleetSimulatorOptions& options)
+      : options_(options),
+        broker_(brokerStandInConfig{options.brokerMessagesPerSecond,
+                                    static_cast<uint64_t>(options.oneWayLatencyMs * 1000.0)}),
+        randomEngine_(options.seed),
+        nowUs_(0),
+        eventSequence_(0) {}
+
+  /**
+   * @brief 仮想デバイスを生成し、購読と初期イベントを登録する。
+   * @return 成功時true。
+   */
+  bool initialize() {
+    devices_.resize(options_.deviceCount);
+    std::uniform_int_distribution<uint32_t> byteDistribution(0, 255);
+    std::uniform_int_distribution<uint64_t> bootDistribution(
+        0, static_cast<uint64_t>(options_.bootWindowSeconds) * kMicrosPerSecond);
+    std::uniform_int_distribution<int32_t> rssiDistribution(-85, -40);
+    for (uint32_t deviceIndex = 0; deviceIndex < options_.deviceCount; ++deviceIndex) {
+      virtualDevice& device = devices_[deviceIndex];
+      // [重要] Espressif OUI(24:0A:C4)配下に連番で割り当て、IoT_<MAC> の一意性を保つ。
+      device.context.efuseMac = 0x240AC4000000ULL | static_cast<uint64_t>(deviceIndex + 1);
+      device.context.cpuMillis = 0;
+      device.context.isWifiConnected = true;
+      device.context.wifiSsid = "fleet-sim";
+      device.context.ipv4Address = 0x0A000000U | ((deviceIndex + 2) & 0x00FFFFFFU);
+      device.context.rssi = rssiDistribution(randomEngine_);
+      device.context.runningPartitionIndex = static_cast<uint8_t>(deviceIndex & 0x01);
+      device.keyBytes.resize(32);
+      for (uint8_t& keyByte : device.keyBytes) {
+        keyByte = static_cast<uint8_t>(byteDistribution(randomEngine_));
+      }
+      char nodeNameBuffer[24] = {};
+      snprintf(nodeNameBuffer, sizeof(nodeNameBuffer), "IoT_%012llX",
+               static_cast<unsigned long long>(device.context.efuseMac));
+      device.nodeName = nodeNameBuffer;
+      device.bootAtUs = bootDistribution(randomEngine_);
+      device.isBooted = false;
+      device.pendingStatusRequestAtUs = 0;
+      device.pendingFileSyncAtUs = 0;
+      device.client.setPublishHandler([this](const char* topic, const char* payload, bool retained) {
+        return broker_.publish(brokerMessage{topic, payload, retained, nowUs_});
+      });
+      if (isLiveMode() && !createLiveSession(deviceIndex)) {
+        return false;
+      }
+      deviceIndexByName_[device.nodeName] = deviceIndex;
+      scheduleEvent(device.bootAtUs, fleetEventType::kBoot, deviceIndex);
+    }
+
+    if (!options_.keysOutPath.empty() && !writeDeviceKeys()) {
+      return false;
+    }
+    if (isLiveMode()) {
+      // [重要] 実ブローカーモードではコマンドを実バックエンドが送るため、バックエンド役とブローカー代替は使わない。
+      if (!WiFi.hostByName(options_.brokerHost.c_str(), brokerAddress_)) {
+        appLogError("fleetSimulator::initialize failed. hostByName failed. host=%s", options_.brokerHost.c_str());
+        return false;
+      }
+      return true;
+    }
+
+    // [重要] 端末ごとに購読を積むと配送が O(台数) になるため、call を1購読で受けて宛先名で振り分ける。
+    bool subscribeResult =
+        broker_.subscribe("esp32lab/call/#",
+                          [this](const brokerMessage& message, uint64_t deliveredAtUs) {
+                            handleDeviceCommand(message, deliveredAtUs);
+                          }) &&
+        broker_.subscribe("esp32lab/notice/#", [this](const brokerMessage& message, uint64_t deliveredAtUs) {
+          handleBackendNotice(message, deliveredAtUs);
+        });
+    if (!subscribeResult) {
+      appLogError("fleetSimulator::initialize failed. broker subscribe failed.");
+      return false;
+    }
+
+    if (options_.commandIntervalMs > 0) {
+      scheduleEvent(static_cast<uint64_t>(options_.bootWindowSeconds) * kMicrosPerSecond,
+                    fleetEventType::kBackendStatusRequest,
+                    0);
+    }
+    if (options_.fileSyncIntervalMs > 0) {
+      scheduleEvent(static_cast<uint64_t>(options_.bootWindowSeconds) * kMicrosPerSecond,
+                    fleetEventType::kBackendFileSyncChunk,
+                    0);
+    }
+    return true;
+  }
+
+  /**
+   * @brief 仮想時刻が終了時刻へ達するまでイベントと配送を処理する（実ブローカーモードは実時間で処理する）。
+   */
+  void run() {
+    if (isLiveMode()) {
+      runLive();
+      return;
+    }
+    const uint64_t endUs = static_cast<uint64_t>(options_.durationSeconds) * kMicrosPerSecond;
+    const auto wallStartedAt = std::chrono::steady_clock::now();
+    simulationStartUtcMicros_ = static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                         std::chrono::system_clock::now().time_since_epoch())
+                                                         .count());
+    advanceClock(0);
+    for (;;) {
+      uint64_t nextDeliveryAtUs = 0;
+      const bool hasDelivery = broker_.peekNextDeliveryTime(&nextDeliveryAtUs);
+      const bool hasEvent = !eventQueue_.empty();
+      if (!hasDelivery && !hasEvent) {
+        break;
+      }
+      // [重要] 同時刻ならブローカー配送を先に処理し、応答待ちが遅れて見えないようにする。
+      if (hasDelivery && (!hasEvent || nextDeliveryAtUs <= eventQueue_.top().atUs)) {
+        if (nextDeliveryAtUs > endUs) {
+          break;
+        }
+        advanceClock(nextDeliveryAtUs);
+        broker_.deliverDue(nowUs_);
+        continue;
+      }
+      const fleetEvent event = eventQueue_.top();
+      if (event.atUs > endUs) {
+        break;
+      }
+      eventQueue_.pop();
+      advanceClock(event.atUs);
+      handleEvent(event);
+    }
+    wallElapsedUs_ = measureWallUs(wallStartedAt);
+  }
+
+  /**
+   * @brief 集計結果を標準出力へ表示する。
+   */
+  void printReport() {
+    const double simulatedSeconds = static_cast<double>(options_.durationSeconds);
+    const double wallSeconds = static_cast<double>(wallElapsedUs_) / static_cast<double>(kMicrosPerSecond);
+    const brokerStandInStats& brokerStats = broker_.stats();
+    printf("=== fleetSimulator report ===\n");
+    if (isLiveMode()) {
+      printf("devices=%u duration=%us bootWindow=%us secure=%s broker=%s:%u seed=%u\n",
+             options_.deviceCount,
+             options_.durationSeconds,
+             options_.bootWindowSeconds,
+             options_.isSecure ? "on" : "off",
+             options_.brokerHost.c_str(),
+             static_cast<unsigned>(options_.brokerPort),
+             options_.seed);
+    } else {
+      printf("devices=%u simulated=%us bootWindow=%us secure=%s brokerRate=%.0f/s latency=%.2fms seed=%u\n",
+             options_.deviceCount,
+             options_.durationSeconds,
+             options_.bootWindowSeconds,
+             options_.isSecure ? "on" : "off",
+             options_.brokerMessagesPerSecond,
+             options_.oneWayLatencyMs,
+             options_.seed);
+    }
+    printf("published=%llu bytes=%llu buildFailures=%llu decodeFailures=%llu\n",
+           static_cast<unsigned long long>(report_.publishedCount),
+           static_cast<unsigned long long>(report_.publishedBytes),
+           static_cast<unsigned long long>(report_.buildFailureCount),
+           static_cast<unsigned long long>(report_.decodeFailureCount));
+    for (const auto& kindCount : report_.publishedCountByKind) {
+      printf("  published[%s]=%llu\n", kindCount.first.c_str(), static_cast<unsigned long long>(kindCount.second));
+    }
+    if (isLiveMode()) {
+      printLiveReport(wallSeconds);
+      return;
+    }
+    printf("broker accepted=%llu delivered=%llu droppedNoSubscriber=%llu maxQueueDepth=%zu maxQueueWait=%.2fms\n",
+           static_cast<unsigned long long>(brokerStats.acceptedCount),
+           static_cast<unsigned long long>(brokerStats.deliveredCount),
+           static_cast<unsigned long long>(brokerStats.droppedNoSubscriberCount),
+           brokerStats.maxQueueDepth,
+           static_cast<double>(brokerStats.maxQueueWaitUs) / 1000.0);
+    printf("throughput simulated=%.1f msg/s (%.1f KiB/s)\n",
+           static_cast<double>(brokerStats.acceptedCount) / simulatedSeconds,
+           static_cast<double>(brokerStats.acceptedPayloadBytes) / 1024.0 / simulatedSeconds);
+    for (auto& kindLatency : report_.deliveryLatencyByKind) {
+      printLatencyLine(("e2e[" + kindLatency.first + "]").c_str(), &kindLatency.second);
+    }
+    printLatencyLine("roundTrip[call/status]", &report_.statusRoundTrip);
+    printLatencyLine("roundTrip[call/fileSyncChunk]", &report_.fileSyncRoundTrip);
+    printf("commandsSent=%llu commandsSkippedBusy=%llu\n",
+           static_cast<unsigned long long>(report_.commandSentCount),
+           static_cast<unsigned long long>(report_.commandSkippedBusyCount));
+    printf("host wall=%.3fs speedup=%.1fx payloadBuild=%.1f payload/s\n",
+           wallSeconds,
+           wallSeconds > 0.0 ? simulatedSeconds / wallSeconds : 0.0,
+           wallSeconds > 0.0 ? static_cast<double>(report_.publishedCount) / wallSeconds : 0.0);
+    printLatencyLine("hostCost[device build+encrypt]", &report_.deviceBuildWallUs);
+    printLatencyLine("hostCost[backend decrypt+parse]", &report_.backendDecodeWallUs);
+  }
+
+ private:
+  bool isLiveMode() const { return !options_.brokerHost.empty(); }
+
+  /**
+   * @brief 実ブローカーモードの集計を表示する。
+   */
+  void printLiveReport(double wallSeconds) {
+    printf("live connected=%llu connectFailures=%llu disconnects=%llu publishRejected=%llu\n",
+           static_cast<unsigned long long>(report_.liveConnectedCount),
+           static_cast<unsigned long long>(report_.liveConnectFailureCount),
+           static_cast<unsigned long long>(report_.liveDisconnectCount),
+           static_cast<unsigned long long>(report_.livePublishRejectedCount));
+    for (const auto& subCount : report_.liveCommandCountBySub) {
+      printf("  received[call/%s]=%llu\n", subCount.first.c_str(), static_cast<unsigned long long>(subCount.second));
+    }
+    printf("throughput wall=%.1f msg/s (%.1f KiB/s)\n",
+           wallSeconds > 0.0 ? static_cast<double>(report_.publishedCount) / wallSeconds : 0.0,
+           wallSeconds > 0.0 ? static_cast<double>(report_.publishedBytes) / 1024.0 / wallSeconds : 0.0);
+    printLatencyLine("connack", &report_.liveConnackLatency);
+    printLatencyLine("puback[QoS1]", &report_.livePubackLatency);
+    printLatencyLine("hostCost[device build+encrypt]", &report_.deviceBuildWallUs);
+  }
+
+  void printLatencyLine(const char* label, latencyRecorder* recorder) {
+    if (recorder == nullptr || recorder->count() == 0) {
+      return;
+    }
+    printf("%-34s n=%-8zu p50=%8.3fms p95=%8.3fms p99=%8.3fms max=%8.3fms\n",
+           label,
+           recorder->count(),
+           recorder->percentileMs(50.0),
+           recorder->percentileMs(95.0),
+           recorder->percentileMs(99.0),
+           recorder->percentileMs(100.0));
+  }
+
+  /**
+   * @brief 仮想時刻を進め、シムの仮想UTC（payloadの ts / id）も同期させる。
+   */
+  void advanceClock(uint64_t atUs) {
+    nowUs_ = atUs;
+    setHostVirtualUtcMicros(simulationStartUtcMicros_ + static_cast<int64_t>(nowUs_));
+  }
+
+  /**
+   * @brief 仮想UTCを ISO8601（ミリ秒、Z付き）で返す（trh の ts 用）。
+   */
+  std::string formatVirtualUtcIso8601() const {
+    const int64_t utcMicros = simulationStartUtcMicros_ + static_cast<int64_t>(nowUs_);
+    const time_t utcSeconds = static_cast<time_t>(utcMicros / 1000000LL);
+    struct tm utcTime = {};
+    gmtime_r(&utcSeconds, &utcTime);
+    char timestampBuffer[32] = {};
+    snprintf(timestampBuffer,
+             sizeof(timestampBuffer),
+             "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+             utcTime.tm_year + 1900,
+             utcTime.tm_mon + 1,
+             utcTime.tm_mday,
+             utcTime.tm_hour,
+             utcTime.tm_min,
+             utcTime.tm_sec,
+             static_cast<int>((utcMicros / 1000LL) % 1000LL));
+    return std::string(timestampBuffer);
+  }
+
+  void scheduleEvent(uint64_t atUs, fleetEventType eventType, uint32_t deviceIndex) {
+    eventQueue_.push(fleetEvent{atUs, eventSequence_++, eventType, deviceIndex});
+  }
+
+  /**
+   * @brief 対象デバイスを「現在のデバイス」に設定し、CPU時刻を仮想時刻へ合わせる。
+   */
+  void activateDevice(virtualDevice* device) {
+    device->context.cpuMillis =
+        (nowUs_ >= device->bootAtUs) ? static_cast<uint32_t>((nowUs_ - device->bootAtUs) / 1000ULL) : 0;
+    setCurrentHostDevice(&device->context);
+  }
+
+  /**
+   * @brief 起動通知を送り、周期通知（status / trh）を登録する。
+   */
+  void startDeviceTelemetry(uint32_t deviceIndex) {
+    virtualDevice& device = devices_[deviceIndex];
+    device.isBooted = true;
+    publishStatus(&device, iotCommon::mqtt::subCommand::status::kStartUp, "status/start-up");
+    // [推奨] 周期の位相を端末ごとにずらし、起動直後以外は負荷が平準化される実機挙動に合わせる。
+    scheduleEvent(nowUs_ + static_cast<uint64_t>(options_.statusIntervalSeconds) * kMicrosPerSecond,
+                  fleetEventType::kStatusTick,
+                  deviceIndex);
+    std::uniform_int_distribution<uint64_t> trhPhase(1,
+                                                     static_cast<uint64_t>(options_.trhIntervalSeconds) * kMicrosPerSecond);
+    scheduleEvent(nowUs_ + trhPhase(randomEngine_), fleetEventType::kTrhTick, deviceIndex);
+  }
+
+  void handleEvent(const fleetEvent& event) {
+    switch (event.eventType) {
+      case fleetEventType::kBoot:
+        // [重要] 実ブローカーモードは CONNACK 受信後に起動通知を送る（mqtt.cpp と同じ順序）。
+        if (isLiveMode()) {
+          beginLiveSession(event.deviceIndex);
+        } else {
+          startDeviceTelemetry(event.deviceIndex);
+        }
+        break;
+      case fleetEventType::kLiveReconnect:
+        beginLiveSession(event.deviceIndex);
+        break;
+      case fleetEventType::kStatusTick:
+        // [重要] main.cpp の周期通知と同じく sub=reply で送る（LocalServer の lastSeenAt 更新用）。
+        publishStatus(&devices_[event.deviceIndex], iotCommon::mqtt::subCommand::status::kReply, "status/periodic");
+        scheduleEvent(nowUs_ + static_cast<uint64_t>(options_.statusIntervalSeconds) * kMicrosPerSecond,
+                      fleetEventType::kStatusTick,
+                      event.deviceIndex);
+        break;
+      case fleetEventType::kTrhTick:
+        publishTrh(&devices_[event.deviceIndex]);
+        scheduleEvent(nowUs_ + static_cast<uint64_t>(options_.trhIntervalSeconds) * kMicrosPerSecond,
+                      fleetEventType::kTrhTick,
+                      event.deviceIndex);
+        break;
+      case fleetEventType::kBackendStatusRequest:
+        sendBackendCommand(iotCommon::mqtt::subCommand::call::kStatus);
+        scheduleEvent(nowUs_ + static_cast<uint64_t>(options_.commandIntervalMs) * 1000ULL,
+                      fleetEventType::kBackendStatusRequest,
+                      0);
+        break;
+      case fleetEventType::kBackendFileSyncChunk:
+        sendBackendCommand("fileSyncChunk");
+        scheduleEvent(nowUs_ + static_cast<uint64_t>(options_.fileSyncIntervalMs) * 1000ULL,
+                      fleetEventType::kBackendFileSyncChunk,
+                      0);
+        break;
+      default:
+        appLogWarn("fleetSimulator::handleEvent skipped unknown eventType=%u", static_cast<unsigned>(event.eventType));
+        break;
+    }
+  }
+
+  /**
+   * @brief 平文payloadを（必要なら）暗号化してpublishする。
+   * @param device 送信元デバイス。
+   * @param kind 統計用の種別名。
+   * @param topic 送信トピック。
+   * @param plainPayload 平文payload。
+   * @param retained retainフラグ。
+   * @param qos QoS（実ブローカーモードのみ有効。ファームウェアの publishMqttText と同じ値を渡す）。
+   */
+  bool publishFromDevice(virtualDevice* device,
+                         const char* kind,
+                         const String& topic,
+                         const String& plainPayload,
+                         bool retained,
+                         mqttAsync::mqttQos qos) {
+    String outgoingPayload = plainPayload;
+    if (options_.isSecure &&
+        !mqttPayloadSecurity::encodeEncryptedEnvelope(device->keyBytes, plainPayload, &outgoingPayload)) {
+      appLogError("fleetSimulator::publishFromDevice failed. encodeEncryptedEnvelope failed. node=%s kind=%s",
+                  device->nodeName.c_str(),
+                  kind);
+      report_.buildFailureCount += 1;
+      return false;
+    }
+    if (device->live != nullptr) {
+      if (!publishLive(device->live.get(), topic, outgoingPayload, retained, qos)) {
+        return false;
+      }
+    } else if (!device->client.publish(topic.c_str(), outgoingPayload.c_str(), retained)) {
+      appLogError("fleetSimulator::publishFromDevice failed. publish returned false. topic=%s", topic.c_str());
+      return false;
+    }
+    report_.publishedCount += 1;
+    report_.publishedBytes += outgoingPayload.length();
+    report_.publishedCountByKind[kind] += 1;
+    return true;
+  }
+
+  /**
+   * @brief status通知をファームウェアの buildMqttStatusPayload で生成して送信する。
+   * @param device 送信元デバイス。
+   * @param subName statusのsub値。
+   * @param kind 統計用の種別名。
+   */
+  void publishStatus(virtualDevice* device, const char* subName, const char* kind) {
+    activateDevice(device);
+    const auto buildStartedAt = std::chrono::steady_clock::now();
+    String plainPayload;
+    if (!mqtt::buildMqttStatusPayload(subName, "Online", 0, &plainPayload)) {
+      appLogError("fleetSimulator::publishStatus failed. buildMqttStatusPayload failed. node=%s", device->nodeName.c_str());
+      report_.buildFailureCount += 1;
+      return;
+    }
+    const String topic = String("esp32lab/notice/status/") + device->nodeName.c_str();
+    publishFromDevice(device, kind, topic, plainPayload, true, mqttAsync::mqttQos::kAtMostOnce);
+    report_.deviceBuildWallUs.add(measureWallUs(buildStartedAt));
+  }
+
+  /**
+   * @brief trh通知をファームウェアの buildTrhNoticePayload（mqtt_notice.cpp）で生成して送信する。
+   */
+  void publishTrh(virtualDevice* device) {
+    activateDevice(device);
+    const auto buildStartedAt = std::chrono::steady_clock::now();
+    std::normal_distribution<double> temperatureDistribution(24.0, 2.0);
+    std::normal_distribution<double> humidityDistribution(45.0, 8.0);
+    std::normal_distribution<double> pressureDistribution(1008.0, 4.0);
+    mqtt::trhNoticeReading reading;
+    reading.sensorAddress = 0x76;
+    reading.temperatureC = static_cast<float>(temperatureDistribution(randomEngine_));
+    reading.humidityRh = static_cast<float>(humidityDistribution(randomEngine_));
+    reading.pressureHpa = static_cast<float>(pressureDistribution(randomEngine_));
+    const String messageId = String(device->nodeName.c_str()) + "-" + millis();
+    const std::string timestampText = formatVirtualUtcIso8601();
+
+    String plainPayload;
+    if (!mqtt::buildTrhNoticePayload(device->nodeName.c_str(),
+                                     "",
+                                     messageId.c_str(),
+                                     timestampText.c_str(),
+                                     true,
+                                     "periodic",
+                                     reading,
+                                     &plainPayload)) {
+      appLogError("fleetSimulator::publishTrh failed. buildTrhNoticePayload failed. node=%s", device->nodeName.c_str());
+      report_.buildFailureCount += 1;
+      return;
+    }
+    const String topic = String("esp32lab/notice/trh/") + device->nodeName.c_str();
+    publishFromDevice(device, "trh", topic, plainPayload, false, mqttAsync::mqttQos::kAtMostOnce);
+    report_.deviceBuildWallUs.add(measureWallUs(buildStartedAt));
+  }
+
+  /**
+   * @brief バックエンド（LocalServer相当）から起動済みデバイス1台へコマンドを送る。
+   * @param subName `status` または `fileSyncChunk`。
+   */
+  void sendBackendCommand(const char* subName) {
+    const bool isFileSync = (strcmp(subName, "fileSyncChunk") == 0);
+    std::uniform_int_distribution<uint32_t> deviceDistribution(0, options_.deviceCount - 1);
+    virtualDevice& device = devices_[deviceDistribution(randomEngine_)];
+    uint64_t* pendingAtUs = isFileSync ? &device.pendingFileSyncAtUs : &device.pendingStatusRequestAtUs;
+    if (!device.isBooted || *pendingAtUs != 0) {
+      report_.commandSkippedBusyCount += 1;
+      return;
+    }
+
+    char requestIdBuffer[48] = {};
+    snprintf(requestIdBuffer, sizeof(requestIdBuffer), "%s-%llu", kBackendName,
+             static_cast<unsigned long long>(report_.commandSentCount + 1));
+    String plainPayload;
+    jsonService payloadJsonService;
+    std::vector<jsonKeyValueItem> itemList = {
+        {"v", jsonValueType::kString, "1", 0, 0, false},
+        {"DstID", jsonValueType::kString, device.nodeName.c_str(), 0, 0, false},
+        {"SrcID", jsonValueType::kString, kBackendName, 0, 0, false},
+        {"Request", jsonValueType::kString, "call", 0, 0, false},
+        {"id", jsonValueType::kString, requestIdBuffer, 0, 0, false},
+        {"op", jsonValueType::kString, "call", 0, 0, false},
+        {"sub", jsonValueType::kString, subName, 0, 0, false},
+    };
+    std::string dataBase64;
+    if (isFileSync) {
+      // [重要] base64長だけが負荷に効くため、内容は固定文字で埋める（4/3倍に膨らむ実サイズを再現）。
+      dataBase64.assign(((options_.fileSyncChunkBytes + 2) / 3) * 4, 'A');
+      itemList.push_back({"args.sessionId", jsonValueType::kString, requestIdBuffer, 0, 0, false});
+      itemList.push_back({"args.targetArea", jsonValueType::kString, "images", 0, 0, false});
+      itemList.push_back({"args.path", jsonValueType::kString, "/images/sim.bin", 0, 0, false});
+      itemList.push_back({"args.chunkIndex", jsonValueType::kLong, nullptr, 0, 0, false});
+      itemList.push_back({"args.chunkCount", jsonValueType::kLong, nullptr, 0, 1, false});
+      itemList.push_back({"args.dataBase64", jsonValueType::kString, dataBase64.c_str(), 0, 0, false});
+    }
+    if (!payloadJsonService.setValuesByPath(&plainPayload, itemList.data(), itemList.size())) {
+      appLogError("fleetSimulator::sendBackendCommand failed. setValuesByPath failed. sub=%s", subName);
+      return;
+    }
+    String outgoingPayload = plainPayload;
+    if (options_.isSecure &&
+        !mqttPayloadSecurity::encodeEncryptedEnvelope(device.keyBytes, plainPayload, &outgoingPayload)) {
+      appLogError("fleetSimulator::sendBackendCommand failed. encodeEncryptedEnvelope failed. node=%s",
+                  device.nodeName.c_str());
+      return;
+    }
+    const std::string topic = std::string("esp32lab/call/") + subName + "/" + device.nodeName;
+    if (broker_.publish(brokerMessage{topic, outgoingPayload.c_str(), false, nowUs_})) {
+      *pendingAtUs = nowUs_;
+      report_.commandSentCount += 1;
+    }
+  }
+
+  /**
+   * @brief 受信payloadを宛先デバイス鍵で復号する（平文ならそのまま）。
+   * @return 復号成功（または平文）時true。
+   */
+  bool decodeForDevice(const virtualDevice& device, const brokerMessage& message, String* plainPayloadOut) {
+    const String receivedPayload(message.payload);
+    if (!options_.isSecure) {
+      *plainPayloadOut = receivedPayload;
+      return true;
+    }
+    bool isEncryptedEnvelope = false;
+    if (!mqttPayloadSecurity::decodeEncryptedEnvelopeIfPresent(device.keyBytes,
+                                                               receivedPayload,
+                                                               &isEncryptedEnvelope,
+                                                               plainPayloadOut)) {
+      report_.decodeFailureCount += 1;
+      appLogError("fleetSimulator::decodeForDevice failed. node=%s topic=%s",
+                  device.nodeName.c_str(),
+                  message.topic.c_str());
+      return false;
+    }
+    if (!isEncryptedEnvelope) {
+      report_.decodeFailureCount += 1;
+      appLogError("fleetSimulator::decodeForDevice failed. plain payload in secure mode. topic=%s",
+                  message.topic.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief デバイス側で call コマンドを受信した際の処理（mqtt.cpp onMqttMessageReceived 相当）。
+   */
+  void handleDeviceCommand(const brokerMessage& message, uint64_t deliveredAtUs) {
+    (void)deliveredAtUs;
+    std::string kind;
+    std::string subName;
+    std::string nodeName;
+    if (!splitTopic(message.topic, &kind, &subName, &nodeName)) {
+      appLogWarn("fleetSimulator::handleDeviceCommand skipped. unexpected topic=%s", message.topic.c_str());
+      return;
+    }
+    const auto deviceIterator = deviceIndexByName_.find(nodeName);
+    if (deviceIterator == deviceIndexByName_.end()) {
+      appLogWarn("fleetSimulator::handleDeviceCommand skipped. unknown node=%s", nodeName.c_str());
+      return;
+    }
+    virtualDevice& device = devices_[deviceIterator->second];
+    activateDevice(&device);
+    String plainPayload;
+    if (!decodeForDevice(device, message, &plainPayload)) {
+      return;
+    }
+
+    if (subName == iotCommon::mqtt::subCommand::call::kStatus) {
+      publishStatus(&device, iotCommon::mqtt::subCommand::status::kReply, "status/reply");
+      return;
+    }
+    if (subName == "fileSyncChunk") {
+      jsonService payloadJsonService;
+      String sessionId;
+      String dataBase64;
+      String requesterId;
+      const bool parseResult = payloadJsonService.getValueByPath(plainPayload, "args.sessionId", &sessionId) &&
+                               payloadJsonService.getValueByPath(plainPayload, "args.dataBase64", &dataBase64);
+      if (!payloadJsonService.getValueByPath(plainPayload, iotCommon::mqtt::jsonKey::status::kSrcId, &requesterId) ||
+          requesterId.length() <= 0) {
+        requesterId = kBackendName;
+      }
+      String noticePayload;
+      const String messageId = String(device.nodeName.c_str()) + "-" + millis();
+      if (!mqtt::buildFileSyncStatusPayload(device.nodeName.c_str(),
+                                            requesterId.c_str(),
+                                            messageId.c_str(),
+                                            sessionId.c_str(),
+                                            "images",
+                                            "chunk",
+                                            parseResult ? iotCommon::mqtt::responseResult::kOk
+                                                        : iotCommon::mqtt::responseResult::kNg,
+                                            parseResult ? "chunk accepted" : "chunk parse failed",
+                                            "",
+                                            &noticePayload)) {
+        appLogError("fleetSimulator::handleDeviceCommand failed. buildFileSyncStatusPayload failed. node=%s",
+                    device.nodeName.c_str());
+        report_.buildFailureCount += 1;
+        return;
+      }
+      const String topic = String("esp32lab/notice/fileSyncStatus/") + device.nodeName.c_str();
+      publishFromDevice(&device, "fileSyncStatus", topic, noticePayload, false, mqttAsync::mqttQos::kAtLeastOnce);
+      return;
+    }
+    appLogWarn("fleetSimulator::handleDeviceCommand skipped. unsupported sub=%s", subName.c_str());
+  }
+
+  /**
+   * @brief バックエンド側で notice を受信した際の処理（復号・JSON解釈・遅延記録）。
+   */
+  void handleBackendNotice(const brokerMessage& message, uint64_t deliveredAtUs) {
+    std::string kind;
+    std::string subName;
+    std::string nodeName;
+    if (!splitTopic(message.topic, &kind, &subName, &nodeName)) {
+      appLogWarn("fleetSimulator::handleBackendNotice skipped. unexpected topic=%s", message.topic.c_str());
+      return;
+    }
+    const auto deviceIterator = deviceIndexByName_.find(nodeName);
+    if (deviceIterator == deviceIndexByName_.end()) {
+      appLogWarn("fleetSimulator::handleBackendNotice skipped. unknown node=%s", nodeName.c_str());
+      return;
+    }
+    virtualDevice& device = devices_[deviceIterator->second];
+
+    const auto decodeStartedAt = std::chrono::steady_clock::now();
+    String plainPayload;
+    if (!decodeForDevice(device, message, &plainPayload)) {
+      return;
+    }
+    jsonService payloadJsonService;
+    String sourceId;
+    String detailText;
+    if (!payloadJsonService.getValueByPath(plainPayload, iotCommon::mqtt::jsonKey::status::kSrcId, &sourceId) ||
+        sourceId.hostText() != nodeName) {
+      report_.decodeFailureCount += 1;
+      appLogError("fleetSimulator::handleBackendNotice failed. SrcID mismatch. topic=%s SrcID=%s",
+                  message.topic.c_str(),
+                  sourceId.c_str());
+      return;
+    }
+    payloadJsonService.getValueByPath(plainPayload, iotCommon::mqtt::jsonKey::kDetail, &detailText);
+    report_.backendDecodeWallUs.add(measureWallUs(decodeStartedAt));
+
+    const uint64_t latencyUs = deliveredAtUs - message.publishedAtUs;
+    std::string latencyKind = subName;
+    if (subName == iotCommon::mqtt::subCommand::notice::kStatus) {
+      latencyKind += "/" + detailText.hostText();
+    }
+    report_.deliveryLatencyByKind[latencyKind].add(latencyUs);
+
+    // [制限] 周期通知も detail=Reply のため、要求後に最初に届いた Reply を応答とみなす（LocalServer と同じ判定）。
+    if (subName == iotCommon::mqtt::subCommand::notice::kStatus && detailText == "Reply" &&
+        device.pendingStatusRequestAtUs != 0) {
+      report_.statusRoundTrip.add(deliveredAtUs - device.pendingStatusRequestAtUs);
+      device.pendingStatusRequestAtUs = 0;
+    } else if (subName == iotCommon::mqtt::subCommand::notice::kFileSyncStatus && device.pendingFileSyncAtUs != 0) {
+      report_.fileSyncRoundTrip.add(deliveredAtUs - device.pendingFileSyncAtUs);
+      device.pendingFileSyncAtUs = 0;
+    }
+  }
+
+  /**
+   * @brief 端末1台分の実ブローカー用セッションを作る（mqtt.cpp と同じ送受信容量・送信窓・Keep Alive）。
+   * @return 成功時true。
+   */
+  bool createLiveSession(uint32_t deviceIndex) {
+    virtualDevice& device = devices_[deviceIndex];
+    device.live = std::make_unique<liveMqttSession>();
+    device.live->owner = this;
+    device.live->deviceIndex = deviceIndex;
+    mqttAsync::mqttAsyncClientConfig clientConfig = mqttAsync::getDefaultMqttAsyncClientConfig();
+    clientConfig.sendQueueBytes = 16384;
+    clientConfig.maxIncomingPacketBytes = 4096;
+    clientConfig.inflightWindow = 8;
+    clientConfig.keepAliveSeconds = 60;
+    if (!device.live->client.initialize(clientConfig)) {
+      appLogError("fleetSimulator::createLiveSession failed. client initialize failed. node=%s", device.nodeName.c_str());
+      return false;
+    }
+    device.live->client.setMessageHandler(onLiveMessage, device.live.get());
+    device.live->client.setPublishAckHandler(onLivePublishAck, device.live.get());
+    return true;
+  }
+
+  /**
+   * @brief 端末名と k-device 鍵（16進）を1行1台で書き出す（実バックエンドの鍵登録用）。
+   * @return 成功時true。
+   */
+  bool writeDeviceKeys() {
+    FILE* keyFile = fopen(options_.keysOutPath.c_str(), "w");
+    if (keyFile == nullptr) {
+      appLogError("fleetSimulator::writeDeviceKeys failed. fopen failed. path=%s", options_.keysOutPath.c_str());
+      return false;
+    }
+    for (const virtualDevice& device : devices_) {
+      fprintf(keyFile, "%s,", device.nodeName.c_str());
+      for (uint8_t keyByte : device.keyBytes) {
+        fprintf(keyFile, "%02x", static_cast<unsigned>(keyByte));
+      }
+      fprintf(keyFile, "\n");
+    }
+    const bool closeResult = (fclose(keyFile) == 0);
+    if (!closeResult) {
+      appLogError("fleetSimulator::writeDeviceKeys failed. fclose failed. path=%s", options_.keysOutPath.c_str());
+    }
+    return closeResult;
+  }
+
+  /**
+   * @brief TCP 接続して CONNECT を積む（mqtt.cpp openMqttSession と同じ Will / Clean Session）。
+   * @details 失敗時は `kLiveReconnectDelayUs` 後に再試行する。
+   */
+  void beginLiveSession(uint32_t deviceIndex) {
+    virtualDevice& device = devices_[deviceIndex];
+    liveMqttSession& session = *device.live;
+    activateDevice(&device);
+    if (session.socket.connect(brokerAddress_, options_.brokerPort) != 1) {
+      failLiveSession(deviceIndex);
+      return;
+    }
+    String willPayload;
+    String willOutgoingPayload;
+    if (!mqtt::buildMqttStatusPayload(iotCommon::mqtt::subCommand::status::kWill, "Offline", 0, &willPayload)) {
+      report_.buildFailureCount += 1;
+      willPayload = "{}";
+    }
+    willOutgoingPayload = willPayload;
+    if (options_.isSecure &&
+        !mqttPayloadSecurity::encodeEncryptedEnvelope(device.keyBytes, willPayload, &willOutgoingPayload)) {
+      report_.buildFailureCount += 1;
+    }
+    const std::string willTopic = "esp32lab/notice/status/" + device.nodeName;
+    mqttAsync::mqttTransport transport = {};
+    transport.context = &session.socket;
+    transport.write = hostClientWrite;
+    transport.read = hostClientRead;
+    mqttAsync::mqttConnectOptions connectOptions = {};
+    connectOptions.clientId = device.nodeName.c_str();
+    connectOptions.userName = options_.mqttUserName.empty() ? nullptr : options_.mqttUserName.c_str();
+    connectOptions.password = options_.mqttPassword.empty() ? nullptr : options_.mqttPassword.c_str();
+    // 実機（openMqttSession）と同じクリーンセッション。再接続後の送り直しは DUP=0 になる。
+    connectOptions.cleanSession = true;
+    connectOptions.willTopic = willTopic.c_str();
+    connectOptions.willPayload = willOutgoingPayload.c_str();
+    connectOptions.willQos = mqttAsync::mqttQos::kAtLeastOnce;
+    connectOptions.willRetain = true;
+    if (!session.client.beginSession(transport, connectOptions, static_cast<uint32_t>(nowUs_ / 1000ULL))) {
+      session.socket.stop();
+      failLiveSession(deviceIndex);
+      return;
+    }
+    session.connectStartedAtUs = nowUs_ == 0 ? 1 : nowUs_;
+  }
+
+  /**
+   * @brief 接続失敗・切断を記録し、再接続を登録する。
+   */
+  void failLiveSession(uint32_t deviceIndex) {
+    liveMqttSession& session = *devices_[deviceIndex].live;
+    if (session.isSessionUp) {
+      report_.liveDisconnectCount += 1;
+    } else {
+      report_.liveConnectFailureCount += 1;
+    }
+    session.isSessionUp = false;
+    session.connectStartedAtUs = 0;
+    session.publishedAtUsByPacketId.clear();
+    scheduleEvent(nowUs_ + kLiveReconnectDelayUs, fleetEventType::kLiveReconnect, deviceIndex);
+  }
+
+  /**
+   * @brief CONNACK(0) 受信時の処理。購読し、初回接続なら起動通知と周期通知を開始する。
+   */
+  void handleLiveSessionUp(uint32_t deviceIndex) {
+    virtualDevice& device = devices_[deviceIndex];
+    liveMqttSession& session = *device.live;
+    session.isSessionUp = true;
+    report_.liveConnectedCount += 1;
+    report_.liveConnackLatency.add(nowUs_ - session.connectStartedAtUs);
+    const std::string commandFilter = "esp32lab/call/+/" + device.nodeName;
+    if (session.client.subscribe(commandFilter.c_str(), mqttAsync::mqttQos::kAtLeastOnce, nullptr) !=
+        mqttAsync::mqttEnqueueResult::kQueued) {
+      appLogWarn("fleetSimulator::handleLiveSessionUp: subscribe was not queued. node=%s", device.nodeName.c_str());
+    }
+    if (!session.hasEverConnected) {
+      session.hasEverConnected = true;
+      startDeviceTelemetry(deviceIndex);
+    }
+  }
+
+  /**
+   * @brief セッションを持つ全端末の送受信を1回進める。
+   * @return いずれかの端末で送受信が進んだ場合true。
+   */
+  bool pollLiveSessions() {
+    bool hasProgress = false;
+    const uint32_t nowMs = static_cast<uint32_t>(nowUs_ / 1000ULL);
+    for (uint32_t deviceIndex = 0; deviceIndex < devices_.size(); ++deviceIndex) {
+      virtualDevice& device = devices_[deviceIndex];
+      liveMqttSession& session = *device.live;
+      if (session.connectStartedAtUs == 0) {
+        continue;
+      }
+      const mqttAsync::mqttAsyncClientStats& clientStats = session.client.stats();
+      const uint64_t bytesBefore = clientStats.bytesSent + clientStats.bytesReceived;
+      activateDevice(&device);
+      if (!session.client.poll(nowMs)) {
+        session.socket.stop();
+        failLiveSession(deviceIndex);
+        hasProgress = true;
+        continue;
+      }
+      if (!session.isSessionUp && session.client.isConnected()) {
+        handleLiveSessionUp(deviceIndex);
+      }
+      hasProgress = hasProgress || (clientStats.bytesSent + clientStats.bytesReceived != bytesBefore);
+    }
+    return hasProgress;
+  }
+
+  /**
+   * @brief 実時間で終了時刻までイベント処理と送受信を行い、最後に DISCONNECT して閉じる。
+   */
+  void runLive() {
+    const uint64_t endUs = static_cast<uint64_t>(options_.durationSeconds) * kMicrosPerSecond;
+    const auto wallStartedAt = std::chrono::steady_clock::now();
+    simulationStartUtcMicros_ = static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                         std::chrono::system_clock::now().time_since_epoch())
+                                                         .count());
+    for (;;) {
+      advanceClock(measureWallUs(wallStartedAt));
+      if (nowUs_ >= endUs) {
+        break;
+      }
+      while (!eventQueue_.empty() && eventQueue_.top().atUs <= nowUs_) {
+        const fleetEvent event = eventQueue_.top();
+        eventQueue_.pop();
+        handleEvent(event);
+      }
+      if (!pollLiveSessions()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+
+    for (virtualDevice& device : devices_) {
+      if (device.live->isSessionUp) {
+        device.live->client.requestDisconnect();
+      }
+    }
+    const uint64_t shutdownEndUs = nowUs_ + kLiveShutdownTimeoutUs;
+    bool hasOpenSession = true;
+    while (hasOpenSession && nowUs_ < shutdownEndUs) {
+      hasOpenSession = false;
+      for (virtualDevice& device : devices_) {
+        if (device.live->isSessionUp && device.live->client.poll(static_cast<uint32_t>(nowUs_ / 1000ULL))) {
+          hasOpenSession = true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      advanceClock(measureWallUs(wallStartedAt));
+    }
+    for (virtualDevice& device : devices_) {
+      device.live->client.endSession();
+      device.live->socket.stop();
+    }
+    wallElapsedUs_ = measureWallUs(wallStartedAt);
+  }
+
+  /**
+   * @brief 送信キュー（QoS1 は送信窓）へ積む。
+   * @return 積めた場合true。
+   */
+  bool publishLive(liveMqttSession* session,
+                   const String& topic,
+                   const String& outgoingPayload,
+                   bool retained,
+                   mqttAsync::mqttQos qos) {
+    uint16_t packetId = 0;
+    const mqttAsync::mqttEnqueueResult enqueueResult =
+        session->client.publish(topic.c_str(),
+                                reinterpret_cast<const uint8_t*>(outgoingPayload.c_str()),
+                                outgoingPayload.length(),
+                                qos,
+                                retained,
+                                &packetId);
+    if (enqueueResult != mqttAsync::mqttEnqueueResult::kQueued) {
+      // [注意] 切断中の QoS0 は実機でも失われる。件数だけ数え、ログは出さない（数千台で出力が支配的になるため）。
+      report_.livePublishRejectedCount += 1;
+      return false;
+    }
+    if (qos == mqttAsync::mqttQos::kAtLeastOnce) {
+      session->publishedAtUsByPacketId[packetId] = nowUs_;
+    }
+    return true;
+  }
+
+  /**
+   * @brief 実ブローカーから受けたコマンドを端末側処理へ渡す。
+   */
+  static void onLiveMessage(void* context, const mqttAsync::mqttIncomingMessage& message) {
+    liveMqttSession* session = static_cast<liveMqttSession*>(context);
+    fleetSimulator* owner = session->owner;
+    brokerMessage receivedMessage{std::string(message.topic, message.topicLength),
+                                  std::string(reinterpret_cast<const char*>(message.payload), message.payloadLength),
+                                  message.retained,
+                                  owner->nowUs_};
+    std::string kind;
+    std::string subName;
+    std::string nodeName;
+    if (splitTopic(receivedMessage.topic, &kind, &subName, &nodeName)) {
+      owner->report_.liveCommandCountBySub[subName] += 1;
+    }
+    owner->handleDeviceCommand(receivedMessage, owner->nowUs_);
+  }
+
+  /**
+   * @brief PUBACK までの時間を記録する。
+   */
+  static void onLivePublishAck(void* context, uint16_t packetId) {
+    liveMqttSession* session = static_cast<liveMqttSession*>(context);
+    fleetSimulator* owner = session->owner;
+    const auto publishedIterator = session->publishedAtUsByPacketId.find(packetId);
+    if (publishedIterator == session->publishedAtUsByPacketId.end()) {
+      return;
+    }
+    owner->report_.livePubackLatency.add(owner->nowUs_ - publishedIterator->second);
+    session->publishedAtUsByPacketId.erase(publishedIterator);
+  }
+
+  fleetSimulatorOptions options_;
+  brokerStandIn broker_;
+  std::mt19937 randomEngine_;
+  std::vector<virtualDevice> devices_;
+  std::map<std::string, uint32_t> deviceIndexByName_;
+  std::priority_queue<fleetEvent, std::vector<fleetEvent>, fleetEventLater> eventQueue_;
+  uint64_t nowUs_;
+  uint64_t eventSequence_;
+  uint64_t wallElapsedUs_ = 0;
+  int64_t simulationStartUtcMicros_ = 0;
+  IPAddress brokerAddress_;
+  fleetReport report_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fleetSimulatorOptions options;
+  if (!parseOptions(argc, argv, &options)) {
+    return 2;
+  }
+  setHostLogVerbose(options.isVerbose);
+
+  fleetSimulator simulator(options);
+  if (!simulator.initialize()) {
+    appLogError("main failed. fleetSimulator::initialize returned false.");
+    return 1;
+  }
+  simulator.run();
+  simulator.printReport();
+  return 0;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file flowRuntimeScenario.cpp
+ * @brief 協調型フロー実行基盤（src/flowRuntime.cpp）をホストで動かす検証シナリオ。
+ * @details
+ * - [重要] ファームウェアの flowRuntime / util を無改変でリンクし、仮想時刻の上で次を確認する。
+ *   - requestReplyFlow が startupAckResponderFlow の応答を受け取ること
+ *   - 応答が来ない requestReplyFlow が応答待機時間の経過で kTimeout になること
+ *   - 保留箱（kDeferredMessageCapacity 件）が満杯でも無関係なメッセージを破棄せず、後ろに並ぶ応答を配送すること
+ *   - coroutineFlow の `co_await awaitSleep / awaitMessage` が待機結果と経過時間どおりに再開すること
+ * - [重要] メールボックスは hostShim/hostInterTaskMessage.cpp の単一スレッド実装で、受信待機は仮想時刻を進める。
+ * - [厳守] coroutineFlow は C++20 でビルドしたときだけ有効になる。無効なビルドでは失敗として扱う。
+ * - 判定に失敗した場合は終了コード 1 を返す。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "flowRuntime.h"
+#include "interTaskMessage.h"
+#include "util.h"
+
+void setHostLogVerbose(bool verbose);
+
+namespace {
+
+using flowRuntime::flowScheduler;
+using flowRuntime::flowWaitResult;
+
+/** @brief 要求側フローのメールボックス。@type appTaskId */
+constexpr appTaskId kRequesterTaskId = appTaskId::kMain;
+/** @brief 応答側フロー（startupAckResponderFlow）のメールボックス。@type appTaskId */
+constexpr appTaskId kResponderTaskId = appTaskId::kHttp;
+/** @brief 応答しないタスク（メールボックスのみ登録）。@type appTaskId */
+constexpr appTaskId kSilentTaskId = appTaskId::kDisplay;
+/** @brief 無関係なメッセージの送信元。@type appTaskId */
+constexpr appTaskId kNoiseTaskId = appTaskId::kLed;
+/** @brief 各メールボックスのQueue長。@type UBaseType_t */
+constexpr UBaseType_t kMailboxQueueLength = 24;
+
+/** @brief 判定失敗の件数。@type uint32_t */
+uint32_t failureCount = 0;
+
+void expect(bool condition, const char* caseName, const char* checkName) {
+  if (!condition) {
+    ++failureCount;
+    printf("FAIL %s %s\n", caseName, checkName);
+  }
+}
+
+uint32_t hostNowMs() {
+  return millis();
+}
+
+bool hostReceiveMessage(appTaskId taskId, appTaskMessage* messageOut, uint32_t waitMs) {
+  return getInterTaskMessageService().receiveMessage(taskId, messageOut, pdMS_TO_TICKS(waitMs));
+}
+
+bool hostSendMessage(const appTaskMessage& message, uint32_t timeoutMs) {
+  return getInterTaskMessageService().sendMessage(message, pdMS_TO_TICKS(timeoutMs));
+}
+
+void hostDelayMs(uint32_t delayMs) {
+  delay(delayMs);
+}
+
+/** @brief 実機の freeRtosFlowPlatform と同じ経路（interTaskMessageService）を使うホスト実装。 */
+const flowRuntime::flowPlatform hostFlowPlatform = {
+    hostNowMs,
+    hostReceiveMessage,
+    hostSendMessage,
+    hostDelayMs,
+    nullptr,
+    nullptr,
+};
+
+/**
+ * @brief ケース開始前にメールボックスを空にする。
+ */
+void drainMailboxes() {
+  const appTaskId taskIds[] = {kRequesterTaskId, kResponderTaskId, kSilentTaskId};
+  appTaskMessage discardedMessage{};
+  for (const appTaskId taskId : taskIds) {
+    while (getInterTaskMessageService().receiveMessage(taskId, &discardedMessage, 0)) {
+    }
+  }
+}
+
+/**
+ * @brief 無関係なメッセージ（kNoiseTaskId からの kHeartbeat、intValue が通し番号）を送る。
+ */
+bool sendNoiseMessage(appTaskId destinationTaskId, int32_t sequenceNumber) {
+  appUtil::appTaskMessageDetail noiseDetail = appUtil::createEmptyMessageDetail();
+  noiseDetail.hasIntValue = true;
+  noiseDetail.intValue = sequenceNumber;
+  return getInterTaskMessageService().sendMessage(
+      appUtil::buildTaskMessage(destinationTaskId, kNoiseTaskId, appMessageType::kHeartbeat, &noiseDetail), 0);
+}
+
+/**
+ * @brief requestReplyFlow が startupAckResponderFlow の kStartupAck を受け取ること。
+ */
+void runReplyCase() {
+  const char* caseName = "requestReply.reply";
+  drainMailboxes();
+  flowScheduler scheduler;
+  scheduler.initialize("replyCase", &hostFlowPlatform);
+  scheduler.registerMailbox(kRequesterTaskId);
+  scheduler.registerMailbox(kResponderTaskId);
+
+  flowRuntime::startupAckResponderFlow responderFlow(kResponderTaskId, "responder ready", nullptr);
+  flowRuntime::requestReplyFlow requestFlow("replyCase.request");
+  expect(requestFlow.configure(kResponderTaskId, kRequesterTaskId, appMessageType::kStartupRequest, nullptr,
+                               appMessageType::kStartupAck, 100, 1000),
+         caseName, "configure");
+  expect(scheduler.addFlow(&responderFlow, kResponderTaskId), caseName, "addFlow responder");
+  expect(scheduler.addFlow(&requestFlow, kRequesterTaskId), caseName, "addFlow request");
+
+  const uint32_t startedAtMs = millis();
+  scheduler.runUntilCompleted(&requestFlow);
+  const uint32_t elapsedMs = millis() - startedAtMs;
+
+  expect(requestFlow.succeeded(), caseName, "succeeded");
+  expect(!requestFlow.sendFailed(), caseName, "sendFailed");
+  expect(requestFlow.lastWaitResult() == flowWaitResult::kMessage, caseName, "lastWaitResult");
+  expect(requestFlow.replyMessage().sourceTaskId == kResponderTaskId, caseName, "reply source");
+  expect(strcmp(requestFlow.replyMessage().text, "responder ready") == 0, caseName, "reply text");
+  expect(elapsedMs < 1000, caseName, "elapsed");
+  printf("%s succeeded=%d elapsedMs=%u text=\"%s\"\n",
+         caseName,
+         requestFlow.succeeded() ? 1 : 0,
+         static_cast<unsigned>(elapsedMs),
+         requestFlow.replyMessage().text);
+}
+
+/**
+ * @brief 応答しない宛先への requestReplyFlow が応答待機時間で kTimeout になること。
+ */
+void runTimeoutCase() {
+  const char* caseName = "requestReply.timeout";
+  constexpr uint32_t kReplyTimeoutMs = 500;
+  drainMailboxes();
+  flowScheduler scheduler;
+  scheduler.initialize("timeoutCase", &hostFlowPlatform);
+  scheduler.registerMailbox(kRequesterTaskId);
+
+  flowRuntime::requestReplyFlow requestFlow("timeoutCase.request");
+  requestFlow.configure(kSilentTaskId, kRequesterTaskId, appMessageType::kStartupRequest, nullptr,
+                        appMessageType::kStartupAck, 100, kReplyTimeoutMs);
+  expect(scheduler.addFlow(&requestFlow, kRequesterTaskId), caseName, "addFlow");
+
+  const uint32_t startedAtMs = millis();
+  scheduler.runUntilCompleted(&requestFlow);
+  const uint32_t elapsedMs = millis() - startedAtMs;
+
+  expect(!requestFlow.succeeded(), caseName, "succeeded");
+  expect(!requestFlow.sendFailed(), caseName, "sendFailed");
+  expect(requestFlow.lastWaitResult() == flowWaitResult::kTimeout, caseName, "lastWaitResult");
+  expect(elapsedMs >= kReplyTimeoutMs && elapsedMs < kReplyTimeoutMs + flowScheduler::kPollSliceMs * 2, caseName,
+         "elapsed");
+  printf("%s succeeded=%d elapsedMs=%u\n", caseName, requestFlow.succeeded() ? 1 : 0, static_cast<unsigned>(elapsedMs));
+}
+
+/**
+ * @brief 保留箱が満杯になっても無関係なメッセージを破棄せず、後ろに並ぶ応答を配送すること。
+ * @details
+ * - [重要] 要求側メールボックスへ保留箱容量 + 3 件の無関係なメッセージを先に積み、その後ろに応答が並ぶ状態を作る。
+ *   溢れた分はメールボックス末尾へ戻され、応答は次周期以降に配送される。
+ * - [重要] 応答後、takeDeferredMessage で全件（保留箱の到着順 + メールボックスに残った分）を取り出せること。
+ */
+void runDeferredOverflowCase() {
+  const char* caseName = "deferred.overflow";
+  constexpr int32_t kNoiseCount = static_cast<int32_t>(flowScheduler::kDeferredMessageCapacity) + 3;
+  drainMailboxes();
+  flowScheduler scheduler;
+  scheduler.initialize("overflowCase", &hostFlowPlatform);
+  scheduler.registerMailbox(kRequesterTaskId);
+  scheduler.registerMailbox(kResponderTaskId);
+
+  for (int32_t sequenceNumber = 1; sequenceNumber <= kNoiseCount; ++sequenceNumber) {
+    expect(sendNoiseMessage(kRequesterTaskId, sequenceNumber), caseName, "send noise");
+  }
+
+  flowRuntime::startupAckResponderFlow responderFlow(kResponderTaskId, "ack after noise", nullptr);
+  flowRuntime::requestReplyFlow requestFlow("overflowCase.request");
+  requestFlow.configure(kResponderTaskId, kRequesterTaskId, appMessageType::kStartupRequest, nullptr,
+                        appMessageType::kStartupAck, 100, 1000);
+  scheduler.addFlow(&responderFlow, kResponderTaskId);
+  scheduler.addFlow(&requestFlow, kRequesterTaskId);
+  scheduler.runUntilCompleted(&requestFlow);
+
+  expect(requestFlow.succeeded(), caseName, "succeeded");
+  expect(strcmp(requestFlow.replyMessage().text, "ack after noise") == 0, caseName, "reply text");
+
+  std::vector<int32_t> takenSequenceNumbers;
+  appTaskMessage takenMessage{};
+  while (scheduler.takeDeferredMessage(kRequesterTaskId, &takenMessage)) {
+    expect(takenMessage.sourceTaskId == kNoiseTaskId && takenMessage.messageType == appMessageType::kHeartbeat, caseName,
+           "taken message kind");
+    takenSequenceNumbers.push_back(takenMessage.intValue);
+  }
+
+  expect(takenSequenceNumbers.size() == static_cast<size_t>(kNoiseCount), caseName, "taken count");
+  // 保留箱に入った先頭 kDeferredMessageCapacity 件は到着順を保つ
+  bool isDeferredOrderKept = takenSequenceNumbers.size() >= flowScheduler::kDeferredMessageCapacity;
+  for (size_t index = 0; isDeferredOrderKept && index < flowScheduler::kDeferredMessageCapacity; ++index) {
+    isDeferredOrderKept = (takenSequenceNumbers[index] == static_cast<int32_t>(index) + 1);
+  }
+  expect(isDeferredOrderKept, caseName, "deferred order");
+  // 末尾へ戻した分も含め、全通し番号がちょうど1回ずつ残る
+  std::vector<uint32_t> seenCounts(static_cast<size_t>(kNoiseCount) + 1, 0);
+  for (const int32_t sequenceNumber : takenSequenceNumbers) {
+    if (sequenceNumber >= 1 && sequenceNumber <= kNoiseCount) {
+      ++seenCounts[static_cast<size_t>(sequenceNumber)];
+    }
+  }
+  bool isEachSeenOnce = true;
+  for (int32_t sequenceNumber = 1; sequenceNumber <= kNoiseCount; ++sequenceNumber) {
+    isEachSeenOnce = isEachSeenOnce && seenCounts[static_cast<size_t>(sequenceNumber)] == 1;
+  }
+  expect(isEachSeenOnce, caseName, "no drop");
+
+  printf("%s succeeded=%d noise=%d taken=%zu order=",
+         caseName,
+         requestFlow.succeeded() ? 1 : 0,
+         static_cast<int>(kNoiseCount),
+         takenSequenceNumbers.size());
+  for (size_t index = 0; index < takenSequenceNumbers.size(); ++index) {
+    printf("%s%d", index == 0 ? "" : ",", static_cast<int>(takenSequenceNumbers[index]));
+  }
+  printf("\n");
+}
+
+#if FLOW_RUNTIME_HAS_COROUTINE
+/**
+ * @brief coroutineFlow ケースの観測結果。
+ */
+struct coroutineObservation {
+  /** @brief awaitSleep の待機結果。@type flowWaitResult */
+  flowWaitResult sleepResult = flowWaitResult::kNone;
+  /** @brief awaitSleep 前後の経過ms。@type uint32_t */
+  uint32_t sleptMs = 0;
+  /** @brief 到着済みメッセージに対する awaitMessage の待機結果。@type flowWaitResult */
+  flowWaitResult messageResult = flowWaitResult::kNone;
+  /** @brief 届かないメッセージに対する awaitMessage の待機結果。@type flowWaitResult */
+  flowWaitResult timeoutResult = flowWaitResult::kNone;
+  /** @brief タイムアウト待機の経過ms。@type uint32_t */
+  uint32_t timeoutWaitedMs = 0;
+  /** @brief 本体を最後まで実行したか。@type bool */
+  bool hasFinished = false;
+};
+
+flowRuntime::coroutineFlow observeCoroutine(coroutineObservation* observation) {
+  uint32_t startedAtMs = millis();
+  observation->sleepResult = co_await flowRuntime::awaitSleep(200);
+  observation->sleptMs = millis() - startedAtMs;
+
+  observation->messageResult = co_await flowRuntime::awaitMessage(kNoiseTaskId, appMessageType::kHeartbeat, 1000);
+
+  startedAtMs = millis();
+  observation->timeoutResult = co_await flowRuntime::awaitMessage(kNoiseTaskId, appMessageType::kHeartbeat, 300);
+  observation->timeoutWaitedMs = millis() - startedAtMs;
+  observation->hasFinished = true;
+}
+#endif
+
+/**
+ * @brief coroutineFlow の co_await が待機結果と経過時間どおりに再開すること。
+ */
+void runCoroutineCase() {
+  const char* caseName = "coroutineFlow";
+#if FLOW_RUNTIME_HAS_COROUTINE
+  drainMailboxes();
+  flowScheduler scheduler;
+  scheduler.initialize("coroutineCase", &hostFlowPlatform);
+  scheduler.registerMailbox(kRequesterTaskId);
+  expect(sendNoiseMessage(kRequesterTaskId, 1), caseName, "send message");
+
+  coroutineObservation observation;
+  flowRuntime::coroutineFlow coroutine = observeCoroutine(&observation);
+  expect(scheduler.addFlow(&coroutine, kRequesterTaskId), caseName, "addFlow");
+  scheduler.runUntilCompleted(&coroutine);
+
+  expect(observation.hasFinished, caseName, "finished");
+  expect(observation.sleepResult == flowWaitResult::kReady, caseName, "sleep result");
+  expect(observation.sleptMs >= 200 && observation.sleptMs < 200 + flowScheduler::kPollSliceMs, caseName, "sleep elapsed");
+  expect(observation.messageResult == flowWaitResult::kMessage, caseName, "message result");
+  expect(observation.timeoutResult == flowWaitResult::kTimeout, caseName, "timeout result");
+  expect(observation.timeoutWaitedMs >= 300 && observation.timeoutWaitedMs < 300 + flowScheduler::kPollSliceMs, caseName,
+         "timeout elapsed");
+  printf("%s finished=%d sleptMs=%u message=%d timeoutWaitedMs=%u\n",
+         caseName,
+         observation.hasFinished ? 1 : 0,
+         static_cast<unsigned>(observation.sleptMs),
+         observation.messageResult == flowWaitResult::kMessage ? 1 : 0,
+         static_cast<unsigned>(observation.timeoutWaitedMs));
+#else
+  expect(false, caseName, "FLOW_RUNTIME_HAS_COROUTINE=0 (build with C++20)");
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--verbose") == 0) {
+    setHostLogVerbose(true);
+  } else if (argc > 1) {
+    printf("usage: %s [--verbose]\n", argv[0]);
+    return 2;
+  }
+
+  interTaskMessageService& messageService = getInterTaskMessageService();
+  messageService.initialize();
+  messageService.registerTaskQueue(kRequesterTaskId, kMailboxQueueLength);
+  messageService.registerTaskQueue(kResponderTaskId, kMailboxQueueLength);
+  messageService.registerTaskQueue(kSilentTaskId, kMailboxQueueLength);
+
+  printf("=== flowRuntimeScenario report ===\n");
+  runReplyCase();
+  runTimeoutCase();
+  runDeferredOverflowCase();
+  runCoroutineCase();
+
+  const bool isPassed = failureCount == 0;
+  printf("failures=%u\n", static_cast<unsigned>(failureCount));
+  printf("result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+/**
+ * @file Arduino.h
+ * @brief ホスト（Linux/macOS/Windows）でファームウェアのプロトコルモジュールをビルドするための Arduino 互換最小シム。
+ * @details
+ * - [重要] `String` はファームウェア側ソースが実際に使うメンバーのみを `std::string` 上に実装する。
+ * - [重要] `millis()` / `ESP.getEfuseMac()` は「現在処理中の仮想デバイス」（hostDeviceContext.h）の値を返す。
+ * - [厳守] 本ディレクトリはホストツール専用であり、PlatformIO のビルドへ混入させない。
+ * - [制限] Arduino の全APIは再現しない。未実装メンバーが必要になった場合はコンパイルエラーで検出し、ここへ追加する。
+ */
+
+#pragma once
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Arduino `String` 互換クラス（ホスト用）。
+ */
+class String {
+ public:
+  String() = default;
+  String(const char* text) : value_(text == nullptr ? "" : text) {}
+  String(const std::string& text) : value_(text) {}
+  explicit String(char character) : value_(1, character) {}
+  explicit String(int value) : value_(std::to_string(value)) {}
+  explicit String(unsigned int value) : value_(std::to_string(value)) {}
+  explicit String(long value) : value_(std::to_string(value)) {}
+  explicit String(unsigned long value) : value_(std::to_string(value)) {}
+  explicit String(long long value) : value_(std::to_string(value)) {}
+  explicit String(unsigned long long value) : value_(std::to_string(value)) {}
+  explicit String(double value, unsigned int decimalPlaces = 2) {
+    char buffer[64] = {};
+    snprintf(buffer, sizeof(buffer), "%.*f", static_cast<int>(decimalPlaces), value);
+    value_ = buffer;
+  }
+
+  const char* c_str() const { return value_.c_str(); }
+  unsigned int length() const { return static_cast<unsigned int>(value_.size()); }
+  bool isEmpty() const { return value_.empty(); }
+  bool reserve(unsigned int size) {
+    value_.reserve(size);
+    return true;
+  }
+
+  char charAt(unsigned int index) const { return index < value_.size() ? value_[index] : '\0'; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) { return value_[index]; }
+
+  bool concat(const String& text) {
+    value_ += text.value_;
+    return true;
+  }
+  bool concat(const char* text) {
+    value_ += (text == nullptr ? "" : text);
+    return true;
+  }
+  bool concat(char character) {
+    value_ += character;
+    return true;
+  }
+  String& operator+=(const String& text) {
+    concat(text);
+    return *this;
+  }
+  String& operator+=(const char* text) {
+    concat(text);
+    return *this;
+  }
+  String& operator+=(char character) {
+    concat(character);
+    return *this;
+  }
+  template <typename numberType, typename = typename std::enable_if<std::is_arithmetic<numberType>::value &&
+                                                                    !std::is_same<numberType, char>::value>::type>
+  String& operator+=(numberType value) {
+    value_ += String(value).value_;
+    return *this;
+  }
+
+  bool equals(const String& text) const { return value_ == text.value_; }
+  bool equalsIgnoreCase(const String& text) const {
+    if (value_.size() != text.value_.size()) {
+      return false;
+    }
+    for (size_t index = 0; index < value_.size(); ++index) {
+      if (tolower(static_cast<unsigned char>(value_[index])) != tolower(static_cast<unsigned char>(text.value_[index]))) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool startsWith(const String& prefix) const { return value_.compare(0, prefix.value_.size(), prefix.value_) == 0; }
+  bool endsWith(const String& suffix) const {
+    return value_.size() >= suffix.value_.size() &&
+           value_.compare(value_.size() - suffix.value_.size(), suffix.value_.size(), suffix.value_) == 0;
+  }
+
+  int indexOf(char character, unsigned int fromIndex = 0) const { return toIndex(value_.find(character, fromIndex)); }
+  int indexOf(const String& text, unsigned int fromIndex = 0) const { return toIndex(value_.find(text.value_, fromIndex)); }
+  int lastIndexOf(char character) const { return toIndex(value_.rfind(character)); }
+  int lastIndexOf(const String& text) const { return toIndex(value_.rfind(text.value_)); }
+
+  String substring(unsigned int beginIndex) const {
+    return beginIndex >= value_.size() ? String() : String(value_.substr(beginIndex));
+  }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+      unsigned int swapIndex = beginIndex;
+      beginIndex = endIndex;
+      endIndex = swapIndex;
+    }
+    if (beginIndex >= value_.size()) {
+      return String();
+    }
+    return String(value_.substr(beginIndex, endIndex - beginIndex));
+  }
+
+  void replace(const String& fromText, const String& toText) {
+    if (fromText.value_.empty()) {
+      return;
+    }
+    size_t position = 0;
+    while ((position = value_.find(fromText.value_, position)) != std::string::npos) {
+      value_.replace(position, fromText.value_.size(), toText.value_);
+      position += toText.value_.size();
+    }
+  }
+  void remove(unsigned int index, unsigned int count = static_cast<unsigned int>(-1)) {
+    if (index < value_.size()) {
+      value_.erase(index, count);
+    }
+  }
+  void toLowerCase() {
+    for (char& character : value_) {
+      character = static_cast<char>(tolower(static_cast<unsigned char>(character)));
+    }
+  }
+  void toUpperCase() {
+    for (char& character : value_) {
+      character = static_cast<char>(toupper(static_cast<unsigned char>(character)));
+    }
+  }
+  void trim() {
+    const size_t beginIndex = value_.find_first_not_of(" \t\r\n");
+    if (beginIndex == std::string::npos) {
+      value_.clear();
+      return;
+    }
+    const size_t endIndex = value_.find_last_not_of(" \t\r\n");
+    value_ = value_.substr(beginIndex, endIndex - beginIndex + 1);
+  }
+  long toInt() const { return strtol(value_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(value_.c_str(), nullptr); }
+
+  /** @brief ホストツール側で `std::string` として参照する。 */
+  const std::string& hostText() const { return value_; }
+
+  friend bool operator==(const String& left, const String& right) { return left.value_ == right.value_; }
+  friend bool operator==(const String& left, const char* right) { return left.value_ == (right == nullptr ? "" : right); }
+  friend bool operator!=(const String& left, const String& right) { return !(left == right); }
+  friend bool operator!=(const String& left, const char* right) { return !(left == right); }
+  friend bool operator<(const String& left, const String& right) { return left.value_ < right.value_; }
+
+  friend String operator+(const String& left, const String& right) { return String(left.value_ + right.value_); }
+  friend String operator+(const String& left, const char* right) {
+    return String(left.value_ + (right == nullptr ? "" : right));
+  }
+  friend String operator+(const char* left, const String& right) {
+    return String(std::string(left == nullptr ? "" : left) + right.value_);
+  }
+  friend String operator+(const String& left, char right) { return String(left.value_ + right); }
+  template <typename numberType, typename = typename std::enable_if<std::is_arithmetic<numberType>::value &&
+                                                                    !std::is_same<numberType, char>::value>::type>
+  friend String operator+(const String& left, numberType right) {
+    return String(left.value_ + String(right).value_);
+  }
+
+ private:
+  static int toIndex(size_t position) { return position == std::string::npos ? -1 : static_cast<int>(position); }
+
+  std::string value_;
+};
+
+/**
+ * @brief 現在の仮想デバイスの起動後経過ms（hostShim.cpp 実装）。
+ */
+uint32_t millis();
+
+/**
+ * @brief 実時間の単調増加us（hostShim.cpp 実装）。
+ * @details
+ * - [重要] `millis()` と異なり仮想時刻ではない。実ソケットで所要時間を測るモジュール（networkSelfTest）用。
+ */
+uint32_t micros();
+
+/**
+ * @brief ホストでは実時間待機せず、仮想デバイスのCPU時刻だけを進める。
+ */
+void delay(uint32_t delayMs);
+
+/**
+ * @brief ESP32 `esp_random()` 互換の乱数（ホストでは std::random_device 由来）。
+ */
+uint32_t esp_random();
+
+/**
+ * @brief `ESP` オブジェクト互換クラス。
+ */
+class EspClass {
+ public:
+  /** @brief 現在の仮想デバイスのBase MACを返す。 */
+  uint64_t getEfuseMac();
+  /** @brief ホストでは固定値を返す。 */
+  uint32_t getFreeHeap() { return 256U * 1024U; }
+};
+
+extern EspClass ESP;
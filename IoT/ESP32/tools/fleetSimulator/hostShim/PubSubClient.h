@@ -0,0 +1,33 @@
+/**
+ * @file PubSubClient.h
+ * @brief PubSubClient のホスト用最小シム。
+ * @details
+ * - [重要] `mqttMessages.h` の宣言を通すための型定義と、仮想デバイスからの publish 転送のみを提供する。
+ * - [重要] publish は `setPublishHandler` で登録した関数（ブローカー代替）へ渡す。
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <functional>
+
+class PubSubClient {
+ public:
+  /** @brief publish転送先。引数は topic / payload / retained。 */
+  using publishHandler = std::function<bool(const char*, const char*, bool)>;
+
+  void setPublishHandler(publishHandler handler) { handler_ = handler; }
+  bool connected() const { return static_cast<bool>(handler_); }
+  bool publish(const char* topic, const char* payload, bool retained) {
+    if (!handler_ || topic == nullptr || payload == nullptr) {
+      return false;
+    }
+    return handler_(topic, payload, retained);
+  }
+  bool publish(const char* topic, const char* payload) { return publish(topic, payload, false); }
+  bool loop() { return connected(); }
+
+ private:
+  publishHandler handler_;
+};
@@ -0,0 +1,69 @@
+/**
+ * @file WiFi.h
+ * @brief Arduino-ESP32 `WiFi` のホスト用最小シム。
+ * @details
+ * - [重要] 値は現在処理中の仮想デバイス（hostDeviceContext.h）から返す。
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+/**
+ * @brief `IPAddress` 互換（IPv4 のみ。値はホストバイトオーダー a.b.c.d = a<<24 で保持する）。
+ */
+class IPAddress {
+ public:
+  IPAddress() : address_(0) {}
+  explicit IPAddress(uint32_t address) : address_(address) {}
+  IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+      : address_((static_cast<uint32_t>(first) << 24) | (static_cast<uint32_t>(second) << 16) |
+                 (static_cast<uint32_t>(third) << 8) | static_cast<uint32_t>(fourth)) {}
+  bool fromString(const char* addressText) {
+    unsigned octets[4] = {};
+    char trailing = '\0';
+    if (addressText == nullptr ||
+        sscanf(addressText, "%u.%u.%u.%u%c", &octets[0], &octets[1], &octets[2], &octets[3], &trailing) != 4 ||
+        octets[0] > 255 || octets[1] > 255 || octets[2] > 255 || octets[3] > 255) {
+      return false;
+    }
+    address_ = (octets[0] << 24) | (octets[1] << 16) | (octets[2] << 8) | octets[3];
+    return true;
+  }
+  bool fromString(const String& addressText) { return fromString(addressText.c_str()); }
+  /** @brief ホストバイトオーダーの値を返す（シム内のソケット接続用）。 */
+  uint32_t toHostOrder() const { return address_; }
+  String toString() const {
+    char buffer[16] = {};
+    snprintf(buffer,
+             sizeof(buffer),
+             "%u.%u.%u.%u",
+             static_cast<unsigned>((address_ >> 24) & 0xFF),
+             static_cast<unsigned>((address_ >> 16) & 0xFF),
+             static_cast<unsigned>((address_ >> 8) & 0xFF),
+             static_cast<unsigned>(address_ & 0xFF));
+    return String(buffer);
+  }
+
+ private:
+  uint32_t address_;
+};
+
+class WiFiClass {
+ public:
+  wl_status_t status();
+  String SSID();
+  IPAddress localIP();
+  int8_t RSSI();
+  String macAddress();
+  /** @brief getaddrinfo で IPv4 を解決する。成功時1。 */
+  int hostByName(const char* hostName, IPAddress& resolvedOut);
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,38 @@
+/**
+ * @file WiFiClient.h
+ * @brief Arduino-ESP32 `WiFiClient` のホスト用シム（POSIX ソケット）。
+ * @details
+ * - [重要] 実ソケットで接続する。networkSelfTest を netSelfTestStandIn（ループバック）へ接続して検証するために使う。
+ * - [制限] IPv4 のみ。setTimeout 等の未使用 API は持たない。
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+class WiFiClient {
+ public:
+  WiFiClient() = default;
+  virtual ~WiFiClient();
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+
+  /** @brief TCP 接続する。成功時1。 */
+  virtual int connect(IPAddress ip, uint16_t port);
+  /** @brief 全量送信するまで待つ。送信できた byte 数を返す。 */
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  /** @brief 受信済みで読める byte 数を返す。 */
+  virtual int available();
+  /** @brief 1 byte 読む。無ければ -1。 */
+  virtual int read();
+  /** @brief 読めるだけ読む。無ければ -1。 */
+  virtual int read(uint8_t* buffer, size_t size);
+  /** @brief 接続中、または未読データがあれば非0。 */
+  virtual uint8_t connected();
+  /** @brief 切断する。 */
+  virtual void stop();
+
+ protected:
+  int socketFd_ = -1;
+};
@@ -0,0 +1,28 @@
+/**
+ * @file WiFiClientSecure.h
+ * @brief Arduino-ESP32 `WiFiClientSecure` のホスト用シム。
+ * @details
+ * - [制限] ホストでは TLS を提供しない。connect は常に失敗する（呼出し側の TLS 失敗経路の確認用）。
+ *   実機の TLS 計測は netSelfTestStandIn の前段に TLS 終端（README 参照）を置いて行う。
+ */
+
+#pragma once
+
+#include <WiFiClient.h>
+
+class WiFiClientSecure : public WiFiClient {
+ public:
+  using WiFiClient::connect;
+  void setCACert(const char* rootCaPem) { (void)rootCaPem; }
+  /** @brief ホストでは常に 0（失敗）を返す。 */
+  int connect(IPAddress ip, uint16_t port, const char* hostName, const char* rootCaPem, const char* clientCertPem,
+              const char* clientKeyPem) {
+    (void)ip;
+    (void)port;
+    (void)hostName;
+    (void)rootCaPem;
+    (void)clientCertPem;
+    (void)clientKeyPem;
+    return 0;
+  }
+};
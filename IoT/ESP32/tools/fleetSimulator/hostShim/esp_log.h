@@ -0,0 +1,15 @@
+/**
+ * @file esp_log.h
+ * @brief ESP-IDF `esp_log.h` のホスト用最小シム（log.h が要求するログレベル型のみ）。
+ */
+
+#pragma once
+
+typedef enum {
+  ESP_LOG_NONE = 0,
+  ESP_LOG_ERROR = 1,
+  ESP_LOG_WARN = 2,
+  ESP_LOG_INFO = 3,
+  ESP_LOG_DEBUG = 4,
+  ESP_LOG_VERBOSE = 5,
+} esp_log_level_t;
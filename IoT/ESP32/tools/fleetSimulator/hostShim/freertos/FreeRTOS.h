@@ -0,0 +1,28 @@
+/**
+ * @file FreeRTOS.h
+ * @brief ホストビルド用 FreeRTOS 型定義の最小シム。
+ * @details
+ * - [重要] `interTaskMessage.h` / `flowRuntime.h` の宣言をホストでコンパイルするための型のみ提供する。
+ * - [制限] タスク/Queue の実体は提供しない。ホスト側は `flowPlatform` 経由で送受信を差し替える。
+ *   タスク間メッセージだけは hostInterTaskMessage.cpp が単一スレッド用の実装を持つ。
+ * - [制限] portMUX はシングルスレッド前提の空実装。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define portMAX_DELAY static_cast<TickType_t>(0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(timeMs) static_cast<TickType_t>(timeMs)
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
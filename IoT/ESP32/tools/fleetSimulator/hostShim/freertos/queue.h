@@ -0,0 +1,10 @@
+/**
+ * @file queue.h
+ * @brief ホストビルド用 FreeRTOS Queue 型の最小シム。
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct hostQueueDefinition* QueueHandle_t;
@@ -0,0 +1,35 @@
+/**
+ * @file task.h
+ * @brief ホストビルド用 FreeRTOS Task 型の最小シム。
+ * @details
+ * - [重要] `taskPlacement.h` の宣言をホストでコンパイルするための型のみ提供する。
+ * - [重要] `xTaskGetTickCount` は仮想デバイスの `millis()` を返し、`vTaskDelay` はそれを進める（1 Tick = 1 ms）。
+ * - [制限] `taskYIELD` は何もしない（単一スレッド）。
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef uint8_t StackType_t;
+typedef struct hostTaskDefinition* TaskHandle_t;
+typedef struct hostStaticTask {
+  uint8_t reserved;
+} StaticTask_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define tskNO_AFFINITY static_cast<BaseType_t>(0x7FFFFFFF)
+
+/**
+ * @brief 現在の Tick 数を返す（hostShim.cpp 実装）。
+ * @return 仮想デバイスの起動後経過ms。
+ */
+TickType_t xTaskGetTickCount();
+
+/**
+ * @brief 仮想デバイスの時刻を進める（hostShim.cpp 実装。`delay()` と同じ）。
+ * @param delayTicks 待機Tick。
+ */
+void vTaskDelay(TickType_t delayTicks);
+
+#define taskYIELD() ((void)0)
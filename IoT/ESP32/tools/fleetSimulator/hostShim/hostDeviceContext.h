@@ -0,0 +1,61 @@
+/**
+ * @file hostDeviceContext.h
+ * @brief ホストシムが参照する「現在処理中の仮想デバイス」コンテキスト定義。
+ * @details
+ * - [重要] ファームウェアのモジュールは `ESP.getEfuseMac()` / `millis()` / `WiFi.*` を直接呼ぶため、
+ *   シミュレータはイベント処理の直前に対象デバイスのコンテキストを差し替える。
+ * - [厳守] イベントループは単一スレッドで動作させる。複数スレッドから同時に差し替えない。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+/**
+ * @brief 仮想デバイス1台分のハードウェア相当情報。
+ */
+struct hostDeviceContext {
+  /** @brief Base MAC（下位48bit有効）。@type uint64_t */
+  uint64_t efuseMac;
+  /** @brief 起動後経過ms（仮想時刻）。@type uint32_t */
+  uint32_t cpuMillis;
+  /** @brief Wi-Fi接続済み扱いか。@type bool */
+  bool isWifiConnected;
+  /** @brief 接続先SSID。@type std::string */
+  std::string wifiSsid;
+  /** @brief 割り当てIPv4（ホストバイトオーダー a.b.c.d = a<<24）。@type uint32_t */
+  uint32_t ipv4Address;
+  /** @brief 受信強度dBm。@type int32_t */
+  int32_t rssi;
+  /** @brief 稼働中パーティション番号（0/1）。@type uint8_t */
+  uint8_t runningPartitionIndex;
+};
+
+/**
+ * @brief 現在処理中の仮想デバイスを設定する。
+ * @param context 対象コンテキスト（nullptrで解除）。
+ */
+void setCurrentHostDevice(hostDeviceContext* context);
+
+/**
+ * @brief 現在処理中の仮想デバイスを返す。
+ * @return 設定済みコンテキスト。未設定時は既定値を持つ静的コンテキスト。
+ */
+hostDeviceContext* getCurrentHostDevice();
+
+/**
+ * @brief 仮想UTC時刻を設定する。
+ * @param utcEpochMicros UTCエポックus。0なら実時刻（gettimeofday）を使う。
+ * @details
+ * - [重要] mqtt_status.cpp はビルド時に `gettimeofday` を `hostGettimeofday` へ置換してあり、本値を返す。
+ * - [理由] 仮想時刻で実時間より速く進めても、payload の `ts` / `id` が送信スケジュールと矛盾しないようにするため。
+ */
+void setHostVirtualUtcMicros(int64_t utcEpochMicros);
+
+/**
+ * @brief シムのログ出力閾値を設定する。
+ * @param verbose trueでINFO以下も出力、falseでWARN以上のみ出力。
+ */
+void setHostLogVerbose(bool verbose);
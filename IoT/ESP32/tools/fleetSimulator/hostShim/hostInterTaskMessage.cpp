@@ -0,0 +1,119 @@
+/**
+ * @file hostInterTaskMessage.cpp
+ * @brief タスク間メッセージサービス（interTaskMessage.h）の単一スレッド用ホスト実装。
+ * @details
+ * - [重要] ファームウェアの interTaskMessage.cpp は FreeRTOS Queue / セマフォに依存するため、ここで置き換える。
+ *   宛先タスクごとの Queue を登録時の長さを上限とする std::deque で表す。
+ * - [重要] 受信待機は仮想時刻（`delay()`）を待機時間だけ進めて即時に返す。単一スレッドでは待機中に
+ *   他から届くことがないため。`portMAX_DELAY` の待機は時刻を進めずに失敗を返す。
+ * - [制限] 完了通知（acquireCompletion 等）は提供しない。ホストで使うモジュールが参照しないため。
+ */
+
+#include <Arduino.h>
+
+#include <deque>
+
+#include "interTaskMessage.h"
+#include "log.h"
+
+namespace {
+
+/**
+ * @brief 宛先タスク1件分の受信Queue。
+ */
+struct hostTaskQueue {
+  /** @brief 登録済みか。@type bool */
+  bool isRegistered = false;
+  /** @brief Queue長。@type size_t */
+  size_t capacity = 0;
+  /** @brief 未受信メッセージ。@type std::deque<appTaskMessage> */
+  std::deque<appTaskMessage> messages;
+};
+
+/** @brief タスクIDを添字として保持するQueueテーブル。 */
+hostTaskQueue hostTaskQueueTable[appDefine::kTaskSlotCount];
+/** @brief 初期化済みか。 */
+bool isInitialized = false;
+
+/**
+ * @brief 登録済みQueueを返す。
+ * @param taskId タスクID。
+ * @return 登録済みならQueue、未登録/範囲外ならnullptr。
+ */
+hostTaskQueue* findTaskQueue(appTaskId taskId) {
+  const int32_t rawValue = static_cast<int32_t>(taskId);
+  if (rawValue <= 0 || rawValue >= appDefine::kTaskSlotCount || !hostTaskQueueTable[rawValue].isRegistered) {
+    return nullptr;
+  }
+  return &hostTaskQueueTable[rawValue];
+}
+
+}  // namespace
+
+bool interTaskMessageService::initialize() {
+  for (hostTaskQueue& taskQueue : hostTaskQueueTable) {
+    taskQueue.isRegistered = false;
+    taskQueue.capacity = 0;
+    taskQueue.messages.clear();
+  }
+  isInitialized = true;
+  return true;
+}
+
+bool interTaskMessageService::registerTaskQueue(appTaskId taskId, UBaseType_t queueLength) {
+  const int32_t rawValue = static_cast<int32_t>(taskId);
+  if (!isInitialized || queueLength == 0 || rawValue <= 0 || rawValue >= appDefine::kTaskSlotCount) {
+    appLogError("interTaskMessageService::registerTaskQueue failed. taskId=%ld queueLength=%lu",
+                static_cast<long>(taskId),
+                static_cast<unsigned long>(queueLength));
+    return false;
+  }
+  hostTaskQueue& taskQueue = hostTaskQueueTable[rawValue];
+  if (!taskQueue.isRegistered) {
+    taskQueue.isRegistered = true;
+    taskQueue.capacity = queueLength;
+  }
+  return true;
+}
+
+bool interTaskMessageService::sendMessage(const appTaskMessage& message, TickType_t timeoutTicks) {
+  (void)timeoutTicks;
+  if (!trySendMessage(message)) {
+    appLogError("interTaskMessageService::sendMessage failed. queue not found or full. destinationTaskId=%ld",
+                static_cast<long>(message.destinationTaskId));
+    return false;
+  }
+  return true;
+}
+
+bool interTaskMessageService::trySendMessage(const appTaskMessage& message) {
+  hostTaskQueue* taskQueue = isInitialized ? findTaskQueue(message.destinationTaskId) : nullptr;
+  if (taskQueue == nullptr || taskQueue->messages.size() >= taskQueue->capacity) {
+    return false;
+  }
+  taskQueue->messages.push_back(message);
+  return true;
+}
+
+bool interTaskMessageService::receiveMessage(appTaskId taskId, appTaskMessage* messageOut, TickType_t timeoutTicks) {
+  hostTaskQueue* taskQueue = isInitialized ? findTaskQueue(taskId) : nullptr;
+  if (taskQueue == nullptr || messageOut == nullptr) {
+    appLogError("interTaskMessageService::receiveMessage failed. queue not registered or messageOut is null. taskId=%ld",
+                static_cast<long>(taskId));
+    return false;
+  }
+  if (taskQueue->messages.empty()) {
+    if (timeoutTicks != portMAX_DELAY) {
+      delay(static_cast<uint32_t>(timeoutTicks));
+    }
+    return false;
+  }
+  *messageOut = taskQueue->messages.front();
+  taskQueue->messages.pop_front();
+  return true;
+}
+
+interTaskMessageService& getInterTaskMessageService() {
+  static interTaskMessageService messageService;
+  return messageService;
+}
@@ -0,0 +1,318 @@
+/**
+ * @file hostShim.cpp
+ * @brief Arduino/ESP-IDF 互換シムとファームウェア依存関数のホスト実装。
+ * @details
+ * - [重要] `appLogWrite` と `firmwareInfo::resolveFirmwareWrittenAtForStatus` は
+ *   ファームウェア側（log.cpp / firmwareInfo.cpp）が LittleFS / NVS に依存するため、ここで置き換える。
+ * - [重要] `taskPlacement::getCpuLoadSnapshot` は常に未計測を返す。status にコア別負荷を載せない（計測前の実機と同じ）。
+ * - [重要] `WiFiClient` と `WiFi.hostByName` は実ソケット / getaddrinfo で動く（networkSelfTest の検証用）。
+ * - [厳守] 既定ではWARN以上のみ出力する。数千台規模でINFOを出すと計測値がログ出力時間に支配されるため。
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <esp_ota_ops.h>
+#include <freertos/task.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <random>
+
+#include "firmwareInfo.h"
+#include "hostDeviceContext.h"
+#include "log.h"
+#include "taskPlacement.h"
+
+namespace {
+/** @brief コンテキスト未設定時に使う既定デバイス。 */
+hostDeviceContext defaultHostDevice{0x0000A0B1C2D3E4F5ULL, 0, true, "fleet-sim", 0x0A000001U, -55, 0};
+/** @brief 現在処理中の仮想デバイス。 */
+hostDeviceContext* currentHostDevice = nullptr;
+/** @brief 仮想UTC時刻us。0なら実時刻を使う。 */
+int64_t hostVirtualUtcMicros = 0;
+/** @brief INFO以下も出力するか。 */
+bool isHostLogVerbose = false;
+
+/** @brief A/B面のパーティション定義（ota_0 / ota_1）。 */
+const esp_partition_t hostAppPartitions[2] = {
+    {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x20000, 0x600000, "ota_0"},
+    {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x620000, 0x600000, "ota_1"},
+};
+
+/**
+ * @brief 乱数エンジンを返す。
+ * @return プロセス内で共有する乱数エンジン。
+ */
+std::mt19937& hostRandomEngine() {
+  static std::mt19937 engine{std::random_device{}()};
+  return engine;
+}
+}  // namespace
+
+EspClass ESP;
+WiFiClass WiFi;
+
+void setCurrentHostDevice(hostDeviceContext* context) {
+  currentHostDevice = context;
+}
+
+hostDeviceContext* getCurrentHostDevice() {
+  return currentHostDevice == nullptr ? &defaultHostDevice : currentHostDevice;
+}
+
+void setHostVirtualUtcMicros(int64_t utcEpochMicros) {
+  hostVirtualUtcMicros = utcEpochMicros;
+}
+
+/**
+ * @brief `gettimeofday` の置換先（CMakeLists.txt で mqtt_status.cpp のみ `-Dgettimeofday=hostGettimeofday`）。
+ * @param timeValueOut 出力先。
+ * @param timeZone 未使用。
+ * @return 成功時0。
+ */
+extern "C" int hostGettimeofday(struct timeval* timeValueOut, void* timeZone) {
+  if (timeValueOut == nullptr) {
+    return -1;
+  }
+  if (hostVirtualUtcMicros <= 0) {
+    return gettimeofday(timeValueOut, static_cast<struct timezone*>(timeZone));
+  }
+  timeValueOut->tv_sec = static_cast<time_t>(hostVirtualUtcMicros / 1000000LL);
+  timeValueOut->tv_usec = static_cast<suseconds_t>(hostVirtualUtcMicros % 1000000LL);
+  return 0;
+}
+
+void setHostLogVerbose(bool verbose) {
+  isHostLogVerbose = verbose;
+}
+
+uint32_t millis() {
+  return getCurrentHostDevice()->cpuMillis;
+}
+
+uint32_t micros() {
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+void delay(uint32_t delayMs) {
+  getCurrentHostDevice()->cpuMillis += delayMs;
+}
+
+TickType_t xTaskGetTickCount() {
+  return static_cast<TickType_t>(millis());
+}
+
+void vTaskDelay(TickType_t delayTicks) {
+  delay(static_cast<uint32_t>(delayTicks));
+}
+
+uint32_t esp_random() {
+  return static_cast<uint32_t>(hostRandomEngine()());
+}
+
+uint64_t EspClass::getEfuseMac() {
+  return getCurrentHostDevice()->efuseMac;
+}
+
+wl_status_t WiFiClass::status() {
+  return getCurrentHostDevice()->isWifiConnected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+String WiFiClass::SSID() {
+  return String(getCurrentHostDevice()->wifiSsid);
+}
+
+IPAddress WiFiClass::localIP() {
+  return IPAddress(getCurrentHostDevice()->ipv4Address);
+}
+
+int8_t WiFiClass::RSSI() {
+  return static_cast<int8_t>(getCurrentHostDevice()->rssi);
+}
+
+String WiFiClass::macAddress() {
+  // [重要] ESP32のSTA MACはBase MACと同一のため、同じ値をコロン区切りで返す。
+  const uint64_t efuseMac = getCurrentHostDevice()->efuseMac;
+  char macBuffer[18] = {};
+  snprintf(macBuffer,
+           sizeof(macBuffer),
+           "%02X:%02X:%02X:%02X:%02X:%02X",
+           static_cast<unsigned>((efuseMac >> 40) & 0xFF),
+           static_cast<unsigned>((efuseMac >> 32) & 0xFF),
+           static_cast<unsigned>((efuseMac >> 24) & 0xFF),
+           static_cast<unsigned>((efuseMac >> 16) & 0xFF),
+           static_cast<unsigned>((efuseMac >> 8) & 0xFF),
+           static_cast<unsigned>(efuseMac & 0xFF));
+  return String(macBuffer);
+}
+
+int WiFiClass::hostByName(const char* hostName, IPAddress& resolvedOut) {
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* resultList = nullptr;
+  if (hostName == nullptr || getaddrinfo(hostName, nullptr, &hints, &resultList) != 0 || resultList == nullptr) {
+    return 0;
+  }
+  const sockaddr_in* address = reinterpret_cast<const sockaddr_in*>(resultList->ai_addr);
+  resolvedOut = IPAddress(ntohl(address->sin_addr.s_addr));
+  freeaddrinfo(resultList);
+  return 1;
+}
+
+WiFiClient::~WiFiClient() {
+  stop();
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  stop();
+  socketFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (socketFd_ < 0) {
+    return 0;
+  }
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(ip.toHostOrder());
+  if (::connect(socketFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    stop();
+    return 0;
+  }
+  // [重要] lwIP の既定（Nagle 無効）に合わせ、小さな要求がまとめられて往復時間が歪むのを防ぐ。
+  const int noDelay = 1;
+  setsockopt(socketFd_, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  size_t sentSize = 0;
+  while (socketFd_ >= 0 && sentSize < size) {
+    const ssize_t result = send(socketFd_, buffer + sentSize, size - sentSize, MSG_NOSIGNAL);
+    if (result <= 0) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    sentSize += static_cast<size_t>(result);
+  }
+  return sentSize;
+}
+
+int WiFiClient::available() {
+  int pendingSize = 0;
+  if (socketFd_ < 0 || ioctl(socketFd_, FIONREAD, &pendingSize) != 0) {
+    return 0;
+  }
+  return pendingSize;
+}
+
+int WiFiClient::read() {
+  uint8_t value = 0;
+  return read(&value, 1) == 1 ? value : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+  if (socketFd_ < 0) {
+    return -1;
+  }
+  const ssize_t result = recv(socketFd_, buffer, size, MSG_DONTWAIT);
+  return result > 0 ? static_cast<int>(result) : -1;
+}
+
+uint8_t WiFiClient::connected() {
+  if (socketFd_ < 0) {
+    return 0;
+  }
+  uint8_t peekValue = 0;
+  const ssize_t result = recv(socketFd_, &peekValue, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (result > 0) {
+    return 1;
+  }
+  return (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 1 : 0;
+}
+
+void WiFiClient::stop() {
+  if (socketFd_ >= 0) {
+    close(socketFd_);
+    socketFd_ = -1;
+  }
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+  return &hostAppPartitions[getCurrentHostDevice()->runningPartitionIndex & 0x01];
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+  return esp_ota_get_running_partition();
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom) {
+  (void)startFrom;
+  return &hostAppPartitions[(getCurrentHostDevice()->runningPartitionIndex + 1) & 0x01];
+}
+
+void initializeLogLevel() {}
+
+void appLogWrite(esp_log_level_t logLevel, const char* levelText, const char* format, ...) {
+  if (!isHostLogVerbose && logLevel > ESP_LOG_WARN) {
+    return;
+  }
+  char messageBuffer[512] = {};
+  va_list argumentList;
+  va_start(argumentList, format);
+  vsnprintf(messageBuffer, sizeof(messageBuffer), format, argumentList);
+  va_end(argumentList);
+  fprintf(stderr, "[%s] [mac=%012llX] %s\n",
+          levelText,
+          static_cast<unsigned long long>(getCurrentHostDevice()->efuseMac & 0xFFFFFFFFFFFFULL),
+          messageBuffer);
+}
+
+void setFileLogEnabled(bool enabled) {
+  (void)enabled;
+}
+
+bool isFileLogEnabled() {
+  return false;
+}
+
+namespace firmwareInfo {
+
+bool saveOtaAppliedAt(const String& firmwareVersion, const String& firmwareWrittenAt) {
+  (void)firmwareVersion;
+  (void)firmwareWrittenAt;
+  return true;
+}
+
+String resolveFirmwareWrittenAtForStatus(const String& currentFirmwareVersion,
+                                         const String& fallbackFirmwareWrittenAt) {
+  (void)currentFirmwareVersion;
+  return fallbackFirmwareWrittenAt;
+}
+
+}  // namespace firmwareInfo
+
+namespace taskPlacement {
+
+bool getCpuLoadSnapshot(cpuLoadSnapshot* snapshotOut) {
+  if (snapshotOut == nullptr) {
+    return false;
+  }
+  *snapshotOut = cpuLoadSnapshot{false, "host", 0, {0, 0}, 0};
+  return false;
+}
+
+}  // namespace taskPlacement
@@ -0,0 +1,352 @@
+/**
+ * @file mirrorDownloadScenario.cpp
+ * @brief 複数ミラー取得（src/mirrorDownload.cpp）をホストで `mirrorStandIn` へ接続して動かす検証シナリオ。
+ * @details
+ * - [重要] ファームウェアの取得処理を無改変でリンクし、ループバック上の実ソケットで次を確認する。
+ *   - プローブで速い URL を選ぶこと（優先順が後でも速い方を使う）
+ *   - 転送中の速度低下で他の URL へ切り替え、途中位置から範囲要求で再開すること
+ *   - 範囲要求に応じない URL は先頭からの取得にだけ使い、切断後の再開には使わないこと
+ *   - 全体サイズの異なる URL を使わないこと、内容の改変を SHA-256 不一致として検出すること
+ *   - URL が1件ならプローブを省くこと、リダイレクトを追うこと、https 必須時に http を拒否すること
+ * - [重要] 出力先へ渡る順序（offset の連続性）と内容を毎回照合する。
+ * - 判定に失敗した場合は終了コード 1 を返す。
+ */
+
+#include <mbedtls/sha256.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "mirrorDownload.h"
+#include "mirrorStandIn.h"
+
+void setHostLogVerbose(bool verbose);
+
+namespace {
+
+/** @brief 既定のイメージサイズ(byte)。 */
+constexpr uint32_t kImageBytes = 1048576;
+/** @brief URL に含めない（リダイレクト先専用の）サーバーを表す値。 */
+constexpr int8_t kNotListed = -1;
+
+/**
+ * @brief ケース内のサーバー1台。
+ */
+struct caseServer {
+  /** @brief サーバー設定。@type mirrorStandInConfig */
+  mirrorStandInConfig config;
+  /** @brief 0 以上ならそのサーバーの URL へリダイレクトする。@type int8_t */
+  int8_t redirectToServerIndex;
+  /** @brief URL 配列へ入れる位置（kNotListed なら入れない）。@type int8_t */
+  int8_t urlIndex;
+  /** @brief URL を https で渡すか。@type bool */
+  bool useHttpsUrl;
+};
+
+/**
+ * @brief 出力先の状態。
+ */
+struct scenarioSink {
+  /** @brief 受け取った内容。@type std::vector<uint8_t> */
+  std::vector<uint8_t> bytes;
+  /** @brief offset が常に連続していたか。@type bool */
+  bool isInOrder = true;
+};
+
+/**
+ * @brief ケースの実行結果。
+ */
+struct caseOutcome {
+  /** @brief run の戻り値。@type bool */
+  bool runResult = false;
+  /** @brief 取得結果。@type mirrorDownloadResult */
+  mirrorDownloadResult result{};
+  /** @brief 出力先へ順に渡されたか。@type bool */
+  bool isInOrder = false;
+  /** @brief 受け取った内容が正しいイメージと一致したか。@type bool */
+  bool isContentMatched = false;
+  /** @brief サーバーごとの統計。@type std::vector<mirrorStandInStats> */
+  std::vector<mirrorStandInStats> serverStats;
+};
+
+/**
+ * @brief 出力先（受信内容を保持し、offset の連続性を確認する）。
+ */
+bool collectToSink(void* sinkContext, const uint8_t* data, size_t length, uint32_t offset, uint32_t totalBytes) {
+  scenarioSink* sink = static_cast<scenarioSink*>(sinkContext);
+  if (offset != sink->bytes.size() || static_cast<uint64_t>(offset) + length > totalBytes) {
+    sink->isInOrder = false;
+    return false;
+  }
+  sink->bytes.insert(sink->bytes.end(), data, data + length);
+  return true;
+}
+
+/**
+ * @brief 正しいイメージの SHA-256 を16進で返す。
+ */
+std::string calculateImageSha256(uint32_t imageBytes) {
+  mbedtls_sha256_context sha256Context;
+  mbedtls_sha256_init(&sha256Context);
+  mbedtls_sha256_starts_ret(&sha256Context, 0);
+  uint8_t chunk[4096];
+  for (uint32_t offset = 0; offset < imageBytes; offset += sizeof(chunk)) {
+    const uint32_t chunkSize = (imageBytes - offset < sizeof(chunk)) ? imageBytes - offset : static_cast<uint32_t>(sizeof(chunk));
+    for (uint32_t byteIndex = 0; byteIndex < chunkSize; ++byteIndex) {
+      chunk[byteIndex] = mirrorStandInImageByte(offset + byteIndex);
+    }
+    mbedtls_sha256_update_ret(&sha256Context, chunk, chunkSize);
+  }
+  unsigned char hashBytes[32];
+  mbedtls_sha256_finish_ret(&sha256Context, hashBytes);
+  mbedtls_sha256_free(&sha256Context);
+  char hashText[65];
+  for (size_t index = 0; index < 32; ++index) {
+    snprintf(&hashText[index * 2], 3, "%02x", hashBytes[index]);
+  }
+  return std::string(hashText);
+}
+
+/**
+ * @brief 既定値のサーバー設定を返す。
+ */
+caseServer makeServer(int8_t urlIndex, bool isRangeSupported, uint32_t bytesPerSecond) {
+  caseServer server{};
+  server.config.imageBytes = kImageBytes;
+  server.config.isRangeSupported = isRangeSupported;
+  server.config.bytesPerSecond = bytesPerSecond;
+  server.config.corruptOffset = UINT32_MAX;
+  server.redirectToServerIndex = -1;
+  server.urlIndex = urlIndex;
+  server.useHttpsUrl = false;
+  return server;
+}
+
+/**
+ * @brief 1ケース分を実行する。
+ * @param servers サーバー（リダイレクト先は先に起動する）。
+ * @param downloadOptions 取得条件。
+ * @return サーバーを起動できた場合true。
+ */
+bool runCase(const char* caseName,
+             std::vector<caseServer> servers,
+             const mirrorDownloadOptions& downloadOptions,
+             caseOutcome* outcomeOut) {
+  std::vector<mirrorStandIn*> standIns(servers.size(), nullptr);
+  bool isStarted = true;
+  // リダイレクトしないサーバーを先に起動し、その URL をリダイレクト元へ渡す
+  for (int pass = 0; pass < 2 && isStarted; ++pass) {
+    for (size_t serverIndex = 0; serverIndex < servers.size(); ++serverIndex) {
+      caseServer& server = servers[serverIndex];
+      if ((server.redirectToServerIndex >= 0) != (pass == 1)) {
+        continue;
+      }
+      if (server.redirectToServerIndex >= 0) {
+        server.config.redirectUrl = standIns[server.redirectToServerIndex]->url();
+      }
+      standIns[serverIndex] = new mirrorStandIn(server.config);
+      if (!standIns[serverIndex]->start()) {
+        appLogError("runCase failed. server start failed. case=%s server=%u", caseName, static_cast<unsigned>(serverIndex));
+        isStarted = false;
+        break;
+      }
+    }
+  }
+
+  if (isStarted) {
+    std::vector<String> urls;
+    for (size_t serverIndex = 0; serverIndex < servers.size(); ++serverIndex) {
+      const caseServer& server = servers[serverIndex];
+      if (server.urlIndex == kNotListed) {
+        continue;
+      }
+      if (urls.size() <= static_cast<size_t>(server.urlIndex)) {
+        urls.resize(server.urlIndex + 1);
+      }
+      std::string urlText = standIns[serverIndex]->url();
+      if (server.useHttpsUrl) {
+        urlText.replace(0, strlen("http"), "https");
+      }
+      urls[server.urlIndex] = String(urlText);
+    }
+    scenarioSink sink;
+    const std::string expectedSha256 = calculateImageSha256(kImageBytes);
+    outcomeOut->runResult = mirrorDownload::run(urls.data(), urls.size(), downloadOptions, expectedSha256.c_str(), collectToSink, &sink,
+                                                &outcomeOut->result);
+    outcomeOut->isInOrder = sink.isInOrder;
+    outcomeOut->isContentMatched = sink.bytes.size() == outcomeOut->result.downloadedBytes;
+    for (size_t offset = 0; offset < sink.bytes.size() && outcomeOut->isContentMatched; ++offset) {
+      outcomeOut->isContentMatched = sink.bytes[offset] == mirrorStandInImageByte(static_cast<uint32_t>(offset));
+    }
+  }
+
+  for (size_t serverIndex = 0; serverIndex < standIns.size(); ++serverIndex) {
+    if (standIns[serverIndex] != nullptr) {
+      standIns[serverIndex]->stop();
+      outcomeOut->serverStats.push_back(standIns[serverIndex]->stats());
+      delete standIns[serverIndex];
+    } else {
+      outcomeOut->serverStats.push_back(mirrorStandInStats{});
+    }
+  }
+  return isStarted;
+}
+
+/**
+ * @brief ケースの結果を表示し、判定を返す。
+ */
+bool reportCase(const char* caseName, const caseOutcome& outcome, bool isPassed) {
+  const mirrorDownloadResult& result = outcome.result;
+  printf("--- case %s ---\n", caseName);
+  printf("run=%d detail=%s total=%u downloaded=%u elapsedMs=%u switches=%u final=%d usedMask=0x%02X inOrder=%d content=%d\n",
+         outcome.runResult ? 1 : 0, result.detail, static_cast<unsigned>(result.totalBytes),
+         static_cast<unsigned>(result.downloadedBytes), static_cast<unsigned>(result.elapsedMs),
+         static_cast<unsigned>(result.switchCount), static_cast<int>(result.finalSourceIndex),
+         static_cast<unsigned>(result.usedSourceMask), outcome.isInOrder ? 1 : 0, outcome.isContentMatched ? 1 : 0);
+  for (uint8_t sourceIndex = 0; sourceIndex < result.sourceCount; ++sourceIndex) {
+    const mirrorDownloadSourceStats& source = result.sources[sourceIndex];
+    printf("source[%u] probe=%d range=%d firstByteMs=%u kbps=%u downloaded=%u failures=%u detail=%s\n",
+           static_cast<unsigned>(sourceIndex), source.isProbeOk ? 1 : 0, source.isRangeSupported ? 1 : 0,
+           static_cast<unsigned>(source.probeFirstByteMs), static_cast<unsigned>(source.probeKbps),
+           static_cast<unsigned>(source.downloadedBytes), static_cast<unsigned>(source.failureCount), source.detail);
+  }
+  for (size_t serverIndex = 0; serverIndex < outcome.serverStats.size(); ++serverIndex) {
+    const mirrorStandInStats& serverStats = outcome.serverStats[serverIndex];
+    printf("server[%u] connections=%u partial=%u resumes=%u bodyBytes=%llu badRequests=%u\n",
+           static_cast<unsigned>(serverIndex), static_cast<unsigned>(serverStats.connectionCount),
+           static_cast<unsigned>(serverStats.partialResponseCount), static_cast<unsigned>(serverStats.resumeRequestCount),
+           static_cast<unsigned long long>(serverStats.bodyBytes), static_cast<unsigned>(serverStats.badRequestCount));
+  }
+  printf("case result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed;
+}
+
+/**
+ * @brief 全量を正しく取得できたか。
+ */
+bool isCompleteAndVerified(const caseOutcome& outcome) {
+  return outcome.runResult && outcome.isInOrder && outcome.isContentMatched && outcome.result.downloadedBytes == kImageBytes &&
+         strcmp(outcome.result.detail, "ok") == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool isVerbose = false;
+  for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex) {
+    if (strcmp(argv[argumentIndex], "--verbose") == 0) {
+      isVerbose = true;
+    } else {
+      printf("usage: %s [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  setHostLogVerbose(isVerbose);
+
+  mirrorDownloadOptions downloadOptions = mirrorDownload::getDefaultOptions();
+  downloadOptions.throughputWindowMs = 500;
+  downloadOptions.idleTimeoutMs = 2000;
+  downloadOptions.totalTimeoutMs = 30000;
+
+  printf("=== mirrorDownloadScenario report ===\n");
+  bool isPassed = true;
+
+  {
+    // 優先順で先の URL が遅い（200KB/s）場合、後ろの速い URL を選ぶ
+    caseOutcome outcome;
+    const bool isStarted = runCase("fastest", {makeServer(0, true, 204800), makeServer(1, true, 0)}, downloadOptions, &outcome);
+    isPassed = reportCase("fastest",
+                          outcome,
+                          isStarted && isCompleteAndVerified(outcome) && outcome.result.finalSourceIndex == 1 &&
+                              outcome.result.usedSourceMask == 0x02 && outcome.result.switchCount == 0) &&
+               isPassed;
+  }
+  {
+    // 速い URL が 256KB 後に 16KB/s へ落ちる。1MB/s の URL へ切り替え、途中位置から再開する
+    caseServer collapsingServer = makeServer(0, true, 0);
+    collapsingServer.config.collapseAfterBytes = 262144;
+    collapsingServer.config.collapsedBytesPerSecond = 16384;
+    caseOutcome outcome;
+    const bool isStarted = runCase("collapse", {collapsingServer, makeServer(1, true, 1048576)}, downloadOptions, &outcome);
+    isPassed = reportCase("collapse",
+                          outcome,
+                          isStarted && isCompleteAndVerified(outcome) && outcome.result.usedSourceMask == 0x03 &&
+                              outcome.result.finalSourceIndex == 1 && outcome.result.switchCount >= 1 &&
+                              outcome.serverStats[1].resumeRequestCount >= 1) &&
+               isPassed;
+  }
+  {
+    // 範囲要求に応じない速い URL が 300KB で切断する。再開は範囲要求に応じる URL だけで行う
+    caseServer noRangeServer = makeServer(0, false, 0);
+    noRangeServer.config.disconnectAfterBytes = 307200;
+    caseOutcome outcome;
+    const bool isStarted = runCase("noRangeResume", {noRangeServer, makeServer(1, true, 2097152)}, downloadOptions, &outcome);
+    isPassed = reportCase("noRangeResume",
+                          outcome,
+                          isStarted && isCompleteAndVerified(outcome) && outcome.result.usedSourceMask == 0x03 &&
+                              !outcome.result.sources[0].isRangeSupported && outcome.serverStats[0].resumeRequestCount == 0 &&
+                              outcome.serverStats[1].resumeRequestCount >= 1) &&
+               isPassed;
+  }
+  {
+    // 後ろの URL はサイズが異なる。速くても使わない
+    caseServer wrongSizeServer = makeServer(1, true, 0);
+    wrongSizeServer.config.imageBytes = kImageBytes + 1;
+    caseOutcome outcome;
+    const bool isStarted = runCase("sizeMismatch", {makeServer(0, true, 4194304), wrongSizeServer}, downloadOptions, &outcome);
+    isPassed = reportCase("sizeMismatch",
+                          outcome,
+                          isStarted && isCompleteAndVerified(outcome) && outcome.result.usedSourceMask == 0x01 &&
+                              strcmp(outcome.result.sources[1].detail, "size mismatch") == 0) &&
+               isPassed;
+  }
+  {
+    // 速い URL の内容が 1 byte 改変されている。全量受信後に SHA-256 不一致で失敗する
+    caseServer corruptServer = makeServer(0, true, 0);
+    corruptServer.config.corruptOffset = 524288;
+    caseOutcome outcome;
+    const bool isStarted = runCase("corrupt", {corruptServer, makeServer(1, true, 204800)}, downloadOptions, &outcome);
+    isPassed = reportCase("corrupt",
+                          outcome,
+                          isStarted && !outcome.runResult && strcmp(outcome.result.detail, "sha256 mismatch") == 0 &&
+                              strlen(outcome.result.sha256Hex) == 64 && outcome.result.usedSourceMask == 0x01 &&
+                              outcome.result.downloadedBytes == kImageBytes) &&
+               isPassed;
+  }
+  {
+    // URL が1件ならプローブしない。リダイレクト先から取得する
+    caseServer redirectServer = makeServer(0, true, 0);
+    redirectServer.redirectToServerIndex = 1;
+    caseOutcome outcome;
+    const bool isStarted = runCase("singleRedirect", {redirectServer, makeServer(kNotListed, true, 0)}, downloadOptions, &outcome);
+    isPassed = reportCase("singleRedirect",
+                          outcome,
+                          isStarted && isCompleteAndVerified(outcome) && outcome.serverStats[0].connectionCount == 1 &&
+                              outcome.serverStats[1].connectionCount == 1 && outcome.result.sources[0].isRangeSupported) &&
+               isPassed;
+  }
+  {
+    // https 必須: http の URL は拒否し、https の URL はホストシムの TLS 失敗として記録する
+    mirrorDownloadOptions httpsOptions = downloadOptions;
+    httpsOptions.isHttpsRequired = true;
+    httpsOptions.tlsCaCertificate = "-----BEGIN CERTIFICATE-----\nhost-shim\n-----END CERTIFICATE-----\n";
+    caseServer tlsServer = makeServer(0, true, 0);
+    tlsServer.useHttpsUrl = true;
+    caseOutcome outcome;
+    const bool isStarted = runCase("httpsRequired", {tlsServer, makeServer(1, true, 0)}, httpsOptions, &outcome);
+    isPassed = reportCase("httpsRequired",
+                          outcome,
+                          isStarted && !outcome.runResult && strcmp(outcome.result.detail, "all probes failed") == 0 &&
+                              strcmp(outcome.result.sources[0].detail, "tls connect failed") == 0 &&
+                              strcmp(outcome.result.sources[1].detail, "https required") == 0 &&
+                              outcome.result.downloadedBytes == 0 && outcome.serverStats[1].connectionCount == 0) &&
+               isPassed;
+  }
+
+  printf("result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file mirrorStandIn.cpp
+ * @brief ミラー取得検証用のイメージ配信サーバー代替の実装。
+ * @details
+ * - [重要] 要求ヘッダーは空行まで読み、`Range` だけ解釈する。応答後は接続を閉じる。
+ * - [重要] 送信速度は 1KB ごとに「送信済み量 / 速度」の時刻まで待って合わせる。
+ */
+
+#include "mirrorStandIn.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+
+namespace {
+
+/** @brief 停止要求を確認する周期(ms)。 */
+constexpr int kPollSliceMs = 100;
+/** @brief 要求ヘッダーを待つ上限(ms)。 */
+constexpr int kHeaderTimeoutMs = 5000;
+/** @brief 要求ヘッダーの上限(byte)。 */
+constexpr size_t kMaxHeaderBytes = 4096;
+/** @brief 送信1回の単位(byte)。 */
+constexpr uint32_t kSendChunkBytes = 1024;
+
+/**
+ * @brief 要求ヘッダーから `Range: bytes=a-[b]` を取り出す。
+ * @return Range ヘッダーがあり解釈できた場合true。
+ */
+bool findRange(const std::string& headerText, uint32_t* firstOut, uint32_t* lastOut, bool* hasLastOut) {
+  size_t lineStart = 0;
+  while (lineStart < headerText.size()) {
+    const size_t lineEnd = headerText.find("\r\n", lineStart);
+    const std::string line = headerText.substr(lineStart, lineEnd == std::string::npos ? std::string::npos : lineEnd - lineStart);
+    if (strncasecmp(line.c_str(), "Range:", 6) == 0) {
+      const char* rangeText = strstr(line.c_str(), "bytes=");
+      if (rangeText == nullptr) {
+        return false;
+      }
+      char* cursor = nullptr;
+      *firstOut = static_cast<uint32_t>(strtoul(rangeText + 6, &cursor, 10));
+      if (cursor == nullptr || *cursor != '-') {
+        return false;
+      }
+      *hasLastOut = cursor[1] >= '0' && cursor[1] <= '9';
+      *lastOut = *hasLastOut ? static_cast<uint32_t>(strtoul(cursor + 1, nullptr, 10)) : 0;
+      return true;
+    }
+    if (lineEnd == std::string::npos) {
+      break;
+    }
+    lineStart = lineEnd + 2;
+  }
+  return false;
+}
+
+}  // namespace
+
+mirrorStandIn::mirrorStandIn(const mirrorStandInConfig& config)
+    : config_(config), listenFd_(-1), boundPort_(0), isStopping_(false), stats_{} {}
+
+mirrorStandIn::~mirrorStandIn() {
+  stop();
+}
+
+bool mirrorStandIn::start() {
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) {
+    fprintf(stderr, "mirrorStandIn::start failed. socket errno=%d\n", errno);
+    return false;
+  }
+  const int reuseAddress = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config_.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd_, 4) != 0) {
+    fprintf(stderr, "mirrorStandIn::start failed. bind/listen errno=%d port=%u\n", errno, static_cast<unsigned>(config_.port));
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  socklen_t addressLength = sizeof(address);
+  getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &addressLength);
+  boundPort_ = ntohs(address.sin_port);
+  isStopping_ = false;
+  acceptThread_ = std::thread(&mirrorStandIn::acceptLoop, this);
+  return true;
+}
+
+void mirrorStandIn::stop() {
+  isStopping_ = true;
+  if (acceptThread_.joinable()) {
+    acceptThread_.join();
+  }
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+    listenFd_ = -1;
+  }
+}
+
+void mirrorStandIn::acceptLoop() {
+  while (!isStopping_) {
+    pollfd listenPoll = {listenFd_, POLLIN, 0};
+    if (poll(&listenPoll, 1, kPollSliceMs) <= 0) {
+      continue;
+    }
+    const int connectionFd = accept(listenFd_, nullptr, nullptr);
+    if (connectionFd < 0) {
+      continue;
+    }
+    const int noDelay = 1;
+    setsockopt(connectionFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    ++stats_.connectionCount;
+    serveConnection(connectionFd);
+    close(connectionFd);
+  }
+}
+
+bool mirrorStandIn::sendAll(int connectionFd, const char* data, size_t length) {
+  size_t sentSize = 0;
+  while (sentSize < length) {
+    const ssize_t result = send(connectionFd, data + sentSize, length - sentSize, MSG_NOSIGNAL);
+    if (result <= 0) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sentSize += static_cast<size_t>(result);
+  }
+  return true;
+}
+
+bool mirrorStandIn::sendBody(int connectionFd, uint32_t firstOffset, uint32_t bodyBytes) {
+  char chunk[kSendChunkBytes];
+  uint32_t sentBytes = 0;
+  // 速度区間（通常 → 低下後）ごとに、区間の開始時刻と開始時の送信量から待ち時間を決める
+  std::chrono::steady_clock::time_point segmentStart = std::chrono::steady_clock::now();
+  uint32_t segmentStartBytes = 0;
+  bool isCollapsed = false;
+  while (sentBytes < bodyBytes && !isStopping_) {
+    if (config_.disconnectAfterBytes > 0 && sentBytes >= config_.disconnectAfterBytes) {
+      return false;
+    }
+    if (!isCollapsed && config_.collapseAfterBytes > 0 && sentBytes >= config_.collapseAfterBytes) {
+      isCollapsed = true;
+      segmentStart = std::chrono::steady_clock::now();
+      segmentStartBytes = sentBytes;
+    }
+    uint32_t chunkSize = bodyBytes - sentBytes;
+    chunkSize = (chunkSize > kSendChunkBytes) ? kSendChunkBytes : chunkSize;
+    for (uint32_t byteIndex = 0; byteIndex < chunkSize; ++byteIndex) {
+      const uint32_t offset = firstOffset + sentBytes + byteIndex;
+      const uint8_t value = mirrorStandInImageByte(offset);
+      chunk[byteIndex] = static_cast<char>(offset == config_.corruptOffset ? static_cast<uint8_t>(~value) : value);
+    }
+    if (!sendAll(connectionFd, chunk, chunkSize)) {
+      return false;
+    }
+    sentBytes += chunkSize;
+    stats_.bodyBytes += chunkSize;
+    const uint32_t bytesPerSecond = isCollapsed ? config_.collapsedBytesPerSecond : config_.bytesPerSecond;
+    if (bytesPerSecond > 0) {
+      const uint64_t dueUs = static_cast<uint64_t>(sentBytes - segmentStartBytes) * 1000000ULL / bytesPerSecond;
+      std::this_thread::sleep_until(segmentStart + std::chrono::microseconds(dueUs));
+    }
+  }
+  return true;
+}
+
+void mirrorStandIn::serveConnection(int connectionFd) {
+  std::string pendingText;
+  char receiveBuffer[1024];
+  int waitedMs = 0;
+  size_t headerEnd = std::string::npos;
+  while (!isStopping_ && (headerEnd = pendingText.find("\r\n\r\n")) == std::string::npos) {
+    if (pendingText.size() > kMaxHeaderBytes || waitedMs >= kHeaderTimeoutMs) {
+      ++stats_.badRequestCount;
+      return;
+    }
+    pollfd connectionPoll = {connectionFd, POLLIN, 0};
+    if (poll(&connectionPoll, 1, kPollSliceMs) <= 0) {
+      waitedMs += kPollSliceMs;
+      continue;
+    }
+    const ssize_t receivedSize = recv(connectionFd, receiveBuffer, sizeof(receiveBuffer), 0);
+    if (receivedSize <= 0) {
+      return;
+    }
+    pendingText.append(receiveBuffer, static_cast<size_t>(receivedSize));
+  }
+  if (headerEnd == std::string::npos) {
+    return;
+  }
+  const std::string headerText = pendingText.substr(0, headerEnd);
+  if (headerText.rfind("GET ", 0) != 0) {
+    ++stats_.badRequestCount;
+    return;
+  }
+
+  char responseHeader[256];
+  int headerLength = 0;
+  if (!config_.redirectUrl.empty()) {
+    headerLength = snprintf(responseHeader,
+                            sizeof(responseHeader),
+                            "HTTP/1.1 302 Found\r\nLocation: %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                            config_.redirectUrl.c_str());
+    sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength));
+    return;
+  }
+
+  uint32_t firstOffset = 0;
+  uint32_t lastOffset = 0;
+  bool hasLastOffset = false;
+  const bool hasRange = findRange(headerText, &firstOffset, &lastOffset, &hasLastOffset);
+  if (hasRange && config_.isRangeSupported) {
+    if (firstOffset >= config_.imageBytes) {
+      headerLength = snprintf(responseHeader,
+                              sizeof(responseHeader),
+                              "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%u\r\nContent-Length: 0\r\n"
+                              "Connection: close\r\n\r\n",
+                              static_cast<unsigned>(config_.imageBytes));
+      sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength));
+      return;
+    }
+    if (!hasLastOffset || lastOffset >= config_.imageBytes) {
+      lastOffset = config_.imageBytes - 1;
+    }
+    ++stats_.partialResponseCount;
+    stats_.resumeRequestCount += (firstOffset > 0) ? 1 : 0;
+    headerLength = snprintf(responseHeader,
+                            sizeof(responseHeader),
+                            "HTTP/1.1 206 Partial Content\r\nContent-Type: application/octet-stream\r\n"
+                            "Content-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+                            static_cast<unsigned>(firstOffset),
+                            static_cast<unsigned>(lastOffset),
+                            static_cast<unsigned>(config_.imageBytes),
+                            static_cast<unsigned>(lastOffset - firstOffset + 1));
+    if (sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength))) {
+      sendBody(connectionFd, firstOffset, lastOffset - firstOffset + 1);
+    }
+    return;
+  }
+  headerLength = snprintf(responseHeader,
+                          sizeof(responseHeader),
+                          "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %u\r\n"
+                          "Connection: close\r\n\r\n",
+                          static_cast<unsigned>(config_.imageBytes));
+  if (sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength))) {
+    sendBody(connectionFd, 0, config_.imageBytes);
+  }
+}
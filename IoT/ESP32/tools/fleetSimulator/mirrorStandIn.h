@@ -0,0 +1,107 @@
+/**
+ * @file mirrorStandIn.h
+ * @brief ミラー取得（mirrorDownload）検証用のイメージ配信サーバー代替（ホスト用 HTTP/1.1 サーバー）定義。
+ * @details
+ * - [重要] 任意のパスへの GET に、mirrorStandInImageByte で決まる内容のイメージを返す。`Range: bytes=a-` / `bytes=a-b` に
+ *   206 で応じる（範囲要求に非対応の設定では常に 200 で全体を返す）。
+ * - [重要] LocalServer のキャッシュとクラウドのオリジンの違いを、送信速度、接続内での速度低下・切断、内容の改変、
+ *   サイズ違い、リダイレクトで再現する。
+ * - [制限] 平文 TCP のみ。1接続1要求（`Connection: close`）。接続は受付順に1本ずつ処理する。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * @brief イメージの offset 位置の内容を返す（検証側の期待値計算にも使う）。
+ */
+inline uint8_t mirrorStandInImageByte(uint32_t offset) {
+  return static_cast<uint8_t>((offset * 131U) ^ (offset >> 9) ^ 0x5AU);
+}
+
+/**
+ * @brief サーバー設定。
+ */
+struct mirrorStandInConfig {
+  /** @brief 待受ポート。0 なら空きポートを割り当てる。@type uint16_t */
+  uint16_t port;
+  /** @brief 配信するイメージのサイズ(byte)。@type uint32_t */
+  uint32_t imageBytes;
+  /** @brief 範囲要求に 206 で応じるか。@type bool */
+  bool isRangeSupported;
+  /** @brief 送信速度(byte/s)。0 で制限しない。@type uint32_t */
+  uint32_t bytesPerSecond;
+  /** @brief 1接続でこの量(byte)を送った後は collapsedBytesPerSecond へ落とす。0 で落とさない。@type uint32_t */
+  uint32_t collapseAfterBytes;
+  /** @brief 速度低下後の送信速度(byte/s)。@type uint32_t */
+  uint32_t collapsedBytesPerSecond;
+  /** @brief 1接続でこの量(byte)を送ったら切断する。0 で切断しない。@type uint32_t */
+  uint32_t disconnectAfterBytes;
+  /** @brief この位置の内容を反転して配信する。UINT32_MAX で改変しない。@type uint32_t */
+  uint32_t corruptOffset;
+  /** @brief 空でなければ全要求へ 302 でこの URL を返す。@type std::string */
+  std::string redirectUrl;
+};
+
+/**
+ * @brief サーバー側の累積統計（stop() 後に参照する）。
+ */
+struct mirrorStandInStats {
+  /** @brief 受け付けた接続数。@type uint32_t */
+  uint32_t connectionCount;
+  /** @brief 206 で応じた要求数。@type uint32_t */
+  uint32_t partialResponseCount;
+  /** @brief 先頭以外から始まる範囲要求の数。@type uint32_t */
+  uint32_t resumeRequestCount;
+  /** @brief 送った本文(byte)。@type uint64_t */
+  uint64_t bodyBytes;
+  /** @brief 解釈できなかった要求数。@type uint32_t */
+  uint32_t badRequestCount;
+};
+
+/**
+ * @brief イメージ配信サーバー代替。
+ */
+class mirrorStandIn {
+ public:
+  explicit mirrorStandIn(const mirrorStandInConfig& config);
+  ~mirrorStandIn();
+  mirrorStandIn(const mirrorStandIn&) = delete;
+  mirrorStandIn& operator=(const mirrorStandIn&) = delete;
+
+  /**
+   * @brief ループバックで待受を開始し、受付スレッドを起動する。
+   * @return 成功時true。
+   */
+  bool start();
+
+  /**
+   * @brief 受付スレッドを止める（処理中の接続は閉じる）。
+   */
+  void stop();
+
+  /** @brief 実際の待受ポートを返す。 */
+  uint16_t port() const { return boundPort_; }
+  /** @brief イメージの URL を返す。 */
+  std::string url() const { return "http://127.0.0.1:" + std::to_string(boundPort_) + "/image.bin"; }
+  /** @brief 累積統計を返す。 */
+  const mirrorStandInStats& stats() const { return stats_; }
+
+ private:
+  void acceptLoop();
+  void serveConnection(int connectionFd);
+  bool sendAll(int connectionFd, const char* data, size_t length);
+  bool sendBody(int connectionFd, uint32_t firstOffset, uint32_t bodyBytes);
+
+  mirrorStandInConfig config_;
+  int listenFd_;
+  uint16_t boundPort_;
+  std::atomic<bool> isStopping_;
+  std::thread acceptThread_;
+  mirrorStandInStats stats_;
+};
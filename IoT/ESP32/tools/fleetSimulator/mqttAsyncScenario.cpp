@@ -0,0 +1,338 @@
+/**
+ * @file mqttAsyncScenario.cpp
+ * @brief `mqttAsyncClient`（src/MQTT/mqttAsyncClient.cpp）をホストで `mqttWireBroker` へ接続して動かす検証シナリオ。
+ * @details
+ * - [重要] ファームウェアのクライアント中核を無改変でリンクし、次を1回の実行で確認する。
+ *   - 通信路が数 byte ずつしか受理/返却しない状態での送信キューと逐次解析
+ *   - QoS1 送信窓の上限、packet id の払い出しと PUBACK での解放
+ *   - PUBACK 前の切断と、再接続後の再送（欠落なし）。セッション継続時は DUP=1、`--clean-session` では DUP=0
+ *   - 受信上限を超えない範囲の大きなコマンド PUBLISH（QoS1）の受信と PUBACK 応答
+ * - [重要] 仮想時刻（1 tick = `kTickMs`）で動作し、実時間待機しない。
+ * - 判定に失敗した場合は終了コード 1 を返す。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "log.h"
+#include "mqttAsyncClient.h"
+#include "mqttWireBroker.h"
+
+void setHostLogVerbose(bool verbose);
+
+namespace {
+
+/** @brief 1 tick の仮想時間(ms)。 */
+constexpr uint32_t kTickMs = 10;
+/** @brief 送信トピック。 */
+constexpr const char* kPublishTopic = "esp32lab/notice/sequence/IoT_sim";
+/** @brief 購読フィルタ。 */
+constexpr const char* kCommandFilter = "esp32lab/call/+/IoT_sim";
+/** @brief 注入するコマンドのトピック。 */
+constexpr const char* kCommandTopic = "esp32lab/call/fileSyncChunk/IoT_sim";
+/** @brief 全件 PUBACK 後に残りの受信を流し切るための tick 数。 */
+constexpr uint32_t kDrainTicks = 500;
+
+/**
+ * @brief シナリオ設定。
+ */
+struct scenarioOptions {
+  uint32_t messageCount = 2000;
+  uint32_t inflightWindow = 8;
+  uint32_t payloadBytes = 512;
+  uint32_t maxAcceptBytes = 300;
+  uint32_t maxDeliverBytes = 97;
+  uint32_t responseDelayTicks = 3;
+  uint32_t dropAfterPublishCount = 700;
+  uint32_t commandIntervalTicks = 50;
+  uint32_t commandBytes = 3000;
+  uint32_t maxTicks = 2000000;
+  uint32_t seed = 1;
+  bool isCleanSession = false;
+  bool isVerbose = false;
+};
+
+/**
+ * @brief クライアント側の観測値。
+ */
+struct scenarioObservation {
+  uint32_t ackedCount = 0;
+  uint32_t commandReceivedCount = 0;
+  uint32_t commandSizeMismatchCount = 0;
+  uint32_t subscribeAckCount = 0;
+  uint32_t expectedCommandBytes = 0;
+};
+
+void printUsage(const char* programName) {
+  printf("usage: %s [options]\n"
+         "  --messages N            QoS1 publish count (default 2000)\n"
+         "  --window N              QoS1 inflight window 1..%u (default 8)\n"
+         "  --payload-bytes N       publish payload bytes (default 512)\n"
+         "  --max-accept-bytes N    broker accepts 1..N bytes per write (default 300)\n"
+         "  --max-deliver-bytes N   broker returns 1..N bytes per read (default 97)\n"
+         "  --response-delay N      broker response delay ticks (default 3)\n"
+         "  --drop-every N          drop connection every N publishes, 0=off (default 700)\n"
+         "  --command-interval N    inject call/fileSyncChunk every N ticks, 0=off (default 50)\n"
+         "  --command-bytes N       injected command payload bytes (default 3000)\n"
+         "  --seed N                random seed (default 1)\n"
+         "  --clean-session         connect with Clean Session=1 (resend without DUP)\n"
+         "  --verbose               print client INFO logs\n",
+         programName, static_cast<unsigned>(mqttAsync::kMaxInflightWindow));
+}
+
+bool parseUnsignedOption(const char* text, uint32_t* valueOut) {
+  if (text == nullptr || valueOut == nullptr) {
+    appLogError("parseUnsignedOption failed. text=%p valueOut=%p", text, valueOut);
+    return false;
+  }
+  char* endPointer = nullptr;
+  const unsigned long parsedValue = strtoul(text, &endPointer, 10);
+  if (endPointer == text || *endPointer != '\0') {
+    appLogError("parseUnsignedOption failed. not a number. text=%s", text);
+    return false;
+  }
+  *valueOut = static_cast<uint32_t>(parsedValue);
+  return true;
+}
+
+/**
+ * @brief コマンドライン引数を解析する。
+ * @return 解析成功時true。--help 時や不正引数時false。
+ */
+bool parseOptions(int argc, char** argv, scenarioOptions* optionsOut) {
+  if (optionsOut == nullptr) {
+    appLogError("parseOptions failed. optionsOut is null.");
+    return false;
+  }
+  for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex) {
+    const std::string argument = argv[argumentIndex];
+    const char* nextValue = (argumentIndex + 1 < argc) ? argv[argumentIndex + 1] : nullptr;
+    uint32_t* targetValue = nullptr;
+    if (argument == "--messages") {
+      targetValue = &optionsOut->messageCount;
+    } else if (argument == "--window") {
+      targetValue = &optionsOut->inflightWindow;
+    } else if (argument == "--payload-bytes") {
+      targetValue = &optionsOut->payloadBytes;
+    } else if (argument == "--max-accept-bytes") {
+      targetValue = &optionsOut->maxAcceptBytes;
+    } else if (argument == "--max-deliver-bytes") {
+      targetValue = &optionsOut->maxDeliverBytes;
+    } else if (argument == "--response-delay") {
+      targetValue = &optionsOut->responseDelayTicks;
+    } else if (argument == "--drop-every") {
+      targetValue = &optionsOut->dropAfterPublishCount;
+    } else if (argument == "--command-interval") {
+      targetValue = &optionsOut->commandIntervalTicks;
+    } else if (argument == "--command-bytes") {
+      targetValue = &optionsOut->commandBytes;
+    } else if (argument == "--seed") {
+      targetValue = &optionsOut->seed;
+    } else if (argument == "--clean-session") {
+      optionsOut->isCleanSession = true;
+      continue;
+    } else if (argument == "--verbose") {
+      optionsOut->isVerbose = true;
+      continue;
+    } else {
+      if (argument != "--help" && argument != "-h") {
+        appLogError("parseOptions failed. unknown argument=%s", argument.c_str());
+      }
+      printUsage(argv[0]);
+      return false;
+    }
+    if (!parseUnsignedOption(nextValue, targetValue)) {
+      appLogError("parseOptions failed. invalid value. argument=%s", argument.c_str());
+      return false;
+    }
+    ++argumentIndex;
+  }
+  if (optionsOut->inflightWindow == 0 || optionsOut->inflightWindow > mqttAsync::kMaxInflightWindow) {
+    appLogError("parseOptions failed. window must be 1..%u.", static_cast<unsigned>(mqttAsync::kMaxInflightWindow));
+    return false;
+  }
+  return true;
+}
+
+void onPublishAck(void* context, uint16_t packetId) {
+  (void)packetId;
+  ++static_cast<scenarioObservation*>(context)->ackedCount;
+}
+
+void onSubscribeAck(void* context, uint16_t packetId, uint8_t returnCode) {
+  (void)packetId;
+  if (returnCode != 0x80) {
+    ++static_cast<scenarioObservation*>(context)->subscribeAckCount;
+  }
+}
+
+void onMessage(void* context, const mqttAsync::mqttIncomingMessage& message) {
+  scenarioObservation* observation = static_cast<scenarioObservation*>(context);
+  ++observation->commandReceivedCount;
+  if (message.payloadLength != observation->expectedCommandBytes) {
+    ++observation->commandSizeMismatchCount;
+  }
+}
+
+/**
+ * @brief 連番入りの publish payload を作る。
+ */
+std::string buildSequencePayload(uint32_t sequence, uint32_t payloadBytes) {
+  char prefix[24];
+  const int prefixLength = snprintf(prefix, sizeof(prefix), "seq=%08u;", static_cast<unsigned>(sequence));
+  std::string payload(prefix, static_cast<size_t>(prefixLength));
+  if (payload.size() < payloadBytes) {
+    payload.append(payloadBytes - payload.size(), static_cast<char>('a' + (sequence % 26)));
+  }
+  return payload;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  scenarioOptions options;
+  if (!parseOptions(argc, argv, &options)) {
+    return 2;
+  }
+  setHostLogVerbose(options.isVerbose);
+
+  mqttWireBrokerConfig brokerConfig = {};
+  brokerConfig.maxAcceptBytesPerWrite = options.maxAcceptBytes;
+  brokerConfig.maxDeliverBytesPerRead = options.maxDeliverBytes;
+  brokerConfig.responseDelayTicks = options.responseDelayTicks;
+  brokerConfig.dropAfterPublishCount = options.dropAfterPublishCount;
+  brokerConfig.seed = options.seed;
+  mqttWireBroker broker(brokerConfig);
+
+  mqttAsync::mqttAsyncClientConfig clientConfig = mqttAsync::getDefaultMqttAsyncClientConfig();
+  clientConfig.sendQueueBytes = 16384;
+  clientConfig.maxIncomingPacketBytes = options.commandBytes + 256;
+  clientConfig.inflightWindow = static_cast<uint8_t>(options.inflightWindow);
+  clientConfig.maxWriteBytesPerPoll = 512;
+  clientConfig.keepAliveSeconds = 1;
+  mqttAsync::mqttAsyncClient client;
+  if (!client.initialize(clientConfig)) {
+    appLogError("main failed. client initialize returned false.");
+    return 1;
+  }
+  scenarioObservation observation;
+  observation.expectedCommandBytes = options.commandBytes;
+  client.setPublishAckHandler(onPublishAck, &observation);
+  client.setSubscribeAckHandler(onSubscribeAck, &observation);
+  client.setMessageHandler(onMessage, &observation);
+
+  mqttAsync::mqttConnectOptions connectOptions = {};
+  connectOptions.clientId = "IoT_sim";
+  connectOptions.cleanSession = options.isCleanSession;
+  const std::string commandPayload(options.commandBytes, 'c');
+
+  uint32_t nextSequence = 0;
+  uint32_t sessionCount = 0;
+  uint32_t windowFullCount = 0;
+  uint32_t injectedCommandCount = 0;
+  bool isSubscribed = false;
+  uint32_t drainTicksLeft = kDrainTicks;
+  uint32_t tickIndex = 0;
+  const auto startedAt = std::chrono::steady_clock::now();
+
+  for (; tickIndex < options.maxTicks; ++tickIndex) {
+    const uint32_t nowMs = tickIndex * kTickMs;
+    if (client.state() == mqttAsync::mqttClientState::kDisconnected) {
+      mqttAsync::mqttTransport transport = {};
+      if (!broker.openConnection(&transport) || !client.beginSession(transport, connectOptions, nowMs)) {
+        appLogError("main failed. session start failed. tick=%u", static_cast<unsigned>(tickIndex));
+        return 1;
+      }
+      isSubscribed = false;
+      ++sessionCount;
+    }
+    if (client.isConnected() && !isSubscribed) {
+      isSubscribed = client.subscribe(kCommandFilter, mqttAsync::mqttQos::kAtLeastOnce, nullptr) ==
+                     mqttAsync::mqttEnqueueResult::kQueued;
+    }
+    while (nextSequence < options.messageCount) {
+      const std::string payload = buildSequencePayload(nextSequence, options.payloadBytes);
+      const mqttAsync::mqttEnqueueResult enqueueResult =
+          client.publish(kPublishTopic, reinterpret_cast<const uint8_t*>(payload.data()), payload.size(),
+                         mqttAsync::mqttQos::kAtLeastOnce, false, nullptr);
+      if (enqueueResult != mqttAsync::mqttEnqueueResult::kQueued) {
+        if (enqueueResult == mqttAsync::mqttEnqueueResult::kWindowFull) {
+          ++windowFullCount;
+        }
+        break;
+      }
+      ++nextSequence;
+    }
+    const bool isPublishDone = observation.ackedCount >= options.messageCount && client.inflightCount() == 0;
+    if (!isPublishDone && options.commandIntervalTicks > 0 && tickIndex % options.commandIntervalTicks == 0) {
+      injectedCommandCount += static_cast<uint32_t>(broker.injectPublish(kCommandTopic, commandPayload, 1));
+    }
+    client.poll(nowMs);
+    broker.tick();
+    if (isPublishDone && --drainTicksLeft == 0) {
+      break;
+    }
+  }
+  const double wallSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+
+  // 判定
+  uint32_t missingCount = 0;
+  const std::map<std::string, uint32_t>& receivedCounts = broker.receivedPublishCounts();
+  for (uint32_t sequence = 0; sequence < options.messageCount; ++sequence) {
+    const std::string key = std::string(kPublishTopic) + "\n" + buildSequencePayload(sequence, options.payloadBytes);
+    if (receivedCounts.find(key) == receivedCounts.end()) {
+      ++missingCount;
+    }
+  }
+  const mqttAsync::mqttAsyncClientStats& clientStats = client.stats();
+  const mqttWireBrokerStats& brokerStats = broker.stats();
+  const bool isPassed = missingCount == 0 && observation.ackedCount == options.messageCount &&
+                        clientStats.protocolErrorCount == 0 && brokerStats.malformedCount == 0 &&
+                        observation.commandSizeMismatchCount == 0 &&
+                        observation.commandReceivedCount == brokerStats.deliveredToClientCount &&
+                        (options.dropAfterPublishCount == 0 || brokerStats.droppedConnectionCount == 0 ||
+                         clientStats.retransmitCount > 0) &&
+                        (options.isCleanSession ? brokerStats.duplicatePublishCount == 0
+                                                : (clientStats.retransmitCount == 0 ||
+                                                   brokerStats.duplicatePublishCount > 0));
+
+  printf("=== mqttAsyncScenario report ===\n");
+  printf("messages=%u window=%u payload=%uB accept<=%uB deliver<=%uB delay=%uticks dropEvery=%u seed=%u "
+         "cleanSession=%d\n",
+         static_cast<unsigned>(options.messageCount), static_cast<unsigned>(options.inflightWindow),
+         static_cast<unsigned>(options.payloadBytes), static_cast<unsigned>(options.maxAcceptBytes),
+         static_cast<unsigned>(options.maxDeliverBytes), static_cast<unsigned>(options.responseDelayTicks),
+         static_cast<unsigned>(options.dropAfterPublishCount), static_cast<unsigned>(options.seed),
+         options.isCleanSession ? 1 : 0);
+  printf("ticks=%u simulated=%.2fs sessions=%u brokerConnects=%u drops=%u pings=%u\n", static_cast<unsigned>(tickIndex),
+         static_cast<double>(tickIndex) * kTickMs / 1000.0, static_cast<unsigned>(sessionCount),
+         static_cast<unsigned>(brokerStats.connectCount), static_cast<unsigned>(brokerStats.droppedConnectionCount),
+         static_cast<unsigned>(brokerStats.pingCount));
+  printf("publish queued=%u acked=%u retransmit=%u brokerReceived=%llu brokerDup=%llu missing=%u windowFull=%u "
+         "maxInflight=%u\n",
+         static_cast<unsigned>(clientStats.publishQueuedCount), static_cast<unsigned>(observation.ackedCount),
+         static_cast<unsigned>(clientStats.retransmitCount),
+         static_cast<unsigned long long>(brokerStats.publishReceivedCount),
+         static_cast<unsigned long long>(brokerStats.duplicatePublishCount), static_cast<unsigned>(missingCount),
+         static_cast<unsigned>(windowFullCount), static_cast<unsigned>(clientStats.maxInflightCount));
+  printf("command injected=%u deliveredToClient=%llu received=%u sizeMismatch=%u subscribeAck=%u\n",
+         static_cast<unsigned>(injectedCommandCount),
+         static_cast<unsigned long long>(brokerStats.deliveredToClientCount),
+         static_cast<unsigned>(observation.commandReceivedCount),
+         static_cast<unsigned>(observation.commandSizeMismatchCount),
+         static_cast<unsigned>(observation.subscribeAckCount));
+  printf("client bytesSent=%llu bytesReceived=%llu maxSendQueue=%zuB protocolErrors=%u controlDrops=%u "
+         "brokerMalformed=%u\n",
+         static_cast<unsigned long long>(clientStats.bytesSent),
+         static_cast<unsigned long long>(clientStats.bytesReceived), clientStats.maxSendQueueUsedBytes,
+         static_cast<unsigned>(clientStats.protocolErrorCount), static_cast<unsigned>(clientStats.controlDropCount),
+         static_cast<unsigned>(brokerStats.malformedCount));
+  printf("host wall=%.3fs\n", wallSeconds);
+  printf("result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file mqttWireBroker.cpp
+ * @brief MQTT ワイヤプロトコルのブローカー代替の実装。
+ * @details
+ * - [重要] クライアントからの受信はファームウェアと同じ `mqttPacketParser` で組み立てる。
+ *   応答パケットは本ファイルで独自に組み立て、クライアント側の符号化とは共有しない。
+ */
+
+#include "mqttWireBroker.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "brokerStandIn.h"
+#include "log.h"
+
+namespace {
+
+/** @brief 受理する Remaining Length の上限。 */
+constexpr size_t kMaxBrokerPacketBytes = 1024 * 1024;
+
+uint16_t readUint16(const uint8_t* cursor) {
+  return static_cast<uint16_t>((static_cast<uint16_t>(cursor[0]) << 8) | cursor[1]);
+}
+
+void appendUint16(std::vector<uint8_t>* packetOut, uint16_t value) {
+  packetOut->push_back(static_cast<uint8_t>(value >> 8));
+  packetOut->push_back(static_cast<uint8_t>(value & 0xFF));
+}
+
+/**
+ * @brief 固定ヘッダー + 本体でパケットを組み立てる。
+ */
+std::vector<uint8_t> buildPacket(uint8_t headerByte, const std::vector<uint8_t>& body) {
+  std::vector<uint8_t> packet;
+  packet.reserve(body.size() + 5);
+  packet.push_back(headerByte);
+  size_t remainingLength = body.size();
+  do {
+    uint8_t encodedByte = static_cast<uint8_t>(remainingLength % 128);
+    remainingLength /= 128;
+    if (remainingLength > 0) {
+      encodedByte |= 0x80;
+    }
+    packet.push_back(encodedByte);
+  } while (remainingLength > 0);
+  packet.insert(packet.end(), body.begin(), body.end());
+  return packet;
+}
+
+std::vector<uint8_t> buildAckPacket(mqttAsync::mqttPacketType type, uint16_t packetId) {
+  std::vector<uint8_t> body;
+  appendUint16(&body, packetId);
+  return buildPacket(static_cast<uint8_t>(static_cast<uint8_t>(type) << 4), body);
+}
+
+std::vector<uint8_t> buildPublishPacket(const std::string& topic, const std::string& payload, uint8_t qos,
+                                        uint16_t packetId) {
+  std::vector<uint8_t> body;
+  appendUint16(&body, static_cast<uint16_t>(topic.size()));
+  body.insert(body.end(), topic.begin(), topic.end());
+  if (qos > 0) {
+    appendUint16(&body, packetId);
+  }
+  body.insert(body.end(), payload.begin(), payload.end());
+  return buildPacket(static_cast<uint8_t>((static_cast<uint8_t>(mqttAsync::mqttPacketType::kPublish) << 4) | (qos << 1)),
+                     body);
+}
+
+}  // namespace
+
+/**
+ * @brief 1接続分の状態。
+ */
+struct mqttWireBroker::connection {
+  /** @brief 応答待ちの送出パケット。 */
+  struct pendingOutbound {
+    uint64_t readyAtTick;
+    std::vector<uint8_t> packet;
+    bool isDelivery;
+  };
+
+  mqttWireBroker* owner = nullptr;
+  bool isOpen = false;
+  bool hasConnected = false;
+  mqttAsync::mqttPacketParser parser;
+  std::deque<uint8_t> outbound;
+  uint64_t outboundTotalBytes = 0;
+  uint64_t readTotalBytes = 0;
+  /** @brief 配送 PUBLISH の末尾位置（outbound 通算 byte）。read がここを越えたら配送完了とみなす。 */
+  std::deque<uint64_t> deliveryEndOffsets;
+  std::deque<pendingOutbound> pendingOutbounds;
+  std::vector<std::string> subscriptions;
+};
+
+mqttWireBroker::mqttWireBroker(const mqttWireBrokerConfig& config)
+    : config_(config), hasStoredSession_(false), publishSinceDrop_(0), currentTick_(0), nextPacketId_(0), random_(config.seed), stats_() {
+  config_.maxAcceptBytesPerWrite = std::max<size_t>(1, config_.maxAcceptBytesPerWrite);
+  config_.maxDeliverBytesPerRead = std::max<size_t>(1, config_.maxDeliverBytesPerRead);
+}
+
+mqttWireBroker::~mqttWireBroker() = default;
+
+bool mqttWireBroker::openConnection(mqttAsync::mqttTransport* transportOut) {
+  if (transportOut == nullptr) {
+    appLogError("mqttWireBroker::openConnection failed. transportOut is null.");
+    return false;
+  }
+  std::unique_ptr<connection> newConnection(new connection());
+  if (!newConnection->parser.initialize(kMaxBrokerPacketBytes)) {
+    appLogError("mqttWireBroker::openConnection failed. parser initialize returned false.");
+    return false;
+  }
+  newConnection->owner = this;
+  newConnection->isOpen = true;
+  transportOut->context = newConnection.get();
+  transportOut->write = transportWrite;
+  transportOut->read = transportRead;
+  connections_.push_back(std::move(newConnection));
+  return true;
+}
+
+void mqttWireBroker::tick() {
+  ++currentTick_;
+  for (std::unique_ptr<connection>& target : connections_) {
+    while (!target->pendingOutbounds.empty() && target->pendingOutbounds.front().readyAtTick <= currentTick_) {
+      connection::pendingOutbound& next = target->pendingOutbounds.front();
+      target->outbound.insert(target->outbound.end(), next.packet.begin(), next.packet.end());
+      target->outboundTotalBytes += next.packet.size();
+      if (next.isDelivery) {
+        target->deliveryEndOffsets.push_back(target->outboundTotalBytes);
+      }
+      target->pendingOutbounds.pop_front();
+    }
+  }
+}
+
+size_t mqttWireBroker::injectPublish(const std::string& topic, const std::string& payload, uint8_t qos) {
+  size_t deliveredConnectionCount = 0;
+  for (std::unique_ptr<connection>& target : connections_) {
+    if (!target->isOpen || !target->hasConnected) {
+      continue;
+    }
+    const bool isSubscribed =
+        std::any_of(target->subscriptions.begin(), target->subscriptions.end(), [&topic](const std::string& filter) {
+          return brokerStandIn::matchTopicFilter(filter, topic);
+        });
+    if (!isSubscribed) {
+      continue;
+    }
+    ++nextPacketId_;
+    if (nextPacketId_ == 0) {
+      nextPacketId_ = 1;
+    }
+    queueDelivery(target.get(), buildPublishPacket(topic, payload, qos, nextPacketId_));
+    ++deliveredConnectionCount;
+  }
+  return deliveredConnectionCount;
+}
+
+int32_t mqttWireBroker::transportWrite(void* context, const uint8_t* data, size_t length) {
+  connection* target = static_cast<connection*>(context);
+  if (!target->isOpen) {
+    return -1;
+  }
+  const size_t acceptedLength =
+      target->owner->randomChunk(std::min(length, target->owner->config_.maxAcceptBytesPerWrite));
+  if (!target->parser.feed(data, acceptedLength, onPacketParsed, target)) {
+    ++target->owner->stats_.malformedCount;
+    target->isOpen = false;
+  }
+  return static_cast<int32_t>(acceptedLength);
+}
+
+int32_t mqttWireBroker::transportRead(void* context, uint8_t* bufferOut, size_t capacity) {
+  connection* target = static_cast<connection*>(context);
+  if (!target->isOpen) {
+    return -1;
+  }
+  if (target->outbound.empty()) {
+    return 0;
+  }
+  const size_t readLength = std::min({capacity, target->outbound.size(),
+                                      target->owner->randomChunk(target->owner->config_.maxDeliverBytesPerRead)});
+  std::copy(target->outbound.begin(), target->outbound.begin() + static_cast<std::ptrdiff_t>(readLength), bufferOut);
+  target->outbound.erase(target->outbound.begin(), target->outbound.begin() + static_cast<std::ptrdiff_t>(readLength));
+  target->readTotalBytes += readLength;
+  while (!target->deliveryEndOffsets.empty() && target->deliveryEndOffsets.front() <= target->readTotalBytes) {
+    target->deliveryEndOffsets.pop_front();
+    ++target->owner->stats_.deliveredToClientCount;
+  }
+  return static_cast<int32_t>(readLength);
+}
+
+void mqttWireBroker::onPacketParsed(void* context, const mqttAsync::mqttPacketView& packet) {
+  connection* target = static_cast<connection*>(context);
+  target->owner->handlePacket(target, packet);
+}
+
+void mqttWireBroker::handlePacket(connection* target, const mqttAsync::mqttPacketView& packet) {
+  if (!target->isOpen) {
+    return;
+  }
+  switch (packet.type()) {
+    case mqttAsync::mqttPacketType::kConnect: {
+      ++stats_.connectCount;
+      target->hasConnected = true;
+      // 可変ヘッダ: プロトコル名(6) + レベル(1) + Connect Flags(1)。Clean Session=0 の再接続だけ前回のセッションを引き継ぐ。
+      if (packet.bodyLength < 8) {
+        ++stats_.malformedCount;
+        return;
+      }
+      const bool isCleanSession = (packet.body[7] & 0x02) != 0;
+      const uint8_t sessionPresent = (!isCleanSession && hasStoredSession_) ? 0x01 : 0x00;
+      hasStoredSession_ = !isCleanSession;
+      // CONNACK: Session Present, Return Code=0
+      queueResponse(target,
+                    buildPacket(static_cast<uint8_t>(mqttAsync::mqttPacketType::kConnack) << 4, {sessionPresent, 0x00}));
+      return;
+    }
+
+    case mqttAsync::mqttPacketType::kPublish: {
+      const uint8_t qos = static_cast<uint8_t>((packet.flags() >> 1) & 0x03);
+      if (packet.bodyLength < 2) {
+        ++stats_.malformedCount;
+        return;
+      }
+      const size_t topicLength = readUint16(packet.body);
+      const size_t packetIdLength = qos > 0 ? 2 : 0;
+      if (packet.bodyLength < 2 + topicLength + packetIdLength) {
+        ++stats_.malformedCount;
+        return;
+      }
+      const std::string topic(reinterpret_cast<const char*>(packet.body + 2), topicLength);
+      const uint8_t* payloadStart = packet.body + 2 + topicLength + packetIdLength;
+      const std::string payload(reinterpret_cast<const char*>(payloadStart),
+                                packet.bodyLength - (2 + topicLength + packetIdLength));
+      ++stats_.publishReceivedCount;
+      if ((packet.flags() & 0x08) != 0) {
+        ++stats_.duplicatePublishCount;
+      }
+      ++receivedPublishCounts_[topic + "\n" + payload];
+
+      ++publishSinceDrop_;
+      if (config_.dropAfterPublishCount > 0 && publishSinceDrop_ >= config_.dropAfterPublishCount) {
+        // PUBACK を返す前に切る。クライアントは再接続後に再送する必要がある（セッション継続時は DUP=1）。
+        publishSinceDrop_ = 0;
+        ++stats_.droppedConnectionCount;
+        target->isOpen = false;
+        return;
+      }
+      if (qos == 1) {
+        queueResponse(target, buildAckPacket(mqttAsync::mqttPacketType::kPuback, readUint16(packet.body + 2 + topicLength)));
+      }
+      return;
+    }
+
+    case mqttAsync::mqttPacketType::kSubscribe: {
+      if (packet.bodyLength < 5) {
+        ++stats_.malformedCount;
+        return;
+      }
+      const uint16_t packetId = readUint16(packet.body);
+      const size_t filterLength = readUint16(packet.body + 2);
+      if (packet.bodyLength < 4 + filterLength + 1) {
+        ++stats_.malformedCount;
+        return;
+      }
+      target->subscriptions.emplace_back(reinterpret_cast<const char*>(packet.body + 4), filterLength);
+      std::vector<uint8_t> body;
+      appendUint16(&body, packetId);
+      body.push_back(std::min<uint8_t>(packet.body[4 + filterLength], 1));
+      queueResponse(target, buildPacket(static_cast<uint8_t>(mqttAsync::mqttPacketType::kSuback) << 4, body));
+      return;
+    }
+
+    case mqttAsync::mqttPacketType::kPuback:
+      return;
+
+    case mqttAsync::mqttPacketType::kPingreq:
+      ++stats_.pingCount;
+      queueResponse(target, buildPacket(static_cast<uint8_t>(mqttAsync::mqttPacketType::kPingresp) << 4, {}));
+      return;
+
+    case mqttAsync::mqttPacketType::kDisconnect:
+      target->isOpen = false;
+      return;
+
+    default:
+      ++stats_.malformedCount;
+      return;
+  }
+}
+
+void mqttWireBroker::queueResponse(connection* target, std::vector<uint8_t> packet) {
+  target->pendingOutbounds.push_back({currentTick_ + config_.responseDelayTicks, std::move(packet), false});
+}
+
+void mqttWireBroker::queueDelivery(connection* target, std::vector<uint8_t> packet) {
+  target->pendingOutbounds.push_back({currentTick_ + config_.responseDelayTicks, std::move(packet), true});
+}
+
+size_t mqttWireBroker::randomChunk(size_t limit) {
+  if (limit <= 1) {
+    return limit;
+  }
+  std::uniform_int_distribution<size_t> distribution(1, limit);
+  return distribution(random_);
+}
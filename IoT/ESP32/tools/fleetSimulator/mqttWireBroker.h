@@ -0,0 +1,120 @@
+/**
+ * @file mqttWireBroker.h
+ * @brief MQTT 3.1.1 のバイト列を直接やり取りするブローカー代替（mqttAsyncClient の検証用）定義。
+ * @details
+ * - [重要] `brokerStandIn` はトピック配送だけを模擬する。本クラスは CONNECT / PUBLISH / PUBACK / SUBSCRIBE /
+ *   PINGREQ / DISCONNECT をバイト列で受け、CONNACK / PUBACK / SUBACK / PINGRESP / PUBLISH をバイト列で返す。
+ * - [重要] 通信路の癖を再現する: 1回の write/read で受け渡す byte 数を乱数で刻む、応答を指定 tick 遅らせる、
+ *   指定件数の PUBLISH ごとに接続を切る。
+ * - [重要] CONNACK の Session Present は、Clean Session=0 の CONNECT が続いた場合だけ 1 を返す（セッションは1つだけ保持）。
+ * - [制限] 1 tick = 呼び出し側ループ1周。時刻は持たない。QoS2 と retain 保存は扱わない。
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mqttAsyncClient.h"
+
+/**
+ * @brief 通信路の癖の設定。
+ */
+struct mqttWireBrokerConfig {
+  /** @brief クライアント write 1回で受理する最大 byte 数（1..この値を乱数で選ぶ）。@type size_t */
+  size_t maxAcceptBytesPerWrite;
+  /** @brief クライアント read 1回で渡す最大 byte 数（1..この値を乱数で選ぶ）。@type size_t */
+  size_t maxDeliverBytesPerRead;
+  /** @brief 応答パケットを遅らせる tick 数。@type uint32_t */
+  uint32_t responseDelayTicks;
+  /** @brief この件数の PUBLISH を受けるごとに接続を切る。0 で切らない。@type uint32_t */
+  uint32_t dropAfterPublishCount;
+  /** @brief 乱数シード。@type uint32_t */
+  uint32_t seed;
+};
+
+/**
+ * @brief ブローカー代替の累積統計。
+ */
+struct mqttWireBrokerStats {
+  /** @brief 受けた PUBLISH 件数（再送を含む）。@type uint64_t */
+  uint64_t publishReceivedCount;
+  /** @brief DUP=1 の PUBLISH 件数。@type uint64_t */
+  uint64_t duplicatePublishCount;
+  /** @brief 接続を切った回数。@type uint32_t */
+  uint32_t droppedConnectionCount;
+  /** @brief 受けた CONNECT 件数。@type uint32_t */
+  uint32_t connectCount;
+  /** @brief 受けた PINGREQ 件数。@type uint32_t */
+  uint32_t pingCount;
+  /** @brief 解析できなかったパケット件数。@type uint32_t */
+  uint32_t malformedCount;
+  /** @brief 購読者へ全 byte を渡し終えた PUBLISH 件数。@type uint64_t */
+  uint64_t deliveredToClientCount;
+};
+
+/**
+ * @brief MQTT ワイヤプロトコルのブローカー代替。
+ */
+class mqttWireBroker {
+ public:
+  explicit mqttWireBroker(const mqttWireBrokerConfig& config);
+  ~mqttWireBroker();
+  mqttWireBroker(const mqttWireBroker&) = delete;
+  mqttWireBroker& operator=(const mqttWireBroker&) = delete;
+
+  /**
+   * @brief 新しい接続を開き、クライアントへ渡す通信路を返す。
+   * @param transportOut 出力先（null不可）。
+   * @return 成功時true。
+   */
+  bool openConnection(mqttAsync::mqttTransport* transportOut);
+
+  /**
+   * @brief 1 tick 進める（遅延応答の解放）。
+   */
+  void tick();
+
+  /**
+   * @brief ブローカー側から PUBLISH を送る（バックエンドからのコマンド相当）。
+   * @param topic トピック。
+   * @param payload payload。
+   * @param qos 0 または 1。
+   * @return 配送した接続数。
+   */
+  size_t injectPublish(const std::string& topic, const std::string& payload, uint8_t qos);
+
+  /** @brief 受けた PUBLISH の (topic + payload) ごとの受信回数を返す。 */
+  const std::map<std::string, uint32_t>& receivedPublishCounts() const { return receivedPublishCounts_; }
+  /** @brief 累積統計を返す。 */
+  const mqttWireBrokerStats& stats() const { return stats_; }
+
+ private:
+  struct connection;
+
+  static int32_t transportWrite(void* context, const uint8_t* data, size_t length);
+  static int32_t transportRead(void* context, uint8_t* bufferOut, size_t capacity);
+  static void onPacketParsed(void* context, const mqttAsync::mqttPacketView& packet);
+
+  void handlePacket(connection* target, const mqttAsync::mqttPacketView& packet);
+  void queueResponse(connection* target, std::vector<uint8_t> packet);
+  void queueDelivery(connection* target, std::vector<uint8_t> packet);
+  size_t randomChunk(size_t limit);
+
+  mqttWireBrokerConfig config_;
+  std::vector<std::unique_ptr<connection>> connections_;
+  std::map<std::string, uint32_t> receivedPublishCounts_;
+  bool hasStoredSession_;
+  uint32_t publishSinceDrop_;
+  uint64_t currentTick_;
+  uint16_t nextPacketId_;
+  std::mt19937 random_;
+  mqttWireBrokerStats stats_;
+};
@@ -0,0 +1,283 @@
+/**
+ * @file netSelfTestScenario.cpp
+ * @brief 通信自己診断（src/networkSelfTest.cpp）をホストで `netSelfTestStandIn` へ接続して動かす検証シナリオ。
+ * @details
+ * - [重要] ファームウェアの計測処理を無改変でリンクし、ループバック上の実ソケットで次を確認する。
+ *   - ping 回数どおりの往復時間記録、ダウンロード / アップロードの全量転送と `received=N` の照合
+ *   - サーバー側で注入した送信停止が、受信間隔の停滞（stalls）として数えられること
+ *   - TLS が使えない場合（ホストシムの WiFiClientSecure は常に失敗）に TLS だけ失敗として記録し、平文の結果は残ること
+ * - [重要] `--serve` を付けるとシナリオを実行せず、計測用エンドポイントとして待ち受け続ける（実機からの計測用）。
+ * - 判定に失敗した場合は終了コード 1 を返す。
+ */
+
+#include <cJSON.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "log.h"
+#include "netSelfTestStandIn.h"
+#include "networkSelfTest.h"
+
+void setHostLogVerbose(bool verbose);
+
+namespace {
+
+/**
+ * @brief シナリオ設定。
+ */
+struct scenarioOptions {
+  uint32_t port = 0;
+  uint32_t transferBytes = 131072;
+  uint32_t pingCount = 16;
+  uint32_t stallEveryBytes = 32768;
+  uint32_t stallMs = 300;
+  bool isServeMode = false;
+  bool isVerbose = false;
+};
+
+/** @brief `--serve` の停止要求。 */
+volatile sig_atomic_t isStopRequested = 0;
+
+void onStopSignal(int signalNumber) {
+  (void)signalNumber;
+  isStopRequested = 1;
+}
+
+void printUsage(const char* programName) {
+  printf("usage: %s [options]\n"
+         "  --serve                 run only the endpoint on 0.0.0.0 until Ctrl+C (for device tests)\n"
+         "  --port N                listen port, 0=ephemeral (default 0, --serve default 8090)\n"
+         "  --bytes N               download/upload bytes per mode (default 131072)\n"
+         "  --pings N               ping count (default 16)\n"
+         "  --stall-every-bytes N   pause the download every N bytes in the stall case (default 32768)\n"
+         "  --stall-ms N            pause length ms in the stall case (default 300)\n"
+         "  --verbose               print firmware INFO logs\n",
+         programName);
+}
+
+bool parseUnsignedOption(const char* text, uint32_t* valueOut) {
+  if (text == nullptr || valueOut == nullptr) {
+    appLogError("parseUnsignedOption failed. text=%p valueOut=%p", text, valueOut);
+    return false;
+  }
+  char* endPointer = nullptr;
+  const unsigned long parsedValue = strtoul(text, &endPointer, 10);
+  if (endPointer == text || *endPointer != '\0') {
+    appLogError("parseUnsignedOption failed. not a number. text=%s", text);
+    return false;
+  }
+  *valueOut = static_cast<uint32_t>(parsedValue);
+  return true;
+}
+
+/**
+ * @brief コマンドライン引数を解析する。
+ * @return 解析成功時true。--help 時や不正引数時false。
+ */
+bool parseOptions(int argc, char** argv, scenarioOptions* optionsOut) {
+  if (optionsOut == nullptr) {
+    appLogError("parseOptions failed. optionsOut is null.");
+    return false;
+  }
+  bool isPortGiven = false;
+  for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex) {
+    const std::string argument = argv[argumentIndex];
+    const char* nextValue = (argumentIndex + 1 < argc) ? argv[argumentIndex + 1] : nullptr;
+    uint32_t* targetValue = nullptr;
+    if (argument == "--port") {
+      targetValue = &optionsOut->port;
+      isPortGiven = true;
+    } else if (argument == "--bytes") {
+      targetValue = &optionsOut->transferBytes;
+    } else if (argument == "--pings") {
+      targetValue = &optionsOut->pingCount;
+    } else if (argument == "--stall-every-bytes") {
+      targetValue = &optionsOut->stallEveryBytes;
+    } else if (argument == "--stall-ms") {
+      targetValue = &optionsOut->stallMs;
+    } else if (argument == "--serve") {
+      optionsOut->isServeMode = true;
+      continue;
+    } else if (argument == "--verbose") {
+      optionsOut->isVerbose = true;
+      continue;
+    } else {
+      if (argument != "--help" && argument != "-h") {
+        appLogError("parseOptions failed. unknown argument=%s", argument.c_str());
+      }
+      printUsage(argv[0]);
+      return false;
+    }
+    if (!parseUnsignedOption(nextValue, targetValue)) {
+      appLogError("parseOptions failed. invalid value. argument=%s", argument.c_str());
+      return false;
+    }
+    ++argumentIndex;
+  }
+  if (optionsOut->isServeMode && !isPortGiven) {
+    optionsOut->port = 8090;
+  }
+  if (optionsOut->port > 65535) {
+    appLogError("parseOptions failed. port must be 0..65535.");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 計測結果を JSON で表示する。
+ */
+void printReportJson(const networkSelfTestReport& report) {
+  cJSON* rootObject = cJSON_CreateObject();
+  if (rootObject == nullptr || !networkSelfTest::appendReportToJson(report, rootObject)) {
+    cJSON_Delete(rootObject);
+    appLogError("printReportJson failed. appendReportToJson returned false.");
+    return;
+  }
+  char* jsonText = cJSON_PrintUnformatted(rootObject);
+  cJSON_Delete(rootObject);
+  if (jsonText != nullptr) {
+    printf("%s\n", jsonText);
+    cJSON_free(jsonText);
+  }
+}
+
+/**
+ * @brief 1ケース分を実行して判定する。
+ * @param caseName 表示名。
+ * @param serverConfig サーバー設定（port は呼出し側で上書きする）。
+ * @param selfTestOptions 計測条件（host / port は呼出し側で上書きする）。
+ * @param expectedMinimumStalls ダウンロードで最低限数えられるべき停滞回数。
+ * @param expectTlsFailure TLS を有効にして失敗記録を確認するか。
+ * @return 判定成功時true。
+ */
+bool runCase(const char* caseName,
+             const scenarioOptions& options,
+             netSelfTestStandInConfig serverConfig,
+             networkSelfTestOptions selfTestOptions,
+             uint32_t expectedMinimumStalls,
+             bool expectTlsFailure) {
+  serverConfig.port = static_cast<uint16_t>(options.port);
+  serverConfig.isLoopbackOnly = true;
+  netSelfTestStandIn server(serverConfig);
+  if (!server.start()) {
+    appLogError("runCase failed. server start failed. case=%s", caseName);
+    return false;
+  }
+  selfTestOptions.tcpPort = server.port();
+  selfTestOptions.tlsPort = expectTlsFailure ? server.port() : 0;
+
+  networkSelfTestReport report;
+  const char* detailText = nullptr;
+  const bool runResult = networkSelfTest::run(selfTestOptions, &report, &detailText);
+  server.stop();
+
+  const networkSelfTestModeResult& tcpMode = report.modes[0];
+  const networkSelfTestModeResult& tlsMode = report.modes[1];
+  const netSelfTestStandInStats& serverStats = server.stats();
+  const bool isTcpPassed = runResult && tcpMode.isSuccess && tcpMode.rttCount == report.options.pingCount &&
+                           tcpMode.rttErrorCount == 0 && tcpMode.download.isComplete && tcpMode.upload.isComplete &&
+                           tcpMode.download.bytes == report.options.transferBytes &&
+                           serverStats.uploadBytes == report.options.transferBytes &&
+                           tcpMode.download.stallCount >= expectedMinimumStalls &&
+                           (expectedMinimumStalls > 0 || tcpMode.download.stallCount == 0);
+  const bool isTlsPassed = !expectTlsFailure || (tlsMode.isAttempted && !tlsMode.isSuccess &&
+                                                 strcmp(tlsMode.detail, "tls connect failed") == 0);
+  const bool isPassed = isTcpPassed && isTlsPassed && report.rssiSampleCount > 0;
+
+  printf("--- case %s ---\n", caseName);
+  printf("run=%d detail=%s ip=%s dnsUs=%u elapsedMs=%u\n", runResult ? 1 : 0, detailText == nullptr ? "" : detailText,
+         report.resolvedIp, static_cast<unsigned>(report.dnsUs), static_cast<unsigned>(report.elapsedMs));
+  printf("tcp rtt count=%u errors=%u avgUs=%u download kbps=%u stalls=%u (expected>=%u) upload complete=%d\n",
+         static_cast<unsigned>(tcpMode.rttCount), static_cast<unsigned>(tcpMode.rttErrorCount),
+         static_cast<unsigned>(tcpMode.rttCount > 0 ? tcpMode.rttTotalUs / tcpMode.rttCount : 0),
+         static_cast<unsigned>(tcpMode.download.elapsedUs > 0
+                                   ? static_cast<uint64_t>(tcpMode.download.bytes) * 1000000ULL / tcpMode.download.elapsedUs / 1024ULL
+                                   : 0),
+         static_cast<unsigned>(tcpMode.download.stallCount), static_cast<unsigned>(expectedMinimumStalls),
+         tcpMode.upload.isComplete ? 1 : 0);
+  printf("server connections=%u pings=%u downloadBytes=%llu uploadBytes=%llu injectedStalls=%u badRequests=%u\n",
+         static_cast<unsigned>(serverStats.connectionCount), static_cast<unsigned>(serverStats.pingCount),
+         static_cast<unsigned long long>(serverStats.downloadBytes),
+         static_cast<unsigned long long>(serverStats.uploadBytes),
+         static_cast<unsigned>(serverStats.injectedStallCount), static_cast<unsigned>(serverStats.badRequestCount));
+  if (expectTlsFailure) {
+    printf("tls attempted=%d ok=%d detail=%s\n", tlsMode.isAttempted ? 1 : 0, tlsMode.isSuccess ? 1 : 0, tlsMode.detail);
+  }
+  if (options.isVerbose) {
+    printReportJson(report);
+  }
+  printf("case result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  scenarioOptions options;
+  if (!parseOptions(argc, argv, &options)) {
+    return 2;
+  }
+  setHostLogVerbose(options.isVerbose);
+
+  if (options.isServeMode) {
+    netSelfTestStandInConfig serverConfig = {};
+    serverConfig.port = static_cast<uint16_t>(options.port);
+    serverConfig.isLoopbackOnly = false;
+    netSelfTestStandIn server(serverConfig);
+    if (!server.start()) {
+      return 1;
+    }
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+    printf("netSelfTestStandIn listening on 0.0.0.0:%u (Ctrl+C to stop)\n", static_cast<unsigned>(server.port()));
+    fflush(stdout);
+    while (!isStopRequested) {
+      sleep(1);
+    }
+    server.stop();
+    const netSelfTestStandInStats& serverStats = server.stats();
+    printf("connections=%u pings=%u downloadBytes=%llu uploadBytes=%llu badRequests=%u\n",
+           static_cast<unsigned>(serverStats.connectionCount), static_cast<unsigned>(serverStats.pingCount),
+           static_cast<unsigned long long>(serverStats.downloadBytes),
+           static_cast<unsigned long long>(serverStats.uploadBytes), static_cast<unsigned>(serverStats.badRequestCount));
+    return 0;
+  }
+
+  networkSelfTestOptions selfTestOptions = networkSelfTest::getDefaultOptions();
+  selfTestOptions.host = "127.0.0.1";
+  selfTestOptions.transferBytes = options.transferBytes;
+  selfTestOptions.pingCount = static_cast<uint16_t>(options.pingCount);
+  selfTestOptions.stallThresholdMs = 200;
+  selfTestOptions.tlsCaCertificate = "-----BEGIN CERTIFICATE-----\nhost-shim\n-----END CERTIFICATE-----\n";
+
+  printf("=== netSelfTestScenario report ===\n");
+  bool isPassed = true;
+
+  netSelfTestStandInConfig cleanConfig = {};
+  isPassed = runCase("clean", options, cleanConfig, selfTestOptions, 0, false) && isPassed;
+
+  // [重要] 停滞閾値(200ms)を超える停止を注入する。最後の区切りの後は止めないため、期待値は区切り数-1。
+  netSelfTestStandInConfig stallConfig = {};
+  stallConfig.stallEveryBytes = options.stallEveryBytes;
+  stallConfig.stallMs = options.stallMs;
+  uint32_t expectedStalls = 0;
+  if (options.stallEveryBytes > 0 && options.stallMs >= 250) {
+    uint32_t clampedBytes = (options.transferBytes < 4096) ? 4096 : options.transferBytes;
+    clampedBytes = (clampedBytes > 1048576) ? 1048576 : clampedBytes;
+    expectedStalls = (clampedBytes - 1) / options.stallEveryBytes;
+  }
+  isPassed = runCase("stall", options, stallConfig, selfTestOptions, expectedStalls, false) && isPassed;
+
+  networkSelfTestOptions tlsOptions = selfTestOptions;
+  tlsOptions.host = "localhost";
+  isPassed = runCase("tlsUnavailable", options, cleanConfig, tlsOptions, 0, true) && isPassed;
+
+  printf("result=%s\n", isPassed ? "PASS" : "FAIL");
+  return isPassed ? 0 : 1;
+}
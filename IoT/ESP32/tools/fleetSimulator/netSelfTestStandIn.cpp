@@ -0,0 +1,265 @@
+/**
+ * @file netSelfTestStandIn.cpp
+ * @brief 通信自己診断の計測用エンドポイント代替の実装。
+ * @details
+ * - [重要] 要求ヘッダーは空行まで読み、`Content-Length` だけ解釈する。chunked 転送は扱わない。
+ * - [重要] 受付スレッドは poll の 100ms 周期で停止要求を確認する。無通信 10 秒で接続を閉じる。
+ */
+
+#include "netSelfTestStandIn.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+namespace {
+
+/** @brief 停止要求を確認する周期(ms)。 */
+constexpr int kPollSliceMs = 100;
+/** @brief 無通信で接続を閉じるまでの時間(ms)。 */
+constexpr int kIdleTimeoutMs = 10000;
+/** @brief 要求ヘッダーの上限(byte)。 */
+constexpr size_t kMaxHeaderBytes = 4096;
+/** @brief ダウンロード本文の上限(byte)。 */
+constexpr uint32_t kMaxDownloadBytes = 16U * 1024U * 1024U;
+
+/**
+ * @brief 要求ヘッダーから `Content-Length` を取り出す。
+ */
+uint32_t findContentLength(const std::string& headerText) {
+  size_t lineStart = 0;
+  while (lineStart < headerText.size()) {
+    const size_t lineEnd = headerText.find("\r\n", lineStart);
+    const std::string line = headerText.substr(lineStart, lineEnd == std::string::npos ? std::string::npos : lineEnd - lineStart);
+    if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+      return static_cast<uint32_t>(strtoul(line.c_str() + 15, nullptr, 10));
+    }
+    if (lineEnd == std::string::npos) {
+      break;
+    }
+    lineStart = lineEnd + 2;
+  }
+  return 0;
+}
+
+}  // namespace
+
+netSelfTestStandIn::netSelfTestStandIn(const netSelfTestStandInConfig& config)
+    : config_(config), listenFd_(-1), boundPort_(0), isStopping_(false), stats_{} {}
+
+netSelfTestStandIn::~netSelfTestStandIn() {
+  stop();
+}
+
+bool netSelfTestStandIn::start() {
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) {
+    fprintf(stderr, "netSelfTestStandIn::start failed. socket errno=%d\n", errno);
+    return false;
+  }
+  const int reuseAddress = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config_.port);
+  address.sin_addr.s_addr = htonl(config_.isLoopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+  if (bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd_, 4) != 0) {
+    fprintf(stderr, "netSelfTestStandIn::start failed. bind/listen errno=%d port=%u\n", errno, static_cast<unsigned>(config_.port));
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  socklen_t addressLength = sizeof(address);
+  getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &addressLength);
+  boundPort_ = ntohs(address.sin_port);
+  isStopping_ = false;
+  acceptThread_ = std::thread(&netSelfTestStandIn::acceptLoop, this);
+  return true;
+}
+
+void netSelfTestStandIn::stop() {
+  isStopping_ = true;
+  if (acceptThread_.joinable()) {
+    acceptThread_.join();
+  }
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+    listenFd_ = -1;
+  }
+}
+
+void netSelfTestStandIn::acceptLoop() {
+  while (!isStopping_) {
+    pollfd listenPoll = {listenFd_, POLLIN, 0};
+    if (poll(&listenPoll, 1, kPollSliceMs) <= 0) {
+      continue;
+    }
+    const int connectionFd = accept(listenFd_, nullptr, nullptr);
+    if (connectionFd < 0) {
+      continue;
+    }
+    const int noDelay = 1;
+    setsockopt(connectionFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    ++stats_.connectionCount;
+    serveConnection(connectionFd);
+    close(connectionFd);
+  }
+}
+
+bool netSelfTestStandIn::sendAll(int connectionFd, const char* data, size_t length) {
+  size_t sentSize = 0;
+  while (sentSize < length) {
+    const ssize_t result = send(connectionFd, data + sentSize, length - sentSize, MSG_NOSIGNAL);
+    if (result <= 0) {
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sentSize += static_cast<size_t>(result);
+  }
+  return true;
+}
+
+bool netSelfTestStandIn::sendDownloadBody(int connectionFd, uint32_t bodyBytes) {
+  char chunk[4096];
+  for (size_t byteIndex = 0; byteIndex < sizeof(chunk); ++byteIndex) {
+    chunk[byteIndex] = static_cast<char>('a' + (byteIndex % 26));
+  }
+  uint32_t sentBytes = 0;
+  uint32_t bytesSinceStall = 0;
+  while (sentBytes < bodyBytes) {
+    uint32_t chunkSize = bodyBytes - sentBytes;
+    chunkSize = (chunkSize > sizeof(chunk)) ? static_cast<uint32_t>(sizeof(chunk)) : chunkSize;
+    if (config_.stallEveryBytes > 0 && chunkSize > config_.stallEveryBytes - bytesSinceStall) {
+      chunkSize = config_.stallEveryBytes - bytesSinceStall;
+    }
+    if (!sendAll(connectionFd, chunk, chunkSize)) {
+      return false;
+    }
+    sentBytes += chunkSize;
+    stats_.downloadBytes += chunkSize;
+    bytesSinceStall += chunkSize;
+    if (config_.stallEveryBytes > 0 && bytesSinceStall >= config_.stallEveryBytes && sentBytes < bodyBytes) {
+      // [重要] 再送待ち（RTO）で受信が止まった状態を、送信側の一時停止で再現する。
+      std::this_thread::sleep_for(std::chrono::milliseconds(config_.stallMs));
+      ++stats_.injectedStallCount;
+      bytesSinceStall = 0;
+    }
+  }
+  return true;
+}
+
+void netSelfTestStandIn::serveConnection(int connectionFd) {
+  std::string pendingText;
+  char receiveBuffer[4096];
+  int idleMs = 0;
+  while (!isStopping_) {
+    // 要求ヘッダーを空行まで貯める
+    const size_t headerEnd = pendingText.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+      if (pendingText.size() > kMaxHeaderBytes) {
+        ++stats_.badRequestCount;
+        return;
+      }
+      pollfd connectionPoll = {connectionFd, POLLIN, 0};
+      if (poll(&connectionPoll, 1, kPollSliceMs) <= 0) {
+        idleMs += kPollSliceMs;
+        if (idleMs >= kIdleTimeoutMs) {
+          return;
+        }
+        continue;
+      }
+      const ssize_t receivedSize = recv(connectionFd, receiveBuffer, sizeof(receiveBuffer), 0);
+      if (receivedSize <= 0) {
+        return;
+      }
+      idleMs = 0;
+      pendingText.append(receiveBuffer, static_cast<size_t>(receivedSize));
+      continue;
+    }
+
+    const std::string headerText = pendingText.substr(0, headerEnd);
+    pendingText.erase(0, headerEnd + 4);
+    const size_t methodEnd = headerText.find(' ');
+    const size_t pathEnd = (methodEnd == std::string::npos) ? std::string::npos : headerText.find(' ', methodEnd + 1);
+    if (pathEnd == std::string::npos) {
+      ++stats_.badRequestCount;
+      return;
+    }
+    const std::string method = headerText.substr(0, methodEnd);
+    const std::string path = headerText.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+    const uint32_t requestBodyBytes = findContentLength(headerText);
+
+    // 要求本文（アップロード）は件数だけ数えて捨てる
+    uint32_t bodyReceivedBytes = 0;
+    const size_t bufferedBodyBytes = (pendingText.size() < requestBodyBytes) ? pendingText.size() : requestBodyBytes;
+    bodyReceivedBytes += static_cast<uint32_t>(bufferedBodyBytes);
+    pendingText.erase(0, bufferedBodyBytes);
+    while (bodyReceivedBytes < requestBodyBytes && !isStopping_) {
+      pollfd connectionPoll = {connectionFd, POLLIN, 0};
+      if (poll(&connectionPoll, 1, kIdleTimeoutMs) <= 0) {
+        return;
+      }
+      const size_t wantedSize = requestBodyBytes - bodyReceivedBytes;
+      const ssize_t receivedSize =
+          recv(connectionFd, receiveBuffer, wantedSize < sizeof(receiveBuffer) ? wantedSize : sizeof(receiveBuffer), 0);
+      if (receivedSize <= 0) {
+        return;
+      }
+      bodyReceivedBytes += static_cast<uint32_t>(receivedSize);
+    }
+
+    char responseHeader[160];
+    if (method == "GET" && path == "/selftest/ping") {
+      ++stats_.pingCount;
+      const int headerLength = snprintf(responseHeader, sizeof(responseHeader),
+                                        "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n");
+      if (!sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength))) {
+        return;
+      }
+    } else if (method == "GET" && path.rfind("/selftest/download?bytes=", 0) == 0) {
+      uint32_t bodyBytes = static_cast<uint32_t>(strtoul(path.c_str() + strlen("/selftest/download?bytes="), nullptr, 10));
+      bodyBytes = (bodyBytes > kMaxDownloadBytes) ? kMaxDownloadBytes : bodyBytes;
+      const int headerLength = snprintf(responseHeader, sizeof(responseHeader),
+                                        "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                                        "Content-Length: %u\r\nConnection: keep-alive\r\n\r\n",
+                                        static_cast<unsigned>(bodyBytes));
+      if (!sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength)) ||
+          !sendDownloadBody(connectionFd, bodyBytes)) {
+        return;
+      }
+    } else if (method == "POST" && path == "/selftest/upload") {
+      stats_.uploadBytes += bodyReceivedBytes;
+      char responseBody[32];
+      const int bodyLength = snprintf(responseBody, sizeof(responseBody), "received=%u", static_cast<unsigned>(bodyReceivedBytes));
+      const int headerLength = snprintf(responseHeader, sizeof(responseHeader),
+                                        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+                                        "Content-Length: %d\r\nConnection: keep-alive\r\n\r\n",
+                                        bodyLength);
+      if (!sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength)) ||
+          !sendAll(connectionFd, responseBody, static_cast<size_t>(bodyLength))) {
+        return;
+      }
+    } else {
+      ++stats_.badRequestCount;
+      const int headerLength = snprintf(responseHeader, sizeof(responseHeader),
+                                        "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n");
+      if (!sendAll(connectionFd, responseHeader, static_cast<size_t>(headerLength))) {
+        return;
+      }
+    }
+    idleMs = 0;
+  }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file netSelfTestStandIn.h
+ * @brief 通信自己診断（networkSelfTest）の計測用エンドポイント代替（ホスト用 HTTP/1.1 サーバー）定義。
+ * @details
+ * - [重要] `header/networkSelfTest.h` に記載の `/selftest/ping` `/selftest/download` `/selftest/upload` を
+ *   keep-alive で応答する。ホストの検証シナリオと、実機を PC へ向けた現場確認の両方で使う。
+ * - [重要] 再送による停滞を再現するため、ダウンロード本文を指定 byte ごとに指定時間止められる。
+ * - [制限] 平文 TCP のみ。接続は受付順に1本ずつ処理する（同時接続は待たせる）。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief サーバー設定。
+ */
+struct netSelfTestStandInConfig {
+  /** @brief 待受ポート。0 なら空きポートを割り当てる。@type uint16_t */
+  uint16_t port;
+  /** @brief 待受アドレスをループバックに限るか。@type bool */
+  bool isLoopbackOnly;
+  /** @brief ダウンロード本文をこの byte 数ごとに止める。0 で止めない。@type uint32_t */
+  uint32_t stallEveryBytes;
+  /** @brief 1回の停止時間(ms)。@type uint32_t */
+  uint32_t stallMs;
+};
+
+/**
+ * @brief サーバー側の累積統計（stop() 後に参照する）。
+ */
+struct netSelfTestStandInStats {
+  /** @brief 受け付けた接続数。@type uint32_t */
+  uint32_t connectionCount;
+  /** @brief ping 応答数。@type uint32_t */
+  uint32_t pingCount;
+  /** @brief 送ったダウンロード本文(byte)。@type uint64_t */
+  uint64_t downloadBytes;
+  /** @brief 受けたアップロード本文(byte)。@type uint64_t */
+  uint64_t uploadBytes;
+  /** @brief 注入した停止の回数。@type uint32_t */
+  uint32_t injectedStallCount;
+  /** @brief 解釈できなかった要求数。@type uint32_t */
+  uint32_t badRequestCount;
+};
+
+/**
+ * @brief 計測用エンドポイント代替。
+ */
+class netSelfTestStandIn {
+ public:
+  explicit netSelfTestStandIn(const netSelfTestStandInConfig& config);
+  ~netSelfTestStandIn();
+  netSelfTestStandIn(const netSelfTestStandIn&) = delete;
+  netSelfTestStandIn& operator=(const netSelfTestStandIn&) = delete;
+
+  /**
+   * @brief 待受を開始し、受付スレッドを起動する。
+   * @return 成功時true。
+   */
+  bool start();
+
+  /**
+   * @brief 受付スレッドを止める（処理中の接続は閉じる）。
+   */
+  void stop();
+
+  /** @brief 実際の待受ポートを返す。 */
+  uint16_t port() const { return boundPort_; }
+  /** @brief 累積統計を返す。 */
+  const netSelfTestStandInStats& stats() const { return stats_; }
+
+ private:
+  void acceptLoop();
+  void serveConnection(int connectionFd);
+  bool sendAll(int connectionFd, const char* data, size_t length);
+  bool sendDownloadBody(int connectionFd, uint32_t bodyBytes);
+
+  netSelfTestStandInConfig config_;
+  int listenFd_;
+  uint16_t boundPort_;
+  std::atomic<bool> isStopping_;
+  std::thread acceptThread_;
+  netSelfTestStandInStats stats_;
+};
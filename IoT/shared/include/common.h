@@ -79,6 +79,7 @@ namespace mqtt {
             constexpr const char* kLedBlink = "led_Blink";
             constexpr const char* kGpioHigh = "gpio_H";
             constexpr const char* kGpioLow = "gpio_L";
+            constexpr const char* kBatch = "batch"; // relay/gpio/led の複数操作を1回で同時反映する
             // [旧仕様] 互換のため受信許容。新規送信は禁止。
             constexpr const char* kGpioHighLegacy = "giio_H";
             constexpr const char* kGpioLowLegacy = "giio_L";
@@ -90,6 +91,7 @@ namespace mqtt {
             constexpr const char* kButton = "button";
             constexpr const char* kGpio = "gpio";
             constexpr const char* kLog = "log";
+            constexpr const char* kMulti = "multi"; // 複数の get を1要求で実行し、応答を1件にまとめる
             // [旧仕様] 互換のため受信許容。新規送信は禁止。
             constexpr const char* kButtonLegacy = "Botton";
             constexpr const char* kGpioLegacy = "giio";
@@ -102,6 +104,10 @@ namespace mqtt {
             // [重要] 7025 未確定起動失敗再現用の試験コマンド。
             constexpr const char* kRollbackTestEnable = "rollbackTestEnable";
             constexpr const char* kRollbackTestDisable = "rollbackTestDisable";
+            // [推奨] LittleFS の I/O 計測（順次/ランダム読み書き・fsync・open/rename/remove の度数分布）。
+            constexpr const char* kFlashBench = "flashBench";
+            // [推奨] 通信自己診断（TCP / TLS の往復時間・スループット・停滞・RSSI・TLS ハンドシェイク時間）。
+            constexpr const char* kNetSelfTest = "netSelfTest";
             // [旧仕様] 互換のため受信許容。新規送信は禁止。
             constexpr const char* kMaintenanceLegacy = "mentenance";
         }
@@ -237,6 +243,12 @@ namespace mqtt {
             constexpr const char* kRunningPartition = "runningPartition";
             constexpr const char* kBootPartition = "bootPartition";
             constexpr const char* kNextUpdatePartition = "nextUpdatePartition";
+            // [推奨] コア別負荷(%)。タスク配置変更の効果確認用。計測前は項目自体を送らない。
+            constexpr const char* kCpuLoadCore0 = "cpuLoadCore0";
+            constexpr const char* kCpuLoadCore1 = "cpuLoadCore1";
+            // [推奨] status 返信で応答済みの要求元（カンマ区切り）と、集約した要求数。reply 以外では送らない。
+            constexpr const char* kRequesterIds = "requesterIds";
+            constexpr const char* kRequestCount = "requestCount";
             constexpr const char* kDetail = "detail";
         }
         /**
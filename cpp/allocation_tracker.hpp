@@ -0,0 +1,512 @@
+/**
+ * @file allocation_tracker.hpp
+ * @brief 確保の計測（グローバル operator new/delete の置き換え + malloc 系の横取り）（ヘッダーのみ・任意で有効化）
+ *
+ * 概要:
+ *   - ALLOCATION_TRACKING を定義してコンパイルしたときだけ有効になる（未定義なら何もしない）。
+ *   - 有効時に数えるもの:
+ *       operator new/delete の回数、malloc/calloc/realloc/free の回数、確保バイト数、
+ *       同時に生きている最大バイト数（ピーク）、呼び出し元アドレスごとの回数/バイト数（ヒストグラム）
+ *   - プログラム終了時に集計を stderr へ表示する（終了時点で解放されていない分 = リーク候補 も表示）。
+ *   - allocationProbe: スコープ（ブロック）1つの間の確保だけを測って表示する。
+ * 主な仕様:
+ *   - バイト数は確保関数の「実際に使える大きさ」（malloc_usable_size / _msize / malloc_size）で数える。
+ *     要求した大きさより少し大きく出るが、ヘッダーを付けないので他の確保関数と混ざっても壊れない。
+ *   - 呼び出し元は operator new / malloc の戻り先アドレス。Linux では「モジュール+オフセット」と関数名（分かれば）を表示する。
+ *     実行ファイル内の関数名は -rdynamic 付きでリンクしたときだけ出る。
+ *     行番号は addr2line -e <実行ファイル> <オフセット> で調べられる（-g 付きビルドの場合）。
+ *   - 計測中はメモリを確保しない（表は固定長、表示は fprintf）。
+ * 制限事項:
+ *   - [厳守] このヘッダーは1つの .cpp からだけインクルードする（operator new の置き換えは実行ファイルに1つだけ）。
+ *   - malloc 系の横取りは glibc（Linux）のみ。その他の環境では operator new/delete だけを数える。
+ *   - AddressSanitizer など、malloc を自分で置き換えるツールとは併用しない。
+ *   - allocationProbe のピークは入れ子にすると内側が外側の値をリセットする（入れ子では外側のピークは不正確）。
+ *   - 終了時点の「未解放」には、標準ライブラリが終了まで持ち続ける領域（入出力バッファなど）も含まれる。
+ *
+ * 使い方:
+ *   #include "allocation_tracker.hpp"
+ *   {
+ *       allocationProbe probe("make_shared x1000");
+ *       ...                         // このブロックの確保回数/バイト数/ピークがスコープ終了時に表示される
+ *   }
+ *
+ * コンパイル例 (GCC/Clang, 計測あり):
+ *   g++ -std=c++17 -O2 -g -rdynamic -DALLOCATION_TRACKING modern_memory.cpp -o modern_memory
+ * コンパイル例 (MSVC x64, 計測あり):
+ *   cl /utf-8 /EHsc /std:c++17 /DALLOCATION_TRACKING modern_memory.cpp /Fe:modern_memory.exe
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(ALLOCATION_TRACKING)
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <intrin.h>
+#include <malloc.h>
+#define ALLOCATION_TRACKING_RETURN_ADDRESS() _ReturnAddress()
+#define ALLOCATION_TRACKING_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATION_TRACKING_RETURN_ADDRESS() __builtin_return_address(0)
+#define ALLOCATION_TRACKING_NOINLINE __attribute__((noinline))
+#endif
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#include <dlfcn.h>
+#include <malloc.h>
+#define ALLOCATION_TRACKING_INTERPOSE_MALLOC 1
+#endif
+
+#if defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+// glibc 本来の確保関数（横取りした malloc から呼ぶ）
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* pointer);
+}
+#endif
+
+namespace allocationTracking {
+
+/** @brief 呼び出し元ヒストグラムの表の大きさ（2の冪）。あふれた分は overflowSiteCount に数える。 */
+constexpr std::size_t kCallSiteTableSize = 1024;
+/** @brief 終了時に表示する呼び出し元の数。 */
+constexpr std::size_t kReportedCallSiteCount = 10;
+
+/** @brief 確保の種類（new 系 / malloc 系）。 */
+enum class allocationKind { newDelete, mallocFree };
+
+/** @brief 呼び出し元1か所分の集計。 */
+struct callSiteEntry {
+    std::atomic<std::uintptr_t> site{0};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> bytes{0};
+};
+
+/** @brief 全体の集計（static 初期化だけで使える = main より前の確保も数えられる）。 */
+struct trackerState {
+    std::atomic<std::uint64_t> newCount{0};
+    std::atomic<std::uint64_t> deleteCount{0};
+    std::atomic<std::uint64_t> mallocCount{0};
+    std::atomic<std::uint64_t> freeCount{0};
+    std::atomic<std::uint64_t> totalBytes{0};
+    std::atomic<std::int64_t> liveBytes{0};
+    std::atomic<std::int64_t> liveBlocks{0};
+    std::atomic<std::int64_t> peakLiveBytes{0};
+    std::atomic<std::int64_t> scopePeakLiveBytes{0}; ///< allocationProbe 用（プローブ開始時に現在値へ戻す）
+    std::atomic<std::uint64_t> overflowSiteCount{0};
+    callSiteEntry callSites[kCallSiteTableSize];
+};
+
+inline trackerState& state() {
+    static trackerState instance;
+    return instance;
+}
+
+/** @brief 確保済みブロックの「使える大きさ」を返す。 */
+inline std::size_t usableSize(void* pointer) {
+#if defined(_WIN32)
+    return _msize(pointer);
+#elif defined(__APPLE__)
+    return malloc_size(pointer);
+#elif defined(__GLIBC__)
+    return malloc_usable_size(pointer);
+#else
+    (void)pointer;
+    return 0;
+#endif
+}
+
+/** @brief 境界指定つきで確保したブロックの「使える大きさ」を返す（Windows は _aligned_malloc 専用の関数を使う）。 */
+inline std::size_t alignedUsableSize(void* pointer, std::size_t alignment) {
+#if defined(_WIN32)
+    return _aligned_msize(pointer, alignment, 0);
+#else
+    (void)alignment;
+    return usableSize(pointer);
+#endif
+}
+
+inline void updateMaximum(std::atomic<std::int64_t>& maximum, std::int64_t value) {
+    std::int64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+/** @brief 呼び出し元の表へ加算する（開番地法。確保は行わない）。 */
+inline void recordCallSite(std::uintptr_t site, std::size_t bytes) {
+    trackerState& tracker = state();
+    std::size_t index = static_cast<std::size_t>((site >> 4) * 0x9E3779B97F4A7C15ull) & (kCallSiteTableSize - 1);
+    for (std::size_t probe = 0; probe < kCallSiteTableSize; ++probe) {
+        callSiteEntry& entry = tracker.callSites[(index + probe) & (kCallSiteTableSize - 1)];
+        std::uintptr_t expected = entry.site.load(std::memory_order_relaxed);
+        if (expected == 0 && entry.site.compare_exchange_strong(expected, site, std::memory_order_relaxed)) {
+            expected = site;
+        }
+        if (expected == site) {
+            entry.count.fetch_add(1, std::memory_order_relaxed);
+            entry.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return;
+        }
+    }
+    tracker.overflowSiteCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/** @brief 確保1回を記録する（bytes は usableSize / alignedUsableSize で求めた大きさ）。 */
+inline void recordAllocation(void* pointer, std::size_t bytes, allocationKind kind, const void* site) {
+    if (pointer == nullptr) {
+        return;
+    }
+    trackerState& tracker = state();
+    (kind == allocationKind::newDelete ? tracker.newCount : tracker.mallocCount).fetch_add(1, std::memory_order_relaxed);
+    tracker.totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+    tracker.liveBlocks.fetch_add(1, std::memory_order_relaxed);
+    const std::int64_t live =
+        tracker.liveBytes.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed) +
+        static_cast<std::int64_t>(bytes);
+    updateMaximum(tracker.peakLiveBytes, live);
+    updateMaximum(tracker.scopePeakLiveBytes, live);
+    recordCallSite(reinterpret_cast<std::uintptr_t>(site), bytes);
+}
+
+/** @brief 解放1回を記録する（解放の前に大きさを求めて渡す）。 */
+inline void recordDeallocation(void* pointer, std::size_t bytes, allocationKind kind) {
+    if (pointer == nullptr) {
+        return;
+    }
+    trackerState& tracker = state();
+    (kind == allocationKind::newDelete ? tracker.deleteCount : tracker.freeCount).fetch_add(1, std::memory_order_relaxed);
+    tracker.liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+    tracker.liveBytes.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+}
+
+/** @brief 計測対象にならない確保/解放（operator new の中身から使う。malloc 横取りとの二重計上を避けるため）。 */
+inline void* rawAllocate(std::size_t size) {
+#if defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+    return __libc_malloc(size == 0 ? 1 : size);
+#else
+    return std::malloc(size == 0 ? 1 : size);
+#endif
+}
+
+inline void* rawAlignedAllocate(std::size_t size, std::size_t alignment) {
+#if defined(_WIN32)
+    return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#elif defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+    return __libc_memalign(alignment, size == 0 ? 1 : size);
+#else
+    return std::aligned_alloc(alignment, (size + alignment) / alignment * alignment);
+#endif
+}
+
+inline void rawFree(void* pointer) {
+#if defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+    __libc_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+inline void rawAlignedFree(void* pointer) {
+#if defined(_WIN32)
+    _aligned_free(pointer);
+#else
+    rawFree(pointer);
+#endif
+}
+
+/** @brief 呼び出し元1か所を「モジュール+オフセット (関数名)」で表示する。 */
+inline void printCallSite(std::FILE* out, std::uintptr_t site) {
+#if defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+    Dl_info info{};
+    if (dladdr(reinterpret_cast<void*>(site), &info) != 0 && info.dli_fname != nullptr) {
+        const char* moduleName = info.dli_fname;
+        for (const char* cursor = info.dli_fname; *cursor != '\0'; ++cursor) {
+            if (*cursor == '/') {
+                moduleName = cursor + 1;
+            }
+        }
+        std::fprintf(out, "%s+0x%" PRIxPTR " (%s)", moduleName,
+                     site - reinterpret_cast<std::uintptr_t>(info.dli_fbase),
+                     info.dli_sname != nullptr ? info.dli_sname : "?");
+        return;
+    }
+#endif
+    std::fprintf(out, "0x%" PRIxPTR, site);
+}
+
+/** @brief 集計を表示する（終了時に自動で呼ばれる。途中で呼んでもよい）。 */
+inline void printReport(std::FILE* out = stderr) {
+    trackerState& tracker = state();
+    std::fflush(stdout); // 標準出力の内容を先に出す（表示順をそろえるため）
+    std::fprintf(out, "\n=== allocationTracking report ===\n");
+    std::fprintf(out, "operator new   : %" PRIu64 " 回   operator delete: %" PRIu64 " 回\n",
+                 tracker.newCount.load(), tracker.deleteCount.load());
+#if defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+    std::fprintf(out, "malloc 系      : %" PRIu64 " 回   free           : %" PRIu64 " 回\n",
+                 tracker.mallocCount.load(), tracker.freeCount.load());
+#else
+    std::fprintf(out, "malloc 系      : (この環境では数えない)\n");
+#endif
+    std::fprintf(out, "確保バイト合計 : %" PRIu64 "   ピーク使用中バイト: %" PRId64 "\n", tracker.totalBytes.load(),
+                 tracker.peakLiveBytes.load());
+    std::fprintf(out, "未解放（リーク候補）: %" PRId64 " ブロック / %" PRId64 " バイト\n", tracker.liveBlocks.load(),
+                 tracker.liveBytes.load());
+
+    // 回数の多い順に kReportedCallSiteCount 件を選ぶ（確保しないよう固定長で選択）
+    std::size_t topIndices[kReportedCallSiteCount];
+    std::size_t topCount = 0;
+    for (std::size_t i = 0; i < kCallSiteTableSize; ++i) {
+        const std::uint64_t count = tracker.callSites[i].count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        std::size_t position = topCount < kReportedCallSiteCount ? topCount++ : kReportedCallSiteCount;
+        if (position == kReportedCallSiteCount) {
+            if (count <= tracker.callSites[topIndices[kReportedCallSiteCount - 1]].count.load()) {
+                continue;
+            }
+            position = kReportedCallSiteCount - 1;
+        }
+        while (position > 0 && tracker.callSites[topIndices[position - 1]].count.load() < count) {
+            topIndices[position] = topIndices[position - 1];
+            --position;
+        }
+        topIndices[position] = i;
+    }
+    std::fprintf(out, "呼び出し元（回数の多い順, 上位 %zu）:\n", topCount);
+    for (std::size_t rank = 0; rank < topCount; ++rank) {
+        const callSiteEntry& entry = tracker.callSites[topIndices[rank]];
+        std::fprintf(out, "  %2zu. %8" PRIu64 " 回 %12" PRIu64 " バイト  ", rank + 1, entry.count.load(),
+                     entry.bytes.load());
+        printCallSite(out, entry.site.load());
+        std::fprintf(out, "\n");
+    }
+    if (tracker.overflowSiteCount.load() != 0) {
+        std::fprintf(out, "  (表に入りきらなかった確保: %" PRIu64 " 回)\n", tracker.overflowSiteCount.load());
+    }
+}
+
+/** @brief 終了時に集計を表示するための static オブジェクト。 */
+struct reportAtExit {
+    reportAtExit() { (void)state(); }
+    ~reportAtExit() { printReport(); }
+};
+
+inline reportAtExit reportAtExitInstance;
+
+} // namespace allocationTracking
+
+// =============================================
+// グローバル operator new/delete の置き換え
+// =============================================
+// GCC 12 以降は「operator new の戻り値を free している」と誤検出することがあるため抑止する（new/delete とも同じ系統で対）。
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// 置き換えた確保関数は noinline にする（インライン展開されると戻り先アドレスが「呼び出し元の呼び出し元」になるため）。
+ALLOCATION_TRACKING_NOINLINE void* operator new(std::size_t size) {
+    void* pointer = allocationTracking::rawAllocate(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    allocationTracking::recordAllocation(pointer, allocationTracking::usableSize(pointer),
+                                         allocationTracking::allocationKind::newDelete,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return pointer;
+}
+
+ALLOCATION_TRACKING_NOINLINE void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* pointer = allocationTracking::rawAlignedAllocate(size, static_cast<std::size_t>(alignment));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    allocationTracking::recordAllocation(pointer,
+                                         allocationTracking::alignedUsableSize(pointer, static_cast<std::size_t>(alignment)),
+                                         allocationTracking::allocationKind::newDelete,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    allocationTracking::recordDeallocation(pointer, allocationTracking::usableSize(pointer),
+                                           allocationTracking::allocationKind::newDelete);
+    allocationTracking::rawFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept { operator delete(pointer); }
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    allocationTracking::recordDeallocation(pointer,
+                                           allocationTracking::alignedUsableSize(pointer, static_cast<std::size_t>(alignment)),
+                                           allocationTracking::allocationKind::newDelete);
+    allocationTracking::rawAlignedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(pointer, alignment);
+}
+
+// =============================================
+// malloc 系の横取り（glibc のみ）
+// =============================================
+#if defined(ALLOCATION_TRACKING_INTERPOSE_MALLOC)
+extern "C" {
+
+ALLOCATION_TRACKING_NOINLINE void* malloc(std::size_t size) noexcept {
+    void* pointer = __libc_malloc(size);
+    allocationTracking::recordAllocation(pointer, pointer != nullptr ? allocationTracking::usableSize(pointer) : 0,
+                                         allocationTracking::allocationKind::mallocFree,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return pointer;
+}
+
+ALLOCATION_TRACKING_NOINLINE void* calloc(std::size_t count, std::size_t size) noexcept {
+    void* pointer = __libc_calloc(count, size);
+    allocationTracking::recordAllocation(pointer, pointer != nullptr ? allocationTracking::usableSize(pointer) : 0,
+                                         allocationTracking::allocationKind::mallocFree,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return pointer;
+}
+
+ALLOCATION_TRACKING_NOINLINE void* realloc(void* pointer, std::size_t size) noexcept {
+    // realloc は「古い領域の解放 + 新しい領域の確保」として数える（失敗時は古い領域がそのまま残る）
+    const std::size_t oldBytes = pointer != nullptr ? allocationTracking::usableSize(pointer) : 0;
+    void* resized = __libc_realloc(pointer, size);
+    if (resized == nullptr && size != 0) {
+        return nullptr;
+    }
+    if (pointer != nullptr) {
+        allocationTracking::trackerState& tracker = allocationTracking::state();
+        tracker.freeCount.fetch_add(1, std::memory_order_relaxed);
+        tracker.liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+        tracker.liveBytes.fetch_sub(static_cast<std::int64_t>(oldBytes), std::memory_order_relaxed);
+    }
+    allocationTracking::recordAllocation(resized, resized != nullptr ? allocationTracking::usableSize(resized) : 0,
+                                         allocationTracking::allocationKind::mallocFree,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return resized;
+}
+
+ALLOCATION_TRACKING_NOINLINE void* memalign(std::size_t alignment, std::size_t size) noexcept {
+    void* pointer = __libc_memalign(alignment, size);
+    allocationTracking::recordAllocation(pointer, pointer != nullptr ? allocationTracking::usableSize(pointer) : 0,
+                                         allocationTracking::allocationKind::mallocFree,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return pointer;
+}
+
+ALLOCATION_TRACKING_NOINLINE void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+    void* pointer = __libc_memalign(alignment, size);
+    allocationTracking::recordAllocation(pointer, pointer != nullptr ? allocationTracking::usableSize(pointer) : 0,
+                                         allocationTracking::allocationKind::mallocFree,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    return pointer;
+}
+
+ALLOCATION_TRACKING_NOINLINE int posix_memalign(void** result, std::size_t alignment, std::size_t size) noexcept {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return 22; // EINVAL
+    }
+    void* pointer = __libc_memalign(alignment, size);
+    if (pointer == nullptr) {
+        return 12; // ENOMEM
+    }
+    allocationTracking::recordAllocation(pointer, pointer != nullptr ? allocationTracking::usableSize(pointer) : 0,
+                                         allocationTracking::allocationKind::mallocFree,
+                                         ALLOCATION_TRACKING_RETURN_ADDRESS());
+    *result = pointer;
+    return 0;
+}
+
+void free(void* pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    allocationTracking::recordDeallocation(pointer, allocationTracking::usableSize(pointer),
+                                           allocationTracking::allocationKind::mallocFree);
+    __libc_free(pointer);
+}
+
+} // extern "C"
+#endif // ALLOCATION_TRACKING_INTERPOSE_MALLOC
+
+#endif // ALLOCATION_TRACKING
+
+/**
+ * @brief スコープ（ブロック）1つの間の確保を測り、スコープ終了時に表示する。
+ * @details
+ * - ALLOCATION_TRACKING 未定義のときは何もしない（同じコードのまま計測あり/なしを切り替えられる）。
+ * - 表示: new 回数 / delete 回数 / malloc 回数 / 確保バイト / ブロック内のピーク増加量 / 終了時の未解放増減
+ */
+class allocationProbe {
+public:
+    explicit allocationProbe(const char* label) : label_(label) {
+#if defined(ALLOCATION_TRACKING)
+        allocationTracking::trackerState& tracker = allocationTracking::state();
+        startNewCount_ = tracker.newCount.load();
+        startDeleteCount_ = tracker.deleteCount.load();
+        startMallocCount_ = tracker.mallocCount.load();
+        startTotalBytes_ = tracker.totalBytes.load();
+        startLiveBytes_ = tracker.liveBytes.load();
+        tracker.scopePeakLiveBytes.store(startLiveBytes_);
+#endif
+    }
+
+    allocationProbe(const allocationProbe&) = delete;
+    allocationProbe& operator=(const allocationProbe&) = delete;
+
+    ~allocationProbe() {
+#if defined(ALLOCATION_TRACKING)
+        std::fflush(stdout);
+        std::fprintf(stderr,
+                     "[allocationProbe] %s: new=%" PRIu64 " delete=%" PRIu64 " malloc=%" PRIu64 " bytes=%" PRIu64
+                     " peak=+%" PRId64 " live=%+" PRId64 "\n",
+                     label_, newCount(), deleteCount(), mallocCount(), allocatedBytes(), peakBytes(), liveBytesDelta());
+#endif
+    }
+
+#if defined(ALLOCATION_TRACKING)
+    std::uint64_t newCount() const { return allocationTracking::state().newCount.load() - startNewCount_; }
+    std::uint64_t deleteCount() const { return allocationTracking::state().deleteCount.load() - startDeleteCount_; }
+    std::uint64_t mallocCount() const { return allocationTracking::state().mallocCount.load() - startMallocCount_; }
+    std::uint64_t allocatedBytes() const { return allocationTracking::state().totalBytes.load() - startTotalBytes_; }
+    std::int64_t peakBytes() const { return allocationTracking::state().scopePeakLiveBytes.load() - startLiveBytes_; }
+    std::int64_t liveBytesDelta() const { return allocationTracking::state().liveBytes.load() - startLiveBytes_; }
+#else
+    std::uint64_t newCount() const { return 0; }
+    std::uint64_t deleteCount() const { return 0; }
+    std::uint64_t mallocCount() const { return 0; }
+    std::uint64_t allocatedBytes() const { return 0; }
+    std::int64_t peakBytes() const { return 0; }
+    std::int64_t liveBytesDelta() const { return 0; }
+#endif
+
+private:
+    const char* label_;
+#if defined(ALLOCATION_TRACKING)
+    std::uint64_t startNewCount_ = 0;
+    std::uint64_t startDeleteCount_ = 0;
+    std::uint64_t startMallocCount_ = 0;
+    std::uint64_t startTotalBytes_ = 0;
+    std::int64_t startLiveBytes_ = 0;
+#endif
+};
@@ -288,12 +288,17 @@ void demonstrateSmartPointers() {
 ////////////////////////////////////////////////////////////////////////////////
 // エントリーポイント
 ////////////////////////////////////////////////////////////////////////////////
-int main() {
+int main(int argc, char** argv) {
 #ifdef _WIN32
     // コンソールのコードページを UTF-8 に設定（日本語文字化け防止）
     SetConsoleOutputCP(CP_UTF8);
 #endif
 
+    // ヘッドレス一括描画（--render-scene など）が指定されたら、デモを実行せずそれだけを行う
+    if (isOpenCvBatchCommand(argc, argv)) {
+        return runOpenCvBatchCommand(argc, argv);
+    }
+
     std::cout << "===============================================================" << std::endl;
     std::cout << " C++ バージョン: " << getCppVersion() << std::endl;
     std::cout << "===============================================================" << std::endl << std::endl;
@@ -1,6 +1,6 @@
 /**
  * @file lambda_vs_function.cpp
- * @brief C++ におけるラムダ式と従来の関数オブジェクト／関数ポインタの比較サンプル
+ * @brief C++ におけるラムダ式と従来の関数オブジェクト／関数ポインタの比較サンプル（呼び出し方式ベンチマーク付き）
  *
  * 概要:
  *   1. 関数ポインタ (Cスタイル)
@@ -8,19 +8,72 @@
  *   3. std::function + ラムダ式 (C++11〜) : 柔軟で可読性が高い
  *   4. ジェネリックラムダ (C++14〜) と `auto` パラメータ
  *   5. キャプチャリストによる状態保持
+ *   6. FunctionRef      : 所有しない呼び出し参照（function_ref 相当。確保なし・コピー2ワード）
+ *   7. SmallFunction    : 小さなキャプチャを内部バッファに置くムーブ専用の関数ラッパ（SBO）
  * 主な仕様:
- *   - 10 個の整数に対して、さまざまなフィルター関数を適用
- *   - 可読性・パフォーマンス・柔軟性の観点を比較
+ *   - デモ: 10 個の整数に対して、さまざまなフィルター関数を適用（従来どおり）
+ *   - ベンチマーク: 大きな配列（既定 1000 万要素）に同じ条件の std::copy_if / std::count_if を各方式で実行し、
+ *     1要素あたりの時間（中央値）と、テンプレートで直接呼ぶ方式との比を表示
+ *   - 確保回数: キャプチャの大きさごとに、std::function / SmallFunction / FunctionRef の
+ *     構築1回あたりの heap 確保回数を、グローバル operator new を数えて表示
  *   - コンパイル時に `-std:c++17` 以上が必要
+ * 制限事項:
+ *   - 計測は最適化ありのビルドで行うこと（最適化なしではインライン化の差が出ない）
+ *   - グローバル operator new を置き換えて数えるため、このプログラム全体の確保が数えられる
+ *
+ * 使い方:
+ *   lambda_vs_function.exe                       ... デモ + ベンチマーク（既定サイズ）
+ *   lambda_vs_function.exe --size 1000000 --trials 9
+ *   lambda_vs_function.exe --demo-only
  *
  * コンパイル例 (MSVC x64):
- *   cl /utf-8 /EHsc /std:c++17 lambda_vs_function.cpp /Fe:lambda_vs_function.exe
+ *   cl /utf-8 /EHsc /std:c++17 /O2 lambda_vs_function.cpp /Fe:lambda_vs_function.exe
+ * コンパイル例 (GCC/Clang):
+ *   g++ -std=c++17 -O2 lambda_vs_function.cpp -o lambda_vs_function
  */
 
 #include <iostream>
 #include <vector>
 #include <functional>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// =============================================
+// 確保回数の計測（グローバル operator new の置き換え）
+// =============================================
+namespace allocationCounter {
+std::atomic<std::uint64_t> allocationCount{0};
+std::atomic<std::uint64_t> allocatedBytes{0};
+}
+
+// GCC 12 以降は「operator new の戻り値を free している」と誤検出することがあるため抑止する（new/delete とも malloc/free で対）。
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    allocationCounter::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationCounter::allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
 
 // =============================================
 // 1. 関数ポインタ (Cスタイル)
@@ -36,9 +89,458 @@ struct IsMultipleOf {
     bool operator()(int n) const { return n % divisor == 0; }
 };
 
-int main() {
-    std::cout << "=== C++ ラムダ式 vs 従来手法 ===\n";
+// =============================================
+// 6. FunctionRef（所有しない呼び出し参照）
+// =============================================
+template <class Signature>
+class FunctionRef;
+
+/**
+ * @brief 呼び出し可能オブジェクトへの「所有しない参照」。
+ * @details
+ * - 中身は「対象のアドレス」と「呼び出し用の関数ポインタ」の2ワードだけ。確保もコピーも発生しない。
+ * - 呼び出しは関数ポインタ経由（間接呼び出し1回）。std::function と違い、空状態の確認や型消去の管理部が無い。
+ * - [注意] 参照先より長く生きてはいけない（引数で受け取り、その場で呼ぶ用途に限る）。
+ */
+template <class R, class... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <class F,
+              class = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value &&
+                                       std::is_invocable_r<R, F&, Args...>::value>>
+    FunctionRef(F&& callable) noexcept
+        : object_(const_cast<void*>(static_cast<const void*>(std::addressof(callable)))),
+          invoker_([](void* object, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F>*>(object))(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return invoker_(object_, std::forward<Args>(args)...); }
+
+private:
+    void* object_;
+    R (*invoker_)(void*, Args...);
+};
+
+// =============================================
+// 7. SmallFunction（SBO 付きムーブ専用関数ラッパ）
+// =============================================
+template <class Signature, std::size_t InlineBytes = 32>
+class SmallFunction;
+
+/**
+ * @brief 小さなキャプチャを内部バッファに置く、ムーブ専用の関数ラッパ。
+ * @details
+ * - InlineBytes 以下で、nothrow でムーブできるキャプチャは内部バッファへ置く（heap 確保なし）。
+ *   それより大きいものだけ heap に置く。
+ * - コピーできない（ムーブ専用）。そのため unique_ptr などムーブ専用のキャプチャも保持できる。
+ * - 呼び出しは invoker_ 経由の間接呼び出し1回（管理用の manager_ は構築/ムーブ/破棄でしか使わない）。
+ */
+template <class R, class... Args, std::size_t InlineBytes>
+class SmallFunction<R(Args...), InlineBytes> {
+public:
+    SmallFunction() noexcept = default;
+
+    template <class F,
+              class = std::enable_if_t<!std::is_same<std::decay_t<F>, SmallFunction>::value &&
+                                       std::is_invocable_r<R, std::decay_t<F>&, Args...>::value>>
+    SmallFunction(F&& callable) {
+        using Stored = std::decay_t<F>;
+        if constexpr (isStoredInline<Stored>()) {
+            object_ = ::new (static_cast<void*>(buffer_)) Stored(std::forward<F>(callable));
+            manager_ = &manageInline<Stored>;
+        } else {
+            object_ = new Stored(std::forward<F>(callable));
+            manager_ = &manageHeap<Stored>;
+        }
+        invoker_ = [](void* object, Args... args) -> R {
+            return (*static_cast<Stored*>(object))(std::forward<Args>(args)...);
+        };
+    }
+
+    SmallFunction(SmallFunction&& other) noexcept { moveFrom(other); }
+
+    SmallFunction& operator=(SmallFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallFunction(const SmallFunction&) = delete;
+    SmallFunction& operator=(const SmallFunction&) = delete;
+
+    ~SmallFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return invoker_ != nullptr; }
+
+    R operator()(Args... args) const { return invoker_(object_, std::forward<Args>(args)...); }
+
+    /** @brief 型 F がこのラッパの内部バッファに置かれるか（heap 確保が起きないか）。 */
+    template <class F>
+    static constexpr bool isStoredInline() {
+        return sizeof(F) <= InlineBytes && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+private:
+    enum class operation { moveTo, destroy };
+    using managerFunction = void (*)(operation, SmallFunction* self, SmallFunction* destination);
+
+    template <class Stored>
+    static void manageInline(operation op, SmallFunction* self, SmallFunction* destination) {
+        Stored* stored = static_cast<Stored*>(self->object_);
+        if (op == operation::moveTo) {
+            destination->object_ = ::new (static_cast<void*>(destination->buffer_)) Stored(std::move(*stored));
+        }
+        stored->~Stored();
+    }
+
+    template <class Stored>
+    static void manageHeap(operation op, SmallFunction* self, SmallFunction* destination) {
+        if (op == operation::moveTo) {
+            destination->object_ = self->object_;  // heap の場合はポインタを渡すだけ
+        } else {
+            delete static_cast<Stored*>(self->object_);
+        }
+    }
+
+    void moveFrom(SmallFunction& other) noexcept {
+        if (other.manager_ == nullptr) {
+            return;
+        }
+        other.manager_(operation::moveTo, &other, this);
+        manager_ = other.manager_;
+        invoker_ = other.invoker_;
+        other.object_ = nullptr;
+        other.manager_ = nullptr;
+        other.invoker_ = nullptr;
+    }
+
+    void reset() noexcept {
+        if (manager_ != nullptr) {
+            manager_(operation::destroy, this, nullptr);
+        }
+        object_ = nullptr;
+        manager_ = nullptr;
+        invoker_ = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char buffer_[InlineBytes];
+    void* object_ = nullptr;
+    managerFunction manager_ = nullptr;
+    R (*invoker_)(void*, Args...) = nullptr;
+};
+
+// =============================================
+// ベンチマーク
+// =============================================
+namespace {
+
+/** @brief 既定の要素数（大きな配列）。 */
+constexpr std::size_t kDefaultElementCount = 10'000'000;
+/** @brief 既定の試行回数（中央値を取る）。 */
+constexpr int kDefaultTrialCount = 7;
+
+/**
+ * @brief 結果を「使った」ことにして、最適化で計算ごと消されるのを防ぐ。
+ */
+template <class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char sink;
+    sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+}
+
+/**
+ * @brief 述語を受けて copy_if を回すテンプレート（呼び出し側の型がそのまま見える = インライン展開できる）。
+ */
+template <class Predicate>
+std::size_t filterWithTemplate(const std::vector<int>& input, std::vector<int>& output, Predicate predicate) {
+    int* const end = std::copy_if(input.data(), input.data() + input.size(), output.data(), predicate);
+    return static_cast<std::size_t>(end - output.data());
+}
+
+/**
+ * @brief 述語を受けて count_if を回すテンプレート。
+ * @details
+ * - 分岐の無い単純なループなので、述語がインライン展開されると SIMD 化されることがある。
+ *   インライン展開できない方式（間接呼び出し）との差が copy_if より大きく出る。
+ */
+template <class Predicate>
+std::size_t countWithTemplate(const std::vector<int>& input, Predicate predicate) {
+    return static_cast<std::size_t>(std::count_if(input.begin(), input.end(), predicate));
+}
+
+/**
+ * @brief 述語を std::function で受ける版（呼び出しは毎回、型消去された間接呼び出し）。
+ */
+std::size_t filterWithStdFunction(const std::vector<int>& input, std::vector<int>& output,
+                                  const std::function<bool(int)>& predicate) {
+    return filterWithTemplate(input, output, std::cref(predicate));
+}
+
+std::size_t countWithStdFunction(const std::vector<int>& input, const std::function<bool(int)>& predicate) {
+    return countWithTemplate(input, std::cref(predicate));
+}
 
+/**
+ * @brief 述語を FunctionRef で受ける版。
+ */
+std::size_t filterWithFunctionRef(const std::vector<int>& input, std::vector<int>& output,
+                                  FunctionRef<bool(int)> predicate) {
+    return filterWithTemplate(input, output, predicate);
+}
+
+std::size_t countWithFunctionRef(const std::vector<int>& input, FunctionRef<bool(int)> predicate) {
+    return countWithTemplate(input, predicate);
+}
+
+/**
+ * @brief 述語を SmallFunction で受ける版。
+ */
+std::size_t filterWithSmallFunction(const std::vector<int>& input, std::vector<int>& output,
+                                    const SmallFunction<bool(int)>& predicate) {
+    return filterWithTemplate(input, output, std::cref(predicate));
+}
+
+std::size_t countWithSmallFunction(const std::vector<int>& input, const SmallFunction<bool(int)>& predicate) {
+    return countWithTemplate(input, std::cref(predicate));
+}
+
+/** @brief 関数ポインタ方式用の「状態」。C のコールバックはグローバル変数か void* で状態を渡すしかない。 */
+int benchDivisor = 2;
+
+/** @brief benchDivisor で割り切れるか（関数ポインタ方式のベンチマーク用）。 */
+bool isMultipleOfBenchDivisor(int n) { return n % benchDivisor == 0; }
+
+/**
+ * @brief 1方式分の計測結果。
+ */
+struct BenchResult {
+    std::string name;
+    double copyIfNsPerElement = 0.0;   // copy_if の中央値
+    double countIfNsPerElement = 0.0;  // count_if の中央値
+    std::size_t matchedCount = 0;
+    std::uint64_t allocationsDuringRun = 0;
+};
+
+/**
+ * @brief 処理を trialCount 回実行し、1要素あたりの時間の中央値を返す（予熱1回を含む）。
+ * @param elementCount 要素数
+ * @param trialCount 試行回数
+ * @param run 実行する処理（一致数を返す）
+ * @param matchedCountOut 一致数
+ * @return double 中央値 [ns/要素]
+ */
+template <class Run>
+double measureMedian(std::size_t elementCount, int trialCount, Run&& run, std::size_t* matchedCountOut) {
+    std::vector<double> nsPerElement;
+    nsPerElement.reserve(static_cast<std::size_t>(trialCount));
+    *matchedCountOut = run();  // 予熱（キャッシュ・分岐予測・ページ割り当て）
+    for (int trial = 0; trial < trialCount; ++trial) {
+        const auto start = std::chrono::steady_clock::now();
+        *matchedCountOut = run();
+        const auto end = std::chrono::steady_clock::now();
+        doNotOptimize(*matchedCountOut);
+        nsPerElement.push_back(std::chrono::duration<double, std::nano>(end - start).count() /
+                               static_cast<double>(elementCount));
+    }
+    std::sort(nsPerElement.begin(), nsPerElement.end());
+    return nsPerElement[nsPerElement.size() / 2];
+}
+
+/**
+ * @brief 1方式分（copy_if と count_if）を計測する。
+ * @param name 方式名
+ * @param elementCount 要素数
+ * @param trialCount 試行回数
+ * @param copyIf copy_if を実行する処理
+ * @param countIf count_if を実行する処理
+ * @return BenchResult 計測結果
+ * @throws std::runtime_error copy_if と count_if の一致数が違う場合
+ */
+template <class CopyIf, class CountIf>
+BenchResult measure(const std::string& name, std::size_t elementCount, int trialCount, CopyIf&& copyIf,
+                    CountIf&& countIf) {
+    BenchResult result;
+    result.name = name;
+    std::size_t countedMatches = 0;
+    const std::uint64_t allocationsBefore = allocationCounter::allocationCount.load();
+    result.copyIfNsPerElement = measureMedian(elementCount, trialCount, copyIf, &result.matchedCount);
+    result.countIfNsPerElement = measureMedian(elementCount, trialCount, countIf, &countedMatches);
+    // 計測用 vector 2個分の確保を除く（残りが呼び出し方式そのものによる確保）。
+    result.allocationsDuringRun = allocationCounter::allocationCount.load() - allocationsBefore - 2;
+    if (countedMatches != result.matchedCount) {
+        throw std::runtime_error("measure: copy_if and count_if disagree. name=" + name);
+    }
+    return result;
+}
+
+/**
+ * @brief キャプチャの大きさを変えるための状態（Bytes バイト）。
+ */
+template <std::size_t Bytes>
+struct CapturedState {
+    int divisor = 2;
+    unsigned char padding[Bytes > sizeof(int) ? Bytes - sizeof(int) : 1] = {};
+};
+
+/**
+ * @brief キャプチャの大きさ Bytes ごとに、構築1回あたりの heap 確保回数を数えて表示する。
+ */
+template <std::size_t Bytes>
+void printAllocationRow(int constructionCount) {
+    const CapturedState<Bytes> state;
+    const auto lambda = [state](int n) { return n % state.divisor == 0; };
+
+    const auto countAllocations = [constructionCount](auto&& construct) {
+        const std::uint64_t before = allocationCounter::allocationCount.load();
+        for (int i = 0; i < constructionCount; ++i) {
+            construct();
+        }
+        return static_cast<double>(allocationCounter::allocationCount.load() - before) / constructionCount;
+    };
+    const double stdFunctionAllocations = countAllocations([&]() {
+        std::function<bool(int)> wrapped = lambda;
+        doNotOptimize(wrapped);
+    });
+    const double smallFunctionAllocations = countAllocations([&]() {
+        SmallFunction<bool(int)> wrapped = lambda;
+        doNotOptimize(wrapped);
+    });
+    const double functionRefAllocations = countAllocations([&]() {
+        FunctionRef<bool(int)> wrapped = lambda;
+        doNotOptimize(wrapped);
+    });
+    std::cout << "  capture=" << std::setw(4) << sizeof(lambda) << " byte"
+              << "  std::function=" << stdFunctionAllocations
+              << "  SmallFunction<32>=" << smallFunctionAllocations
+              << (SmallFunction<bool(int)>::isStoredInline<decltype(lambda)>() ? " (inline)" : " (heap)")
+              << "  FunctionRef=" << functionRefAllocations << "\n";
+}
+
+/**
+ * @brief 整数オプション（--size / --trials）を読む。
+ * @throws std::runtime_error 値が正の整数でない場合
+ */
+std::size_t parsePositiveOption(int argc, char** argv, const std::string& name, std::size_t defaultValue) {
+    for (int i = 1; i < argc; ++i) {
+        if (name != argv[i]) {
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("parsePositiveOption: missing value for " + name);
+        }
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(argv[i + 1], &end, 10);
+        if (end == argv[i + 1] || *end != '\0' || value == 0) {
+            throw std::runtime_error("parsePositiveOption: invalid " + name + " \"" + argv[i + 1] + "\"");
+        }
+        return static_cast<std::size_t>(value);
+    }
+    return defaultValue;
+}
+
+/**
+ * @brief 大きな配列での呼び出し方式ベンチマークを実行する。
+ * @details
+ * - すべての方式で「2で割り切れるか」という同じ条件を使う（違いは呼び出し方だけ）。
+ * - 状態を持つ方式の divisor は volatile 経由で読み、定数として畳み込まれないようにする。
+ * - 関数ポインタ方式は状態を持てないため、divisor をグローバル変数（benchDivisor）経由で読む。
+ * - 関数ポインタは2通り測る: そのまま渡す（コンパイラが呼び先を知っている→インライン化されうる）と、
+ *   volatile 経由で渡す（呼び先が実行時まで分からない→必ず間接呼び出し）。
+ */
+void runBenchmark(std::size_t elementCount, int trialCount) {
+    std::cout << "\n=== 呼び出し方式ベンチマーク (要素数=" << elementCount << ", 試行=" << trialCount
+              << ", 中央値) ===\n";
+#if !defined(__OPTIMIZE__) && (defined(__GNUC__) || defined(__clang__))
+    std::cout << "[注意] 最適化なしのビルドです。-O2 以上でビルドした結果を比べてください。\n";
+#endif
+
+    std::vector<int> input(elementCount);
+    std::mt19937 random(12345U);
+    std::uniform_int_distribution<int> distribution(0, 1'000'000);
+    for (int& value : input) {
+        value = distribution(random);
+    }
+    std::vector<int> output(elementCount);
+
+    static volatile int volatileDivisor = 2;
+    const int divisor = volatileDivisor;
+    benchDivisor = divisor;
+    bool (*volatile volatileFunctionPointer)(int) = isMultipleOfBenchDivisor;
+    bool (*const opaqueFunctionPointer)(int) = volatileFunctionPointer;
+
+    const auto captureByReference = [&divisor](int n) { return n % divisor == 0; };
+    const auto captureByValue = [divisor](int n) { return n % divisor == 0; };
+    const auto genericLambda = [divisor](auto n) { return n % divisor == 0; };
+    const std::function<bool(int)> stdFunction = captureByValue;
+    const SmallFunction<bool(int)> smallFunction = captureByValue;
+
+    std::vector<BenchResult> results;
+    results.push_back(measure("generic-lambda(template)", elementCount, trialCount,
+                              [&]() { return filterWithTemplate(input, output, genericLambda); },
+                              [&]() { return countWithTemplate(input, genericLambda); }));
+    results.push_back(measure("function-pointer(direct)", elementCount, trialCount,
+                              [&]() { return filterWithTemplate(input, output, isMultipleOfBenchDivisor); },
+                              [&]() { return countWithTemplate(input, isMultipleOfBenchDivisor); }));
+    results.push_back(measure("function-pointer(opaque)", elementCount, trialCount,
+                              [&]() { return filterWithTemplate(input, output, opaqueFunctionPointer); },
+                              [&]() { return countWithTemplate(input, opaqueFunctionPointer); }));
+    results.push_back(measure("functor(IsMultipleOf)", elementCount, trialCount,
+                              [&]() { return filterWithTemplate(input, output, IsMultipleOf{divisor}); },
+                              [&]() { return countWithTemplate(input, IsMultipleOf{divisor}); }));
+    results.push_back(measure("lambda[&divisor]", elementCount, trialCount,
+                              [&]() { return filterWithTemplate(input, output, captureByReference); },
+                              [&]() { return countWithTemplate(input, captureByReference); }));
+    results.push_back(measure("std::function", elementCount, trialCount,
+                              [&]() { return filterWithStdFunction(input, output, stdFunction); },
+                              [&]() { return countWithStdFunction(input, stdFunction); }));
+    results.push_back(measure("FunctionRef", elementCount, trialCount,
+                              [&]() { return filterWithFunctionRef(input, output, captureByValue); },
+                              [&]() { return countWithFunctionRef(input, captureByValue); }));
+    results.push_back(measure("SmallFunction", elementCount, trialCount,
+                              [&]() { return filterWithSmallFunction(input, output, smallFunction); },
+                              [&]() { return countWithSmallFunction(input, smallFunction); }));
+
+    const BenchResult& baseline = results.front();
+    std::cout << "  " << std::left << std::setw(26) << "callable" << std::right
+              << "   copy_if [ns/elem]    count_if [ns/elem]\n";
+    for (const BenchResult& result : results) {
+        if (result.matchedCount != baseline.matchedCount) {
+            throw std::runtime_error("runBenchmark: result mismatch. name=" + result.name);
+        }
+        std::cout << "  " << std::left << std::setw(26) << result.name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(8) << result.copyIfNsPerElement << " (x" << std::setprecision(2)
+                  << result.copyIfNsPerElement / baseline.copyIfNsPerElement << ")    " << std::setprecision(3)
+                  << std::setw(8) << result.countIfNsPerElement << " (x" << std::setprecision(2)
+                  << result.countIfNsPerElement / baseline.countIfNsPerElement << ")"
+                  << "  alloc=" << result.allocationsDuringRun << "\n";
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+    std::cout << "  (一致数=" << baseline.matchedCount << "、x は generic-lambda(template) との比)\n";
+    std::cout << "  copy_if は一致/不一致の分岐予測ミスが大きく、差が埋もれやすい。"
+              << "count_if はインライン展開されると SIMD 化され、間接呼び出しとの差がはっきり出る。\n";
+
+    std::cout << "\n=== キャプチャの大きさと heap 確保回数（構築1回あたり） ===\n";
+    constexpr int kConstructionCount = 1000;
+    printAllocationRow<8>(kConstructionCount);
+    printAllocationRow<16>(kConstructionCount);
+    printAllocationRow<32>(kConstructionCount);
+    printAllocationRow<64>(kConstructionCount);
+    printAllocationRow<256>(kConstructionCount);
+    std::cout << "  (std::function の内部バッファの大きさは標準ライブラリ実装ごとに違う)\n";
+}
+
+/**
+ * @brief 10 要素でのデモ（従来の内容）。
+ */
+void runDemo() {
     std::vector<int> numbers{1,2,3,4,5,6,7,8,9,10};
 
     // ---------------------------------------------
@@ -110,6 +612,44 @@ int main() {
         std::cout << "\n";
     }
 
-    std::cout << "\nプログラムが正常に終了しました。\n";
-    return 0;
+    // ---------------------------------------------
+    // 6. FunctionRef / 7. SmallFunction
+    // ---------------------------------------------
+    {
+        std::cout << "\n-- FunctionRef / SmallFunction (3 の倍数) --\n";
+        const IsMultipleOf multipleOf3{3};
+        const FunctionRef<bool(int)> reference = multipleOf3;  // 参照するだけ（multipleOf3 より長く使わない）
+        auto owner = std::make_unique<IsMultipleOf>(3);
+        // ムーブ専用のキャプチャ（unique_ptr）も持てる。std::function はコピー可能を要求するため持てない。
+        const SmallFunction<bool(int)> owning = [owner = std::move(owner)](int n) { return (*owner)(n); };
+        for (int n : numbers) {
+            if (reference(n) && owning(n)) std::cout << n << ' ';
+        }
+        std::cout << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        std::cout << "=== C++ ラムダ式 vs 従来手法 ===\n";
+        runDemo();
+
+        bool isDemoOnly = false;
+        for (int i = 1; i < argc; ++i) {
+            isDemoOnly = isDemoOnly || std::string(argv[i]) == "--demo-only";
+        }
+        if (!isDemoOnly) {
+            const std::size_t elementCount = parsePositiveOption(argc, argv, "--size", kDefaultElementCount);
+            const int trialCount = static_cast<int>(parsePositiveOption(argc, argv, "--trials", kDefaultTrialCount));
+            runBenchmark(elementCount, trialCount);
+        }
+
+        std::cout << "\nプログラムが正常に終了しました。\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "[error] function=main(file=lambda_vs_function.cpp) message=\"" << ex.what() << "\"\n";
+        return 1;
+    }
 }
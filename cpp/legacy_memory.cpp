@@ -10,18 +10,24 @@
  *   1. new で確保した整数配列を手動で delete[]
  *   2. malloc で確保した C 配列を free
  *   3. 手動解放を忘れた場合のメモリリークを実演
+ *      （-DALLOCATION_TRACKING を付けてコンパイルすると、終了時の集計に未解放のブロックとして表示される）
  * 制限事項:
  *   - 例外安全性は考慮していない（あえて古いコード例として）
  *   - C++17 以降でもコンパイルは可能だが推奨されない
  *
  * コンパイル例:
  *   cl /utf-8 /EHsc /std:c++17 legacy_memory.cpp /Fe:legacy_memory.exe
+ * コンパイル例（確保の計測あり）:
+ *   cl /utf-8 /EHsc /std:c++17 /DALLOCATION_TRACKING legacy_memory.cpp /Fe:legacy_memory.exe
+ *   g++ -std=c++17 -O2 -g -rdynamic -DALLOCATION_TRACKING legacy_memory.cpp -o legacy_memory
  */
 
 #include <iostream>
 #include <cstdlib>  // malloc, free
 #include <cstring>  // memset
 
+#include "allocation_tracker.hpp"
+
 int main() {
     std::cout << "=== 旧式メモリ管理サンプル ===\n";
 
@@ -30,6 +36,7 @@ int main() {
     // ------------------------------
     {
         std::cout << "\n-- new / delete[] サンプル --\n";
+        allocationProbe probe("new[] / delete[]");
         const size_t size = 5;
         int* numbers = new int[size];  // 動的配列の確保
 
@@ -53,6 +60,7 @@ int main() {
     // ------------------------------
     {
         std::cout << "\n-- malloc / free サンプル --\n";
+        allocationProbe probe("malloc / free");
         const size_t size = 5;
         int* numbers = static_cast<int*>(std::malloc(size * sizeof(int)));
         if (!numbers) {
@@ -79,6 +87,7 @@ int main() {
     // ------------------------------
     {
         std::cout << "\n-- メモリリーク例 (delete 忘れ) --\n";
+        allocationProbe probe("leak (delete[] 忘れ)");
         int* leakPtr = new int[10];
         for (int i = 0; i < 10; ++i) leakPtr[i] = i;
         std::cout << "delete[] を忘れるとリーク!\n";
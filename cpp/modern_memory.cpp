@@ -10,18 +10,26 @@
  *   1. 動的に確保した整数配列を std::unique_ptr で自動管理
  *   2. クラス Sample オブジェクトを std::shared_ptr で共有管理
  *   3. 循環参照を避けるため std::weak_ptr を利用
+ *   4. 確保回数の比較: make_shared と shared_ptr(new ...)、コピーとムーブ
+ *      （-DALLOCATION_TRACKING を付けてコンパイルすると、allocation_tracker.hpp が回数/バイト数を表示する）
  * 制限事項:
  *   - C++17 以降でのコンパイルを想定
  *   - スマートポインタを使用しない old-style new/delete は含まない
  *
  * コンパイル例:
  *   cl /utf-8 /EHsc /std:c++17 modern_memory.cpp /Fe:modern_memory.exe
+ * コンパイル例（確保の計測あり）:
+ *   cl /utf-8 /EHsc /std:c++17 /DALLOCATION_TRACKING modern_memory.cpp /Fe:modern_memory.exe
+ *   g++ -std=c++17 -O2 -g -rdynamic -DALLOCATION_TRACKING modern_memory.cpp -o modern_memory
  */
 
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
+
+#include "allocation_tracker.hpp"
 
 /**
  * @class Sample
@@ -67,6 +75,7 @@ int main() {
     // ------------------------------
     {
         std::cout << "\n-- unique_ptr サンプル --\n";
+        allocationProbe probe("unique_ptr<int[]>");
         const size_t size = 5;
         // 動的配列を unique_ptr で管理（配列版）
         std::unique_ptr<int[]> numbers = std::make_unique<int[]>(size);
@@ -88,6 +97,7 @@ int main() {
     // ------------------------------
     {
         std::cout << "\n-- shared_ptr / weak_ptr サンプル --\n";
+        allocationProbe probe("shared_ptr / weak_ptr");
 
         auto alice = std::make_shared<Sample>("Alice");
         auto bob   = std::make_shared<Sample>("Bob");
@@ -106,6 +116,47 @@ int main() {
         // スコープを抜けると参照カウントが 0 になり自動で delete される
     }
 
+    // ------------------------------
+    // 4. 確保回数の比較（-DALLOCATION_TRACKING で数値が出る）
+    // ------------------------------
+    {
+        std::cout << "\n-- 確保回数の比較 --\n";
+        constexpr int kObjectCount = 1000;
+        std::vector<std::shared_ptr<int>> holders;
+        holders.reserve(kObjectCount);
+
+        {
+            // shared_ptr(new T): オブジェクトと制御ブロックで2回確保する
+            allocationProbe probe("shared_ptr<int>(new int) x1000");
+            for (int i = 0; i < kObjectCount; ++i) {
+                holders.push_back(std::shared_ptr<int>(new int(i)));
+            }
+            holders.clear();
+        }
+        {
+            // make_shared: オブジェクトと制御ブロックを1回の確保にまとめる
+            allocationProbe probe("make_shared<int> x1000");
+            for (int i = 0; i < kObjectCount; ++i) {
+                holders.push_back(std::make_shared<int>(i));
+            }
+            holders.clear();
+        }
+
+        std::vector<std::string> source(kObjectCount, std::string(64, 'x'));
+        {
+            // コピー: vector の領域 + 各 string の領域を確保し直す
+            allocationProbe probe("vector<string> copy");
+            std::vector<std::string> copied = source;
+            std::cout << "コピー後の要素数: " << copied.size() << "\n";
+        }
+        {
+            // ムーブ: ポインタを付け替えるだけで、確保は発生しない
+            allocationProbe probe("vector<string> move");
+            std::vector<std::string> moved = std::move(source);
+            std::cout << "ムーブ後の要素数: " << moved.size() << "\n";
+        }
+    }
+
     std::cout << "\nプログラムが正常に終了しました。\n";
     return 0;
 }
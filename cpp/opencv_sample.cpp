@@ -5,12 +5,32 @@
  * - 空白のキャンバス作成
  * - 基本図形（円、矩形、線、テキスト）の描画
  * - 画像の保存と表示
+ * - ヘッドレス一括描画: シーンファイル（数千〜数百万の図形）をタイルに分けて cv::parallel_for_ で並列描画し PNG 保存
+ *   （--render-scene / --write-random-scene / --render-bench。使い方は opencv_sample.hpp）
+ * - パイプライン描画: 生成 → 描画 → エンコードを別スレッドにし、あらかじめ確保した cv::Mat のリングで
+ *   枠の番号だけを受け渡す（画像はコピーしない）。段ごとの遅延とフレーム/秒を同期処理と比べる（--render-pipeline）
  * 制限事項: OpenCV 4.0以降が必要
  */
 
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <vector>
 #include "opencv_sample.hpp"
 
 /**
@@ -21,21 +41,23 @@ private:
     cv::Mat canvas_;  ///< 描画用のキャンバス
     int width_;       ///< キャンバスの幅
     int height_;      ///< キャンバスの高さ
+    bool verbose_;    ///< 描画ごとにログを出すか（大量描画では false にしてログを描画ループから外す）
 
 public:
     /**
      * @brief コンストラクタ
      * @param width キャンバスの幅
      * @param height キャンバスの高さ
+     * @param verbose 描画ごとにログを出すか
      */
-    SimpleDrawing(int width = 800, int height = 600) 
-        : width_(width), height_(height) {
+    SimpleDrawing(int width = 800, int height = 600, bool verbose = true) 
+        : width_(width), height_(height), verbose_(verbose) {
         try {
             // 白いキャンバスを作成（3チャンネル、8bit、白色で初期化）
             canvas_ = cv::Mat::zeros(height_, width_, CV_8UC3);
             canvas_.setTo(cv::Scalar(255, 255, 255)); // 白色で塗りつぶし
             
-            std::cout << "キャンバス作成完了: " << width_ << "x" << height_ << std::endl;
+            if (verbose_) std::cout << "キャンバス作成完了: " << width_ << "x" << height_ << std::endl;
         }
         catch (const cv::Exception& e) {
             std::cerr << "OpenCVエラーが発生しました - クラス: SimpleDrawing, メソッド: コンストラクタ"
@@ -59,7 +81,7 @@ public:
     void drawCircle(const cv::Point& center, int radius, const cv::Scalar& color, int thickness = 2) {
         try {
             cv::circle(canvas_, center, radius, color, thickness);
-            std::cout << "円を描画しました: 中心(" << center.x << "," << center.y 
+            if (verbose_) std::cout << "円を描画しました: 中心(" << center.x << "," << center.y 
                       << "), 半径=" << radius << std::endl;
         }
         catch (const cv::Exception& e) {
@@ -80,7 +102,7 @@ public:
                       const cv::Scalar& color, int thickness = 2) {
         try {
             cv::rectangle(canvas_, topLeft, bottomRight, color, thickness);
-            std::cout << "矩形を描画しました: (" << topLeft.x << "," << topLeft.y 
+            if (verbose_) std::cout << "矩形を描画しました: (" << topLeft.x << "," << topLeft.y 
                       << ") - (" << bottomRight.x << "," << bottomRight.y << ")" << std::endl;
         }
         catch (const cv::Exception& e) {
@@ -101,7 +123,7 @@ public:
                   const cv::Scalar& color, int thickness = 2) {
         try {
             cv::line(canvas_, start, end, color, thickness);
-            std::cout << "線を描画しました: (" << start.x << "," << start.y 
+            if (verbose_) std::cout << "線を描画しました: (" << start.x << "," << start.y 
                       << ") - (" << end.x << "," << end.y << ")" << std::endl;
         }
         catch (const cv::Exception& e) {
@@ -123,7 +145,7 @@ public:
         try {
             cv::putText(canvas_, text, position, cv::FONT_HERSHEY_SIMPLEX, 
                        scale, color, 2, cv::LINE_AA);
-            std::cout << "テキストを描画しました: \"" << text << "\" at (" 
+            if (verbose_) std::cout << "テキストを描画しました: \"" << text << "\" at (" 
                       << position.x << "," << position.y << ")" << std::endl;
         }
         catch (const cv::Exception& e) {
@@ -133,6 +155,12 @@ public:
         }
     }
 
+    /**
+     * @brief キャンバスを取得する（比較・保存用）
+     * @return 描画先のキャンバス
+     */
+    const cv::Mat& canvas() const { return canvas_; }
+
     /**
      * @brief 画像を保存するメソッド
      * @param filename 保存ファイル名
@@ -172,6 +200,847 @@ public:
     }
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// ヘッドレス一括描画（タイル分割 + cv::parallel_for_）
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief シーンに含まれる図形の種類
+ */
+enum class PrimitiveType { Circle, Rectangle, Line, Text };
+
+/**
+ * @brief シーン内の図形1つ（SimpleDrawing の各描画メソッドの引数に対応）
+ */
+struct ScenePrimitive {
+    PrimitiveType type;   ///< 図形の種類
+    cv::Point p1;         ///< 円: 中心 / 矩形: 左上 / 線: 開始点 / テキスト: 位置
+    cv::Point p2;         ///< 矩形: 右下 / 線: 終了点
+    int radius;           ///< 円の半径
+    cv::Scalar color;     ///< 色（BGR形式）
+    int thickness;        ///< 線の太さ（-1で塗りつぶし）
+    double scale;         ///< テキストのスケール
+    std::string text;     ///< テキスト
+};
+
+/**
+ * @brief 描画するシーン（キャンバスの大きさと図形の並び。並び順 = 描画順）
+ */
+struct Scene {
+    int width;
+    int height;
+    std::vector<ScenePrimitive> primitives;
+};
+
+/**
+ * @brief シーンファイル（テキスト）を読み込む
+ * @details
+ * 1行1命令。'#' 以降はコメント。座標・色は整数、色は B G R の順。
+ *   canvas <幅> <高さ>
+ *   circle <cx> <cy> <半径> <B> <G> <R> <太さ>
+ *   rect   <x1> <y1> <x2> <y2> <B> <G> <R> <太さ>
+ *   line   <x1> <y1> <x2> <y2> <B> <G> <R> <太さ>
+ *   text   <x> <y> <スケール> <B> <G> <R> <文字列（行末まで）>
+ * @param path ファイルパス
+ * @return 読み込んだシーン
+ * @throws std::runtime_error 開けない、または書式が正しくない行がある場合（行番号付き）
+ */
+Scene loadScene(const std::string& path) {
+    std::ifstream input(path.c_str());
+    if (!input) {
+        throw std::runtime_error("loadScene: cannot open \"" + path + "\"");
+    }
+    Scene scene;
+    scene.width = 0;
+    scene.height = 0;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        const std::string::size_type commentPosition = line.find('#');
+        if (commentPosition != std::string::npos) {
+            line.erase(commentPosition);
+        }
+        std::istringstream fields(line);
+        std::string command;
+        if (!(fields >> command)) {
+            continue; // 空行
+        }
+        ScenePrimitive primitive;
+        primitive.radius = 0;
+        primitive.thickness = 1;
+        primitive.scale = 1.0;
+        int blue = 0, green = 0, red = 0;
+        bool isValid = false;
+        if (command == "canvas") {
+            isValid = static_cast<bool>(fields >> scene.width >> scene.height) && scene.width > 0 && scene.height > 0;
+            if (isValid) {
+                continue;
+            }
+        } else if (command == "circle") {
+            primitive.type = PrimitiveType::Circle;
+            isValid = static_cast<bool>(fields >> primitive.p1.x >> primitive.p1.y >> primitive.radius
+                                               >> blue >> green >> red >> primitive.thickness);
+        } else if (command == "rect" || command == "line") {
+            primitive.type = command == "rect" ? PrimitiveType::Rectangle : PrimitiveType::Line;
+            isValid = static_cast<bool>(fields >> primitive.p1.x >> primitive.p1.y >> primitive.p2.x >> primitive.p2.y
+                                               >> blue >> green >> red >> primitive.thickness);
+        } else if (command == "text") {
+            primitive.type = PrimitiveType::Text;
+            isValid = static_cast<bool>(fields >> primitive.p1.x >> primitive.p1.y >> primitive.scale
+                                               >> blue >> green >> red);
+            std::getline(fields >> std::ws, primitive.text);
+            isValid = isValid && !primitive.text.empty();
+        }
+        if (!isValid) {
+            std::ostringstream message;
+            message << "loadScene: invalid line " << lineNumber << " in \"" << path << "\": " << line;
+            throw std::runtime_error(message.str());
+        }
+        primitive.color = cv::Scalar(blue, green, red);
+        scene.primitives.push_back(primitive);
+    }
+    if (scene.width <= 0 || scene.height <= 0) {
+        throw std::runtime_error("loadScene: missing \"canvas <width> <height>\" in \"" + path + "\"");
+    }
+    return scene;
+}
+
+/**
+ * @brief ランダムなシーンを作る（ベンチマーク・動作確認用。seed が同じなら同じシーン）
+ * @param width キャンバスの幅
+ * @param height キャンバスの高さ
+ * @param primitiveCount 図形の数
+ * @param seed 乱数の種
+ */
+Scene makeRandomScene(int width, int height, std::size_t primitiveCount, unsigned seed) {
+    Scene scene;
+    scene.width = width;
+    scene.height = height;
+    scene.primitives.reserve(primitiveCount);
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> xDistribution(0, width - 1);
+    std::uniform_int_distribution<int> yDistribution(0, height - 1);
+    std::uniform_int_distribution<int> sizeDistribution(2, 24);
+    std::uniform_int_distribution<int> colorDistribution(0, 255);
+    std::uniform_int_distribution<int> kindDistribution(0, 99);
+    for (std::size_t i = 0; i < primitiveCount; ++i) {
+        ScenePrimitive primitive;
+        primitive.p1 = cv::Point(xDistribution(random), yDistribution(random));
+        primitive.p2 = primitive.p1 + cv::Point(sizeDistribution(random) * 2, sizeDistribution(random));
+        primitive.radius = sizeDistribution(random);
+        primitive.color = cv::Scalar(colorDistribution(random), colorDistribution(random), colorDistribution(random));
+        primitive.thickness = kindDistribution(random) < 50 ? -1 : 2;
+        primitive.scale = 0.5;
+        const int kind = kindDistribution(random);
+        // ダッシュボードのオーバーレイを想定した比率（円 40% / 矩形 30% / 線 28% / テキスト 2%）
+        if (kind < 40) {
+            primitive.type = PrimitiveType::Circle;
+        } else if (kind < 70) {
+            primitive.type = PrimitiveType::Rectangle;
+        } else if (kind < 98) {
+            primitive.type = PrimitiveType::Line;
+            primitive.thickness = 1 + kind % 3;
+        } else {
+            primitive.type = PrimitiveType::Text;
+            primitive.text = "v=" + std::to_string(static_cast<long long>(i % 1000));
+        }
+        scene.primitives.push_back(primitive);
+    }
+    return scene;
+}
+
+/**
+ * @brief シーンをテキストファイルへ書き出す（loadScene で読める形式）
+ * @throws std::runtime_error 書き込みに失敗した場合
+ */
+void saveScene(const Scene& scene, const std::string& path) {
+    std::ofstream output(path.c_str());
+    if (!output) {
+        throw std::runtime_error("saveScene: cannot open \"" + path + "\"");
+    }
+    output << "canvas " << scene.width << " " << scene.height << "\n";
+    for (std::size_t i = 0; i < scene.primitives.size(); ++i) {
+        const ScenePrimitive& primitive = scene.primitives[i];
+        const int blue = static_cast<int>(primitive.color[0]);
+        const int green = static_cast<int>(primitive.color[1]);
+        const int red = static_cast<int>(primitive.color[2]);
+        switch (primitive.type) {
+        case PrimitiveType::Circle:
+            output << "circle " << primitive.p1.x << " " << primitive.p1.y << " " << primitive.radius;
+            break;
+        case PrimitiveType::Rectangle:
+        case PrimitiveType::Line:
+            output << (primitive.type == PrimitiveType::Rectangle ? "rect " : "line ") << primitive.p1.x << " "
+                   << primitive.p1.y << " " << primitive.p2.x << " " << primitive.p2.y;
+            break;
+        case PrimitiveType::Text:
+            output << "text " << primitive.p1.x << " " << primitive.p1.y << " " << primitive.scale;
+            break;
+        }
+        output << " " << blue << " " << green << " " << red << " ";
+        if (primitive.type == PrimitiveType::Text) {
+            output << primitive.text << "\n";
+        } else {
+            output << primitive.thickness << "\n";
+        }
+    }
+    if (!output) {
+        throw std::runtime_error("saveScene: write failed \"" + path + "\"");
+    }
+}
+
+/**
+ * @brief 図形1つを描画する（offset だけずらして描く。タイルの ROI に描くときは -タイル左上 を渡す）
+ * @details SimpleDrawing の各メソッドと同じ OpenCV 関数・同じ引数で描く（ログは出さない）。
+ */
+void drawPrimitive(cv::Mat& target, const ScenePrimitive& primitive, const cv::Point& offset) {
+    switch (primitive.type) {
+    case PrimitiveType::Circle:
+        cv::circle(target, primitive.p1 + offset, primitive.radius, primitive.color, primitive.thickness);
+        break;
+    case PrimitiveType::Rectangle:
+        cv::rectangle(target, primitive.p1 + offset, primitive.p2 + offset, primitive.color, primitive.thickness);
+        break;
+    case PrimitiveType::Line:
+        cv::line(target, primitive.p1 + offset, primitive.p2 + offset, primitive.color, primitive.thickness);
+        break;
+    case PrimitiveType::Text:
+        cv::putText(target, primitive.text, primitive.p1 + offset, cv::FONT_HERSHEY_SIMPLEX, primitive.scale,
+                    primitive.color, 2, cv::LINE_AA);
+        break;
+    }
+}
+
+/**
+ * @brief 図形が塗る可能性のある範囲（線の太さ・アンチエイリアスの余白込み）
+ */
+cv::Rect primitiveBounds(const ScenePrimitive& primitive) {
+    const int margin = (primitive.thickness > 0 ? primitive.thickness / 2 : 0) + 2;
+    switch (primitive.type) {
+    case PrimitiveType::Circle: {
+        const int extent = primitive.radius + margin;
+        return cv::Rect(primitive.p1.x - extent, primitive.p1.y - extent, extent * 2 + 1, extent * 2 + 1);
+    }
+    case PrimitiveType::Rectangle:
+    case PrimitiveType::Line: {
+        const int left = std::min(primitive.p1.x, primitive.p2.x) - margin;
+        const int top = std::min(primitive.p1.y, primitive.p2.y) - margin;
+        const int right = std::max(primitive.p1.x, primitive.p2.x) + margin;
+        const int bottom = std::max(primitive.p1.y, primitive.p2.y) + margin;
+        return cv::Rect(left, top, right - left + 1, bottom - top + 1);
+    }
+    case PrimitiveType::Text: {
+        int baseline = 0;
+        const cv::Size size = cv::getTextSize(primitive.text, cv::FONT_HERSHEY_SIMPLEX, primitive.scale, 2, &baseline);
+        const int textMargin = 4;
+        return cv::Rect(primitive.p1.x - textMargin, primitive.p1.y - size.height - textMargin,
+                        size.width + textMargin * 2, size.height + baseline + textMargin * 2);
+    }
+    }
+    return cv::Rect();
+}
+
+/**
+ * @brief タイル分割した並列描画の結果
+ */
+struct TileRenderStats {
+    int tileCount;              ///< タイル数
+    std::size_t binnedCount;    ///< タイルへ振り分けた件数の合計（複数タイルにまたがる図形は重複して数える）
+    double binningMilliseconds; ///< 振り分けにかかった時間
+    double drawMilliseconds;    ///< 並列描画にかかった時間
+};
+
+/**
+ * @brief シーンをタイルに分けて並列に描画する
+ * @details
+ * - キャンバスを tileSize 四方のタイルに分け、各図形を「範囲が重なるタイル」の一覧（ビン）へ入れる。
+ *   ビンは図形の並び順を保つので、タイル内の重なり順はシーンの順と同じになる。
+ * - cv::parallel_for_ でタイルごとに、キャンバスの ROI（同じ画素を共有する部分行列）へ描く。
+ *   タイル同士は画素が重ならないので排他は不要。ROI からはみ出した部分は OpenCV が切り取る。
+ * - ログは描画ループの外（呼び出し側）で1回だけ出す。
+ * @param scene シーン
+ * @param canvas 描画先（scene の大きさ、CV_8UC3）
+ * @param tileSize タイルの一辺（画素）
+ * @return 統計
+ */
+TileRenderStats renderSceneTiled(const Scene& scene, cv::Mat& canvas, int tileSize) {
+    TileRenderStats stats;
+    const int tileColumns = (scene.width + tileSize - 1) / tileSize;
+    const int tileRows = (scene.height + tileSize - 1) / tileSize;
+    stats.tileCount = tileColumns * tileRows;
+    const cv::Rect canvasRect(0, 0, scene.width, scene.height);
+
+    // 1) 振り分け: 2パス（数える → 置く）で、タイルごとの一覧を1本の配列に詰める（確保はほぼ2回）
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<cv::Rect> tileSpans(scene.primitives.size()); // 各図形が重なるタイルの範囲（列/行の番号）
+    std::vector<int> binOffsets(stats.tileCount + 1, 0);
+    for (std::size_t i = 0; i < scene.primitives.size(); ++i) {
+        const cv::Rect bounds = primitiveBounds(scene.primitives[i]) & canvasRect;
+        if (bounds.area() == 0) {
+            continue; // キャンバス外
+        }
+        const int firstColumn = bounds.x / tileSize;
+        const int firstRow = bounds.y / tileSize;
+        const int lastColumn = (bounds.x + bounds.width - 1) / tileSize;
+        const int lastRow = (bounds.y + bounds.height - 1) / tileSize;
+        tileSpans[i] = cv::Rect(firstColumn, firstRow, lastColumn - firstColumn + 1, lastRow - firstRow + 1);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                ++binOffsets[row * tileColumns + column + 1];
+            }
+        }
+    }
+    for (int tile = 0; tile < stats.tileCount; ++tile) {
+        binOffsets[tile + 1] += binOffsets[tile];
+    }
+    stats.binnedCount = static_cast<std::size_t>(binOffsets[stats.tileCount]);
+    std::vector<int> binEntries(stats.binnedCount);
+    std::vector<int> binCursor(binOffsets.begin(), binOffsets.end() - 1);
+    for (std::size_t i = 0; i < scene.primitives.size(); ++i) {
+        const cv::Rect& span = tileSpans[i];
+        for (int row = span.y; row < span.y + span.height; ++row) {
+            for (int column = span.x; column < span.x + span.width; ++column) {
+                binEntries[binCursor[row * tileColumns + column]++] = static_cast<int>(i);
+            }
+        }
+    }
+    stats.binningMilliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // 2) 並列描画: タイル単位で ROI に描く
+    start = std::chrono::steady_clock::now();
+    cv::parallel_for_(cv::Range(0, stats.tileCount), [&](const cv::Range& range) {
+        for (int tile = range.start; tile < range.end; ++tile) {
+            const cv::Rect tileRect =
+                cv::Rect((tile % tileColumns) * tileSize, (tile / tileColumns) * tileSize, tileSize, tileSize) &
+                canvasRect;
+            cv::Mat tileCanvas = canvas(tileRect);
+            const cv::Point offset(-tileRect.x, -tileRect.y);
+            for (int entry = binOffsets[tile]; entry < binOffsets[tile + 1]; ++entry) {
+                drawPrimitive(tileCanvas, scene.primitives[binEntries[entry]], offset);
+            }
+        }
+    });
+    stats.drawMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+/**
+ * @brief シーンを1スレッドで先頭から順に描画する（比較用。SimpleDrawing をログなしで使う）
+ */
+cv::Mat renderSceneSequential(const Scene& scene) {
+    SimpleDrawing drawing(scene.width, scene.height, false);
+    for (std::size_t i = 0; i < scene.primitives.size(); ++i) {
+        const ScenePrimitive& primitive = scene.primitives[i];
+        switch (primitive.type) {
+        case PrimitiveType::Circle:
+            drawing.drawCircle(primitive.p1, primitive.radius, primitive.color, primitive.thickness);
+            break;
+        case PrimitiveType::Rectangle:
+            drawing.drawRectangle(primitive.p1, primitive.p2, primitive.color, primitive.thickness);
+            break;
+        case PrimitiveType::Line:
+            drawing.drawLine(primitive.p1, primitive.p2, primitive.color, primitive.thickness);
+            break;
+        case PrimitiveType::Text:
+            drawing.drawText(primitive.text, primitive.p1, primitive.color, primitive.scale);
+            break;
+        }
+    }
+    return drawing.canvas();
+}
+
+/**
+ * @brief 白で初期化したキャンバスを作る（SimpleDrawing と同じ初期状態）
+ */
+cv::Mat makeWhiteCanvas(int width, int height) {
+    return cv::Mat(height, width, CV_8UC3, cv::Scalar(255, 255, 255));
+}
+
+/**
+ * @brief 2枚の画像で値が異なる画素の数
+ */
+int countDifferentPixels(const cv::Mat& left, const cv::Mat& right) {
+    cv::Mat difference;
+    cv::absdiff(left, right, difference);
+    cv::Mat differenceGray;
+    cv::cvtColor(difference, differenceGray, cv::COLOR_BGR2GRAY);
+    return cv::countNonZero(differenceGray);
+}
+
+/**
+ * @brief コマンドライン引数から "--name 値" の値を探す（無ければ既定値）
+ */
+std::string findOptionValue(int argc, char** argv, const std::string& name, const std::string& defaultValue) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (name == argv[i]) {
+            return argv[i + 1];
+        }
+    }
+    return defaultValue;
+}
+
+/**
+ * @brief 正の整数オプションを読む
+ * @throws std::runtime_error 正の整数でない場合
+ */
+long long findPositiveOption(int argc, char** argv, const std::string& name, long long defaultValue) {
+    const std::string text = findOptionValue(argc, argv, name, "");
+    if (text.empty()) {
+        return defaultValue;
+    }
+    char* end = NULL;
+    const long long value = std::strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0' || value <= 0) {
+        throw std::runtime_error("findPositiveOption: invalid " + name + " \"" + text + "\"");
+    }
+    return value;
+}
+
+/**
+ * @brief 一括描画のベンチマーク（キャンバスの大きさ別に、逐次描画とタイル並列描画の図形/秒を比べる）
+ */
+void runRenderBenchmark(std::size_t primitiveCount, int tileSize) {
+    const cv::Size canvasSizes[] = {cv::Size(1280, 720), cv::Size(1920, 1080), cv::Size(3840, 2160)};
+    std::cout << "=== 一括描画ベンチマーク (図形数=" << primitiveCount << ", タイル=" << tileSize
+              << "px, スレッド数=" << cv::getNumThreads() << ") ===" << std::endl;
+    std::cout << std::left << std::setw(12) << "canvas" << std::right << std::setw(14) << "seq[ms]"
+              << std::setw(14) << "tiled[ms]" << std::setw(12) << "bin[ms]" << std::setw(16) << "seq[prim/s]"
+              << std::setw(16) << "tiled[prim/s]" << std::setw(10) << "speedup" << std::setw(12) << "diff[px]"
+              << std::endl;
+    for (std::size_t i = 0; i < sizeof(canvasSizes) / sizeof(canvasSizes[0]); ++i) {
+        const Scene scene = makeRandomScene(canvasSizes[i].width, canvasSizes[i].height, primitiveCount, 12345u);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const cv::Mat sequential = renderSceneSequential(scene);
+        const double sequentialMilliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        cv::Mat tiled = makeWhiteCanvas(scene.width, scene.height);
+        const TileRenderStats stats = renderSceneTiled(scene, tiled, tileSize);
+        const double tiledMilliseconds = stats.binningMilliseconds + stats.drawMilliseconds;
+
+        std::ostringstream sizeText;
+        sizeText << scene.width << "x" << scene.height;
+        std::cout << std::left << std::setw(12) << sizeText.str() << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << sequentialMilliseconds << std::setw(14) << tiledMilliseconds << std::setw(12)
+                  << stats.binningMilliseconds << std::setprecision(0) << std::setw(16)
+                  << primitiveCount / (sequentialMilliseconds / 1000.0) << std::setw(16)
+                  << primitiveCount / (tiledMilliseconds / 1000.0) << std::setprecision(2) << std::setw(10)
+                  << sequentialMilliseconds / tiledMilliseconds << std::setw(12)
+                  << countDifferentPixels(sequential, tiled) << std::endl;
+    }
+    std::cout << "diff[px]: 逐次描画との差がある画素数（タイル境界で線の切り取り位置が変わると、まれに数画素の差が出る）"
+              << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// パイプライン描画（生成 → 描画 → エンコードを別スレッドで流す）
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief リングバッファの1枠（あらかじめ確保した画像と、その画像が今どのフレームかの情報）
+ * @details 段の間で受け渡すのは枠の番号だけ。画像データはコピーしない（ゼロコピー）。
+ */
+struct FrameSlot {
+    cv::Mat image;                                  ///< あらかじめ確保した画像（生成段が上書きする）
+    int frameIndex;                                 ///< いま入っているフレームの番号
+    std::chrono::steady_clock::time_point startedAt; ///< 生成開始時刻（端から端までの遅延計測用）
+};
+
+/**
+ * @brief 1フレーム分の計測結果
+ */
+struct FrameTiming {
+    double generateMilliseconds; ///< 生成段の処理時間
+    double drawMilliseconds;     ///< 描画段の処理時間
+    double encodeMilliseconds;   ///< エンコード段の処理時間（ファイル書き込み込み）
+    double latencyMilliseconds;  ///< 生成開始からエンコード完了まで（待ち時間込み）
+    std::size_t encodedBytes;    ///< エンコード後の大きさ
+};
+
+/**
+ * @brief 段の間で枠の番号を渡すキュー（スレッドセーフ）
+ * @details 枠の総数はリングの大きさで決まるため、キューがあふれることはない（push は待たない）。
+ */
+class SlotQueue {
+public:
+    /** @brief 枠の番号を入れて、待っている取り出し側を1つ起こす */
+    void push(int slot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_.push_back(slot);
+        }
+        condition_.notify_one();
+    }
+
+    /**
+     * @brief 枠の番号を取り出す（空なら待つ）
+     * @return false: close() 済みで空（この段は終了してよい）
+     */
+    bool pop(int& slot) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return !slots_.empty() || isClosed_; });
+        if (slots_.empty()) {
+            return false;
+        }
+        slot = slots_.front();
+        slots_.pop_front();
+        return true;
+    }
+
+    /** @brief これ以上入れないことを知らせる（取り出し側は残りを処理してから終了する） */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isClosed_ = true;
+        }
+        condition_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<int> slots_;
+    bool isClosed_ = false;
+};
+
+/**
+ * @brief パイプラインの設定
+ */
+struct PipelineOptions {
+    int frameCount;          ///< 流すフレーム数
+    int ringSize;            ///< リングバッファの枠数（同時に流れているフレームの上限）
+    int encoderCount;        ///< エンコード段のスレッド数
+    int width;               ///< 画像の幅
+    int height;              ///< 画像の高さ
+    std::string extension;   ///< ".png" / ".jpg"
+    std::string outputDirectory; ///< 出力先（空ならエンコードのみでファイルに書かない）
+};
+
+/**
+ * @brief カメラの代わりのフレームを生成する（横方向のグラデーション + フレームごとに動く物体）
+ * @details 枠の画像へそのまま書き込む（確保しない）。
+ */
+void generateFrame(cv::Mat& image, int frameIndex) {
+    const int shift = frameIndex * 4;
+    for (int row = 0; row < image.rows; ++row) {
+        cv::Vec3b* pixels = image.ptr<cv::Vec3b>(row);
+        const uchar green = static_cast<uchar>((row * 255) / image.rows);
+        for (int column = 0; column < image.cols; ++column) {
+            const uchar blue = static_cast<uchar>((column + shift) & 0xFF);
+            pixels[column] = cv::Vec3b(blue, green, 96);
+        }
+    }
+    const cv::Point objectCenter((frameIndex * 7) % image.cols, image.rows / 2);
+    cv::circle(image, objectCenter, image.rows / 10, cv::Scalar(40, 40, 40), -1);
+}
+
+/**
+ * @brief 生成したフレームに注釈（検出枠・照準・フレーム番号）を描く
+ */
+void annotateFrame(cv::Mat& image, int frameIndex) {
+    const int radius = image.rows / 10;
+    const cv::Point objectCenter((frameIndex * 7) % image.cols, image.rows / 2);
+    cv::rectangle(image, objectCenter + cv::Point(-radius - 4, -radius - 4), objectCenter + cv::Point(radius + 4, radius + 4),
+                  cv::Scalar(0, 255, 0), 2);
+    cv::line(image, cv::Point(image.cols / 2 - 20, image.rows / 2), cv::Point(image.cols / 2 + 20, image.rows / 2),
+             cv::Scalar(0, 0, 255), 2);
+    cv::line(image, cv::Point(image.cols / 2, image.rows / 2 - 20), cv::Point(image.cols / 2, image.rows / 2 + 20),
+             cv::Scalar(0, 0, 255), 2);
+    std::ostringstream label;
+    label << "frame " << frameIndex;
+    cv::putText(image, label.str(), cv::Point(16, 40), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(255, 255, 255), 2,
+                cv::LINE_AA);
+}
+
+/**
+ * @brief 画像をエンコードし、出力先があればファイルへ書く
+ * @param encoded エンコード結果の置き場（スレッドごとに使い回し、確保を減らす）
+ * @return エンコード後の大きさ
+ * @throws std::runtime_error エンコード・書き込みに失敗した場合
+ */
+std::size_t encodeFrame(const cv::Mat& image, int frameIndex, const PipelineOptions& options,
+                        std::vector<uchar>& encoded) {
+    if (!cv::imencode(options.extension, image, encoded)) {
+        throw std::runtime_error("encodeFrame: imencode failed (" + options.extension + ")");
+    }
+    if (!options.outputDirectory.empty()) {
+        std::ostringstream path;
+        path << options.outputDirectory << "/frame_" << std::setw(6) << std::setfill('0') << frameIndex
+             << options.extension;
+        std::ofstream output(path.str().c_str(), std::ios::binary);
+        output.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+        if (!output) {
+            throw std::runtime_error("encodeFrame: write failed \"" + path.str() + "\"");
+        }
+    }
+    return encoded.size();
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 比較用: 1スレッドで「生成 → 描画 → エンコード」をフレームごとに順に行う（runOpenCvSample と同じ流れ）
+ * @return 全体の時間（ミリ秒）
+ */
+double runFramesSynchronously(const PipelineOptions& options, std::vector<FrameTiming>& timings) {
+    cv::Mat image(options.height, options.width, CV_8UC3);
+    std::vector<uchar> encoded;
+    const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frameCount; ++frame) {
+        FrameTiming& timing = timings[frame];
+        const std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+        generateFrame(image, frame);
+        timing.generateMilliseconds = millisecondsSince(frameStart);
+        std::chrono::steady_clock::time_point stageStart = std::chrono::steady_clock::now();
+        annotateFrame(image, frame);
+        timing.drawMilliseconds = millisecondsSince(stageStart);
+        stageStart = std::chrono::steady_clock::now();
+        timing.encodedBytes = encodeFrame(image, frame, options, encoded);
+        timing.encodeMilliseconds = millisecondsSince(stageStart);
+        timing.latencyMilliseconds = millisecondsSince(frameStart);
+    }
+    return millisecondsSince(totalStart);
+}
+
+/**
+ * @brief パイプラインで流す
+ * @details
+ * - 枠の流れ: 空き → 生成段 → 描画段 → エンコード段（encoderCount スレッド）→ 空き
+ * - 各段は枠の番号だけを次のキューへ渡す。画像はリングの枠に置いたまま（コピーしない）。
+ * - 枠が全部使用中なら生成段は空きを待つ（= 遅い段に合わせて自然に流量が絞られる）。
+ * - どこかの段で例外が起きたら全キューを閉じて全スレッドを止め、呼び出し元で再送出する。
+ * @return 全体の時間（ミリ秒）
+ */
+double runFramesPipelined(const PipelineOptions& options, std::vector<FrameTiming>& timings) {
+    std::vector<FrameSlot> ring(options.ringSize);
+    SlotQueue freeSlots;
+    SlotQueue generatedSlots;
+    SlotQueue drawnSlots;
+    for (int slot = 0; slot < options.ringSize; ++slot) {
+        ring[slot].image.create(options.height, options.width, CV_8UC3); // ここで1回だけ確保
+        ring[slot].frameIndex = -1;
+        freeSlots.push(slot);
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+    std::atomic<bool> isFailed(false);
+    // 例外を記録し、全キューを閉じて他の段を止める
+    std::function<void()> recordError = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+        isFailed = true;
+        freeSlots.close();
+        generatedSlots.close();
+        drawnSlots.close();
+    };
+
+    const std::chrono::steady_clock::time_point totalStart = std::chrono::steady_clock::now();
+
+    std::thread generator([&]() {
+        try {
+            for (int frame = 0; frame < options.frameCount && !isFailed; ++frame) {
+                int slot = 0;
+                if (!freeSlots.pop(slot)) {
+                    break;
+                }
+                FrameSlot& target = ring[slot];
+                target.frameIndex = frame;
+                target.startedAt = std::chrono::steady_clock::now();
+                generateFrame(target.image, frame);
+                timings[frame].generateMilliseconds = millisecondsSince(target.startedAt);
+                generatedSlots.push(slot);
+            }
+            generatedSlots.close();
+        } catch (...) {
+            recordError();
+        }
+    });
+
+    std::thread drawer([&]() {
+        try {
+            int slot = 0;
+            while (generatedSlots.pop(slot)) {
+                FrameSlot& target = ring[slot];
+                const std::chrono::steady_clock::time_point stageStart = std::chrono::steady_clock::now();
+                annotateFrame(target.image, target.frameIndex);
+                timings[target.frameIndex].drawMilliseconds = millisecondsSince(stageStart);
+                drawnSlots.push(slot);
+            }
+            drawnSlots.close();
+        } catch (...) {
+            recordError();
+        }
+    });
+
+    std::vector<std::thread> encoders;
+    for (int encoder = 0; encoder < options.encoderCount; ++encoder) {
+        encoders.push_back(std::thread([&]() {
+            try {
+                std::vector<uchar> encoded;
+                int slot = 0;
+                while (drawnSlots.pop(slot)) {
+                    FrameSlot& target = ring[slot];
+                    FrameTiming& timing = timings[target.frameIndex];
+                    const std::chrono::steady_clock::time_point stageStart = std::chrono::steady_clock::now();
+                    timing.encodedBytes = encodeFrame(target.image, target.frameIndex, options, encoded);
+                    timing.encodeMilliseconds = millisecondsSince(stageStart);
+                    timing.latencyMilliseconds = millisecondsSince(target.startedAt);
+                    freeSlots.push(slot);
+                }
+            } catch (...) {
+                recordError();
+            }
+        }));
+    }
+
+    generator.join();
+    drawer.join();
+    for (std::size_t i = 0; i < encoders.size(); ++i) {
+        encoders[i].join();
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+    return millisecondsSince(totalStart);
+}
+
+/**
+ * @brief 段ごとの中央値/p95 と、全体のフレーム/秒を表示する
+ */
+void printPipelineReport(const std::string& modeName, const std::vector<FrameTiming>& timings, double totalMilliseconds) {
+    struct StageColumn {
+        const char* name;
+        double FrameTiming::*field;
+    };
+    const StageColumn columns[] = {{"generate", &FrameTiming::generateMilliseconds},
+                                   {"draw", &FrameTiming::drawMilliseconds},
+                                   {"encode", &FrameTiming::encodeMilliseconds},
+                                   {"end-to-end", &FrameTiming::latencyMilliseconds}};
+    std::size_t encodedBytes = 0;
+    for (std::size_t i = 0; i < timings.size(); ++i) {
+        encodedBytes += timings[i].encodedBytes;
+    }
+    std::cout << "[" << modeName << "] " << timings.size() << " フレーム, " << std::fixed << std::setprecision(1)
+              << totalMilliseconds << " ms, " << timings.size() / (totalMilliseconds / 1000.0) << " フレーム/秒, 平均 "
+              << encodedBytes / timings.size() / 1024 << " KiB/フレーム" << std::endl;
+    std::vector<double> values(timings.size());
+    for (std::size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); ++c) {
+        for (std::size_t i = 0; i < timings.size(); ++i) {
+            values[i] = timings[i].*(columns[c].field);
+        }
+        std::sort(values.begin(), values.end());
+        std::cout << "  " << std::left << std::setw(12) << columns[c].name << std::right << "中央値 " << std::setw(8)
+                  << values[values.size() / 2] << " ms   p95 " << std::setw(8)
+                  << values[std::min(values.size() - 1, values.size() * 95 / 100)] << " ms" << std::endl;
+    }
+}
+
+/**
+ * @brief 同期処理とパイプライン処理を同じ設定で実行して比べる
+ */
+void runFramePipelineComparison(const PipelineOptions& options) {
+    std::cout << "=== フレームパイプライン (" << options.width << "x" << options.height << ", " << options.frameCount
+              << " フレーム, リング " << options.ringSize << " 枠, エンコード " << options.encoderCount << " スレッド, "
+              << options.extension << (options.outputDirectory.empty() ? ", 保存なし" : ", 保存先 " + options.outputDirectory)
+              << ") ===" << std::endl;
+    std::vector<FrameTiming> synchronousTimings(options.frameCount);
+    const double synchronousMilliseconds = runFramesSynchronously(options, synchronousTimings);
+    printPipelineReport("synchronous", synchronousTimings, synchronousMilliseconds);
+
+    std::vector<FrameTiming> pipelinedTimings(options.frameCount);
+    const double pipelinedMilliseconds = runFramesPipelined(options, pipelinedTimings);
+    printPipelineReport("pipelined", pipelinedTimings, pipelinedMilliseconds);
+    std::cout << "速度比 (synchronous / pipelined): " << std::setprecision(2)
+              << synchronousMilliseconds / pipelinedMilliseconds << std::endl;
+}
+
+bool isOpenCvBatchCommand(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument == "--render-scene" || argument == "--render-bench" || argument == "--write-random-scene" ||
+            argument == "--render-pipeline") {
+            return true;
+        }
+    }
+    return false;
+}
+
+int runOpenCvBatchCommand(int argc, char** argv) {
+    try {
+        const int tileSize = static_cast<int>(findPositiveOption(argc, argv, "--tile", 256));
+        const std::size_t primitiveCount = static_cast<std::size_t>(findPositiveOption(argc, argv, "--primitives", 200000));
+
+        bool isPipeline = false;
+        for (int i = 1; i < argc; ++i) {
+            isPipeline = isPipeline || std::string(argv[i]) == "--render-pipeline";
+        }
+        if (isPipeline) {
+            PipelineOptions options;
+            options.frameCount = static_cast<int>(findPositiveOption(argc, argv, "--frames", 120));
+            options.ringSize = static_cast<int>(findPositiveOption(argc, argv, "--ring", 4));
+            options.encoderCount = static_cast<int>(findPositiveOption(argc, argv, "--encoders", 2));
+            options.width = static_cast<int>(findPositiveOption(argc, argv, "--width", 1280));
+            options.height = static_cast<int>(findPositiveOption(argc, argv, "--height", 720));
+            const std::string format = findOptionValue(argc, argv, "--format", "jpg");
+            if (format != "png" && format != "jpg") {
+                throw std::runtime_error("runOpenCvBatchCommand: --format must be png or jpg: \"" + format + "\"");
+            }
+            options.extension = "." + format;
+            options.outputDirectory = findOptionValue(argc, argv, "--output-dir", "");
+            runFramePipelineComparison(options);
+            return 0;
+        }
+
+        const std::string randomScenePath = findOptionValue(argc, argv, "--write-random-scene", "");
+        if (!randomScenePath.empty()) {
+            const int width = static_cast<int>(findPositiveOption(argc, argv, "--width", 1920));
+            const int height = static_cast<int>(findPositiveOption(argc, argv, "--height", 1080));
+            saveScene(makeRandomScene(width, height, primitiveCount, 12345u), randomScenePath);
+            std::cout << "シーンを書き出しました: " << randomScenePath << " (" << primitiveCount << " 図形)" << std::endl;
+            return 0;
+        }
+
+        const std::string scenePath = findOptionValue(argc, argv, "--render-scene", "");
+        if (!scenePath.empty()) {
+            const std::string outputPath = findOptionValue(argc, argv, "--output", "scene.png");
+            const Scene scene = loadScene(scenePath);
+            cv::Mat canvas = makeWhiteCanvas(scene.width, scene.height);
+            const TileRenderStats stats = renderSceneTiled(scene, canvas, tileSize);
+            if (!cv::imwrite(outputPath, canvas)) {
+                throw std::runtime_error("runOpenCvBatchCommand: imwrite failed \"" + outputPath + "\"");
+            }
+            const double totalMilliseconds = stats.binningMilliseconds + stats.drawMilliseconds;
+            std::cout << std::fixed << std::setprecision(1) << "描画完了: " << scene.primitives.size() << " 図形, " << scene.width << "x" << scene.height
+                      << ", タイル " << stats.tileCount << " 枚, 振り分け " << stats.binningMilliseconds
+                      << " ms, 描画 " << stats.drawMilliseconds << " ms ("
+                      << static_cast<long long>(scene.primitives.size() / (totalMilliseconds / 1000.0))
+                      << " 図形/秒) -> " << outputPath << std::endl;
+            return 0;
+        }
+
+        runRenderBenchmark(primitiveCount, tileSize);
+        return 0;
+    }
+    catch (const cv::Exception& e) {
+        std::cerr << "OpenCVエラーが発生しました - メソッド: runOpenCvBatchCommand, エラー: " << e.what() << std::endl;
+        return 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "エラーが発生しました - メソッド: runOpenCvBatchCommand, エラー: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
 /**
  * @brief メイン関数
  * @return プログラムの終了ステータス
@@ -8,3 +8,18 @@
 // OpenCV サンプルを実行する関数
 // 戻り値: なし
 void runOpenCvSample();
+
+// ヘッドレス一括描画（表示なし・PNG 出力）のコマンドかどうか
+// 戻り値: --render-scene / --render-bench / --write-random-scene / --render-pipeline のいずれかがあれば true
+bool isOpenCvBatchCommand(int argc, char** argv);
+
+// ヘッドレス一括描画を実行する（hello_world の main から、通常のデモの代わりに呼ぶ）
+//   --render-scene <scene.txt> [--output out.png] [--tile 256]   シーンをタイル並列で描画して PNG 保存
+//   --write-random-scene <scene.txt> [--primitives N] [--width W] [--height H]   ランダムなシーンを書き出す
+//   --render-bench [--primitives N] [--tile 256]   キャンバスの大きさ別に図形/秒を計測（逐次描画と比較）
+//   --render-pipeline [--frames 120] [--ring 4] [--encoders 2] [--width 1280] [--height 720]
+//                     [--format jpg|png] [--output-dir dir]
+//       生成 → 描画 → エンコードのパイプライン（リングの cv::Mat をコピーせず受け渡す）。段ごとの遅延と
+//       フレーム/秒を、1スレッドの同期処理と比べて表示（--output-dir を付けると frame_000000.jpg ... を保存）
+// 戻り値: 0=成功 / 1=失敗（エラー内容は std::cerr）
+int runOpenCvBatchCommand(int argc, char** argv);
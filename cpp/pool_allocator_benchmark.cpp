@@ -0,0 +1,381 @@
+/**
+ * @file pool_allocator_benchmark.cpp
+ * @brief shared_ptr の Node リストを「make_shared / プール / アリーナ」で作って壊す速さとメモリの比較
+ *
+ * 概要:
+ *   - hello_world.cpp の demonstrateSmartPointers() と同じ形の Node（next: shared_ptr / prev: weak_ptr）で
+ *     数百万要素の双方向リストを作り、たどり、壊す。
+ *   - 確保方式（pool_allocators.hpp と標準の std::pmr）を差し替えて、次を表示する:
+ *       構築/走査/破棄の時間、上流（グローバル operator new）の確保回数、構築後の RSS 増加量
+ *   - 最後にプロセス全体のピーク RSS を表示する（方式ごとのピークは --only で1方式ずつ測る）。
+ * 主な仕様:
+ *   - 方式: make_shared / FixedSizePool(pmr) / MonotonicArena(pmr) / ArenaAllocator /
+ *           std::pmr::unsynchronized_pool_resource / std::pmr::monotonic_buffer_resource
+ *   - allocate_shared を使うと、制御ブロックと Node が1回の確保にまとまり、その確保がアロケータへ流れる。
+ *   - 破棄はループで行う（先頭から順に next を外す）。再帰的な破棄だと数百万要素でスタックがあふれるため。
+ * 制限事項:
+ *   - C++17 以降（std::pmr）
+ *   - RSS は Linux（/proc, getrusage）と Windows（GetProcessMemoryInfo）のみ。その他は「-」表示
+ *   - 構築後の RSS 増加量は、前の方式で解放したメモリを malloc が再利用すると小さく出る（正確には --only で比べる）
+ *   - グローバル operator new を置き換えて数えるため、このプログラム全体の確保が数えられる
+ *
+ * 使い方:
+ *   pool_allocator_benchmark.exe                          ... 既定（200万要素）で全方式
+ *   pool_allocator_benchmark.exe --count 5000000
+ *   pool_allocator_benchmark.exe --only arena-allocator    ... 1方式だけ（ピーク RSS を方式ごとに比べる用）
+ *
+ * コンパイル例 (MSVC x64):
+ *   cl /utf-8 /EHsc /std:c++17 /O2 pool_allocator_benchmark.cpp /Fe:pool_allocator_benchmark.exe psapi.lib
+ * コンパイル例 (GCC/Clang):
+ *   g++ -std=c++17 -O2 pool_allocator_benchmark.cpp -o pool_allocator_benchmark
+ */
+
+#include "pool_allocators.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// =============================================
+// 確保回数の計測（グローバル operator new の置き換え）
+// =============================================
+namespace allocationCounter {
+std::atomic<std::uint64_t> allocationCount{0};
+}
+
+// GCC 12 以降は「operator new の戻り値を free している」と誤検出することがあるため抑止する（new/delete とも malloc/free で対）。
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    allocationCounter::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+// std::pmr::new_delete_resource は境界指定つきの operator new を呼ぶ実装があるため、こちらも数える。
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocationCounter::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t alignmentBytes = static_cast<std::size_t>(alignment);
+#if defined(_WIN32)
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, alignmentBytes);
+#else
+    // aligned_alloc は「大きさが境界の倍数」であることを求めるため切り上げる
+    void* memory = std::aligned_alloc(alignmentBytes, (size + alignmentBytes) / alignmentBytes * alignmentBytes);
+#endif
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+#if defined(_WIN32)
+void operator delete(void* memory, std::align_val_t) noexcept { _aligned_free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { _aligned_free(memory); }
+#else
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+#endif
+
+namespace {
+
+/** @brief 既定の要素数。 */
+constexpr std::size_t kDefaultNodeCount = 2000000;
+
+/**
+ * @struct Node
+ * @brief hello_world.cpp と同じ形の双方向リストのノード（name の代わりに value を持つ）。
+ */
+struct Node {
+    int value = 0;
+    std::shared_ptr<Node> next; ///< 次のノード（所有する）
+    std::weak_ptr<Node> prev;   ///< 前のノード（循環参照を避けるため weak_ptr）
+
+    explicit Node(int initialValue) : value(initialValue) {}
+};
+
+/**
+ * @brief 方式ごとの計測結果。
+ */
+struct StrategyResult {
+    std::string name;
+    double buildMilliseconds = 0.0;
+    double walkMilliseconds = 0.0;
+    double teardownMilliseconds = 0.0;
+    std::uint64_t upstreamAllocations = 0; ///< 構築中のグローバル operator new の回数
+    long long rssGrowthBytes = -1;         ///< 構築後の RSS 増加量（取れない環境では -1）
+    long long checksum = 0;
+};
+
+/**
+ * @brief 現在の RSS（常駐メモリ量）をバイトで返す。取れない環境では -1。
+ */
+long long readCurrentRssBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long long>(counters.WorkingSetSize);
+    }
+    return -1;
+#elif defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return -1;
+    }
+    long long totalPages = 0;
+    long long residentPages = 0;
+    const int readCount = std::fscanf(file, "%lld %lld", &totalPages, &residentPages);
+    std::fclose(file);
+    if (readCount != 2) {
+        return -1;
+    }
+    return residentPages * static_cast<long long>(sysconf(_SC_PAGESIZE));
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief プロセス開始からのピーク RSS をバイトで返す。取れない環境では -1。
+ */
+long long readPeakRssBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long long>(counters.PeakWorkingSetSize);
+    }
+    return -1;
+#elif defined(__linux__)
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return static_cast<long long>(usage.ru_maxrss) * 1024; // Linux では KiB 単位
+#else
+    return -1;
+#endif
+}
+
+double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief makeNode で nodeCount 個のノードを作って双方向リストにし、たどって、壊す。
+ * @param name 方式名
+ * @param nodeCount ノード数
+ * @param makeNode int 値から shared_ptr<Node> を作る関数
+ * @param releaseAll 破棄の最後に呼ぶ後始末（アリーナ/プールのまとめて解放。不要なら空）
+ */
+template <class MakeNode>
+StrategyResult runStrategy(const std::string& name, std::size_t nodeCount, MakeNode makeNode,
+                           const std::function<void()>& releaseAll) {
+    StrategyResult result;
+    result.name = name;
+
+    const long long rssBefore = readCurrentRssBytes();
+    const std::uint64_t allocationsBefore = allocationCounter::allocationCount.load(std::memory_order_relaxed);
+
+    // 構築: 先頭に足していく（head->prev を新しいノードへ向ける）
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<Node> head;
+    for (std::size_t i = nodeCount; i > 0; --i) {
+        std::shared_ptr<Node> node = makeNode(static_cast<int>(i - 1));
+        if (head) {
+            head->prev = node;
+        }
+        node->next = std::move(head);
+        head = std::move(node);
+    }
+    result.buildMilliseconds = elapsedMilliseconds(start);
+    result.upstreamAllocations = allocationCounter::allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+    const long long rssAfter = readCurrentRssBytes();
+    if (rssBefore >= 0 && rssAfter >= 0) {
+        result.rssGrowthBytes = rssAfter - rssBefore;
+    }
+
+    // 走査: next をたどって合計する（ノードがメモリ上で近いほど速い）
+    start = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    for (const Node* node = head.get(); node != nullptr; node = node->next.get()) {
+        checksum += node->value;
+    }
+    result.walkMilliseconds = elapsedMilliseconds(start);
+    result.checksum = checksum;
+
+    // 破棄: 先頭から順に外す（head.reset() 1回で任せると、デストラクタが nodeCount 段の再帰になる）
+    start = std::chrono::steady_clock::now();
+    while (head) {
+        std::shared_ptr<Node> next = std::move(head->next);
+        head = std::move(next);
+    }
+    if (releaseAll) {
+        releaseAll();
+    }
+    result.teardownMilliseconds = elapsedMilliseconds(start);
+    return result;
+}
+
+/**
+ * @brief 方式名を受け取り、その方式を1回実行する。
+ * @throws std::runtime_error 不明な方式名
+ */
+StrategyResult runNamedStrategy(const std::string& name, std::size_t nodeCount) {
+    if (name == "make_shared") {
+        return runStrategy(name, nodeCount, [](int value) { return std::make_shared<Node>(value); }, nullptr);
+    }
+    if (name == "pool") {
+        PoolMemoryResource pool;
+        std::pmr::polymorphic_allocator<Node> allocator(&pool);
+        return runStrategy(name, nodeCount,
+                           [&allocator](int value) { return std::allocate_shared<Node>(allocator, value); }, nullptr);
+    }
+    if (name == "arena") {
+        MonotonicArena arena;
+        ArenaMemoryResource resource(arena);
+        std::pmr::polymorphic_allocator<Node> allocator(&resource);
+        return runStrategy(name, nodeCount,
+                           [&allocator](int value) { return std::allocate_shared<Node>(allocator, value); },
+                           [&arena]() { arena.release(); });
+    }
+    if (name == "arena-allocator") {
+        MonotonicArena arena;
+        ArenaAllocator<Node> allocator(arena);
+        return runStrategy(name, nodeCount,
+                           [&allocator](int value) { return std::allocate_shared<Node>(allocator, value); },
+                           [&arena]() { arena.release(); });
+    }
+    if (name == "std-pool") {
+        std::pmr::unsynchronized_pool_resource pool;
+        std::pmr::polymorphic_allocator<Node> allocator(&pool);
+        return runStrategy(name, nodeCount,
+                           [&allocator](int value) { return std::allocate_shared<Node>(allocator, value); },
+                           [&pool]() { pool.release(); });
+    }
+    if (name == "std-monotonic") {
+        std::pmr::monotonic_buffer_resource buffer;
+        std::pmr::polymorphic_allocator<Node> allocator(&buffer);
+        return runStrategy(name, nodeCount,
+                           [&allocator](int value) { return std::allocate_shared<Node>(allocator, value); },
+                           [&buffer]() { buffer.release(); });
+    }
+    throw std::runtime_error("runNamedStrategy: unknown strategy \"" + name + "\"");
+}
+
+std::string formatBytes(long long bytes) {
+    if (bytes < 0) {
+        return "-";
+    }
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MiB";
+    return stream.str();
+}
+
+/**
+ * @brief 整数オプション（--count）を読む。
+ * @throws std::runtime_error 値が正の整数でない場合
+ */
+std::size_t parsePositiveOption(int argc, char** argv, const std::string& name, std::size_t defaultValue) {
+    for (int i = 1; i < argc; ++i) {
+        if (name != argv[i]) {
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("parsePositiveOption: missing value for " + name);
+        }
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(argv[i + 1], &end, 10);
+        if (end == argv[i + 1] || *end != '\0' || value == 0 || value > 0x7fffffffULL) {
+            throw std::runtime_error("parsePositiveOption: invalid " + name + " \"" + argv[i + 1] + "\"");
+        }
+        return static_cast<std::size_t>(value);
+    }
+    return defaultValue;
+}
+
+/**
+ * @brief 文字列オプション（--only）を読む。無ければ空文字列。
+ */
+std::string parseStringOption(int argc, char** argv, const std::string& name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (name == argv[i]) {
+            return argv[i + 1];
+        }
+    }
+    return std::string();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const std::size_t nodeCount = parsePositiveOption(argc, argv, "--count", kDefaultNodeCount);
+        const std::string onlyStrategy = parseStringOption(argc, argv, "--only");
+
+        std::vector<std::string> strategyNames = {"make_shared", "pool", "arena", "arena-allocator",
+                                                  "std-pool", "std-monotonic"};
+        if (!onlyStrategy.empty()) {
+            if (std::find(strategyNames.begin(), strategyNames.end(), onlyStrategy) == strategyNames.end()) {
+                throw std::runtime_error("main: unknown --only \"" + onlyStrategy + "\"");
+            }
+            strategyNames = {onlyStrategy};
+        }
+
+        std::cout << "=== Node リストの構築/走査/破棄 (ノード数=" << nodeCount << ", sizeof(Node)=" << sizeof(Node)
+                  << ") ===\n";
+#if !defined(__OPTIMIZE__) && (defined(__GNUC__) || defined(__clang__))
+        std::cout << "[注意] 最適化なしのビルドです。-O2 を付けて計測してください。\n";
+#endif
+        // 見出しは幅をそろえるため英字（build=構築, walk=走査, teardown=破棄, upstream=上流確保回数, rss=構築後の RSS 増加）
+        std::cout << std::left << std::setw(18) << "strategy" << std::right << std::setw(12) << "build[ms]"
+                  << std::setw(12) << "walk[ms]" << std::setw(14) << "teardown[ms]" << std::setw(12) << "upstream"
+                  << std::setw(14) << "rss" << "\n";
+
+        long long expectedChecksum = -1;
+        for (const std::string& name : strategyNames) {
+            const StrategyResult result = runNamedStrategy(name, nodeCount);
+            if (expectedChecksum < 0) {
+                expectedChecksum = result.checksum;
+            } else if (result.checksum != expectedChecksum) {
+                throw std::runtime_error("main: checksum mismatch at strategy \"" + name + "\"");
+            }
+            std::cout << std::left << std::setw(18) << result.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << result.buildMilliseconds << std::setw(12) << result.walkMilliseconds
+                      << std::setw(14) << result.teardownMilliseconds << std::setw(12) << result.upstreamAllocations
+                      << std::setw(14) << formatBytes(result.rssGrowthBytes) << "\n";
+        }
+        std::cout << "プロセスのピーク RSS: " << formatBytes(readPeakRssBytes()) << "\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "[error] function=main(file=pool_allocator_benchmark.cpp) message=\"" << ex.what() << "\"\n";
+        return 1;
+    }
+}
@@ -0,0 +1,319 @@
+/**
+ * @file pool_allocators.hpp
+ * @brief 固定サイズプール・モノトニックアリーナと、std::pmr::memory_resource アダプタ（ヘッダーのみ）
+ * @details
+ * 概要:
+ *   - FixedSizePool      : 同じ大きさのブロックだけを扱うプール。空きブロックを単方向リスト（free list）でつなぐ。
+ *   - MonotonicArena     : ポインタを進めるだけで確保するアリーナ。個別解放はせず、最後にまとめて解放する。
+ *   - PoolMemoryResource : 大きさ別の FixedSizePool を束ねた std::pmr::memory_resource（大きいものは上流へ）
+ *   - ArenaMemoryResource: MonotonicArena を std::pmr::memory_resource として使うアダプタ
+ *   - ArenaAllocator<T>  : MonotonicArena を直接使う型付きアロケータ（仮想呼び出しなし）
+ * 使い方（Node リストを allocate_shared で作る例）:
+ *   PoolMemoryResource pool;
+ *   auto node = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>(&pool), ...);
+ * 制限事項:
+ *   - C++17 以降（std::pmr を使うため）
+ *   - スレッドセーフではない（1スレッドで使う、または呼び出し側で排他する）
+ *   - プール/アリーナは、そこから確保したオブジェクトより長く生きていなければならない
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 固定サイズのブロックを高速に確保/解放するプール。
+ * @details
+ * - 上流から「チャンク」（ブロック blocksPerChunk 個分）をまとめて確保し、ブロック単位で貸し出す。
+ * - 解放されたブロックは free list の先頭に戻す（次の確保で再利用。キャッシュにも載っていることが多い）。
+ * - 確保/解放ともにポインタの付け替えだけ（O(1)）。チャンクはプールの破棄時にまとめて返す。
+ */
+class FixedSizePool {
+public:
+    /**
+     * @param blockSize 1ブロックの大きさ（ポインタ1個分より小さい場合は切り上げる）
+     * @param blockAlignment ブロックの境界（2の冪）
+     * @param blocksPerChunk 1チャンクに入れるブロック数
+     * @param upstream チャンクを確保する上流（既定: new/delete）
+     */
+    explicit FixedSizePool(std::size_t blockSize, std::size_t blockAlignment = alignof(std::max_align_t),
+                           std::size_t blocksPerChunk = 4096,
+                           std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : blockAlignment_(std::max(blockAlignment, alignof(FreeBlock))),
+          blockSize_(roundUp(std::max(blockSize, sizeof(FreeBlock)), blockAlignment_)),
+          blocksPerChunk_(blocksPerChunk == 0 ? 1 : blocksPerChunk),
+          upstream_(upstream) {}
+
+    FixedSizePool(const FixedSizePool&) = delete;
+    FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+    ~FixedSizePool() { release(); }
+
+    /** @brief ブロックを1個確保する（足りなければチャンクを追加）。 */
+    void* allocate() {
+        if (freeList_ == nullptr) {
+            addChunk();
+        }
+        FreeBlock* block = freeList_;
+        freeList_ = block->next;
+        ++liveBlockCount_;
+        peakLiveBlockCount_ = std::max(peakLiveBlockCount_, liveBlockCount_);
+        return block;
+    }
+
+    /** @brief ブロックを返す（このプールから確保したものに限る）。 */
+    void deallocate(void* pointer) noexcept {
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = freeList_;
+        freeList_ = block;
+        --liveBlockCount_;
+    }
+
+    /** @brief 全チャンクを上流へ返す（貸し出し中のブロックも無効になる）。 */
+    void release() noexcept {
+        for (void* chunk : chunks_) {
+            upstream_->deallocate(chunk, blockSize_ * blocksPerChunk_, blockAlignment_);
+        }
+        chunks_.clear();
+        freeList_ = nullptr;
+        liveBlockCount_ = 0;
+    }
+
+    std::size_t blockSize() const noexcept { return blockSize_; }
+    std::size_t chunkCount() const noexcept { return chunks_.size(); }
+    std::size_t liveBlockCount() const noexcept { return liveBlockCount_; }
+    std::size_t peakLiveBlockCount() const noexcept { return peakLiveBlockCount_; }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static std::size_t roundUp(std::size_t value, std::size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void addChunk() {
+        auto* chunk = static_cast<unsigned char*>(upstream_->allocate(blockSize_ * blocksPerChunk_, blockAlignment_));
+        chunks_.push_back(chunk);
+        // チャンク内のブロックを先頭から順に free list へつなぐ（順に使うほうがキャッシュに優しい）
+        for (std::size_t i = blocksPerChunk_; i > 0; --i) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * blockSize_);
+            block->next = freeList_;
+            freeList_ = block;
+        }
+    }
+
+    std::size_t blockAlignment_;
+    std::size_t blockSize_;
+    std::size_t blocksPerChunk_;
+    std::pmr::memory_resource* upstream_;
+    FreeBlock* freeList_ = nullptr;
+    std::vector<void*> chunks_;
+    std::size_t liveBlockCount_ = 0;
+    std::size_t peakLiveBlockCount_ = 0;
+};
+
+/**
+ * @brief ポインタを進めるだけで確保するアリーナ（モノトニック = 増える一方）。
+ * @details
+ * - 確保は「境界合わせ + ポインタ加算」だけ。個別の解放は何もしない。
+ * - 領域が足りなくなると、前回の2倍（上限 maxChunkBytes）のチャンクを上流から確保する。
+ * - release() で全チャンクをまとめて返す。多数の小さなオブジェクトを「まとめて作ってまとめて捨てる」用途向け。
+ */
+class MonotonicArena {
+public:
+    /**
+     * @param initialChunkBytes 最初のチャンクの大きさ
+     * @param upstream チャンクを確保する上流（既定: new/delete）
+     */
+    explicit MonotonicArena(std::size_t initialChunkBytes = 64 * 1024,
+                            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : nextChunkBytes_(std::max<std::size_t>(initialChunkBytes, 256)), upstream_(upstream) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() { release(); }
+
+    /** @brief bytes バイトを alignment 境界で確保する。 */
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        std::size_t space = static_cast<std::size_t>(end_ - cursor_);
+        void* pointer = cursor_;
+        if (cursor_ == nullptr || std::align(alignment, bytes, pointer, space) == nullptr) {
+            addChunk(bytes + alignment);
+            space = static_cast<std::size_t>(end_ - cursor_);
+            pointer = cursor_;
+            std::align(alignment, bytes, pointer, space);
+        }
+        cursor_ = static_cast<unsigned char*>(pointer) + bytes;
+        usedBytes_ += bytes;
+        return pointer;
+    }
+
+    /** @brief 個別解放は何もしない（release() でまとめて返す）。 */
+    void deallocate(void*, std::size_t) noexcept {}
+
+    /** @brief 全チャンクを上流へ返す。 */
+    void release() noexcept {
+        for (const Chunk& chunk : chunks_) {
+            upstream_->deallocate(chunk.memory, chunk.bytes, alignof(std::max_align_t));
+        }
+        chunks_.clear();
+        cursor_ = nullptr;
+        end_ = nullptr;
+        usedBytes_ = 0;
+    }
+
+    std::size_t chunkCount() const noexcept { return chunks_.size(); }
+    std::size_t usedBytes() const noexcept { return usedBytes_; }
+
+private:
+    /** @brief 1チャンクの上限（倍々で増やしすぎないため）。 */
+    static constexpr std::size_t kMaxChunkBytes = 16 * 1024 * 1024;
+
+    struct Chunk {
+        void* memory;
+        std::size_t bytes;
+    };
+
+    void addChunk(std::size_t minimumBytes) {
+        const std::size_t bytes = std::max(nextChunkBytes_, minimumBytes);
+        auto* memory = static_cast<unsigned char*>(upstream_->allocate(bytes, alignof(std::max_align_t)));
+        chunks_.push_back(Chunk{memory, bytes});
+        cursor_ = memory;
+        end_ = memory + bytes;
+        nextChunkBytes_ = std::min(nextChunkBytes_ * 2, kMaxChunkBytes);
+    }
+
+    std::size_t nextChunkBytes_;
+    std::pmr::memory_resource* upstream_;
+    unsigned char* cursor_ = nullptr;
+    unsigned char* end_ = nullptr;
+    std::vector<Chunk> chunks_;
+    std::size_t usedBytes_ = 0;
+};
+
+/**
+ * @brief 大きさ別の FixedSizePool を束ねた std::pmr::memory_resource。
+ * @details
+ * - 16, 32, 64, ... , 512 バイトの大きさクラスを持ち、要求を「以上で最小」のクラスへ振り分ける。
+ * - 512 バイトを超える要求と、max_align_t より厳しい境界の要求は上流へそのまま渡す。
+ * - allocate_shared のように「中で別の型へ rebind して確保する」場合も、大きさで振り分けるので使える。
+ */
+class PoolMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit PoolMemoryResource(std::size_t blocksPerChunk = 4096,
+                                std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream_(upstream),
+          pools_{{FixedSizePool(16, alignof(std::max_align_t), blocksPerChunk, upstream),
+                  FixedSizePool(32, alignof(std::max_align_t), blocksPerChunk, upstream),
+                  FixedSizePool(64, alignof(std::max_align_t), blocksPerChunk, upstream),
+                  FixedSizePool(128, alignof(std::max_align_t), blocksPerChunk, upstream),
+                  FixedSizePool(256, alignof(std::max_align_t), blocksPerChunk, upstream),
+                  FixedSizePool(512, alignof(std::max_align_t), blocksPerChunk, upstream)}} {}
+
+    /** @brief 大きさクラスごとのプール（統計表示用）。 */
+    const FixedSizePool& poolForSize(std::size_t bytes) const { return pools_[classIndex(bytes)]; }
+
+    /** @brief 全プールのチャンク数の合計。 */
+    std::size_t chunkCount() const noexcept {
+        std::size_t count = 0;
+        for (const FixedSizePool& pool : pools_) {
+            count += pool.chunkCount();
+        }
+        return count;
+    }
+
+private:
+    static constexpr std::size_t kMaxPooledBytes = 512;
+
+    static std::size_t classIndex(std::size_t bytes) noexcept {
+        std::size_t index = 0;
+        std::size_t classBytes = 16;
+        while (classBytes < bytes) {
+            classBytes *= 2;
+            ++index;
+        }
+        return index;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes > kMaxPooledBytes || alignment > alignof(std::max_align_t)) {
+            return upstream_->allocate(bytes, alignment);
+        }
+        return pools_[classIndex(bytes)].allocate();
+    }
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+        if (bytes > kMaxPooledBytes || alignment > alignof(std::max_align_t)) {
+            upstream_->deallocate(pointer, bytes, alignment);
+            return;
+        }
+        pools_[classIndex(bytes)].deallocate(pointer);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream_;
+    std::array<FixedSizePool, 6> pools_;
+};
+
+/**
+ * @brief MonotonicArena を std::pmr::memory_resource として使うアダプタ。
+ */
+class ArenaMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaMemoryResource(MonotonicArena& arena) : arena_(arena) {}
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override { return arena_.allocate(bytes, alignment); }
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t) override { arena_.deallocate(pointer, bytes); }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    MonotonicArena& arena_;
+};
+
+/**
+ * @brief MonotonicArena を直接使う型付きアロケータ（std::allocator と同じ使い方）。
+ * @details
+ * - polymorphic_allocator と違い仮想呼び出しが無く、確保処理がインライン展開される。
+ * - 別の型へ rebind しても同じアリーナを使う（allocate_shared の制御ブロックもアリーナに載る）。
+ */
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena& arena) noexcept : arena_(&arena) {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(std::size_t count) {
+        if (count > static_cast<std::size_t>(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept { arena_->deallocate(pointer, count * sizeof(T)); }
+
+    MonotonicArena* arena() const noexcept { return arena_; }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena(); }
+
+private:
+    MonotonicArena* arena_;
+};
@@ -0,0 +1,722 @@
+/**
+ * @file benchHarness.h
+ * @brief [重要] cpp_m の各サンプル共通のマイクロベンチマーク（ヘッダーのみ）。
+ * @details
+ * - 目的: cpp11〜cpp23 / modern で紹介した書き方（unique_ptr と生ポインタ、ジェネリックラムダと std::function など）を
+ *   「同じ手順・同じ統計」で測り、コンパイラ/最適化オプションの違いを JSON で比べられるようにする。
+ * - 使い方（各サンプル側）:
+ *   - `void registerXxxKernels(benchHarness::kernelRegistry& registry)` で計測対象（カーネル）を登録する。
+ *   - main の先頭で `if (benchHarness::isBenchCommand(args)) { return benchHarness::runCommand("cpp11", args, registerXxxKernels); }`
+ * - 計測手順（カーネルごと）:
+ *   - (1) 校正: 1回の試行が kMinTrialNanoseconds 以上になるよう、本体の繰り返し回数（repeat）を決める
+ *   - (2) 予熱（warm-up）: 結果を捨てて数回実行する（キャッシュ/分岐予測/クロック上昇を落ち着かせる）
+ *   - (3) 本計測: N 回の試行それぞれの時間を記録し、中央値（median）と p95 を求める
+ *   - (4) 1要素あたり ns と、取得できる環境ではサイクル数（x86 の TSC）を表示する
+ * - 比較モード: `--bench-compare base.json current.json` で2つの結果を突き合わせ、遅くなったカーネルを表示する。
+ *
+ * @note [厳守] 「1ファイル = 1実行ファイル」は変わらない。このヘッダーは main() を持たず、各サンプルが include するだけ。
+ * @note [厳守] C++11 でもコンパイルできる書き方に留める（cpp11.cpp からも使うため）。
+ * @note [注意] 最適化なしのビルドで測った値は比較の意味がない。JSON の "optimized" を確認すること。
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace benchHarness {
+
+/** @brief 1回の試行の最小時間。これより短いと時計の分解能と呼び出しコストが結果を支配する。 */
+constexpr std::uint64_t kMinTrialNanoseconds = 1000000;  // 1ms
+/** @brief 校正で決める繰り返し回数の上限。 */
+constexpr std::uint64_t kMaxRepeatCount = 1ULL << 24;
+/** @brief JSON の形式名（比較モードで同じ形式か確認する）。 */
+constexpr const char* kJsonSchema = "cpp_m-bench/1";
+
+/**
+ * @brief 値を「使った」ことにして、最適化で計算ごと消されるのを防ぎます（do-not-optimize 障壁）。
+ * @details
+ * - 結果を使わないループは、最適化で丸ごと削除されることがある（その場合 0ns と表示されてしまう）。
+ * - GCC/Clang: 空のインラインアセンブリに値を入力として渡し、「値が必要」とコンパイラに思わせる。
+ * - MSVC: インラインアセンブリが使えないため volatile へ書き込む（少しだけコストがある）。
+ * @tparam T 値の型
+ * @param value const T& 結果
+ * @return void
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<const volatile char*>(&value);
+  _ReadWriteBarrier();
+#endif
+}
+
+/**
+ * @brief 書き換え可能な値を渡した場合は「値が書き換えられたかもしれない」ことにもします。
+ * @details
+ * - 入力をこれに通すと、コンパイラは値を定数として扱えなくなる（ループ全体を計算式に畳み込まれるのを防ぐ）。
+ * @tparam T 値の型
+ * @param value T& 値
+ * @return void
+ */
+template <typename T>
+inline void doNotOptimize(T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : "+r,m"(value) : : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<volatile char*>(&value);
+  _ReadWriteBarrier();
+#endif
+}
+
+/**
+ * @brief 「メモリの中身が変わったかもしれない」とコンパイラに思わせます（書き込みの削除を防ぐ）。
+ * @return void
+ */
+inline void clobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#else
+  _ReadWriteBarrier();
+#endif
+}
+
+/**
+ * @brief サイクルカウンタを読みます（x86 の TSC。無い環境では false）。
+ * @details
+ * - [注意] TSC は「定格クロックで数えた周期」。ターボ時の実クロックとは一致しないが、同じマシンでの比較には使える。
+ * @param valueOut std::uint64_t* 読んだ値
+ * @return bool 取得できたら true
+ */
+inline bool readCycleCounter(std::uint64_t* valueOut) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  *valueOut = static_cast<std::uint64_t>(__rdtsc());
+  return true;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  *valueOut = static_cast<std::uint64_t>(__rdtsc());
+  return true;
+#else
+  *valueOut = 0;
+  return false;
+#endif
+}
+
+/**
+ * @brief 計測対象（カーネル）1個の定義。
+ * @details
+ * - body は「elementCount 個の要素を1回処理する」関数。結果は doNotOptimize へ渡すこと。
+ * - group が同じカーネル同士を並べて表示する（例: "ownership" の raw-new-delete と unique_ptr）。
+ */
+struct kernelDefinition {
+  std::string group;
+  std::string name;
+  std::uint64_t elementCount;
+  std::function<void()> body;
+};
+
+/**
+ * @brief カーネルの登録先。
+ */
+class kernelRegistry {
+ public:
+  /**
+   * @brief カーネルを登録します。
+   * @param group std::string 比較グループ名
+   * @param name std::string カーネル名（グループ内で一意）
+   * @param elementCount std::uint64_t body 1回で処理する要素数（1以上）
+   * @param body std::function<void()> 計測する処理
+   * @return void
+   * @throws std::invalid_argument elementCount が 0、body が空、名前が重複している場合
+   */
+  void add(const std::string& group, const std::string& name, const std::uint64_t elementCount, std::function<void()> body) {
+    if (elementCount == 0 || !body) {
+      throw std::invalid_argument("kernelRegistry::add: elementCount must be > 0 and body must not be empty. name=" + name);
+    }
+    for (const kernelDefinition& kernel : kernels_) {
+      if (kernel.group == group && kernel.name == name) {
+        throw std::invalid_argument("kernelRegistry::add: duplicated kernel. group=" + group + " name=" + name);
+      }
+    }
+    kernelDefinition kernel;
+    kernel.group = group;
+    kernel.name = name;
+    kernel.elementCount = elementCount;
+    kernel.body = std::move(body);
+    kernels_.push_back(std::move(kernel));
+  }
+
+  /** @brief 登録済みカーネル一覧。 */
+  const std::vector<kernelDefinition>& kernels() const { return kernels_; }
+
+ private:
+  std::vector<kernelDefinition> kernels_;
+};
+
+/**
+ * @brief コマンドラインで指定する計測条件。
+ */
+struct benchOptions {
+  int warmupCount = 3;
+  int trialCount = 15;
+  std::string filter;            // group/name に含まれる文字列で絞り込む（空は全部）
+  std::string jsonPath;          // 空: JSON を出さない / "-": 標準出力
+  std::string label;             // 結果に付ける名前（例: "gcc13-O2"）
+  std::string baselinePath;      // 比較モード: 基準の JSON
+  std::string currentPath;       // 比較モード: 比べる JSON
+  double thresholdPercent = 5.0;  // 比較モード: これ以上遅くなったら回帰とみなす
+};
+
+/**
+ * @brief カーネル1個の計測結果。
+ */
+struct kernelResult {
+  std::string group;
+  std::string name;
+  std::uint64_t elementCount = 0;
+  std::uint64_t repeatCount = 0;
+  int trialCount = 0;
+  double medianNanoseconds = 0.0;  // 1試行（elementCount x repeatCount 要素）の中央値
+  double p95Nanoseconds = 0.0;
+  double nsPerElement = 0.0;       // 中央値 / 要素数
+  double p95NsPerElement = 0.0;
+  double cyclesPerElement = -1.0;  // 取得できない場合は負
+};
+
+/**
+ * @brief 昇順に並んだ値から、nearest-rank 法でパーセンタイルを取ります。
+ * @param sortedValues const std::vector<double>& 昇順の値（空不可）
+ * @param percent double 0〜100
+ * @return double パーセンタイル値
+ */
+inline double percentileOfSorted(const std::vector<double>& sortedValues, const double percent) {
+  const double rank = percent / 100.0 * static_cast<double>(sortedValues.size());
+  std::size_t index = static_cast<std::size_t>(rank + 0.999999);  // 切り上げ（1始まりの順位）
+  index = std::max<std::size_t>(1, std::min(index, sortedValues.size()));
+  return sortedValues[index - 1];
+}
+
+/**
+ * @brief 中央値（偶数個なら中央2個の平均）。
+ * @param sortedValues const std::vector<double>& 昇順の値（空不可）
+ * @return double 中央値
+ */
+inline double medianOfSorted(const std::vector<double>& sortedValues) {
+  const std::size_t middle = sortedValues.size() / 2;
+  return sortedValues.size() % 2 == 1 ? sortedValues[middle] : (sortedValues[middle - 1] + sortedValues[middle]) / 2.0;
+}
+
+/**
+ * @brief body を repeatCount 回実行した時間(ns)とサイクル数を測ります。
+ */
+inline double measureOnce(const kernelDefinition& kernel, const std::uint64_t repeatCount, std::uint64_t* cyclesOut) {
+  std::uint64_t startCycles = 0;
+  const bool hasCycles = readCycleCounter(&startCycles);
+  const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  for (std::uint64_t i = 0; i < repeatCount; ++i) {
+    kernel.body();
+  }
+  clobberMemory();
+  const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+  std::uint64_t endCycles = 0;
+  *cyclesOut = hasCycles && readCycleCounter(&endCycles) ? endCycles - startCycles : 0;
+  return std::chrono::duration<double, std::nano>(endTime - startTime).count();
+}
+
+/**
+ * @brief カーネル1個を「校正 → 予熱 → N回試行」で計測します。
+ * @param kernel const kernelDefinition& 対象
+ * @param options const benchOptions& 条件
+ * @return kernelResult 結果
+ */
+inline kernelResult measureKernel(const kernelDefinition& kernel, const benchOptions& options) {
+  std::uint64_t ignoredCycles = 0;
+  std::uint64_t repeatCount = 1;
+  for (;;) {
+    const double elapsedNs = measureOnce(kernel, repeatCount, &ignoredCycles);
+    if (elapsedNs >= static_cast<double>(kMinTrialNanoseconds) || repeatCount >= kMaxRepeatCount) {
+      break;
+    }
+    // 目標時間に届くまで、見込みの倍率（最低2倍）で増やす。
+    const double scale = elapsedNs > 0.0 ? static_cast<double>(kMinTrialNanoseconds) / elapsedNs * 1.2 : 10.0;
+    repeatCount = std::min(kMaxRepeatCount, static_cast<std::uint64_t>(static_cast<double>(repeatCount) * std::max(2.0, scale)));
+  }
+  for (int i = 0; i < options.warmupCount; ++i) {
+    measureOnce(kernel, repeatCount, &ignoredCycles);
+  }
+
+  std::vector<double> trialNanoseconds;
+  std::vector<double> trialCycles;
+  trialNanoseconds.reserve(static_cast<std::size_t>(options.trialCount));
+  for (int i = 0; i < options.trialCount; ++i) {
+    std::uint64_t cycles = 0;
+    trialNanoseconds.push_back(measureOnce(kernel, repeatCount, &cycles));
+    if (cycles > 0) {
+      trialCycles.push_back(static_cast<double>(cycles));
+    }
+  }
+  std::sort(trialNanoseconds.begin(), trialNanoseconds.end());
+  std::sort(trialCycles.begin(), trialCycles.end());
+
+  kernelResult result;
+  result.group = kernel.group;
+  result.name = kernel.name;
+  result.elementCount = kernel.elementCount;
+  result.repeatCount = repeatCount;
+  result.trialCount = options.trialCount;
+  result.medianNanoseconds = medianOfSorted(trialNanoseconds);
+  result.p95Nanoseconds = percentileOfSorted(trialNanoseconds, 95.0);
+  const double elementsPerTrial = static_cast<double>(kernel.elementCount) * static_cast<double>(repeatCount);
+  result.nsPerElement = result.medianNanoseconds / elementsPerTrial;
+  result.p95NsPerElement = result.p95Nanoseconds / elementsPerTrial;
+  if (trialCycles.size() == trialNanoseconds.size()) {
+    result.cyclesPerElement = medianOfSorted(trialCycles) / elementsPerTrial;
+  }
+  return result;
+}
+
+/**
+ * @brief 使ったコンパイラの表示名。
+ */
+inline std::string getCompilerLabel() {
+  std::ostringstream oss;
+#if defined(__clang__)
+  oss << "clang " << __clang_major__ << "." << __clang_minor__ << "." << __clang_patchlevel__;
+#elif defined(__GNUC__)
+  oss << "gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "." << __GNUC_PATCHLEVEL__;
+#elif defined(_MSC_FULL_VER)
+  oss << "msvc " << _MSC_FULL_VER;
+#else
+  oss << "unknown";
+#endif
+  return oss.str();
+}
+
+/**
+ * @brief 最適化ビルドかどうかの表示（"yes" / "no" / "unknown"）。
+ * @details
+ * - GCC/Clang は `__OPTIMIZE__` で分かる。MSVC には相当するマクロが無いため unknown（/O2 を付けたか自分で確認）。
+ */
+inline const char* getOptimizedLabel() {
+#if defined(__OPTIMIZE__)
+  return "yes";
+#elif defined(__GNUC__) || defined(__clang__)
+  return "no";
+#else
+  return "unknown";
+#endif
+}
+
+/**
+ * @brief 使った C++ 標準の値（MSVC は `_MSVC_LANG`）。
+ */
+inline long long getStandardValue() {
+#if defined(_MSVC_LANG)
+  return static_cast<long long>(_MSVC_LANG);
+#else
+  return static_cast<long long>(__cplusplus);
+#endif
+}
+
+/**
+ * @brief JSON 文字列用にエスケープします。
+ */
+inline std::string escapeJson(const std::string& text) {
+  std::string escaped;
+  for (const char c : text) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          escaped += ' ';
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
+/**
+ * @brief 結果を JSON で書き出します。
+ * @details
+ * - [重要] 1カーネル = 1行 で書く。比較モードはこの形を前提に読む（汎用の JSON パーサは持たない）。
+ * @param out std::ostream& 出力先
+ * @param sampleName const std::string& サンプル名（例: "cpp11"）
+ * @param options const benchOptions& 条件
+ * @param results const std::vector<kernelResult>& 結果
+ * @return void
+ */
+inline void writeJson(std::ostream& out, const std::string& sampleName, const benchOptions& options,
+                      const std::vector<kernelResult>& results) {
+  out << "{\n";
+  out << "  \"schema\": \"" << kJsonSchema << "\",\n";
+  out << "  \"sample\": \"" << escapeJson(sampleName) << "\",\n";
+  out << "  \"label\": \"" << escapeJson(options.label) << "\",\n";
+  out << "  \"compiler\": \"" << escapeJson(getCompilerLabel()) << "\",\n";
+  out << "  \"standard\": " << getStandardValue() << ",\n";
+  out << "  \"optimized\": \"" << getOptimizedLabel() << "\",\n";
+  out << "  \"warmup\": " << options.warmupCount << ",\n";
+  out << "  \"trials\": " << options.trialCount << ",\n";
+  out << "  \"results\": [\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const kernelResult& result = results[i];
+    out << "    {\"group\": \"" << escapeJson(result.group) << "\", \"name\": \"" << escapeJson(result.name) << "\""
+        << ", \"elements\": " << result.elementCount << ", \"repeat\": " << result.repeatCount
+        << ", \"medianNs\": " << result.medianNanoseconds << ", \"p95Ns\": " << result.p95Nanoseconds
+        << ", \"nsPerElement\": " << result.nsPerElement << ", \"p95NsPerElement\": " << result.p95NsPerElement
+        << ", \"cyclesPerElement\": ";
+    if (result.cyclesPerElement < 0.0) {
+      out << "null";
+    } else {
+      out << result.cyclesPerElement;
+    }
+    out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+}
+
+/**
+ * @brief 1行の中から `"key": "文字列"` の値を取り出します（このヘッダーが書いた JSON 専用）。
+ * @return bool 見つかったら true
+ */
+inline bool findJsonString(const std::string& line, const std::string& key, std::string* valueOut) {
+  const std::string pattern = "\"" + key + "\": \"";
+  const std::size_t start = line.find(pattern);
+  if (start == std::string::npos) {
+    return false;
+  }
+  std::string value;
+  for (std::size_t i = start + pattern.size(); i < line.size(); ++i) {
+    if (line[i] == '\\' && i + 1 < line.size()) {
+      value += line[++i] == 'n' ? '\n' : line[i];
+    } else if (line[i] == '"') {
+      *valueOut = value;
+      return true;
+    } else {
+      value += line[i];
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 1行の中から `"key": 数値` の値を取り出します（null は false）。
+ * @return bool 見つかったら true
+ */
+inline bool findJsonNumber(const std::string& line, const std::string& key, double* valueOut) {
+  const std::string pattern = "\"" + key + "\": ";
+  const std::size_t start = line.find(pattern);
+  if (start == std::string::npos) {
+    return false;
+  }
+  std::istringstream iss(line.substr(start + pattern.size()));
+  double value = 0.0;
+  if (!(iss >> value)) {
+    return false;
+  }
+  *valueOut = value;
+  return true;
+}
+
+/**
+ * @brief 比較モード用に読み込んだ JSON。
+ */
+struct loadedResults {
+  std::string sample;
+  std::string label;
+  std::string compiler;
+  std::string optimized;
+  std::map<std::string, kernelResult> results;  // キー: "group/name"
+};
+
+/**
+ * @brief `writeJson()` が書いた JSON を読み込みます。
+ * @param path const std::string& ファイルパス
+ * @return loadedResults 内容
+ * @throws std::runtime_error 開けない/形式が違う場合
+ */
+inline loadedResults loadJson(const std::string& path) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    throw std::runtime_error("benchHarness::loadJson: cannot open file. path=\"" + path + "\"");
+  }
+  loadedResults loaded;
+  bool hasSchema = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::string schema;
+    if (findJsonString(line, "schema", &schema)) {
+      if (schema != kJsonSchema) {
+        throw std::runtime_error("benchHarness::loadJson: unsupported schema \"" + schema + "\". path=\"" + path + "\"");
+      }
+      hasSchema = true;
+      continue;
+    }
+    kernelResult result;
+    if (findJsonString(line, "name", &result.name) && findJsonString(line, "group", &result.group)) {
+      if (!findJsonNumber(line, "nsPerElement", &result.nsPerElement) ||
+          !findJsonNumber(line, "p95NsPerElement", &result.p95NsPerElement)) {
+        throw std::runtime_error("benchHarness::loadJson: broken result line. path=\"" + path + "\" line=\"" + line + "\"");
+      }
+      if (!findJsonNumber(line, "cyclesPerElement", &result.cyclesPerElement)) {
+        result.cyclesPerElement = -1.0;
+      }
+      loaded.results[result.group + "/" + result.name] = result;
+      continue;
+    }
+    if (!findJsonString(line, "sample", &loaded.sample) && !findJsonString(line, "label", &loaded.label) &&
+        !findJsonString(line, "compiler", &loaded.compiler)) {
+      findJsonString(line, "optimized", &loaded.optimized);
+    }
+  }
+  if (!hasSchema) {
+    throw std::runtime_error("benchHarness::loadJson: schema not found (not written by benchHarness?). path=\"" + path + "\"");
+  }
+  return loaded;
+}
+
+/**
+ * @brief 2つの結果を比べ、回帰（遅くなったカーネル）を表示します。
+ * @details
+ * - 回帰の判定: current の中央値が「base の中央値 x (1 + threshold%)」を超え、かつ base の p95 も超えた場合。
+ *   p95 も見るのは、もともとばらつきの大きいカーネルを誤検出しないため。
+ * - 改善（threshold% 以上速くなった）も表示するが、終了コードには影響しない。
+ * @param options const benchOptions& 条件（baselinePath / currentPath / thresholdPercent）
+ * @return int 回帰なし 0 / 回帰あり 1
+ * @throws std::runtime_error JSON を読めない場合
+ */
+inline int compareResults(const benchOptions& options) {
+  const loadedResults baseline = loadJson(options.baselinePath);
+  const loadedResults current = loadJson(options.currentPath);
+  std::cout << "\n=== bench compare ===\n";
+  std::cout << "base   : " << options.baselinePath << " sample=" << baseline.sample << " label=" << baseline.label
+            << " compiler=" << baseline.compiler << " optimized=" << baseline.optimized << "\n";
+  std::cout << "current: " << options.currentPath << " sample=" << current.sample << " label=" << current.label
+            << " compiler=" << current.compiler << " optimized=" << current.optimized << "\n";
+  std::cout << "threshold=" << options.thresholdPercent << "%\n";
+  if (baseline.sample != current.sample) {
+    std::cout << "[注意] sample が違います（同じ名前のカーネルだけ比べます）\n";
+  }
+
+  int regressionCount = 0;
+  for (std::map<std::string, kernelResult>::const_iterator it = current.results.begin(); it != current.results.end(); ++it) {
+    const std::map<std::string, kernelResult>::const_iterator baseIt = baseline.results.find(it->first);
+    if (baseIt == baseline.results.end()) {
+      std::cout << "  [new]        " << it->first << " ns/elem=" << it->second.nsPerElement << "\n";
+      continue;
+    }
+    const double baseNs = baseIt->second.nsPerElement;
+    const double currentNs = it->second.nsPerElement;
+    const double changePercent = baseNs > 0.0 ? (currentNs / baseNs - 1.0) * 100.0 : 0.0;
+    const char* verdict = "  [same]       ";
+    if (changePercent > options.thresholdPercent && currentNs > baseIt->second.p95NsPerElement) {
+      verdict = "  [REGRESSION] ";
+      ++regressionCount;
+    } else if (changePercent < -options.thresholdPercent) {
+      verdict = "  [faster]     ";
+    }
+    std::cout << verdict << it->first << " ns/elem " << baseNs << " -> " << currentNs << " (" << std::showpos
+              << std::fixed << std::setprecision(1) << changePercent << std::noshowpos << std::defaultfloat
+              << std::setprecision(6) << "%)\n";
+  }
+  for (std::map<std::string, kernelResult>::const_iterator it = baseline.results.begin(); it != baseline.results.end(); ++it) {
+    if (current.results.find(it->first) == current.results.end()) {
+      std::cout << "  [missing]    " << it->first << " (base only)\n";
+    }
+  }
+  std::cout << "regressions=" << regressionCount << "\n";
+  return regressionCount > 0 ? 1 : 0;
+}
+
+/**
+ * @brief ベンチマーク系のオプションが指定されているか判定します。
+ * @param args const std::vector<std::string>& コマンドライン引数
+ * @return bool `--bench` または `--bench-compare` があれば true
+ */
+inline bool isBenchCommand(const std::vector<std::string>& args) {
+  return std::find(args.begin(), args.end(), "--bench") != args.end() ||
+         std::find(args.begin(), args.end(), "--bench-compare") != args.end();
+}
+
+/**
+ * @brief 正の整数オプションを読みます。
+ * @throws std::runtime_error 値が無い/正の整数でない場合
+ */
+inline int parsePositiveIntOption(const std::vector<std::string>& args, std::size_t index) {
+  if (index + 1 >= args.size()) {
+    throw std::runtime_error("benchHarness::parseOptions: missing value for " + args[index]);
+  }
+  const std::string& text = args[index + 1];
+  std::istringstream iss(text);
+  int value = 0;
+  char rest = 0;
+  if (!(iss >> value) || (iss >> rest) || value <= 0) {
+    throw std::runtime_error("benchHarness::parseOptions: invalid " + args[index] + " \"" + text + "\" (expected: positive integer)");
+  }
+  return value;
+}
+
+/**
+ * @brief 0 以上の実数オプションを読みます。
+ * @throws std::runtime_error 値が無い/0 以上の実数でない場合
+ */
+inline double parseNonNegativeDoubleOption(const std::vector<std::string>& args, std::size_t index) {
+  if (index + 1 >= args.size()) {
+    throw std::runtime_error("benchHarness::parseOptions: missing value for " + args[index]);
+  }
+  const std::string& text = args[index + 1];
+  std::istringstream iss(text);
+  double value = 0.0;
+  char rest = 0;
+  if (!(iss >> value) || (iss >> rest) || !(value >= 0.0)) {
+    throw std::runtime_error("benchHarness::parseOptions: invalid " + args[index] + " \"" + text + "\" (expected: non-negative number)");
+  }
+  return value;
+}
+
+/**
+ * @brief `--bench-*` オプションを読み取ります。
+ * @param args const std::vector<std::string>& コマンドライン引数
+ * @return benchOptions 条件
+ * @throws std::runtime_error 値が不正な場合、または知らない `--bench-*` がある場合（`--bench-trial` などの打ち間違いを既定値で黙って測らないため）
+ */
+inline benchOptions parseOptions(const std::vector<std::string>& args) {
+  benchOptions options;
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    const bool hasValue = i + 1 < args.size();
+    if (arg == "--bench-trials") {
+      options.trialCount = parsePositiveIntOption(args, i++);
+    } else if (arg == "--bench-warmup") {
+      options.warmupCount = parsePositiveIntOption(args, i++);
+    } else if ((arg == "--bench-filter" || arg == "--bench-json" || arg == "--bench-label") && !hasValue) {
+      throw std::runtime_error("benchHarness::parseOptions: missing value for " + arg);
+    } else if (arg == "--bench-filter") {
+      options.filter = args[++i];
+    } else if (arg == "--bench-json") {
+      options.jsonPath = args[++i];
+    } else if (arg == "--bench-label") {
+      options.label = args[++i];
+    } else if (arg == "--bench-threshold") {
+      options.thresholdPercent = parseNonNegativeDoubleOption(args, i++);
+    } else if (arg == "--bench-compare") {
+      if (i + 2 >= args.size()) {
+        throw std::runtime_error("benchHarness::parseOptions: --bench-compare needs <base.json> <current.json>");
+      }
+      options.baselinePath = args[i + 1];
+      options.currentPath = args[i + 2];
+      i += 2;
+    } else if (arg.compare(0, 8, "--bench-") == 0) {
+      throw std::runtime_error("benchHarness::parseOptions: unknown option " + arg +
+                               " (expected: --bench-trials / --bench-warmup / --bench-filter / --bench-json / "
+                               "--bench-label / --bench-threshold / --bench-compare)");
+    }
+  }
+  return options;
+}
+
+/**
+ * @brief 登録したカーネルを全部測り、表と（指定があれば）JSON を出力します。
+ * @param sampleName const std::string& サンプル名
+ * @param registry const kernelRegistry& 登録済みカーネル
+ * @param options const benchOptions& 条件
+ * @return std::vector<kernelResult> 結果
+ * @throws std::runtime_error フィルタに一致するカーネルが無い/JSON を書けない場合
+ */
+inline std::vector<kernelResult> runKernels(const std::string& sampleName, const kernelRegistry& registry,
+                                            const benchOptions& options) {
+  std::cout << "\n=== bench (" << sampleName << ") ===\n";
+  std::cout << "compiler=" << getCompilerLabel() << " standard=" << getStandardValue()
+            << " optimized=" << getOptimizedLabel() << " warmup=" << options.warmupCount
+            << " trials=" << options.trialCount << "\n";
+  if (std::string(getOptimizedLabel()) == "no") {
+    std::cout << "[注意] 最適化なしのビルドです。比較には -O2 / /O2 以上でビルドした結果を使ってください。\n";
+  }
+
+  std::vector<kernelResult> results;
+  std::string previousGroup;
+  for (const kernelDefinition& kernel : registry.kernels()) {
+    if (!options.filter.empty() && (kernel.group + "/" + kernel.name).find(options.filter) == std::string::npos) {
+      continue;
+    }
+    if (kernel.group != previousGroup) {
+      std::cout << "[" << kernel.group << "]\n";
+      previousGroup = kernel.group;
+    }
+    const kernelResult result = measureKernel(kernel, options);
+    std::cout << "  " << std::left << std::setw(28) << result.name << std::right << " median=" << std::setw(10)
+              << result.nsPerElement << " ns/elem  p95=" << std::setw(10) << result.p95NsPerElement << " ns/elem";
+    if (result.cyclesPerElement >= 0.0) {
+      std::cout << "  cycles/elem=" << result.cyclesPerElement;
+    }
+    std::cout << "  (elements=" << result.elementCount << " x repeat=" << result.repeatCount << ")\n";
+    results.push_back(result);
+  }
+  if (results.empty()) {
+    throw std::runtime_error("benchHarness::runKernels: no kernel matched. filter=\"" + options.filter + "\"");
+  }
+
+  if (options.jsonPath == "-") {
+    writeJson(std::cout, sampleName, options, results);
+  } else if (!options.jsonPath.empty()) {
+    std::ofstream out(options.jsonPath.c_str());
+    if (!out) {
+      throw std::runtime_error("benchHarness::runKernels: cannot open json output. path=\"" + options.jsonPath + "\"");
+    }
+    writeJson(out, sampleName, options, results);
+    std::cout << "json=" << options.jsonPath << "\n";
+  }
+  return results;
+}
+
+/**
+ * @brief サンプルの main から呼ぶ入口（`--bench` または `--bench-compare`）。
+ * @param sampleName const std::string& サンプル名（JSON の "sample"）
+ * @param args const std::vector<std::string>& コマンドライン引数
+ * @param registerKernels void(*)(kernelRegistry&) カーネル登録関数
+ * @return int 終了コード（0: 正常 / 1: 比較で回帰あり）
+ * @throws std::runtime_error オプション/入出力が不正な場合
+ */
+inline int runCommand(const std::string& sampleName, const std::vector<std::string>& args,
+                      void (*registerKernels)(kernelRegistry&)) {
+  const benchOptions options = parseOptions(args);
+  if (!options.baselinePath.empty()) {
+    return compareResults(options);
+  }
+  kernelRegistry registry;
+  registerKernels(registry);
+  runKernels(sampleName, registry, options);
+  return 0;
+}
+
+}  // namespace benchHarness
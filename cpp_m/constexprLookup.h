@@ -0,0 +1,347 @@
+/**
+ * @file constexprLookup.h
+ * @brief [重要] コンパイル時（constexpr）に作る文字列ハッシュ・整列済み表・完全ハッシュ表（ヘッダーのみ）。
+ * @details
+ * - 目的: コマンド名などの「決まった文字列の集合」から値を引く処理を、実行時の初期化や確保なしで行う。
+ * - 提供するもの:
+ *   - `fnv1a32` / `fnv1a64` / `xxh32`: constexpr の文字列ハッシュ（コンパイル時にも実行時にも同じ値）
+ *   - `sortedTable`   : キーをコンパイル時に並べ替えた表。実行時は二分探索（比較 log2(N) 回）
+ *   - `perfectHashMap`: キーが衝突しない種（seed）をコンパイル時に探した表。実行時はハッシュ1回 + 文字列比較1回
+ * - 検証: キーの重複や、種が見つからない場合はコンパイル時に throw に到達し、**コンパイルエラー**になる
+ *   （constexpr 評価中の throw は「定数式ではない」扱いになるため）。
+ * - 使い方: `constexpr auto table = constexprLookup::makePerfectHashMap<commandId>({{"get", commandId::get}, ...});`
+ *   C++20 では `constinit` を付けると、グローバル変数として「静的初期化済み」を保証できる（cpp20.cpp）。
+ *
+ * @note [厳守] C++17 以上でコンパイルすること（string_view と constexpr のループを使うため）。
+ * @note [注意] キーは string_view で持つ。文字列リテラル（静的な寿命）以外を入れないこと。
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace constexprLookup {
+
+/**
+ * @brief FNV-1a（32bit）。1文字ずつ XOR して素数を掛ける、短い文字列向けの簡単なハッシュ。
+ * @param text std::string_view 対象
+ * @param seed std::uint32_t 初期値（既定は FNV の offset basis）
+ * @return std::uint32_t ハッシュ値
+ */
+constexpr std::uint32_t fnv1a32(const std::string_view text, const std::uint32_t seed = 2166136261u) {
+  std::uint32_t hash = seed;
+  for (const char c : text) {
+    hash ^= static_cast<std::uint8_t>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief FNV-1a（64bit）。
+ * @param text std::string_view 対象
+ * @param seed std::uint64_t 初期値（既定は FNV の offset basis）
+ * @return std::uint64_t ハッシュ値
+ */
+constexpr std::uint64_t fnv1a64(const std::string_view text, const std::uint64_t seed = 14695981039346656037ull) {
+  std::uint64_t hash = seed;
+  for (const char c : text) {
+    hash ^= static_cast<std::uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+namespace detail {
+
+constexpr std::uint32_t kXxhPrime1 = 2654435761u;
+constexpr std::uint32_t kXxhPrime2 = 2246822519u;
+constexpr std::uint32_t kXxhPrime3 = 3266489917u;
+constexpr std::uint32_t kXxhPrime4 = 668265263u;
+constexpr std::uint32_t kXxhPrime5 = 374761393u;
+
+constexpr std::uint32_t rotateLeft(const std::uint32_t value, const int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+/** @brief 4バイトをリトルエンディアンとして読む（constexpr で使えるよう memcpy ではなくシフトで組み立てる）。 */
+constexpr std::uint32_t readLittle32(const std::string_view text, const std::size_t offset) {
+  return static_cast<std::uint32_t>(static_cast<std::uint8_t>(text[offset])) |
+         (static_cast<std::uint32_t>(static_cast<std::uint8_t>(text[offset + 1])) << 8) |
+         (static_cast<std::uint32_t>(static_cast<std::uint8_t>(text[offset + 2])) << 16) |
+         (static_cast<std::uint32_t>(static_cast<std::uint8_t>(text[offset + 3])) << 24);
+}
+
+constexpr std::uint32_t xxhRound(std::uint32_t accumulator, const std::uint32_t input) {
+  accumulator += input * kXxhPrime2;
+  accumulator = rotateLeft(accumulator, 13);
+  return accumulator * kXxhPrime1;
+}
+
+/** @brief 2の冪に切り上げる（C++20 の std::bit_ceil 相当。C++17 でも使えるよう自前）。 */
+constexpr std::size_t roundUpToPowerOfTwo(const std::size_t value) {
+  std::size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace detail
+
+/**
+ * @brief xxHash32（公式の XXH32 と同じ値）。長めの文字列では FNV より速い（4バイトずつ処理するため）。
+ * @param text std::string_view 対象
+ * @param seed std::uint32_t 種
+ * @return std::uint32_t ハッシュ値
+ */
+constexpr std::uint32_t xxh32(const std::string_view text, const std::uint32_t seed = 0) {
+  using namespace detail;
+  const std::size_t length = text.size();
+  std::size_t offset = 0;
+  std::uint32_t hash = 0;
+  if (length >= 16) {
+    std::uint32_t v1 = seed + kXxhPrime1 + kXxhPrime2;
+    std::uint32_t v2 = seed + kXxhPrime2;
+    std::uint32_t v3 = seed;
+    std::uint32_t v4 = seed - kXxhPrime1;
+    for (; offset + 16 <= length; offset += 16) {
+      v1 = xxhRound(v1, readLittle32(text, offset));
+      v2 = xxhRound(v2, readLittle32(text, offset + 4));
+      v3 = xxhRound(v3, readLittle32(text, offset + 8));
+      v4 = xxhRound(v4, readLittle32(text, offset + 12));
+    }
+    hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+  } else {
+    hash = seed + kXxhPrime5;
+  }
+  hash += static_cast<std::uint32_t>(length);
+  for (; offset + 4 <= length; offset += 4) {
+    hash += readLittle32(text, offset) * kXxhPrime3;
+    hash = rotateLeft(hash, 17) * kXxhPrime4;
+  }
+  for (; offset < length; ++offset) {
+    hash += static_cast<std::uint32_t>(static_cast<std::uint8_t>(text[offset])) * kXxhPrime5;
+    hash = rotateLeft(hash, 11) * kXxhPrime1;
+  }
+  hash ^= hash >> 15;
+  hash *= kXxhPrime2;
+  hash ^= hash >> 13;
+  hash *= kXxhPrime3;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+namespace literals {
+
+/**
+ * @brief `"get"_fnv` でコンパイル時に FNV-1a(64bit) を求めるリテラル（switch の case に使える）。
+ * @return std::uint64_t ハッシュ値
+ */
+constexpr std::uint64_t operator""_fnv(const char* text, const std::size_t length) {
+  return fnv1a64(std::string_view(text, length));
+}
+
+}  // namespace literals
+
+/**
+ * @brief キーと値の組（表の1行）。
+ * @tparam Value 値の型（constexpr で扱える型: 整数・enum など）
+ */
+template <typename Value>
+struct keyValue {
+  std::string_view key{};
+  Value value{};
+};
+
+/**
+ * @brief コンパイル時に並べ替えた表（実行時は二分探索）。
+ * @details
+ * - 構築（並べ替え・重複チェック）は constexpr。C++17 では std::sort が constexpr ではないため挿入ソートで書く。
+ * - 探索は比較 log2(N) 回。ハッシュを計算しない分、キーが少ない/短い場合に有利なことがある。
+ * @tparam Value 値の型
+ * @tparam N キーの数
+ */
+template <typename Value, std::size_t N>
+class sortedTable {
+ public:
+  /**
+   * @brief 表を作ります（キーの重複があれば throw。constexpr 評価中ならコンパイルエラー）。
+   * @param entries const std::array<keyValue<Value>, N>& 並び順は問わない
+   */
+  constexpr explicit sortedTable(const std::array<keyValue<Value>, N>& entries) : entries_(entries) {
+    for (std::size_t i = 1; i < N; ++i) {
+      const keyValue<Value> moving = entries_[i];
+      std::size_t j = i;
+      while (j > 0 && moving.key < entries_[j - 1].key) {
+        entries_[j] = entries_[j - 1];
+        --j;
+      }
+      entries_[j] = moving;
+    }
+    for (std::size_t i = 1; i < N; ++i) {
+      if (entries_[i - 1].key == entries_[i].key) {
+        throw std::logic_error("sortedTable: duplicate key");
+      }
+    }
+  }
+
+  /**
+   * @brief キーを二分探索します。
+   * @param key std::string_view 探すキー
+   * @return const Value* 見つかれば値へのポインタ、無ければ nullptr
+   */
+  constexpr const Value* find(const std::string_view key) const {
+    std::size_t low = 0;
+    std::size_t high = N;
+    while (low < high) {
+      const std::size_t middle = low + (high - low) / 2;
+      const int order = key.compare(entries_[middle].key);
+      if (order == 0) {
+        return &entries_[middle].value;
+      }
+      if (order < 0) {
+        high = middle;
+      } else {
+        low = middle + 1;
+      }
+    }
+    return nullptr;
+  }
+
+  /** @brief キーの数。 */
+  constexpr std::size_t size() const { return N; }
+
+  /** @brief i 番目（キーの昇順）の行。 */
+  constexpr const keyValue<Value>& entryAt(const std::size_t index) const { return entries_[index]; }
+
+ private:
+  std::array<keyValue<Value>, N> entries_{};
+};
+
+/**
+ * @brief 完全ハッシュ表（キーが衝突しない種をコンパイル時に探した、開番地なしの表）。
+ * @details
+ * - 枠の数はキー数の2倍以上の2の冪。`fnv1a64(key, 種) & (枠数-1)` が全キーで異なる種を 1, 2, 3... と順に試す。
+ * - 実行時の探索: ハッシュ1回 → 枠1つ → 長さと文字列の比較1回。未知のキーも比較1回で「無い」と分かる。
+ * - 種が kMaxSeedAttempts 回以内に見つからなければ throw（constexpr 評価中ならコンパイルエラー）。
+ * @tparam Value 値の型
+ * @tparam N キーの数
+ */
+template <typename Value, std::size_t N>
+class perfectHashMap {
+ public:
+  /** @brief 枠の数（キー数の2倍以上の2の冪）。 */
+  static constexpr std::size_t kSlotCount = detail::roundUpToPowerOfTwo(N * 2);
+  /** @brief 種を探す回数の上限（コンパイル時間の上限でもある）。 */
+  static constexpr std::uint64_t kMaxSeedAttempts = 4096;
+
+  /**
+   * @brief 表を作ります（重複キー・種が見つからない場合は throw）。
+   * @param entries const std::array<keyValue<Value>, N>& 並び順は問わない
+   */
+  constexpr explicit perfectHashMap(const std::array<keyValue<Value>, N>& entries) {
+    // 重複キーはどの種でも衝突するため、種を探す前に弾く（探し続けてコンパイルが長引くのを防ぐ）
+    for (std::size_t i = 0; i < N; ++i) {
+      for (std::size_t j = i + 1; j < N; ++j) {
+        if (entries[i].key == entries[j].key) {
+          throw std::logic_error("perfectHashMap: duplicate key");
+        }
+      }
+    }
+    for (std::uint64_t candidate = 1; candidate <= kMaxSeedAttempts; ++candidate) {
+      if (tryPlace(entries, candidate)) {
+        seed_ = candidate;
+        return;
+      }
+    }
+    throw std::logic_error("perfectHashMap: no collision-free seed");
+  }
+
+  /**
+   * @brief キーを探します。
+   * @param key std::string_view 探すキー
+   * @return const Value* 見つかれば値へのポインタ、無ければ nullptr
+   */
+  constexpr const Value* find(const std::string_view key) const {
+    const slot& candidate = slots_[slotIndex(key, seed_)];
+    if (!candidate.isUsed || candidate.entry.key != key) {
+      return nullptr;
+    }
+    return &candidate.entry.value;
+  }
+
+  /** @brief 見つけた種（表示・検証用）。 */
+  constexpr std::uint64_t seed() const { return seed_; }
+
+  /** @brief キーの数。 */
+  constexpr std::size_t size() const { return N; }
+
+ private:
+  struct slot {
+    keyValue<Value> entry{};
+    bool isUsed = false;
+  };
+
+  static constexpr std::size_t slotIndex(const std::string_view key, const std::uint64_t seed) {
+    // 種を FNV の初期値へ混ぜる（種ごとに別のハッシュ関数になる）。
+    // FNV の下位ビットは入力の下位ビットでしか決まらないため、上位ビットを下へ混ぜてから枠番号を取る。
+    std::uint64_t hash = fnv1a64(key, 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull));
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return static_cast<std::size_t>(hash & (kSlotCount - 1));
+  }
+
+  constexpr bool tryPlace(const std::array<keyValue<Value>, N>& entries, const std::uint64_t candidate) {
+    slots_ = std::array<slot, kSlotCount>{};
+    for (const keyValue<Value>& entry : entries) {
+      slot& target = slots_[slotIndex(entry.key, candidate)];
+      if (target.isUsed) {
+        return false;
+      }
+      target.entry = entry;
+      target.isUsed = true;
+    }
+    return true;
+  }
+
+  std::array<slot, kSlotCount> slots_{};
+  std::uint64_t seed_ = 0;
+};
+
+namespace detail {
+
+/** @brief 組み込み配列を std::array へ写す（make 関数で N を推論させるため、引数は組み込み配列で受ける）。 */
+template <typename Value, std::size_t N>
+constexpr std::array<keyValue<Value>, N> toArray(const keyValue<Value> (&entries)[N]) {
+  std::array<keyValue<Value>, N> result{};
+  for (std::size_t i = 0; i < N; ++i) {
+    result[i] = entries[i];
+  }
+  return result;
+}
+
+}  // namespace detail
+
+/**
+ * @brief `makeSortedTable<Value>({{"a", 1}, {"b", 2}})` の形で作るための補助（キーの数 N を推論させる）。
+ */
+template <typename Value, std::size_t N>
+constexpr sortedTable<Value, N> makeSortedTable(const keyValue<Value> (&entries)[N]) {
+  return sortedTable<Value, N>(detail::toArray(entries));
+}
+
+/**
+ * @brief `makePerfectHashMap<Value>({{"a", 1}, {"b", 2}})` の形で作るための補助（キーの数 N を推論させる）。
+ */
+template <typename Value, std::size_t N>
+constexpr perfectHashMap<Value, N> makePerfectHashMap(const keyValue<Value> (&entries)[N]) {
+  return perfectHashMap<Value, N>(detail::toArray(entries));
+}
+
+}  // namespace constexprLookup
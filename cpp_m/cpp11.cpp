@@ -14,6 +14,7 @@
  * @note [推奨] 例外発生時の出力を読み、どの関数で失敗したかを追う。理由: 実務でのデバッグに直結するため。
  */
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -22,6 +23,8 @@
 #include <utility>
 #include <vector>
 
+#include "benchHarness.h"
+
 namespace {
 
 /**
@@ -229,6 +232,54 @@ void runCpp11Samples() {
   std::cout << "favorite=" << toString(favorite) << "\n";
 }
 
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - ownership: 生の new/delete と unique_ptr で「確保→使用→解放」を比べる（unique_ptr は追加コストが無い想定）。
+ * - traverse : 生ポインタ配列と unique_ptr 配列をたどって合計する（参照外しのコストも同じ想定）。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerCpp11Kernels(benchHarness::kernelRegistry& registry) {
+  const std::uint64_t kElementCount = 1024;
+
+  registry.add("ownership", "raw-new-delete", kElementCount, [kElementCount]() {
+    for (std::uint64_t i = 0; i < kElementCount; ++i) {
+      int* value = new int(static_cast<int>(i));
+      benchHarness::doNotOptimize(*value);
+      delete value;
+    }
+  });
+  registry.add("ownership", "unique_ptr", kElementCount, [kElementCount]() {
+    for (std::uint64_t i = 0; i < kElementCount; ++i) {
+      std::unique_ptr<int> value(new int(static_cast<int>(i)));
+      benchHarness::doNotOptimize(*value);
+    }
+  });
+
+  // [重要] 両方のカーネルが同じデータを見るよう、shared_ptr で保持してラムダへ渡す（C++11 は初期化キャプチャが無い）。
+  std::shared_ptr<std::vector<std::unique_ptr<int>>> ownedValues(new std::vector<std::unique_ptr<int>>());
+  std::shared_ptr<std::vector<int*>> rawValues(new std::vector<int*>());
+  for (std::uint64_t i = 0; i < kElementCount; ++i) {
+    ownedValues->push_back(std::unique_ptr<int>(new int(static_cast<int>(i))));
+    rawValues->push_back(ownedValues->back().get());  // 所有は ownedValues。rawValues は見るだけ
+  }
+  registry.add("traverse", "raw-pointer", kElementCount, [rawValues, ownedValues]() {
+    long long sum = 0;
+    for (const int* value : *rawValues) {
+      sum += *value;
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("traverse", "unique_ptr", kElementCount, [ownedValues]() {
+    long long sum = 0;
+    for (const std::unique_ptr<int>& value : *ownedValues) {
+      sum += *value;
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+}
+
 #if 0
 // ---------------------------------------------------------------------------
 // [悪い例/良い例] よくある間違いの対比（ビルドが通らない例は #if 0 に閉じ込める）
@@ -275,8 +326,10 @@ void runCpp11Samples() {
  */
 int main(const int argc, char** argv) {
   try {
-    (void)argc;
-    (void)argv;
+    const std::vector<std::string> args(argv, argv + argc);
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("cpp11", args, registerCpp11Kernels);
+    }
     std::cout << "[cpp11] args: " << joinArgs(argc, argv) << "\n";
     runCpp11Samples();
     return 0;
@@ -11,6 +11,8 @@
  * @note [厳守] C++14 以上でコンパイルすること（例: clang++ -std=c++14 / g++ -std=c++14）。理由: 学習対象機能が有効になるため。
  */
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -19,6 +21,8 @@
 #include <utility>
 #include <vector>
 
+#include "benchHarness.h"
+
 namespace {
 
 /**
@@ -197,6 +201,51 @@ void runCpp14Samples() {
   demonstrateDigitSeparators();
 }
 
+/**
+ * @brief ジェネリックラムダを受け取って count 回呼ぶ（テンプレートなのでインライン展開できる）。
+ * @tparam Callable 呼び出し可能な型
+ * @param callable const Callable& 呼ぶ関数
+ * @param count int 回数
+ * @return long long 戻り値の合計
+ */
+template <typename Callable>
+long long callRepeatedly(const Callable& callable, const int count) {
+  long long sum = 0;
+  for (int i = 0; i < count; ++i) {
+    int input = i;
+    benchHarness::doNotOptimize(input);  // 入力を不透明にし、ループ全体を計算式に畳み込まれないようにする
+    sum += callable(input);
+  }
+  return sum;
+}
+
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - callable: 同じ処理を「ジェネリックラムダ（テンプレートで直接呼ぶ）」「std::function」「関数ポインタ」で呼び比べる。
+ *   std::function と関数ポインタは間接呼び出しになり、インライン展開されにくい。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerCpp14Kernels(benchHarness::kernelRegistry& registry) {
+  constexpr int kCallCount = 4096;
+  const auto addOffset = [offset = 7](const auto x) { return x + offset; };
+
+  registry.add("callable", "generic-lambda", kCallCount, [addOffset]() {
+    benchHarness::doNotOptimize(callRepeatedly(addOffset, kCallCount));
+  });
+  registry.add("callable", "std::function", kCallCount, [addOffset]() {
+    static const std::function<long long(int)> wrapped = addOffset;
+    benchHarness::doNotOptimize(callRepeatedly(wrapped, kCallCount));
+  });
+  registry.add("callable", "function-pointer", kCallCount, []() {
+    // キャプチャなしのラムダは関数ポインタへ変換できる。volatile 経由にして定数として畳み込まれないようにする。
+    static long long (*volatile pointer)(int) = [](const int x) -> long long { return x + 7; };
+    long long (*const target)(int) = pointer;
+    benchHarness::doNotOptimize(callRepeatedly(target, kCallCount));
+  });
+}
+
 #if 0
 // ---------------------------------------------------------------------------
 // [悪い例/良い例] よくある間違いの対比（ビルドが通らない例は #if 0 に閉じ込める）
@@ -234,6 +283,10 @@ void runCpp14Samples() {
  */
 int main(const int argc, char** argv) {
   try {
+    const std::vector<std::string> args(argv, argv + argc);
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("cpp14", args, registerCpp14Kernels);
+    }
     std::cout << "[cpp14] args: " << joinArgs(argc, argv) << "\n";
     runCpp14Samples();
     return 0;
@@ -4,6 +4,8 @@
  * @details
  * - 目的: C++17 の代表的機能を、実務でよく出る形（分岐・パース・戻り値）で確認する。
  * - 主な題材: 構造化束縛 / `if constexpr` / `std::optional` / `std::string_view`
+ * - 応用: constexpr の文字列ハッシュ・整列済み表・完全ハッシュ表（constexprLookup.h）で、コマンド名の振り分けを
+ *   if 連鎖 / std::unordered_map / switch(ハッシュ) と比べる（`--bench --bench-filter keyword-dispatch`）
  * - C言語経験者向け補足:
  *   - `std::optional<T>` は「値がある/ない」を型で表現します。Cでありがちな「-1 を失敗」等のセンチネルより安全。
  *   - `std::string_view` は「文字列を所有しない参照」です。Cの `const char*` に近いですが、
@@ -12,16 +14,23 @@
  * @note [厳守] C++17 以上でコンパイルすること（例: clang++ -std=c++17 / g++ -std=c++17）。
  */
 
+#include <charconv>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "benchHarness.h"
+#include "constexprLookup.h"
+
 namespace {
 
 /**
@@ -219,6 +228,171 @@ void demonstrateIfConstexpr() {
   std::cout << "category(string)=" << getTypeCategory(std::string("x")) << "\n";
 }
 
+/**
+ * @brief 振り分け先のコマンド（コマンドルーティングの例）。
+ */
+enum class commandId : std::uint8_t {
+  unknown,
+  get,
+  set,
+  del,
+  ping,
+  status,
+  reboot,
+  ota,
+  config,
+  log,
+  time,
+  led,
+  sensor,
+  wifi,
+  mqtt,
+  help,
+  version
+};
+
+/**
+ * @brief コマンド名と commandId の対応（この1か所を書き換えれば、下の表はすべてコンパイル時に作り直される）。
+ */
+constexpr constexprLookup::keyValue<commandId> kCommandEntries[] = {
+    {"get", commandId::get},       {"set", commandId::set},         {"del", commandId::del},
+    {"ping", commandId::ping},     {"status", commandId::status},   {"reboot", commandId::reboot},
+    {"ota", commandId::ota},       {"config", commandId::config},   {"log", commandId::log},
+    {"time", commandId::time},     {"led", commandId::led},         {"sensor", commandId::sensor},
+    {"wifi", commandId::wifi},     {"mqtt", commandId::mqtt},       {"help", commandId::help},
+    {"version", commandId::version}};
+
+/** @brief コンパイル時に並べ替えた表（実行時は二分探索）。 */
+constexpr auto kCommandSortedTable = constexprLookup::makeSortedTable(kCommandEntries);
+/** @brief コンパイル時に衝突しない種を探した完全ハッシュ表。 */
+constexpr auto kCommandPerfectHash = constexprLookup::makePerfectHashMap(kCommandEntries);
+
+// コンパイル時の検証（ここが通らなければビルドが止まる）
+static_assert(*kCommandSortedTable.find("ota") == commandId::ota, "sortedTable: ota");
+static_assert(kCommandSortedTable.find("otaa") == nullptr, "sortedTable: unknown key");
+static_assert(*kCommandPerfectHash.find("version") == commandId::version, "perfectHashMap: version");
+static_assert(kCommandPerfectHash.find("versio") == nullptr, "perfectHashMap: unknown key");
+static_assert(constexprLookup::xxh32("abc") == 0x32D153FFu, "xxh32: 公式テストベクタと一致");
+static_assert(constexprLookup::fnv1a64("a") == 0xaf63dc4c8601ec8cull, "fnv1a64: 公式テストベクタと一致");
+
+/**
+ * @brief 振り分け（1）: if の連鎖。キーが後ろにあるほど比較回数が増える。
+ * @param key std::string_view コマンド名
+ * @return commandId 見つからなければ unknown
+ */
+commandId dispatchWithIfChain(const std::string_view key) {
+  if (key == "get") return commandId::get;
+  if (key == "set") return commandId::set;
+  if (key == "del") return commandId::del;
+  if (key == "ping") return commandId::ping;
+  if (key == "status") return commandId::status;
+  if (key == "reboot") return commandId::reboot;
+  if (key == "ota") return commandId::ota;
+  if (key == "config") return commandId::config;
+  if (key == "log") return commandId::log;
+  if (key == "time") return commandId::time;
+  if (key == "led") return commandId::led;
+  if (key == "sensor") return commandId::sensor;
+  if (key == "wifi") return commandId::wifi;
+  if (key == "mqtt") return commandId::mqtt;
+  if (key == "help") return commandId::help;
+  if (key == "version") return commandId::version;
+  return commandId::unknown;
+}
+
+/**
+ * @brief 振り分け（2）: ハッシュ値で switch。`"get"_fnv` はコンパイル時に計算される定数。
+ * @details
+ * - ハッシュが一致しても別の文字列の可能性があるため、case の中で文字列も確認する。
+ * - 2つのキーのハッシュが衝突すると case の値が重複してコンパイルエラーになる（衝突に気付ける）。
+ * @param key std::string_view コマンド名
+ * @return commandId 見つからなければ unknown
+ */
+commandId dispatchWithHashSwitch(const std::string_view key) {
+  using namespace constexprLookup::literals;
+  const auto confirm = [key](const std::string_view expected, const commandId id) {
+    return key == expected ? id : commandId::unknown;
+  };
+  switch (constexprLookup::fnv1a64(key)) {
+    case "get"_fnv: return confirm("get", commandId::get);
+    case "set"_fnv: return confirm("set", commandId::set);
+    case "del"_fnv: return confirm("del", commandId::del);
+    case "ping"_fnv: return confirm("ping", commandId::ping);
+    case "status"_fnv: return confirm("status", commandId::status);
+    case "reboot"_fnv: return confirm("reboot", commandId::reboot);
+    case "ota"_fnv: return confirm("ota", commandId::ota);
+    case "config"_fnv: return confirm("config", commandId::config);
+    case "log"_fnv: return confirm("log", commandId::log);
+    case "time"_fnv: return confirm("time", commandId::time);
+    case "led"_fnv: return confirm("led", commandId::led);
+    case "sensor"_fnv: return confirm("sensor", commandId::sensor);
+    case "wifi"_fnv: return confirm("wifi", commandId::wifi);
+    case "mqtt"_fnv: return confirm("mqtt", commandId::mqtt);
+    case "help"_fnv: return confirm("help", commandId::help);
+    case "version"_fnv: return confirm("version", commandId::version);
+    default: return commandId::unknown;
+  }
+}
+
+/**
+ * @brief 振り分け（3）: コンパイル時に作った整列済み表を二分探索。
+ */
+commandId dispatchWithSortedTable(const std::string_view key) {
+  const commandId* const found = kCommandSortedTable.find(key);
+  return found != nullptr ? *found : commandId::unknown;
+}
+
+/**
+ * @brief 振り分け（4）: コンパイル時に作った完全ハッシュ表（ハッシュ1回 + 比較1回）。
+ */
+commandId dispatchWithPerfectHash(const std::string_view key) {
+  const commandId* const found = kCommandPerfectHash.find(key);
+  return found != nullptr ? *found : commandId::unknown;
+}
+
+/**
+ * @brief 振り分け（5）の表: 実行時に作る std::unordered_map（比較用。構築時に確保が発生する）。
+ * @return std::unordered_map<std::string, commandId> 表
+ */
+std::unordered_map<std::string, commandId> makeCommandUnorderedMap() {
+  std::unordered_map<std::string, commandId> table;
+  for (const auto& entry : kCommandEntries) {
+    table.emplace(std::string(entry.key), entry.value);
+  }
+  return table;
+}
+
+/**
+ * @brief コンパイル時ハッシュと表による振り分けの確認。
+ * @details
+ * - 5通りの振り分けが、既知/未知のキーで同じ結果になることを確認する（違えば例外）。
+ * - 完全ハッシュ表が見つけた種と枠数を表示する（どちらもコンパイル時に決まっている）。
+ * @return void
+ * @throws std::runtime_error 振り分け結果が一致しない場合
+ */
+void demonstrateCompileTimeLookup() {
+  printTitle("constexpr hash / lookup tables");
+  constexpr std::uint64_t kGetHash = constexprLookup::fnv1a64("get");  // コンパイル時に計算済み
+  std::cout << "fnv1a64(\"get\")=0x" << std::hex << kGetHash << " xxh32(\"get\")=0x" << constexprLookup::xxh32("get")
+            << std::dec << "\n";
+  std::cout << "perfectHashMap: keys=" << kCommandPerfectHash.size() << " slots=" << kCommandPerfectHash.kSlotCount
+            << " seed=" << kCommandPerfectHash.seed() << "\n";
+
+  const std::unordered_map<std::string, commandId> unorderedMap = makeCommandUnorderedMap();
+  const std::vector<std::string> samples{"ota", "version", "get", "gett", "", "reboot"};
+  for (const std::string& sample : samples) {
+    const commandId expected = dispatchWithIfChain(sample);
+    const auto mapFound = unorderedMap.find(sample);
+    const commandId fromMap = mapFound != unorderedMap.end() ? mapFound->second : commandId::unknown;
+    if (dispatchWithHashSwitch(sample) != expected || dispatchWithSortedTable(sample) != expected ||
+        dispatchWithPerfectHash(sample) != expected || fromMap != expected) {
+      throw std::runtime_error("demonstrateCompileTimeLookup: dispatch mismatch for \"" + sample + "\"");
+    }
+    std::cout << "key=\"" << sample << "\" -> id=" << static_cast<int>(expected)
+              << (expected == commandId::unknown ? " (unknown)" : "") << "\n";
+  }
+}
+
 /**
  * @brief C++17 サンプル全体の実行。
  * @details
@@ -226,6 +400,7 @@ void demonstrateIfConstexpr() {
  * - (1) 構造化束縛（分解代入）
  * - (2) if constexpr（型で分岐）
  * - (3) optional/string_view（失敗を型で表す）
+ * - (4) constexpr のハッシュと表（コマンド名の振り分け）
  * @return void
  */
 void runCpp17Samples() {
@@ -239,6 +414,130 @@ void runCpp17Samples() {
   demonstrateStructuredBindings();
   demonstrateIfConstexpr();
   demonstrateOptionalAndStringView();
+  demonstrateCompileTimeLookup();
+}
+
+/**
+ * @brief `std::from_chars`（C++17）で int に変換します（ベンチマーク比較用）。
+ * @details
+ * - `parseInt` と同じ入出力。`std::string` へのコピーも例外も無い。
+ * @param text std::string_view 変換対象
+ * @return std::optional<int> 成功時は値、失敗時は空
+ */
+std::optional<int> parseIntFromChars(const std::string_view text) {
+  int value = 0;
+  const char* const end = text.data() + text.size();
+  const auto [parsedEnd, errorCode] = std::from_chars(text.data(), end, value, 10);
+  if (errorCode != std::errc{} || parsedEnd != end) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - optional-parse: `parseInt`（stoi + try/catch）と `parseIntFromChars` を、同じトークン列で比べる。
+ * - substring     : 部分文字列を `std::string`（コピー）と `std::string_view`（参照だけ）で取り出して比べる。
+ * - keyword-dispatch: コマンド名 → commandId を、if 連鎖 / std::unordered_map / switch(ハッシュ) /
+ *   整列済み表（二分探索）/ 完全ハッシュ表 で比べる。入力の 1/8 は未知のキー。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerCpp17Kernels(benchHarness::kernelRegistry& registry) {
+  constexpr std::uint64_t kTokenCount = 1024;
+  auto tokens = std::make_shared<std::vector<std::string>>();
+  for (std::uint64_t i = 0; i < kTokenCount; ++i) {
+    tokens->push_back(std::to_string(static_cast<long long>(i * 7919 % 2000003) - 1000000));
+  }
+
+  registry.add("optional-parse", "stoi+try/catch", kTokenCount, [tokens]() {
+    long long sum = 0;
+    for (const std::string& token : *tokens) {
+      sum += parseInt(token).value_or(0);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("optional-parse", "from_chars", kTokenCount, [tokens]() {
+    long long sum = 0;
+    for (const std::string& token : *tokens) {
+      sum += parseIntFromChars(token).value_or(0);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+
+  // 短文字列最適化（SSO）に収まらない長さにして、コピー時の確保を見えるようにする。
+  auto sentence = std::make_shared<std::string>(4096, 'x');
+  constexpr std::size_t kSliceLength = 64;
+  constexpr std::uint64_t kSliceCount = 256;
+  registry.add("substring", "std::string-copy", kSliceCount, [sentence]() {
+    std::size_t total = 0;
+    for (std::uint64_t i = 0; i < kSliceCount; ++i) {
+      const std::string slice = sentence->substr(static_cast<std::size_t>(i) * 8, kSliceLength);
+      total += slice.size();
+    }
+    benchHarness::doNotOptimize(total);
+  });
+  registry.add("substring", "string_view", kSliceCount, [sentence]() {
+    const std::string_view whole(*sentence);
+    std::size_t total = 0;
+    for (std::uint64_t i = 0; i < kSliceCount; ++i) {
+      const std::string_view slice = whole.substr(static_cast<std::size_t>(i) * 8, kSliceLength);
+      benchHarness::doNotOptimize(slice.data());
+      total += slice.size();
+    }
+    benchHarness::doNotOptimize(total);
+  });
+
+  // 既知のキーを順に並べ、8個に1個は未知のキー（似た綴り）を混ぜる
+  constexpr std::uint64_t kKeywordCount = 1024;
+  const char* const unknownKeys[] = {"gett", "statu", "versions", "foo"};
+  auto keywords = std::make_shared<std::vector<std::string>>();
+  for (std::uint64_t i = 0; i < kKeywordCount; ++i) {
+    if (i % 8 == 7) {
+      keywords->push_back(unknownKeys[(i / 8) % 4]);
+    } else {
+      keywords->push_back(std::string(kCommandEntries[(i * 7) % std::size(kCommandEntries)].key));
+    }
+  }
+  auto unorderedMap = std::make_shared<const std::unordered_map<std::string, commandId>>(makeCommandUnorderedMap());
+
+  registry.add("keyword-dispatch", "if-chain", kKeywordCount, [keywords]() {
+    int sum = 0;
+    for (const std::string& keyword : *keywords) {
+      sum += static_cast<int>(dispatchWithIfChain(keyword));
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("keyword-dispatch", "unordered_map<string>", kKeywordCount, [keywords, unorderedMap]() {
+    int sum = 0;
+    for (const std::string& keyword : *keywords) {
+      const auto found = unorderedMap->find(keyword);
+      sum += static_cast<int>(found != unorderedMap->end() ? found->second : commandId::unknown);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("keyword-dispatch", "hash-switch", kKeywordCount, [keywords]() {
+    int sum = 0;
+    for (const std::string& keyword : *keywords) {
+      sum += static_cast<int>(dispatchWithHashSwitch(keyword));
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("keyword-dispatch", "sorted-table", kKeywordCount, [keywords]() {
+    int sum = 0;
+    for (const std::string& keyword : *keywords) {
+      sum += static_cast<int>(dispatchWithSortedTable(keyword));
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("keyword-dispatch", "perfect-hash", kKeywordCount, [keywords]() {
+    int sum = 0;
+    for (const std::string& keyword : *keywords) {
+      sum += static_cast<int>(dispatchWithPerfectHash(keyword));
+    }
+    benchHarness::doNotOptimize(sum);
+  });
 }
 
 #if 0
@@ -282,6 +581,10 @@ void runCpp17Samples() {
  */
 int main(const int argc, char** argv) {
   try {
+    const std::vector<std::string> args(argv, argv + argc);
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("cpp17", args, registerCpp17Kernels);
+    }
     std::cout << "[cpp17] args: " << joinArgs(argc, argv) << "\n";
     runCpp17Samples();
     return 0;
@@ -4,6 +4,10 @@
  * @details
  * - 目的: C++20 の中でも「読みやすさに直結」する機能を最小例で確認する。
  * - 主な題材: `concepts` / `std::span` / `constinit`
+ * - 応用: `constinit` の完全ハッシュ表（constexprLookup.h）と、関数内 static の std::unordered_map を比べる
+ *   （`--bench --bench-filter route-lookup`）
+ * - 応用: `--parallel-compare` で sum / transform-reduce / sort / copy_if を、手書きループ・実行ポリシー
+ *   （seq / par / par_unseq）・ranges・スレッドプール分割で比べ、スレッド数ごとの伸び（scaling）を表示する
  * - C言語経験者向け補足:
  *   - `std::span<T>` は「ポインタ + 長さ」を安全に束ねた参照ビューです。
  *     Cでよくある `int* p, size_t n` の組を、型としてまとめるイメージ。
@@ -13,15 +17,39 @@
  * @note [厳守] C++20 以上でコンパイルすること（例: clang++ -std=c++20 / g++ -std=c++20）。
  */
 
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <chrono>
 #include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <ranges>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <span>
+#include <string_view>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include <version>
+#if __has_include(<execution>)
+#include <execution>
+#endif
+
+#include "benchHarness.h"
+#include "constexprLookup.h"
 
 namespace {
 
@@ -86,6 +114,42 @@ void printTitle(const std::string& title) {
 // [推奨] 初期化順問題の対策として有用（ただし万能ではない）。
 constinit int globalCounter = 0;
 
+/**
+ * @brief MQTT トピックの末尾（ルート名）→ 処理番号 の完全ハッシュ表。
+ * @details
+ * - [重要] `constinit` なので、表の構築（種の探索を含む）はすべてコンパイル時に終わり、実行時の初期化コードも
+ *   「初回呼び出し時の初期化済み判定（関数内 static のガード）」も無い。
+ * - キーの重複や種が見つからない場合は、ここがコンパイルエラーになる。
+ */
+constinit const auto kRouteTable = constexprLookup::makePerfectHashMap<int>({
+    {"cmd/ping", 1},       {"cmd/reboot", 2},      {"cmd/ota", 3},        {"cmd/config/get", 4},
+    {"cmd/config/set", 5}, {"cmd/log/level", 6},   {"cmd/time/sync", 7},  {"cmd/led/set", 8},
+    {"cmd/sensor/read", 9}, {"cmd/wifi/scan", 10}, {"cmd/mqtt/reconnect", 11}, {"cmd/version", 12}});
+
+/**
+ * @brief 比較用: 関数内 static の std::unordered_map（初回呼び出しで構築され、以降は毎回ガードの確認が入る）。
+ * @param route std::string_view ルート名
+ * @return int 処理番号（見つからなければ 0）
+ */
+int findRouteWithStaticMap(const std::string_view route) {
+  static const std::unordered_map<std::string_view, int> table{
+      {"cmd/ping", 1},       {"cmd/reboot", 2},      {"cmd/ota", 3},        {"cmd/config/get", 4},
+      {"cmd/config/set", 5}, {"cmd/log/level", 6},   {"cmd/time/sync", 7},  {"cmd/led/set", 8},
+      {"cmd/sensor/read", 9}, {"cmd/wifi/scan", 10}, {"cmd/mqtt/reconnect", 11}, {"cmd/version", 12}};
+  const auto found = table.find(route);
+  return found != table.end() ? found->second : 0;
+}
+
+/**
+ * @brief constinit の完全ハッシュ表でルートを探します。
+ * @param route std::string_view ルート名
+ * @return int 処理番号（見つからなければ 0）
+ */
+int findRouteWithConstinitTable(const std::string_view route) {
+  const int* const found = kRouteTable.find(route);
+  return found != nullptr ? *found : 0;
+}
+
 /**
  * @brief 足し算可能な「整数型」を表す concept。
  * @details
@@ -197,6 +261,14 @@ void runCpp20Samples() {
   std::cout << "globalCounter(before)=" << globalCounter << "\n";
   globalCounter += 1;
   std::cout << "globalCounter(after)=" << globalCounter << "\n";
+  std::cout << "kRouteTable: routes=" << kRouteTable.size() << " seed=" << kRouteTable.seed() << "\n";
+  for (const std::string_view route : {"cmd/ota", "cmd/version", "cmd/otax"}) {
+    const int fromTable = findRouteWithConstinitTable(route);
+    if (fromTable != findRouteWithStaticMap(route)) {
+      throw std::runtime_error("runCpp20Samples: route lookup mismatch");
+    }
+    std::cout << "route=\"" << route << "\" -> " << fromTable << (fromTable == 0 ? " (unknown)" : "") << "\n";
+  }
 
   printTitle("concepts");
   const int x = addValues<int>(10, 20);
@@ -210,6 +282,741 @@ void runCpp20Samples() {
   std::cout << "sumSpan(vector)=" << sumSpan(std::span<const int>(vectorValues.data(), vectorValues.size())) << "\n";
 }
 
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - span-sum: 同じ配列の合計を `std::span`（sumSpan）、`const std::vector&`、ポインタ+長さで比べる。
+ *   span は「ポインタ+長さ」そのものなので、最適化ありなら差が出ない想定。
+ * - route-lookup: ルート名の検索を、constinit の完全ハッシュ表と関数内 static の std::unordered_map で比べる。
+ *   入力の 1/4 は未知のルート。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerCpp20Kernels(benchHarness::kernelRegistry& registry) {
+  constexpr std::uint64_t kElementCount = 4096;
+  auto values = std::make_shared<std::vector<int>>(kElementCount);
+  for (std::uint64_t i = 0; i < kElementCount; ++i) {
+    (*values)[i] = static_cast<int>(i % 100);
+  }
+
+  registry.add("span-sum", "std::span", kElementCount, [values]() {
+    benchHarness::clobberMemory();
+    benchHarness::doNotOptimize(sumSpan(*values));
+  });
+  registry.add("span-sum", "const-vector-ref", kElementCount, [values]() {
+    benchHarness::clobberMemory();
+    const std::vector<int>& ref = *values;
+    int sum = 0;
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+      sum += ref[i];
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("span-sum", "pointer+length", kElementCount, [values]() {
+    benchHarness::clobberMemory();
+    const int* const data = values->data();
+    const std::size_t length = values->size();
+    int sum = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+      sum += data[i];
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+
+  constexpr std::uint64_t kRouteCount = 1024;
+  const std::string_view knownRoutes[] = {"cmd/ping", "cmd/ota", "cmd/config/set", "cmd/sensor/read",
+                                          "cmd/wifi/scan", "cmd/mqtt/reconnect"};
+  auto routes = std::make_shared<std::vector<std::string>>();
+  for (std::uint64_t i = 0; i < kRouteCount; ++i) {
+    routes->push_back(i % 4 == 3 ? "cmd/unknown/" + std::to_string(i % 16)
+                                 : std::string(knownRoutes[i % std::size(knownRoutes)]));
+  }
+
+  registry.add("route-lookup", "constinit-perfect-hash", kRouteCount, [routes]() {
+    int sum = 0;
+    for (const std::string& route : *routes) {
+      sum += findRouteWithConstinitTable(route);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("route-lookup", "static-unordered_map", kRouteCount, [routes]() {
+    int sum = 0;
+    for (const std::string& route : *routes) {
+      sum += findRouteWithStaticMap(route);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+}
+
+// ---------------------------------------------------------------------------
+// 並列アルゴリズムの比較（--parallel-compare）
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 使われている並列アルゴリズムの実装（バックエンド）の表示名。
+ * @details
+ * - [注意] libstdc++（g++）は TBB のヘッダーがあれば TBB で並列化し、無ければ par / par_unseq も1スレッドで動く。
+ *   TBB を使う場合は `-ltbb` でリンクする（INSTALL.md 参照）。
+ * @return const char* 表示名
+ */
+const char* executionBackendLabel() {
+#if !defined(__cpp_lib_parallel_algorithm)
+  return "none (<execution> 未対応のため seq/par/par_unseq は省略)";
+#elif defined(_PSTL_PAR_BACKEND_TBB)
+  return "libstdc++ PSTL + TBB";
+#elif defined(_PSTL_PAR_BACKEND_SERIAL)
+  return "libstdc++ PSTL serial (TBB 無し: par/par_unseq も1スレッド)";
+#elif defined(_MSC_VER)
+  return "MSVC STL (Windows スレッドプール)";
+#else
+  return "implementation-defined";
+#endif
+}
+
+/**
+ * @brief 固定数のスレッドで「タスク番号 0..N-1」を分け合って実行する、最小のスレッドプール。
+ * @details
+ * - [重要] スレッドは構築時に1回だけ作る（計測のたびに std::thread を作る費用を含めないため）。
+ * - run() は全タスクの完了まで待つ。タスクが例外を投げた場合は、最初の1つを run() の呼び出し元へ投げ直す。
+ * - [制限] run() を複数スレッドから同時に呼ばないこと（計測用の単純な作り）。
+ */
+class threadPool {
+ public:
+  /**
+   * @brief スレッドを作ります。
+   * @param threadCount unsigned スレッド数（1以上）
+   * @throws std::invalid_argument threadCount が 0 の場合
+   */
+  explicit threadPool(const unsigned threadCount) {
+    if (threadCount == 0) {
+      throw std::invalid_argument("threadPool: threadCount must be positive");
+    }
+    workers_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+      workers_.emplace_back([this]() { workerLoop(); });
+    }
+  }
+
+  threadPool(const threadPool&) = delete;
+  threadPool& operator=(const threadPool&) = delete;
+
+  /** @brief 停止を伝えて全スレッドを join します。 */
+  ~threadPool() {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /** @brief スレッド数。 */
+  unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+  /**
+   * @brief task(0) .. task(taskCount-1) を空いているスレッドで実行し、全部終わるまで待ちます。
+   * @param taskCount std::size_t タスク数
+   * @param task const std::function<void(std::size_t)>& タスク（引数はタスク番号）
+   * @return void
+   */
+  void run(const std::size_t taskCount, const std::function<void(std::size_t)>& task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    taskCount_ = taskCount;
+    nextTask_ = 0;
+    finishedTasks_ = 0;
+    error_ = nullptr;
+    wake_.notify_all();
+    done_.wait(lock, [this]() { return finishedTasks_ == taskCount_; });
+    task_ = nullptr;
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+ private:
+  void workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this]() { return stopping_ || (task_ != nullptr && nextTask_ < taskCount_); });
+      if (stopping_) {
+        return;
+      }
+      const std::size_t index = nextTask_++;
+      const std::function<void(std::size_t)>* const task = task_;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        (*task)(index);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error && !error_) {
+        error_ = error;
+      }
+      if (++finishedTasks_ == taskCount_) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(std::size_t)>* task_ = nullptr;
+  std::size_t taskCount_ = 0;
+  std::size_t nextTask_ = 0;
+  std::size_t finishedTasks_ = 0;
+  std::exception_ptr error_;
+  bool stopping_ = false;
+};
+
+/**
+ * @brief 比べる処理。
+ */
+enum class parallelOperation { sum, transformReduce, sort, copyIf };
+
+/**
+ * @brief 比べる書き方。
+ */
+enum class parallelVariant { loop, executionSeq, executionPar, executionParUnseq, ranges, threadPool };
+
+/**
+ * @brief `--parallel-compare` のオプション。
+ */
+struct parallelCompareOptions {
+  std::uint64_t elementCount = 10'000'000;
+  std::vector<unsigned> threadCounts;  // thread-pool で試すスレッド数（既定: 1,2,4,... とハードウェアのスレッド数）
+  std::vector<parallelOperation> operations{parallelOperation::sum, parallelOperation::transformReduce,
+                                            parallelOperation::sort, parallelOperation::copyIf};
+  unsigned repeatCount = 3;
+};
+
+/** @brief 処理の表示名（`--ops` の値と同じ）。 */
+const char* toOperationLabel(const parallelOperation operation) {
+  switch (operation) {
+    case parallelOperation::sum: return "sum";
+    case parallelOperation::transformReduce: return "transform-reduce";
+    case parallelOperation::sort: return "sort";
+    case parallelOperation::copyIf: return "copy_if";
+  }
+  return "?";
+}
+
+/** @brief 書き方の表示名。 */
+const char* toVariantLabel(const parallelVariant variant) {
+  switch (variant) {
+    case parallelVariant::loop: return "loop";
+    case parallelVariant::executionSeq: return "std::execution::seq";
+    case parallelVariant::executionPar: return "std::execution::par";
+    case parallelVariant::executionParUnseq: return "std::execution::par_unseq";
+    case parallelVariant::ranges: return "ranges";
+    case parallelVariant::threadPool: return "thread-pool";
+  }
+  return "?";
+}
+
+/** @brief copy_if の条件（偶数だけ残す。乱数なので約半分が残る）。 */
+constexpr bool isEvenValue(const std::int32_t value) { return value % 2 == 0; }
+
+/** @brief transform-reduce の変換（2乗。int64 に広げてから掛けるので桁あふれしない）。 */
+constexpr std::int64_t squareValue(const std::int32_t value) {
+  return static_cast<std::int64_t>(value) * static_cast<std::int64_t>(value);
+}
+
+/**
+ * @brief 並びも含めた指紋（sort / copy_if の結果が基準と同じかを、全体を保存せずに確かめる）。
+ * @param values std::span<const std::int32_t> 結果
+ * @return std::uint64_t Σ value * (位置+1)（2^64 で折り返す）
+ */
+std::uint64_t orderedFingerprint(const std::span<const std::int32_t> values) {
+  std::uint64_t fingerprint = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    fingerprint += static_cast<std::uint64_t>(static_cast<std::int64_t>(values[i])) * (i + 1);
+  }
+  return fingerprint ^ values.size();
+}
+
+/**
+ * @brief 入力を作ります（位置から値を決めるので、毎回同じ内容。値は -1,000,000..1,000,000）。
+ * @param elementCount std::uint64_t 要素数
+ * @return std::vector<std::int32_t> 入力
+ */
+std::vector<std::int32_t> makeParallelInput(const std::uint64_t elementCount) {
+  std::vector<std::int32_t> values(static_cast<std::size_t>(elementCount));
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    // splitmix64 の混ぜ方（乱数表を持たずに、位置ごとにばらけた値を作る）
+    std::uint64_t mixed = (static_cast<std::uint64_t>(i) + 1) * 0x9E3779B97F4A7C15ull;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+    mixed ^= mixed >> 31;
+    values[i] = static_cast<std::int32_t>(mixed % 2'000'001ull) - 1'000'000;
+  }
+  return values;
+}
+
+/**
+ * @brief [begin, end) を partCount 個にほぼ均等に分けたときの、part 番目の範囲。
+ * @return std::pair<std::size_t, std::size_t> {開始, 終了}
+ */
+std::pair<std::size_t, std::size_t> partitionRange(const std::size_t length, const std::size_t partCount,
+                                                   const std::size_t part) {
+  return {length * part / partCount, length * (part + 1) / partCount};
+}
+
+/**
+ * @brief (1) 手書きのループ（sort だけは std::sort を基準にする）。
+ * @return std::uint64_t sum / transform-reduce は結果、copy_if は残した個数、sort は 0
+ */
+std::uint64_t executeWithLoop(const parallelOperation operation, const std::span<const std::int32_t> input,
+                              std::vector<std::int32_t>& scratch) {
+  switch (operation) {
+    case parallelOperation::sum: {
+      std::int64_t total = 0;
+      for (const std::int32_t value : input) {
+        total += value;
+      }
+      return static_cast<std::uint64_t>(total);
+    }
+    case parallelOperation::transformReduce: {
+      std::int64_t total = 0;
+      for (const std::int32_t value : input) {
+        total += squareValue(value);
+      }
+      return static_cast<std::uint64_t>(total);
+    }
+    case parallelOperation::sort:
+      std::sort(scratch.begin(), scratch.end());
+      return 0;
+    case parallelOperation::copyIf: {
+      std::size_t kept = 0;
+      for (const std::int32_t value : input) {
+        if (isEvenValue(value)) {
+          scratch[kept++] = value;
+        }
+      }
+      return kept;
+    }
+  }
+  return 0;
+}
+
+#if defined(__cpp_lib_parallel_algorithm)
+/**
+ * @brief (2) `<algorithm>` + 実行ポリシー（seq / par / par_unseq）。
+ * @tparam Policy 実行ポリシーの型
+ * @return std::uint64_t executeWithLoop と同じ意味
+ */
+template <typename Policy>
+std::uint64_t executeWithPolicy(const Policy& policy, const parallelOperation operation,
+                                const std::span<const std::int32_t> input, std::vector<std::int32_t>& scratch) {
+  switch (operation) {
+    case parallelOperation::sum:
+      return static_cast<std::uint64_t>(std::reduce(policy, input.begin(), input.end(), std::int64_t{0}));
+    case parallelOperation::transformReduce:
+      return static_cast<std::uint64_t>(
+          std::transform_reduce(policy, input.begin(), input.end(), std::int64_t{0}, std::plus<>{}, squareValue));
+    case parallelOperation::sort:
+      std::sort(policy, scratch.begin(), scratch.end());
+      return 0;
+    case parallelOperation::copyIf: {
+      const auto end = std::copy_if(policy, input.begin(), input.end(), scratch.begin(), isEvenValue);
+      return static_cast<std::uint64_t>(end - scratch.begin());
+    }
+  }
+  return 0;
+}
+#endif
+
+/**
+ * @brief (3) C++20 ranges のパイプライン（views::transform / views::filter、ranges::sort）。
+ * @details
+ * - [注意] C++20 の ranges には reduce/fold が無い（fold_left は C++23）ので、合計は range-for で受ける。
+ * @return std::uint64_t executeWithLoop と同じ意味
+ */
+std::uint64_t executeWithRanges(const parallelOperation operation, const std::span<const std::int32_t> input,
+                                std::vector<std::int32_t>& scratch) {
+  switch (operation) {
+    case parallelOperation::sum: {
+      std::int64_t total = 0;
+      for (const std::int64_t value : input | std::views::transform([](const std::int32_t v) { return std::int64_t{v}; })) {
+        total += value;
+      }
+      return static_cast<std::uint64_t>(total);
+    }
+    case parallelOperation::transformReduce: {
+      std::int64_t total = 0;
+      for (const std::int64_t value : input | std::views::transform(squareValue)) {
+        total += value;
+      }
+      return static_cast<std::uint64_t>(total);
+    }
+    case parallelOperation::sort:
+      std::ranges::sort(scratch);
+      return 0;
+    case parallelOperation::copyIf: {
+      const auto result = std::ranges::copy(input | std::views::filter(isEvenValue), scratch.begin());
+      return static_cast<std::uint64_t>(result.out - scratch.begin());
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief (4) スレッドプールで明示的に分割。
+ * @details
+ * - sum / transform-reduce: スレッド数に分けて部分和を作り、最後に足す。部分和は 64byte ごとに置き、偽共有を避ける。
+ * - sort: 各区間を並列に std::sort → 隣どうしを std::inplace_merge で併合（1段ごとに並列、段数は log2(区間数)）。
+ *   [注意] 最後の段は1スレッドで全体を併合するため、スレッドを増やしても伸びが頭打ちになりやすい。
+ * - copy_if: 1回目で区間ごとの個数を数え、累積和で書き込み位置を決め、2回目で並列にコピーする（入力順を保つ）。
+ * @return std::uint64_t executeWithLoop と同じ意味
+ */
+std::uint64_t executeWithThreadPool(threadPool& pool, const parallelOperation operation,
+                                    const std::span<const std::int32_t> input, std::vector<std::int32_t>& scratch) {
+  struct alignas(64) paddedPartial {
+    std::int64_t value = 0;
+  };
+  const std::size_t partCount = pool.size();
+  switch (operation) {
+    case parallelOperation::sum:
+    case parallelOperation::transformReduce: {
+      std::vector<paddedPartial> partials(partCount);
+      const bool isSquare = operation == parallelOperation::transformReduce;
+      pool.run(partCount, [&](const std::size_t part) {
+        const auto [begin, end] = partitionRange(input.size(), partCount, part);
+        std::int64_t total = 0;
+        // ループの中で分岐させるとベクトル化されにくいため、ループごと分ける
+        if (isSquare) {
+          for (std::size_t i = begin; i < end; ++i) {
+            total += squareValue(input[i]);
+          }
+        } else {
+          for (std::size_t i = begin; i < end; ++i) {
+            total += input[i];
+          }
+        }
+        partials[part].value = total;
+      });
+      std::int64_t total = 0;
+      for (const paddedPartial& partial : partials) {
+        total += partial.value;
+      }
+      return static_cast<std::uint64_t>(total);
+    }
+    case parallelOperation::sort: {
+      pool.run(partCount, [&](const std::size_t part) {
+        const auto [begin, end] = partitionRange(scratch.size(), partCount, part);
+        std::sort(scratch.begin() + static_cast<std::ptrdiff_t>(begin), scratch.begin() + static_cast<std::ptrdiff_t>(end));
+      });
+      for (std::size_t width = 1; width < partCount; width *= 2) {
+        const std::size_t mergeCount = (partCount + 2 * width - 1) / (2 * width);
+        pool.run(mergeCount, [&](const std::size_t merge) {
+          const std::size_t firstPart = merge * 2 * width;
+          const std::size_t middlePart = std::min(firstPart + width, partCount);
+          const std::size_t lastPart = std::min(firstPart + 2 * width, partCount);
+          if (middlePart == lastPart) {
+            return;  // 相手がいない（区間数が2の冪でない時の端）
+          }
+          const auto at = [&](const std::size_t part) {
+            return scratch.begin() + static_cast<std::ptrdiff_t>(partitionRange(scratch.size(), partCount, part).first);
+          };
+          const auto last = lastPart == partCount ? scratch.end() : at(lastPart);
+          std::inplace_merge(at(firstPart), at(middlePart), last);
+        });
+      }
+      return 0;
+    }
+    case parallelOperation::copyIf: {
+      std::vector<std::size_t> offsets(partCount + 1, 0);
+      pool.run(partCount, [&](const std::size_t part) {
+        const auto [begin, end] = partitionRange(input.size(), partCount, part);
+        offsets[part + 1] = static_cast<std::size_t>(
+            std::count_if(input.begin() + static_cast<std::ptrdiff_t>(begin), input.begin() + static_cast<std::ptrdiff_t>(end),
+                          isEvenValue));
+      });
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+      pool.run(partCount, [&](const std::size_t part) {
+        const auto [begin, end] = partitionRange(input.size(), partCount, part);
+        std::copy_if(input.begin() + static_cast<std::ptrdiff_t>(begin), input.begin() + static_cast<std::ptrdiff_t>(end),
+                     scratch.begin() + static_cast<std::ptrdiff_t>(offsets[part]), isEvenValue);
+      });
+      return offsets[partCount];
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief 1回分の実行（準備は計測に含めない）。
+ * @param pool threadPool* thread-pool のときだけ使う
+ * @return std::uint64_t 結果の指紋（書き方が違っても同じ処理なら一致する）
+ */
+std::uint64_t runParallelOnce(const parallelOperation operation, const parallelVariant variant,
+                              const std::span<const std::int32_t> input, std::vector<std::int32_t>& scratch,
+                              threadPool* const pool, double& elapsedMs) {
+  if (operation == parallelOperation::sort) {
+    std::copy(input.begin(), input.end(), scratch.begin());  // 並べ替える前の状態に戻す（計測外）
+  }
+  const auto start = std::chrono::steady_clock::now();
+  std::uint64_t value = 0;
+  switch (variant) {
+    case parallelVariant::loop:
+      value = executeWithLoop(operation, input, scratch);
+      break;
+#if defined(__cpp_lib_parallel_algorithm)
+    case parallelVariant::executionSeq:
+      value = executeWithPolicy(std::execution::seq, operation, input, scratch);
+      break;
+    case parallelVariant::executionPar:
+      value = executeWithPolicy(std::execution::par, operation, input, scratch);
+      break;
+    case parallelVariant::executionParUnseq:
+      value = executeWithPolicy(std::execution::par_unseq, operation, input, scratch);
+      break;
+#else
+    case parallelVariant::executionSeq:
+    case parallelVariant::executionPar:
+    case parallelVariant::executionParUnseq:
+      throw std::runtime_error("runParallelOnce: execution policies are not available in this standard library");
+#endif
+    case parallelVariant::ranges:
+      value = executeWithRanges(operation, input, scratch);
+      break;
+    case parallelVariant::threadPool:
+      value = executeWithThreadPool(*pool, operation, input, scratch);
+      break;
+  }
+  elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  switch (operation) {
+    case parallelOperation::sum:
+    case parallelOperation::transformReduce:
+      return value;
+    case parallelOperation::sort:
+      return orderedFingerprint(scratch);
+    case parallelOperation::copyIf:
+      return orderedFingerprint(std::span<const std::int32_t>(scratch.data(), static_cast<std::size_t>(value)));
+  }
+  return 0;
+}
+
+/**
+ * @brief 1つの書き方を repeatCount 回測り、中央値を返します（結果が基準と違えば例外）。
+ * @param expected std::optional<std::uint64_t>& 基準の指紋（空なら今回の結果を基準にする）
+ * @return double 中央値 [ms]
+ * @throws std::runtime_error 結果が基準と一致しない場合
+ */
+double measureParallelVariant(const parallelOperation operation, const parallelVariant variant,
+                              const std::span<const std::int32_t> input, std::vector<std::int32_t>& scratch,
+                              threadPool* const pool, const unsigned repeatCount, std::optional<std::uint64_t>& expected) {
+  std::vector<double> samples;
+  for (unsigned i = 0; i < repeatCount; ++i) {
+    double elapsedMs = 0.0;
+    const std::uint64_t fingerprint = runParallelOnce(operation, variant, input, scratch, pool, elapsedMs);
+    if (!expected.has_value()) {
+      expected = fingerprint;
+    } else if (*expected != fingerprint) {
+      throw std::runtime_error(std::string("measureParallelVariant: result mismatch operation=") +
+                               toOperationLabel(operation) + " variant=" + toVariantLabel(variant));
+    }
+    samples.push_back(elapsedMs);
+  }
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+/**
+ * @brief 表の1行を表示します。
+ * @param threadsLabel std::string "1" / "4" / "auto" など
+ * @param threadCount unsigned 効率の計算に使うスレッド数（0 なら効率を表示しない）
+ * @return void
+ */
+void printParallelRow(const parallelVariant variant, const std::string& threadsLabel, const unsigned threadCount,
+                      const double medianMs, const double baselineMs, const std::uint64_t elementCount) {
+  const double seconds = medianMs / 1000.0;
+  const double megaElementsPerSecond = seconds > 0.0 ? static_cast<double>(elementCount) / seconds / 1e6 : 0.0;
+  const double gigabytesPerSecond =
+      seconds > 0.0 ? static_cast<double>(elementCount * sizeof(std::int32_t)) / seconds / 1e9 : 0.0;
+  const double speedup = medianMs > 0.0 ? baselineMs / medianMs : 0.0;
+  std::cout << "  " << std::left << std::setw(27) << toVariantLabel(variant) << std::right << std::setw(7) << threadsLabel
+            << std::fixed << std::setprecision(2) << std::setw(12) << medianMs << std::setw(12) << megaElementsPerSecond
+            << std::setw(9) << gigabytesPerSecond << std::setw(9) << speedup << "x";
+  if (threadCount != 0) {
+    std::cout << std::setw(9) << std::setprecision(0) << (speedup / threadCount * 100.0) << "%";
+  }
+  std::cout << std::defaultfloat << std::setprecision(6) << "\n";
+}
+
+/**
+ * @brief 正の整数を読み取ります（`--elements` / `--threads` / `--repeat` 用）。
+ * @return std::optional<std::uint64_t> 正の整数でなければ空
+ */
+std::optional<std::uint64_t> parsePositiveInteger(const std::string& text) {
+  std::uint64_t value = 0;
+  const auto [end, errorCode] = std::from_chars(text.data(), text.data() + text.size(), value, 10);
+  if (text.empty() || errorCode != std::errc{} || end != text.data() + text.size() || value == 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/**
+ * @brief カンマ区切りの文字列を分けます。
+ */
+std::vector<std::string> splitCommaList(const std::string& text) {
+  std::vector<std::string> items;
+  std::size_t start = 0;
+  while (start <= text.size()) {
+    const std::size_t comma = std::min(text.find(',', start), text.size());
+    items.push_back(text.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return items;
+}
+
+/**
+ * @brief `--parallel-compare` / `--elements` / `--threads` / `--ops` / `--repeat` を読み取ります。
+ * @param args std::vector<std::string> コマンドライン引数
+ * @return std::optional<parallelCompareOptions> `--parallel-compare` が無ければ空
+ * @throws std::runtime_error 値が不正な場合
+ */
+std::optional<parallelCompareOptions> parseParallelCompareOptions(const std::vector<std::string>& args) {
+  if (std::find(args.begin(), args.end(), "--parallel-compare") == args.end()) {
+    return std::nullopt;
+  }
+  const auto valueOf = [&args](const std::string& name) -> std::optional<std::string> {
+    const auto it = std::find(args.begin(), args.end(), name);
+    if (it == args.end()) {
+      return std::nullopt;
+    }
+    if (std::next(it) == args.end()) {
+      throw std::runtime_error("parseParallelCompareOptions: missing value for " + name);
+    }
+    return *std::next(it);
+  };
+
+  parallelCompareOptions options;
+  if (const std::optional<std::string> text = valueOf("--elements"); text.has_value()) {
+    const std::optional<std::uint64_t> value = parsePositiveInteger(*text);
+    if (!value.has_value()) {
+      throw std::runtime_error("parseParallelCompareOptions: invalid --elements \"" + *text + "\" (expected: positive integer)");
+    }
+    options.elementCount = *value;
+  }
+  if (const std::optional<std::string> text = valueOf("--repeat"); text.has_value()) {
+    const std::optional<std::uint64_t> value = parsePositiveInteger(*text);
+    if (!value.has_value() || *value > 1000) {
+      throw std::runtime_error("parseParallelCompareOptions: invalid --repeat \"" + *text + "\" (expected: 1..1000)");
+    }
+    options.repeatCount = static_cast<unsigned>(*value);
+  }
+  if (const std::optional<std::string> text = valueOf("--threads"); text.has_value()) {
+    for (const std::string& item : splitCommaList(*text)) {
+      const std::optional<std::uint64_t> value = parsePositiveInteger(item);
+      if (!value.has_value() || *value > 1024) {
+        throw std::runtime_error("parseParallelCompareOptions: invalid --threads \"" + *text + "\" (expected: e.g. 1,2,4,8)");
+      }
+      options.threadCounts.push_back(static_cast<unsigned>(*value));
+    }
+  } else {
+    const unsigned hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned count = 1; count < hardwareThreads; count *= 2) {
+      options.threadCounts.push_back(count);
+    }
+    options.threadCounts.push_back(hardwareThreads);
+  }
+  if (const std::optional<std::string> text = valueOf("--ops"); text.has_value()) {
+    options.operations.clear();
+    for (const std::string& item : splitCommaList(*text)) {
+      const parallelOperation all[] = {parallelOperation::sum, parallelOperation::transformReduce, parallelOperation::sort,
+                                       parallelOperation::copyIf};
+      const auto found = std::find_if(std::begin(all), std::end(all),
+                                      [&item](const parallelOperation operation) { return item == toOperationLabel(operation); });
+      if (found == std::end(all)) {
+        throw std::runtime_error("parseParallelCompareOptions: invalid --ops \"" + item +
+                                 "\" (expected: sum,transform-reduce,sort,copy_if)");
+      }
+      options.operations.push_back(*found);
+    }
+  }
+  return options;
+}
+
+/**
+ * @brief 並列アルゴリズムの比較（`--parallel-compare`）を実行します。
+ * @details
+ * - 処理ごとに、予熱を1回行ってから loop（1スレッドの基準）→ seq / par / par_unseq → ranges → thread-pool（スレッド数ごと）の順に測る。
+ * - 表示: 中央値 [ms]、M elem/s、GB/s（入力 int32 のバイト数基準）、loop に対する速度比、
+ *   thread-pool はスレッドあたりの効率（速度比 / スレッド数）も表示する。
+ * - 全ての書き方の結果（合計、または並びを含めた指紋）が loop と一致しない場合は例外で止める。
+ * - [注意] 時間に入力の生成と、sort 前の入力のコピーは含めない。
+ * @param options const parallelCompareOptions& オプション
+ * @return void
+ * @throws std::runtime_error 結果が一致しない / メモリが足りない場合
+ */
+void runParallelCompare(const parallelCompareOptions& options) {
+  const std::uint64_t bytes = options.elementCount * sizeof(std::int32_t);
+  printTitle("parallel algorithms compare");
+  std::cout << "elements=" << options.elementCount << " memory≈" << (bytes * 2 / (1024 * 1024))
+            << "MiB (input + scratch) repeat=" << options.repeatCount
+            << " hardware_concurrency=" << std::thread::hardware_concurrency() << "\n";
+  std::cout << "execution backend: " << executionBackendLabel() << "\n";
+
+  std::vector<std::int32_t> input;
+  std::vector<std::int32_t> scratch;
+  try {
+    input = makeParallelInput(options.elementCount);
+    scratch.resize(input.size());
+  } catch (const std::bad_alloc&) {
+    throw std::runtime_error("runParallelCompare: not enough memory for --elements " +
+                             std::to_string(options.elementCount));
+  }
+
+  std::vector<std::unique_ptr<threadPool>> pools;
+  for (const unsigned threadCount : options.threadCounts) {
+    pools.push_back(std::make_unique<threadPool>(threadCount));
+  }
+
+  std::vector<parallelVariant> variants{parallelVariant::loop};
+#if defined(__cpp_lib_parallel_algorithm)
+  variants.insert(variants.end(),
+                  {parallelVariant::executionSeq, parallelVariant::executionPar, parallelVariant::executionParUnseq});
+#endif
+  variants.push_back(parallelVariant::ranges);
+
+  for (const parallelOperation operation : options.operations) {
+    std::cout << "\n[" << toOperationLabel(operation) << "]\n";
+    std::cout << "  " << std::left << std::setw(27) << "variant" << std::right << std::setw(7) << "threads"
+              << std::setw(12) << "median ms" << std::setw(12) << "M elem/s" << std::setw(9) << "GB/s" << std::setw(10)
+              << "speedup" << std::setw(10) << "effic." << "\n";
+    // 予熱（1回目だけキャッシュ/TLB が冷えていて遅くなるのを、最初に測る loop に押し付けない）。結果は基準にする
+    double warmupMs = 0.0;
+    std::optional<std::uint64_t> expected =
+        runParallelOnce(operation, parallelVariant::loop, input, scratch, nullptr, warmupMs);
+    double baselineMs = 0.0;
+    for (const parallelVariant variant : variants) {
+      const double medianMs =
+          measureParallelVariant(operation, variant, input, scratch, nullptr, options.repeatCount, expected);
+      if (variant == parallelVariant::loop) {
+        baselineMs = medianMs;
+      }
+      const bool isParallelPolicy =
+          variant == parallelVariant::executionPar || variant == parallelVariant::executionParUnseq;
+      printParallelRow(variant, isParallelPolicy ? "auto" : "1", 0, medianMs, baselineMs, options.elementCount);
+    }
+    for (const std::unique_ptr<threadPool>& pool : pools) {
+      const double medianMs = measureParallelVariant(operation, parallelVariant::threadPool, input, scratch, pool.get(),
+                                                     options.repeatCount, expected);
+      printParallelRow(parallelVariant::threadPool, std::to_string(pool->size()), pool->size(), medianMs, baselineMs,
+                       options.elementCount);
+    }
+  }
+}
+
 #if 0
 // ---------------------------------------------------------------------------
 // [悪い例/良い例] よくある間違いの対比（ビルドが通らない例は #if 0 に閉じ込める）
@@ -241,6 +1048,14 @@ void runCpp20Samples() {
  */
 int main(const int argc, char** argv) {
   try {
+    const std::vector<std::string> args(argv, argv + argc);
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("cpp20", args, registerCpp20Kernels);
+    }
+    if (const std::optional<parallelCompareOptions> options = parseParallelCompareOptions(args); options.has_value()) {
+      runParallelCompare(*options);
+      return 0;
+    }
     std::cout << "[cpp20] args: " << joinArgs(argc, argv) << "\n";
     runCpp20Samples();
     return 0;
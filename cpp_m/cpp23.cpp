@@ -12,12 +12,15 @@
  * @note [推奨] 未対応マクロがあっても焦らず、コンパイラ/標準ライブラリのバージョン差だと理解する。
  */
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "benchHarness.h"
+
 namespace {
 
 /**
@@ -246,6 +249,63 @@ void runCpp23Samples() {
 #endif
 }
 
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - member-call: 従来のメンバー関数と、明示的オブジェクト引数（C++23）の呼び出しを比べる（使える場合のみ）。
+ * - if-consteval: `computeWithIfConsteval` の実行時経路と、同じ計算の通常関数を比べる（使える場合のみ）。
+ * - [重要] どちらも「書き方が変わるだけで速度は同じ」ことを確かめるためのカーネル。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerCpp23Kernels(benchHarness::kernelRegistry& registry) {
+  constexpr std::uint64_t kCallCount = 4096;
+
+  struct classicCounter {
+    int value = 0;
+    void add(const int delta) { value += delta; }
+  };
+  registry.add("member-call", "classic-member", kCallCount, []() {
+    classicCounter counter;
+    for (std::uint64_t i = 0; i < kCallCount; ++i) {
+      counter.add(static_cast<int>(i & 7));
+      benchHarness::clobberMemory();
+    }
+    benchHarness::doNotOptimize(counter.value);
+  });
+#if defined(__cpp_explicit_this_parameter)
+  registry.add("member-call", "explicit-this", kCallCount, []() {
+    simpleCounter counter;
+    for (std::uint64_t i = 0; i < kCallCount; ++i) {
+      counter.add(static_cast<int>(i & 7));
+      benchHarness::clobberMemory();
+    }
+    benchHarness::doNotOptimize(counter.value);
+  });
+#endif
+
+#if defined(__cpp_if_consteval)
+  registry.add("if-consteval", "runtime-path", kCallCount, []() {
+    int sum = 0;
+    for (std::uint64_t i = 0; i < kCallCount; ++i) {
+      int input = static_cast<int>(i);
+      benchHarness::doNotOptimize(input);
+      sum += computeWithIfConsteval(input);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("if-consteval", "plain-function", kCallCount, []() {
+    int sum = 0;
+    for (std::uint64_t i = 0; i < kCallCount; ++i) {
+      int input = static_cast<int>(i);
+      benchHarness::doNotOptimize(input);
+      sum += input * 3;
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+#endif
+}
+
 }  // namespace
 
 /**
@@ -256,6 +316,10 @@ void runCpp23Samples() {
  */
 int main(const int argc, char** argv) {
   try {
+    const std::vector<std::string> args(argv, argv + argc);
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("cpp23", args, registerCpp23Kernels);
+    }
     std::cout << "[cpp23] args: " << joinArgs(argc, argv) << "\n";
     runCpp23Samples();
     return 0;
@@ -13,11 +13,14 @@
  * @note [禁止] 「とりあえず動いたからOK」でエラーを握りつぶすこと。理由: 学習では原因と対策の言語化が重要なため。
  */
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "benchHarness.h"
+
 namespace {
 
 /**
@@ -90,6 +93,8 @@ void printHelp(const std::string& programName) {
   std::cout << "\n";
   std::cout << "使い方:\n";
   std::cout << "  " << programName << " --help\n";
+  std::cout << "  " << programName << " --bench [--bench-trials N] [--bench-json out.json] [--bench-label text]\n";
+  std::cout << "  " << programName << " --bench-compare base.json current.json [--bench-threshold 5]\n";
   std::cout << "\n";
   std::cout << "学習の進め方（推奨）:\n";
   std::cout << "  cpp11.cpp -> cpp14.cpp -> cpp17.cpp -> cpp20.cpp -> cpp23.cpp -> modern.cpp\n";
@@ -97,6 +102,24 @@ void printHelp(const std::string& programName) {
   std::cout << "ビルド方法は `cpp_m/INSTALL.md` を参照してください。\n";
 }
 
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - baseline: 計測の「床」。何もしないループと、doNotOptimize だけのループの 1要素あたりの時間。
+ *   他のサンプルの結果がこの値に近い場合は、差ではなく計測の限界を見ている。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerMainKernels(benchHarness::kernelRegistry& registry) {
+  const std::uint64_t kElementCount = 4096;
+  registry.add("baseline", "empty-call", 1, []() {});
+  registry.add("baseline", "doNotOptimize-loop", kElementCount, [kElementCount]() {
+    for (std::uint64_t i = 0; i < kElementCount; ++i) {
+      benchHarness::doNotOptimize(i);
+    }
+  });
+}
+
 }  // namespace
 
 /**
@@ -112,6 +135,9 @@ int main(const int argc, char** argv) {
       printHelp(args[0]);
       return 0;
     }
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("main", args, registerMainKernels);
+    }
 
     std::cout << "[cpp_m] 入口プログラム\n";
     std::cout << "- args: " << joinArgs(argc, argv) << "\n";
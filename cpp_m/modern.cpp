@@ -3,7 +3,10 @@
  * @brief [重要] modern（最新の総合）サンプル。
  * @details
  * - 目的: C++17〜C++23 の「読みやすさ・安全性・実用性」に寄与する要素を、1つの小さな題材で統合的に練習する。
- * - 題材: `--numbers` で与えた整数列の統計（合計/平均/最小/最大）を計算して表示する。
+ * - 題材: `--numbers` で与えた整数列の統計（合計/平均/最小/最大/分散）を計算して表示する。
+ * - 題材(大規模入力): `--input <file|->` で数GB級の数値ファイル（テキスト/int32バイナリ）や標準入力を読み、
+ *   「素朴なfor」「標準アルゴリズム」「全コア+SIMD向けカーネル」の3方式で統計を取り、時間と GB/s を比べる。
+ * - 題材(整数解析): `--bench-parse` で `std::stoi` ループと `std::from_chars` / SWAR（8文字ずつ判定）の一括解析を比べる。
  * - C言語経験者向け補足:
  *   - `std::vector<int>` は「可変長配列」。Cの `int*` + 要素数 + malloc/free をまとめて扱う。
  *   - `std::span<const int>` は「ポインタ+長さ」を安全に束ねた参照（所有しない）。
@@ -16,20 +19,53 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <span>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "benchHarness.h"
+
+// [重要] ファイルのメモリマップ（OS機能）だけは標準C++に無いため、OSごとのAPIを使う。
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace {
 
 /**
@@ -106,20 +142,44 @@ void printTitle(const std::string& title) {
 /**
  * @brief 文字列を int に変換します（失敗時は std::nullopt）。
  * @details
- * - 成功した場合: `std::optional<int>` に値を入れて返す（例: "007" -> 7）
- * - 失敗した場合: `std::nullopt` を返す（例: "12x" / "" / " " など）
+ * - 成功した場合: `std::optional<int>` に値を入れて返す（例: "007" -> 7, "+5" -> 5）
+ * - 失敗した場合: `std::nullopt` を返す（例: "12x" / "" / " " / "99999999999" など）
  *
- * [重要] ここでは `std::stoi` を使うため、
- * - 内部で例外が投げられる可能性がある（それをcatchして nullopt に変換）
- * - 変換の都合上、一度 `std::string` にコピーしている（速度より可読性を優先）
+ * [重要] `std::from_chars` を使うため、
+ * - メモリ確保をしない（`std::string` へのコピーが不要）
+ * - 例外を使わない（失敗は戻り値 `std::errc` で分かる）
+ * - ロケールに依存しない
+ * [注意] `std::stoi` と違い、先頭の空白は受け付けない（区切りは呼び出し側で処理する）。
  *
  * C言語経験者向け:
- * - Cの `strtol` で `endptr` を見て判定するのと似ています。
+ * - Cの `strtol` で `endptr` を見て判定するのと似ています（errno の代わりに戻り値で判定）。
  * - C++では「成功/失敗」を `optional` で表し、呼び出し側に判断させます。
  * @param text std::string_view 変換対象
  * @return std::optional<int> 成功時は値、失敗時は空
  */
-std::optional<int> parseInt(const std::string_view text) {
+std::optional<int> parseInt(std::string_view text) {
+  // from_chars は '+' を受け付けないため、stoi と互換にするためここで外す（"+-5" は不可のまま）。
+  if (text.size() > 1 && text.front() == '+' && text[1] != '-') {
+    text.remove_prefix(1);
+  }
+  int value = 0;
+  const char* const end = text.data() + text.size();
+  const auto [parsedEnd, errorCode] = std::from_chars(text.data(), end, value, 10);
+  if (errorCode != std::errc{} || parsedEnd != end) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/**
+ * @brief 文字列を int に変換します（旧実装: std::stoi + try/catch。`--bench-parse` の比較用）。
+ * @details
+ * - [注意] 1トークンごとに `std::string` を確保し、失敗時は例外を投げて catch する。
+ *   正しく動くが、大量のトークンでは確保と例外処理のコストが支配的になる。
+ * @param text std::string_view 変換対象
+ * @return std::optional<int> 成功時は値、失敗時は空
+ */
+std::optional<int> parseIntWithStoi(const std::string_view text) {
   try {
     std::string owned(text);
     size_t parsedLength = 0;
@@ -134,13 +194,16 @@ std::optional<int> parseInt(const std::string_view text) {
 }
 
 /**
- * @brief 統計結果（合計/平均/最小/最大）。
+ * @brief 統計結果（合計/平均/最小/最大/分散）。
+ * @details
+ * - variance は母分散（Σ(x-平均)² / 要素数）。
  */
 struct statisticsResult {
   long long sum = 0;
   double average = 0.0;
   int minValue = 0;
   int maxValue = 0;
+  double variance = 0.0;
 };
 
 /**
@@ -152,11 +215,12 @@ struct statisticsResult {
  * 処理手順:
  * - min/max を「十分大きい/十分小さい」初期値にする
  * - すべての要素を1回ずつ走査し、sum/min/max を更新
- * - 最後に average を計算
+ * - average を計算
+ * - もう1回走査し、平均との差の二乗和から variance を計算
  *
  * 結果のイメージ:
  * - 入力: [1,2,3,4,5]
- * - sum=15, average=3, min=1, max=5
+ * - sum=15, average=3, min=1, max=5, variance=2
  * @param numbers std::span<const int> 入力数列（空は不可）
  * @return statisticsResult 結果
  * @throws std::invalid_argument numbers が空のとき
@@ -179,6 +243,13 @@ statisticsResult computeStatistics(const std::span<const int> numbers) {
     result.maxValue = std::max(result.maxValue, v);
   }
   result.average = static_cast<double>(result.sum) / static_cast<double>(numbers.size());
+
+  double squaredDiffSum = 0.0;
+  for (const int v : numbers) {
+    const double diff = static_cast<double>(v) - result.average;
+    squaredDiffSum += diff * diff;
+  }
+  result.variance = squaredDiffSum / static_cast<double>(numbers.size());
   return result;
 }
 
@@ -193,6 +264,7 @@ statisticsResult computeStatistics(const std::span<const int> numbers) {
  * - sum: `std::accumulate` で合計（初期値 0LL を指定して long long 合計にする）
  * - min/max: `std::minmax_element` で一度に取得
  * - average: sum / size
+ * - variance: `std::accumulate` にラムダを渡して、平均との差の二乗和を求める
  *
  * 結果は `computeStatistics()` と一致するはずなので、呼び出し側で一致チェックしています。
  * @param numbers std::span<const int> 入力数列（空は不可）
@@ -211,6 +283,13 @@ statisticsResult computeStatisticsRefined(const std::span<const int> numbers) {
   result.minValue = *minIt;
   result.maxValue = *maxIt;
   result.average = static_cast<double>(result.sum) / static_cast<double>(numbers.size());
+
+  const double average = result.average;
+  const double squaredDiffSum = std::accumulate(numbers.begin(), numbers.end(), 0.0, [average](const double acc, const int v) {
+    const double diff = static_cast<double>(v) - average;
+    return acc + diff * diff;
+  });
+  result.variance = squaredDiffSum / static_cast<double>(numbers.size());
   return result;
 }
 
@@ -225,7 +304,7 @@ statisticsResult computeStatisticsRefined(const std::span<const int> numbers) {
  *   （学習用に実装を単純化しています）
  *
  * エラー時の方針:
- * - 失敗したトークンを message に含めて例外を投げる（原因特定を容易にする）
+ * - 失敗したトークンを全部集め、位置（--numbers の後ろから何番目か）と一緒に message に含めて例外を投げる
  * @param args std::vector<std::string> コマンドライン引数（argv をコピーしたもの）
  * @return std::vector<int> 読み取った整数列（空の場合あり）
  * @throws std::runtime_error 変換に失敗した場合
@@ -239,20 +318,1306 @@ std::vector<int> parseNumbersOption(const std::vector<std::string>& args) {
     return numbers;
   }
 
+  // 1個目の失敗で止めず、失敗したトークンを全部集めてから1回だけ例外にする（まとめて直せるように）。
+  numbers.reserve(static_cast<size_t>(std::distance(std::next(it), args.end())));
+  std::vector<std::pair<size_t, std::string_view>> badTokens;
   for (auto jt = std::next(it); jt != args.end(); ++jt) {
     const std::optional<int> valueOpt = parseInt(*jt);
     if (!valueOpt.has_value()) {
-      std::ostringstream oss;
-      oss << "parseNumbersOption: failed to parse int"
-          << " token=\"" << *jt << "\""
-          << " (expected: decimal integer)";
-      throw std::runtime_error(oss.str());
+      badTokens.emplace_back(static_cast<size_t>(std::distance(std::next(it), jt)), *jt);
+      continue;
     }
     numbers.push_back(*valueOpt);
   }
+  if (!badTokens.empty()) {
+    std::ostringstream oss;
+    oss << "parseNumbersOption: failed to parse " << badTokens.size() << " int token(s)"
+        << " (expected: decimal integer in int range)";
+    for (const auto& [index, token] : badTokens) {
+      oss << "\n  index=" << index << " token=\"" << token << "\"";
+    }
+    throw std::runtime_error(oss.str());
+  }
+  return numbers;
+}
+
+// ===========================================================================
+// 大規模入力（--input）向けの統計エンジン
+// ===========================================================================
+//
+// [重要] `--numbers` はコマンドライン引数なので、せいぜい数千個しか渡せない。
+// 数GBのセンサーダンプを扱うために、次の3点を追加している。
+// - 入力: ファイルをメモリマップ（OSがページ単位で読み込む）/ 標準入力をチャンク単位でストリーム読み込み
+// - 計算: ブロック単位の「レーン並列」カーネル（コンパイラが SIMD 命令へ変換しやすい形）を全コアで実行
+// - 集約: スレッドごとの部分統計を最後にまとめる（分散は Chan らの並列分散の式で合成）
+
+/**
+ * @brief `--input` の入力形式。
+ */
+enum class inputFormat {
+  /** 10進整数を空白/改行/カンマ区切りで並べたテキスト */
+  text,
+  /** int32（ネイティブエンディアン。x86/ARM なら little-endian）を隙間なく並べたバイナリ */
+  int32,
+};
+
+/**
+ * @brief `--input` 関連オプション。
+ */
+struct inputOptions {
+  std::string path;                           // ファイルパス。"-" は標準入力
+  inputFormat format = inputFormat::text;
+  unsigned threadCount = 1;
+};
+
+static_assert(sizeof(int) == 4, "int32 input format assumes 32-bit int");
+
+/** @brief カーネルのレーン数（8 = AVX2 の int32 x 8 / double x 4 x 2 に相当）。 */
+constexpr std::size_t kSimdLaneCount = 8;
+/** @brief 1ブロックの要素数。4096 x 4byte = 16KiB で L1 キャッシュに収まり、2回走査しても遅くならない。 */
+constexpr std::size_t kReduceBlockValues = 4096;
+/** @brief 標準入力から1回に読むバイト数。 */
+constexpr std::size_t kStreamChunkBytes = 4 * 1024 * 1024;
+/** @brief テキスト入力で比較用（naive/refined）に vector へ展開する上限バイト数。超えたら比較を省略する。 */
+constexpr std::size_t kMaterializeLimitBytes = 1024ULL * 1024ULL * 1024ULL;
+
+/**
+ * @brief 部分統計（ブロック/スレッドごとの途中結果）。
+ * @details
+ * - 分散は「平均との差の二乗和（m2）」で持つ。
+ *   Σx² − n·平均² で計算すると、値が大きいときに桁落ちで精度が大きく落ちるため。
+ */
+struct partialStatistics {
+  std::uint64_t count = 0;
+  long long sum = 0;
+  int minValue = std::numeric_limits<int>::max();
+  int maxValue = std::numeric_limits<int>::min();
+  double mean = 0.0;
+  double m2 = 0.0;
+};
+
+/**
+ * @brief 部分統計を合成します（Chan らの並列分散アルゴリズム）。
+ * @details
+ * - 2つの集合 A, B の (件数, 平均, m2) から、A∪B の (件数, 平均, m2) を求める。
+ * - m2 = m2A + m2B + δ² · nA · nB / (nA + nB)、δ = 平均B − 平均A
+ * @param into partialStatistics& 合成先（A）
+ * @param from const partialStatistics& 合成元（B）
+ * @return void
+ */
+void mergePartialStatistics(partialStatistics& into, const partialStatistics& from) {
+  if (from.count == 0) {
+    return;
+  }
+  if (into.count == 0) {
+    into = from;
+    return;
+  }
+  const double intoCount = static_cast<double>(into.count);
+  const double fromCount = static_cast<double>(from.count);
+  const double totalCount = intoCount + fromCount;
+  const double delta = from.mean - into.mean;
+  into.m2 += from.m2 + delta * delta * intoCount * fromCount / totalCount;
+  into.mean += delta * fromCount / totalCount;
+  into.count += from.count;
+  into.sum += from.sum;
+  into.minValue = std::min(into.minValue, from.minValue);
+  into.maxValue = std::max(into.maxValue, from.maxValue);
+}
+
+/**
+ * @brief 1ブロック（L1 に収まる長さ）の部分統計を「レーン並列」で計算します。
+ * @details
+ * - [重要] `lane[j]` ごとに独立した累積変数を持つと、ループの各反復が依存しなくなり、
+ *   コンパイラが SIMD 命令（SSE/AVX/NEON）へ変換できる。1本の累積変数だと前の反復の結果待ちになる。
+ * - [注意] double の合計は結合則が厳密には成り立たないため、レーンを分けない素朴な形だと
+ *   `-ffast-math` 無しでは SIMD 化されない。レーンを明示するのはそのため。
+ * - 2回走査する: 1回目で sum/min/max、2回目でブロック平均との差の二乗和。ブロックは L1 上にあるので安い。
+ * @param values const int* 先頭
+ * @param count std::size_t 要素数（1以上）
+ * @return partialStatistics 部分統計
+ */
+partialStatistics reduceBlockLanes(const int* values, const std::size_t count) {
+  std::array<long long, kSimdLaneCount> laneSum{};
+  std::array<int, kSimdLaneCount> laneMin;
+  std::array<int, kSimdLaneCount> laneMax;
+  laneMin.fill(std::numeric_limits<int>::max());
+  laneMax.fill(std::numeric_limits<int>::min());
+
+  const std::size_t laneEnd = count - (count % kSimdLaneCount);
+  for (std::size_t i = 0; i < laneEnd; i += kSimdLaneCount) {
+    for (std::size_t lane = 0; lane < kSimdLaneCount; ++lane) {
+      const int v = values[i + lane];
+      laneSum[lane] += v;
+      laneMin[lane] = std::min(laneMin[lane], v);
+      laneMax[lane] = std::max(laneMax[lane], v);
+    }
+  }
+  partialStatistics result;
+  result.count = count;
+  for (std::size_t lane = 0; lane < kSimdLaneCount; ++lane) {
+    result.sum += laneSum[lane];
+    result.minValue = std::min(result.minValue, laneMin[lane]);
+    result.maxValue = std::max(result.maxValue, laneMax[lane]);
+  }
+  for (std::size_t i = laneEnd; i < count; ++i) {
+    result.sum += values[i];
+    result.minValue = std::min(result.minValue, values[i]);
+    result.maxValue = std::max(result.maxValue, values[i]);
+  }
+  result.mean = static_cast<double>(result.sum) / static_cast<double>(count);
+
+  std::array<double, kSimdLaneCount> laneM2{};
+  const double mean = result.mean;
+  for (std::size_t i = 0; i < laneEnd; i += kSimdLaneCount) {
+    for (std::size_t lane = 0; lane < kSimdLaneCount; ++lane) {
+      const double diff = static_cast<double>(values[i + lane]) - mean;
+      laneM2[lane] += diff * diff;
+    }
+  }
+  for (std::size_t lane = 0; lane < kSimdLaneCount; ++lane) {
+    result.m2 += laneM2[lane];
+  }
+  for (std::size_t i = laneEnd; i < count; ++i) {
+    const double diff = static_cast<double>(values[i]) - mean;
+    result.m2 += diff * diff;
+  }
+  return result;
+}
+
+/**
+ * @brief 任意長の数列をブロックに分けて部分統計を計算します（1スレッド分）。
+ * @param values std::span<const int> 数列
+ * @return partialStatistics 部分統計
+ */
+partialStatistics reduceValuesSimd(const std::span<const int> values) {
+  partialStatistics total;
+  for (std::size_t offset = 0; offset < values.size(); offset += kReduceBlockValues) {
+    const std::size_t blockCount = std::min(kReduceBlockValues, values.size() - offset);
+    mergePartialStatistics(total, reduceBlockLanes(values.data() + offset, blockCount));
+  }
+  return total;
+}
+
+/**
+ * @brief 数列を threadCount 個に分け、全スレッドで部分統計を計算して合成します。
+ * @details
+ * - 各スレッドは自分専用の `partials[t]` にだけ書くので、ロックは不要。
+ * - 合成は join 後にメインスレッドで行う（スレッド番号順なので結果は毎回同じ）。
+ * @param values std::span<const int> 数列
+ * @param threadCount unsigned スレッド数（1以上）
+ * @return partialStatistics 全体の統計
+ */
+partialStatistics reduceValuesParallel(const std::span<const int> values, const unsigned threadCount) {
+  const std::size_t blockCount = (values.size() + kReduceBlockValues - 1) / kReduceBlockValues;
+  const std::size_t workerCount = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, blockCount));
+  // 1スレッドあたりの要素数をブロック長の倍数に揃え、ブロックがスレッド境界で割れないようにする。
+  const std::size_t blocksPerWorker = (blockCount + workerCount - 1) / workerCount;
+  const std::size_t valuesPerWorker = blocksPerWorker * kReduceBlockValues;
+
+  std::vector<partialStatistics> partials(workerCount);
+  std::vector<std::thread> workers;
+  workers.reserve(workerCount);
+  for (std::size_t t = 0; t < workerCount; ++t) {
+    const std::size_t begin = std::min(values.size(), t * valuesPerWorker);
+    const std::size_t length = std::min(values.size() - begin, valuesPerWorker);
+    workers.emplace_back([&partials, t, part = values.subspan(begin, length)]() { partials[t] = reduceValuesSimd(part); });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  partialStatistics total;
+  for (const partialStatistics& partial : partials) {
+    mergePartialStatistics(total, partial);
+  }
+  return total;
+}
+
+/**
+ * @brief テキスト解析の失敗位置。
+ */
+struct textParseError {
+  std::uint64_t byteOffset = 0;  // 入力先頭からのバイト位置
+  std::string token;             // 失敗したトークン（長すぎる場合は先頭のみ）
+};
+
+/** @brief 一括解析で位置を記録するエラーの最大件数（件数自体は全部数える）。 */
+constexpr std::size_t kMaxCollectedParseErrors = 16;
+
+/**
+ * @brief 一括解析の結果（値は sink へ渡すので、ここには件数とエラーだけを持つ）。
+ * @details
+ * - [重要] 例外を使わずにエラーを集める。1個目のエラーで止めず、残りの入力も解析して
+ *   「どこが何件おかしいか」をまとめて返す（数GBのダンプを何度も読み直さずに済む）。
+ */
+struct bulkParseReport {
+  std::uint64_t parsedCount = 0;
+  std::uint64_t errorCount = 0;
+  std::vector<textParseError> errors;  // 入力先頭に近い順に最大 kMaxCollectedParseErrors 件
+
+  /**
+   * @brief 別範囲の結果を合成します（エラーは位置順に並べ直して上限で切る）。
+   * @param other const bulkParseReport& 合成元
+   * @return void
+   */
+  void merge(const bulkParseReport& other) {
+    parsedCount += other.parsedCount;
+    errorCount += other.errorCount;
+    errors.insert(errors.end(), other.errors.begin(), other.errors.end());
+    std::sort(errors.begin(), errors.end(),
+              [](const textParseError& a, const textParseError& b) { return a.byteOffset < b.byteOffset; });
+    if (errors.size() > kMaxCollectedParseErrors) {
+      errors.resize(kMaxCollectedParseErrors);
+    }
+  }
+};
+
+/**
+ * @brief テキスト入力の区切り文字か判定します（空白/タブ/改行/カンマ）。
+ * @param c char 文字
+ * @return bool 区切り文字なら true
+ */
+constexpr bool isNumberSeparator(const char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',';
+}
+
+/**
+ * @brief 8文字を1回で扱う（word-at-a-time / SWAR）ための補助関数群。
+ * @details
+ * - SWAR = SIMD Within A Register。64bit 整数1個を「8個の1byte レーン」とみなして同時に処理する。
+ * - [制限] 先頭の文字が最下位バイトに入る little-endian 専用。big-endian では呼び出し側が使わない。
+ */
+namespace swarDigits {
+
+constexpr std::uint64_t kAsciiZeros = 0x3030303030303030ULL;
+constexpr std::uint64_t kLowNibbles = 0x0F0F0F0F0F0F0F0FULL;
+constexpr std::uint64_t kHighNibbles = 0xF0F0F0F0F0F0F0F0ULL;
+constexpr std::uint64_t kPlusSix = 0x0606060606060606ULL;
+
+/** @brief 8byte を読み込みます（アラインメント不要。memcpy はコンパイラが1命令にする）。 */
+inline std::uint64_t loadWord(const char* p) {
+  std::uint64_t word = 0;
+  std::memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+/**
+ * @brief 先頭から続く数字の個数（0..8）を返します。
+ * @details
+ * - '0'..'9' は 0x30..0x39。0x30 と XOR すると、数字のバイトだけが 0x00..0x09 になる。
+ * - 上位4bit が 0 でない、または下位4bit + 6 が 0x10 を超える（= 0x0A 以上）バイトが「数字以外」。
+ *   下位4bit だけで +6 するのでバイトをまたぐ桁上がりは起きない。
+ * @param digitsXor std::uint64_t `word ^ kAsciiZeros`
+ * @return unsigned 先頭から続く数字の個数
+ */
+inline unsigned countLeadingDigits(const std::uint64_t digitsXor) {
+  const std::uint64_t nonDigitMask =
+      (digitsXor & kHighNibbles) | (((digitsXor & kLowNibbles) + kPlusSix) & kHighNibbles);
+  return nonDigitMask == 0 ? 8U : static_cast<unsigned>(std::countr_zero(nonDigitMask)) / 8U;
+}
+
+/**
+ * @brief 先頭 digitCount 文字（1..8）の数字を3回の掛け算で整数にします。
+ * @details
+ * - 使わない上位バイトを左シフトで追い出し、空いた下位バイト（= 先頭側）を 0（先行ゼロ）にする。
+ * - 隣り合う2桁 → 4桁 → 8桁の順にまとめる（各段で「上の桁 x 10^k + 下の桁」を全レーン同時に計算）。
+ * @param digitsXor std::uint64_t `word ^ kAsciiZeros`
+ * @param digitCount unsigned 数字の個数（1..8）
+ * @return std::uint32_t 値
+ */
+inline std::uint32_t parseDigits(std::uint64_t digitsXor, const unsigned digitCount) {
+  digitsXor <<= (8U - digitCount) * 8U;
+  digitsXor = ((digitsXor & kLowNibbles) * 2561ULL) >> 8U;                          // 2561 = 10 * 256 + 1
+  digitsXor = ((digitsXor & 0x00FF00FF00FF00FFULL) * 6553601ULL) >> 16U;            // 6553601 = 100 * 65536 + 1
+  return static_cast<std::uint32_t>(((digitsXor & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32U);  // 10000 * 2^32 + 1
+}
+
+}  // namespace swarDigits
+
+/**
+ * @brief テキスト全体から整数を一括で取り出し、1個ずつ sink へ渡します（例外なし・確保なし）。
+ * @details
+ * - 高速経路（kUseWordFastPath=true, little-endian, 残り8byte以上）:
+ *   8byte を1回で読み、数字の連続長を求めて、1..8桁ならそのまま SWAR で変換する。
+ *   9〜10桁は「上位8桁 x 10^k + 残り」を 64bit で計算し、int の範囲か確認する。
+ * - それ以外（末尾付近、11桁以上の先行ゼロ、big-endian）は `std::from_chars` で変換する。
+ * - 先頭の `+` は許可する（`std::stoi` と同じ）。`-` はそのまま負数。
+ * - 変換できないトークン（"12x"、範囲外など）はエラーとして記録し、次の区切り文字まで読み飛ばして続ける。
+ * @tparam kUseWordFastPath bool SWAR 高速経路を使うか（false はベンチマーク比較用の from_chars のみ）
+ * @param text std::string_view 入力
+ * @param baseOffset std::uint64_t text 先頭の、入力全体でのバイト位置（エラー表示用）
+ * @param sink Sink 1個ごとに呼ぶ関数 `void(int)`
+ * @return bulkParseReport 件数とエラー位置
+ */
+template <bool kUseWordFastPath = true, class Sink>
+bulkParseReport parseIntsBulk(const std::string_view text, const std::uint64_t baseOffset, Sink&& sink) {
+  constexpr bool kCanUseWordFastPath = kUseWordFastPath && std::endian::native == std::endian::little;
+  constexpr std::uint64_t kPowersOfTen[] = {1ULL, 10ULL, 100ULL};
+  constexpr std::uint64_t kIntMax = static_cast<std::uint64_t>(std::numeric_limits<int>::max());
+
+  bulkParseReport report;
+  const char* cursor = text.data();
+  const char* const end = text.data() + text.size();
+  while (cursor < end) {
+    while (cursor < end && isNumberSeparator(*cursor)) {
+      ++cursor;
+    }
+    if (cursor == end) {
+      break;
+    }
+    const char* const tokenStart = cursor;
+    const char* digitsStart = cursor;
+    const bool isNegative = *digitsStart == '-';
+    if (*digitsStart == '+' || isNegative) {
+      ++digitsStart;
+    }
+
+    bool isParsed = false;
+    int value = 0;
+    const char* parsedEnd = digitsStart;
+    if constexpr (kCanUseWordFastPath) {
+      if (end - digitsStart >= 8) {
+        const std::uint64_t digitsXor = swarDigits::loadWord(digitsStart) ^ swarDigits::kAsciiZeros;
+        const unsigned leadingDigits = swarDigits::countLeadingDigits(digitsXor);
+        if (leadingDigits > 0 && leadingDigits < 8) {
+          // [速度] 最も多い 1〜7 桁はここで終わる（分岐1回 + 掛け算3回）。
+          const std::uint32_t magnitude = swarDigits::parseDigits(digitsXor, leadingDigits);
+          value = isNegative ? -static_cast<int>(magnitude) : static_cast<int>(magnitude);
+          parsedEnd = digitsStart + leadingDigits;
+          isParsed = true;
+        } else if (leadingDigits == 8) {
+          unsigned extraDigits = 0;
+          while (extraDigits < 3 && digitsStart + 8 + extraDigits < end &&
+                 static_cast<unsigned char>(digitsStart[8 + extraDigits] - '0') < 10U) {
+            ++extraDigits;
+          }
+          if (extraDigits <= 2) {
+            std::uint64_t magnitude = swarDigits::parseDigits(digitsXor, 8) * kPowersOfTen[extraDigits];
+            for (unsigned i = 0; i < extraDigits; ++i) {
+              magnitude += static_cast<std::uint64_t>(digitsStart[8 + i] - '0') * kPowersOfTen[extraDigits - 1 - i];
+            }
+            if (magnitude <= kIntMax + (isNegative ? 1U : 0U)) {
+              value = isNegative ? static_cast<int>(-static_cast<long long>(magnitude)) : static_cast<int>(magnitude);
+              parsedEnd = digitsStart + 8 + extraDigits;
+              isParsed = true;
+            }
+          }
+        }
+      }
+    }
+    if (!isParsed && digitsStart < end && static_cast<unsigned char>(*digitsStart - '0') < 10U) {
+      // 汎用経路: from_chars は '-' を解釈するので、負数は符号の位置から渡す。
+      const auto [fromCharsEnd, errorCode] = std::from_chars(isNegative ? tokenStart : digitsStart, end, value, 10);
+      if (errorCode == std::errc{}) {
+        parsedEnd = fromCharsEnd;
+        isParsed = true;
+      }
+    }
+
+    if (isParsed && (parsedEnd == end || isNumberSeparator(*parsedEnd))) {
+      sink(value);
+      ++report.parsedCount;
+      cursor = parsedEnd;
+      continue;
+    }
+
+    // エラー: トークン末尾まで読み飛ばし、位置を記録して続行する。
+    const char* tokenEnd = tokenStart;
+    while (tokenEnd < end && !isNumberSeparator(*tokenEnd)) {
+      ++tokenEnd;
+    }
+    ++report.errorCount;
+    if (report.errors.size() < kMaxCollectedParseErrors) {
+      const std::size_t shownLength = std::min<std::size_t>(32, static_cast<std::size_t>(tokenEnd - tokenStart));
+      report.errors.push_back(textParseError{baseOffset + static_cast<std::uint64_t>(tokenStart - text.data()),
+                                             std::string(tokenStart, shownLength)});
+    }
+    cursor = tokenEnd;
+  }
+  return report;
+}
+
+/**
+ * @brief トークン数を数えます（vector を正確に事前確保するため）。
+ * @details
+ * - 「区切り文字の直後の非区切り文字」の数を数えるだけなので、解析より十分速い。
+ * @param text std::string_view 入力
+ * @return std::size_t トークン数
+ */
+std::size_t countTokens(const std::string_view text) {
+  std::size_t tokenCount = 0;
+  bool isPreviousSeparator = true;
+  for (const char c : text) {
+    const bool isSeparator = isNumberSeparator(c);
+    tokenCount += static_cast<std::size_t>(isPreviousSeparator && !isSeparator);
+    isPreviousSeparator = isSeparator;
+  }
+  return tokenCount;
+}
+
+/**
+ * @brief 事前確保した領域へ直接書き込みながら一括解析します。
+ * @details
+ * - [重要] push_back を使わないので、容量確認・再確保・要素移動が発生しない。
+ * - destination が足りない場合、入りきらない値は捨ててエラー（"(destination full)"）として数える。
+ * @tparam kUseWordFastPath bool SWAR 高速経路を使うか
+ * @param text std::string_view 入力
+ * @param destination std::span<int> 書き込み先（`countTokens()` 個あれば必ず足りる）
+ * @param writtenCountOut std::size_t* 書き込んだ個数
+ * @return bulkParseReport 件数とエラー位置
+ */
+template <bool kUseWordFastPath = true>
+bulkParseReport parseIntsInto(const std::string_view text, const std::span<int> destination, std::size_t* writtenCountOut) {
+  int* const first = destination.data();
+  int* out = first;
+  int* const last = first + destination.size();
+  bool isOverflowed = false;
+  bulkParseReport report = parseIntsBulk<kUseWordFastPath>(text, 0, [&](const int value) {
+    if (out == last) {
+      isOverflowed = true;
+      return;
+    }
+    *out++ = value;
+  });
+  if (isOverflowed) {
+    const std::uint64_t droppedCount = report.parsedCount - static_cast<std::uint64_t>(out - first);
+    report.parsedCount -= droppedCount;
+    report.errorCount += droppedCount;
+    report.errors.push_back(textParseError{text.size(), "(destination full)"});
+  }
+  *writtenCountOut = static_cast<std::size_t>(out - first);
+  return report;
+}
+
+/**
+ * @brief テキスト範囲の集計結果。
+ */
+struct textReduceResult {
+  partialStatistics statistics;
+  bulkParseReport report;
+};
+
+/**
+ * @brief テキスト範囲を解析しながら部分統計を計算します（ストリーミング集計。値を全部は保持しない）。
+ * @details
+ * - 解析した値は 4096 個ずつブロックバッファへ貯め、満杯になったらカーネルで集計する。
+ *   メモリ使用量は入力サイズに関係なく一定。
+ * @param text std::string_view 入力範囲
+ * @param baseOffset std::uint64_t text 先頭の、入力全体でのバイト位置
+ * @return textReduceResult 部分統計と解析結果
+ */
+textReduceResult reduceTextRange(const std::string_view text, const std::uint64_t baseOffset) {
+  textReduceResult result;
+  std::array<int, kReduceBlockValues> block;
+  std::size_t filled = 0;
+  result.report = parseIntsBulk(text, baseOffset, [&](const int value) {
+    block[filled++] = value;
+    if (filled == block.size()) {
+      mergePartialStatistics(result.statistics, reduceBlockLanes(block.data(), filled));
+      filled = 0;
+    }
+  });
+  if (filled > 0) {
+    mergePartialStatistics(result.statistics, reduceBlockLanes(block.data(), filled));
+  }
+  return result;
+}
+
+/**
+ * @brief 解析エラーを「件数+位置+トークン」入りの例外にします。
+ * @param functionName const char* 呼び出し元関数名
+ * @param report const bulkParseReport& 解析結果（errorCount は1以上）
+ * @return std::runtime_error 例外オブジェクト
+ */
+std::runtime_error makeBulkParseException(const char* functionName, const bulkParseReport& report) {
+  std::ostringstream oss;
+  oss << functionName << ": failed to parse " << report.errorCount << " token(s)"
+      << " (expected: decimal integer in int range)";
+  for (const textParseError& error : report.errors) {
+    oss << "\n  byteOffset=" << error.byteOffset << " token=\"" << error.token << "\"";
+  }
+  if (report.errorCount > report.errors.size()) {
+    oss << "\n  ... and " << (report.errorCount - report.errors.size()) << " more";
+  }
+  return std::runtime_error(oss.str());
+}
+
+/**
+ * @brief テキスト全体を threadCount 個の範囲に分け、全スレッドで解析+集計します。
+ * @details
+ * - 分割位置が数字の途中に来ないよう、次の区切り文字まで後ろへずらす。
+ * - 各スレッドのエラーは位置順にまとめて報告する。
+ * @param text std::string_view 入力全体
+ * @param threadCount unsigned スレッド数
+ * @return partialStatistics 全体の統計
+ * @throws std::runtime_error 解析に失敗したトークンがある場合
+ */
+partialStatistics reduceTextParallel(const std::string_view text, const unsigned threadCount) {
+  const std::size_t workerCount = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, text.size() / 4096 + 1));
+  std::vector<std::size_t> boundaries(workerCount + 1, text.size());
+  boundaries[0] = 0;
+  for (std::size_t t = 1; t < workerCount; ++t) {
+    std::size_t position = std::max(boundaries[t - 1], text.size() / workerCount * t);
+    while (position < text.size() && !isNumberSeparator(text[position])) {
+      ++position;
+    }
+    boundaries[t] = position;
+  }
+
+  std::vector<textReduceResult> results(workerCount);
+  std::vector<std::thread> workers;
+  workers.reserve(workerCount);
+  for (std::size_t t = 0; t < workerCount; ++t) {
+    const std::size_t begin = boundaries[t];
+    const std::string_view part = text.substr(begin, boundaries[t + 1] - begin);
+    workers.emplace_back([&results, t, part, begin]() { results[t] = reduceTextRange(part, begin); });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  partialStatistics total;
+  bulkParseReport report;
+  for (const textReduceResult& result : results) {
+    mergePartialStatistics(total, result.statistics);
+    report.merge(result.report);
+  }
+  if (report.errorCount > 0) {
+    throw makeBulkParseException("reduceTextParallel", report);
+  }
+  return total;
+}
+
+/**
+ * @brief テキストを1スレッドで解析して vector へ展開します（naive/refined 比較用）。
+ * @details
+ * - `countTokens()` で個数を数えて一度だけ確保し、`parseIntsInto()` で直接書き込む。
+ * @param text std::string_view 入力
+ * @return std::vector<int> 数列
+ * @throws std::runtime_error 解析に失敗したトークンがある場合
+ */
+std::vector<int> parseTextToVector(const std::string_view text) {
+  std::vector<int> numbers(countTokens(text));
+  std::size_t writtenCount = 0;
+  const bulkParseReport report = parseIntsInto(text, std::span<int>(numbers), &writtenCount);
+  if (report.errorCount > 0) {
+    throw makeBulkParseException("parseTextToVector", report);
+  }
+  numbers.resize(writtenCount);
   return numbers;
 }
 
+/**
+ * @brief 読み取り専用のメモリマップファイル（RAII）。
+ * @details
+ * - [重要] ファイル全体を read() でメモリへコピーせず、OS のページキャッシュをそのまま参照する。
+ *   数GBのファイルでも、アドレス空間さえあれば（64bit なら実質無制限）扱える。
+ * - C言語経験者向け: `mmap()` / `munmap()`（Windows は `MapViewOfFile`）をデストラクタで確実に解放する形にしたもの。
+ */
+class mappedFile {
+ public:
+  /**
+   * @brief ファイルを開いてマップします。
+   * @param path const std::string& ファイルパス
+   * @throws std::runtime_error 開けない/マップできない場合
+   */
+  explicit mappedFile(const std::string& path) {
+#if defined(_WIN32)
+    fileHandle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle_ == INVALID_HANDLE_VALUE) {
+      throw std::runtime_error("mappedFile: CreateFileA failed. path=\"" + path + "\" error=" + std::to_string(GetLastError()));
+    }
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(fileHandle_, &fileSize)) {
+      const DWORD errorCode = GetLastError();
+      CloseHandle(fileHandle_);
+      throw std::runtime_error("mappedFile: GetFileSizeEx failed. path=\"" + path + "\" error=" + std::to_string(errorCode));
+    }
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    if (size_ == 0) {
+      return;  // 空ファイルはマップできない（呼び出し側で empty を判定する）
+    }
+    mappingHandle_ = CreateFileMappingA(fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle_ == nullptr) {
+      const DWORD errorCode = GetLastError();
+      CloseHandle(fileHandle_);
+      throw std::runtime_error("mappedFile: CreateFileMappingA failed. path=\"" + path + "\" error=" + std::to_string(errorCode));
+    }
+    data_ = static_cast<const char*>(MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+      const DWORD errorCode = GetLastError();
+      CloseHandle(mappingHandle_);
+      CloseHandle(fileHandle_);
+      throw std::runtime_error("mappedFile: MapViewOfFile failed. path=\"" + path + "\" error=" + std::to_string(errorCode));
+    }
+#else
+    fileDescriptor_ = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor_ < 0) {
+      throw std::runtime_error("mappedFile: open failed. path=\"" + path + "\" errno=" + std::strerror(errno));
+    }
+    struct stat fileStatus {};
+    if (fstat(fileDescriptor_, &fileStatus) != 0) {
+      const int errorNumber = errno;
+      close(fileDescriptor_);
+      throw std::runtime_error("mappedFile: fstat failed. path=\"" + path + "\" errno=" + std::strerror(errorNumber));
+    }
+    size_ = static_cast<std::size_t>(fileStatus.st_size);
+    if (size_ == 0) {
+      return;
+    }
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fileDescriptor_, 0);
+    if (mapped == MAP_FAILED) {
+      const int errorNumber = errno;
+      close(fileDescriptor_);
+      throw std::runtime_error("mappedFile: mmap failed. path=\"" + path + "\" errno=" + std::strerror(errorNumber));
+    }
+    // 先頭から順に読むことを OS へ伝え、先読みを大きくしてもらう（失敗しても動作に影響しない）。
+    madvise(mapped, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(mapped);
+#endif
+  }
+
+  ~mappedFile() {
+#if defined(_WIN32)
+    if (data_ != nullptr) {
+      UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_ != nullptr) {
+      CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(fileHandle_);
+    }
+#else
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+    if (fileDescriptor_ >= 0) {
+      close(fileDescriptor_);
+    }
+#endif
+  }
+
+  mappedFile(const mappedFile&) = delete;
+  mappedFile& operator=(const mappedFile&) = delete;
+
+  /** @brief マップした内容（空ファイルなら空）。 */
+  std::string_view bytes() const { return data_ == nullptr ? std::string_view() : std::string_view(data_, size_); }
+
+ private:
+#if defined(_WIN32)
+  HANDLE fileHandle_ = INVALID_HANDLE_VALUE;
+  HANDLE mappingHandle_ = nullptr;
+#else
+  int fileDescriptor_ = -1;
+#endif
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+/**
+ * @brief バイト列を int32 配列として見ます（コピーしない）。
+ * @details
+ * - [注意] mmap / new の先頭はページ/最大アラインメント境界なので、int の境界条件を満たす。
+ * - [制限] エンディアン変換はしない（書き出した機械と同じエンディアンで読むこと）。
+ * @param bytes std::string_view バイト列（長さは4の倍数）
+ * @return std::span<const int> 数列
+ * @throws std::runtime_error 長さが4の倍数でない場合
+ */
+std::span<const int> viewAsInt32(const std::string_view bytes) {
+  if (bytes.size() % sizeof(int) != 0) {
+    std::ostringstream oss;
+    oss << "viewAsInt32: byte size is not a multiple of 4. size=" << bytes.size();
+    throw std::runtime_error(oss.str());
+  }
+  return std::span<const int>(reinterpret_cast<const int*>(bytes.data()), bytes.size() / sizeof(int));
+}
+
+/**
+ * @brief 標準入力をストリーム処理した結果。
+ */
+struct streamReduceResult {
+  partialStatistics statistics;
+  std::uint64_t totalBytes = 0;
+};
+
+/**
+ * @brief 標準入力をチャンク単位で読み、ワーカースレッドで解析+集計します（入力全体は保持しない）。
+ * @details
+ * - 構成: 読み込み（メインスレッド）→ 上限付きキュー → ワーカー threadCount 個。
+ *   キューに上限があるので、集計が遅くてもメモリは「チャンク長 x (2 x ワーカー数)」程度で頭打ちになる。
+ * - テキストは「チャンク末尾の数字が次のチャンクへまたがる」ことがあるため、最後の区切り文字より後ろを
+ *   次のチャンクの先頭へ持ち越す。int32 は 4byte 未満の端数を持ち越す。
+ * - [注意] 一度しか読めないので、naive/refined との比較はできない（呼び出し側で省略する）。
+ * @param format inputFormat 入力形式
+ * @param threadCount unsigned ワーカー数
+ * @return streamReduceResult 統計と総バイト数
+ * @throws std::runtime_error 読み込み/解析に失敗した場合
+ */
+streamReduceResult reduceStdinStreaming(const inputFormat format, const unsigned threadCount) {
+#if defined(_WIN32)
+  // Windows の標準入力は既定でテキストモード（\r\n 変換や 0x1A で EOF）なので、バイナリモードへ切り替える。
+  _setmode(_fileno(stdin), _O_BINARY);
+#endif
+  struct streamChunk {
+    std::vector<char> bytes;
+    std::uint64_t baseOffset = 0;
+  };
+  std::mutex queueMutex;
+  std::condition_variable queueNotEmpty;
+  std::condition_variable queueNotFull;
+  std::deque<streamChunk> queue;
+  bool isReadFinished = false;
+  const std::size_t workerCount = std::max(1U, threadCount);
+  const std::size_t maxQueuedChunks = workerCount * 2;
+
+  std::vector<partialStatistics> partials(workerCount);
+  std::vector<bulkParseReport> reports(workerCount);
+  std::vector<std::thread> workers;
+  workers.reserve(workerCount);
+  for (std::size_t t = 0; t < workerCount; ++t) {
+    workers.emplace_back([&, t]() {
+      while (true) {
+        streamChunk chunk;
+        {
+          std::unique_lock<std::mutex> lock(queueMutex);
+          queueNotEmpty.wait(lock, [&]() { return !queue.empty() || isReadFinished; });
+          if (queue.empty()) {
+            return;
+          }
+          chunk = std::move(queue.front());
+          queue.pop_front();
+        }
+        queueNotFull.notify_one();
+        const std::string_view bytes(chunk.bytes.data(), chunk.bytes.size());
+        if (format == inputFormat::int32) {
+          mergePartialStatistics(partials[t], reduceValuesSimd(viewAsInt32(bytes)));
+        } else {
+          const textReduceResult result = reduceTextRange(bytes, chunk.baseOffset);
+          mergePartialStatistics(partials[t], result.statistics);
+          reports[t].merge(result.report);
+        }
+      }
+    });
+  }
+
+  const auto pushChunk = [&](streamChunk chunk) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queueNotFull.wait(lock, [&]() { return queue.size() < maxQueuedChunks; });
+    queue.push_back(std::move(chunk));
+    lock.unlock();
+    queueNotEmpty.notify_one();
+  };
+
+  streamReduceResult result;
+  std::vector<char> carry;
+  std::uint64_t carryOffset = 0;
+  bool hasReadError = false;
+  while (true) {
+    streamChunk chunk;
+    chunk.baseOffset = carryOffset;
+    chunk.bytes.resize(carry.size() + kStreamChunkBytes);
+    std::memcpy(chunk.bytes.data(), carry.data(), carry.size());
+    const std::size_t readBytes = std::fread(chunk.bytes.data() + carry.size(), 1, kStreamChunkBytes, stdin);
+    result.totalBytes += readBytes;
+    chunk.bytes.resize(carry.size() + readBytes);
+    if (readBytes == 0) {
+      hasReadError = std::ferror(stdin) != 0;
+      if (!chunk.bytes.empty()) {
+        if (format == inputFormat::int32) {
+          carry = std::move(chunk.bytes);  // 4byte 未満の端数。下でエラーにする
+        } else {
+          pushChunk(std::move(chunk));  // 最後のトークン（末尾に改行が無い場合）
+          carry.clear();
+        }
+      }
+      break;
+    }
+    // 次のチャンクへ持ち越す位置を決める。
+    std::size_t cutPosition = chunk.bytes.size();
+    if (format == inputFormat::int32) {
+      cutPosition -= cutPosition % sizeof(int);
+    } else {
+      while (cutPosition > 0 && !isNumberSeparator(chunk.bytes[cutPosition - 1])) {
+        --cutPosition;
+      }
+    }
+    carry.assign(chunk.bytes.begin() + static_cast<std::ptrdiff_t>(cutPosition), chunk.bytes.end());
+    carryOffset = chunk.baseOffset + cutPosition;
+    chunk.bytes.resize(cutPosition);
+    if (!chunk.bytes.empty()) {
+      pushChunk(std::move(chunk));
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    isReadFinished = true;
+  }
+  queueNotEmpty.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  if (hasReadError) {
+    throw std::runtime_error("reduceStdinStreaming: fread(stdin) failed");
+  }
+  if (format == inputFormat::int32 && !carry.empty()) {
+    std::ostringstream oss;
+    oss << "reduceStdinStreaming: byte size is not a multiple of 4. size=" << result.totalBytes;
+    throw std::runtime_error(oss.str());
+  }
+  bulkParseReport report;
+  for (const bulkParseReport& workerReport : reports) {
+    report.merge(workerReport);
+  }
+  if (report.errorCount > 0) {
+    throw makeBulkParseException("reduceStdinStreaming", report);
+  }
+  for (const partialStatistics& partial : partials) {
+    mergePartialStatistics(result.statistics, partial);
+  }
+  return result;
+}
+
+/**
+ * @brief 部分統計を表示用の statisticsResult へ変換します。
+ * @param partial const partialStatistics& 部分統計（count は1以上）
+ * @return statisticsResult 結果
+ */
+statisticsResult toStatisticsResult(const partialStatistics& partial) {
+  statisticsResult result;
+  result.sum = partial.sum;
+  result.average = static_cast<double>(partial.sum) / static_cast<double>(partial.count);
+  result.minValue = partial.minValue;
+  result.maxValue = partial.maxValue;
+  result.variance = partial.m2 / static_cast<double>(partial.count);
+  return result;
+}
+
+/**
+ * @brief 2つの統計結果が一致するか判定します（分散は浮動小数の誤差を許容）。
+ * @details
+ * - 分散は加算順序が違うと末尾の桁が変わるため、相対誤差 1e-9 まで一致とみなす。
+ * @return bool 一致なら true
+ */
+bool isSameStatistics(const statisticsResult& a, const statisticsResult& b) {
+  const double varianceScale = std::max({1.0, std::abs(a.variance), std::abs(b.variance)});
+  return a.sum == b.sum && a.minValue == b.minValue && a.maxValue == b.maxValue &&
+         std::abs(a.variance - b.variance) <= varianceScale * 1e-9;
+}
+
+/**
+ * @brief 不一致時の例外を作ります。
+ */
+std::runtime_error makeStatisticsMismatchException(const char* label, const statisticsResult& expected, const statisticsResult& actual) {
+  std::ostringstream oss;
+  oss << "statistics mismatch (" << label << ")"
+      << " sum(" << expected.sum << " vs " << actual.sum << ")"
+      << " min(" << expected.minValue << " vs " << actual.minValue << ")"
+      << " max(" << expected.maxValue << " vs " << actual.maxValue << ")"
+      << " variance(" << expected.variance << " vs " << actual.variance << ")";
+  return std::runtime_error(oss.str());
+}
+
+/**
+ * @brief 経過時間(ms)を返します。
+ */
+double elapsedMsSince(const std::chrono::steady_clock::time_point startTime) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * @brief 1方式分の計測結果を表示します。
+ * @details
+ * - GB/s = 処理したバイト数 / 秒 / 10^9。どのバイト数を基準にしたかを basis に表示する。
+ */
+void printTiming(const std::string& label, const double elapsedMs, const std::uint64_t bytes, const std::string& basis) {
+  const double seconds = elapsedMs / 1000.0;
+  const double gigabytesPerSecond = seconds > 0.0 ? static_cast<double>(bytes) / seconds / 1e9 : 0.0;
+  std::cout << "[" << label << "] elapsedMs=" << elapsedMs << " GB/s=" << gigabytesPerSecond << " (bytes=" << bytes
+            << ", " << basis << ")\n";
+}
+
+/**
+ * @brief `--input` / `--format` / `--threads` を読み取ります。
+ * @param args std::vector<std::string> コマンドライン引数
+ * @return std::optional<inputOptions> `--input` が無ければ空
+ * @throws std::runtime_error 値が不正な場合
+ */
+std::optional<inputOptions> parseInputOptions(const std::vector<std::string>& args) {
+  const auto inputIt = std::find(args.begin(), args.end(), "--input");
+  if (inputIt == args.end()) {
+    return std::nullopt;
+  }
+  if (std::find(args.begin(), args.end(), "--numbers") != args.end()) {
+    throw std::runtime_error("parseInputOptions: --input and --numbers cannot be used together");
+  }
+  const auto valueOf = [&args](const std::string& name) -> std::optional<std::string> {
+    const auto it = std::find(args.begin(), args.end(), name);
+    if (it == args.end()) {
+      return std::nullopt;
+    }
+    if (std::next(it) == args.end()) {
+      throw std::runtime_error("parseInputOptions: missing value for " + name);
+    }
+    return *std::next(it);
+  };
+
+  inputOptions options;
+  options.path = *valueOf("--input");
+  const unsigned hardwareThreads = std::thread::hardware_concurrency();
+  options.threadCount = hardwareThreads == 0 ? 1 : hardwareThreads;
+
+  if (const std::optional<std::string> formatText = valueOf("--format"); formatText.has_value()) {
+    if (*formatText == "text") {
+      options.format = inputFormat::text;
+    } else if (*formatText == "int32") {
+      options.format = inputFormat::int32;
+    } else {
+      throw std::runtime_error("parseInputOptions: invalid --format \"" + *formatText + "\" (expected: text|int32)");
+    }
+  }
+  if (const std::optional<std::string> threadText = valueOf("--threads"); threadText.has_value()) {
+    const std::optional<int> threadValue = parseInt(*threadText);
+    if (!threadValue.has_value() || *threadValue <= 0) {
+      throw std::runtime_error("parseInputOptions: invalid --threads \"" + *threadText + "\" (expected: positive integer)");
+    }
+    options.threadCount = static_cast<unsigned>(*threadValue);
+  }
+  return options;
+}
+
+/**
+ * @brief 統計結果を表示します。
+ */
+void printStatistics(const std::uint64_t count, const statisticsResult& stats) {
+  std::cout << "numbers size=" << count << "\n";
+  std::cout << "sum=" << stats.sum << "\n";
+  std::cout << "average=" << stats.average << "\n";
+  std::cout << "min=" << stats.minValue << "\n";
+  std::cout << "max=" << stats.maxValue << "\n";
+  std::cout << "variance=" << stats.variance << "\n";
+}
+
+/**
+ * @brief `--input` モードを実行します。
+ * @details
+ * 処理手順:
+ * - (1) ファイルならメモリマップ、"-" なら標準入力のストリーム処理
+ * - (2) ファイルの場合は naive（for ループ）と refined（accumulate/minmax_element）も計測する。
+ *       int32 はマップをそのまま span で見る。text は 1GiB までなら vector へ展開して計測する（展開時間は別表示）。
+ * - (3) parallel-SIMD（全スレッド+レーン並列カーネル）を計測する
+ * - (4) 方式間で結果が一致するか確認して表示する
+ * @param options const inputOptions& オプション
+ * @return void
+ * @throws std::runtime_error 入力/解析/不一致
+ */
+void runInputStatistics(const inputOptions& options) {
+  printTitle("input statistics");
+  const char* const formatLabel = options.format == inputFormat::text ? "text" : "int32";
+
+  if (options.path == "-") {
+    std::cout << "input=stdin format=" << formatLabel << " threads=" << options.threadCount << " method=stream\n";
+    std::cout << "[naive] skipped (stdin can be read only once)\n";
+    std::cout << "[refined] skipped (stdin can be read only once)\n";
+    const auto startTime = std::chrono::steady_clock::now();
+    const streamReduceResult streamed = reduceStdinStreaming(options.format, options.threadCount);
+    const double elapsedMs = elapsedMsSince(startTime);
+    if (streamed.statistics.count == 0) {
+      throw std::runtime_error("runInputStatistics: input is empty (stdin)");
+    }
+    printTiming("parallel-simd", elapsedMs, streamed.totalBytes, "stdin bytes, read+parse+reduce");
+    printStatistics(streamed.statistics.count, toStatisticsResult(streamed.statistics));
+    return;
+  }
+
+  const mappedFile file(options.path);
+  const std::string_view bytes = file.bytes();
+  std::cout << "input=" << options.path << " format=" << formatLabel << " threads=" << options.threadCount
+            << " method=mmap bytes=" << bytes.size() << "\n";
+  if (bytes.empty()) {
+    throw std::runtime_error("runInputStatistics: input is empty. path=\"" + options.path + "\"");
+  }
+
+  std::optional<statisticsResult> referenceStats;
+  std::uint64_t valueCount = 0;
+  std::vector<int> materialized;
+  std::span<const int> values;
+  if (options.format == inputFormat::int32) {
+    values = viewAsInt32(bytes);
+  } else if (bytes.size() <= kMaterializeLimitBytes) {
+    const auto parseStart = std::chrono::steady_clock::now();
+    materialized = parseTextToVector(bytes);
+    printTiming("parse-to-vector", elapsedMsSince(parseStart), bytes.size(), "file bytes, single thread");
+    values = std::span<const int>(materialized.data(), materialized.size());
+  } else {
+    std::cout << "[naive] skipped (text larger than " << kMaterializeLimitBytes << " bytes is not materialized)\n";
+    std::cout << "[refined] skipped (text larger than " << kMaterializeLimitBytes << " bytes is not materialized)\n";
+  }
+
+  if (!values.empty()) {
+    const std::uint64_t valueBytes = static_cast<std::uint64_t>(values.size_bytes());
+    const auto naiveStart = std::chrono::steady_clock::now();
+    const statisticsResult naiveStats = computeStatistics(values);
+    printTiming("naive", elapsedMsSince(naiveStart), valueBytes, "int32 bytes");
+
+    const auto refinedStart = std::chrono::steady_clock::now();
+    const statisticsResult refinedStats = computeStatisticsRefined(values);
+    printTiming("refined", elapsedMsSince(refinedStart), valueBytes, "int32 bytes");
+    if (!isSameStatistics(naiveStats, refinedStats)) {
+      throw makeStatisticsMismatchException("naive vs refined", naiveStats, refinedStats);
+    }
+    referenceStats = naiveStats;
+    valueCount = values.size();
+  }
+
+  const auto parallelStart = std::chrono::steady_clock::now();
+  const partialStatistics parallel = options.format == inputFormat::int32 ? reduceValuesParallel(values, options.threadCount)
+                                                                          : reduceTextParallel(bytes, options.threadCount);
+  printTiming("parallel-simd", elapsedMsSince(parallelStart), bytes.size(),
+              options.format == inputFormat::int32 ? "int32 bytes" : "file bytes, parse+reduce");
+  if (parallel.count == 0) {
+    throw std::runtime_error("runInputStatistics: no numbers in input. path=\"" + options.path + "\"");
+  }
+  const statisticsResult parallelStats = toStatisticsResult(parallel);
+  if (referenceStats.has_value() && (valueCount != parallel.count || !isSameStatistics(*referenceStats, parallelStats))) {
+    throw makeStatisticsMismatchException("naive vs parallel-simd", *referenceStats, parallelStats);
+  }
+  printStatistics(parallel.count, parallelStats);
+}
+
+/**
+ * @brief `--bench-parse` のオプション。
+ */
+struct parseBenchOptions {
+  std::uint64_t tokenCount = 100'000'000;  // 既定は 1億トークン（テキスト約 0.8GB をメモリ上に作る）
+  unsigned threadCount = 1;
+};
+
+/**
+ * @brief ベンチマーク用のテキストを作ります（固定シードなので毎回同じ内容）。
+ * @details
+ * - 桁数は 1〜10 を一様に選ぶ（= 値は対数一様）。短い値も長い値も同じ割合で混ぜ、
+ *   高速経路（1〜8桁）と 9〜10 桁の経路の両方を測る。約25%を負数、区切りは空白と改行を混ぜる。
+ * @param tokenCount std::uint64_t トークン数
+ * @return std::string テキスト
+ */
+std::string makeParseBenchText(const std::uint64_t tokenCount) {
+  std::mt19937 random(20261018U);
+  std::uniform_int_distribution<int> digitCountDistribution(1, 10);
+  std::string text;
+  text.reserve(static_cast<size_t>(tokenCount) * 8);
+  std::array<char, 16> buffer{};
+  for (std::uint64_t i = 0; i < tokenCount; ++i) {
+    const int digitCount = digitCountDistribution(random);
+    const std::uint32_t upper = digitCount == 10 ? static_cast<std::uint32_t>(std::numeric_limits<int>::max())
+                                                 : static_cast<std::uint32_t>(std::pow(10.0, digitCount)) - 1U;
+    const std::uint32_t lower = digitCount == 1 ? 0U : static_cast<std::uint32_t>(std::pow(10.0, digitCount - 1));
+    const int value = static_cast<int>(std::uniform_int_distribution<std::uint32_t>(lower, upper)(random));
+    const bool isNegative = (random() & 3U) == 0U;
+    const auto [end, errorCode] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), isNegative ? -value : value);
+    (void)errorCode;  // int は 16byte に必ず収まる
+    text.append(buffer.data(), end);
+    text.push_back((i & 15U) == 15U ? '\n' : ' ');
+  }
+  return text;
+}
+
+/**
+ * @brief 旧方式: 区切り文字で切り出し → `parseIntWithStoi` → push_back（事前確保なし）。
+ * @param text std::string_view 入力
+ * @return std::vector<int> 数列
+ * @throws std::runtime_error 解析に失敗した場合（最初の1個で止まる）
+ */
+std::vector<int> parseTextWithStoiLoop(const std::string_view text) {
+  std::vector<int> numbers;
+  size_t position = 0;
+  while (position < text.size()) {
+    while (position < text.size() && isNumberSeparator(text[position])) {
+      ++position;
+    }
+    const size_t tokenStart = position;
+    while (position < text.size() && !isNumberSeparator(text[position])) {
+      ++position;
+    }
+    if (tokenStart == position) {
+      break;
+    }
+    const std::string_view token = text.substr(tokenStart, position - tokenStart);
+    const std::optional<int> value = parseIntWithStoi(token);
+    if (!value.has_value()) {
+      throw std::runtime_error("parseTextWithStoiLoop: failed to parse int token=\"" + std::string(token) + "\"");
+    }
+    numbers.push_back(*value);
+  }
+  return numbers;
+}
+
+/**
+ * @brief 数列の合計（ベンチマークの結果一致確認用）。
+ */
+long long sumValues(const std::span<const int> values) {
+  return std::accumulate(values.begin(), values.end(), 0LL);
+}
+
+/**
+ * @brief `--bench-parse` / `--bench-tokens` / `--threads` を読み取ります。
+ * @param args std::vector<std::string> コマンドライン引数
+ * @return std::optional<parseBenchOptions> `--bench-parse` が無ければ空
+ * @throws std::runtime_error 値が不正な場合
+ */
+std::optional<parseBenchOptions> parseBenchOptionsFromArgs(const std::vector<std::string>& args) {
+  if (std::find(args.begin(), args.end(), "--bench-parse") == args.end()) {
+    return std::nullopt;
+  }
+  parseBenchOptions options;
+  const unsigned hardwareThreads = std::thread::hardware_concurrency();
+  options.threadCount = hardwareThreads == 0 ? 1 : hardwareThreads;
+  if (const auto it = std::find(args.begin(), args.end(), "--bench-tokens"); it != args.end()) {
+    std::uint64_t tokenCount = 0;
+    const std::string& valueText = std::next(it) == args.end() ? std::string() : *std::next(it);
+    const auto [end, errorCode] = std::from_chars(valueText.data(), valueText.data() + valueText.size(), tokenCount, 10);
+    if (valueText.empty() || errorCode != std::errc{} || end != valueText.data() + valueText.size() || tokenCount == 0) {
+      throw std::runtime_error("parseBenchOptionsFromArgs: invalid --bench-tokens \"" + valueText + "\" (expected: positive integer)");
+    }
+    options.tokenCount = tokenCount;
+  }
+  if (const auto it = std::find(args.begin(), args.end(), "--threads"); it != args.end()) {
+    const std::optional<int> threadValue = std::next(it) == args.end() ? std::nullopt : parseInt(*std::next(it));
+    if (!threadValue.has_value() || *threadValue <= 0) {
+      throw std::runtime_error("parseBenchOptionsFromArgs: invalid --threads (expected: positive integer)");
+    }
+    options.threadCount = static_cast<unsigned>(*threadValue);
+  }
+  return options;
+}
+
+/**
+ * @brief 整数解析のベンチマーク（`--bench-parse`）を実行します。
+ * @details
+ * 比べる方式（すべて同じテキスト、結果の合計が一致することを確認する）:
+ * - (1) stoi-loop      : 旧方式。トークンごとに std::string を確保して std::stoi、push_back。
+ * - (2) from_chars     : countTokens で一度だけ確保し、from_chars で直接書き込む。
+ * - (3) swar           : (2) + 8文字を1回で判定/変換する高速経路。
+ * - (4) swar-stream    : vector を作らず、解析しながら統計を計算する（メモリ使用量が一定）。
+ * - (5) swar-parallel  : (4) を全スレッドで実行する。
+ * [注意] 時間は「メモリ上のテキストを解析する時間」だけ。ファイル読み込みは含まない。
+ * @param options const parseBenchOptions& オプション
+ * @return void
+ * @throws std::runtime_error 方式間で結果が一致しない場合
+ */
+void runParseBenchmark(const parseBenchOptions& options) {
+  printTitle("parse benchmark");
+  const auto generateStart = std::chrono::steady_clock::now();
+  const std::string text = makeParseBenchText(options.tokenCount);
+  std::cout << "tokens=" << options.tokenCount << " bytes=" << text.size() << " threads=" << options.threadCount
+            << " generateMs=" << elapsedMsSince(generateStart) << "\n";
+
+  const auto printParseTiming = [&](const std::string& label, const double elapsedMs) {
+    const double seconds = elapsedMs / 1000.0;
+    const double tokensPerSecond = seconds > 0.0 ? static_cast<double>(options.tokenCount) / seconds : 0.0;
+    printTiming(label, elapsedMs, text.size(), "text bytes");
+    std::cout << "  Mtokens/s=" << tokensPerSecond / 1e6 << "\n";
+  };
+  const auto requireSameSum = [](const char* label, const long long expected, const long long actual) {
+    if (expected != actual) {
+      std::ostringstream oss;
+      oss << "runParseBenchmark: checksum mismatch (" << label << ") expected=" << expected << " actual=" << actual;
+      throw std::runtime_error(oss.str());
+    }
+  };
+
+  long long expectedSum = 0;
+  {
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::vector<int> numbers = parseTextWithStoiLoop(text);
+    const double elapsedMs = elapsedMsSince(startTime);
+    printParseTiming("stoi-loop", elapsedMs);
+    expectedSum = sumValues(numbers);
+    requireSameSum("stoi-loop count", static_cast<long long>(options.tokenCount), static_cast<long long>(numbers.size()));
+  }
+  const auto runPreallocated = [&]<bool kUseWordFastPath>(const char* label) {
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<int> numbers(countTokens(text));
+    std::size_t writtenCount = 0;
+    const bulkParseReport report = parseIntsInto<kUseWordFastPath>(text, std::span<int>(numbers), &writtenCount);
+    const double elapsedMs = elapsedMsSince(startTime);
+    if (report.errorCount > 0) {
+      throw makeBulkParseException("runParseBenchmark", report);
+    }
+    printParseTiming(label, elapsedMs);
+    requireSameSum(label, expectedSum, sumValues(std::span<const int>(numbers.data(), writtenCount)));
+  };
+  runPreallocated.template operator()<false>("from_chars");
+  runPreallocated.template operator()<true>("swar");
+  {
+    const auto startTime = std::chrono::steady_clock::now();
+    const textReduceResult reduced = reduceTextRange(text, 0);
+    const double elapsedMs = elapsedMsSince(startTime);
+    if (reduced.report.errorCount > 0) {
+      throw makeBulkParseException("runParseBenchmark", reduced.report);
+    }
+    printParseTiming("swar-stream", elapsedMs);
+    requireSameSum("swar-stream", expectedSum, reduced.statistics.sum);
+  }
+  {
+    const auto startTime = std::chrono::steady_clock::now();
+    const partialStatistics reduced = reduceTextParallel(text, options.threadCount);
+    const double elapsedMs = elapsedMsSince(startTime);
+    printParseTiming("swar-parallel", elapsedMs);
+    requireSameSum("swar-parallel", expectedSum, reduced.sum);
+  }
+  std::cout << "checksum=" << expectedSum << " (all methods match)\n";
+}
+
+/**
+ * @brief `--bench` で計測するカーネルを登録します（benchHarness.h）。
+ * @details
+ * - optional-parse: `parseIntWithStoi`（旧実装）と `parseInt`（from_chars）を同じトークン列で比べる。
+ * - statistics    : 同じ数列に対する naive / refined / SIMD 向けカーネル（1スレッド）。
+ * - 大きな入力やスレッド並列は `--input` / `--bench-parse` で測る（ここは小さな入力の繰り返し計測）。
+ * @param registry benchHarness::kernelRegistry& 登録先
+ * @return void
+ */
+void registerModernKernels(benchHarness::kernelRegistry& registry) {
+  constexpr std::uint64_t kTokenCount = 1024;
+  auto tokens = std::make_shared<std::vector<std::string>>();
+  for (std::uint64_t i = 0; i < kTokenCount; ++i) {
+    tokens->push_back(std::to_string(static_cast<long long>(i * 7919 % 2000003) - 1000000));
+  }
+  registry.add("optional-parse", "stoi+try/catch", kTokenCount, [tokens]() {
+    long long sum = 0;
+    for (const std::string& token : *tokens) {
+      sum += parseIntWithStoi(token).value_or(0);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+  registry.add("optional-parse", "from_chars", kTokenCount, [tokens]() {
+    long long sum = 0;
+    for (const std::string& token : *tokens) {
+      sum += parseInt(token).value_or(0);
+    }
+    benchHarness::doNotOptimize(sum);
+  });
+
+  constexpr std::uint64_t kValueCount = 16384;
+  auto values = std::make_shared<std::vector<int>>(kValueCount);
+  std::mt19937 random(1U);
+  std::uniform_int_distribution<int> distribution(-1000000, 1000000);
+  for (int& value : *values) {
+    value = distribution(random);
+  }
+  registry.add("statistics", "naive", kValueCount, [values]() {
+    benchHarness::doNotOptimize(computeStatistics(std::span<const int>(*values)).variance);
+  });
+  registry.add("statistics", "refined", kValueCount, [values]() {
+    benchHarness::doNotOptimize(computeStatisticsRefined(std::span<const int>(*values)).variance);
+  });
+  registry.add("statistics", "simd-lanes", kValueCount, [values]() {
+    benchHarness::doNotOptimize(reduceValuesSimd(std::span<const int>(*values)).m2);
+  });
+}
+
 /**
  * @brief 使い方を表示します。
  * @details
@@ -266,10 +1631,20 @@ void printHelp(const std::string& programName) {
   std::cout << "使い方:\n";
   std::cout << "  " << programName << " --help\n";
   std::cout << "  " << programName << " --numbers 1 2 3 4 5\n";
+  std::cout << "  " << programName << " --input <file|-> [--format text|int32] [--threads N]\n";
+  std::cout << "  " << programName << " --bench-parse [--bench-tokens N] [--threads N]\n";
+  std::cout << "  " << programName << " --bench [--bench-trials N] [--bench-json out.json] [--bench-label text]\n";
   std::cout << "\n";
   std::cout << "説明:\n";
-  std::cout << "- --numbers の後ろに整数を並べると、統計（sum/avg/min/max）を計算して表示します。\n";
+  std::cout << "- --numbers の後ろに整数を並べると、統計（sum/avg/min/max/variance）を計算して表示します。\n";
   std::cout << "- --numbers が無い場合はデフォルトの数列で実行します。\n";
+  std::cout << "- --input はファイルをメモリマップして統計を計算します（- は標準入力をストリーム処理）。\n";
+  std::cout << "  naive / refined / parallel-simd の3方式の時間と GB/s を別々に表示します。\n";
+  std::cout << "- --format text : 10進整数を空白/改行/カンマ区切り（既定）。int32 : 4byte整数の連続（ネイティブエンディアン）。\n";
+  std::cout << "- --threads は parallel-simd のスレッド数（既定: 論理コア数）。\n";
+  std::cout << "- --bench-parse は整数解析の方式（stoi / from_chars / SWAR / ストリーム / 並列）を比べます。\n";
+  std::cout << "  --bench-tokens でトークン数を指定（既定: 100000000。テキスト約0.8GBをメモリ上に作る）。\n";
+  std::cout << "- --bench は小さなカーネル（解析/統計）を繰り返し計測します（benchHarness.h。--bench-compare で結果比較）。\n";
 }
 
 /**
@@ -384,6 +1759,7 @@ void demonstrateLambdaCaptures() {
  * - (1) 引数をvectorへコピー（後で検索しやすくする）
  * - (2) `--help` ならヘルプ表示
  * - (3) コンパイラ/標準値を表示（環境確認）
+ * - (3') `--input` なら大規模入力の統計だけを実行して終了（ラムダ例などの学習用出力を混ぜない）
  * - (4) ラムダのキャプチャ例を実行（結果の違いを確認）
  * - (5) `--numbers` をパース（失敗したら例外）
  * - (6) 統計を2通りで計算して一致チェック（デグレ防止）
@@ -408,6 +1784,18 @@ int main(const int argc, char** argv) {
     std::cout << "- _MSVC_LANG: " << toCppStandardLabel(static_cast<long long>(_MSVC_LANG)) << "\n";
 #endif
 
+    if (benchHarness::isBenchCommand(args)) {
+      return benchHarness::runCommand("modern", args, registerModernKernels);
+    }
+    if (const std::optional<parseBenchOptions> bench = parseBenchOptionsFromArgs(args); bench.has_value()) {
+      runParseBenchmark(*bench);
+      return 0;
+    }
+    if (const std::optional<inputOptions> input = parseInputOptions(args); input.has_value()) {
+      runInputStatistics(*input);
+      return 0;
+    }
+
     demonstrateLambdaCaptures();
 
     std::vector<int> numbers = parseNumbersOption(args);
@@ -417,28 +1805,23 @@ int main(const int argc, char** argv) {
     }
 
     printTitle("compute statistics");
-    const auto startTime = std::chrono::steady_clock::now();
-    const statisticsResult stats = computeStatistics(std::span<const int>(numbers.data(), numbers.size()));
-    const statisticsResult refinedStats = computeStatisticsRefined(std::span<const int>(numbers.data(), numbers.size()));
-    const auto endTime = std::chrono::steady_clock::now();
-    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    // [重要] 2方式を別々に計測する（まとめて測ると、どちらが速いか分からない）。
+    const std::span<const int> numberSpan(numbers.data(), numbers.size());
+    const auto naiveStart = std::chrono::steady_clock::now();
+    const statisticsResult stats = computeStatistics(numberSpan);
+    const double naiveElapsedMs = elapsedMsSince(naiveStart);
+    const auto refinedStart = std::chrono::steady_clock::now();
+    const statisticsResult refinedStats = computeStatisticsRefined(numberSpan);
+    const double refinedElapsedMs = elapsedMsSince(refinedStart);
 
     // [重要] 学習用: 2通りの実装が同じ結果になることを確認する（デグレ防止の考え方）。
-    if (stats.sum != refinedStats.sum || stats.minValue != refinedStats.minValue || stats.maxValue != refinedStats.maxValue) {
-      std::ostringstream oss;
-      oss << "main(modern.cpp): statistics mismatch"
-          << " sum(" << stats.sum << " vs " << refinedStats.sum << ")"
-          << " min(" << stats.minValue << " vs " << refinedStats.minValue << ")"
-          << " max(" << stats.maxValue << " vs " << refinedStats.maxValue << ")";
-      throw std::runtime_error(oss.str());
+    if (!isSameStatistics(stats, refinedStats)) {
+      throw makeStatisticsMismatchException("main(modern.cpp): naive vs refined", stats, refinedStats);
     }
 
-    std::cout << "numbers size=" << numbers.size() << "\n";
-    std::cout << "sum=" << stats.sum << "\n";
-    std::cout << "average=" << stats.average << "\n";
-    std::cout << "min=" << stats.minValue << "\n";
-    std::cout << "max=" << stats.maxValue << "\n";
-    std::cout << "elapsedMs=" << elapsedMs << "\n";
+    printStatistics(numbers.size(), stats);
+    std::cout << "naiveElapsedMs=" << naiveElapsedMs << "\n";
+    std::cout << "refinedElapsedMs=" << refinedElapsedMs << "\n";
 
     return 0;
   } catch (const std::exception& ex) {